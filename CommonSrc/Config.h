@@ -6,6 +6,7 @@
 
 #include <filesystem>
 #include <string>
+#include <vector>
 
 bool LoadConfig();
 
@@ -16,3 +17,25 @@ const std::wstring& ApplicationUserModelId() noexcept;
 const std::wstring& ApplicationId() noexcept;
 const std::filesystem::path& PackageRootPath() noexcept;
 const std::filesystem::path& FinalPackageRootPath() noexcept;
+
+// An attach that a fixup asked for through PSFRegister; 'function' is the function being detoured
+struct detour_registration
+{
+    void** target;
+    void* detour;
+    void* function;
+};
+
+// While set, PSFRegister only records the attaches that it is asked for in 'log'; the fixup loader makes them once the
+// fixup has initialized successfully
+void SetDetourRegistrationLog(std::vector<detour_registration>* log) noexcept;
+
+// Starts queueing the log (see PSFWriteLog) and writing it out to 'sink' from a background thread: "debugger", "etw"
+// (the Microsoft.Windows.PSF.Log TraceLogging provider), or "file:<folder>" (a <executable>-<process id>.log file in
+// that folder). Returns false, and keeps logging to the debugger, if the sink can't be used.
+bool StartAsyncLogging(const wchar_t* sink) noexcept;
+
+// Set from the "timeline" option of the config; when set, the process timeline is written out on exit. WriteTimelineOnExit
+// is called when the application's entry point returns and from the ExitProcess detour, never from DllMain.
+void SetWriteTimelineOnExit(bool enabled) noexcept;
+void WriteTimelineOnExit() noexcept;
@@ -6,47 +6,130 @@
 #include <windows.h>
 #include <stdarg.h>
 #include <debugapi.h>
-#include <string>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <cwchar>
+#include <memory>
+#include <string_view>
+#include <utility>
 #include <assert.h>
 
+#include <psf_config.h>
+#include <psf_constants.h>
+#include <psf_logging.h>
 #include <utilities.h>
 
 bool g_psf_NoLogging = false;
 
-void Log(const char* fmt, ...)
+using namespace std::literals;
+
+namespace
 {
-    if (!g_psf_NoLogging)
+    // Messages are formatted here rather than into a new string each time; only longer ones allocate
+    constexpr std::size_t logBufferLength = 1024;
+    thread_local char t_narrowLogBuffer[logBufferLength];
+    thread_local wchar_t t_wideLogBuffer[logBufferLength];
+
+    using write_log_proc = void(__stdcall*)(const char*, std::size_t) noexcept;
+    using write_log_wide_proc = void(__stdcall*)(const wchar_t*, std::size_t) noexcept;
+    using flush_log_proc = void(__stdcall*)() noexcept;
+
+    // PsfRuntime's log writer, shared by every module of the process. It is looked up rather than imported since not
+    // every module that logs links against PsfRuntime; PsfRuntime is loaded before any fixup, so looking it up once is
+    // enough.
+    struct log_writer_entry_points
     {
-        try
-        {
-            va_list args;
-            va_start(args, fmt);
-            std::string str;
-            str.resize(256);
-            std::size_t count = std::vsnprintf(str.data(), str.size() + 1, fmt, args);
-            assert(count >= 0);
-            va_end(args);
+        write_log_proc write = nullptr;
+        write_log_wide_proc write_wide = nullptr;
+        flush_log_proc flush = nullptr;
 
-            if (count > str.size())
+        log_writer_entry_points() noexcept
+        {
+            if (auto runtime = ::GetModuleHandleW(psf::runtime_dll_name))
             {
-                count = 1024;       // vswprintf actually returns a negative number, let's just go with something big enough for our long strings; it is resized shortly.
-                str.resize(count);
-
-                va_list args2;
-                va_start(args2, fmt);
-                count = std::vsnprintf(str.data(), str.size() + 1, fmt, args2);
-                assert(count >= 0);
-                va_end(args2);
+#if defined(_M_IX86)
+                write = reinterpret_cast<write_log_proc>(::GetProcAddress(runtime, "_PSFWriteLog@8"));
+                write_wide = reinterpret_cast<write_log_wide_proc>(::GetProcAddress(runtime, "_PSFWriteLogW@8"));
+                flush = reinterpret_cast<flush_log_proc>(::GetProcAddress(runtime, "_PSFFlushLog@0"));
+#else
+                write = reinterpret_cast<write_log_proc>(::GetProcAddress(runtime, "PSFWriteLog"));
+                write_wide = reinterpret_cast<write_log_wide_proc>(::GetProcAddress(runtime, "PSFWriteLogW"));
+                flush = reinterpret_cast<flush_log_proc>(::GetProcAddress(runtime, "PSFFlushLog"));
+#endif
             }
+        }
+    };
 
-            str.resize(count);
-            ::OutputDebugStringA(str.c_str());
+    const log_writer_entry_points& log_writer() noexcept
+    {
+        static const log_writer_entry_points entryPoints;
+        return entryPoints;
+    }
+
+    // 'message' is null terminated at message[length]
+    void write_log(const char* message, std::size_t length) noexcept
+    {
+        if (auto write = log_writer().write)
+        {
+            write(message, length);
         }
-        catch (...)
+        else
+        {
+            ::OutputDebugStringA(message);
+        }
+    }
+
+    void write_log(const wchar_t* message, std::size_t length) noexcept
+    {
+        if (auto write = log_writer().write_wide)
         {
+            write(message, length);
+        }
+        else
+        {
+            ::OutputDebugStringW(message);
+        }
+    }
+}
+
+void FlushLog() noexcept
+{
+    if (auto flush = log_writer().flush)
+    {
+        flush();
+    }
+}
+
+void Log(const char* fmt, ...)
+{
+    if (!g_psf_NoLogging)
+    {
+        va_list args;
+        va_start(args, fmt);
+        va_list retryArgs;
+        va_copy(retryArgs, args);
+        auto count = std::vsnprintf(t_narrowLogBuffer, logBufferLength, fmt, args);
+        va_end(args);
+
+        if (count < 0)
+        {
+            va_end(retryArgs);
             ::OutputDebugStringA("Exception in Log()");
             ::OutputDebugStringA(fmt);
+            return;
+        }
+
+        if (static_cast<std::size_t>(count) < logBufferLength)
+        {
+            write_log(t_narrowLogBuffer, static_cast<std::size_t>(count));
+        }
+        else if (std::unique_ptr<char[]> message(new (std::nothrow) char[count + 1]); message)
+        {
+            std::vsnprintf(message.get(), count + 1, fmt, retryArgs);
+            write_log(message.get(), static_cast<std::size_t>(count));
         }
+        va_end(retryArgs);
     }
 }
 
@@ -54,32 +137,119 @@ void Log(const wchar_t* fmt, ...)
 {
     if (!g_psf_NoLogging)
     {
-        try
+        va_list args;
+        va_start(args, fmt);
+        va_list lengthArgs;
+        va_copy(lengthArgs, args);
+        va_list retryArgs;
+        va_copy(retryArgs, args);
+        auto count = ::_vsnwprintf_s(t_wideLogBuffer, logBufferLength, _TRUNCATE, fmt, args);
+
+        if (count >= 0)
+        {
+            write_log(t_wideLogBuffer, static_cast<std::size_t>(count));
+        }
+        else
+        {
+            // Negative when the message did not fit, or when formatting failed, in which case the buffer is empty
+            auto length = ::_vscwprintf(fmt, lengthArgs);
+            std::unique_ptr<wchar_t[]> message((length > 0) ? new (std::nothrow) wchar_t[length + 1] : nullptr);
+            if (message && (::_vsnwprintf_s(message.get(), length + 1, _TRUNCATE, fmt, retryArgs) >= 0))
+            {
+                write_log(message.get(), static_cast<std::size_t>(length));
+            }
+            else
+            {
+                write_log(t_wideLogBuffer, std::wcslen(t_wideLogBuffer));
+            }
+        }
+        va_end(retryArgs);
+        va_end(lengthArgs);
+        va_end(args);
+    }
+}
+
+static bool parse_log_level(std::string_view name, psf::log_level& level) noexcept
+{
+    static constexpr std::pair<std::string_view, psf::log_level> levels[] =
+    {
+        { "off"sv, psf::log_level::off },
+        { "error"sv, psf::log_level::error },
+        { "warning"sv, psf::log_level::warning },
+        { "info"sv, psf::log_level::info },
+        { "debug"sv, psf::log_level::debug },
+        { "trace"sv, psf::log_level::trace },
+    };
+
+    for (auto& [levelName, value] : levels)
+    {
+        if (name == levelName)
         {
-            va_list args;
-            va_start(args, fmt);
+            level = value;
+            return true;
+        }
+    }
 
-            std::wstring wstr;
-            wstr.resize(256);
-            std::size_t count = std::vswprintf(wstr.data(), wstr.size() + 1, fmt, args);
-            va_end(args);
+    Log("Unknown log level '%.*s'; expected off, error, warning, info, debug or trace.", static_cast<int>(name.length()), name.data());
+    return false;
+}
+
+void SetLogLevels(const psf::json_value* levels)
+{
+    if (!levels)
+    {
+        return;
+    }
 
-            if (count > wstr.size())
+    auto setAll = [](const psf::json_value& value)
+    {
+        psf::log_level level;
+        if (parse_log_level(value.as_string().string(), level))
+        {
+            for (auto category = psf::log_category::first(); category; category = category->next())
+            {
+                category->set_level(level);
+            }
+        }
+    };
+
+    if (levels->type() == psf::json_type::string)
+    {
+        setAll(*levels);
+        return;
+    }
+
+    auto& levelsObject = levels->as_object();
+    if (auto defaultLevel = levelsObject.try_get("default"))
+    {
+        setAll(*defaultLevel);
+    }
+
+    for (auto [name, value] : levelsObject)
+    {
+        if (name == "default"sv)
+        {
+            continue;
+        }
+
+        psf::log_level level;
+        if (!parse_log_level(value.as_string().string(), level))
+        {
+            continue;
+        }
+
+        bool found = false;
+        for (auto category = psf::log_category::first(); category; category = category->next())
+        {
+            if (name == category->name())
             {
-                count = 1024;       // vswprintf actually returns a negative number, let's just go with something big enough for our long strings; it is resized shortly.
-                wstr.resize(count);
-                va_list args2;
-                va_start(args2, fmt);
-                count = std::vswprintf(wstr.data(), wstr.size() + 1, fmt, args2);
-                va_end(args2);
+                category->set_level(level);
+                found = true;
             }
-            wstr.resize(count);
-            ::OutputDebugStringW(wstr.c_str());
         }
-        catch (...)
+        if (!found)
         {
-            ::OutputDebugStringA("Exception in wide Log()");
-            ::OutputDebugStringW(fmt);
+            Log("Unknown log category '%.*s'.", static_cast<int>(name.length()), name.data());
         }
     }
 }
@@ -329,7 +499,7 @@ void Loghexdump(void* pAddressIn, long  lSize, DWORD instance=0)
 
             if (instance == 0)
             {
-                ::OutputDebugStringA(szBuf);
+                write_log(szBuf, std::strlen(szBuf));
             }
             else
             {
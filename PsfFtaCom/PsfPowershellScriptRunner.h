@@ -454,13 +454,9 @@ private:
 		if (!std::filesystem::exists(SSWrapper))
 		{
 			// The wrapper isn't in this folder, so we should search for it elewhere in the package.
-			for (const auto& file : std::filesystem::recursive_directory_iterator(packageRoot))
+			if (auto foundPath = PSFFindPackageFile(SSWrapper.filename().c_str(), 0))
 			{
-				if (file.path().filename().compare(SSWrapper.filename()) == 0)
-				{
-					SSWrapper = file.path();
-					break;
-				}
+				SSWrapper = foundPath;
 			}
 		}
 		std::wstring commandString = psPath;
@@ -481,13 +477,9 @@ private:
 		if (!std::filesystem::exists(scriptPath))
 		{
 			// The wrapper isn't in this folder, so we should search for it elewhere in the package.
-			for (const auto& file : std::filesystem::recursive_directory_iterator(packageRoot))
+			if (auto foundPath = PSFFindPackageFile(scriptPath.c_str(), 0))
 			{
-				if (file.path().filename().compare(scriptPath.c_str()) == 0)
-				{
-					wScriptPath = file.path();
-					break;
-				}
+				wScriptPath = foundPath;
 			}
 		}
 		LogString(L"MakeCommandString: post exists search Script path", wScriptPath.c_str());
@@ -128,6 +128,7 @@ int launcher_main(PCWSTR args, int cmdShow) noexcept try
         powershellScriptRunner.Initialize(appConfig, currentDirectory, packageRoot);
 
         // Launch the starting PowerShell script if we are using one.
+        psf::timeline_span span("starting script");
         powershellScriptRunner.RunStartingScript();
     }
 
@@ -271,13 +272,9 @@ int launcher_main(PCWSTR args, int cmdShow) noexcept try
             if (!std::filesystem::exists(SSCmdWrapper))
             {
                 // The wrapper isn't in this folder, so we should search for it elewhere in the package.
-                for (const auto& file : std::filesystem::recursive_directory_iterator(packageRoot))
+                if (auto foundPath = PSFFindPackageFile(SSCmdWrapper.filename().c_str(), 0))
                 {
-                    if (file.path().filename().compare(SSCmdWrapper.filename()) == 0)
-                    {
-                        SSCmdWrapper = file.path();
-                        break;
-                    }
+                    SSCmdWrapper = foundPath;
                 }
             }
 
@@ -342,13 +339,9 @@ int launcher_main(PCWSTR args, int cmdShow) noexcept try
                 if (!std::filesystem::exists(SSShellWrapper))
                 {
                     // The wrapper isn't in this folder, so we should search for it elewhere in the package.
-                    for (const auto& file : std::filesystem::recursive_directory_iterator(packageRoot))
+                    if (auto foundPath = PSFFindPackageFile(SSShellWrapper.filename().c_str(), 0))
                     {
-                        if (file.path().filename().compare(SSShellWrapper.filename()) == 0)
-                        {
-                            SSShellWrapper = file.path();
-                            break;
-                        }
+                        SSShellWrapper = foundPath;
                     }
                 }
 
@@ -365,7 +358,10 @@ int launcher_main(PCWSTR args, int cmdShow) noexcept try
     {
         Log(L"Process Launch Ready to run any end scripts.");
         // Launch the end PowerShell script if we are using one.
-        powershellScriptRunner.RunEndingScript();
+        {
+            psf::timeline_span span("ending script");
+            powershellScriptRunner.RunEndingScript();
+        }
         Log(L"Process Launch complete.");
     }
 
@@ -524,24 +520,13 @@ void LaunchInBackgroundAsAdmin( const wchar_t executable[], const wchar_t argume
 #endif
                         // If not in those two locations, must check everywhere in package.
                         // The child process might also be in another package folder, so look elsewhere in the package.
-                        for (auto& dentry : std::filesystem::recursive_directory_iterator(packageRoot))
+                        if (auto foundPath = PSFFindPackageFile(wtargetDllName.c_str(), 0))
                         {
-                            try
-                            {
-                                if (dentry.path().filename().compare(wtargetDllName) == 0)
-                                {
-                                    static const auto altDirPathToPsfRuntime = narrow(dentry.path().c_str());
+                            static const auto altDirPathToPsfRuntime = narrow(foundPath);
 #if _DEBUG
-                                    Log(L"\tPsfLaunch: Found match as %ls", dentry.path().c_str());
+                            Log(L"\tPsfLaunch: Found match as %ls", foundPath);
 #endif
-                                    targetDllPath = altDirPathToPsfRuntime.c_str();
-                                    break;
-                                }
-                            }
-                            catch (...)
-                            {
-                                Log(L"\tPsfLaunch: Non-fatal error enumerating directories while looking for PsfRuntime.");
-                            }
+                            targetDllPath = altDirPathToPsfRuntime.c_str();
                         }
 
                     }
@@ -3,21 +3,21 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 //-------------------------------------------------------------------------------------------------------
 
+#include <algorithm>
 #include <cctype>
+#include <cstdio>
 #include <fstream>
 #include <iostream>
 #include <map>
 #include <memory>
-#include <regex>
 #include <sstream>
 #include <string_view>
 #include <vector>
 
 #include <windows.h>
 #include <detours.h>
-#include <rapidjson/reader.h>
 #include <rapidjson/error/en.h>
-#include <rapidjson/filereadstream.h>
+#include <psf_cache_files.h>
 #include <psf_constants.h>
 #include <psf_runtime.h>
 #include <psf_utils.h>
@@ -27,7 +27,9 @@
 #include <wil\resource.h>
 
 #include "Config.h"
+#include "ConfigImage.h"
 #include "JsonConfig.h"
+#include "ProcessMatcher.h"
 
 using namespace std::literals;
 
@@ -39,182 +41,10 @@ static std::filesystem::path g_PackageRootPath;
 static std::filesystem::path g_FinalPackageRootPath;
 static std::filesystem::path g_CurrentExecutable;
 
-// The object that constructs the JSON DOM and holds the root
-static struct
-{
-    bool on_value(std::unique_ptr<psf::json_value> value)
-    {
-        if (!state_stack.empty())
-        {
-            assert(root);
-            auto& current_value = state_stack.back();
-            switch (current_value.index())
-            {
-            case 0:
-            {
-                auto& map = std::get<0>(current_value)->values;
-                if (map.find(object_key) != map.end())
-                {
-                    error_message = "'" + object_key + "' already exists in map";
-                    return false;
-                }
-
-                return std::get<0>(current_value)->values.emplace(std::move(object_key), std::move(value)).second;
-            }   break;
-
-            case 1:
-                std::get<1>(current_value)->values.emplace_back(std::move(value));
-                break;
-            }
-        }
-        else if (!root)
-        {
-            root = std::move(value);
-        }
-        else
-        {
-            error_message = "Can't have more than one root";
-            return false;
-        }
-
-        return true;
-    }
-
-    bool Null()
-    {
-        return on_value(std::make_unique<json_null_impl>());
-    }
-
-    bool Bool(bool b)
-    {
-        return on_value(std::make_unique<json_boolean_impl>(b));
-    }
-
-    bool Int(std::int64_t value)
-    {
-        return on_value(std::make_unique<json_number_impl>(value));
-    }
-
-    bool Uint(std::uint64_t value)
-    {
-        return on_value(std::make_unique<json_number_impl>(value));
-    }
-
-    bool Int64(std::int64_t value)
-    {
-        return on_value(std::make_unique<json_number_impl>(value));
-    }
-
-    bool Uint64(std::uint64_t value)
-    {
-        return on_value(std::make_unique<json_number_impl>(value));
-    }
-
-    bool Double(double value)
-    {
-        return on_value(std::make_unique<json_number_impl>(value));
-    }
-
-    bool RawNumber(const char* /*str*/, rapidjson::SizeType /*length*/, bool /*copy*/)
-    {
-        // Provided only to satisfy compilation, but never called since we never pass kParseNumbersAsStringsFlag
-        // Consider: Update rapidjson to use if constexpr
-        assert(false);
-        return false;
-    }
-
-    bool String(const char* str, rapidjson::SizeType length, [[maybe_unused]] bool copy)
-    {
-        // Caller should always own the memory
-        assert(copy);
-        return on_value(std::make_unique<json_string_impl>(std::string_view(str, length)));
-    }
-
-    bool StartObject()
-    {
-        // NOTE: We must call 'on_value' before appending to 'state_stack', otherwise we'll try and add the object as a
-        //       child of itself
-        auto obj = std::make_unique<json_object_impl>();
-        auto objPtr = obj.get();
-        auto result = on_value(std::move(obj));
-        if (result)
-        {
-            state_stack.emplace_back(objPtr);
-        }
-
-        return result;
-    }
-
-    bool Key(const char* str, rapidjson::SizeType length, [[maybe_unused]] bool copy)
-    {
-        // Caller should always own the memory
-        assert(copy);
-        assert(object_key.empty());
-        object_key.assign(str, length);
-        return true;
-    }
-
-    bool EndObject([[maybe_unused]] rapidjson::SizeType memberCount)
-    {
-#ifndef NDEBUG
-        assert(!state_stack.empty());
-
-        auto current = state_stack.back();
-        assert(current.index() == 0);
-
-        auto ptr = std::get<0>(current);
-        assert(ptr->values.size() == memberCount);
-#endif
-
-        state_stack.pop_back();
-        return true;
-    }
-
-    bool StartArray()
-    {
-        // NOTE: We must call 'on_value' before appending to 'state_stack', otherwise we'll try and add the array as a
-        //       child of itself
-        auto arr = std::make_unique<json_array_impl>();
-        auto arrPtr = arr.get();
-        auto result = on_value(std::move(arr));
-        if (result)
-        {
-            state_stack.emplace_back(arrPtr);
-        }
-
-        return result;
-    }
-
-    bool EndArray([[maybe_unused]] rapidjson::SizeType elementCount)
-    {
-#ifndef NDEBUG
-        assert(!state_stack.empty());
-
-        auto current = state_stack.back();
-        assert(current.index() == 1);
-
-        auto ptr = std::get<1>(current);
-        assert(ptr->values.size() == elementCount);
-#endif
-
-        state_stack.pop_back();
-        return true;
-    }
-
-    // Root of the tree, filled in by the first object/array/string, etc. encountered
-    std::unique_ptr<psf::json_value> root;
-
-    // Since all we get are callbacks, we don't have the luxury of using stack memory to save state, so use the heap
-    // NOTE: Since we're immediately done processing strings, numbers, booleans, and null, we only need to save state
-    //       for objects and arrays
-    std::vector<std::variant<json_object_impl*, json_array_impl*>> state_stack;
-    std::string object_key;
-
-    // When non-empty, provides a more useful error message displayed to the user for invalid config.json files
-    std::string error_message;
+static json_dom_builder g_JsonHandler;
 
-    bool enableReportError{ true };
-} g_JsonHandler;
+// Set by the "enableReportError" config value
+static bool g_EnableReportError = true;
 
 #if DONTCONSOLIDATELOGS
 void Log(const char* fmt, ...)
@@ -254,18 +84,32 @@ void LogString(const char* name, const wchar_t* value)
 #endif
 
 static const psf::json_object* g_CurrentExeConfig = nullptr;
+static process_matcher g_ProcessMatcher;
 
+// The config root, either parsed into g_JsonHandler or mapped from a compiled image
+static const psf::json_value* g_ConfigRoot = nullptr;
+static std::unique_ptr<config_image_file> g_ConfigImage;
 
-void load_json()
+static std::filesystem::path config_image_path()
+{
+    return psf::local_cache_path(g_PackageFamilyName, L"config.psfc");
+}
+
+
+// Parses config.json and returns a hash of its contents, which a compiled image of it records
+static std::uint64_t parse_json(std::filesystem::path& configPath)
 {
+    std::uint64_t contentHash = 0;
+    configPath = g_PackageRootPath / L"config.json";
 #pragma warning(suppress:4996) // Nonsense warning; _wfopen is perfectly safe
-    auto file = _wfopen((g_PackageRootPath / L"config.json").c_str(), L"rb, ccs=UTF-8");
+    auto file = _wfopen(configPath.c_str(), L"rb, ccs=UTF-8");
     if (!file)
     {
         Log(L"Config.json not found in root of package %ls, look elsewhere.", g_PackageRootPath.c_str());
         ///Check folder with application, then everyhwere in package if needed
+        configPath = g_CurrentExecutable.parent_path() / L"config.json";
 #pragma warning(suppress:4996) // Nonsense warning; _wfopen is perfectly safe
-        file = _wfopen((g_CurrentExecutable.parent_path() / L"config.json").c_str(), L"rb, ccs=UTF-8");
+        file = _wfopen(configPath.c_str(), L"rb, ccs=UTF-8");
         if (file)
         {
             Log(L"Config.json found in executable folder of package %ls", g_PackageRootPath.c_str());
@@ -274,39 +118,29 @@ void load_json()
         {
             Log(L"Config.json not found in executable folder of package %ls, continue looking elsewhere.", g_PackageRootPath.c_str());
             // If not in those two locations, must check everywhere in package.
-            for (auto& dentry : std::filesystem::recursive_directory_iterator(g_PackageRootPath))
+            if (auto foundPath = PSFFindPackageFile(L"config.json", 0))
             {
-                try
-                {
-                    if (dentry.is_regular_file())
-                    {
-                        if (dentry.path().filename().compare(L"config.json") == 0)
-                        {
-                            Log(L"Found config at: %ls", dentry.path().c_str());
+                Log(L"Found config at: %ls", foundPath);
+                configPath = foundPath;
 #pragma warning(suppress:4996) // Nonsense warning; _wfopen is perfectly safe
-                            file = _wfopen(dentry.path().c_str(), L"rb, ccs=UTF-8");
-                            break;
-                        }
-                    }
-                }
-                catch (...)
-                {
-                    Log(L"Non-fatal error enumerating directories while looking for config.json.");
-                }
+                file = _wfopen(configPath.c_str(), L"rb, ccs=UTF-8");
             }
         }
     }
 
     if (file)
     {
+        // The whole file is read first, so that the hash is of exactly the bytes that were parsed
+        std::vector<char> contents;
         char buffer[2048];
-        rapidjson::FileReadStream stream(file, buffer, std::size(buffer));
-        rapidjson::AutoUTFInputStream<char32_t, rapidjson::FileReadStream> autoStream(stream);
-
-        rapidjson::GenericReader<rapidjson::AutoUTF<char32_t>, rapidjson::UTF8<>> reader;
-        auto result = reader.Parse(autoStream, g_JsonHandler);
+        while (auto count = std::fread(buffer, 1, std::size(buffer), file))
+        {
+            contents.insert(contents.end(), buffer, buffer + count);
+        }
         fclose(file);
 
+        contentHash = config_image::content_hash(contents.data(), contents.size());
+        auto result = parse_json_contents(contents.data(), contents.size(), g_JsonHandler);
 
         if (result.IsError())
         {
@@ -334,32 +168,67 @@ void load_json()
         PSFReportError(L"Config.json not found in package. Unable to configure the PSF.");
     }
     assert(g_JsonHandler.state_stack.empty());
+    g_ConfigRoot = g_JsonHandler.root;
+    return contentHash;
+}
 
-    // Cache a pointer to the current executable's config, as we are most likely to reference that later
-    auto currentExe = g_CurrentExecutable.stem();
-    if (auto processes = g_JsonHandler.root->as_object().try_get("processes"))
+void load_json()
+{
+    psf::timeline_span span("load_json");
+
+    // A compiled image of config.json, if an earlier process made one, saves parsing it again
+    std::filesystem::path imagePath;
+    try
+    {
+        psf::timeline_span imageSpan("open compiled config");
+        imagePath = config_image_path();
+        g_ConfigImage = config_image_file::open(imagePath, g_PackageFullName);
+    }
+    catch (...)
     {
-        if (processes)
+        Log(L"Unable to locate the compiled config.");
+    }
+
+    if (g_ConfigImage)
+    {
+        LogString(L"Config loaded from compiled image of", g_ConfigImage->source_path().c_str());
+        g_ConfigRoot = g_ConfigImage->root();
+    }
+    else
+    {
+        std::filesystem::path configPath;
+        std::uint64_t contentHash;
         {
-            for (auto& processConfig : processes->as_array())
+            psf::timeline_span parseSpan("parse config.json");
+            contentHash = parse_json(configPath);
+        }
+
+        auto compiledConfig = g_ConfigRoot ? g_ConfigRoot->as_object().try_get("compiledConfig") : nullptr;
+        if (compiledConfig && compiledConfig->as_boolean().get() && !imagePath.empty())
+        {
+            psf::timeline_span writeSpan("write compiled config");
+            if (write_config_image(*g_ConfigRoot, configPath, contentHash, g_PackageFullName, imagePath))
+            {
+                LogString(L"Compiled config written to", imagePath.c_str());
+            }
+            else
             {
-                auto& obj = processConfig.as_object();
-                auto exe = obj.get("executable").as_string().wstring();
-                if (!g_CurrentExeConfig && std::regex_match(currentExe.native(), std::wregex(exe.data(), exe.length())))
-                {
-                    g_CurrentExeConfig = &obj;
-                    LogCountedStringW("Processes config match", exe.data(), exe.length());
-                    break;
-                }
-                else if (!g_CurrentExeConfig)
-                {
-                    //LogCountedStringW("Processes config notmatched", exe.data(), exe.length());
-                }
+                Log(L"Unable to write the compiled config.");
             }
         }
-        else
+    }
+
+    // Compile the processes once, as PSFQueryExeConfig is called for every child process, and cache a pointer to the
+    // current executable's config, as we are most likely to reference that later
+    auto currentExe = g_CurrentExecutable.stem();
+    if (auto processes = g_ConfigRoot->as_object().try_get("processes"))
+    {
+        g_ProcessMatcher.assign(processes);
+        g_CurrentExeConfig = g_ProcessMatcher.find(currentExe.native());
+        if (g_CurrentExeConfig)
         {
-            Log(L"No processes to match; no fixups to load.");
+            auto exe = g_CurrentExeConfig->get("executable").as_string().wstring();
+            LogCountedStringW("Processes config match", exe.data(), exe.length());
         }
     }
     else
@@ -368,15 +237,46 @@ void load_json()
     }
 
     // Permit ReportError disabling iff basic config.json parse succeeded
-    auto enableReportError = g_JsonHandler.root->as_object().try_get("enableReportError");
+    auto enableReportError = g_ConfigRoot->as_object().try_get("enableReportError");
     if (enableReportError)
     {
-        g_JsonHandler.enableReportError = enableReportError->as_boolean().get();
+        g_EnableReportError = enableReportError->as_boolean().get();
+    }
+
+    if (auto timeline = g_ConfigRoot->as_object().try_get("timeline"))
+    {
+        SetWriteTimelineOnExit(timeline->as_boolean().get());
+    }
+
+    // Child processes pick the log sink up from the environment, unless their config names one
+    if (auto logSink = g_ConfigRoot->as_object().try_get("logSink"))
+    {
+        std::wstring sink = logSink->as_string().wide();
+        if (sink == L"file")
+        {
+            auto logPath = psf::local_cache_path(g_PackageFamilyName, L"Logs");
+            std::error_code ec;
+            std::filesystem::create_directories(logPath, ec);
+            sink = L"file:" + logPath.native();
+        }
+
+        ::SetEnvironmentVariableW(L"PSF_LOG_SINK", sink.c_str());
+        StartAsyncLogging(sink.c_str());
+    }
+    else
+    {
+        wchar_t sink[MAX_PATH + 8];
+        auto sinkLength = ::GetEnvironmentVariableW(L"PSF_LOG_SINK", sink, static_cast<DWORD>(std::size(sink)));
+        if ((sinkLength > 0) && (sinkLength < std::size(sink)))
+        {
+            StartAsyncLogging(sink);
+        }
     }
 }
 
 bool LoadConfig()
 {
+    psf::timeline_span span("LoadConfig");
     if (psf::is_packaged())
     {
         g_PackageFullName = psf::current_package_full_name();
@@ -440,11 +340,29 @@ const std::filesystem::path& FinalPackageRootPath() noexcept
     return g_FinalPackageRootPath;
 }
 
+static std::vector<detour_registration>* g_DetourRegistrationLog = nullptr;
+
+void SetDetourRegistrationLog(std::vector<detour_registration>* log) noexcept
+{
+    g_DetourRegistrationLog = log;
+}
+
 // API definitions
-PSFAPI DWORD __stdcall PSFRegister(_Inout_ void** implFn, _In_ void* fixupFn) noexcept
+PSFAPI DWORD __stdcall PSFRegister(_Inout_ void** implFn, _In_ void* fixupFn) noexcept try
 {
+    if (g_DetourRegistrationLog)
+    {
+        // *implFn would not change until the transaction commits anyway, so the fixup can't tell the difference
+        g_DetourRegistrationLog->push_back({ implFn, fixupFn, *implFn });
+        return NO_ERROR;
+    }
+
     return ::DetourAttach(implFn, fixupFn);
 }
+catch (...)
+{
+    return ERROR_NOT_ENOUGH_MEMORY;
+}
 
 PSFAPI DWORD __stdcall PSFUnregister(_Inout_ void** implFn, _In_ void* fixupFn) noexcept
 {
@@ -483,12 +401,12 @@ PSFAPI const wchar_t* __stdcall PSFQueryFinalPackageRootPath() noexcept
 
 PSFAPI const psf::json_value* __stdcall PSFQueryConfigRoot() noexcept
 {
-    return g_JsonHandler.root.get();
+    return g_ConfigRoot;
 }
 
 PSFAPI const psf::json_object* __stdcall PSFQueryAppLaunchConfig(_In_ const wchar_t* applicationId, bool verbose) noexcept try
 {
-    for (auto& app : g_JsonHandler.root->as_object().get("applications").as_array())
+    for (auto& app : g_ConfigRoot->as_object().get("applications").as_array())
     {
         auto& appObj = app.as_object();
         auto appId = appObj.get("id").as_string().wstring();
@@ -574,23 +492,7 @@ static inline constexpr iwstring_view remove_suffix_if(iwstring_view str, iwstri
 
 PSFAPI const psf::json_object* __stdcall PSFQueryExeConfig(const wchar_t* executable) noexcept try
 {
-    //const auto exeName = remove_suffix_if(executable, L".exe"_isv);
-    const iwstring_view exeName  = iwstring_view (executable);
-    if (auto processes = g_JsonHandler.root->as_object().try_get("processes"))
-    {
-        for (auto& processConfig : processes->as_array())
-        {
-            auto& obj = processConfig.as_object();
-            auto exePattern = obj.get("executable").as_string().wstring();
-
-            if (std::regex_match(exeName.begin(), exeName.end(), std::wregex(exePattern.data(), exePattern.length())))
-            {
-                return &obj;
-            }
-        }
-    }
-
-    return nullptr;
+    return g_ProcessMatcher.find(executable);
 }
 catch (...)
 {
@@ -602,7 +504,8 @@ PSFAPI const psf::json_object* __stdcall PSFQueryCurrentExeConfig() noexcept
     return g_CurrentExeConfig;
 }
 
-static inline const psf::json_value* find_config(const psf::json_object* exeConfig, const wchar_t* dll)
+// The dll's entry in the exe config's fixups array
+static inline const psf::json_object* find_fixup_entry(const psf::json_object* exeConfig, const wchar_t* dll)
 {
     if (!exeConfig)
     {
@@ -626,8 +529,7 @@ static inline const psf::json_value* find_config(const psf::json_object* exeConf
             iwstring_view dllStrView(dllStr.data(), dllStr.length());
            if (targetDll == remove_suffix_if(remove_suffix_if(dllStrView, L".dll"_isv), psf::warch_string))
             {
-                // NOTE: config is optional
-                return fixupConfigObj.try_get("config");
+                return &fixupConfigObj;
             }
             else
             {
@@ -637,7 +539,7 @@ static inline const psf::json_value* find_config(const psf::json_object* exeConf
                {
                    if (targetDll == remove_suffix_if(remove_suffix_if(dllStrView.substr(offsetLast + 1), L".dll"_isv), psf::warch_string))
                    {
-                       return fixupConfigObj.try_get("config");
+                       return &fixupConfigObj;
                    }
                }
             }
@@ -647,6 +549,14 @@ static inline const psf::json_value* find_config(const psf::json_object* exeConf
     return nullptr;
 }
 
+static inline const psf::json_value* find_config(const psf::json_object* exeConfig, const wchar_t* dll)
+{
+    auto fixupEntry = find_fixup_entry(exeConfig, dll);
+
+    // NOTE: config is optional
+    return fixupEntry ? fixupEntry->try_get("config") : nullptr;
+}
+
 PSFAPI const psf::json_value* __stdcall PSFQueryConfig(const wchar_t* executable, const wchar_t* dll) noexcept try
 {
     return find_config(PSFQueryExeConfig(executable), dll);
@@ -665,9 +575,19 @@ catch (...)
     return nullptr;
 }
 
+PSFAPI const psf::json_value* __stdcall PSFQueryDllLogLevel(const wchar_t* dll) noexcept try
+{
+    auto fixupEntry = find_fixup_entry(g_CurrentExeConfig, dll);
+    return fixupEntry ? fixupEntry->try_get("logLevel") : nullptr;
+}
+catch (...)
+{
+    return nullptr;
+}
+
 PSFAPI void __stdcall PSFReportError(const wchar_t* error) noexcept
 {
-    if (!g_JsonHandler.enableReportError)
+    if (!g_EnableReportError)
     {
         return;
     }
@@ -0,0 +1,458 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) Tim Mangan. All rights reserved
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <map>
+#include <numeric>
+#include <string_view>
+
+#include <windows.h>
+#include <psf_logging.h>
+#include <utilities.h>
+
+#include "ConfigImage.h"
+
+using namespace config_image;
+
+// Images are small; anything bigger than this is not one of ours
+static constexpr std::uint64_t max_image_size = 64 * 1024 * 1024;
+
+psf::json_value* image_object_impl::try_get(_In_ const char* key) const noexcept
+{
+    std::string_view target(key);
+    auto end = members + count;
+    auto itr = std::lower_bound(members, end, target, [&](const image_member& member, std::string_view value)
+    {
+        return std::string_view(image->narrow_at(member.key_offset), member.key_length) < value;
+    });
+    if ((itr != end) && (std::string_view(image->narrow_at(itr->key_offset), itr->key_length) == target))
+    {
+        return image->value_at(itr->value);
+    }
+
+    return nullptr;
+}
+
+bool image_object_impl::fill(unsigned index, enumeration_data* data) const noexcept
+{
+    if (index >= count)
+    {
+        *data = {};
+        return false;
+    }
+
+    data->key = image->narrow_at(members[index].key_offset);
+    data->key_length = members[index].key_length;
+    data->value = image->value_at(members[index].value);
+    return true;
+}
+
+psf::json_object::enumeration_handle* image_object_impl::begin_enumeration(_Out_ enumeration_data* data) const noexcept
+{
+    return fill(0, data) ? reinterpret_cast<enumeration_handle*>(std::uintptr_t{ 1 }) : nullptr;
+}
+
+psf::json_object::enumeration_handle* image_object_impl::advance(_In_ enumeration_handle* handle, _Inout_ enumeration_data* data) const noexcept
+{
+    auto next = static_cast<unsigned>(reinterpret_cast<std::uintptr_t>(handle));
+    return fill(next, data) ? reinterpret_cast<enumeration_handle*>(std::uintptr_t{ next } + 1) : nullptr;
+}
+
+psf::json_value* image_array_impl::try_get_at(unsigned index) const noexcept
+{
+    if (index >= count)
+    {
+        return nullptr;
+    }
+
+    return image->value_at(elements[index]);
+}
+
+std::unique_ptr<config_image_file> config_image_file::open(const std::filesystem::path& imagePath, std::wstring_view packageFullName)
+{
+    auto file = psf::map_cache_file(imagePath, sizeof(image_header), max_image_size);
+    if (!file)
+    {
+        return nullptr;
+    }
+
+    std::unique_ptr<config_image_file> image(new config_image_file(std::move(file)));
+    if (!image->validate(packageFullName))
+    {
+        Log(L"Compiled config %ls is not valid; ignoring it.", imagePath.c_str());
+        return nullptr;
+    }
+    if (!image->source_is_current())
+    {
+        Log(L"Compiled config %ls is out of date; ignoring it.", imagePath.c_str());
+        return nullptr;
+    }
+
+    image->create_values();
+    return image;
+}
+
+psf::json_value* config_image_file::value_at(std::uint32_t index) const noexcept
+{
+    assert(index < m_values.size());
+    return std::visit([](auto& value) -> psf::json_value* { return &value; }, m_values[index]);
+}
+
+std::filesystem::path config_image_file::source_path() const
+{
+    return std::wstring_view(wide_at(header().source_path_offset), header().source_path_length);
+}
+
+bool config_image_file::validate(std::wstring_view packageFullName) const noexcept
+{
+    auto& hdr = header();
+    if ((hdr.signature != image_signature) || (hdr.version != image_version) || (hdr.image_size != m_size) ||
+        (image_hash(m_view + sizeof(image_header), m_size - sizeof(image_header)) != hdr.image_hash) ||
+        !is_string_at<wchar_t>(hdr.source_path_offset, hdr.source_path_length) ||
+        !is_string_at<wchar_t>(hdr.package_offset, hdr.package_length) ||
+        (std::wstring_view(wide_at(hdr.package_offset), hdr.package_length) != packageFullName))
+    {
+        return false;
+    }
+
+    auto nodes = table_at<image_node>(hdr.nodes_offset, hdr.node_count);
+    if (!nodes || (hdr.node_count == 0))
+    {
+        return false;
+    }
+
+    // Children must come after their parent, which also rules out cycles
+    auto isChild = [&](std::uint32_t parent, std::uint32_t child) { return (child > parent) && (child < hdr.node_count); };
+    for (std::uint32_t index = 0; index < hdr.node_count; ++index)
+    {
+        auto& node = nodes[index];
+        switch (static_cast<psf::json_type>(node.type))
+        {
+        case psf::json_type::null:
+            break;
+
+        case psf::json_type::string:
+        {
+            auto str = table_at<image_string>(node.payload, 1);
+            if (!str || !is_string_at<char>(str->narrow_offset, str->narrow_length) || !is_string_at<wchar_t>(str->wide_offset, str->wide_length))
+            {
+                return false;
+            }
+        }   break;
+
+        case psf::json_type::number:
+            if (node.count >= std::variant_size_v<decltype(json_number_impl::value)>)
+            {
+                return false;
+            }
+            break;
+
+        case psf::json_type::boolean:
+            if (node.payload > 1)
+            {
+                return false;
+            }
+            break;
+
+        case psf::json_type::object:
+        {
+            auto members = table_at<image_member>(node.payload, node.count);
+            if (!members)
+            {
+                return false;
+            }
+            for (std::uint32_t i = 0; i < node.count; ++i)
+            {
+                if (!is_string_at<char>(members[i].key_offset, members[i].key_length) || !isChild(index, members[i].value))
+                {
+                    return false;
+                }
+            }
+        }   break;
+
+        case psf::json_type::array:
+        {
+            auto elements = table_at<std::uint32_t>(node.payload, node.count);
+            if (!elements)
+            {
+                return false;
+            }
+            for (std::uint32_t i = 0; i < node.count; ++i)
+            {
+                if (!isChild(index, elements[i]))
+                {
+                    return false;
+                }
+            }
+        }   break;
+
+        default:
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool config_image_file::source_is_current() const
+{
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!::GetFileAttributesExW(wide_at(header().source_path_offset), GetFileExInfoStandard, &data))
+    {
+        return false;
+    }
+
+    auto size = (static_cast<std::uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+    auto writeTime = (static_cast<std::uint64_t>(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+    if ((size != header().source_size) || (writeTime != header().source_write_time))
+    {
+        return false;
+    }
+
+    // A file can be replaced by one of the same size and time (copied with its times kept, or by a tool that resets
+    // them), so the contents have the final say
+    auto source = psf::map_cache_file(wide_at(header().source_path_offset), size, size);
+    return source && (content_hash(source.data(), source.size()) == header().source_hash);
+}
+
+void config_image_file::create_values()
+{
+    auto nodes = table_at<image_node>(header().nodes_offset, header().node_count);
+
+    // Reserved up front, as the values point at each other by address
+    m_values.reserve(header().node_count);
+    for (std::uint32_t index = 0; index < header().node_count; ++index)
+    {
+        auto& node = nodes[index];
+        switch (static_cast<psf::json_type>(node.type))
+        {
+        case psf::json_type::null:
+            m_values.emplace_back(std::in_place_type<json_null_impl>);
+            break;
+
+        case psf::json_type::string:
+        {
+            auto str = table_at<image_string>(node.payload, 1);
+            auto& value = std::get<image_string_impl>(m_values.emplace_back(std::in_place_type<image_string_impl>));
+            value.narrow_string = narrow_at(str->narrow_offset);
+            value.narrow_length = str->narrow_length;
+            value.wide_string = wide_at(str->wide_offset);
+            value.wide_length = str->wide_length;
+        }   break;
+
+        case psf::json_type::number:
+            switch (node.count)
+            {
+            case 0:
+                m_values.emplace_back(std::in_place_type<json_number_impl>, static_cast<std::int64_t>(node.payload));
+                break;
+            case 1:
+                m_values.emplace_back(std::in_place_type<json_number_impl>, static_cast<std::uint64_t>(node.payload));
+                break;
+            default:
+            {
+                double value;
+                std::memcpy(&value, &node.payload, sizeof(value));
+                m_values.emplace_back(std::in_place_type<json_number_impl>, value);
+            }   break;
+            }
+            break;
+
+        case psf::json_type::boolean:
+            m_values.emplace_back(std::in_place_type<json_boolean_impl>, node.payload != 0);
+            break;
+
+        case psf::json_type::object:
+        {
+            auto& value = std::get<image_object_impl>(m_values.emplace_back(std::in_place_type<image_object_impl>));
+            value.image = this;
+            value.members = table_at<image_member>(node.payload, node.count);
+            value.count = node.count;
+        }   break;
+
+        case psf::json_type::array:
+        {
+            auto& value = std::get<image_array_impl>(m_values.emplace_back(std::in_place_type<image_array_impl>));
+            value.image = this;
+            value.elements = table_at<std::uint32_t>(node.payload, node.count);
+            value.count = node.count;
+        }   break;
+        }
+    }
+}
+
+bool write_config_image(const psf::json_value& root, const std::filesystem::path& sourcePath, std::uint64_t sourceHash, std::wstring_view packageFullName, const std::filesystem::path& imagePath) noexcept try
+{
+    const std::wstring sourcePathText = sourcePath.wstring();
+    WIN32_FILE_ATTRIBUTE_DATA sourceData;
+    if (!::GetFileAttributesExW(sourcePathText.c_str(), GetFileExInfoStandard, &sourceData))
+    {
+        return false;
+    }
+
+    // Number the values breadth first, so that the children of each value are numbered in the order they are visited
+    std::vector<const psf::json_value*> values{ &root };
+    for (std::size_t index = 0; index < values.size(); ++index)
+    {
+        if (auto object = values[index]->try_as_object())
+        {
+            for (auto& member : *object)
+            {
+                values.push_back(&member.second);
+            }
+        }
+        else if (auto array = values[index]->try_as_array())
+        {
+            for (auto& element : *array)
+            {
+                values.push_back(&element);
+            }
+        }
+    }
+
+    // Everything but the header and the node table is appended to 'data'
+    const std::size_t dataStart = sizeof(image_header) + values.size() * sizeof(image_node);
+    std::vector<std::uint8_t> data;
+    auto append = [&](const void* bytes, std::size_t size, std::size_t alignment)
+    {
+        data.resize((data.size() + alignment - 1) / alignment * alignment);
+        auto offset = dataStart + data.size();
+        data.insert(data.end(), static_cast<const std::uint8_t*>(bytes), static_cast<const std::uint8_t*>(bytes) + size);
+        return static_cast<std::uint32_t>(offset);
+    };
+    auto appendNarrow = [&](std::string_view str)
+    {
+        auto offset = append(str.data(), str.length(), 1);
+        data.push_back(0);
+        return offset;
+    };
+    auto appendWide = [&](std::wstring_view str)
+    {
+        auto offset = append(str.data(), str.length() * sizeof(wchar_t), alignof(wchar_t));
+        data.insert(data.end(), sizeof(wchar_t), std::uint8_t{ 0 });
+        return offset;
+    };
+
+    std::vector<image_node> nodes(values.size());
+    std::uint32_t nextChild = 1;
+    for (std::size_t index = 0; index < values.size(); ++index)
+    {
+        auto& value = *values[index];
+        auto& node = nodes[index];
+        node.type = static_cast<std::uint32_t>(value.type());
+        switch (value.type())
+        {
+        case psf::json_type::null:
+            break;
+
+        case psf::json_type::string:
+        {
+            auto& str = value.as_string();
+            image_string record;
+            record.narrow_offset = appendNarrow(str.string());
+            record.narrow_length = static_cast<std::uint32_t>(str.string().length());
+            record.wide_offset = appendWide(str.wstring());
+            record.wide_length = static_cast<std::uint32_t>(str.wstring().length());
+            node.payload = append(&record, sizeof(record), alignof(image_string));
+        }   break;
+
+        case psf::json_type::number:
+        {
+            // Keep the number as it was parsed, so that the image gives the same answers as the DOM
+            auto number = dynamic_cast<const json_number_impl*>(&value.as_number());
+            if (!number)
+            {
+                return false;
+            }
+            node.count = static_cast<std::uint32_t>(number->value.index());
+            switch (node.count)
+            {
+            case 0:
+                node.payload = static_cast<std::uint64_t>(std::get<std::int64_t>(number->value));
+                break;
+            case 1:
+                node.payload = std::get<std::uint64_t>(number->value);
+                break;
+            default:
+                std::memcpy(&node.payload, &std::get<double>(number->value), sizeof(node.payload));
+                break;
+            }
+        }   break;
+
+        case psf::json_type::boolean:
+            node.payload = value.as_boolean().get() ? 1 : 0;
+            break;
+
+        case psf::json_type::object:
+        {
+            std::vector<std::string_view> keys;
+            std::vector<image_member> members;
+            for (auto& member : value.as_object())
+            {
+                keys.push_back(member.first);
+                members.push_back(image_member{ appendNarrow(member.first), static_cast<std::uint32_t>(member.first.length()), nextChild++ });
+            }
+
+            std::vector<std::size_t> order(members.size());
+            std::iota(order.begin(), order.end(), std::size_t{ 0 });
+            std::sort(order.begin(), order.end(), [&](std::size_t lhs, std::size_t rhs) { return keys[lhs] < keys[rhs]; });
+            std::vector<image_member> sorted;
+            for (auto i : order)
+            {
+                sorted.push_back(members[i]);
+            }
+
+            node.count = static_cast<std::uint32_t>(sorted.size());
+            node.payload = append(sorted.data(), sorted.size() * sizeof(image_member), alignof(image_member));
+        }   break;
+
+        case psf::json_type::array:
+        {
+            std::vector<std::uint32_t> elements(value.as_array().size());
+            for (auto& element : elements)
+            {
+                element = nextChild++;
+            }
+
+            node.count = static_cast<std::uint32_t>(elements.size());
+            node.payload = append(elements.data(), elements.size() * sizeof(std::uint32_t), alignof(std::uint32_t));
+        }   break;
+        }
+    }
+    assert(nextChild == values.size());
+
+    image_header header = {};
+    header.signature = image_signature;
+    header.version = image_version;
+    header.source_size = (static_cast<std::uint64_t>(sourceData.nFileSizeHigh) << 32) | sourceData.nFileSizeLow;
+    header.source_write_time = (static_cast<std::uint64_t>(sourceData.ftLastWriteTime.dwHighDateTime) << 32) | sourceData.ftLastWriteTime.dwLowDateTime;
+    header.source_hash = sourceHash;
+    header.source_path_offset = appendWide(sourcePathText);
+    header.source_path_length = static_cast<std::uint32_t>(sourcePathText.length());
+    header.package_offset = appendWide(packageFullName);
+    header.package_length = static_cast<std::uint32_t>(packageFullName.length());
+    header.node_count = static_cast<std::uint32_t>(nodes.size());
+    header.nodes_offset = sizeof(image_header);
+    if (dataStart + data.size() > max_image_size)
+    {
+        return false;
+    }
+    header.image_size = static_cast<std::uint32_t>(dataStart + data.size());
+
+    // The hash is over what follows the header as one run of bytes, the way a reader sees it
+    auto nodeBytes = reinterpret_cast<const std::uint8_t*>(nodes.data());
+    data.insert(data.begin(), nodeBytes, nodeBytes + nodes.size() * sizeof(image_node));
+    header.image_hash = image_hash(data.data(), data.size());
+
+    return psf::write_file_atomically(imagePath, {
+        { &header, sizeof(header) },
+        { data.data(), data.size() } });
+}
+catch (...)
+{
+    return false;
+}
@@ -0,0 +1,243 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) Tim Mangan. All rights reserved
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+//
+// A compiled form of config.json that the processes of a package can map into memory instead of parsing the json
+// again. The image is flat and offset based: a header, one fixed size node per json value (the root first, and every
+// child after its parent), then the member tables, element tables and strings they refer to. Strings are stored both
+// narrow and wide, null terminated, and object members are sorted by key, which is also the order that the parsed DOM
+// enumerates them in. Offsets are from the start of the image and all values are little endian.
+//
+// The image records the package full name, and the path, size, last write time and a hash of the contents of the
+// config.json it was built from; it is only used while all of these still match. The size and time are checked first,
+// as they are cheap; the contents are only read and hashed when those match, which is still far cheaper than parsing.
+// The header also holds a hash of everything after it, so that an image that has been damaged where the structural
+// checks cannot tell (a byte of a string, say) is not used either.
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <variant>
+#include <vector>
+
+#include <windows.h>
+#include <psf_cache_files.h>
+
+#include "JsonConfig.h"
+
+namespace config_image
+{
+    inline constexpr std::uint32_t image_signature = 0x43465350; // "PSFC"
+    inline constexpr std::uint32_t image_version = 3;
+
+    // 64 bit FNV-1a; pass the hash of the bytes before 'data' as 'hash' to continue it
+    inline std::uint64_t content_hash(const void* data, std::size_t size, std::uint64_t hash = 0xcbf29ce484222325) noexcept
+    {
+        auto bytes = static_cast<const std::uint8_t*>(data);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            hash = (hash ^ bytes[i]) * 0x100000001b3;
+        }
+        return hash;
+    }
+
+    // The same step taken a 64 bit word at a time, in four interleaved lanes, then over the bytes left; several times
+    // faster than content_hash on the whole image, which every process hashes when it opens it. Any one damaged word
+    // still changes the result, as every step is one to one in the word and in the lane.
+    inline std::uint64_t image_hash(const void* data, std::size_t size) noexcept
+    {
+        constexpr std::uint64_t prime = 0x100000001b3;
+        std::uint64_t hash = 0xcbf29ce484222325;
+        std::uint64_t lanes[4] = { hash, hash + 1, hash + 2, hash + 3 };
+        auto bytes = static_cast<const std::uint8_t*>(data);
+        std::size_t i = 0;
+        for (; size - i >= sizeof(lanes); i += sizeof(lanes))
+        {
+            for (std::size_t lane = 0; lane < 4; ++lane)
+            {
+                std::uint64_t word;
+                std::memcpy(&word, bytes + i + lane * sizeof(word), sizeof(word));
+                lanes[lane] = (lanes[lane] ^ word) * prime;
+            }
+        }
+        for (auto lane : lanes)
+        {
+            hash = (hash ^ lane) * prime;
+        }
+        return content_hash(bytes + i, size - i, hash);
+    }
+
+    struct image_header
+    {
+        std::uint32_t signature;
+        std::uint32_t version;
+        std::uint64_t source_size;
+        std::uint64_t source_write_time;
+        std::uint64_t source_hash;              // content_hash of the whole file
+        std::uint32_t source_path_offset;       // wide
+        std::uint32_t source_path_length;
+        std::uint32_t package_offset;           // wide
+        std::uint32_t package_length;
+        std::uint32_t node_count;
+        std::uint32_t nodes_offset;
+        std::uint32_t image_size;
+        std::uint32_t reserved;
+        std::uint64_t image_hash;               // image_hash of everything after the header
+    };
+
+    struct image_node
+    {
+        std::uint32_t type;                     // psf::json_type
+        std::uint32_t count;                    // members or elements; for numbers the json_number_impl variant index
+        std::uint64_t payload;                  // offset of the string, member or element table; or the value itself
+    };
+
+    struct image_string
+    {
+        std::uint32_t narrow_offset;
+        std::uint32_t narrow_length;
+        std::uint32_t wide_offset;
+        std::uint32_t wide_length;
+    };
+
+    struct image_member
+    {
+        std::uint32_t key_offset;               // narrow
+        std::uint32_t key_length;
+        std::uint32_t value;                    // node index
+    };
+}
+
+class config_image_file;
+
+struct image_string_impl : psf::json_string
+{
+    virtual const char* narrow(_Out_opt_ unsigned* length) const noexcept override
+    {
+        if (length)
+        {
+            *length = narrow_length;
+        }
+
+        return narrow_string;
+    }
+
+    virtual const wchar_t* wide(_Out_opt_ unsigned* length) const noexcept override
+    {
+        if (length)
+        {
+            *length = wide_length;
+        }
+
+        return wide_string;
+    }
+
+    const char* narrow_string;
+    unsigned narrow_length;
+    const wchar_t* wide_string;
+    unsigned wide_length;
+};
+
+struct image_object_impl : psf::json_object
+{
+    virtual json_value* try_get(_In_ const char* key) const noexcept override;
+
+    // The enumeration handle is the index of the current member, plus one so that it is never null
+    virtual enumeration_handle* begin_enumeration(_Out_ enumeration_data* data) const noexcept override;
+    virtual enumeration_handle* advance(_In_ enumeration_handle* handle, _Inout_ enumeration_data* data) const noexcept override;
+    virtual void cancel_enumeration(_In_ enumeration_handle*) const noexcept override
+    {
+    }
+
+    bool fill(unsigned index, enumeration_data* data) const noexcept;
+
+    const config_image_file* image;
+    const config_image::image_member* members;
+    unsigned count;
+};
+
+struct image_array_impl : psf::json_array
+{
+    virtual unsigned size() const noexcept override
+    {
+        return count;
+    }
+
+    virtual json_value* try_get_at(unsigned index) const noexcept override;
+
+    const config_image_file* image;
+    const std::uint32_t* elements;
+    unsigned count;
+};
+
+class config_image_file
+{
+public:
+    // Maps the image at imagePath if it is valid and was built from the current package's config.json as it is now
+    static std::unique_ptr<config_image_file> open(const std::filesystem::path& imagePath, std::wstring_view packageFullName);
+
+    config_image_file(const config_image_file&) = delete;
+    config_image_file& operator=(const config_image_file&) = delete;
+
+    const psf::json_value* root() const noexcept
+    {
+        return value_at(0);
+    }
+
+    psf::json_value* value_at(std::uint32_t index) const noexcept;
+
+    const char* narrow_at(std::uint32_t offset) const noexcept
+    {
+        return reinterpret_cast<const char*>(m_view + offset);
+    }
+
+    const wchar_t* wide_at(std::uint32_t offset) const noexcept
+    {
+        return reinterpret_cast<const wchar_t*>(m_view + offset);
+    }
+
+    std::filesystem::path source_path() const;
+
+private:
+    explicit config_image_file(psf::mapped_file file) noexcept : m_file(std::move(file)), m_view(m_file.data()), m_size(m_file.size()) {}
+
+    const config_image::image_header& header() const noexcept
+    {
+        return *reinterpret_cast<const config_image::image_header*>(m_view);
+    }
+
+    template <typename T>
+    const T* table_at(std::uint64_t offset, std::uint64_t count) const noexcept
+    {
+        if ((offset % alignof(T)) || (offset > m_size) || (count > (m_size - offset) / sizeof(T)))
+        {
+            return nullptr;
+        }
+        return reinterpret_cast<const T*>(m_view + offset);
+    }
+
+    template <typename CharT>
+    bool is_string_at(std::uint64_t offset, std::uint64_t length) const noexcept
+    {
+        auto str = table_at<CharT>(offset, length + 1);
+        return str && (str[length] == 0);
+    }
+
+    bool validate(std::wstring_view packageFullName) const noexcept;
+    bool source_is_current() const;
+    void create_values();
+
+    psf::mapped_file m_file;
+    const std::uint8_t* m_view;
+    std::size_t m_size;
+
+    using value_storage = std::variant<json_null_impl, image_string_impl, json_number_impl, json_boolean_impl, image_object_impl, image_array_impl>;
+    mutable std::vector<value_storage> m_values;
+};
+
+// Compiles the parsed config into an image at imagePath. The image is only a cache, so failures are not fatal.
+// sourceHash is the content_hash of the config.json that root was parsed from.
+bool write_config_image(const psf::json_value& root, const std::filesystem::path& sourcePath, std::uint64_t sourceHash, std::wstring_view packageFullName, const std::filesystem::path& imagePath) noexcept;
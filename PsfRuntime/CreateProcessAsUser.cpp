@@ -710,24 +710,13 @@ BOOL WINAPI CreateProcessAsUserFixup(
 #endif
                 // If not in those two locations, must check everywhere in package.
                 // The child process might also be in another package folder, so look elsewhere in the package.
-                for (auto& dentry : std::filesystem::recursive_directory_iterator(PackageRootPath()))
+                if (auto foundPath = PSFFindPackageFile(wtargetDllName.c_str(), 0))
                 {
-                    try
-                    {
-                        if (dentry.path().filename().compare(wtargetDllName) == 0)
-                        {
-                            static const auto altDirPathToPsfRuntime = narrow(dentry.path().c_str());
+                    static const auto altDirPathToPsfRuntime = narrow(foundPath);
 #if _DEBUG
-                            Log(L"\t[%d] CreateProcessAsUserFixup: Found match as %ls", DllInstance, dentry.path().c_str());
+                    Log(L"\t[%d] CreateProcessAsUserFixup: Found match as %ls", DllInstance, foundPath);
 #endif
-                            targetDllPath = altDirPathToPsfRuntime.c_str();
-                            break;
-                        }
-                    }
-                    catch (...)
-                    {
-                        Log(L"\t[%d] CreateProcessAsUserFixup: Non-fatal error enumerating directories while looking for PsfRuntime.", DllInstance);
-                    }
+                    targetDllPath = altDirPathToPsfRuntime.c_str();
                 }
 
             }
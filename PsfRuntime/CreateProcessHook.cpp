@@ -340,24 +340,12 @@ BOOL WINAPI CreateProcessWithPsfRunDll(
     std::wstring RunDllExePath = PackageRootPath() / psf::wrun_dll_name;
     if (!std::filesystem::exists(RunDllExePath))
     {
-        for (auto& dentry : std::filesystem::recursive_directory_iterator(PackageRootPath()))
+        if (auto foundPath = PSFFindPackageFile(psf::wrun_dll_name, 0))
         {
-            try
-            {
-                if (dentry.path().filename().compare(psf::wrun_dll_name) == 0)
-                {
-                    static const auto altDirPathToPsfRuntime = dentry.path().filename().wstring();
-                    RunDllExePath = altDirPathToPsfRuntime.c_str();
+            RunDllExePath = foundPath;
 #if _DEBUG
-                    LogString(g_CreateProcessIntceptInstance, L"\tCreateProcessWithPsfRunDll: Found match as %s", RunDllExePath.c_str());
+            LogString(g_CreateProcessIntceptInstance, L"\tCreateProcessWithPsfRunDll: Found match as %s", RunDllExePath.c_str());
 #endif
-                    break;
-                }
-            }
-            catch (...)
-            {
-                Log(L"\t[%d] CreateProcessWithPsfRunDll: Non-fatal error enumerating directories while looking for PsfRunDll.", g_CreateProcessIntceptInstance);
-            }
         }
     }
     else
@@ -1130,24 +1118,13 @@ BOOL WINAPI CreateProcessFixup(
 #endif
                 // If not in those two locations, must check everywhere in package.
                 // The child process might also be in another package folder, so look elsewhere in the package.
-                for (auto& dentry : std::filesystem::recursive_directory_iterator(PackageRootPath()))
+                if (auto foundPath = PSFFindPackageFile(wtargetDllName.c_str(), 0))
                 {
-                    try
-                    {
-                        if (dentry.path().filename().compare(wtargetDllName) == 0)
-                        {
-                            static const auto altDirPathToPsfRuntime = narrow(dentry.path().c_str());
+                    static const auto altDirPathToPsfRuntime = narrow(foundPath);
 #if _DEBUG
-                            Log(L"\t[%d] CreateProcessFixup: Found match as %ls", CreateProcessInstance, dentry.path().c_str());
+                    Log(L"\t[%d] CreateProcessFixup: Found match as %ls", CreateProcessInstance, foundPath);
 #endif
-                            targetDllPath = altDirPathToPsfRuntime.c_str();
-                            break;
-                        }
-                    }
-                    catch (...)
-                    {
-                        Log(L"\t[%d] CreateProcessFixup: Non-fatal error enumerating directories while looking for PsfRuntime.", CreateProcessInstance);
-                    }
+                    targetDllPath = altDirPathToPsfRuntime.c_str();
                 }
 
             }
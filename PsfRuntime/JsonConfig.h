@@ -4,42 +4,158 @@
 //-------------------------------------------------------------------------------------------------------
 #pragma once
 
-#include <unordered_map>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 
 #include <psf_config.h>
+#include <rapidjson/encodedstream.h>
+#include <rapidjson/memorystream.h>
+#include <rapidjson/reader.h>
+
+// Owns every node and string of the parsed config. Memory is handed out from large blocks by bumping a pointer, and
+// is only given back, all at once, when the arena goes away. Node destructors are never run, so nodes must not own any
+// memory other than what they get from the arena.
+class json_arena
+{
+public:
+    json_arena() = default;
+    json_arena(const json_arena&) = delete;
+    json_arena& operator=(const json_arena&) = delete;
+
+    ~json_arena()
+    {
+        for (auto block : m_blocks)
+        {
+            ::operator delete(block);
+        }
+    }
+
+    // Safe to call from several threads, as wide strings are created on first use
+    void* allocate(std::size_t size, std::size_t alignment)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto offset = (m_used + alignment - 1) & ~(alignment - 1);
+        if (!m_current || (offset + size > m_capacity))
+        {
+            // Requests bigger than a block get a block of their own
+            m_capacity = std::max(size, block_size);
+            m_current = static_cast<std::byte*>(::operator new(m_capacity));
+            m_blocks.push_back(m_current);
+            offset = 0;
+        }
+
+        m_used = offset + size;
+        return m_current + offset;
+    }
+
+    template <typename T, typename... Args>
+    T* make(Args&&... args)
+    {
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    template <typename T>
+    T* copy_array(const T* values, std::size_t count)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        auto result = static_cast<T*>(allocate(std::max<std::size_t>(count, 1) * sizeof(T), alignof(T)));
+        std::copy(values, values + count, result);
+        return result;
+    }
+
+    // The copy is null terminated
+    template <typename CharT>
+    const CharT* copy_string(std::basic_string_view<CharT> value)
+    {
+        auto result = static_cast<CharT*>(allocate((value.length() + 1) * sizeof(CharT), alignof(CharT)));
+        std::copy(value.begin(), value.end(), result);
+        result[value.length()] = 0;
+        return result;
+    }
+
+private:
+    static constexpr std::size_t block_size = 16 * 1024;
+
+    std::mutex m_mutex;
+    std::vector<std::byte*> m_blocks;
+    std::byte* m_current = nullptr;
+    std::size_t m_capacity = 0;
+    std::size_t m_used = 0;
+};
 
 struct json_null_impl : psf::json_null
 {
 };
 
+// Most strings in the config are only ever read in one of their forms, so the wide form is created the first time
+// that it is asked for
 struct json_string_impl : psf::json_string
 {
-    json_string_impl(std::string_view value) : narrow_string(value), wide_string(widen(value)) {}
+    json_string_impl(json_arena& arena, std::string_view value) :
+        arena(&arena),
+        narrow_string(arena.copy_string(value)),
+        narrow_length(static_cast<unsigned>(value.length()))
+    {
+    }
 
     virtual const char* narrow(_Out_opt_ unsigned* length) const noexcept override
     {
         if (length)
         {
-            *length = static_cast<unsigned>(narrow_string.length());
+            *length = narrow_length;
         }
 
-        return narrow_string.c_str();
+        return narrow_string;
     }
 
     virtual const wchar_t* wide(_Out_opt_ unsigned* length) const noexcept override
     {
+        auto result = wide_string.load(std::memory_order_acquire);
+        if (!result)
+        {
+            result = create_wide();
+        }
+
         if (length)
         {
-            *length = static_cast<unsigned>(wide_string.length());
+            *length = wide_length.load(std::memory_order_relaxed);
         }
 
-        return wide_string.c_str();
+        return result;
     }
 
-    std::string narrow_string;
-    std::wstring wide_string;
+    const wchar_t* create_wide() const noexcept try
+    {
+        auto value = widen(std::string_view(narrow_string, narrow_length));
+        auto created = arena->copy_string(std::wstring_view(value));
+        wide_length.store(static_cast<unsigned>(value.length()), std::memory_order_relaxed);
+
+        // Another thread may have got there first, in which case we use its copy
+        const wchar_t* expected = nullptr;
+        if (!wide_string.compare_exchange_strong(expected, created, std::memory_order_acq_rel))
+        {
+            return expected;
+        }
+        return created;
+    }
+    catch (...)
+    {
+        return L"";
+    }
+
+    json_arena* arena;
+    const char* narrow_string;
+    unsigned narrow_length;
+    mutable std::atomic<const wchar_t*> wide_string = nullptr;
+    mutable std::atomic<unsigned> wide_length = 0;
 };
 
 struct json_number_impl : psf::json_number
@@ -93,128 +209,293 @@ struct json_boolean_impl : psf::json_boolean
 
 struct json_object_impl : psf::json_object
 {
-    using map_type = std::map<std::string, std::unique_ptr<psf::json_value>, std::less<>>;
-    using iterator_type = map_type::const_iterator;
+    struct member
+    {
+        const char* key;
+        unsigned key_length;
+        psf::json_value* value;
+
+        std::string_view key_view() const noexcept
+        {
+            return { key, key_length };
+        }
+    };
 
     virtual json_value* try_get(_In_ const char* key) const noexcept override
     {
-        if (auto itr = values.find(key); itr != values.end())
+        // The members are sorted by key, which is also the order they are enumerated in
+        std::string_view target(key);
+        auto end = members + count;
+        auto itr = std::lower_bound(members, end, target, [](const member& lhs, std::string_view rhs)
         {
-            return itr->second.get();
+            return lhs.key_view() < rhs;
+        });
+        if ((itr != end) && (itr->key_view() == target))
+        {
+            return itr->value;
         }
 
         return nullptr;
     }
 
-    // We can elide allocations if the iterator fits within the size of a pointer (which should always be the case when
-    // building release)
-    static constexpr bool handle_requires_allocation = sizeof(iterator_type) > sizeof(enumeration_handle*);
-
+    // The enumeration handle is the index of the current member plus one, so it never needs to allocate
     virtual enumeration_handle* begin_enumeration(_Out_ enumeration_data* data) const noexcept override
     {
-        auto itr = values.begin();
-        if (itr == values.end())
+        return fill(0, data) ? reinterpret_cast<enumeration_handle*>(std::uintptr_t{ 1 }) : nullptr;
+    }
+
+    virtual enumeration_handle* advance(_In_ enumeration_handle* handle, _Inout_ enumeration_data* data) const noexcept override
+    {
+        assert(handle);
+        auto next = static_cast<unsigned>(reinterpret_cast<std::uintptr_t>(handle));
+        return fill(next, data) ? reinterpret_cast<enumeration_handle*>(std::uintptr_t{ next } + 1) : nullptr;
+    }
+
+    virtual void cancel_enumeration(_In_ enumeration_handle*) const noexcept override
+    {
+    }
+
+    bool fill(unsigned index, enumeration_data* data) const noexcept
+    {
+        if (index >= count)
         {
             *data = {};
+            return false;
+        }
+
+        data->key = members[index].key;
+        data->key_length = members[index].key_length;
+        data->value = members[index].value;
+        return true;
+    }
+
+    const member* members = nullptr;
+    unsigned count = 0;
+};
+
+struct json_array_impl : psf::json_array
+{
+    virtual unsigned size() const noexcept override
+    {
+        return count;
+    }
+
+    virtual json_value* try_get_at(unsigned index) const noexcept override
+    {
+        if (index >= count)
+        {
             return nullptr;
         }
 
-        data->key = itr->first.c_str();
-        data->key_length = static_cast<unsigned>(itr->first.length());
-        data->value = itr->second.get();
+        return values[index];
+    }
 
-        if constexpr (handle_requires_allocation)
+    psf::json_value* const* values = nullptr;
+    unsigned count = 0;
+};
+
+// The rapidjson handler that constructs the JSON DOM and holds the root. Every node and string lives in 'arena'; the
+// members and elements of an open object or array are collected in 'pending' and only copied into the arena, sorted,
+// once the container is closed.
+struct json_dom_builder
+{
+    template <typename T, typename... Args>
+    bool on_value(Args&&... args)
+    {
+        return add_value(arena.make<T>(std::forward<Args>(args)...));
+    }
+
+    bool add_value(psf::json_value* value)
+    {
+        if (!state_stack.empty())
         {
-            return reinterpret_cast<enumeration_handle*>(new iterator_type(itr));
+            assert(root);
+
+            // Keys are only used by objects; for arrays 'object_key' is empty
+            pending.push_back(json_object_impl::member{ object_key.data(), static_cast<unsigned>(object_key.length()), value });
+            object_key = {};
+        }
+        else if (!root)
+        {
+            root = value;
         }
         else
         {
-            return handle_from_iterator(itr);
+            error_message = "Can't have more than one root";
+            return false;
         }
+
+        return true;
     }
 
-    virtual enumeration_handle* advance(_In_ enumeration_handle* handle, _Inout_ enumeration_data* data) const noexcept override
+    bool Null()
     {
-        auto& itr = iterator_from_handle(handle);
-        assert(itr != values.end());
+        return on_value<json_null_impl>();
+    }
 
-        ++itr;
-        if (itr == values.end())
-        {
-            if constexpr (handle_requires_allocation)
-            {
-                delete &itr;
-            }
+    bool Bool(bool b)
+    {
+        return on_value<json_boolean_impl>(b);
+    }
 
-            *data = {};
-            return nullptr;
-        }
+    bool Int(std::int64_t value)
+    {
+        return on_value<json_number_impl>(value);
+    }
 
-        data->key = itr->first.c_str();
-        data->key_length = static_cast<unsigned>(itr->first.length());
-        data->value = itr->second.get();
+    bool Uint(std::uint64_t value)
+    {
+        return on_value<json_number_impl>(value);
+    }
 
-        return handle_from_iterator(itr);
+    bool Int64(std::int64_t value)
+    {
+        return on_value<json_number_impl>(value);
     }
 
-    virtual void cancel_enumeration(_In_ enumeration_handle* handle) const noexcept override
+    bool Uint64(std::uint64_t value)
     {
-        if constexpr (handle_requires_allocation)
-        {
-            delete &iterator_from_handle(handle);
-        }
+        return on_value<json_number_impl>(value);
     }
 
-    iterator_type& iterator_from_handle(enumeration_handle*& handle) const noexcept
+    bool Double(double value)
     {
-        assert(handle);
-        if constexpr (handle_requires_allocation)
-        {
-            // Allocation means that the handle pointer is actually a pointer to a map iterator
-            return *reinterpret_cast<iterator_type*>(handle);
-        }
-        else
+        return on_value<json_number_impl>(value);
+    }
+
+    bool RawNumber(const char* /*str*/, rapidjson::SizeType /*length*/, bool /*copy*/)
+    {
+        // Provided only to satisfy compilation, but never called since we never pass kParseNumbersAsStringsFlag
+        // Consider: Update rapidjson to use if constexpr
+        assert(false);
+        return false;
+    }
+
+    bool String(const char* str, rapidjson::SizeType length, [[maybe_unused]] bool copy)
+    {
+        // Caller should always own the memory
+        assert(copy);
+        return on_value<json_string_impl>(arena, std::string_view(str, length));
+    }
+
+    bool StartObject()
+    {
+        // NOTE: We must call 'on_value' before appending to 'state_stack', otherwise we'll try and add the object as a
+        //       child of itself
+        auto obj = arena.make<json_object_impl>();
+        auto result = add_value(obj);
+        if (result)
         {
-            // No allocation means that the handle pointer _is_ the map iterator, e.g. as if it were a union
-            return reinterpret_cast<iterator_type&>(handle);
+            state_stack.push_back({ obj, pending.size() });
         }
+
+        return result;
     }
 
-    enumeration_handle* handle_from_iterator(iterator_type& itr) const noexcept
+    bool Key(const char* str, rapidjson::SizeType length, [[maybe_unused]] bool copy)
     {
-        assert(itr != values.end());
-        if constexpr (handle_requires_allocation)
+        // Caller should always own the memory
+        assert(copy);
+        assert(object_key.empty());
+        object_key = std::string_view(arena.copy_string(std::string_view(str, length)), length);
+        return true;
+    }
+
+    bool EndObject([[maybe_unused]] rapidjson::SizeType memberCount)
+    {
+        assert(!state_stack.empty());
+        auto current = state_stack.back();
+        assert(current.container.index() == 0);
+        assert(pending.size() - current.first == memberCount);
+
+        auto begin = pending.begin() + current.first;
+        std::sort(begin, pending.end(), [](const json_object_impl::member& lhs, const json_object_impl::member& rhs)
         {
-            // Allocation means that the handle pointer is actually a pointer to a map iterator
-            return reinterpret_cast<enumeration_handle*>(&itr);
-        }
-        else
+            return lhs.key_view() < rhs.key_view();
+        });
+
+        auto duplicate = std::adjacent_find(begin, pending.end(), [](const json_object_impl::member& lhs, const json_object_impl::member& rhs)
         {
-            // No allocation means that the handle pointer _is_ the map iterator, e.g. as if it were a union
-            // NOTE: We can reinterpret_cast a pointer to a reference, but not the other way around...
-            return *reinterpret_cast<enumeration_handle**>(&itr);
+            return lhs.key_view() == rhs.key_view();
+        });
+        if (duplicate != pending.end())
+        {
+            error_message = "'" + std::string(duplicate->key_view()) + "' already exists in map";
+            return false;
         }
-    }
 
-    map_type values;
-};
+        auto obj = std::get<0>(current.container);
+        obj->count = static_cast<unsigned>(pending.size() - current.first);
+        obj->members = arena.copy_array(pending.data() + current.first, obj->count);
 
-struct json_array_impl : psf::json_array
-{
-    virtual unsigned size() const noexcept override
+        pending.erase(begin, pending.end());
+        state_stack.pop_back();
+        return true;
+    }
+
+    bool StartArray()
     {
-        return static_cast<unsigned>(values.size());
+        // NOTE: We must call 'on_value' before appending to 'state_stack', otherwise we'll try and add the array as a
+        //       child of itself
+        auto arr = arena.make<json_array_impl>();
+        auto result = add_value(arr);
+        if (result)
+        {
+            state_stack.push_back({ arr, pending.size() });
+        }
+
+        return result;
     }
 
-    virtual json_value* try_get_at(unsigned index) const noexcept override
+    bool EndArray([[maybe_unused]] rapidjson::SizeType elementCount)
     {
-        if (index >= values.size())
+        assert(!state_stack.empty());
+        auto current = state_stack.back();
+        assert(current.container.index() == 1);
+        assert(pending.size() - current.first == elementCount);
+
+        auto arr = std::get<1>(current.container);
+        arr->count = static_cast<unsigned>(pending.size() - current.first);
+        auto values = static_cast<psf::json_value**>(arena.allocate(std::max(arr->count, 1u) * sizeof(psf::json_value*), alignof(psf::json_value*)));
+        for (unsigned i = 0; i < arr->count; ++i)
         {
-            return nullptr;
+            values[i] = pending[current.first + i].value;
         }
+        arr->values = values;
 
-        return values[index].get();
+        pending.erase(pending.begin() + current.first, pending.end());
+        state_stack.pop_back();
+        return true;
     }
 
-    std::vector<std::unique_ptr<psf::json_value>> values;
+    // Owns the whole tree, which is never freed
+    json_arena arena;
+
+    // Root of the tree, filled in by the first object/array/string, etc. encountered
+    psf::json_value* root = nullptr;
+
+    // Since all we get are callbacks, we don't have the luxury of using stack memory to save state, so use the heap
+    // NOTE: Since we're immediately done processing strings, numbers, booleans, and null, we only need to save state
+    //       for objects and arrays, along with where their members start in 'pending'
+    struct open_container
+    {
+        std::variant<json_object_impl*, json_array_impl*> container;
+        std::size_t first;
+    };
+    std::vector<open_container> state_stack;
+    std::vector<json_object_impl::member> pending;
+    std::string_view object_key;
+
+    // When non-empty, provides a more useful error message displayed to the user for invalid config.json files
+    std::string error_message;
 };
+
+// Parses the contents of a config.json file, in any of the encodings that rapidjson detects from its BOM, into 'builder'
+inline rapidjson::ParseResult parse_json_contents(const char* data, std::size_t size, json_dom_builder& builder)
+{
+    rapidjson::MemoryStream stream(data, size);
+    rapidjson::AutoUTFInputStream<char32_t, rapidjson::MemoryStream> autoStream(stream);
+
+    rapidjson::GenericReader<rapidjson::AutoUTF<char32_t>, rapidjson::UTF8<>> reader;
+    return reader.Parse(autoStream, builder);
+}
@@ -0,0 +1,349 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) Tim Mangan. All rights reserved
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+//
+// The one log writer of the process. Every module that logs through psf_logging.cpp hands its messages to
+// PSFWriteLog/PSFWriteLogW here, so that all of them share a single queue, a single background thread and a single
+// file, and their messages come out in the order they were logged.
+
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#include <windows.h>
+#include <TraceLoggingProvider.h>
+
+#include <psf_log_queue.h>
+#include <psf_logging.h>
+#include <psf_runtime.h>
+#include <utilities.h>
+
+#include "Config.h"
+
+TRACELOGGING_DECLARE_PROVIDER(g_psf_LogProvider);
+TRACELOGGING_DEFINE_PROVIDER(
+    g_psf_LogProvider,
+    "Microsoft.Windows.PSF.Log",
+    (0xb5f77bf3, 0x4b15, 0x425b, 0xa8, 0x63, 0x61, 0x4e, 0x54, 0x48, 0x8b, 0x1f));
+
+using namespace std::literals;
+
+namespace
+{
+    enum class log_sink
+    {
+        debugger,
+        file,
+        etw,
+    };
+
+    // Writes the messages that the threads of the process log from a background thread, so that logging costs the
+    // thread being logged a format and a copy instead of a call into the kernel (that a debugger also serializes).
+    class async_log_writer
+    {
+    public:
+
+        // Returns nullptr if 'sink' is not a valid sink
+        static async_log_writer* create(const wchar_t* sink)
+        {
+            std::unique_ptr<async_log_writer> writer(new async_log_writer());
+            if (::_wcsicmp(sink, L"debugger") == 0)
+            {
+                writer->m_sink = log_sink::debugger;
+            }
+            else if (::_wcsicmp(sink, L"etw") == 0)
+            {
+                writer->m_sink = log_sink::etw;
+                ::TraceLoggingRegister(g_psf_LogProvider);
+            }
+            else if (::_wcsnicmp(sink, L"file:", 5) == 0)
+            {
+                auto filePath = std::filesystem::path(sink + 5) /
+                    (psf::current_executable_path().stem().native() + L"-" + std::to_wstring(::GetCurrentProcessId()) + L".log");
+
+                writer->m_sink = log_sink::file;
+                writer->m_file = ::CreateFileW(filePath.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                    nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+                if (writer->m_file == INVALID_HANDLE_VALUE)
+                {
+                    return nullptr;
+                }
+            }
+            else
+            {
+                return nullptr;
+            }
+
+            writer->m_wake = ::CreateEventW(nullptr, FALSE, FALSE, nullptr);
+            if (!writer->m_wake)
+            {
+                return nullptr;
+            }
+
+            // This may be under the loader lock, which is fine as long as nothing waits for the thread to start. The
+            // thread never exits, and PsfRuntime is only unloaded when the process exits.
+            auto thread = ::CreateThread(nullptr, 0, thread_proc, writer.get(), 0, nullptr);
+            if (!thread)
+            {
+                return nullptr;
+            }
+            ::CloseHandle(thread);
+
+            return writer.release();
+        }
+
+        // Only ever run when create fails
+        ~async_log_writer()
+        {
+            if (m_file != INVALID_HANDLE_VALUE)
+            {
+                ::CloseHandle(m_file);
+            }
+            if (m_wake)
+            {
+                ::CloseHandle(m_wake);
+            }
+        }
+
+        template <typename CharT>
+        void push(const CharT* message, std::size_t length) noexcept
+        {
+            m_queue.push(message, length);
+
+            // Pairs with the fence in run, so that either this sees the writer going to sleep or it sees this record
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (m_sleeping.load(std::memory_order_relaxed) && m_sleeping.exchange(false))
+            {
+                ::SetEvent(m_wake);
+            }
+        }
+
+        void flush() noexcept
+        {
+            std::lock_guard<std::mutex> lock(m_drainLock);
+            write_pending();
+        }
+
+        // Called while the process detaches PsfRuntime, under the loader lock, so it never waits. By then ExitProcess has
+        // terminated the writer thread, which may have been holding the lock; its records are then lost, but the ones
+        // logged before ExitProcess were already flushed by ExitProcessFixup.
+        void flush_at_exit() noexcept
+        {
+            if (m_drainLock.try_lock())
+            {
+                write_pending();
+                m_drainLock.unlock();
+            }
+        }
+
+    private:
+
+        async_log_writer() = default;
+
+        static DWORD __stdcall thread_proc(void* parameter) noexcept
+        {
+            static_cast<async_log_writer*>(parameter)->run();
+            return 0;
+        }
+
+        void run() noexcept
+        {
+            for (;;)
+            {
+                flush();
+
+                m_sleeping.store(true);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (m_queue.empty())
+                {
+                    // The timeout only bounds how long a record can wait if a wake up is ever missed
+                    ::WaitForSingleObject(m_wake, 100);
+                }
+                m_sleeping.store(false);
+            }
+        }
+
+        void write_pending() noexcept
+        {
+            m_queue.drain([&](const psf::log_record& record)
+            {
+                if (record.is_wide)
+                {
+                    write(record.wide(), record.length);
+                }
+                else
+                {
+                    write(record.narrow(), record.length);
+                }
+            });
+
+            auto dropped = m_queue.dropped();
+            if (dropped != m_reportedDrops)
+            {
+                char message[128];
+                auto length = std::snprintf(message, sizeof(message), "PSF logging dropped %llu message(s) because the log buffer was full.",
+                    static_cast<unsigned long long>(dropped - m_reportedDrops));
+                write(message, static_cast<std::size_t>(length));
+                m_reportedDrops = dropped;
+            }
+
+            if (!m_fileBuffer.empty())
+            {
+                DWORD written;
+                ::WriteFile(m_file, m_fileBuffer.data(), static_cast<DWORD>(m_fileBuffer.size()), &written, nullptr);
+                m_fileBuffer.clear();
+            }
+        }
+
+        void write(const char* message, std::size_t length) noexcept
+        {
+            switch (m_sink)
+            {
+            case log_sink::debugger:
+                ::OutputDebugStringA(message);
+                break;
+
+            case log_sink::etw:
+                TraceLoggingWrite(g_psf_LogProvider, "Log", TraceLoggingString(message, "Message"));
+                break;
+
+            case log_sink::file:
+                try
+                {
+                    append_line(message, length);
+                }
+                catch (...)
+                {
+                }
+                break;
+            }
+        }
+
+        void write(const wchar_t* message, std::size_t length) noexcept
+        {
+            switch (m_sink)
+            {
+            case log_sink::debugger:
+                ::OutputDebugStringW(message);
+                break;
+
+            case log_sink::etw:
+                TraceLoggingWrite(g_psf_LogProvider, "Log", TraceLoggingWideString(message, "Message"));
+                break;
+
+            case log_sink::file:
+                try
+                {
+                    auto utf8 = narrow(std::wstring_view(message, length), CP_UTF8);
+                    append_line(utf8.data(), utf8.length());
+                }
+                catch (...)
+                {
+                }
+                break;
+            }
+        }
+
+        void append_line(const char* message, std::size_t length)
+        {
+            while ((length > 0) && ((message[length - 1] == '\n') || (message[length - 1] == '\r')))
+            {
+                --length;
+            }
+            m_fileBuffer.append(message, length);
+            m_fileBuffer.append("\r\n");
+        }
+
+        psf::log_queue m_queue;
+        std::atomic<bool> m_sleeping{ false };
+        HANDLE m_wake = nullptr;
+
+        std::mutex m_drainLock;
+        log_sink m_sink = log_sink::debugger;
+        HANDLE m_file = INVALID_HANDLE_VALUE;
+        std::string m_fileBuffer;
+        std::uint64_t m_reportedDrops = 0;
+    };
+
+    std::atomic<async_log_writer*> g_asyncLog{ nullptr };
+    std::mutex g_asyncLogStartLock;
+
+    // The writer is never deleted, since threads may still be logging, but what is in its queue is written out when
+    // PsfRuntime is unloaded (which is only ever when the process exits); anything logged after that is written directly.
+    struct async_log_flusher
+    {
+        ~async_log_flusher()
+        {
+            if (auto writer = g_asyncLog.exchange(nullptr))
+            {
+                writer->flush_at_exit();
+            }
+        }
+    } g_asyncLogFlusher;
+
+    template <typename CharT>
+    void write_log(const CharT* message, std::size_t length) noexcept
+    {
+        if (auto writer = g_asyncLog.load(std::memory_order_acquire))
+        {
+            writer->push(message, length);
+        }
+        else if constexpr (sizeof(CharT) == sizeof(char))
+        {
+            ::OutputDebugStringA(message);
+        }
+        else
+        {
+            ::OutputDebugStringW(message);
+        }
+    }
+}
+
+bool StartAsyncLogging(const wchar_t* sink) noexcept try
+{
+    async_log_writer* writer;
+    {
+        std::lock_guard<std::mutex> lock(g_asyncLogStartLock);
+        if (g_asyncLog.load())
+        {
+            return true;
+        }
+
+        writer = async_log_writer::create(sink);
+        g_asyncLog.store(writer, std::memory_order_release);
+    }
+
+    if (!writer)
+    {
+        ::OutputDebugStringW((L"Unable to start logging to "s + sink + L"; logging to the debugger instead.").c_str());
+        return false;
+    }
+    return true;
+}
+catch (...)
+{
+    return false;
+}
+
+PSFAPI void __stdcall PSFWriteLog(_In_reads_(length) const char* message, std::size_t length) noexcept
+{
+    write_log(message, length);
+}
+
+PSFAPI void __stdcall PSFWriteLogW(_In_reads_(length) const wchar_t* message, std::size_t length) noexcept
+{
+    write_log(message, length);
+}
+
+PSFAPI void __stdcall PSFFlushLog() noexcept
+{
+    if (auto writer = g_asyncLog.load(std::memory_order_acquire))
+    {
+        writer->flush();
+    }
+}
@@ -0,0 +1,288 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) Tim Mangan. All rights reserved
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cwctype>
+#include <mutex>
+#include <set>
+#include <string>
+
+#include <windows.h>
+#include <psf_logging.h>
+#include <psf_runtime.h>
+#include <wil\resource.h>
+
+#include "Config.h"
+#include "PackageFileIndex.h"
+
+using namespace file_index;
+
+// Even packages with hundreds of thousands of files stay well below this
+static constexpr std::uint64_t max_index_size = 256 * 1024 * 1024;
+
+static std::wstring lower_file_name(std::wstring_view name)
+{
+    std::wstring result(name);
+    std::transform(result.begin(), result.end(), result.begin(), std::towlower);
+    return result;
+}
+
+struct walk_entry
+{
+    std::wstring name;
+    std::wstring path;
+};
+
+// Pre-order, the same as recursive_directory_iterator: the contents of a directory are visited as soon as the
+// directory itself is found, and directory links are not followed
+static void walk_package(const std::filesystem::path& root, const std::wstring& relative, std::vector<walk_entry>& entries)
+{
+    auto pattern = (relative.empty() ? root : (root / relative)) / L"*";
+    WIN32_FIND_DATAW findData;
+    wil::unique_hfind find(::FindFirstFileExW(pattern.c_str(), FindExInfoBasic, &findData, FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH));
+    if (!find)
+    {
+        return;
+    }
+
+    do
+    {
+        std::wstring_view name = findData.cFileName;
+        if ((name == L".") || (name == L".."))
+        {
+            continue;
+        }
+
+        auto path = relative.empty() ? std::wstring(name) : (relative + L'\\' + findData.cFileName);
+        if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+        {
+            if ((findData.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) == 0)
+            {
+                walk_package(root, path, entries);
+            }
+        }
+        else
+        {
+            entries.push_back({ lower_file_name(name), std::move(path) });
+        }
+    } while (::FindNextFileW(find.get(), &findData));
+}
+
+// Guards the join in PSFFindPackageFile, whatever the index holds
+static bool is_under_root(const std::filesystem::path& root, const std::filesystem::path& path)
+{
+    auto relative = path.lexically_normal().lexically_relative(root.lexically_normal());
+    return !relative.empty() && (*relative.begin() != L"..") && (*relative.begin() != L".");
+}
+
+static std::vector<std::uint8_t> build_index(std::vector<walk_entry> entries, std::wstring_view packageFullName, std::uint64_t rootWriteTime)
+{
+    std::stable_sort(entries.begin(), entries.end(), [](const walk_entry& lhs, const walk_entry& rhs)
+    {
+        return lhs.name < rhs.name;
+    });
+
+    auto stringsStart = sizeof(index_header) + entries.size() * sizeof(index_entry);
+    std::vector<std::uint8_t> data(stringsStart);
+    auto appendString = [&](std::wstring_view value)
+    {
+        auto offset = data.size();
+        auto bytes = reinterpret_cast<const std::uint8_t*>(value.data());
+        data.insert(data.end(), bytes, bytes + value.length() * sizeof(wchar_t));
+        data.insert(data.end(), sizeof(wchar_t), std::uint8_t{ 0 });
+        if (data.size() > max_index_size)
+        {
+            throw std::length_error("package file index is too large");
+        }
+        return static_cast<std::uint32_t>(offset);
+    };
+
+    auto table = reinterpret_cast<index_entry*>(data.data() + sizeof(index_header));
+    for (std::size_t i = 0; i < entries.size(); ++i)
+    {
+        index_entry entry;
+        entry.name_offset = appendString(entries[i].name);
+        entry.name_length = static_cast<std::uint32_t>(entries[i].name.length());
+        entry.path_offset = appendString(entries[i].path);
+        entry.path_length = static_cast<std::uint32_t>(entries[i].path.length());
+
+        // 'data' may have moved
+        table = reinterpret_cast<index_entry*>(data.data() + sizeof(index_header));
+        table[i] = entry;
+    }
+
+    index_header header = {};
+    header.signature = index_signature;
+    header.version = index_version;
+    header.package_length = static_cast<std::uint32_t>(packageFullName.length());
+    header.package_offset = appendString(packageFullName);
+    header.entry_count = static_cast<std::uint32_t>(entries.size());
+    header.entries_offset = sizeof(index_header);
+    header.index_size = static_cast<std::uint32_t>(data.size());
+    header.root_write_time = rootWriteTime;
+    std::copy_n(reinterpret_cast<const std::uint8_t*>(&header), sizeof(header), data.begin());
+    return data;
+}
+
+std::unique_ptr<package_file_index> package_file_index::load(const std::filesystem::path& packageRoot, std::wstring_view packageFullName, const std::filesystem::path& cachePath)
+{
+    auto rootWriteTime = psf::folder_write_time(packageRoot);
+    if (!cachePath.empty())
+    {
+        if (auto index = open(cachePath, packageFullName, rootWriteTime))
+        {
+            return index;
+        }
+    }
+
+    std::vector<walk_entry> entries;
+    walk_package(packageRoot, {}, entries);
+    Log(L"Package file index built with %u files.", static_cast<unsigned>(entries.size()));
+
+    auto data = build_index(std::move(entries), packageFullName, rootWriteTime);
+    if (!cachePath.empty())
+    {
+        if (psf::write_file_atomically(cachePath, { { data.data(), data.size() } }))
+        {
+            if (auto index = open(cachePath, packageFullName, rootWriteTime))
+            {
+                return index;
+            }
+        }
+        Log(L"Unable to cache the package file index at %ls.", cachePath.c_str());
+    }
+
+    return std::unique_ptr<package_file_index>(new package_file_index(std::move(data)));
+}
+
+std::unique_ptr<package_file_index> package_file_index::open(const std::filesystem::path& cachePath, std::wstring_view packageFullName, std::uint64_t rootWriteTime)
+{
+    auto file = psf::map_cache_file(cachePath, sizeof(index_header), max_index_size);
+    if (!file)
+    {
+        return nullptr;
+    }
+
+    std::unique_ptr<package_file_index> index(new package_file_index(std::move(file)));
+    if (!index->validate(packageFullName, rootWriteTime))
+    {
+        Log(L"Package file index %ls is not valid for this package, or is out of date; ignoring it.", cachePath.c_str());
+        return nullptr;
+    }
+    return index;
+}
+
+bool package_file_index::is_string_at(std::uint64_t offset, std::uint64_t length) const noexcept
+{
+    if ((offset % alignof(wchar_t)) || (offset > m_size) || (length >= (m_size - offset) / sizeof(wchar_t)))
+    {
+        return false;
+    }
+    return reinterpret_cast<const wchar_t*>(m_view + offset)[length] == 0;
+}
+
+bool package_file_index::validate(std::wstring_view packageFullName, std::uint64_t rootWriteTime) const noexcept
+{
+    auto& hdr = header();
+    if ((hdr.signature != index_signature) || (hdr.version != index_version) || (hdr.index_size != m_size) ||
+        (hdr.root_write_time != rootWriteTime))
+    {
+        return false;
+    }
+
+    if (!is_string_at(hdr.package_offset, hdr.package_length) || (string_at(hdr.package_offset, hdr.package_length) != packageFullName))
+    {
+        return false;
+    }
+
+    if ((hdr.entries_offset % alignof(index_entry)) || (hdr.entries_offset > m_size) ||
+        (hdr.entry_count > (m_size - hdr.entries_offset) / sizeof(index_entry)))
+    {
+        return false;
+    }
+
+    auto entries = reinterpret_cast<const index_entry*>(m_view + hdr.entries_offset);
+    for (std::uint32_t i = 0; i < hdr.entry_count; ++i)
+    {
+        if (!is_string_at(entries[i].name_offset, entries[i].name_length) || !is_string_at(entries[i].path_offset, entries[i].path_length) ||
+            !psf::is_package_relative_path(string_at(entries[i].path_offset, entries[i].path_length)) ||
+            ((i > 0) && (string_at(entries[i].name_offset, entries[i].name_length) < string_at(entries[i - 1].name_offset, entries[i - 1].name_length))))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::optional<std::wstring_view> package_file_index::find(std::wstring_view fileName, unsigned index) const
+{
+    auto name = lower_file_name(fileName);
+    auto& hdr = header();
+    auto begin = reinterpret_cast<const index_entry*>(m_view + hdr.entries_offset);
+    auto end = begin + hdr.entry_count;
+    auto itr = std::lower_bound(begin, end, std::wstring_view(name), [&](const index_entry& entry, std::wstring_view value)
+    {
+        return string_at(entry.name_offset, entry.name_length) < value;
+    });
+
+    // Entries with the same name are next to each other, in walk order
+    if ((static_cast<std::size_t>(end - itr) <= index) || (string_at(itr[index].name_offset, itr[index].name_length) != name))
+    {
+        return std::nullopt;
+    }
+    return string_at(itr[index].path_offset, itr[index].path_length);
+}
+
+static std::once_flag g_FileIndexOnce;
+static std::unique_ptr<package_file_index> g_FileIndex;
+
+// Paths handed out by PSFFindPackageFile, so that they stay valid
+static std::mutex g_FoundPathsLock;
+static std::set<std::wstring> g_FoundPaths;
+
+PSFAPI const wchar_t* __stdcall PSFFindPackageFile(_In_ const wchar_t* fileName, unsigned index) noexcept try
+{
+    std::call_once(g_FileIndexOnce, []
+    {
+        try
+        {
+            std::filesystem::path cachePath;
+            if (!psf::is_development_package(PackageFullName().c_str()))
+            {
+                cachePath = psf::local_cache_path(PSFQueryPackageFamilyName(), L"FileIndex.dat");
+            }
+            g_FileIndex = package_file_index::load(PackageRootPath(), PackageFullName(), cachePath);
+        }
+        catch (...)
+        {
+            Log(L"Unable to build the package file index.");
+        }
+    });
+
+    if (!g_FileIndex)
+    {
+        return nullptr;
+    }
+
+    auto relativePath = g_FileIndex->find(fileName, index);
+    if (!relativePath)
+    {
+        return nullptr;
+    }
+
+    auto path = PackageRootPath() / *relativePath;
+    if (!is_under_root(PackageRootPath(), path))
+    {
+        Log(L"Package file index entry %.*ls is outside the package; ignoring it.", static_cast<int>(relativePath->length()), relativePath->data());
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(g_FoundPathsLock);
+    return g_FoundPaths.insert(path.native()).first->c_str();
+}
+catch (...)
+{
+    return nullptr;
+}
@@ -0,0 +1,99 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) Tim Mangan. All rights reserved
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+//
+// An index of every file in the package by file name, used by PSFFindPackageFile instead of walking the package root
+// each time a file (config.json, a fixup, PsfRunDll, a script wrapper, ...) is not where it was first looked for.
+//
+// The index is built the first time that it is needed by walking the package root in the same order as
+// std::filesystem::recursive_directory_iterator, so the first match is the one the walk would have stopped at. It is
+// written to a cache file keyed on the package full name (the contents of an installed package never change), which
+// every other process of the package then maps read-only instead of walking again. Names are matched ignoring case.
+//
+// The cache file also records the last write time of the package root, and is rebuilt if that changes. Packages that
+// are registered from a development folder can change below the root without it, so they are never given a cache file
+// to begin with; their index only lives as long as the process.
+//
+// A cache file whose paths are rooted or step out with "..", which the walk never records, is ignored, and a found path
+// is only handed out if it lies under the package root.
+//
+// The file is a header, a table of entries sorted by lower-cased file name (and by walk order within a name), then
+// the null terminated wide strings they refer to: the lower-cased name and the path relative to the package root.
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include <psf_cache_files.h>
+
+namespace file_index
+{
+    inline constexpr std::uint32_t index_signature = 0x49465350; // "PSFI"
+    inline constexpr std::uint32_t index_version = 2;
+
+    struct index_header
+    {
+        std::uint32_t signature;
+        std::uint32_t version;
+        std::uint32_t package_offset;           // wide
+        std::uint32_t package_length;
+        std::uint32_t entry_count;
+        std::uint32_t entries_offset;
+        std::uint32_t index_size;
+        std::uint32_t reserved;
+        std::uint64_t root_write_time;          // FILETIME of the package root folder
+    };
+
+    struct index_entry
+    {
+        std::uint32_t name_offset;              // wide, lower-cased
+        std::uint32_t name_length;
+        std::uint32_t path_offset;              // wide, relative to the package root
+        std::uint32_t path_length;
+    };
+}
+
+class package_file_index
+{
+public:
+    // Maps the cached index for the package if there is a valid one, otherwise walks the package and tries to cache
+    // the result; if that fails, or cachePath is empty, the index is kept in memory
+    static std::unique_ptr<package_file_index> load(const std::filesystem::path& packageRoot, std::wstring_view packageFullName, const std::filesystem::path& cachePath);
+
+    package_file_index(const package_file_index&) = delete;
+    package_file_index& operator=(const package_file_index&) = delete;
+
+    // The path, relative to the package root, of the index'th file named fileName in walk order
+    std::optional<std::wstring_view> find(std::wstring_view fileName, unsigned index) const;
+
+private:
+    explicit package_file_index(psf::mapped_file file) noexcept : m_file(std::move(file)), m_view(m_file.data()), m_size(m_file.size()) {}
+    explicit package_file_index(std::vector<std::uint8_t> data) noexcept : m_data(std::move(data)), m_view(m_data.data()), m_size(m_data.size()) {}
+
+    static std::unique_ptr<package_file_index> open(const std::filesystem::path& cachePath, std::wstring_view packageFullName, std::uint64_t rootWriteTime);
+
+    const file_index::index_header& header() const noexcept
+    {
+        return *reinterpret_cast<const file_index::index_header*>(m_view);
+    }
+
+    std::wstring_view string_at(std::uint32_t offset, std::uint32_t length) const noexcept
+    {
+        return { reinterpret_cast<const wchar_t*>(m_view + offset), length };
+    }
+
+    bool is_string_at(std::uint64_t offset, std::uint64_t length) const noexcept;
+    bool validate(std::wstring_view packageFullName, std::uint64_t rootWriteTime) const noexcept;
+
+    // One of these backs m_view: the cache file, or the index built in memory when it could not be cached
+    psf::mapped_file m_file;
+    std::vector<std::uint8_t> m_data;
+
+    const std::uint8_t* m_view;
+    std::size_t m_size;
+};
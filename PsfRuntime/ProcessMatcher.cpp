@@ -0,0 +1,153 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) Tim Mangan. All rights reserved
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <mutex>
+
+#include <windows.h>
+#include <psf_logging.h>
+
+#include "ProcessMatcher.h"
+
+// Characters with a meaning to the ECMAScript grammar; a pattern with none of these outside of an escape is a literal
+static constexpr std::wstring_view regex_special_chars = L"\\^$.|?*+()[]{}";
+
+static bool parse_literal(std::wstring_view pattern, std::wstring& text)
+{
+    text.clear();
+    for (std::size_t i = 0; i < pattern.length(); ++i)
+    {
+        auto ch = pattern[i];
+        if (ch == L'\\')
+        {
+            if ((++i == pattern.length()) || (regex_special_chars.find(pattern[i]) == std::wstring_view::npos))
+            {
+                return false;
+            }
+            ch = pattern[i];
+        }
+        else if (regex_special_chars.find(ch) != std::wstring_view::npos)
+        {
+            return false;
+        }
+
+        text.push_back(ch);
+    }
+
+    return true;
+}
+
+// '.' matches anything but a line terminator
+static bool is_line_terminator(wchar_t ch)
+{
+    return (ch == L'\n') || (ch == L'\r') || (ch == L'\u2028') || (ch == L'\u2029');
+}
+
+void process_matcher::assign(const psf::json_value* processes)
+{
+    m_entries.clear();
+    m_exactNames.clear();
+    m_cache.clear();
+    if (!processes)
+    {
+        return;
+    }
+
+    for (auto& processConfig : processes->as_array())
+    {
+        auto& obj = processConfig.as_object();
+        auto exe = obj.try_get("executable");
+        if (!exe)
+        {
+            Log(L"Processes entry without an executable ignored.");
+            continue;
+        }
+
+        entry current{};
+        current.config = &obj;
+        auto pattern = exe->as_string().wstring();
+        if (parse_literal(pattern, current.text))
+        {
+            current.kind = pattern_kind::exact;
+            m_exactNames.try_emplace(current.text, m_entries.size());
+        }
+        else if ((pattern.length() >= 2) && (pattern.substr(pattern.length() - 2) == L".*") &&
+            parse_literal(pattern.substr(0, pattern.length() - 2), current.text))
+        {
+            current.kind = pattern_kind::prefix;
+        }
+        else
+        {
+            try
+            {
+                current.kind = pattern_kind::regex;
+                current.text = pattern;
+                current.regex.assign(pattern);
+            }
+            catch (...)
+            {
+                LogCountedStringW("Bad processes executable pattern ignored", pattern.data(), pattern.length());
+                continue;
+            }
+        }
+
+        m_entries.push_back(std::move(current));
+    }
+}
+
+const psf::json_object* process_matcher::find(std::wstring_view executable) const
+{
+    std::wstring name(executable);
+    {
+        std::shared_lock<std::shared_mutex> lock(m_cacheLock);
+        if (auto itr = m_cache.find(name); itr != m_cache.end())
+        {
+            return itr->second;
+        }
+    }
+
+    auto result = match(executable);
+    std::unique_lock<std::shared_mutex> lock(m_cacheLock);
+    m_cache.try_emplace(std::move(name), result);
+    return result;
+}
+
+const psf::json_object* process_matcher::match(std::wstring_view executable) const
+{
+    // An exact name match only wins if no earlier entry matches
+    auto limit = m_entries.size();
+    if (auto itr = m_exactNames.find(std::wstring(executable)); itr != m_exactNames.end())
+    {
+        limit = itr->second;
+    }
+
+    for (std::size_t i = 0; i < limit; ++i)
+    {
+        auto& current = m_entries[i];
+        switch (current.kind)
+        {
+        case pattern_kind::exact:
+            // Would have been found by the lookup
+            break;
+
+        case pattern_kind::prefix:
+            if ((executable.substr(0, current.text.length()) == current.text) &&
+                std::none_of(executable.begin() + current.text.length(), executable.end(), is_line_terminator))
+            {
+                return current.config;
+            }
+            break;
+
+        case pattern_kind::regex:
+            if (current.regex.match(executable))
+            {
+                return current.config;
+            }
+            break;
+        }
+    }
+
+    return (limit < m_entries.size()) ? m_entries[limit].config : nullptr;
+}
@@ -0,0 +1,57 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) Tim Mangan. All rights reserved
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+//
+// The "processes" array of config.json, compiled once into a list of matchers. Entries are still tried in the order
+// of the array and the first one to match wins, but patterns that are plain names ("PsfLauncher1") are found through
+// a hash lookup, plain names followed by ".*" ("PsfLauncher.*") by comparing the prefix, and only the rest are run as
+// regular expressions, each compiled just once. Results are remembered per executable name, as the same children tend
+// to be launched over and over.
+#pragma once
+
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <dfa_regex.h>
+#include <psf_config.h>
+
+class process_matcher
+{
+public:
+    // Entries without an "executable", or whose pattern is not a valid regular expression, are logged and skipped.
+    // Not safe to call while find is running on another thread.
+    void assign(const psf::json_value* processes);
+
+    // Equivalent to regex matching the name against the "executable" of each entry in turn
+    const psf::json_object* find(std::wstring_view executable) const;
+
+private:
+    enum class pattern_kind
+    {
+        exact,
+        prefix,
+        regex,
+    };
+
+    struct entry
+    {
+        pattern_kind kind;
+        std::wstring text;
+        psf::dfa_regex regex;
+        const psf::json_object* config;
+    };
+
+    const psf::json_object* match(std::wstring_view executable) const;
+
+    std::vector<entry> m_entries;
+
+    // First entry with each exact name
+    std::unordered_map<std::wstring, std::size_t> m_exactNames;
+
+    mutable std::shared_mutex m_cacheLock;
+    mutable std::unordered_map<std::wstring, const psf::json_object*> m_cache;
+};
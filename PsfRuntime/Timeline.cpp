@@ -0,0 +1,82 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) Tim Mangan. All rights reserved
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <windows.h>
+#include <psf_cache_files.h>
+#include <psf_logging.h>
+#include <psf_runtime.h>
+#include <psf_timeline.h>
+#include <utilities.h>
+
+#include "Config.h"
+
+static psf::span_recorder g_Timeline;
+static bool g_WriteTimelineOnExit = false;
+static std::atomic<bool> g_TimelineWrittenOnExit = false;
+
+void SetWriteTimelineOnExit(bool enabled) noexcept
+{
+    g_WriteTimelineOnExit = enabled;
+}
+
+// Never called from DllMain: writing the file creates folders and may load dlls, which can't be done under the loader
+// lock. Only the first call, from whichever of the two ways out the process takes (see main.cpp), writes the timeline.
+void WriteTimelineOnExit() noexcept
+{
+    if (g_WriteTimelineOnExit && !g_TimelineWrittenOnExit.exchange(true))
+    {
+        ::PSFWriteTimeline(nullptr);
+    }
+}
+
+PSFAPI std::uint64_t __stdcall PSFTimelineNow() noexcept
+{
+    return psf::span_recorder::now();
+}
+
+PSFAPI void __stdcall PSFRecordSpan(_In_ const char* name, std::uint64_t start, std::uint64_t end) noexcept
+{
+    g_Timeline.record(name, start, end, ::GetCurrentThreadId());
+}
+
+PSFAPI BOOL __stdcall PSFWriteTimeline(_In_opt_ const wchar_t* path) noexcept try
+{
+    auto processId = ::GetCurrentProcessId();
+    auto executable = psf::current_executable_path().filename();
+
+    std::filesystem::path outputPath;
+    if (path)
+    {
+        outputPath = path;
+    }
+    else
+    {
+        outputPath = psf::local_cache_path(PSFQueryPackageFamilyName(), L"Timeline");
+        std::error_code ec;
+        std::filesystem::create_directories(outputPath, ec);
+        outputPath /= executable.stem().native() + L"-" + std::to_wstring(processId) + L".json";
+    }
+
+    std::ofstream file(outputPath, std::ios::out | std::ios::trunc);
+    g_Timeline.write_chrome_trace(file, processId, narrow(executable.c_str()));
+    file.close();
+    if (!file)
+    {
+        Log(L"Unable to write the timeline to %ls.", outputPath.c_str());
+        return FALSE;
+    }
+
+    Log(L"Timeline written to %ls.", outputPath.c_str());
+    return TRUE;
+}
+catch (...)
+{
+    return FALSE;
+}
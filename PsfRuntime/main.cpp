@@ -4,6 +4,8 @@
 //-------------------------------------------------------------------------------------------------------
 
 #include <algorithm>
+#include <optional>
+#include <set>
 #include <sstream>
 
 #include <detour_transaction.h>
@@ -56,6 +58,161 @@ std::vector<loaded_fixup> loaded_fixups;
 bool usingPsf = false;
 wchar_t g_PsfRunTimeModulePath[MAX_PATH];
 
+// A fixup that has been loaded, but not yet initialized
+struct pending_fixup
+{
+    std::size_t index;  // into loaded_fixups
+    std::filesystem::path path;
+    PSFInitializeProc initialize;
+    PSFUninitializeProc uninitialize;
+
+    std::vector<detour_registration> registrations;
+    bool initialized = false;
+    bool committed = false;
+};
+
+// Initializes the fixups, one at a time in the order they are listed, and attaches their detours.
+//
+// Ordering: by default each fixup's detours are committed before the next fixup is loaded, as PSF has always done, so a
+// fixup loads and initializes with the detours of every fixup listed before it in place. A fixup whose entry sets
+// "shareTransaction": true declares that it does not depend on those, and its detours join the open transaction
+// instead, saving a commit (each one suspends the threads and flushes the instruction cache). Detours can't attach the
+// same function twice in one transaction, so a fixup that detours a function already in the open transaction commits
+// it first, even when it shares, giving the same chain of detours as committing one fixup at a time.
+//
+// Failures: while a fixup initializes, its attaches are only recorded, so a fixup that fails leaves nothing in the
+// transaction. As before, a fixup that fails to initialize, or to attach its detours, fails the launch: the fixups
+// before it are committed, so that they are uninitialized as usual, and the error is thrown.
+class fixup_initializer
+{
+public:
+
+    // Called before each fixup is loaded
+    void before_load(std::vector<pending_fixup>& pending, bool shareTransaction)
+    {
+        if (!shareTransaction)
+        {
+            commit(pending);
+        }
+    }
+
+    void initialize(std::vector<pending_fixup>& pending, pending_fixup& fixup)
+    {
+        auto start = ::PSFTimelineNow();
+        if (!m_transaction)
+        {
+            begin_transaction();
+        }
+
+        SetDetourRegistrationLog(&fixup.registrations);
+        auto initializeStart = ::PSFTimelineNow();
+        auto result = fixup.initialize();
+        ::PSFRecordSpan(("initialize " + narrow(fixup.path.filename().c_str())).c_str(), initializeStart, ::PSFTimelineNow());
+        SetDetourRegistrationLog(nullptr);
+        if (result != ERROR_SUCCESS)
+        {
+            Log("\tERROR: fixup %ls failed to initialize, error 0x%x.", fixup.path.c_str(), result);
+            commit(pending);
+            throw_win32(result, ("PSFInitialize failed in " + narrow(fixup.path.c_str())).c_str());
+        }
+
+        bool conflicts = std::any_of(fixup.registrations.begin(), fixup.registrations.end(), [&](const detour_registration& registration)
+        {
+            return m_transactionFunctions.count(registration.function) != 0;
+        });
+        if (conflicts)
+        {
+            commit(pending);
+            begin_transaction();
+        }
+
+        if (auto error = attach_recorded(fixup); error != NO_ERROR)
+        {
+            // Part of it may already be in the transaction, which can't be taken back, so start over with the others
+            Log("\tERROR: fixup %ls could not attach its detours, error 0x%x.", fixup.path.c_str(), error);
+            begin_transaction();
+            for (auto& other : pending)
+            {
+                if (other.initialized && !other.committed)
+                {
+                    check_win32(attach_recorded(other));
+                }
+            }
+            commit(pending);
+            throw_win32(error, ("DetourAttach failed for " + narrow(fixup.path.c_str())).c_str());
+        }
+
+        fixup.initialized = true;
+        m_elapsed += ::PSFTimelineNow() - start;
+    }
+
+    // Commits what is left; returns the number of transactions committed
+    unsigned finish(std::vector<pending_fixup>& pending)
+    {
+        commit(pending);
+        return m_commits;
+    }
+
+    // Time spent in PSFInitialize, attaching and committing, in nanoseconds; loading the fixups is not included
+    std::uint64_t elapsed() const noexcept
+    {
+        return m_elapsed;
+    }
+
+private:
+
+    // Aborts the open transaction, if any
+    void begin_transaction()
+    {
+        m_transaction.emplace();
+        check_win32(::DetourUpdateThread(::GetCurrentThread()));
+        m_transactionFunctions.clear();
+    }
+
+    DWORD attach_recorded(const pending_fixup& fixup)
+    {
+        for (auto& registration : fixup.registrations)
+        {
+            if (auto result = ::DetourAttach(registration.target, registration.detour); result != NO_ERROR)
+            {
+                return result;
+            }
+            m_transactionFunctions.insert(registration.function);
+        }
+        return NO_ERROR;
+    }
+
+    // Only set the uninitialize pointer once the transaction commits successfully, since that's our cue to clean it
+    // up, which will attempt to call DetourDetach
+    void commit(std::vector<pending_fixup>& pending)
+    {
+        if (!m_transaction)
+        {
+            return;
+        }
+
+        auto start = ::PSFTimelineNow();
+        auto transaction = std::move(*m_transaction);
+        m_transaction.reset();
+        transaction.commit();
+        ++m_commits;
+        m_elapsed += ::PSFTimelineNow() - start;
+        for (auto& fixup : pending)
+        {
+            if (fixup.initialized && !fixup.committed)
+            {
+                fixup.committed = true;
+                loaded_fixups[fixup.index].uninitialize = fixup.uninitialize;
+            }
+        }
+    }
+
+    std::optional<detours::transaction> m_transaction;
+    std::set<void*> m_transactionFunctions;
+    unsigned m_commits = 0;
+    std::uint64_t m_elapsed = 0;
+};
+
 void load_fixups()
 {
     using namespace std::literals;
@@ -68,137 +225,156 @@ void load_fixups()
             {
                 if (fixups != nullptr)
                 {
-                    for (auto& fixupConfig : fixups->as_array())
-                    {
-                        auto& fixup = loaded_fixups.emplace_back();
+                    std::vector<pending_fixup> pending;
+                    fixup_initializer initializer;
+                    std::uint64_t loadTime = 0;
+                    auto start = ::PSFTimelineNow();
 
-                        auto path = PackageRootPath() / fixupConfig.as_object().get("dll").as_string().wide();
-#if _DEBUG
-                        Log("\tfixup to attempt to load as specified: %ls.", path.c_str());
-#endif
-                        fixup.module_handle = ::LoadLibraryW(path.c_str());
-                        if (!fixup.module_handle)
+                    try
+                    {
+                        for (auto& fixupConfig : fixups->as_array())
                         {
-                            path.replace_extension();
-                            path.concat((sizeof(void*) == 4) ? L"32.dll" : L"64.dll");
+                            auto shareTransaction = fixupConfig.as_object().try_get("shareTransaction");
+                            initializer.before_load(pending, shareTransaction && shareTransaction->as_boolean().get());
+
+                            auto& fixup = loaded_fixups.emplace_back();
+                            auto loadStart = ::PSFTimelineNow();
+
+                            auto path = PackageRootPath() / fixupConfig.as_object().get("dll").as_string().wide();
 #if _DEBUG
-                            Log("\tfixup to attempt to load as: %ls.", path.c_str());
+                            Log("\tfixup to attempt to load as specified: %ls.", path.c_str());
 #endif
                             fixup.module_handle = ::LoadLibraryW(path.c_str());
-
                             if (!fixup.module_handle)
                             {
+                                path.replace_extension();
+                                path.concat((sizeof(void*) == 4) ? L"32.dll" : L"64.dll");
 #if _DEBUG
-                                Log("\tfixup not found as specified,checkroot of package." );
+                                Log("\tfixup to attempt to load as: %ls.", path.c_str());
 #endif
-                                std::filesystem::path pathfromroot = PackageRootPath() / path.filename().c_str();
-                                fixup.module_handle = ::LoadLibraryW(pathfromroot.c_str());
-                                if (fixup.module_handle)
+                                fixup.module_handle = ::LoadLibraryW(path.c_str());
+
+                                if (!fixup.module_handle)
                                 {
 #if _DEBUG
-                                    Log("\tfixup found at . %ls", pathfromroot.c_str());
+                                    Log("\tfixup not found as specified,checkroot of package." );
+#endif
+                                    std::filesystem::path pathfromroot = PackageRootPath() / path.filename().c_str();
+                                    fixup.module_handle = ::LoadLibraryW(pathfromroot.c_str());
+                                    if (fixup.module_handle)
+                                    {
+#if _DEBUG
+                                        Log("\tfixup found at . %ls", pathfromroot.c_str());
 #endif                            
-                                    path = pathfromroot;
-                                }
+                                        path = pathfromroot;
+                                    }
 #ifdef MOREDEBUG
-                                else
-                                {
-                                    DWORD rember = GetLastError();
-                                    DWORD att = ::GetFileAttributesW(pathfromroot.c_str());
-                                    if (att != INVALID_FILE_ATTRIBUTES)
+                                    else
                                     {
-                                        Log("\t???file %ls attrib 0x%x but load error 0x%x", pathfromroot.c_str(), att, rember);
+                                        DWORD rember = GetLastError();
+                                        DWORD att = ::GetFileAttributesW(pathfromroot.c_str());
+                                        if (att != INVALID_FILE_ATTRIBUTES)
+                                        {
+                                            Log("\t???file %ls attrib 0x%x but load error 0x%x", pathfromroot.c_str(), att, rember);
+                                        }
                                     }
-                                }
 #endif
-                            }
+                                }
 
-                            if (!fixup.module_handle)
-                            {
+                                if (!fixup.module_handle)
+                                {
 #if _DEBUG
-                                Log("\tfixup not found at root of package, look elsewhere.");
+                                    Log("\tfixup not found at root of package, look elsewhere.");
 #endif
-                                // just try to find it elsewhere as it isn't at the root
-                                for (auto& dentry : std::filesystem::recursive_directory_iterator(PackageRootPath()))
-                                {
-                                    if (!fixup.module_handle)
+                                    // just try to find it elsewhere as it isn't at the root
+                                    for (unsigned match = 0; !fixup.module_handle; ++match)
                                     {
-                                        try
+                                        auto foundPath = PSFFindPackageFile(path.filename().c_str(), match);
+                                        if (!foundPath)
                                         {
-                                            if (dentry.path().filename().compare(path.filename().c_str()) == 0)
-                                            {
+                                            // Reported below the same way as having walked the whole package
+                                            ::SetLastError(ERROR_NO_MORE_FILES);
+                                            break;
+                                        }
+
+                                        std::filesystem::path candidate = foundPath;
 #if _DEBUG
-                                                Log("\tfixup might be found as %ls.", dentry.path().c_str());
+                                        Log("\tfixup might be found as %ls.", candidate.c_str());
 #endif
-                                                fixup.module_handle = ::LoadLibraryW(dentry.path().c_str());
-                                                if (!fixup.module_handle)
-                                                {
-                                                    auto d2 = dentry.path();
-                                                    d2.replace_extension();
-                                                    d2.concat((sizeof(void*) == 4) ? L"32.dll" : L"64.dll");
-                                                    fixup.module_handle = ::LoadLibraryW(d2.c_str());
-                                                }
-                                                if (fixup.module_handle)
-                                                {
-#if _DEBUG
-                                                    Log("\tfixup found at . %ls", dentry.path().c_str());
-#endif                            
-                                                    path = dentry.path();
-                                                    break;
-                                                }
-                                            }
+                                        fixup.module_handle = ::LoadLibraryW(candidate.c_str());
+                                        if (!fixup.module_handle)
+                                        {
+                                            auto d2 = candidate;
+                                            d2.replace_extension();
+                                            d2.concat((sizeof(void*) == 4) ? L"32.dll" : L"64.dll");
+                                            fixup.module_handle = ::LoadLibraryW(d2.c_str());
                                         }
-                                        catch (...)
+                                        if (fixup.module_handle)
                                         {
-                                            Log("Non-fatal error enumerating directories while looking for fixup.");
+#if _DEBUG
+                                            Log("\tfixup found at . %ls", candidate.c_str());
+#endif
+                                            path = candidate;
                                         }
                                     }
-                                    else
-                                        break;
                                 }
-                            }
 
 
-                            if (!fixup.module_handle)
+                                if (!fixup.module_handle)
+                                {
+                                    if (GetLastError() == ERROR_NO_MORE_FILES)
+                                    {
+                                        Log("\tERROR: fixup not found in package; ignoring.");
+                                    }
+                                    else
+                                    {
+                                        auto message = narrow(path.c_str());
+                                        throw_last_error(message.c_str());
+                                    }
+                                }
+                            }
+                            if (fixup.module_handle)
                             {
-                                if (GetLastError() == ERROR_NO_MORE_FILES)
+                                Log("\tInjected into current process: %ls\n", path.c_str());
+
+                                auto initialize = reinterpret_cast<PSFInitializeProc>(::GetProcAddress(fixup.module_handle, "PSFInitialize"));
+                                if (!initialize)
                                 {
-                                    Log("\tERROR: fixup not found in package; ignoring.");
+                                    auto message = "PSFInitialize export not found in "s + narrow(path.c_str());
+                                    throw_win32(ERROR_PROC_NOT_FOUND, message.c_str());
                                 }
-                                else
+                                auto uninitialize = reinterpret_cast<PSFUninitializeProc>(::GetProcAddress(fixup.module_handle, "PSFUninitialize"));
+                                if (!uninitialize)
                                 {
-                                    auto message = narrow(path.c_str());
-                                    throw_last_error(message.c_str());
+                                    auto message = "PSFUninitialize export not found in "s + narrow(path.c_str());
+                                    throw_win32(ERROR_PROC_NOT_FOUND, message.c_str());
                                 }
-                            }
-                        }
-                        if (fixup.module_handle)
-                        {
-                            Log("\tInjected into current process: %ls\n", path.c_str());
 
-                            auto initialize = reinterpret_cast<PSFInitializeProc>(::GetProcAddress(fixup.module_handle, "PSFInitialize"));
-                            if (!initialize)
-                            {
-                                auto message = "PSFInitialize export not found in "s + narrow(path.c_str());
-                                throw_win32(ERROR_PROC_NOT_FOUND, message.c_str());
-                            }
-                            auto uninitialize = reinterpret_cast<PSFUninitializeProc>(::GetProcAddress(fixup.module_handle, "PSFUninitialize"));
-                            if (!uninitialize)
-                            {
-                                auto message = "PSFUninitialize export not found in "s + narrow(path.c_str());
-                                throw_win32(ERROR_PROC_NOT_FOUND, message.c_str());
+                                pending.push_back({ loaded_fixups.size() - 1, path, initialize, uninitialize });
+                                auto loadEnd = ::PSFTimelineNow();
+                                ::PSFRecordSpan(("load " + narrow(path.filename().c_str())).c_str(), loadStart, loadEnd);
+                                loadTime += loadEnd - loadStart;
+                                initializer.initialize(pending, pending.back());
                             }
-
-                            auto transaction = detours::transaction();
-                            check_win32(::DetourUpdateThread(::GetCurrentThread()));
-
-                            // Only set the uninitialize pointer if the transaction commits successfully since that's our cue to clean
-                            // it up, which will attempt to call DetourDetach
-                            check_win32(initialize());
-                            transaction.commit();
-                            fixup.uninitialize = uninitialize;
                         }
                     }
+                    catch (...)
+                    {
+                        // A fixup that can't be loaded fails the launch too; the fixups before it stay attached
+                        initializer.finish(pending);
+                        throw;
+                    }
+
+                    auto commits = initializer.finish(pending);
+                    auto attached = ::PSFTimelineNow();
+                    ::PSFRecordSpan("load and initialize fixups", start, attached);
+
+                    auto ms = [](std::uint64_t duration)
+                    {
+                        return static_cast<double>(duration) / 1000000.0;
+                    };
+                    Log("\tFixups: %u loaded in %.2f ms, then initialized and attached in %.2f ms with %u transaction commit(s); %.2f ms in all.",
+                        static_cast<unsigned>(pending.size()), ms(loadTime), ms(initializer.elapsed()), commits, ms(attached - start));
                 }
             }
         }
@@ -231,7 +407,13 @@ static int __stdcall FixupEntryPoint() noexcept try
     Log("PsfRuntime FixupEntryPoint in App Pid=%d Tid=%d", GetCurrentProcessId(), GetCurrentThreadId());
 #endif
     load_fixups();
-    return ApplicationEntryPoint();
+    auto result = ApplicationEntryPoint();
+
+    // An entry point that returns, rather than calling ExitProcess, ends the process without passing through
+    // ExitProcessFixup
+    WriteTimelineOnExit();
+    ::PSFFlushLog();
+    return result;
 }
 catch (...)
 {
@@ -240,8 +422,24 @@ catch (...)
     return  err;
 }
 
+namespace impl
+{
+    inline auto ExitProcess = &::ExitProcess;
+}
+
+// Most applications leave through ExitProcess (the C runtime calls it once main returns). This runs before it takes the
+// loader lock and terminates the other threads, so it can still write files and wait for the log writer thread.
+void WINAPI ExitProcessFixup(_In_ UINT exitCode) noexcept
+{
+    WriteTimelineOnExit();
+    ::PSFFlushLog();
+    impl::ExitProcess(exitCode);
+}
+DECLARE_FIXUP(impl::ExitProcess, ExitProcessFixup);
+
 void attach()
 {
+    psf::timeline_span span("PsfRuntime attach");
     try
     {
 #if _DEBUG
@@ -294,6 +492,7 @@ void detach()
         if (usingPsf)
         {
             //Log("DEBUG: PsfRuntime Dettach Pid=%d",GetCurrentProcessId());
+
             // Unload in the reverse order as we initialized
             unload_fixups();
 
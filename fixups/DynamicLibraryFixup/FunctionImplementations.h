@@ -17,6 +17,8 @@
 // unnecessary invocation of the fixup
 inline thread_local psf::reentrancy_guard g_reentrancyGuard;
 
+inline psf::log_category g_logLoadLibrary{ "loadLibrary" };
+
 namespace impl
 {
 
@@ -4,10 +4,12 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 //-------------------------------------------------------------------------------------------------------
 
+#include <algorithm>
 #include <regex>
+#include <unordered_map>
 #include <vector>
 
-#include <known_folders.h>
+#include <psf_cache_files.h>
 #include <objbase.h>
 
 #include <psf_framework.h>
@@ -18,6 +20,7 @@
 
 #include "FunctionImplementations.h"
 #include "dll_location_spec.h"
+#include "PackageDllScan.h"
 
 #if _DEBUG
 //#define MOREDEBUG 1
@@ -28,10 +31,84 @@ using namespace std::literals;
 std::filesystem::path g_dynf_packageRootPath;
 std::filesystem::path g_dynf_packageVfsRootPath;
 bool                  g_dynf_forcepackagedlluse = false;
+bool                  g_dynf_scanpackage = false;
 
 
 std::vector<dll_location_spec> g_dynf_dllSpecs;
 
+// The specs usable by this process, by lower-cased name both with and without ".dll"; the first one in the config wins
+std::unordered_map<std::wstring, size_t> g_dynf_dllSpecsByName;
+
+static std::wstring LowerDllName(std::wstring_view name)
+{
+    std::wstring result(name);
+    std::transform(result.begin(), result.end(), result.begin(), towlower);
+    return result;
+}
+
+bool IsUsableArchitecture(dllBitness architecture)
+{
+    [[maybe_unused]] BOOL procTest = false;
+    switch (architecture)
+    {
+    case x86:
+#if defined(_WIN64)
+        // Only a 32-bit process on an x64 OS can use it; the call itself should never fail.
+        return IsWow64Process(GetCurrentProcess(), &procTest) && (procTest == TRUE);
+#else
+        // Only 32-bit is valid if we are built as 32-bit.
+        return true;
+#endif
+    case x64:
+#if defined(_WIN64)
+        // Only a 64-bit process on an x64 OS can use it; the call itself should never fail.
+        return IsWow64Process(GetCurrentProcess(), &procTest) && (procTest == FALSE);
+#else
+        // Can't use x64 dll if we are a 32-bit process
+        return false;
+#endif
+    case AnyCPU:
+    case NotSpecified:
+    default:
+        return true;
+    }
+}
+
+static void IndexDllSpec(size_t index)
+{
+    auto& spec = g_dynf_dllSpecs[index];
+    if (!IsUsableArchitecture(spec.architecture))
+    {
+#if MOREDEBUG
+        Log(L"DynamicLibraryFixup: %s skipped, architecture does not match this process.", spec.full_filepath.c_str());
+#endif
+        return;
+    }
+
+    auto name = LowerDllName(spec.filename);
+    g_dynf_dllSpecsByName.emplace(name, index);
+    constexpr auto dllExtension = L".dll"sv;
+    if ((name.length() > dllExtension.length()) &&
+        (name.compare(name.length() - dllExtension.length(), dllExtension.length(), dllExtension) == 0))
+    {
+        g_dynf_dllSpecsByName.emplace(name.substr(0, name.length() - dllExtension.length()), index);
+    }
+    else
+    {
+        g_dynf_dllSpecsByName.emplace(name + std::wstring(dllExtension), index);
+    }
+}
+
+const dll_location_spec* FindDllSpec(const std::wstring& requested)
+{
+    auto name = LowerDllName(requested);
+    if (auto found = g_dynf_dllSpecsByName.find(name); found != g_dynf_dllSpecsByName.end())
+    {
+        return &g_dynf_dllSpecs[found->second];
+    }
+    return g_dynf_scanpackage ? FindScannedDllSpec(name) : nullptr;
+}
+
 void InitializeFixups()
 {
 #if _DEBUG
@@ -54,6 +131,8 @@ void InitializeFixups()
 
 void InitializeConfiguration()
 {
+    SetLogLevels(::PSFQueryCurrentDllLogLevel());
+
 #if _DEBUG
     Log(L"DynamicLibraryFixup InitializeConfiguration()");
 #endif
@@ -111,6 +190,7 @@ void InitializeConfiguration()
                         g_dynf_dllSpecs.back().full_filepath = fullpath;
                         g_dynf_dllSpecs.back().filename = filename;
                         g_dynf_dllSpecs.back().architecture = bitness;
+                        IndexDllSpec(g_dynf_dllSpecs.size() - 1);
 #if MOREDEBUG
                         Log(L"DynamicLibraryFixup: %s : (%s=%d) : %s", filename.data(), wArch.c_str(), bitness, fullpath.c_str());
 #endif
@@ -127,6 +207,29 @@ void InitializeConfiguration()
                 Log(L"DynamicLibraryFixup ForcePackageDllUse=false");
 #endif
             }
+
+            if (auto scanValue = rootObject.try_get("scanPackage"))
+            {
+                g_dynf_scanpackage = scanValue->as_boolean().get();
+            }
+            if (g_dynf_scanpackage)
+            {
+                try
+                {
+                    // A package registered from a development folder can change under us, so it is scanned each time
+                    std::filesystem::path cacheFilePath;
+                    if (!psf::is_development_package(::PSFQueryPackageFullName()))
+                    {
+                        cacheFilePath = psf::local_cache_path(::PSFQueryPackageFamilyName(), L"DllIndex.dat");
+                    }
+                    StartPackageDllScan(g_dynf_packageRootPath, cacheFilePath);
+                }
+                catch (...)
+                {
+                    Log(L"DynamicLibraryFixup: unable to scan the package.");
+                    g_dynf_scanpackage = false;
+                }
+            }
         }
     }
 }
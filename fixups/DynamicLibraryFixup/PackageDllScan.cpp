@@ -0,0 +1,376 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) Tim Mangan. All rights reserved
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+
+#include <psf_framework.h>
+#include <psf_logging.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cwctype>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <folder_queue.h>
+#include <pe_image_architecture.h>
+#include <psf_cache_files.h>
+
+#include "PackageDllScan.h"
+
+#if _DEBUG
+//#define MOREDEBUG 1
+#endif
+
+using namespace std::literals;
+
+namespace
+{
+    // The first line of the cache file; the second is the package full name the index was built for, and the third the
+    // write time of the package root folder when it was scanned
+    constexpr auto cacheSignature = L"PSF DynamicLibraryFixup dll index 3"sv;
+    constexpr std::uint64_t maxCacheSize = 64 * 1024 * 1024;
+
+    struct scanned_dll
+    {
+        std::wstring relativePath;
+        dllBitness architecture;
+    };
+
+    struct scanned_dll_index
+    {
+        std::vector<dll_location_spec> specs;
+        std::unordered_map<std::wstring, size_t> byName;
+    };
+
+    // Set once, when the cache has been read or the scan thread is done, and never replaced
+    std::unique_ptr<scanned_dll_index> g_scannedIndexOwner;
+    std::atomic<const scanned_dll_index*> g_scannedIndex = nullptr;
+
+    std::wstring LowerName(std::wstring_view name)
+    {
+        std::wstring result(name);
+        std::transform(result.begin(), result.end(), result.begin(), [](wchar_t ch) { return static_cast<wchar_t>(std::towlower(ch)); });
+        return result;
+    }
+
+    bool HasDllExtension(std::wstring_view name)
+    {
+        constexpr auto dllExtension = L".dll"sv;
+        return (name.length() > dllExtension.length()) &&
+            (LowerName(name.substr(name.length() - dllExtension.length())) == dllExtension);
+    }
+
+    std::optional<dllBitness> ReadDllArchitecture(const std::filesystem::path& path)
+    {
+        HANDLE file = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return std::nullopt;
+        }
+
+        // The headers practically always fit in the first page; only managed dlls need another read, for the CLR header
+        auto architecture = psf::read_pe_architecture([file](std::uint64_t offset, void* buffer, std::size_t count) -> std::size_t
+        {
+            OVERLAPPED position = {};
+            position.Offset = static_cast<DWORD>(offset);
+            position.OffsetHigh = static_cast<DWORD>(offset >> 32);
+            DWORD bytesRead = 0;
+            if ((count > MAXDWORD) || !::ReadFile(file, buffer, static_cast<DWORD>(count), &bytesRead, &position))
+            {
+                return 0;
+            }
+            return bytesRead;
+        });
+        ::CloseHandle(file);
+
+        switch (architecture)
+        {
+        case psf::pe_architecture::x86:
+            return x86;
+        case psf::pe_architecture::x64:
+            return x64;
+        case psf::pe_architecture::any_cpu:
+            return AnyCPU;
+        default:
+            // Not a dll that could be loaded on this OS
+            return std::nullopt;
+        }
+    }
+
+    void ScanFolders(const std::filesystem::path& root, psf::folder_queue& queue, std::vector<scanned_dll>& found)
+    {
+        std::wstring folder;
+        std::vector<std::wstring> subFolders;
+        while (queue.pop(folder))
+        {
+            try
+            {
+                auto searchPath = (folder.empty() ? root : root / folder) / L"*";
+                WIN32_FIND_DATAW findData;
+                HANDLE findHandle = ::FindFirstFileExW(searchPath.c_str(), FindExInfoBasic, &findData, FindExSearchNameMatch,
+                    nullptr, FIND_FIRST_EX_LARGE_FETCH);
+                if (findHandle != INVALID_HANDLE_VALUE)
+                {
+                    do
+                    {
+                        std::wstring_view name = findData.cFileName;
+                        if ((name == L"."sv) || (name == L".."sv))
+                        {
+                            continue;
+                        }
+
+                        auto relativePath = folder.empty() ? std::wstring(name) : folder + L"\\" + std::wstring(name);
+                        if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+                        {
+                            // Junctions could lead out of the package, or round in circles
+                            if ((findData.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) == 0)
+                            {
+                                subFolders.push_back(std::move(relativePath));
+                            }
+                        }
+                        else if (HasDllExtension(name))
+                        {
+                            if (auto architecture = ReadDllArchitecture(root / relativePath))
+                            {
+                                found.push_back(scanned_dll{ std::move(relativePath), *architecture });
+                            }
+                        }
+                    } while (::FindNextFileW(findHandle, &findData));
+                    ::FindClose(findHandle);
+                }
+            }
+            catch (...)
+            {
+                Log(L"DynamicLibraryFixup: package scan failed to list %ls", folder.c_str());
+            }
+            queue.finish(subFolders);
+        }
+    }
+
+    std::vector<scanned_dll> ScanPackage(const std::filesystem::path& root)
+    {
+        auto threadCount = std::clamp(std::thread::hardware_concurrency(), 1u, 8u);
+        psf::folder_queue queue;
+        std::vector<std::vector<scanned_dll>> found(threadCount);
+        std::vector<std::thread> threads;
+        for (unsigned i = 1; i < threadCount; ++i)
+        {
+            try
+            {
+                threads.emplace_back(ScanFolders, std::cref(root), std::ref(queue), std::ref(found[i]));
+            }
+            catch (...)
+            {
+                // Fewer threads just means a slower scan
+                break;
+            }
+        }
+        ScanFolders(root, queue, found[0]);
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        std::vector<scanned_dll> result;
+        for (auto& threadFound : found)
+        {
+            std::move(threadFound.begin(), threadFound.end(), std::back_inserter(result));
+        }
+
+        // The threads finish in no particular order. When several dlls have the same name, the one nearest the package
+        // root wins, so sort by depth first.
+        std::sort(result.begin(), result.end(), [](const scanned_dll& lhs, const scanned_dll& rhs)
+        {
+            auto lhsDepth = std::count(lhs.relativePath.begin(), lhs.relativePath.end(), L'\\');
+            auto rhsDepth = std::count(rhs.relativePath.begin(), rhs.relativePath.end(), L'\\');
+            if (lhsDepth != rhsDepth)
+            {
+                return lhsDepth < rhsDepth;
+            }
+            return LowerName(lhs.relativePath) < LowerName(rhs.relativePath);
+        });
+        return result;
+    }
+
+    std::optional<std::vector<scanned_dll>> ReadCache(const std::filesystem::path& cacheFilePath, std::wstring_view packageFullName,
+        std::uint64_t rootWriteTime)
+    {
+        auto file = psf::map_cache_file(cacheFilePath, cacheSignature.length() * sizeof(wchar_t), maxCacheSize);
+        if (!file)
+        {
+            return std::nullopt;
+        }
+        std::wstring_view text(reinterpret_cast<const wchar_t*>(file.data()), file.size() / sizeof(wchar_t));
+
+        std::vector<scanned_dll> result;
+        size_t lineNumber = 0;
+        for (size_t start = 0; start < text.size(); ++lineNumber)
+        {
+            auto end = text.find(L'\n', start);
+            if (end == std::wstring_view::npos)
+            {
+                return std::nullopt;
+            }
+            std::wstring_view line(text.data() + start, end - start);
+            start = end + 1;
+
+            if (lineNumber == 0)
+            {
+                if (line != cacheSignature)
+                {
+                    return std::nullopt;
+                }
+            }
+            else if (lineNumber == 1)
+            {
+                if (line != packageFullName)
+                {
+#if _DEBUG
+                    Log(L"DynamicLibraryFixup: dll index cache is for another package version.");
+#endif
+                    return std::nullopt;
+                }
+            }
+            else if (lineNumber == 2)
+            {
+                if (line != std::to_wstring(rootWriteTime))
+                {
+#if _DEBUG
+                    Log(L"DynamicLibraryFixup: the package has changed since the dll index cache was written.");
+#endif
+                    return std::nullopt;
+                }
+            }
+            else
+            {
+                // <architecture>\t<path relative to the package root>. The file is in a folder that the package can
+                // write to, so a path that could lead out of the package root means it was not written by us.
+                if ((line.length() < 3) || (line[0] < L'0') || (line[0] > L'0' + NotSpecified) || (line[1] != L'\t') ||
+                    !psf::is_package_relative_path(line.substr(2)))
+                {
+                    return std::nullopt;
+                }
+                result.push_back(scanned_dll{ std::wstring(line.substr(2)), static_cast<dllBitness>(line[0] - L'0') });
+            }
+        }
+        if (lineNumber < 3)
+        {
+            return std::nullopt;
+        }
+        return result;
+    }
+
+    void WriteCache(const std::filesystem::path& cacheFilePath, std::wstring_view packageFullName, std::uint64_t rootWriteTime,
+        const std::vector<scanned_dll>& dlls)
+    {
+        std::wstring text;
+        text.append(cacheSignature).append(L"\n");
+        text.append(packageFullName).append(L"\n");
+        text.append(std::to_wstring(rootWriteTime)).append(L"\n");
+        for (auto& dll : dlls)
+        {
+            text.push_back(static_cast<wchar_t>(L'0' + dll.architecture));
+            text.append(L"\t").append(dll.relativePath).append(L"\n");
+        }
+
+        if (!psf::write_file_atomically(cacheFilePath, { { text.data(), text.size() * sizeof(wchar_t) } }))
+        {
+            Log(L"DynamicLibraryFixup: unable to write the dll index to %ls", cacheFilePath.c_str());
+        }
+    }
+
+    void PublishIndex(const std::filesystem::path& root, const std::vector<scanned_dll>& dlls)
+    {
+        auto index = std::make_unique<scanned_dll_index>();
+        for (auto& dll : dlls)
+        {
+            if (!IsUsableArchitecture(dll.architecture))
+            {
+                continue;
+            }
+
+            auto& spec = index->specs.emplace_back();
+            spec.full_filepath = root / dll.relativePath;
+            spec.filename = spec.full_filepath.filename().native();
+            spec.architecture = dll.architecture;
+
+            auto name = LowerName(spec.filename);
+            index->byName.emplace(name, index->specs.size() - 1);
+            index->byName.emplace(name.substr(0, name.length() - 4), index->specs.size() - 1);
+        }
+#if _DEBUG
+        Log(L"DynamicLibraryFixup: %d of %d dlls found in the package are usable by this process.",
+            static_cast<int>(index->specs.size()), static_cast<int>(dlls.size()));
+#endif
+        g_scannedIndexOwner = std::move(index);
+        g_scannedIndex.store(g_scannedIndexOwner.get(), std::memory_order_release);
+    }
+}
+
+void StartPackageDllScan(const std::filesystem::path& packageRootPath, const std::filesystem::path& cacheFilePath)
+{
+    std::wstring packageFullName = ::PSFQueryPackageFullName();
+    auto rootWriteTime = psf::folder_write_time(packageRootPath);
+    if (!cacheFilePath.empty())
+    {
+        if (auto cached = ReadCache(cacheFilePath, packageFullName, rootWriteTime))
+        {
+#if _DEBUG
+            Log(L"DynamicLibraryFixup: %d package dlls read from %ls", static_cast<int>(cached->size()), cacheFilePath.c_str());
+#endif
+            PublishIndex(packageRootPath, *cached);
+            return;
+        }
+    }
+
+    // We are under the loader lock, so the scan has to happen on a thread that we don't wait for
+    std::thread([packageRootPath, cacheFilePath, packageFullName, rootWriteTime]()
+    {
+        try
+        {
+#if _DEBUG
+            auto start = ::GetTickCount64();
+#endif
+            auto dlls = ScanPackage(packageRootPath);
+#if _DEBUG
+            Log(L"DynamicLibraryFixup: package scan found %d dlls in %d ms", static_cast<int>(dlls.size()),
+                static_cast<int>(::GetTickCount64() - start));
+#endif
+            if (!cacheFilePath.empty())
+            {
+                WriteCache(cacheFilePath, packageFullName, rootWriteTime, dlls);
+            }
+            PublishIndex(packageRootPath, dlls);
+        }
+        catch (...)
+        {
+            Log(L"DynamicLibraryFixup: package scan failed.");
+        }
+    }).detach();
+}
+
+const dll_location_spec* FindScannedDllSpec(const std::wstring& lowerName)
+{
+    // Before the scan thread is done, the dll is left to the normal search rather than walking the package here, on
+    // what may be the loader lock
+    auto index = g_scannedIndex.load(std::memory_order_acquire);
+    if (!index)
+    {
+#if _DEBUG
+        Log(L"DynamicLibraryFixup: %ls was asked for before the package scan is done; not redirected.", lowerName.c_str());
+#endif
+        return nullptr;
+    }
+    if (auto found = index->byName.find(lowerName); found != index->byName.end())
+    {
+        return &index->specs[found->second];
+    }
+    return nullptr;
+}
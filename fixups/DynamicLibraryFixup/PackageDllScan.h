@@ -0,0 +1,24 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) Tim Mangan. All rights reserved
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+
+// The dlls found by scanning the package (the `scanPackage` option), as a second source of specs behind the ones
+// listed in relativeDllPaths.
+//
+// InitializeConfiguration runs under the loader lock, so it can't wait for other threads. StartPackageDllScan
+// therefore only reads the cached index, if there is one for this package full name and package root write time;
+// otherwise it starts a thread that scans the package root in parallel, writes the cache and then makes the result
+// visible. A lookup that comes before that thread is done finds nothing, and the dll is left to the normal search.
+// An empty cacheFilePath (for a package registered from a development folder) means the package is always scanned.
+#pragma once
+
+#include <filesystem>
+#include <string>
+
+#include "dll_location_spec.h"
+
+void StartPackageDllScan(const std::filesystem::path& packageRootPath, const std::filesystem::path& cacheFilePath);
+
+// Takes the lower-cased requested name; returns nullptr if it is not in the package
+const dll_location_spec* FindScannedDllSpec(const std::wstring& lowerName);
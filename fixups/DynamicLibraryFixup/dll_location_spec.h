@@ -15,6 +15,13 @@ typedef enum dllBitness
 struct dll_location_spec
 {
     std::filesystem::path full_filepath;
-    std::wstring_view filename;
+    std::wstring filename;
     dllBitness architecture;
-};
\ No newline at end of file
+};
+
+// Whether a dll of the given architecture may be loaded into this process
+bool IsUsableArchitecture(dllBitness architecture);
+
+// Returns the spec to use for the requested dll name (compared without regard to case, with or without ".dll"), or
+// nullptr. Specs for another architecture than the current process are never returned.
+const dll_location_spec* FindDllSpec(const std::wstring& requested);
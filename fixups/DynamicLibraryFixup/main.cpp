@@ -22,6 +22,7 @@ extern "C" {
             Log(L"Attaching DynamicLibraryFixup");
 #endif
 
+            psf::timeline_span span("DynamicLibraryFixup attach");
             InitializeFixups();
             InitializeConfiguration();
         }
@@ -4,18 +4,37 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 //-------------------------------------------------------------------------------------------------------
 
+#include <memory>
 #include <regex>
 #include <psf_framework.h>
 #include <psf_logging.h>
 #include "FunctionImplementations.h"
 #include "EnvVar_spec.h"
+#include "EnvironmentSnapshot.h"
 
 
 extern std::vector<env_var_spec> g_envvar_envVarSpecs;
+extern std::unique_ptr<environment_snapshot> g_envvar_registrySnapshot;
 
 DWORD g_EnvVarInterceptInstance = 40000;
 
 
+// Copies a value out with GetEnvironmentVariable semantics: the length without the terminator on success, or the
+// buffer size needed (including the terminator) when lenBuf is too small.
+template <typename CharT>
+DWORD CopyEnvironmentValue(const std::basic_string<CharT>& value, CharT* lpValue, DWORD lenBuf)
+{
+    if (value.length() < lenBuf)
+    {
+        value.copy(lpValue, value.length(), 0);
+        lpValue[value.length()] = 0;
+        SetLastError(ERROR_SUCCESS);
+        return static_cast<DWORD>(value.length());
+    }
+    return static_cast<DWORD>(value.length() + 1);
+}
+
+
 //ExpandEnvironmentStrings
 //  [DllImport("kernel32.dll", SetLastError = true, CharSet = CharSet.Auto)]
 //  public static extern int ExpandEnvironmentStrings([MarshalAs(UnmanagedType.LPTStr)] String source, [Out] StringBuilder destination, int size);
@@ -52,18 +71,36 @@ DWORD __stdcall GetEnvironmentVariableFixup(_In_ const CharC* lpName, _Inout_ Ch
             eName =lpName;
         }
 
-        for (env_var_spec spec : g_envvar_envVarSpecs)
+        if (auto spec = FindEnvVarSpec(eName, GetEnvVarInstance); spec != nullptr)
         {
             try
             {
-                if (std::regex_match(eName, spec.variablename))
+                size_t valuelen = spec->variablevalue.length();
+                if (spec->useregistry == true)
                 {
-                    size_t valuelen = spec.variablevalue.length();
-                    if (spec.useregistry == true)
+#if _DEBUG
+                    Log(L"[%d] GetEnvironmentVariableFixup: Registry supplied case.", GetEnvVarInstance);
+#endif
+                    if (g_envvar_registrySnapshot)
                     {
+                        std::wstring registryValue;
+                        if (g_envvar_registrySnapshot->lookup(eName, registryValue))
+                        {
 #if _DEBUG
-                        Log(L"[%d] GetEnvironmentVariableFixup: Registry supplied case.", GetEnvVarInstance);
+                            LogString(GetEnvVarInstance, L"GetEnvironmentVariableFixup: registry snapshot value is ", registryValue.c_str());
 #endif
+                            if constexpr (psf::is_ansi<CharT>)
+                            {
+                                return CopyEnvironmentValue(narrow(registryValue), lpValue, lenBuf);
+                            }
+                            else
+                            {
+                                return CopyEnvironmentValue(registryValue, lpValue, lenBuf);
+                            }
+                        }
+                    }
+                    else
+                    {
                         // Check app registry for an answer instead of the Json. Note: this allows value to be modified possibly also.
                         HKEY hKeyCU;
                         if constexpr (psf::is_ansi<CharT>)
@@ -189,81 +226,81 @@ DWORD __stdcall GetEnvironmentVariableFixup(_In_ const CharC* lpName, _Inout_ Ch
                                 RegCloseKey(hKeyLM);
                             }
                         }
-                        // allow to fall through to system
-                        //return result;
-                        result = 0;
                     }
+                    // allow to fall through to system
+                    //return result;
+                    result = 0;
+                }
 
-                    // Sometimes HKLM\System reg items from the package are not visible to the app.  We think this is a bug, so
-                    // allow a check to see if there is a value field in the JSON and use that.
-                    // Of course, we should always look at the json if useregistry was set to false anyway.
+                // Sometimes HKLM\System reg items from the package are not visible to the app.  We think this is a bug, so
+                // allow a check to see if there is a value field in the JSON and use that.
+                // Of course, we should always look at the json if useregistry was set to false anyway.
 
 #if _DEBUG
-                    Log(L"[%d] GetEnvironmentVariableFixup: Json supplied case.", GetEnvVarInstance);
+                Log(L"[%d] GetEnvironmentVariableFixup: Json supplied case.", GetEnvVarInstance);
 #endif
 
-                    if (valuelen <= lenBuf)
-                    {
+                if (valuelen <= lenBuf)
+                {
 #if _DEBUG
-                        Log(L"[%d] GetEnvironmentVariableFixup: Match to be returned.", GetEnvVarInstance);
+                    Log(L"[%d] GetEnvironmentVariableFixup: Match to be returned.", GetEnvVarInstance);
 #endif
-                        // copy into lpValue, but might need form conversion
-                        if constexpr (psf::is_ansi<CharT>)
-                        {
+                    // copy into lpValue, but might need form conversion
+                    if constexpr (psf::is_ansi<CharT>)
+                    {
 
-                            std::string sval = narrow(spec.variablevalue);
+                        std::string sval = narrow(spec->variablevalue);
 #if _DEBUG
-                            LogString(GetEnvVarInstance, L"GetEnvironmentVariableFixup:(A) HKCU value is ", sval.c_str());
+                        LogString(GetEnvVarInstance, L"GetEnvironmentVariableFixup:(A) HKCU value is ", sval.c_str());
 #endif
-                            ZeroMemory(lpValue, lenBuf);
-                            sval.copy(lpValue, lenBuf, 0);
-                            //strcpy_s(lpValue, lenBuf, sval.c_str());
+                        ZeroMemory(lpValue, lenBuf);
+                        sval.copy(lpValue, lenBuf, 0);
+                        //strcpy_s(lpValue, lenBuf, sval.c_str());
 #if _DEBUG
-                            LogString(GetEnvVarInstance, L"GetEnvironmentVariableFixup:(A) HKCU value copied is ", lpValue);
+                        LogString(GetEnvVarInstance, L"GetEnvironmentVariableFixup:(A) HKCU value copied is ", lpValue);
 #endif
-                            result = (DWORD)sval.length();
-                        }
-                        else
-                        {
+                        result = (DWORD)sval.length();
+                    }
+                    else
+                    {
 #if _DEBUG
-                            LogString(GetEnvVarInstance, L"GetEnvironmentVariableFixup:(W) HKCU value is ", spec.variablevalue.data());
+                        LogString(GetEnvVarInstance, L"GetEnvironmentVariableFixup:(W) HKCU value is ", spec->variablevalue.data());
 #endif
-                            ZeroMemory(lpValue, lenBuf);
-                            spec.variablevalue.copy(lpValue, lenBuf, 0);
+                        ZeroMemory(lpValue, lenBuf);
+                        spec->variablevalue.copy(lpValue, lenBuf, 0);
 #if _DEBUG
-                            LogString(GetEnvVarInstance, L"GetEnvironmentVariableFixup:(W) HKCU value copied is ", lpValue);
+                        LogString(GetEnvVarInstance, L"GetEnvironmentVariableFixup:(W) HKCU value copied is ", lpValue);
 #endif
-                            result = (DWORD)valuelen;
-                        }
+                        result = (DWORD)valuelen;
+                    }
 #if _DEBUG
-                        Log(L"GetEnvironmentVariableFixup: Value saved.");
+                    Log(L"GetEnvironmentVariableFixup: Value saved.");
 #endif
-                        SetLastError(ERROR_SUCCESS);
-                        return(result);
+                    SetLastError(ERROR_SUCCESS);
+                    return(result);
+                }
+                else
+                {
+#if _DEBUG
+                    if constexpr (psf::is_ansi<CharT>)
+                    {
+                        Log(L"[%d] GetEnvironmentVariableFixup: (A) Match returns bufferoverflow. Needs 0x%x more than 0x%x.",GetEnvVarInstance,valuelen-lenBuf, lenBuf);
                     }
                     else
                     {
-#if _DEBUG
-                        if constexpr (psf::is_ansi<CharT>)
-                        {
-                            Log(L"[%d] GetEnvironmentVariableFixup: (A) Match returns bufferoverflow. Needs 0x%x more than 0x%x.",GetEnvVarInstance,valuelen-lenBuf, lenBuf);
-                        }
-                        else
-                        {
-                            Log(L"[%d] GetEnvironmentVariableFixup: (W) Match returns bufferoverflow. Needs 0x%x more than 0x%x.", GetEnvVarInstance, valuelen - lenBuf, lenBuf);
-                        }
-#endif
-                        // return buffer overflow
-                        result = ERROR_BUFFER_OVERFLOW;
-                        SetLastError(ERROR_BUFFER_OVERFLOW);
-                        return(result);
+                        Log(L"[%d] GetEnvironmentVariableFixup: (W) Match returns bufferoverflow. Needs 0x%x more than 0x%x.", GetEnvVarInstance, valuelen - lenBuf, lenBuf);
                     }
-
+#endif
+                    // return buffer overflow
+                    result = ERROR_BUFFER_OVERFLOW;
+                    SetLastError(ERROR_BUFFER_OVERFLOW);
+                    return(result);
                 }
+
             }
             catch (...)
             {
-                Log(L"[%d] Bad Regex pattern ignored in EnvVarFixup.\n", GetEnvVarInstance);
+                Log(L"[%d] EnvVarFixup: exception while handling the variable.\n", GetEnvVarInstance);
             }
         }
 
@@ -309,82 +346,110 @@ BOOL __stdcall SetEnvironmentVariableFixup(_In_ const CharT* lpName, _In_ const
         {
             eName = lpName;
         }
-        for (env_var_spec spec : g_envvar_envVarSpecs)
+        if (auto spec = FindEnvVarSpec(eName, SetEnvVarInstance); spec != nullptr)
         {
             try
             {
-                if (std::regex_match(eName, spec.variablename))
+                if (spec->useregistry == true)
                 {
-                    if (spec.useregistry == true)
-                    {
 #if _DEBUG
-                        Log(L"[%d] GetEnvironmentVariableFixup: registry case.", SetEnvVarInstance);
+                    Log(L"[%d] GetEnvironmentVariableFixup: registry case.", SetEnvVarInstance);
 #endif
-                        HKEY hKeyCU;
+                    if (g_envvar_registrySnapshot)
+                    {
+                        // Written through the snapshot, which reads the keys again on the next lookup; the ANSI strings
+                        // are converted with the ANSI code page, as RegSetValueExA does. If the key cannot be opened
+                        // this is left to the code below, which then falls through to the original call as before.
+                        std::optional<LSTATUS> ret;
                         if constexpr (psf::is_ansi<CharT>)
                         {
-                            if (RegOpenKeyExA(HKEY_CURRENT_USER, "Environment", 0, MAXIMUM_ALLOWED, &hKeyCU) == ERROR_SUCCESS)
+                            ret = g_envvar_registrySnapshot->set(widen(lpName, CP_ACP), widen(lpValue, CP_ACP));
+                        }
+                        else
+                        {
+                            ret = g_envvar_registrySnapshot->set(lpName, lpValue);
+                        }
+                        if (ret)
+                        {
+#if _DEBUG
+                            Log(L"[%d] SetEnvironmentVariableFixup: written through the snapshot, status 0x%x.", SetEnvVarInstance, *ret);
+#endif
+                            result = (*ret == ERROR_SUCCESS) ? 1 : 0;
+                            return result;
+                        }
+                    }
+                    HKEY hKeyCU;
+                    if constexpr (psf::is_ansi<CharT>)
+                    {
+                        if (RegOpenKeyExA(HKEY_CURRENT_USER, "Environment", 0, MAXIMUM_ALLOWED, &hKeyCU) == ERROR_SUCCESS)
+                        {
+                            DWORD dLen = (DWORD)((strlen(lpValue) + 1) * sizeof(CharT));
+                            auto ret = RegSetValueExA(hKeyCU, lpName, NULL, REG_SZ, (BYTE*)lpValue, dLen);
+                            if (ret == ERROR_SUCCESS)
                             {
-                                DWORD dLen = (DWORD)((strlen(lpValue) + 1) * sizeof(CharT));
-                                auto ret = RegSetValueExA(hKeyCU, lpName, NULL, REG_SZ, (BYTE*)lpValue, dLen);
-                                if (ret == ERROR_SUCCESS)
-                                {
 #if _DEBUG
-                                    Log(L"[%d] SetEnvironmentVariableFixup: success. %s=%s", SetEnvVarInstance, lpName, lpValue);
+                                Log(L"[%d] SetEnvironmentVariableFixup: success. %s=%s", SetEnvVarInstance, lpName, lpValue);
 #endif
-                                    result = 1;
-                                    return result;
-                                }
-                                else
+                                if (g_envvar_registrySnapshot)
                                 {
+                                    g_envvar_registrySnapshot->invalidate();
+                                }
+                                result = 1;
+                                return result;
+                            }
+                            else
+                            {
 #if _DEBUG
-                                    Log(L"[%d] SetEnvironmentVariableFixup: Failure 0x%x.", SetEnvVarInstance, GetLastError());
+                                Log(L"[%d] SetEnvironmentVariableFixup: Failure 0x%x.", SetEnvVarInstance, GetLastError());
 #endif
-                                    result = 0;
-                                    return result;
-                                }
+                                result = 0;
+                                return result;
                             }
                         }
-                        else
+                    }
+                    else
+                    {
+                        if (RegOpenKeyExW(HKEY_CURRENT_USER, L"Environment", 0, MAXIMUM_ALLOWED, &hKeyCU) == ERROR_SUCCESS)
                         {
-                            if (RegOpenKeyExW(HKEY_CURRENT_USER, L"Environment", 0, MAXIMUM_ALLOWED, &hKeyCU) == ERROR_SUCCESS)
+                            DWORD dLen = (DWORD)((wcslen(lpValue) + 1) * sizeof(CharT));
+                            auto ret = RegSetValueExW(hKeyCU, lpName, NULL, REG_SZ, (BYTE*)lpValue, dLen);
+                            if (ret == ERROR_SUCCESS)
                             {
-                                DWORD dLen = (DWORD)((wcslen(lpValue) + 1) * sizeof(CharT));
-                                auto ret = RegSetValueExW(hKeyCU, lpName, NULL, REG_SZ, (BYTE*)lpValue, dLen);
-                                if (ret == ERROR_SUCCESS)
-                                {
 #if _DEBUG
-                                    Log(L"[%d] SetEnvironmentVariableFixup: success. %ls=%ls", SetEnvVarInstance, lpName, lpValue);
+                                Log(L"[%d] SetEnvironmentVariableFixup: success. %ls=%ls", SetEnvVarInstance, lpName, lpValue);
 #endif
-                                    result = 1;
-                                    return result;
-                                }
-                                else
+                                if (g_envvar_registrySnapshot)
                                 {
+                                    g_envvar_registrySnapshot->invalidate();
+                                }
+                                result = 1;
+                                return result;
+                            }
+                            else
+                            {
 #if _DEBUG
-                                    Log(L"[%d] SetEnvironmentVariableFixup: Failure 0x%x.", SetEnvVarInstance, GetLastError());
+                                Log(L"[%d] SetEnvironmentVariableFixup: Failure 0x%x.", SetEnvVarInstance, GetLastError());
 #endif
-                                    result = 0;
-                                    return result;
-                                }
+                                result = 0;
+                                return result;
                             }
                         }
                     }
-                    else
-                    {
+                }
+                else
+                {
 #if _DEBUG
-                        Log(L"[%d] GetEnvironmentVariableFixup: JSON case - return ACCESS_DENIED.", SetEnvVarInstance);
+                    Log(L"[%d] GetEnvironmentVariableFixup: JSON case - return ACCESS_DENIED.", SetEnvVarInstance);
 #endif
-                        // Unable to overwrite json, return ACCESS_DENIED
-                        SetLastError(ERROR_ACCESS_DENIED);
-                        result = 0;
-                        return result;
-                    }
+                    // Unable to overwrite json, return ACCESS_DENIED
+                    SetLastError(ERROR_ACCESS_DENIED);
+                    result = 0;
+                    return result;
                 }
             }
             catch (...)
             {
-                Log(L"[%d] Bad Regex pattern ignored in EnvVarFixup.\n", SetEnvVarInstance);
+                Log(L"[%d] EnvVarFixup: exception while handling the variable.\n", SetEnvVarInstance);
             }
         }
     }
@@ -10,4 +10,8 @@ struct env_var_spec
     std::wregex variablename;
     std::wstring_view variablevalue;
     bool useregistry;
-};
\ No newline at end of file
+};
+
+// Returns the first spec (in config order) whose name pattern matches the variable, or nullptr. Names without any regex
+// syntax, which is nearly all of them, are looked up in a hash table; only the real patterns are run.
+const env_var_spec* FindEnvVarSpec(const std::wstring& name, DWORD instance);
@@ -0,0 +1,163 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) Tim Mangan. All rights reserved
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+
+// The registry keys behind environment_snapshot, which RegNotifyChangeKeyValue watches for changes.
+
+#include <psf_framework.h>
+#include <psf_logging.h>
+
+#include <vector>
+
+#include "EnvironmentSnapshot.h"
+
+
+namespace
+{
+    std::wstring ExpandValue(const std::wstring& value)
+    {
+        auto size = ::ExpandEnvironmentStringsW(value.c_str(), nullptr, 0);
+        if (size == 0)
+        {
+            return value;
+        }
+        std::wstring expanded(size, L'\0');
+        size = ::ExpandEnvironmentStringsW(value.c_str(), expanded.data(), size);
+        if (size == 0)
+        {
+            return value;
+        }
+        expanded.resize(size - 1);
+        return expanded;
+    }
+
+    class registry_environment_source : public environment_source
+    {
+    public:
+        registry_environment_source(HKEY root, const wchar_t* path) noexcept :
+            m_root(root),
+            m_path(path)
+        {
+        }
+
+        registry_environment_source(const registry_environment_source&) = delete;
+        registry_environment_source& operator=(const registry_environment_source&) = delete;
+
+        ~registry_environment_source()
+        {
+            if (m_changed)
+            {
+                ::CloseHandle(m_changed);
+            }
+            if (m_key)
+            {
+                ::RegCloseKey(m_key);
+            }
+        }
+
+        std::vector<std::pair<std::wstring, std::wstring>> read() override
+        {
+            std::vector<std::pair<std::wstring, std::wstring>> values;
+            if (!m_key)
+            {
+                if (::RegOpenKeyExW(m_root, m_path, 0, KEY_READ, &m_key) != ERROR_SUCCESS)
+                {
+                    m_key = nullptr;
+                    return values;
+                }
+            }
+
+            // Ask to be told about the next change before reading, so that none can slip in between
+            if (!m_changed)
+            {
+                m_changed = ::CreateEventW(nullptr, TRUE, FALSE, nullptr);
+            }
+            if (m_changed)
+            {
+                ::ResetEvent(m_changed);
+                if (::RegNotifyChangeKeyValue(m_key, FALSE, REG_NOTIFY_CHANGE_LAST_SET | REG_NOTIFY_THREAD_AGNOSTIC, m_changed, TRUE) != ERROR_SUCCESS)
+                {
+                    ::CloseHandle(m_changed);
+                    m_changed = nullptr;
+                }
+            }
+
+            DWORD maxNameLength = 0;
+            DWORD maxDataSize = 0;
+            if (::RegQueryInfoKeyW(m_key, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, &maxNameLength, &maxDataSize, nullptr, nullptr) != ERROR_SUCCESS)
+            {
+                return values;
+            }
+
+            std::wstring name(maxNameLength + 1, L'\0');
+            std::vector<wchar_t> data(maxDataSize / sizeof(wchar_t) + 1);
+            for (DWORD index = 0; ; ++index)
+            {
+                DWORD nameLength = static_cast<DWORD>(name.size());
+                DWORD type = 0;
+                DWORD dataSize = static_cast<DWORD>(data.size() * sizeof(wchar_t));
+                auto result = ::RegEnumValueW(m_key, index, name.data(), &nameLength, nullptr, &type, reinterpret_cast<BYTE*>(data.data()), &dataSize);
+                if (result == ERROR_MORE_DATA)
+                {
+                    // A value grew since RegQueryInfoKey; the change notification will bring it in on the next read
+                    continue;
+                }
+                else if (result != ERROR_SUCCESS)
+                {
+                    break;
+                }
+
+                if ((type != REG_SZ) && (type != REG_EXPAND_SZ))
+                {
+                    continue;
+                }
+                std::wstring value(data.data(), dataSize / sizeof(wchar_t));
+                while (!value.empty() && (value.back() == L'\0'))
+                {
+                    value.pop_back();
+                }
+                if (type == REG_EXPAND_SZ)
+                {
+                    value = ExpandValue(value);
+                }
+                values.emplace_back(std::wstring(name.data(), nameLength), std::move(value));
+            }
+#if _DEBUG
+            Log(L"EnvVarFixup: %d values read from %ls", static_cast<int>(values.size()), m_path);
+#endif
+            return values;
+        }
+
+        bool unchanged() noexcept override
+        {
+            return m_changed && (::WaitForSingleObject(m_changed, 0) == WAIT_TIMEOUT);
+        }
+
+        std::optional<LSTATUS> write(const std::wstring& name, const std::wstring& value) override
+        {
+            HKEY key;
+            if (::RegOpenKeyExW(m_root, m_path, 0, MAXIMUM_ALLOWED, &key) != ERROR_SUCCESS)
+            {
+                return std::nullopt;
+            }
+            DWORD dLen = static_cast<DWORD>((value.length() + 1) * sizeof(wchar_t));
+            auto result = ::RegSetValueExW(key, name.c_str(), 0, REG_SZ, reinterpret_cast<const BYTE*>(value.c_str()), dLen);
+            ::RegCloseKey(key);
+            return result;
+        }
+
+    private:
+        HKEY m_root;
+        const wchar_t* m_path;
+        HKEY m_key = nullptr;
+        HANDLE m_changed = nullptr;
+    };
+}
+
+environment_snapshot::environment_snapshot() :
+    environment_snapshot(
+        std::make_unique<registry_environment_source>(HKEY_CURRENT_USER, L"Environment"),
+        std::make_unique<registry_environment_source>(HKEY_LOCAL_MACHINE, L"SYSTEM\\CurrentControlSet\\Control\\Session Manager\\Environment"))
+{
+}
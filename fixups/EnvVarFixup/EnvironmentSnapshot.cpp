@@ -0,0 +1,94 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) Tim Mangan. All rights reserved
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cwctype>
+#include <mutex>
+
+#include "EnvironmentSnapshot.h"
+
+
+namespace
+{
+    std::wstring UpperName(std::wstring name)
+    {
+        std::transform(name.begin(), name.end(), name.begin(), [](wchar_t ch) { return static_cast<wchar_t>(std::towupper(ch)); });
+        return name;
+    }
+}
+
+environment_snapshot::environment_snapshot(std::unique_ptr<environment_source> user, std::unique_ptr<environment_source> machine)
+{
+    m_user.source = std::move(user);
+    m_machine.source = std::move(machine);
+}
+
+bool environment_snapshot::key_snapshot::is_current() const noexcept
+{
+    // Without a notification there is no telling whether the key has changed, so it is read every time
+    return loaded && source->unchanged();
+}
+
+void environment_snapshot::key_snapshot::load()
+{
+    values.clear();
+    loaded = true;
+    for (auto& [name, value] : source->read())
+    {
+        values.insert_or_assign(UpperName(std::move(name)), std::move(value));
+    }
+}
+
+bool environment_snapshot::lookup(const std::wstring& name, std::wstring& value)
+{
+    auto upperName = UpperName(name);
+    auto find = [&]()
+    {
+        for (auto snapshot : { &m_user, &m_machine })
+        {
+            if (auto found = snapshot->values.find(upperName); found != snapshot->values.end())
+            {
+                value = found->second;
+                return true;
+            }
+        }
+        return false;
+    };
+
+    {
+        std::shared_lock lock(m_mutex);
+        if (m_user.is_current() && m_machine.is_current())
+        {
+            return find();
+        }
+    }
+
+    std::unique_lock lock(m_mutex);
+    for (auto snapshot : { &m_user, &m_machine })
+    {
+        if (!snapshot->is_current())
+        {
+            snapshot->load();
+        }
+    }
+    return find();
+}
+
+std::optional<LSTATUS> environment_snapshot::set(const std::wstring& name, const std::wstring& value)
+{
+    auto result = m_user.source->write(name, value);
+    if (result == ERROR_SUCCESS)
+    {
+        invalidate();
+    }
+    return result;
+}
+
+void environment_snapshot::invalidate() noexcept
+{
+    std::unique_lock lock(m_mutex);
+    m_user.loaded = false;
+    m_machine.loaded = false;
+}
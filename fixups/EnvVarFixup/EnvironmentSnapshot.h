@@ -0,0 +1,73 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) Tim Mangan. All rights reserved
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+
+// An in-memory copy of the HKCU\Environment and HKLM\...\Session Manager\Environment values, used for the `useregistry`
+// variables when the config asks for `registrySnapshot`. Each key is read (as the app sees it) the first time it is
+// needed, and read again after its source reports a change to it or invalidate is called, so lookups normally cost no
+// registry calls at all.
+
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <windows.h>
+
+// Where the snapshot reads one of the keys from, and how it learns that the key has changed. For the registry
+// (EnvironmentRegistrySource.cpp) that is RegNotifyChangeKeyValue; the portable tests supply their own.
+class environment_source
+{
+public:
+    virtual ~environment_source() = default;
+
+    // Returns the REG_SZ and REG_EXPAND_SZ values of the key, the latter expanded as RegGetValue does. Sources that can
+    // report changes start watching for the next one before reading, so that none can slip in between.
+    virtual std::vector<std::pair<std::wstring, std::wstring>> read() = 0;
+
+    // True while the key is known not to have changed since the last read; false if the source cannot tell
+    virtual bool unchanged() noexcept = 0;
+
+    // Sets a REG_SZ value in the key; std::nullopt if the key could not be opened for writing
+    virtual std::optional<LSTATUS> write(const std::wstring& name, const std::wstring& value) = 0;
+};
+
+class environment_snapshot
+{
+public:
+    // Reads the registry
+    environment_snapshot();
+    environment_snapshot(std::unique_ptr<environment_source> user, std::unique_ptr<environment_source> machine);
+    environment_snapshot(const environment_snapshot&) = delete;
+    environment_snapshot& operator=(const environment_snapshot&) = delete;
+
+    // Looks the variable up in HKCU, then HKLM
+    bool lookup(const std::wstring& name, std::wstring& value);
+
+    // Writes a variable to the user's key, as SetEnvironmentVariable does for a `useregistry` variable, and has both
+    // keys read again on the next lookup if that worked. std::nullopt if the key could not be opened.
+    std::optional<LSTATUS> set(const std::wstring& name, const std::wstring& value);
+
+    // Forces both keys to be read again on the next lookup, e.g. after the fixup itself has written to one of them
+    void invalidate() noexcept;
+
+private:
+    struct key_snapshot
+    {
+        std::unique_ptr<environment_source> source;
+        bool loaded = false;
+        std::unordered_map<std::wstring, std::wstring> values;  // by upper-cased name
+
+        bool is_current() const noexcept;
+        void load();
+    };
+
+    std::shared_mutex m_mutex;
+    key_snapshot m_user;
+    key_snapshot m_machine;
+};
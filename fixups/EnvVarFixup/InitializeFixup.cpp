@@ -15,10 +15,13 @@
 #include <utilities.h>
 
 #include <filesystem>
+#include <memory>
+#include <unordered_map>
 
 
 #include "FunctionImplementations.h"
 #include "EnvVar_spec.h"
+#include "EnvironmentSnapshot.h"
 
 using namespace std::literals;
 
@@ -28,6 +31,46 @@ bool                  g_envvar_forcepackagedlluse = false;
 
 
 std::vector<env_var_spec> g_envvar_envVarSpecs;
+std::unique_ptr<environment_snapshot> g_envvar_registrySnapshot;
+
+// The specs whose name is a plain name, by that name, and the specs whose name is a real pattern, in config order
+std::unordered_map<std::wstring, size_t> g_envvar_specsByName;
+std::vector<size_t> g_envvar_patternSpecs;
+
+static bool IsPlainName(std::wstring_view pattern)
+{
+    return pattern.find_first_of(L"\\^$.|?*+()[]{}") == std::wstring_view::npos;
+}
+
+const env_var_spec* FindEnvVarSpec(const std::wstring& name, [[maybe_unused]] DWORD instance)
+{
+    // A pattern that comes earlier in the config than the spec with this exact name still gets the first chance
+    size_t exactIndex = g_envvar_envVarSpecs.size();
+    if (auto exact = g_envvar_specsByName.find(name); exact != g_envvar_specsByName.end())
+    {
+        exactIndex = exact->second;
+    }
+
+    for (auto index : g_envvar_patternSpecs)
+    {
+        if (index > exactIndex)
+        {
+            break;
+        }
+        try
+        {
+            if (std::regex_match(name, g_envvar_envVarSpecs[index].variablename))
+            {
+                return &g_envvar_envVarSpecs[index];
+            }
+        }
+        catch (...)
+        {
+            Log(L"[%d] Bad Regex pattern ignored in EnvVarFixup.\n", instance);
+        }
+    }
+    return (exactIndex < g_envvar_envVarSpecs.size()) ? &g_envvar_envVarSpecs[exactIndex] : nullptr;
+}
 
 void InitializeFixups()
 {
@@ -54,6 +97,8 @@ void InitializeFixups()
 
 void InitializeConfiguration()
 {
+    SetLogLevels(::PSFQueryCurrentDllLogLevel());
+
 #if _DEBUG
     Log(L"EnvVarFixup InitializeConfiguration()");
 #endif
@@ -82,6 +127,14 @@ void InitializeConfiguration()
                     LogString(0, L"GetEnvFixup Config: value", variablevalue.data());
                     LogString(0, L"GetEnvFixup Config: useregistry", useregistry.data());
 #endif
+                    if (IsPlainName(variablenamePattern))
+                    {
+                        g_envvar_specsByName.emplace(variablenamePattern, g_envvar_envVarSpecs.size());
+                    }
+                    else
+                    {
+                        g_envvar_patternSpecs.push_back(g_envvar_envVarSpecs.size());
+                    }
                     g_envvar_envVarSpecs.emplace_back();
                     g_envvar_envVarSpecs.back().variablename.assign(variablenamePattern.data(), variablenamePattern.length());
                     g_envvar_envVarSpecs.back().variablevalue = variablevalue;
@@ -102,6 +155,16 @@ void InitializeConfiguration()
 #endif
             }
         }
+        if (auto snapshotValue = rootObject.try_get("registrySnapshot"))
+        {
+            if (snapshotValue->as_boolean().get())
+            {
+#if _DEBUG
+                Log(L"EnvVarFixup: registry values served from a snapshot.");
+#endif
+                g_envvar_registrySnapshot = std::make_unique<environment_snapshot>();
+            }
+        }
         if (g_envvar_envVarSpecs.size() == 0)
         {
 #if _DEBUG
@@ -12,6 +12,7 @@ template <typename CharT>
 BOOL __stdcall CopyFileFixup(_In_ const CharT* existingFileName, _In_ const CharT* newFileName, _In_ BOOL failIfExists) noexcept
 {
     DWORD CopyFileInstance = ++g_FileIntceptInstance;
+    redirection_change_scope changes(newFileName);
     auto guard = g_reentrancyGuard.enter();
     try
     {
@@ -39,6 +40,7 @@ BOOL __stdcall CopyFileFixup(_In_ const CharT* existingFileName, _In_ const Char
 
             path_redirect_info  priSource = ShouldRedirectV2(existingFileName, redirect_flags::check_file_presence | redirect_flags::ok_if_parent_in_pkg, CopyFileInstance);
             path_redirect_info  priDest = ShouldRedirectV2(newFileName, redirect_flags::ensure_directory_structure | redirect_flags::ok_if_parent_in_pkg, CopyFileInstance);
+            changes.add(priDest.redirect_path.c_str());
             if (priSource.should_redirect )
             {
                 std::wstring rldSourceRedirectPath = TurnPathIntoRootLocalDevice(widen(priSource.redirect_path).c_str());
@@ -125,6 +127,7 @@ BOOL __stdcall CopyFileExFixup(
     _In_ DWORD copyFlags) noexcept
 {
     DWORD CopyFileExInstance = ++g_FileIntceptInstance;
+    redirection_change_scope changes(newFileName);
     auto guard = g_reentrancyGuard.enter();
     try
     {
@@ -138,6 +141,7 @@ BOOL __stdcall CopyFileExFixup(
             // See note in CopyFileFixup for commentary on copy-on-read policy
             path_redirect_info  priSource = ShouldRedirectV2(existingFileName, redirect_flags::check_file_presence | redirect_flags::ok_if_parent_in_pkg, CopyFileExInstance);
             path_redirect_info  priDest = ShouldRedirectV2(newFileName, redirect_flags::ensure_directory_structure | redirect_flags::ok_if_parent_in_pkg, CopyFileExInstance);
+            changes.add(priDest.redirect_path.c_str());
             if (priSource.should_redirect)
             {
                 std::wstring rldSourceRedirectPath = TurnPathIntoRootLocalDevice(widen(priSource.redirect_path).c_str());
@@ -197,6 +201,7 @@ HRESULT __stdcall CopyFile2Fixup(
     _In_opt_ COPYFILE2_EXTENDED_PARAMETERS* extendedParameters) noexcept
 {
     DWORD CopyFile2Instance = ++g_FileIntceptInstance;
+    redirection_change_scope changes(newFileName);
     auto guard = g_reentrancyGuard.enter();
     try
     {
@@ -210,6 +215,7 @@ HRESULT __stdcall CopyFile2Fixup(
             // See note in CopyFileFixup for commentary on copy-on-read policy
             path_redirect_info  priSource = ShouldRedirectV2(existingFileName, redirect_flags::check_file_presence | redirect_flags::ok_if_parent_in_pkg, CopyFile2Instance);
             path_redirect_info  priDest = ShouldRedirectV2(newFileName, redirect_flags::ensure_directory_structure | redirect_flags::ok_if_parent_in_pkg, CopyFile2Instance);
+            changes.add(priDest.redirect_path.c_str());
             if (priSource.should_redirect)
             {
                 return impl::CopyFile2(
@@ -11,6 +11,7 @@ template <typename CharT>
 BOOL __stdcall CreateDirectoryFixup(_In_ const CharT* pathName, _In_opt_ LPSECURITY_ATTRIBUTES securityAttributes) noexcept
 {
     DWORD CreateDirectoryInstance = ++g_FileIntceptInstance;
+    redirection_change_scope changes(pathName);
     auto guard = g_reentrancyGuard.enter();
     
     try
@@ -34,6 +35,7 @@ BOOL __stdcall CreateDirectoryFixup(_In_ const CharT* pathName, _In_opt_ LPSECUR
             if (!IsUnderUserAppDataLocalPackages(wPathName.c_str()))
             { 
                 path_redirect_info  pri = ShouldRedirectV2(wPathName.c_str(), redirect_flags::ensure_directory_structure, CreateDirectoryInstance);
+                changes.add(pri.redirect_path.c_str());
                 //path_redirect_info  pri = ShouldRedirectV2(pathName, redirect_flags::ensure_directory_structure, CreateDirectoryInstance);
                 //path_redirect_info  pri = ShouldRedirectV2(pathName, redirect_flags::none, CreateDirectoryInstance);
                 if (pri.should_redirect)
@@ -96,6 +98,7 @@ BOOL __stdcall CreateDirectoryExFixup(
     _In_opt_ LPSECURITY_ATTRIBUTES securityAttributes) noexcept
 {
     DWORD CreateDirectoryExInstance = ++g_FileIntceptInstance;
+    redirection_change_scope changes(newDirectory);
     auto guard = g_reentrancyGuard.enter();
     try
     {
@@ -128,6 +131,7 @@ BOOL __stdcall CreateDirectoryExFixup(
             
             path_redirect_info  priSource = ShouldRedirectV2(WtemplateDirectory.c_str(), redirect_flags::check_file_presence, CreateDirectoryExInstance);
             path_redirect_info  priDest = ShouldRedirectV2(WnewDirectory.c_str(), redirect_flags::ensure_directory_structure | redirect_flags::ok_if_parent_in_pkg, CreateDirectoryExInstance);
+            changes.add(priDest.redirect_path.c_str());
             if (priSource.should_redirect || priDest.should_redirect)
             {
                 std::wstring rldRedirectTemplate = TurnPathIntoRootLocalDevice(priSource.should_redirect ? priSource.redirect_path.c_str() : WtemplateDirectory.c_str());
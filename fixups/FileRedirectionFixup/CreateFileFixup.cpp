@@ -56,6 +56,7 @@ HANDLE __stdcall CreateFileFixup(
 {
     auto guard = g_reentrancyGuard.enter();
     DWORD CreateFileInstance = ++g_FileIntceptInstance;
+    redirection_change_scope changes;
 #if _DEBUG
     if (fileName != NULL)
     {
@@ -158,6 +159,12 @@ HANDLE __stdcall CreateFileFixup(
                     // FUTURE: If 'creationDisposition' is something like 'CREATE_ALWAYS', we could get away with something
                     //         cheaper than copy-on-read, but we'd also need to be mindful of ensuring the correct error if so
                     path_redirect_info  pri = ShouldRedirectV2(FixedFileName, redirect_flags::copy_on_read, CreateFileInstance);
+                    if ((creationDisposition != OPEN_EXISTING) || ((flagsAndAttributes & FILE_FLAG_DELETE_ON_CLOSE) != 0))
+                    {
+                        // The file may be created or removed; cached decisions about it are dropped once the call completes
+                        changes.add(FixedFileName);
+                        changes.add(pri.redirect_path.c_str());
+                    }
                     if (pri.should_redirect)
                     {
                         std::filesystem::path PackageVersion = GetPackageVFSPath(FixedFileName);
@@ -353,6 +360,7 @@ HANDLE __stdcall CreateFile2Fixup(
 {
     auto guard = g_reentrancyGuard.enter();
     DWORD CreateFile2Instance = ++g_FileIntceptInstance;
+    redirection_change_scope changes;
 #if _DEBUG
     LogString(CreateFile2Instance, L"CreateFile2Fixup for ", fileName);
     Log(L"[%d] DesiredAccess 0x%x  ShareMode 0x%x", CreateFile2Instance, desiredAccess, shareMode);
@@ -382,6 +390,11 @@ HANDLE __stdcall CreateFile2Fixup(
                 // FUTURE: See comment in CreateFileFixup about using 'creationDisposition' to choose a potentially better
                 //         redirect flags value
                 path_redirect_info  pri = ShouldRedirectV2(WFileNameString.c_str(), redirect_flags::copy_on_read, CreateFile2Instance);
+                if ((creationDisposition != OPEN_EXISTING) || ((createExParams != nullptr) && ((createExParams->dwFileFlags & FILE_FLAG_DELETE_ON_CLOSE) != 0)))
+                {
+                    changes.add(WFileNameString.c_str());
+                    changes.add(pri.redirect_path.c_str());
+                }
                 if (pri.should_redirect)
                 {
                     if (IsUnderUserAppDataLocal(WFileNameString.c_str()))
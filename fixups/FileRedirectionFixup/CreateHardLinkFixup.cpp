@@ -14,6 +14,7 @@ BOOL __stdcall CreateHardLinkFixup(
     _Reserved_ LPSECURITY_ATTRIBUTES securityAttributes) noexcept
 {
     DWORD CreateHardLinkInstance = ++g_FileIntceptInstance;
+    redirection_change_scope changes(fileName);
     auto guard = g_reentrancyGuard.enter();
     BOOL retfinal;
     try
@@ -32,6 +33,7 @@ BOOL __stdcall CreateHardLinkFixup(
             //       are trying to create a hard-link with the same path as a file inside the package, they had
             //       previously attempted to delete that file.
             path_redirect_info  priSource = ShouldRedirectV2(fileName, redirect_flags::ensure_directory_structure);
+            changes.add(priSource.redirect_path.c_str());
             path_redirect_info  priTarget = ShouldRedirectV2(existingFileName, redirect_flags::copy_on_read);
             if (priSource.should_redirect || priTarget.should_redirect)
             {
@@ -14,6 +14,7 @@ BOOLEAN __stdcall CreateSymbolicLinkFixup(
     _In_ DWORD flags) noexcept
 {
     DWORD CreateSymbolicLinkInstance = ++g_FileIntceptInstance;
+    redirection_change_scope changes(symlinkFileName);
     auto guard = g_reentrancyGuard.enter();
     try
     {
@@ -24,6 +25,7 @@ BOOLEAN __stdcall CreateSymbolicLinkFixup(
             LogString(CreateSymbolicLinkInstance,L"CreateSymbolicLinkFixup target",  targetFileName);
 #endif
             path_redirect_info  priSource = ShouldRedirectV2(symlinkFileName, redirect_flags::ensure_directory_structure, CreateSymbolicLinkInstance);
+            changes.add(priSource.redirect_path.c_str());
             path_redirect_info  priTarget = ShouldRedirectV2(targetFileName, redirect_flags::copy_on_read, CreateSymbolicLinkInstance);
             if (priSource.should_redirect || priTarget.should_redirect)
             {
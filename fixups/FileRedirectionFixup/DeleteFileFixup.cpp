@@ -11,6 +11,7 @@ template <typename CharT>
 BOOL __stdcall DeleteFileFixup(_In_ const CharT* fileName) noexcept
 {
     DWORD DeleteFileInstance = ++g_FileIntceptInstance;
+    redirection_change_scope changes(fileName);
     auto guard = g_reentrancyGuard.enter();
     try
     {
@@ -30,6 +31,7 @@ BOOL __stdcall DeleteFileFixup(_In_ const CharT* fileName) noexcept
                 //       disruptful and probably fairly inefficient as it would impact virtually every code path, so we'll
                 //       put it off for now.
                 path_redirect_info  pri = ShouldRedirectV2(fileName, redirect_flags::none, DeleteFileInstance);
+                changes.add(pri.redirect_path.c_str());
                 if (pri.should_redirect)
                 {
                     std::wstring rldFileName = TurnPathIntoRootLocalDevice(widen_argument(fileName).c_str());
@@ -25,6 +25,8 @@
 
 #include <dos_paths.h>
 #include <fancy_handle.h>
+#include <file_name_set.h>
+#include <user_locale_fold.h>
 #include <psf_framework.h>
 
 #include "FunctionImplementations.h"
@@ -57,7 +59,7 @@ struct find_data2
     std::wstring requested_path;
     std::wstring package_devfs_path;
     std::wstring package_deredirect_path;
-    std::list<std::wstring> already_returned_list = {};
+    psf::file_name_set<psf::user_locale_fold> already_returned_list;
 
     // There are five different locations where we might find things, stored in the find_handles array and used in the following order:
     //    The first (optional) value is the find handle for the "redirected path" (typically to the user's profile). Set when original is a package path.
@@ -557,7 +559,7 @@ HANDLE __stdcall FindFirstFileExFixupV2(
 #if _DEBUG
         Log(L"[%d] FindFirstFileExFixupV2 returns %ls", InstanceV2, result->cached_data.cFileName);
 #endif
-        result->already_returned_list.push_back(result->cached_data.cFileName);
+        result->already_returned_list.insert(result->cached_data.cFileName);
         ::SetLastError(ERROR_SUCCESS);
     }
     else
@@ -980,7 +982,7 @@ HANDLE __stdcall FindFirstFileFixupV2(_In_ const CharT* fileName, _Out_ win32_fi
 #if _DEBUG
         Log(L"[%d] FindFirstFileFixupV2 returns %ls", InstanceV2, result->cached_data.cFileName);
 #endif
-        result->already_returned_list.push_back(result->cached_data.cFileName);
+        result->already_returned_list.insert(result->cached_data.cFileName);
         ::SetLastError(ERROR_SUCCESS);
     }
     else
@@ -1181,7 +1183,7 @@ BOOL __stdcall FindNextFileFixupV2(_In_ HANDLE findFile, _Out_ win32_find_data_t
         return result;
     };
 #endif
-    auto wasFileAlreadyProvided = [&](std::wstring findrequest, auto filename)
+    auto wasFileAlreadyProvided = [&]([[maybe_unused]] const std::wstring& findrequest, auto filename)
     {
 #if _DEBUG
         LogString(data->RememberedInstance, FindNextFileInstance2, L"\tFindNextFileV2 wasFileAlreadyProvided versus ",  filename);
@@ -1220,10 +1222,10 @@ BOOL __stdcall FindNextFileFixupV2(_In_ HANDLE findFile, _Out_ win32_find_data_t
         }
 #endif
 
-// always return false on directories as these are always considered merged.
+#if WasntABadIdea
+        // always return false on directories as these are always considered merged.
         std::filesystem::path fullpath = findrequest.c_str();
         fullpath  = fullpath.parent_path() / wFilename.c_str();
-#if WasntABadIdea
         // Maybe not.  The caller only needs the folder once, it doesn't see the path that succeeded.
         // Subsequent calls to other file APIs will redirect as needed.
 #if _DEBUG
@@ -1238,20 +1240,13 @@ BOOL __stdcall FindNextFileFixupV2(_In_ HANDLE findFile, _Out_ win32_find_data_t
         }
 #endif
 
-        _locale_t locale = _wcreate_locale(LC_ALL,L"");
-        for (std::wstring check : data->already_returned_list)
+        if (data->already_returned_list.contains(wFilename))
         {
-//            if (check.compare(wFilename.c_str()) == 0)
-            if (_wcsicmp_l(check.c_str(),wFilename.c_str(),locale) == 0)
-            {
 #if _DEBUG
-                Log(L"[%d][%d]\tFindNextFileV2 A wasFileAlreadyProvided returns true %ls", data->RememberedInstance, FindNextFileInstance2, wFilename.c_str());
+            Log(L"[%d][%d]\tFindNextFileV2 A wasFileAlreadyProvided returns true %ls", data->RememberedInstance, FindNextFileInstance2, wFilename.c_str());
 #endif
-                _free_locale(locale);
-                return true;
-            }
+            return true;
         }
-        _free_locale(locale);
 
 #if _DEBUG
         Log(L"[%d][%d]\tFindNextFileV2 wasFileAlreadyProvided returns false", data->RememberedInstance, FindNextFileInstance2);
@@ -1269,7 +1264,7 @@ BOOL __stdcall FindNextFileFixupV2(_In_ HANDLE findFile, _Out_ win32_find_data_t
 #if _DEBUG
                 Log(L"[%d][%d] FindNextFileV2[0] returns TRUE: %ls", data->RememberedInstance, FindNextFileInstance2, widen(findFileData->cFileName).c_str());
 #endif
-                data->already_returned_list.push_back(widen(findFileData->cFileName));
+                data->already_returned_list.insert(widen(findFileData->cFileName));
                 return TRUE;
             }
             else if (::GetLastError() == ERROR_NO_MORE_FILES)
@@ -1302,7 +1297,7 @@ BOOL __stdcall FindNextFileFixupV2(_In_ HANDLE findFile, _Out_ win32_find_data_t
 #if _DEBUG
                     Log(L"[%d][%d] FindNextFileV2[1] returns TRUE with ERROR_SUCCESS and file %ls", data->RememberedInstance, FindNextFileInstance2, widen(findFileData->cFileName).c_str());
 #endif
-                    data->already_returned_list.push_back(widen(findFileData->cFileName));
+                    data->already_returned_list.insert(widen(findFileData->cFileName));
                     ::SetLastError(ERROR_SUCCESS);
                     return TRUE;
                 }
@@ -1352,7 +1347,7 @@ BOOL __stdcall FindNextFileFixupV2(_In_ HANDLE findFile, _Out_ win32_find_data_t
 #if _DEBUG
                         Log(L"[%d][%d] FindNextFileV2[2] returns TRUE with ERROR_SUCCESS and file %ls", data->RememberedInstance, FindNextFileInstance2, widen(findFileData->cFileName).c_str());
 #endif
-                        data->already_returned_list.push_back(widen(findFileData->cFileName));
+                        data->already_returned_list.insert(widen(findFileData->cFileName));
                         ::SetLastError(ERROR_SUCCESS);
                         return TRUE;
                     }
@@ -1396,7 +1391,7 @@ BOOL __stdcall FindNextFileFixupV2(_In_ HANDLE findFile, _Out_ win32_find_data_t
 #if _DEBUG
                     Log(L"[%d][%d] FindNextFileV2[3] returns TRUE with ERROR_SUCCESS and file %ls", data->RememberedInstance, FindNextFileInstance2, widen(findFileData->cFileName).c_str());
 #endif
-                    data->already_returned_list.push_back(widen(findFileData->cFileName));
+                    data->already_returned_list.insert(widen(findFileData->cFileName));
                     ::SetLastError(ERROR_SUCCESS);
                     return TRUE;
                 }
@@ -1442,7 +1437,7 @@ BOOL __stdcall FindNextFileFixupV2(_In_ HANDLE findFile, _Out_ win32_find_data_t
 #if _DEBUG
                     Log(L"[%d][%d] FindNextFileV2[4] returns TRUE with ERROR_SUCCESS and file %ls", data->RememberedInstance, FindNextFileInstance2, widen(findFileData->cFileName).c_str());
 #endif
-                    data->already_returned_list.push_back(widen(findFileData->cFileName));
+                    data->already_returned_list.insert(widen(findFileData->cFileName));
                     ::SetLastError(ERROR_SUCCESS);
                     return TRUE;
                 }
@@ -11,6 +11,8 @@ template <typename CharT>
 BOOL __stdcall MoveFileFixup(_In_ const CharT* existingFileName, _In_ const CharT* newFileName) noexcept
 {
     DWORD MoveFileInstance = ++g_FileIntceptInstance;
+    redirection_change_scope changes(existingFileName);
+    changes.add(newFileName);
     auto guard = g_reentrancyGuard.enter();
     try
     {
@@ -29,7 +31,9 @@ BOOL __stdcall MoveFileFixup(_In_ const CharT* existingFileName, _In_ const Char
             //       same for CopyFile: we give the application the benefit of the doubt that they previously tried to
             //       delete the file if it exists in the package path.
             path_redirect_info  priExisting = ShouldRedirectV2(existingFileName, redirect_flags::copy_on_read, MoveFileInstance);
+            changes.add(priExisting.redirect_path.c_str());
             path_redirect_info  priDest = ShouldRedirectV2(newFileName, redirect_flags::ensure_directory_structure, MoveFileInstance);
+            changes.add(priDest.redirect_path.c_str());
             if (priExisting.should_redirect || priDest.should_redirect)
             {
                 BOOL bRet = impl::MoveFile(
@@ -74,6 +78,8 @@ BOOL __stdcall MoveFileExFixup(
     _In_ DWORD flags) noexcept
 {
     DWORD MoveFileExInstance = ++g_FileIntceptInstance;
+    redirection_change_scope changes(existingFileName);
+    changes.add(newFileName);
     auto guard = g_reentrancyGuard.enter();
     BOOL retfinal;
     try
@@ -89,7 +95,9 @@ BOOL __stdcall MoveFileExFixup(
             // See note in MoveFile for commentary on copy-on-read functionality (though we could do better by checking
             // flags for MOVEFILE_REPLACE_EXISTING)
             path_redirect_info  priExisting = ShouldRedirectV2(existingFileName, redirect_flags::copy_on_read, MoveFileExInstance);
+            changes.add(priExisting.redirect_path.c_str());
             path_redirect_info  priDest = ShouldRedirectV2(newFileName, redirect_flags::ensure_directory_structure, MoveFileExInstance);
+            changes.add(priDest.redirect_path.c_str());
             if (priExisting.should_redirect || priDest.should_redirect)
             {
                 std::wstring rldExistingFileName = TurnPathIntoRootLocalDevice(priExisting.should_redirect ? priExisting.redirect_path.c_str() : widen_argument(existingFileName).c_str());
@@ -0,0 +1,272 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Copyright (C) TMurgent Technologies, LLP. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+//
+// NormalizePathV2, which every V2 intercept runs on the path it was given before anything else. It is kept apart from
+// the rest of PathRedirectionV2.cpp so that the portable tests can build it against their windows.h stand-in.
+
+#include <cwchar>
+#include <filesystem>
+#include <string_view>
+
+#include <psf_logging.h>
+#include <utilities.h>
+
+#include "PathRedirection.h"
+
+using namespace std::literals;
+
+void LogNormalizedPathV2(const normalized_pathV2& np2, std::wstring desc, [[maybe_unused]] DWORD instance)
+{
+    Log(L"[%d]\tNormalized_path %ls Type=%x, Orig=%ls, Full=%ls, Abs=%ls",
+        instance, desc.c_str(), (int)np2.path_type, np2.original_path.c_str(),
+        np2.full_path.c_str(), np2.drive_absolute_path.c_str());
+}
+
+// Appends path to the storage of result with the same cleanup that StripFileColonSlash, ReplaceSlashBackwardOnly and
+// UrlDecode (in that order) would apply, but without building any intermediate strings.
+static void StoreCleanedPathV2(normalized_pathV2& result, std::wstring_view path)
+{
+    for (auto prefix : { L"file:\\\\"sv, L"file://"sv, L"FILE:\\\\"sv, L"FILE://"sv, L"\\\\file\\"sv, L"\\\\FILE\\"sv })
+    {
+        if (path.substr(0, prefix.length()) == prefix)
+        {
+            path.remove_prefix(prefix.length());
+        }
+    }
+
+    for (std::size_t i = 0; i < path.length(); i++)
+    {
+        wchar_t ch = (path[i] == L'/') ? L'\\' : path[i];
+        if (ch != L'%')
+        {
+            result.storage.push_back(ch);
+            continue;
+        }
+
+        // Same parse as UrlDecode: up to four following characters, as hex.
+        wchar_t hex[5] = {};
+        auto hexLength = std::min<std::size_t>(4, path.length() - i - 1);
+        for (std::size_t h = 0; h < hexLength; h++)
+        {
+            hex[h] = (path[i + 1 + h] == L'/') ? L'\\' : path[i + 1 + h];
+        }
+        unsigned int ii;
+        if (swscanf_s(hex, L"%x", &ii) == 1)
+        {
+            result.storage.push_back(static_cast<wchar_t>(static_cast<char>(ii)));
+            i += (ii <= 255) ? 2 : 4;
+        }
+        else
+        {
+            result.storage.push_back(ch);
+        }
+    }
+}
+
+// Appends the current directory, a separator if needed, and then the relativeLength characters at relativeOffset in the
+// storage of result, to that storage. This is what std::filesystem::current_path() / relativePath produces when
+// relativePath is a plain relative path. Returns false, having stored nothing, when that is not the case or the current
+// directory is not a drive-absolute path. The relative path is passed by offset because appending can move the storage.
+static bool StorePathRelativeToCurrentDirectoryV2(normalized_pathV2& result, std::size_t relativeOffset, std::size_t relativeLength)
+{
+    if ((relativeLength > 0) && psf::path_type(result.storage.c_str() + relativeOffset) != psf::dos_path_type::relative)
+    {
+        return false;
+    }
+
+    wchar_t cwd[MAX_PATH + 1];
+    auto cwdLength = ::GetCurrentDirectoryW(MAX_PATH + 1, cwd);
+    if ((cwdLength == 0) || (cwdLength > MAX_PATH) || (psf::path_type(cwd) != psf::dos_path_type::drive_absolute))
+    {
+        return false;
+    }
+
+    result.storage.append(std::wstring_view(cwd, cwdLength));
+    if (!psf::is_path_separator(cwd[cwdLength - 1]))
+    {
+        result.storage.push_back(L'\\');
+    }
+    // Grow first, so that the view is taken of the storage that it is appended to
+    result.storage.reserve(result.storage.size() + relativeLength);
+    result.storage.append(std::wstring_view(result.storage.c_str() + relativeOffset, relativeLength));
+    return true;
+}
+
+static void NormalizePathV2Impl(normalized_pathV2& result, const wchar_t* path, [[maybe_unused]] DWORD inst)
+{
+    ///Log(L"[%d]\t\t\tNormailizePath2Impl",inst);
+    std::wstring_view original(path);
+    result.path_type = psf::path_type(path);
+
+    auto originalOffset = result.store(original);
+    result.storage.push_back(L'\0');
+    auto fullOffset = result.storage.size();
+    StoreCleanedPathV2(result, original);
+    auto fullLength = result.storage.size() - fullOffset;
+    if (std::wstring_view(result.storage.c_str() + fullOffset, fullLength) == original)
+    {
+        // Nothing needed decoding; share the text
+        result.storage.truncate(originalOffset + original.length());
+        fullOffset = originalOffset;
+    }
+
+    ///Log(L"[%d]\t\t\tNormailizePath2Impl post initial decodes.",inst);
+
+    std::size_t absOffset = fullOffset;
+    std::size_t absLength = fullLength;
+    std::filesystem::path cwd;
+    std::wstring_view full(result.storage.c_str() + fullOffset, fullLength);
+
+    switch (result.path_type)
+    {
+    case psf::dos_path_type::unc_absolute:  // E.g. "\\servername\share\path\to\file"
+        break;
+    case psf::dos_path_type::drive_absolute:  // E.g. "C:\path\to\file"
+        break;
+    case psf::dos_path_type::drive_relative:  // E.g. "C:path\to\file"
+    {
+        cwd = std::filesystem::current_path();
+        cwd.append(L"\\");
+        cwd.append(full.data() + 2);
+        auto absolute = cwd.wstring();
+        absOffset = result.store(absolute);
+        absLength = absolute.length();
+        break;
+    }
+    case psf::dos_path_type::rooted:   // E.g. "\path\to\file"
+    {
+        cwd = std::filesystem::current_path();
+        cwd = cwd.root_name();
+        cwd /= full.data();
+        auto absolute = cwd.wstring();
+        absOffset = result.store(absolute);
+        absLength = absolute.length();
+        break;
+    }
+    case psf::dos_path_type::relative:  // E.g. "path\to\file"
+    {
+        // Kept as an offset into storage rather than as a view, as storing the absolute path can move the storage
+        auto skip = (full.substr(0, 2) == L".\\"sv) ? 2 : 0;
+        auto relativeOffset = fullOffset + skip;
+        auto relativeLength = fullLength - skip;
+        absOffset = result.store(L""sv);
+        if (StorePathRelativeToCurrentDirectoryV2(result, relativeOffset, relativeLength))
+        {
+            absLength = result.storage.size() - absOffset;
+        }
+        else
+        {
+            cwd = std::filesystem::current_path();
+            cwd /= std::wstring(result.storage.c_str() + relativeOffset, relativeLength);
+            auto absolute = cwd.wstring();
+            result.storage.append(absolute);
+            absLength = absolute.length();
+        }
+        break;
+    }
+    case psf::dos_path_type::local_device:  // E.g. "\\.\C:\path\to\file"
+    case psf::dos_path_type::root_local_device:   // E.g. "\\?\C:\path\to\file"
+        // Shares the text (and terminator) of full_path
+        absOffset = (fullLength >= 4) ? fullOffset + 4 : fullOffset + fullLength;
+        absLength = (fullLength >= 4) ? fullLength - 4 : 0;
+        break;
+    case psf::dos_path_type::storage_namespace:  // E.g. "\\?\STORAGE#Volume..."
+        break;
+    case psf::dos_path_type::protocol:
+    case psf::dos_path_type::shell:
+    case psf::dos_path_type::unknown:
+    default:
+        break;
+    }
+
+    // Only now that storage has stopped growing can the views be taken
+    result.original_path = result.stored(originalOffset, original.length());
+    result.full_path = result.stored(fullOffset, fullLength);
+    result.drive_absolute_path = result.stored(absOffset, absLength);
+
+#if _DEBUG
+    LogString(inst, L"\t\tNormailizePath2Impl orig",result.original_path.c_str());
+    LogString(inst, L"\t\tNormailizePath2Impl full", result.full_path.c_str());
+    LogString(inst, L"\t\tNormailizePath2Impl abs", result.drive_absolute_path.c_str());
+#endif
+}
+
+// Used for paths that are passed through as they are, such as "::{guid}" and "blob:hexstring".
+static void StoreVerbatimPathV2(normalized_pathV2& result, std::wstring_view path)
+{
+    result.path_type = psf::dos_path_type::unknown;
+    auto offset = result.store(path);
+    result.original_path = result.stored(offset, path.length());
+    result.full_path = result.original_path;
+    result.drive_absolute_path = result.original_path;
+}
+
+normalized_pathV2 NormalizePathV2(const char* path, DWORD inst)
+{
+    //Log(L"[%d]\t\tNormalizePathV2 A",inst);
+    normalized_pathV2 n2;
+
+    if (path != NULL && path[0] != 0)
+    {
+        if (IsColonColonGuid(path))
+        {
+            //Log(L"[%d]\t\t\tNormalizePathV2 A: Guid avoidance.",inst);            
+            StoreVerbatimPathV2(n2, widen(path));
+        }
+        else if (IsBlobColon(path))  // blob:hexstring has been seen, believed to be associated with writing encrypted data,  Just pass it through as it is not a real file.
+        {
+            //Log(L"[%d]\t\t\tNormalizePathV2 A: Blob avoidance.",inst);  
+            StoreVerbatimPathV2(n2, widen(path));
+        }
+        else
+        {
+            NormalizePathV2Impl(n2, widen(path).c_str(), inst);
+        }
+    }
+    else
+    {
+        NormalizePathV2Impl(n2, std::filesystem::current_path().wstring().c_str(), inst);
+        n2.original_path = psf::wzstring_view();
+    }
+    return n2;
+}
+
+normalized_pathV2 NormalizePathV2(const wchar_t* path, DWORD inst)
+{
+    //Log(L"[%d]\t\tNormalizePathV2 W", inst);
+    normalized_pathV2 n2;
+    if (path != NULL && path[0] != 0)
+    {
+        if (IsColonColonGuid(path))
+        {
+#if _DEBUG
+            Log(L"[%d]\t\t\tNormalizePathV2 W: Guid avoidance.",inst);
+#endif
+            StoreVerbatimPathV2(n2, path);
+        }
+        else if (IsBlobColon(path))  // blog:hexstring has been seen, believed to be associated with writing encrypted data,  Just pass it through as it is not a real file.
+        {
+#if _DEBUG
+            Log(L"[%d]\t\t\tNormalizePathV2 W: Blob avoidance.",inst);
+#endif
+            StoreVerbatimPathV2(n2, path);
+        }
+        else
+        {
+            NormalizePathV2Impl(n2, path, inst);
+        }
+    }
+    else
+    {
+#if _DEBUG
+        Log(L"[%d]\t\tNormalizePathV2 W: NULL-or-empty,  Use CWD.",inst);
+#endif
+        NormalizePathV2Impl(n2, std::filesystem::current_path().wstring().c_str(), inst);
+        n2.original_path = psf::wzstring_view();
+    }
+    return n2;
+}
+
@@ -13,6 +13,9 @@
 #include <objbase.h>
 #include <psf_framework.h>
 #include <utilities.h>
+#include <path_prefix_trie.h>
+#include <package_file_index.h>
+#include <mutex>
 
 #include "FunctionImplementations.h"
 #include "PathRedirection.h"
@@ -142,6 +145,239 @@ void InitializePaths()
 
 std::vector<path_redirection_spec> g_redirectionSpecs;
 
+// Index into g_redirectionSpecs by base_path, built once all of the specs have been read from the configuration.
+psf::path_prefix_trie<std::size_t> g_redirectionSpecIndex;
+
+void BuildRedirectionSpecIndex()
+{
+    g_redirectionSpecIndex.clear();
+    for (std::size_t i = 0; i < g_redirectionSpecs.size(); ++i)
+    {
+        g_redirectionSpecIndex.insert(g_redirectionSpecs[i].base_path.native(), i);
+    }
+#if _DEBUG
+    Log(L"\t\tFRF CONFIG: %d redirection specs indexed.", (int)g_redirectionSpecIndex.size());
+#endif
+}
+
+/// <summary>
+/// Find the first redirection spec, in configuration order, whose base_path contains the given path and whose
+/// pattern matches the remainder of the path. This is equivalent to walking g_redirectionSpecs in order, but only
+/// evaluates the patterns of specs whose base_path is actually a parent of the path.
+/// </summary>
+/// <param name="path">The (virtualized) path to test</param>
+/// <param name="relativePath">On a match, set to the part of path that follows the base_path</param>
+/// <returns>The matching spec, or nullptr if there is none.</returns>
+const path_redirection_spec* FindRedirectionSpec(const wchar_t* path, const wchar_t** relativePath)
+{
+    struct candidate
+    {
+        const std::vector<std::size_t>* indices;
+        std::size_t next;
+        std::size_t offset;
+    };
+    thread_local std::vector<candidate> candidates;
+    candidates.clear();
+
+    g_redirectionSpecIndex.for_each_prefix(path, [](const std::vector<std::size_t>& indices, std::size_t offset)
+    {
+        candidates.push_back(candidate{ &indices, 0, offset });
+        return true;
+    });
+
+    // Each node holds its spec indices in ascending order, so merging them gives configuration order.
+    while (true)
+    {
+        candidate* best = nullptr;
+        for (auto& c : candidates)
+        {
+            if ((c.next < c.indices->size()) &&
+                ((best == nullptr) || ((*c.indices)[c.next] < (*best->indices)[best->next])))
+            {
+                best = &c;
+            }
+        }
+        if (best == nullptr)
+        {
+            return nullptr;
+        }
+
+        auto& redirectSpec = g_redirectionSpecs[(*best->indices)[best->next++]];
+        auto relative = path + best->offset;
+        if (redirectSpec.pattern.match(relative))
+        {
+            *relativePath = relative;
+            return &redirectSpec;
+        }
+    }
+}
+
+
+
+// Listing of the package root, which does not change while the process runs. Built on first use unless the
+// configuration sets "packageFileIndex" to false (e.g. for a loose-file layout registered from a development folder).
+psf::package_file_index g_packageFileIndex;
+std::once_flag g_packageFileIndexOnce;
+bool g_usePackageFileIndex = true;
+constexpr std::size_t c_maxPackageFileIndexEntries = 500000;
+
+static void BuildPackageFileIndex()
+{
+    DWORD oldErr = GetLastError();
+    auto start = GetTickCount64();
+    std::wstring rootPath = LR"(\\?\)" + g_packageRootPath.native();
+    std::wstring searchPath;
+    bool built = g_packageFileIndex.build([&](std::wstring_view relativeFolder, auto&& add)
+    {
+        searchPath = rootPath;
+        if (!relativeFolder.empty())
+        {
+            searchPath.push_back(L'\\');
+            searchPath.append(relativeFolder);
+        }
+        searchPath.append(L"\\*");
+
+        WIN32_FIND_DATAW findData;
+        auto findHandle = impl::FindFirstFileEx(searchPath.c_str(), FindExInfoBasic, &findData, FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+        if (findHandle == INVALID_HANDLE_VALUE)
+        {
+            return ::GetLastError() == ERROR_FILE_NOT_FOUND;
+        }
+
+        bool listed = true;
+        do
+        {
+            if ((wcscmp(findData.cFileName, L".") == 0) || (wcscmp(findData.cFileName, L"..") == 0))
+            {
+                continue;
+            }
+            if ((findData.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) != 0)
+            {
+                // Whatever is behind a link might change, so don't answer for any of the package
+                listed = false;
+                break;
+            }
+            add(findData.cFileName, (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0);
+        } while (impl::FindNextFile(findHandle, &findData));
+
+        if (listed && (::GetLastError() != ERROR_NO_MORE_FILES))
+        {
+            listed = false;
+        }
+        impl::FindClose(findHandle);
+        return listed;
+    }, c_maxPackageFileIndexEntries);
+
+    if (built)
+    {
+        Log(L"FRF package file index: %d entries in %d ms", (int)g_packageFileIndex.size(), (int)(GetTickCount64() - start));
+    }
+    else
+    {
+        Log(L"FRF package file index: not available, package paths will be checked on disk.");
+    }
+    SetLastError(oldErr);
+}
+
+// Same as impl::PathExists, but paths in the package are answered from g_packageFileIndex.
+bool PathExistsUsingPackageIndex(const wchar_t* path)
+{
+    if (g_usePackageFileIndex && (path != nullptr))
+    {
+        auto dap = path;
+        auto pathType = psf::path_type(path);
+        if ((pathType == psf::dos_path_type::root_local_device) || (pathType == psf::dos_path_type::local_device))
+        {
+            dap += 4;
+        }
+
+        if (path_relative_to(dap, g_packageRootPath))
+        {
+            auto relativePath = dap + g_packageRootPath.native().length();
+            if ((relativePath[0] == L'\0') || psf::is_path_separator(relativePath[0]))
+            {
+                std::call_once(g_packageFileIndexOnce, BuildPackageFileIndex);
+
+                if (relativePath[0] != L'\0')
+                {
+                    ++relativePath;
+                }
+                switch (g_packageFileIndex.find(relativePath))
+                {
+                case psf::package_file_index::entry_type::file:
+                case psf::package_file_index::entry_type::directory:
+                    return true;
+                case psf::package_file_index::entry_type::missing:
+                    return false;
+                default:
+                    break;
+                }
+            }
+        }
+    }
+    return impl::PathExists(path);
+}
+
+// Changes made to the file system by the fixups, used to keep the per-thread ShouldRedirectV2 caches current.
+psf::path_invalidation_log g_redirectionChangeLog;
+
+// Number of ShouldRedirectV2 decisions each thread may cache; zero disables caching. Set by "decisionCacheSize".
+std::size_t g_redirectionDecisionCacheSize = 256;
+
+void redirection_change_scope::add(const wchar_t* path)
+{
+    if (path != nullptr && path[0] != 0)
+    {
+        m_paths.emplace_back(path);
+    }
+}
+
+void redirection_change_scope::add(const char* path)
+{
+    if (path != nullptr && path[0] != 0)
+    {
+        m_paths.push_back(widen(path));
+    }
+}
+
+redirection_change_scope::~redirection_change_scope()
+{
+    try
+    {
+        for (auto& path : m_paths)
+        {
+            // Relative paths are recorded as their full path so that they can be compared with cached decisions
+            if (psf::path_type(path.c_str()) == psf::dos_path_type::drive_absolute ||
+                psf::path_type(path.c_str()) == psf::dos_path_type::root_local_device ||
+                psf::path_type(path.c_str()) == psf::dos_path_type::unc_absolute)
+            {
+                g_redirectionChangeLog.invalidate(path);
+            }
+            else
+            {
+                g_redirectionChangeLog.invalidate(NormalizePathV2(path.c_str(), 0).drive_absolute_path);
+            }
+        }
+    }
+    catch (...)
+    {
+        Log(L"*****FRF redirection_change_scope Exception!!");
+    }
+}
+
+void LogRedirectionDecisionCacheStatistics()
+{
+    Log(L"FRF decision cache: size=%d hits=%llu misses=%llu invalidated=%llu flushes=%llu",
+        (int)g_redirectionDecisionCacheSize,
+        g_redirectionChangeLog.hits.load(),
+        g_redirectionChangeLog.misses.load(),
+        g_redirectionChangeLog.invalidated_entries.load(),
+        g_redirectionChangeLog.flushes.load());
+    g_redirectionChangeLog.for_each_subtree_count([](std::wstring_view subtree, std::size_t count)
+    {
+        Log(L"FRF decision cache: %d changes under %ls", (int)count, subtree.empty() ? L"(other folders)" : std::wstring(subtree).c_str());
+    });
+}
 
 
 std::filesystem::path path_from_known_folder_string(std::wstring_view str)
@@ -383,6 +619,8 @@ void manual_wait_for_debugger()
 
 void InitializeConfiguration()
 {
+    SetLogLevels(::PSFQueryCurrentDllLogLevel());
+
     TraceLoggingRegister(g_Log_ETW_ComponentProvider);
     std::wstringstream traceDataStream;
 
@@ -402,6 +640,16 @@ void InitializeConfiguration()
 #endif            
         auto& rootObject = rootConfig->as_object();
         traceDataStream << " config:\n";
+        if (auto cacheSizeValue = rootObject.try_get("decisionCacheSize"))
+        {
+            g_redirectionDecisionCacheSize = cacheSizeValue->as_number().get<std::size_t>();
+            traceDataStream << " decisionCacheSize:" << g_redirectionDecisionCacheSize << " ;";
+        }
+        if (auto packageFileIndexValue = rootObject.try_get("packageFileIndex"))
+        {
+            g_usePackageFileIndex = packageFileIndexValue->as_boolean().get();
+            traceDataStream << " packageFileIndex:" << (g_usePackageFileIndex ? "true" : "false") << " ;";
+        }
         if (auto pathsValue = rootObject.try_get("redirectedPaths"))
         {
 #if MOREDEBUG
@@ -447,7 +695,7 @@ void InitializeConfiguration()
                         {
                           g_redirectionSpecs.emplace_back();
                           g_redirectionSpecs.back().base_path = path;
-                          g_redirectionSpecs.back().pattern.assign(patternString.data(), patternString.length());
+                          g_redirectionSpecs.back().pattern.assign(patternString);
                           try
                           {
                               g_redirectionSpecs.back().patternWstring = patternString.data();
@@ -522,6 +770,8 @@ void InitializeConfiguration()
             TraceLoggingKeyword(MICROSOFT_KEYWORD_CRITICAL_DATA));
     }
 
+    BuildRedirectionSpecIndex();
+
     TraceLoggingUnregister(g_Log_ETW_ComponentProvider);
 }
 
@@ -1192,7 +1442,7 @@ static path_redirect_info ShouldRedirectImpl(const CharT* path, redirect_flags f
 #ifdef MOREDEBUG
             //LogString(inst, L"\t\t\tFRFShouldRedirect: relativePath",relativePath);
 #endif
-            if (std::regex_match(relativePath, redirectSpec.pattern))
+            if (redirectSpec.pattern.match(relativePath))
             {
                 if (redirectSpec.isExclusion)
                 {
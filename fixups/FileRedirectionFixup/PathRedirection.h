@@ -6,7 +6,11 @@
 
 #include <regex>
 #include <filesystem>
+#include <functional>
 #include <dos_paths.h>
+#include <dfa_regex.h>
+#include <path_decision_cache.h>
+#include <inline_wstring.h>
 
 enum class redirect_flags
 {
@@ -65,7 +69,7 @@ struct vfs_folder_mapping
 struct path_redirection_spec
 {
     std::filesystem::path base_path;
-    std::wregex pattern;
+    psf::dfa_regex pattern;
     std::wstring patternWstring;
     std::filesystem::path redirect_targetbase;
     bool isExclusion;
@@ -73,6 +77,11 @@ struct path_redirection_spec
 };
 
 
+// Returns the first path_redirection_spec, in configuration order, that applies to the path (or nullptr). On a match,
+// relativePath points at the portion of path that follows the spec's base_path.
+const path_redirection_spec* FindRedirectionSpec(const wchar_t* path, const wchar_t** relativePath);
+
+
 struct normalized_path
 {
     // The full_path could either be:
@@ -99,25 +108,98 @@ struct normalized_pathV2
     //      3.  A root-local device path. E.g. "\\?\C:\foo\bar.txt" or "\\?\HarddiskVolume1\foo\bar.txt"
     //      4.  A UNC-absolute path. E.g. "\\server\share\foo\bar.txt"
     // or empty if there was a failure
-    // All are stored wide
-    std::wstring original_path;
-    std::wstring full_path;
+    // All are stored wide, as null terminated views into storage (the same text is shared when the views are equal).
+    psf::wzstring_view original_path;
+    psf::wzstring_view full_path;
 
-    psf::dos_path_type path_type;
+    psf::dos_path_type path_type = psf::dos_path_type::unknown;
 
     // A shortened full_path if the path explicitly uses a drive symbolic link at the root, otherwise the full_path or a path with working directory added; always wide.
-    std::wstring drive_absolute_path;
+    psf::wzstring_view drive_absolute_path;
+
+    // Null terminated segments that the views above point into. Typical paths fit inline, so normalizing a path does not
+    // need the heap; pass normalized_pathV2 by const reference all the same, as it is not small.
+    psf::inline_wstring<2 * MAX_PATH> storage;
+
+    normalized_pathV2() = default;
+
+    normalized_pathV2(const normalized_pathV2& other) :
+        path_type(other.path_type),
+        storage(other.storage)
+    {
+        rebase_views(other, other.storage.c_str(), other.storage.size());
+    }
+
+    normalized_pathV2(normalized_pathV2&& other) noexcept :
+        path_type(other.path_type),
+        storage(std::move(other.storage))
+    {
+        // When the storage was on the heap it has simply changed owner
+        auto oldBase = storage.is_inline() ? other.storage.c_str() : storage.c_str();
+        rebase_views(other, oldBase, storage.size());
+    }
+
+    normalized_pathV2& operator=(const normalized_pathV2& other)
+    {
+        if (this != &other)
+        {
+            path_type = other.path_type;
+            storage = other.storage;
+            rebase_views(other, other.storage.c_str(), other.storage.size());
+        }
+        return *this;
+    }
+
+    normalized_pathV2& operator=(normalized_pathV2&& other) noexcept
+    {
+        if (this != &other)
+        {
+            auto oldBase = other.storage.c_str();
+            auto oldSize = other.storage.size();
+            path_type = other.path_type;
+            storage = std::move(other.storage);
+            rebase_views(other, oldBase, oldSize);
+        }
+        return *this;
+    }
+
+    // Appends text to storage as a new null terminated segment and returns its offset.
+    std::size_t store(std::wstring_view text)
+    {
+        if (!storage.empty())
+        {
+            storage.push_back(L'\0');
+        }
+        auto offset = storage.size();
+        storage.append(text);
+        return offset;
+    }
+
+    // A view of length characters at offset in storage; storage[offset + length] must be a null terminator.
+    psf::wzstring_view stored(std::size_t offset, std::size_t length) const noexcept
+    {
+        return psf::wzstring_view(storage.c_str() + offset, length);
+    }
+
+private:
+
+    void rebase_views(const normalized_pathV2& other, const wchar_t* oldBase, std::size_t oldSize) noexcept
+    {
+        auto rebase = [&](psf::wzstring_view view)
+        {
+            std::less_equal<const wchar_t*> le;
+            if (le(oldBase, view.data()) && le(view.data(), oldBase + oldSize))
+            {
+                return stored(view.data() - oldBase, view.length());
+            }
+            return view;
+        };
+        original_path = rebase(other.original_path);
+        full_path = rebase(other.full_path);
+        drive_absolute_path = rebase(other.drive_absolute_path);
+    }
 };
 
-inline normalized_pathV2 ClonePathV2(normalized_pathV2 input)
-{
-    normalized_pathV2 output;
-    output.original_path = input.original_path;
-    output.drive_absolute_path = input.drive_absolute_path;
-    output.full_path = input.full_path;
-    output.path_type = input.path_type;
-    return output;
-}
 
 path_redirect_info ShouldRedirect(const char* path, redirect_flags flags, DWORD inst = 0);
 path_redirect_info ShouldRedirect(const wchar_t* path, redirect_flags flags, DWORD inst = 0);
@@ -126,13 +208,41 @@ path_redirect_info ShouldRedirect(const wchar_t* path, redirect_flags flags, DWO
 path_redirect_info ShouldRedirectV2(const char* path, redirect_flags flags, DWORD inst = 0);
 path_redirect_info ShouldRedirectV2(const wchar_t* path, redirect_flags flags, DWORD inst = 0);
 
+// ShouldRedirectV2 decisions are cached per thread. A fixup that creates, deletes, moves or copies files declares one of
+// these before making the change and adds every path it touches (as requested and as redirected); when it goes out of
+// scope, after the change has been made, cached decisions that depended on those paths are dropped.
+class redirection_change_scope
+{
+public:
+    redirection_change_scope() = default;
+
+    template <typename CharT>
+    explicit redirection_change_scope(const CharT* path)
+    {
+        add(path);
+    }
+
+    redirection_change_scope(const redirection_change_scope&) = delete;
+    redirection_change_scope& operator=(const redirection_change_scope&) = delete;
+
+    ~redirection_change_scope();
+
+    void add(const char* path);
+    void add(const wchar_t* path);
+
+private:
+    std::vector<std::wstring> m_paths;
+};
+
+void LogRedirectionDecisionCacheStatistics();
+
 normalized_path NormalizePath(const char* path, DWORD inst);
 normalized_path NormalizePath(const wchar_t* path, DWORD inst);
 
 
 normalized_pathV2 NormalizePathV2(const char* path, DWORD inst);
 normalized_pathV2 NormalizePathV2(const wchar_t* path, DWORD inst);
-void LogNormalizedPathV2(normalized_pathV2 np2, std::wstring desc, DWORD instance);
+void LogNormalizedPathV2(const normalized_pathV2& np2, std::wstring desc, DWORD instance);
 
 std::string RemoveAnyFinalDoubleSlash(std::string input);
 std::wstring RemoveAnyFinalDoubleSlash(std::wstring input);
@@ -141,14 +251,14 @@ std::wstring RemoveAnyFinalDoubleSlash(std::wstring input);
 // then modifies that path to its virtualized equivalent (e.g. "C:\Windows\System32\foo.txt")
 normalized_path DeVirtualizePath(normalized_path path);
 
-std::wstring DeVirtualizePathV2(normalized_pathV2 path);
+std::wstring DeVirtualizePathV2(const normalized_pathV2& path);
 
 // If the input path is a physical path outside of the package (e.g. "C:\Windows\System32\foo.txt"),
 // this returns what the package VFS equivalent would be (e.g "C:\Program Files\WindowsApps\Packagename\VFS\SystemX64\foo.txt");
 // NOTE: Does not check if package has this virtualized path.
 normalized_path VirtualizePath(normalized_path path, DWORD impl = 0);
 
-std::wstring VirtualizePathV2(normalized_pathV2 path, DWORD impl = 0);
+std::wstring VirtualizePathV2(const normalized_pathV2& path, DWORD impl = 0);
 
 std::wstring GenerateRedirectedPath(std::wstring_view relativePath, bool ensureDirectoryStructure, std::wstring result, DWORD inst);
 
@@ -161,6 +271,9 @@ std::wstring RedirectedPathV2(const normalized_pathV2& deVirtualizedPath, bool e
 
 std::wstring ReverseRedirectedToPackage(const std::wstring input);
 
+// Same as impl::PathExists, but answers for paths in the package without going to disk.
+bool PathExistsUsingPackageIndex(const wchar_t* path);
+
 // Return path to existing package VFS file (or NULL if not present) but only for AppData local and remote
 std::filesystem::path GetPackageVFSPath(const wchar_t* fileName);
 std::filesystem::path GetPackageVFSPath(const char* fileName);
@@ -224,8 +337,8 @@ bool IsSpecialFile( const wchar_t* path);
 bool IsColonColonGuid(const char* path);
 bool IsColonColonGuid(const wchar_t* path);
 
-bool IsBlobColon(const std::string path);
-bool IsBlobColon(const std::wstring path);
+bool IsBlobColon(std::string_view path);
+bool IsBlobColon(std::wstring_view path);
 
 std::string UrlDecode(std::string str);
 std::wstring UrlDecode(std::wstring str);
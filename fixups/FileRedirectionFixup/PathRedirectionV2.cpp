@@ -40,172 +40,11 @@ extern std::filesystem::path g_finalPackageRootPath;
 extern std::vector<vfs_folder_mapping> g_vfsFolderMappings;
 extern std::vector<path_redirection_spec> g_redirectionSpecs;
 
-#pragma region NormalizeV2
-void LogNormalizedPathV2(normalized_pathV2 np2, std::wstring desc, [[maybe_unused]] DWORD instance)
-{
-    Log(L"[%d]\tNormalized_path %ls Type=%x, Orig=%ls, Full=%ls, Abs=%ls",
-        instance, desc.c_str(), (int)np2.path_type, np2.original_path.c_str(),
-        np2.full_path.c_str(), np2.drive_absolute_path.c_str());
-}
-
-
-normalized_pathV2 NormalizePathV2Impl(const wchar_t* path, [[maybe_unused]] DWORD inst)
-{
-    normalized_pathV2 result;
-    ///Log(L"[%d]\t\t\tNormailizePath2Impl",inst);
-    result.original_path = path;
-    result.path_type = psf::path_type(path);
-
-    std::wstring new_wstring = StripFileColonSlash(result.original_path.c_str());        // removes "file:\\" from start of path if present
-    new_wstring = ReplaceSlashBackwardOnly(new_wstring);      // Ensure all slashes are backslashes
-    new_wstring = UrlDecode(new_wstring);
-    result.full_path = new_wstring;
-
-    ///Log(L"[%d]\t\t\tNormailizePath2Impl post initial decodes.",inst);
-
-    std::filesystem::path cwd;
-
-    switch (result.path_type)
-    {
-    case psf::dos_path_type::unc_absolute:  // E.g. "\\servername\share\path\to\file"
-        result.drive_absolute_path = result.full_path.data();
-        break;
-    case psf::dos_path_type::drive_absolute:  // E.g. "C:\path\to\file"
-        result.drive_absolute_path = result.full_path.data();
-        break;
-    case psf::dos_path_type::drive_relative:  // E.g. "C:path\to\file"
-        cwd = std::filesystem::current_path();
-        cwd.append(L"\\");
-        cwd.append(result.full_path.data() + 2);
-        result.drive_absolute_path = cwd.native();
-        break;
-    case psf::dos_path_type::rooted:   // E.g. "\path\to\file"
-        cwd = std::filesystem::current_path();
-        cwd = cwd.root_name();
-        cwd /= result.full_path.data();
-        result.drive_absolute_path = cwd.native();
-        break;
-    case psf::dos_path_type::relative:  // E.g. "path\to\file"
-        cwd = std::filesystem::current_path();
-        if (result.full_path._Starts_with(L".\\"))
-        {
-            cwd.append(result.full_path.data() + 2);
-        }
-        else
-        {
-            cwd /= result.full_path.data();
-        }
-        result.drive_absolute_path = cwd.native();
-        break;
-    case psf::dos_path_type::local_device:  // E.g. "\\.\C:\path\to\file"
-        result.drive_absolute_path = result.full_path.substr(4); 
-        break;
-    case psf::dos_path_type::storage_namespace:  // E.g. "\\?\STORAGE#Volume..."
-        result.drive_absolute_path = result.full_path.data();
-        break;
-    case psf::dos_path_type::root_local_device:   // E.g. "\\?\C:\path\to\file"
-        result.drive_absolute_path = result.full_path.substr(4);
-        break;
-    case psf::dos_path_type::protocol:
-    case psf::dos_path_type::shell:
-    case psf::dos_path_type::unknown:
-    default:
-        result.drive_absolute_path = result.full_path.data();
-        break;
-    }
-
-#if _DEBUG
-    LogString(inst, L"\t\tNormailizePath2Impl orig",result.original_path.data());
-    LogString(inst, L"\t\tNormailizePath2Impl full", result.full_path.c_str());
-    LogString(inst, L"\t\tNormailizePath2Impl abs", result.drive_absolute_path.c_str());
-#endif
-    return result;
-}
-
-normalized_pathV2 NormalizePathV2(const char* path, DWORD inst)
-{
-    //Log(L"[%d]\t\tNormalizePathV2 A",inst);
-    normalized_pathV2 n2;
-
-    if (path != NULL && path[0] != 0)
-    {
-        n2.original_path = widen(path).c_str();
-        if (IsColonColonGuid(path))
-        {
-            //Log(L"[%d]\t\t\tNormalizePathV2 A: Guid avoidance.",inst);            
-            n2.path_type = psf::dos_path_type::unknown;
-            n2.full_path = widen(path).c_str();
-            n2.drive_absolute_path = n2.full_path;
-            n2.original_path = n2.full_path;
-        }
-        else if (IsBlobColon(path))  // blob:hexstring has been seen, believed to be associated with writing encrypted data,  Just pass it through as it is not a real file.
-        {
-            //Log(L"[%d]\t\t\tNormalizePathV2 A: Blob avoidance.",inst);  
-            n2.path_type = psf::dos_path_type::unknown;
-            n2.full_path = widen(path).c_str();
-            n2.drive_absolute_path = n2.full_path;
-            n2.original_path = n2.full_path;
-        }
-        else
-        {
-            n2 = NormalizePathV2Impl(n2.original_path.c_str(),inst);
-        }
-    }
-    else
-    {
-        n2 = NormalizePathV2Impl(std::filesystem::current_path().c_str(),inst);
-        n2.original_path = nullptr;
-    }
-    return n2;
-}
-
-normalized_pathV2 NormalizePathV2(const wchar_t* path, DWORD inst)
-{
-    //Log(L"[%d]\t\tNormalizePathV2 W", inst);
-    normalized_pathV2 n2;
-    if (path != NULL && path[0] != 0)
-    {
-        n2.original_path = path;
-        if (IsColonColonGuid(path))
-        {
-#if _DEBUG
-            Log(L"[%d]\t\t\tNormalizePathV2 W: Guid avoidance.",inst);
-#endif
-            n2.path_type = psf::dos_path_type::unknown;
-            n2.original_path = path;
-            n2.full_path = path;
-            n2.drive_absolute_path = path;
-        }
-        else if (IsBlobColon(path))  // blog:hexstring has been seen, believed to be associated with writing encrypted data,  Just pass it through as it is not a real file.
-        {
-#if _DEBUG
-            Log(L"[%d]\t\t\tNormalizePathV2 W: Blob avoidance.",inst);
-#endif
-            n2.path_type = psf::dos_path_type::unknown;
-            n2.full_path = path;
-            n2.full_path = path;
-            n2.drive_absolute_path = path;
-        }
-        else
-        {
-            n2 = NormalizePathV2Impl(n2.original_path.c_str(),inst);
-        }
-    }
-    else
-    {
-#if _DEBUG
-        Log(L"[%d]\t\tNormalizePathV2 W: NULL-or-empty,  Use CWD.",inst);
-#endif
-        n2 = NormalizePathV2Impl(std::filesystem::current_path().c_str(),inst);
-        n2.original_path = path;
-    }
-    return n2;
-}
-
-#pragma endregion
+extern psf::path_invalidation_log g_redirectionChangeLog;
+extern std::size_t g_redirectionDecisionCacheSize;
 
 #pragma region DevirtualizeV2
-void LogDeVirtualizedPathV2(normalized_pathV2 np2, std::wstring desc, [[maybe_unused]] DWORD instance)
+void LogDeVirtualizedPathV2(const normalized_pathV2& np2, std::wstring desc, [[maybe_unused]] DWORD instance)
 {
 #if _DEBUG
     Log(L"[%d]\tDeVirtualized_path %ls Type=%x, Orig=%ls, Full=%ls, Abs=%ls", instance, desc.c_str(), (int)np2.path_type, np2.original_path.c_str(), np2.full_path.c_str(), np2.drive_absolute_path.c_str());
@@ -218,7 +57,7 @@ void LogDeVirtualizedPathV2(normalized_pathV2 np2, std::wstring desc, [[maybe_un
 /// </summary>
 /// <param name="path"></param>
 /// <returns></returns>
-std::wstring DeVirtualizePathV2(normalized_pathV2 path)
+std::wstring DeVirtualizePathV2(const normalized_pathV2& path)
 {
     std::wstring dvPath = L"";
 
@@ -230,19 +69,19 @@ std::wstring DeVirtualizePathV2(normalized_pathV2 path)
     }
     else
     {
-        std::wstring wPathDAP = path.drive_absolute_path;
+        const wchar_t* wPathDAP = path.drive_absolute_path.c_str();
         if (path.path_type == psf::dos_path_type::local_device ||
             path.path_type == psf::dos_path_type::root_local_device)
         {
-            if (wPathDAP.substr(0, 4).compare(L"\\\\?\\") == 0 ||
-                wPathDAP.substr(0, 4).compare(L"\\\\.\\") == 0)
+            if (path.drive_absolute_path.substr(0, 4).compare(L"\\\\?\\") == 0 ||
+                path.drive_absolute_path.substr(0, 4).compare(L"\\\\.\\") == 0)
             {
-                wPathDAP = wPathDAP.substr(4);
+                wPathDAP += 4;
             }
         }
-        if (path_relative_to(wPathDAP.c_str(), g_packageVfsRootPath))
+        if (path_relative_to(wPathDAP, g_packageVfsRootPath))
         {
-            auto packageRelativePath = wPathDAP.data() + g_packageVfsRootPath.native().length();
+            auto packageRelativePath = wPathDAP + g_packageVfsRootPath.native().length();
             if (psf::is_path_separator(packageRelativePath[0]))
             {
                 ++packageRelativePath;
@@ -279,7 +118,7 @@ std::wstring DeVirtualizePathV2(normalized_pathV2 path)
 // If the input path is a physical path outside of the package (e.g. "C:\Windows\System32\foo.txt"),
 // this returns what the package VFS equivalent would be (e.g "C:\Program Files\WindowsApps\Packagename\VFS\SystemX64\foo.txt");
 // NOTE: Does not check if package has this virtualized path.
-std::wstring VirtualizePathV2(normalized_pathV2 path, [[maybe_unused]] DWORD impl)
+std::wstring VirtualizePathV2(const normalized_pathV2& path, [[maybe_unused]] DWORD impl)
 {
 #ifdef MOREDEBUG
     LogString(impl, L"\t\tVirtualizePathV2: Input original_path ", path.original_path.c_str());
@@ -349,7 +188,7 @@ std::wstring VirtualizePathV2(normalized_pathV2 path, [[maybe_unused]] DWORD imp
 #endif
     vPath = g_packageVfsRootPath.c_str();
     vPath.push_back(L'\\');
-    vPath.push_back(path.drive_absolute_path[0]);
+    vPath.push_back(path.drive_absolute_path.c_str()[0]);
     vPath.push_back('$');  // Replace ':' with '$'
     auto remainingLength = wcslen(path.drive_absolute_path.c_str());
     remainingLength -= 2;
@@ -376,11 +215,8 @@ std::wstring RedirectedPathV2(const normalized_pathV2& pathAsRequestedNormalized
     std::wstring relativePath;
 
     bool shouldredirectToPackageRoot = false;
-    auto deVirtualizedFullPath = pathAsRequestedNormalized.drive_absolute_path;
-    if (pathAsRequestedNormalized.drive_absolute_path.empty())
-    {
-        deVirtualizedFullPath = pathAsRequestedNormalized.full_path;
-    }
+    std::wstring deVirtualizedFullPath(pathAsRequestedNormalized.drive_absolute_path.empty() ?
+        pathAsRequestedNormalized.full_path : pathAsRequestedNormalized.drive_absolute_path);
 
     // The package root path is not redirected by this code
     if (IsPackageRoot(deVirtualizedFullPath.c_str()))
@@ -455,7 +291,7 @@ std::wstring RedirectedPathV2(const normalized_pathV2& pathAsRequestedNormalized
 #if _DEBUG
             ///Log("[%d]RedirectedPath: File share case should not be redirected ever.", inst);
 #endif
-            return pathAsRequestedNormalized.full_path;
+            return std::wstring(pathAsRequestedNormalized.full_path);
         }
         else
         {
@@ -555,41 +391,25 @@ std::wstring RedirectedPathV2(const normalized_pathV2& pathAsRequestedNormalized
 
 #pragma region ShouldRedirectV2
 
+// Details of a ShouldRedirectV2Impl decision that are needed to cache it, but are not part of path_redirect_info.
+struct redirect_decision_context
+{
+    std::wstring deVirtualizedPath;
+    bool failed = false;
+};
+
+// Works out whether, and where to, path is redirected. This only reads the file system: ShouldRedirectV2Cached removes
+// the copy_on_read flags before calling it and then carries them out itself.
 template <typename CharT>
-static path_redirect_info ShouldRedirectV2Impl(const CharT* path, redirect_flags flags, DWORD inst)
+static path_redirect_info ShouldRedirectV2Impl(const CharT* path, const normalized_pathV2& normalizedPathV2, redirect_flags flags, redirect_decision_context& context, DWORD inst)
 {
     path_redirect_info result;
 
-    if (!path)
-    {
-        return result;
-    }
-#if _DEBUG
-    LogString(inst, L" \tFRFShouldRedirectV2: called for path", widen(path).c_str());
-#endif
     try
     {
 
-#if _DEBUG
-        bool c_presense = flag_set(flags, redirect_flags::check_file_presence);
-        bool c_copy = flag_set(flags, redirect_flags::copy_file);
-        bool c_ensure = flag_set(flags, redirect_flags::ensure_directory_structure);
-        bool c_ok_if = flag_set(flags, redirect_flags::ok_if_parent_in_pkg);
-        Log(L"[%d]\t\tFRFShouldRedirectV2: flags  CheckPresense:%d  CopyFile:%d  EnsureDirectory:%d OkIfParent:%d", inst, c_presense, c_copy, c_ensure, c_ok_if);
-#endif
-
         // normalizedPathv2 represents the requested path, redirected to the external system if relevant, or just as requested if not.
         // pathVirtualizedV2 represents this as a package relative path
-        normalized_pathV2 normalizedPathV2 = NormalizePathV2(path, inst);
-
-        if (IsSpecialFile(path))
-        {
-#if _DEBUG
-            Log(L"[%d]\t\tFRFShouldRedirectV2: Request is a special file not subject to redirection.", inst);
-#endif
-            return result;
-        }
-
         if (IsUnderUserPackageWritablePackageRoot(normalizedPathV2.drive_absolute_path.c_str()))
         {
             result.Requested_FilePathArea = FilePathArea_Redirection;
@@ -614,7 +434,7 @@ static path_redirect_info ShouldRedirectV2Impl(const CharT* path, redirect_flags
 
         if (result.Requested_FilePathArea == FilePathArea_Redirection)
         {
-            std::wstring reversedWritablePathWstring = ReverseRedirectedToPackage(normalizedPathV2.drive_absolute_path);
+            std::wstring reversedWritablePathWstring = ReverseRedirectedToPackage(std::wstring(normalizedPathV2.drive_absolute_path));
             if (reversedWritablePathWstring.length() > 0)
             {
                 // We were provided a path that is in the redirection area. We probably want to use this path,
@@ -654,21 +474,21 @@ static path_redirect_info ShouldRedirectV2Impl(const CharT* path, redirect_flags
 #ifdef MOREDEBUG
         LogString(inst, L"\t\tFRFShouldRedirectV2: NormalizedV2.DAP", normalizedPathV2.drive_absolute_path.c_str());
 #endif
-        result.doesRequestedExist = impl::PathExists( TurnPathIntoRootLocalDevice(normalizedPathV2.drive_absolute_path.c_str()).c_str());
+        result.doesRequestedExist = PathExistsUsingPackageIndex( TurnPathIntoRootLocalDevice(normalizedPathV2.drive_absolute_path.c_str()).c_str());
 #if _DEBUG
         Log(L"[%d]\t\tFRFShouldRedirectV2: doesRequestedExist=%d", inst, result.doesRequestedExist);
 #endif
 
-        normalized_pathV2 cloneNormalizedPathV2 = ClonePathV2(normalizedPathV2);
 #ifdef DODEVIRT
         // To be consistent in where we redirect files, we need to map VFS paths to their non-package-relative equivalent,
         // but maybe only for findfile and not these
-        std::wstring DeVirtualizedV2 = DeVirtualizePathV2(std::move(normalizedPathV2));   
+        std::wstring DeVirtualizedV2 = DeVirtualizePathV2(normalizedPathV2);
 #ifdef MOREDEBUG
         LogString(inst, L"\t\tFRFShouldRedirectV2: DeVirtualizedV2", DeVirtualizedV2.c_str());
 #endif
         if (DeVirtualizedV2.length() > 0)
         {
+            context.deVirtualizedPath = DeVirtualizedV2;
             result.doesDevirtualizedExist = impl::PathExists(TurnPathIntoRootLocalDevice(DeVirtualizedV2.c_str()).c_str());
 #if _DEBUG
             Log(L"[%d]\t\tFRFShouldRedirectV2: doesDevirtualizedExist=%d", inst, result.doesDevirtualizedExist);
@@ -685,10 +505,10 @@ static path_redirect_info ShouldRedirectV2Impl(const CharT* path, redirect_flags
         // FindFirstFile/NextFixup.cpp
         std::wstring pathVirtualizedV2 = L"";
 #ifdef MOREDEBUG
-        Log(L"[%d]\t\tFRFShouldRedirectV2: type=0x%x %ls", inst, cloneNormalizedPathV2.path_type, cloneNormalizedPathV2.drive_absolute_path.c_str());
+        Log(L"[%d]\t\tFRFShouldRedirectV2: type=0x%x %ls", inst, normalizedPathV2.path_type, normalizedPathV2.drive_absolute_path.c_str());
 #endif
-        if (cloneNormalizedPathV2.path_type != psf::dos_path_type::unknown &&
-            cloneNormalizedPathV2.path_type != psf::dos_path_type::unc_absolute)
+        if (normalizedPathV2.path_type != psf::dos_path_type::unknown &&
+            normalizedPathV2.path_type != psf::dos_path_type::unc_absolute)
         {
             switch (result.Requested_FilePathArea)
             {
@@ -698,14 +518,14 @@ static path_redirect_info ShouldRedirectV2Impl(const CharT* path, redirect_flags
                 break;
             case FilePathArea_Native:
             default:
-                pathVirtualizedV2 = VirtualizePathV2(cloneNormalizedPathV2, inst);
+                pathVirtualizedV2 = VirtualizePathV2(normalizedPathV2, inst);
                 if (pathVirtualizedV2.length() > 0)
                 {
 #if _DEBUG
                     LogString(inst, L"Native path virtualized", pathVirtualizedV2.c_str());
 #endif
                     result.vfs_path = pathVirtualizedV2.c_str();
-                    result.doesVFSExist = impl::PathExists(TurnPathIntoRootLocalDevice(pathVirtualizedV2.c_str()).c_str());
+                    result.doesVFSExist = PathExistsUsingPackageIndex(TurnPathIntoRootLocalDevice(pathVirtualizedV2.c_str()).c_str());
 #if _DEBUG
                     Log(L"[%d]\t\tFRFShouldRedirectV2: doesVFSExist=%d", inst, result.doesVFSExist);
 #endif        
@@ -720,8 +540,8 @@ static path_redirect_info ShouldRedirectV2Impl(const CharT* path, redirect_flags
 
         if (pathVirtualizedV2.length() == 0)
         {
-            //pathVirtualizedV2 = cloneNormalizedPathV2.full_path.c_str(); // should be dap in case this was a relative path?
-            pathVirtualizedV2 = cloneNormalizedPathV2.drive_absolute_path.c_str(); 
+            //pathVirtualizedV2 = normalizedPathV2.full_path.c_str(); // should be dap in case this was a relative path?
+            pathVirtualizedV2 = normalizedPathV2.drive_absolute_path.c_str(); 
         }
 
         auto vfspathV2 = NormalizePathV2(pathVirtualizedV2.c_str(), inst);
@@ -735,62 +555,105 @@ static path_redirect_info ShouldRedirectV2Impl(const CharT* path, redirect_flags
 
 
         // Figure out if this VFS path is something we need to redirect
-        for (auto& redirectSpec : g_redirectionSpecs)
+        const wchar_t* relativePath = nullptr;
+        if (auto matchedSpec = FindRedirectionSpec(pathVirtualizedV2.c_str(), &relativePath))
         {
+            auto& redirectSpec = *matchedSpec;
 #ifdef RULEDEBUG
-            Log(L"[%d]\t\tFRFShouldRedirectV2: Check against: base_path=%s and pattern=%s exclusion=%d", inst, redirectSpec.base_path.c_str(), redirectSpec.patternWstring.c_str(),redirectSpec.isExclusion);
-            Log(L"[%d]\t\tFRFShouldRedirectV2: versus=%s", inst, pathVirtualizedV2.c_str());
+            Log(L"[%d]\t\tFRFShouldRedirectV2: Matched: base_path=%s and pattern=%s exclusion=%d", inst, redirectSpec.base_path.c_str(), redirectSpec.patternWstring.c_str(),redirectSpec.isExclusion);
+            LogString(inst, L"\t\t\tFRFShouldRedirectV2: relativePath",relativePath);
 #endif
-            if (path_relative_to(pathVirtualizedV2.c_str(), redirectSpec.base_path))
+            if (redirectSpec.isExclusion)
             {
+                // The impact on isExclusion is that redirection is not needed.
+                result.should_redirect = false;
 #ifdef RULEDEBUG
-                LogString(inst, L"\t\tFRFShouldRedirectV2: In ball park of base", redirectSpec.base_path.c_str());
+                LogString(inst, L"\t\tFRFShouldRedirectV2 CASE:Exclusion for path", widen(path).c_str());
 #endif
-                auto relativePath = pathVirtualizedV2.c_str() + redirectSpec.base_path.native().length();
-                if (psf::is_path_separator(relativePath[0]))
-                {
-                    ++relativePath;
+            }
+            else
+            {
+                result.should_redirect = true;
+                result.shouldReadonly = (redirectSpec.isReadOnly == true);
+
+                // Check if file exists as VFS path in the package
+                std::wstring rldPath = TurnPathIntoRootLocalDevice(pathVirtualizedV2.c_str());
+                if (PathExistsUsingPackageIndex(rldPath.c_str()))
+                { 
+#ifdef RULEDEBUG
+                    Log(L"[%d]\t\t\tFRFShouldRedirectV2 CASE:match, existing in package.", inst);
+#endif
+                    result.vfs_path = rldPath.c_str();
+                    result.doesVFSExist = true;
+                    destinationTargetBase = redirectSpec.redirect_targetbase;
+
+#ifdef RULEDEBUG
+                    LogString(inst, L"\t\tFRFShouldRedirectV2 isWide for", pathVirtualizedV2.c_str());
+                    LogString(inst, L"\t\tFRFShouldRedirectV2 isWide redir", destinationTargetBase.c_str());
+#endif
+                    result.redirect_path = RedirectedPathV2(vfspathV2, flag_set(flags, redirect_flags::ensure_directory_structure), destinationTargetBase, inst);
+                    //if (impl::PathExists(result.redirect_path.filename().wstring().c_str()))
+                    if (impl::PathExists(result.redirect_path.c_str()))
+                    {
+                        result.doesRedirectedExist = true;
+                    }
+#if _DEBUG
+                    Log(L"[%d]\t\tFRFShouldRedirectV2: doesRedirectedExist=%d", inst, result.doesRedirectedExist);
+#endif       
                 }
-                else if (relativePath[0])
+                else
                 {
-                    // Otherwise, just a substring match (e.g. we're trying to match against 'foo' but input was 'foobar')
-                    continue;
-                }
-                // Otherwise exact match. Assume an implicit directory separator at the end (e.g. for matches to satisfy the
-                // first call to CreateDirectory
 #ifdef RULEDEBUG
-                LogString(inst, L"\t\t\tFRFShouldRedirectV2: relativePath",relativePath);
+                    Log(L"[%d]\t\t\tFRFShouldRedirectV2 CASE:match, not existing in package.", inst);
+#endif
+                    // If the folder above it exists, we might want to redirect anyway?
+                    //  EX: Folder has VFS\AppData\Vendor
+                    //  Request:       ...\AppData\Roaming                      Redirect yes (found above)
+                    //  Request:       ...\AppData\Roaming\Vendor               Redirect yes (found above)
+                    //  Request:       ...\AppData\Roaming\Vendor\foo           Redirect yes
+                    //  Request:       ...\AppData\Roaming\Vendor\foo\bar       Redirect currently yes, was no
+                    //  Request:       ...\AppData\Roaming\Vendor\foo\bar\now   Redirect currently yes, was no
+                    std::filesystem::path abs = pathVirtualizedV2.c_str();
+                    std::filesystem::path abs2vfsvarfolder = trim_absvfs2varfolder(abs);
+#ifdef RULEDEBUG
+                    LogString(inst, L"\t\t\tFRFShouldRedirectV2 check if parent folder is in package?", abs2vfsvarfolder.c_str());
 #endif
-                if (std::regex_match(relativePath, redirectSpec.pattern))
-                {
-                    if (redirectSpec.isExclusion)
+                    std::wstring rldPPath = TurnPathIntoRootLocalDevice(abs2vfsvarfolder.c_str());
+                    rldPPath = rldPPath.substr(0, rldPPath.find_last_of(L"\\"));
+                    if (PathExistsUsingPackageIndex(rldPPath.c_str()))
                     {
-                        // The impact on isExclusion is that redirection is not needed.
-                        result.should_redirect = false;
-#ifdef RULEDEBUG
-                        LogString(inst, L"\t\tFRFShouldRedirectV2 CASE:Exclusion for path", widen(path).c_str());
+#ifdef MOREDRULEDEBUGEBUG
+                        Log(L"[%d]\t\t\tFRFShouldRedirectV2 SUBCASE: parent-folder is in package.", inst);
 #endif
+                        if (flag_set(flags, redirect_flags::ok_if_parent_in_pkg))
+                        {
+                            result.doesPackageParentFolderExist = true;  // Needed for the destination on CopyFile and friends
+                        }
+                        destinationTargetBase = redirectSpec.redirect_targetbase;
+                        result.redirect_path = RedirectedPathV2(vfspathV2, flag_set(flags, redirect_flags::ensure_directory_structure), destinationTargetBase, inst);
+                        //if (impl::PathExists(result.redirect_path.filename().wstring().c_str()))
+                        if (impl::PathExists(result.redirect_path.c_str()))
+                        {
+                            result.doesRedirectedExist = true;
+                        }
+#if _DEBUG
+                        Log(L"[%d]\t\tFRFShouldRedirectV2: doesRedirectedExist=%d", inst, result.doesRedirectedExist);
+#endif       
                     }
                     else
                     {
-                        result.should_redirect = true;
-                        result.shouldReadonly = (redirectSpec.isReadOnly == true);
 
-                        // Check if file exists as VFS path in the package
-                        std::wstring rldPath = TurnPathIntoRootLocalDevice(pathVirtualizedV2.c_str());
-                        if (impl::PathExists(rldPath.c_str()))
-                        { 
+#ifdef DONTREDIRECTIFPARENTNOTINPACKAGE
+                        psf::dos_path_type origType = psf::path_type(path);
 #ifdef RULEDEBUG
-                            Log(L"[%d]\t\t\tFRFShouldRedirectV2 CASE:match, existing in package.", inst);
+                        Log(L"[%d]\t\t\tFRFShouldRedirectV2 Orig Type=0%x", inst, (int)origType);
 #endif
-                            result.vfs_path = rldPath.c_str();
-                            result.doesVFSExist = true;
-                            destinationTargetBase = redirectSpec.redirect_targetbase;
-
-#ifdef RULEDEBUG
-                            LogString(inst, L"\t\tFRFShouldRedirectV2 isWide for", pathVirtualizedV2.c_str());
-                            LogString(inst, L"\t\tFRFShouldRedirectV2 isWide redir", destinationTargetBase.c_str());
+                        if (origType == psf::dos_path_type::relative)
+                        {
+#ifdef MOREDEBUG
+                            Log(L"[%d]\t\t\tFRFShouldRedirectV2 SUBCASE: VFS var-folder is also not in package, but req was relative path, we should redirect.", inst);
 #endif
+                            destinationTargetBase = redirectSpec.redirect_targetbase;
                             result.redirect_path = RedirectedPathV2(vfspathV2, flag_set(flags, redirect_flags::ensure_directory_structure), destinationTargetBase, inst);
                             //if (impl::PathExists(result.redirect_path.filename().wstring().c_str()))
                             if (impl::PathExists(result.redirect_path.c_str()))
@@ -803,114 +666,42 @@ static path_redirect_info ShouldRedirectV2Impl(const CharT* path, redirect_flags
                         }
                         else
                         {
-#ifdef RULEDEBUG
-                            Log(L"[%d]\t\t\tFRFShouldRedirectV2 CASE:match, not existing in package.", inst);
-#endif
-                            // If the folder above it exists, we might want to redirect anyway?
-                            //  EX: Folder has VFS\AppData\Vendor
-                            //  Request:       ...\AppData\Roaming                      Redirect yes (found above)
-                            //  Request:       ...\AppData\Roaming\Vendor               Redirect yes (found above)
-                            //  Request:       ...\AppData\Roaming\Vendor\foo           Redirect yes
-                            //  Request:       ...\AppData\Roaming\Vendor\foo\bar       Redirect currently yes, was no
-                            //  Request:       ...\AppData\Roaming\Vendor\foo\bar\now   Redirect currently yes, was no
-                            std::filesystem::path abs = pathVirtualizedV2.c_str();
-                            std::filesystem::path abs2vfsvarfolder = trim_absvfs2varfolder(abs);
-#ifdef RULEDEBUG
-                            LogString(inst, L"\t\t\tFRFShouldRedirectV2 check if parent folder is in package?", abs2vfsvarfolder.c_str());
-#endif
-                            std::wstring rldPPath = TurnPathIntoRootLocalDevice(abs2vfsvarfolder.c_str());
-                            rldPPath = rldPPath.substr(0, rldPPath.find_last_of(L"\\"));
-                            if (impl::PathExists(rldPPath.c_str()))
-                            {
-#ifdef MOREDRULEDEBUGEBUG
-                                Log(L"[%d]\t\t\tFRFShouldRedirectV2 SUBCASE: parent-folder is in package.", inst);
-#endif
-                                if (flag_set(flags, redirect_flags::ok_if_parent_in_pkg))
-                                {
-                                    result.doesPackageParentFolderExist = true;  // Needed for the destination on CopyFile and friends
-                                }
-                                destinationTargetBase = redirectSpec.redirect_targetbase;
-                                result.redirect_path = RedirectedPathV2(vfspathV2, flag_set(flags, redirect_flags::ensure_directory_structure), destinationTargetBase, inst);
-                                //if (impl::PathExists(result.redirect_path.filename().wstring().c_str()))
-                                if (impl::PathExists(result.redirect_path.c_str()))
-                                {
-                                    result.doesRedirectedExist = true;
-                                }
-#if _DEBUG
-                                Log(L"[%d]\t\tFRFShouldRedirectV2: doesRedirectedExist=%d", inst, result.doesRedirectedExist);
-#endif       
-                            }
-                            else
-                            {
-
-#ifdef DONTREDIRECTIFPARENTNOTINPACKAGE
-                                psf::dos_path_type origType = psf::path_type(path);
-#ifdef RULEDEBUG
-                                Log(L"[%d]\t\t\tFRFShouldRedirectV2 Orig Type=0%x", inst, (int)origType);
-#endif
-                                if (origType == psf::dos_path_type::relative)
-                                {
-#ifdef MOREDEBUG
-                                    Log(L"[%d]\t\t\tFRFShouldRedirectV2 SUBCASE: VFS var-folder is also not in package, but req was relative path, we should redirect.", inst);
-#endif
-                                    destinationTargetBase = redirectSpec.redirect_targetbase;
-                                    result.redirect_path = RedirectedPathV2(vfspathV2, flag_set(flags, redirect_flags::ensure_directory_structure), destinationTargetBase, inst);
-                                    //if (impl::PathExists(result.redirect_path.filename().wstring().c_str()))
-                                    if (impl::PathExists(result.redirect_path.c_str()))
-                                    {
-                                        result.doesRedirectedExist = true;
-                                    }
-#if _DEBUG
-                                    Log(L"[%d]\t\tFRFShouldRedirectV2: doesRedirectedExist=%d", inst, result.doesRedirectedExist);
-#endif       
-                                }
-                                else
-                                {
 #ifdef MOREDEBUG
-                                    Log(L"[%d]\t\t\tFRFShouldRedirectV2 SUBCASE: VFS var-folder is also not in package, therefore we should NOT redirect.", inst);
+                            Log(L"[%d]\t\t\tFRFShouldRedirectV2 SUBCASE: VFS var-folder is also not in package, therefore we should NOT redirect.", inst);
 #endif
-                                    result.should_redirect = false;
-                                }
+                            result.should_redirect = false;
+                        }
 #else
 #ifdef MOREDEBUG
-                                Log(L"[%d]\t\t\tFRFShouldRedirectV2 SUBCASE: VFS var-folder is also not in package, but since rule exists we should redirect.", inst);
-#endif
-                                destinationTargetBase = redirectSpec.redirect_targetbase;
-                                result.redirect_path = RedirectedPath(vfspath, flag_set(flags, redirect_flags::ensure_directory_structure), destinationTargetBase, inst);
-                                //if (impl::PathExists(result.redirect_path.filename().wstring().c_str()))
-                                if (impl::PathExists(result.redirect_path.c_str()))
-                                {
-                                    result.doesRedirectedExist = true;
-                                }
-#if _DEBUG
-                                Log(L"[%d]\t\tFRFShouldRedirectV2: doesRedirectedExist=%d", inst, result.doesRedirectedExist);
-#endif       
+                        Log(L"[%d]\t\t\tFRFShouldRedirectV2 SUBCASE: VFS var-folder is also not in package, but since rule exists we should redirect.", inst);
 #endif
-                            }
-                        }
-                        if (result.should_redirect)
+                        destinationTargetBase = redirectSpec.redirect_targetbase;
+                        result.redirect_path = RedirectedPath(vfspath, flag_set(flags, redirect_flags::ensure_directory_structure), destinationTargetBase, inst);
+                        //if (impl::PathExists(result.redirect_path.filename().wstring().c_str()))
+                        if (impl::PathExists(result.redirect_path.c_str()))
                         {
-#ifdef RULEDEBUG
-                            LogString(inst, L"\t\tFRFShouldRedirectV2 CASE:match on redirect_path", result.redirect_path.c_str());
-#endif
+                            result.doesRedirectedExist = true;
                         }
+#if _DEBUG
+                        Log(L"[%d]\t\tFRFShouldRedirectV2: doesRedirectedExist=%d", inst, result.doesRedirectedExist);
+#endif       
+#endif
                     }
-                    break;
                 }
-                else
+                if (result.should_redirect)
                 {
 #ifdef RULEDEBUG
-                    LogString(inst, L"\t\tFRFShouldRedirectV2: no match on parse relativePath", relativePath);
+                    LogString(inst, L"\t\tFRFShouldRedirectV2 CASE:match on redirect_path", result.redirect_path.c_str());
 #endif
                 }
             }
-            else
-            {
+        }
 #ifdef RULEDEBUG
-                LogString(inst, L"\t\tFRFShouldRedirectV2: Not in ball park of base", redirectSpec.base_path.c_str());
-#endif
-            }
+        else
+        {
+            LogString(inst, L"\t\tFRFShouldRedirectV2: no matching rule for", pathVirtualizedV2.c_str());
         }
+#endif
 
 #ifdef RULEDEBUG
         Log(L"[%d]\t\tFRFShouldRedirectV2 post check 1", inst);
@@ -959,145 +750,292 @@ static path_redirect_info ShouldRedirectV2Impl(const CharT* path, redirect_flags
         Log(L"[%d]\t\tFRFShouldRedirectV2 post check 3", inst);
 #endif
 
-        if (flag_set(flags, redirect_flags::copy_file))
-        {
-#ifdef MOREDEBUG
-            Log(L"[%d]\t\tFRFShouldRedirectV2: copy_file flag is set", inst);
+#if _DEBUG
+        LogString(inst, L" \tFRFShouldRedirectV2: returns with result", result.redirect_path.c_str());
 #endif
-            [[maybe_unused]] BOOL copyResult = false;
-            if (result.doesRedirectedExist) //impl::PathExists(TurnPathIntoRootLocalDevice(widen(result.redirect_path).c_str()).c_str()))
-            {
+    }
+    catch (...)
+    {
+        Log(L"[%d]*****FRFShouldRedirectV2 Exeption!!", inst);
+        result.should_redirect = false;  // What else to do???
+        context.failed = true;
+    }
+    return result;
+}
+
+/// <summary>
+/// The copy_file part of a ShouldRedirectV2 request: unless the redirected copy already exists, copies the file that
+/// the request resolved to (in the package, or at the native path) to the redirected path, or creates the redirected
+/// folder for a folder. Returns true if it created anything.
+/// </summary>
+static bool CopyToRedirectedPath(const normalized_pathV2& normalizedPathV2, path_redirect_info& result, [[maybe_unused]] DWORD inst)
+{
+    bool created = false;
+    [[maybe_unused]] BOOL copyResult = false;
+    if (result.doesRedirectedExist) //impl::PathExists(TurnPathIntoRootLocalDevice(widen(result.redirect_path).c_str()).c_str()))
+    {
 #if _DEBUG
-                Log(L"[%d]\t\tFRFShouldRedirectV2: Found that a copy exists in the redirected area so we skip the folder creation.", inst);
+        Log(L"[%d]\t\tFRFShouldRedirectV2: Found that a copy exists in the redirected area so we skip the folder creation.", inst);
 #endif
-            }
-            else
-            {
-                std::filesystem::path CopySource = normalizedPathV2.drive_absolute_path.c_str();
+    }
+    else
+    {
+        std::filesystem::path CopySource = normalizedPathV2.drive_absolute_path.c_str();
 #ifdef MOREDEBUG
-                Log(L"[%d]\t\tFRFShouldRedirectV2 CopySource CheckA %s", inst, CopySource.c_str());
+        Log(L"[%d]\t\tFRFShouldRedirectV2 CopySource CheckA %s", inst, CopySource.c_str());
 #endif               
-                if (result.doesVFSExist) //impl::PathExists( TurnPathIntoRootLocalDevice(pathVirtualizedV2.c_str()).c_str() )
-                {
-                    CopySource = pathVirtualizedV2.c_str();
+        if (result.doesVFSExist) //impl::PathExists( TurnPathIntoRootLocalDevice(pathVirtualizedV2.c_str()).c_str() )
+        {
+            CopySource = result.vfs_path;
 #ifdef MOREDEBUG
-                    Log(L"[%d]\t\tFRFShouldRedirectV2 CopySource CheckB %s", inst, CopySource.c_str());
+            Log(L"[%d]\t\tFRFShouldRedirectV2 CopySource CheckB %s", inst, CopySource.c_str());
 #endif  
-                }
+        }
 
 #ifdef MOREDEBUG
-                std::wstring test = TurnPathIntoRootLocalDevice(CopySource.c_str());
-                Log(L"[%d]\t\tFRFShouldRedirectV2 CopySource CheckC %s", inst, test.c_str());
+        std::wstring test = TurnPathIntoRootLocalDevice(CopySource.c_str());
+        Log(L"[%d]\t\tFRFShouldRedirectV2 CopySource CheckC %s", inst, test.c_str());
 #endif  
-                auto attr = impl::GetFileAttributes(TurnPathIntoRootLocalDevice(CopySource.c_str()).c_str()); //normalizedPath.drive_absolute_path);
+        auto attr = impl::GetFileAttributes(TurnPathIntoRootLocalDevice(CopySource.c_str()).c_str()); //normalizedPath.drive_absolute_path);
 #ifdef MOREDEBUG
-                Log(L"[%d]\t\tFRFShouldRedirectV2 source %s attributes=0x%x", inst, CopySource.c_str(), attr);
+        Log(L"[%d]\t\tFRFShouldRedirectV2 source %s attributes=0x%x", inst, CopySource.c_str(), attr);
 #endif
-                if (attr != INVALID_FILE_ATTRIBUTES)
-                {
-                    if ((attr & FILE_ATTRIBUTE_DIRECTORY) != FILE_ATTRIBUTE_DIRECTORY)
-                    {
+        if (attr != INVALID_FILE_ATTRIBUTES)
+        {
+            if ((attr & FILE_ATTRIBUTE_DIRECTORY) != FILE_ATTRIBUTE_DIRECTORY)
+            {
 #ifdef MOREDEBUG
-                        Log(L"[%d]\tFRFShouldRedirectV2 we have a file to be copied to %ls", inst, result.redirect_path.c_str());
-#endif
-                        copyResult = impl::CopyFileEx(
-                            CopySource.c_str(), //normalizedPath.drive_absolute_path,
-                            result.redirect_path.c_str(),
-                            nullptr,
-                            nullptr,
-                            nullptr,
-                            COPY_FILE_FAIL_IF_EXISTS | COPY_FILE_NO_BUFFERING);
-                        if (copyResult)
-                        {
-                            result.doesRedirectedExist = true;
+                Log(L"[%d]\tFRFShouldRedirectV2 we have a file to be copied to %ls", inst, result.redirect_path.c_str());
+#endif
+                copyResult = impl::CopyFileEx(
+                    CopySource.c_str(), //normalizedPath.drive_absolute_path,
+                    result.redirect_path.c_str(),
+                    nullptr,
+                    nullptr,
+                    nullptr,
+                    COPY_FILE_FAIL_IF_EXISTS | COPY_FILE_NO_BUFFERING);
+                if (copyResult)
+                {
+                    result.doesRedirectedExist = true;
+                    created = true;
 #if _DEBUG
-                            LogString(inst, L"\t\tFRFShouldRedirectV2 CopyFile Success From", CopySource.c_str());
-                            LogString(inst, L"\t\tFRFShouldRedirectV2 CopyFile Success To", result.redirect_path.c_str());
+                    LogString(inst, L"\t\tFRFShouldRedirectV2 CopyFile Success From", CopySource.c_str());
+                    LogString(inst, L"\t\tFRFShouldRedirectV2 CopyFile Success To", result.redirect_path.c_str());
 #endif
-                        }
-                        else
-                        {
-                            //0x72 = ERROR_INVALID_TARGET_HANDLE
-                            auto err = ::GetLastError();
+                }
+                else
+                {
+                    //0x72 = ERROR_INVALID_TARGET_HANDLE
+                    auto err = ::GetLastError();
 #if _DEBUG
-                            Log("[%d]\t\tFRFShouldRedirectV2 CopyFile Fail=0x%x", inst, err);
-                            LogString(inst, L"\t\tFRFShouldRedirectV2 CopyFile Fail From", CopySource.c_str());
-                            LogString(inst, L"\t\tFRFShouldRedirectV2 CopyFile Fail To", result.redirect_path.c_str());
+                    Log("[%d]\t\tFRFShouldRedirectV2 CopyFile Fail=0x%x", inst, err);
+                    LogString(inst, L"\t\tFRFShouldRedirectV2 CopyFile Fail From", CopySource.c_str());
+                    LogString(inst, L"\t\tFRFShouldRedirectV2 CopyFile Fail To", result.redirect_path.c_str());
 #endif
-                            switch (err)
-                            {
-                            case ERROR_FILE_EXISTS:
+                    switch (err)
+                    {
+                    case ERROR_FILE_EXISTS:
 #if _DEBUG
-                                Log(L"[%d]\t\tFRFShouldRedirectV2  was ERROR_FILE_EXISTS", inst);
+                        Log(L"[%d]\t\tFRFShouldRedirectV2  was ERROR_FILE_EXISTS", inst);
 #endif
-                                break;
-                            case ERROR_PATH_NOT_FOUND:
+                        break;
+                    case ERROR_PATH_NOT_FOUND:
 #if _DEBUG
-                                Log(L"[%d]\t\tFRFShouldRedirectV2  was ERROR_PATH_NOT_FOUND", inst);
+                        Log(L"[%d]\t\tFRFShouldRedirectV2  was ERROR_PATH_NOT_FOUND", inst);
 #endif
-                                break;
-                            case ERROR_FILE_NOT_FOUND:
+                        break;
+                    case ERROR_FILE_NOT_FOUND:
 #if _DEBUG
-                                Log(L"[%d]\t\tFRFShouldRedirectV2  was ERROR_FILE_NOT_FOUND", inst);
+                        Log(L"[%d]\t\tFRFShouldRedirectV2  was ERROR_FILE_NOT_FOUND", inst);
 #endif
-                                break;
-                            case ERROR_ALREADY_EXISTS:
+                        break;
+                    case ERROR_ALREADY_EXISTS:
 #if _DEBUG
-                                Log(L"[%d]\t\tFRFShouldRedirectV2  was ERROR_ALREADY_EXISTS", inst);
+                        Log(L"[%d]\t\tFRFShouldRedirectV2  was ERROR_ALREADY_EXISTS", inst);
 #endif
-                                break;
-                            default:
+                        break;
+                    default:
 #if _DEBUG
-                                Log(L"[%d]\t\tFRFShouldRedirectV2 was 0x%x", inst, err);
+                        Log(L"[%d]\t\tFRFShouldRedirectV2 was 0x%x", inst, err);
 #endif
-                                break;
-                            }
-                        }
+                        break;
                     }
-                    else
-                    {
+                }
+            }
+            else
+            {
 #ifdef MOREDEBUG
-                        Log(L"[%d]\tFRFShouldRedirectV2 we have a directory to be copied to %ls.", inst, result.redirect_path.c_str());
-#endif
-                        copyResult = impl::CreateDirectoryEx(CopySource.c_str(), result.redirect_path.c_str(), nullptr);
-                        if (copyResult)
-                        {
-#if _DEBUG
-                            LogString(inst, L"\t\tFRFShouldRedirectV2 CreateDir Success From", CopySource.c_str());
-                            LogString(inst, L"\t\tFRFShouldRedirectV2 CreateDir Success To", result.redirect_path.c_str());
-#endif
-                        }
-                        else
-                        {
-#if _DEBUG
-                            Log("[%d]\t\tFRFShouldRedirectV2 CreateDir Fail=0x%x", inst, ::GetLastError());
-                            LogString(inst, L"\t\tFRFShouldRedirectV2 CreateDir Fail From", CopySource.c_str());
-                            LogString(inst, L"\t\tFRFShouldRedirectV2 CreateDir Fail To", result.redirect_path.c_str());
+                Log(L"[%d]\tFRFShouldRedirectV2 we have a directory to be copied to %ls.", inst, result.redirect_path.c_str());
 #endif
-                        }
+                copyResult = impl::CreateDirectoryEx(CopySource.c_str(), result.redirect_path.c_str(), nullptr);
+                if (copyResult)
+                {
+                    created = true;
 #if _DEBUG
-                        /////auto err = ::GetLastError();  // saw this happen with a redirected iconccache_32.db file.  Let's not crash!
-                        /////assert(copyResult || (err == ERROR_FILE_EXISTS) || (err == ERROR_PATH_NOT_FOUND) || (err == ERROR_FILE_NOT_FOUND) || (err == ERROR_ALREADY_EXISTS));
+                    LogString(inst, L"\t\tFRFShouldRedirectV2 CreateDir Success From", CopySource.c_str());
+                    LogString(inst, L"\t\tFRFShouldRedirectV2 CreateDir Success To", result.redirect_path.c_str());
 #endif
-                    }
                 }
                 else
                 {
-                    //There is no source to copy, so we just want to allow it to be created in the redirected area.
 #if _DEBUG
-                    LogString(inst,L"\t\tFRFShouldRedirectV2 there is no package file to be copied to",  result.redirect_path.c_str());
-#endif 
+                    Log("[%d]\t\tFRFShouldRedirectV2 CreateDir Fail=0x%x", inst, ::GetLastError());
+                    LogString(inst, L"\t\tFRFShouldRedirectV2 CreateDir Fail From", CopySource.c_str());
+                    LogString(inst, L"\t\tFRFShouldRedirectV2 CreateDir Fail To", result.redirect_path.c_str());
+#endif
                 }
+#if _DEBUG
+                /////auto err = ::GetLastError();  // saw this happen with a redirected iconccache_32.db file.  Let's not crash!
+                /////assert(copyResult || (err == ERROR_FILE_EXISTS) || (err == ERROR_PATH_NOT_FOUND) || (err == ERROR_FILE_NOT_FOUND) || (err == ERROR_ALREADY_EXISTS));
+#endif
             }
         }
+        else
+        {
+            //There is no source to copy, so we just want to allow it to be created in the redirected area.
+#if _DEBUG
+            LogString(inst,L"\t\tFRFShouldRedirectV2 there is no package file to be copied to",  result.redirect_path.c_str());
+#endif 
+        }
+    }
+    return created;
+}
+
+/// <summary>
+/// The ensure_directory_structure part of a ShouldRedirectV2 request: creates whichever of the folders above the
+/// redirected path do not exist yet. Returns true if it created any.
+/// </summary>
+static bool CreateRedirectedParentFolders(const std::wstring& redirectPath, [[maybe_unused]] DWORD inst)
+{
+    std::vector<std::wstring> missing;
+    std::wstring parent = redirectPath.substr(0, redirectPath.find_last_of(L"\\/"));
+    while (!parent.empty() && !impl::PathExists(parent.c_str()))
+    {
+        missing.push_back(parent);
+        auto pos = parent.find_last_of(L"\\/");
+        if ((pos == std::wstring::npos) || (pos == 0) || (parent[pos - 1] == L':'))
+        {
+            break;
+        }
+        parent.resize(pos);
+    }
+
+    bool created = false;
+    for (auto itr = missing.rbegin(); itr != missing.rend(); ++itr)
+    {
+        if (impl::CreateDirectory(itr->c_str(), nullptr))
+        {
+            created = true;
+        }
 #if _DEBUG
-        LogString(inst, L" \tFRFShouldRedirectV2: returns with result", result.redirect_path.c_str());
+        else if (::GetLastError() != ERROR_ALREADY_EXISTS)
+        {
+            Log(L"[%d]\t\tFRFShouldRedirectV2: CreateDirectory Fail=0x%x", inst, ::GetLastError());
+            LogString(inst, L"\t\tFRFShouldRedirectV2: CreateDirectory Fail for", itr->c_str());
+        }
+#endif
+    }
+    return created;
+}
+
+/// <summary>
+/// Each thread keeps its own cache of recent ShouldRedirectV2Impl decisions, so that repeated probes of the same path
+/// skip the rule scan and the file system existence checks. Entries are dropped when a fixup reports a change beneath
+/// one of the paths the decision depended upon (see redirection_change_scope).
+/// </summary>
+static psf::path_decision_cache<path_redirect_info>& RedirectionDecisionCache()
+{
+    thread_local psf::path_decision_cache<path_redirect_info> cache(g_redirectionChangeLog, g_redirectionDecisionCacheSize);
+    return cache;
+}
+
+template <typename CharT>
+static path_redirect_info ShouldRedirectV2Cached(const CharT* path, redirect_flags flags, DWORD inst)
+{
+    path_redirect_info result;
+
+    if (!path)
+    {
+        return result;
+    }
+#if _DEBUG
+    LogString(inst, L" \tFRFShouldRedirectV2: called for path", widen(path).c_str());
+    bool c_presense = flag_set(flags, redirect_flags::check_file_presence);
+    bool c_copy = flag_set(flags, redirect_flags::copy_file);
+    bool c_ensure = flag_set(flags, redirect_flags::ensure_directory_structure);
+    bool c_ok_if = flag_set(flags, redirect_flags::ok_if_parent_in_pkg);
+    Log(L"[%d]\t\tFRFShouldRedirectV2: flags  CheckPresense:%d  CopyFile:%d  EnsureDirectory:%d OkIfParent:%d", inst, c_presense, c_copy, c_ensure, c_ok_if);
+#endif
+    try
+    {
+        normalized_pathV2 normalizedPathV2 = NormalizePathV2(path, inst);
+
+        if (IsSpecialFile(path))
+        {
+#if _DEBUG
+            Log(L"[%d]\t\tFRFShouldRedirectV2: Request is a special file not subject to redirection.", inst);
+#endif
+            return result;
+        }
+
+        // The decision only reads the file system, so it is made (and cached) without the flags that ask for folders
+        // to be created or files copied; those are carried out below, on the new or cached decision alike.
+        redirect_flags decisionFlags = flags & ~redirect_flags::copy_on_read;
+        bool cacheable = (g_redirectionDecisionCacheSize > 0) && !normalizedPathV2.drive_absolute_path.empty();
+
+        // Whether the request was a relative path affects the decision too, so it is part of the key
+        std::uint32_t cacheFlags = static_cast<std::uint32_t>(decisionFlags);
+        if (psf::path_type(path) == psf::dos_path_type::relative)
+        {
+            cacheFlags |= 0x80000000;
+        }
+
+        auto& cache = RedirectionDecisionCache();
+        const path_redirect_info* cached = cacheable ? cache.find(normalizedPathV2.drive_absolute_path, cacheFlags) : nullptr;
+        if (cached)
+        {
+#if _DEBUG
+            LogString(inst, L" \tFRFShouldRedirectV2: cached result", cached->should_redirect ? cached->redirect_path.c_str() : L"no redirection");
 #endif
+            result = *cached;
+        }
+        else
+        {
+            auto observedSequence = cache.sequence();
+            redirect_decision_context context;
+            result = ShouldRedirectV2Impl(path, normalizedPathV2, decisionFlags, context, inst);
+
+            if (cacheable && !context.failed)
+            {
+                cache.insert(normalizedPathV2.drive_absolute_path, cacheFlags, result,
+                    { result.vfs_path.native(), result.redirect_path.native(), context.deVirtualizedPath },
+                    observedSequence);
+            }
+        }
+
+        if (result.should_redirect && !result.redirect_path.empty())
+        {
+            bool changed = false;
+            if (flag_set(flags, redirect_flags::ensure_directory_structure))
+            {
+                changed = CreateRedirectedParentFolders(result.redirect_path.native(), inst);
+            }
+            if (flag_set(flags, redirect_flags::copy_file) && CopyToRedirectedPath(normalizedPathV2, result, inst))
+            {
+                changed = true;
+            }
+
+            // Only an actual change affects other decisions; most copy_on_read requests find the copy already made
+            if (changed)
+            {
+                g_redirectionChangeLog.invalidate(result.redirect_path.native());
+            }
+        }
     }
     catch (...)
     {
         Log(L"[%d]*****FRFShouldRedirectV2 Exeption!!", inst);
-        result.should_redirect = false;  // What else to do???
+        result.should_redirect = false;
     }
     return result;
 }
@@ -1107,7 +1045,7 @@ path_redirect_info ShouldRedirectV2(const char* path, redirect_flags flags, DWOR
 #ifdef MOREDEBUG
     Log(L"[%d]\t\tFRFShouldRedirectV2 A", inst);
 #endif
-    return ShouldRedirectV2Impl(path, flags, inst);
+    return ShouldRedirectV2Cached(path, flags, inst);
 }
 
 path_redirect_info ShouldRedirectV2(const wchar_t* path, redirect_flags flags, DWORD inst)
@@ -1115,7 +1053,7 @@ path_redirect_info ShouldRedirectV2(const wchar_t* path, redirect_flags flags, D
 #ifdef MOREDEBUG
     Log(L"[%d]\t\tFRFShouldRedirectV2 W", inst);
 #endif
-    return ShouldRedirectV2Impl(path, flags, inst);
+    return ShouldRedirectV2Cached(path, flags, inst);
 }
 
 #pragma endregion
\ No newline at end of file
@@ -336,40 +336,14 @@ bool IsColonColonGuid(const wchar_t* path)
     return false;
 }
 
-bool IsBlobColon(const std::string path)
+bool IsBlobColon(std::string_view path)
 {
-    if (!path.empty())
-    {
-        size_t found = path.find("blob:", 0);
-        if (found == 0)
-        {
-            return true;
-        }
-        found = path.find("BLOB:", 0);
-        if (found == 0)
-        {
-            return true;
-        }
-    }
-    return false;
+    return path.substr(0, 5) == "blob:" || path.substr(0, 5) == "BLOB:";
 }
 
-bool IsBlobColon(const std::wstring path)
+bool IsBlobColon(std::wstring_view path)
 {
-    if (!path.empty())
-    {
-        size_t found = path.find(L"blob:", 0);
-        if (found == 0)
-        {
-            return true;
-        }
-        found = path.find(L"BLOB:", 0);
-        if (found == 0)
-        {
-            return true;
-        }
-    }
-    return false;
+    return path.substr(0, 5) == L"blob:" || path.substr(0, 5) == L"BLOB:";
 }
 #pragma endregion
 
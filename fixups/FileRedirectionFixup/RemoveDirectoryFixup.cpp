@@ -11,6 +11,7 @@ template <typename CharT>
 BOOL __stdcall RemoveDirectoryFixup(_In_ const CharT* pathName) noexcept
 {
     DWORD RemoveDirectoryInstance = ++g_FileIntceptInstance;
+    redirection_change_scope changes(pathName);
     auto guard = g_reentrancyGuard.enter();
     BOOL retfinal;
     try
@@ -27,6 +28,7 @@ BOOL __stdcall RemoveDirectoryFixup(_In_ const CharT* pathName) noexcept
                 // NOTE: See commentary in DeleteFileFixup for limitations on deleting files/directories
                 //auto [shouldRedirect, redirectPath, shouldReadonly, exist1, exist2] 
                 path_redirect_info  pri = ShouldRedirectV2(wPathName.c_str(), redirect_flags::check_file_presence | redirect_flags::ok_if_parent_in_pkg, RemoveDirectoryInstance);
+                changes.add(pri.redirect_path.c_str());
                 if (pri.should_redirect)
                 {
                     std::wstring rldPathName = TurnPathIntoRootLocalDevice(wPathName.c_str());
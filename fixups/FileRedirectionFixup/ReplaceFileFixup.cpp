@@ -21,6 +21,9 @@ BOOL __stdcall ReplaceFileFixup(
     _Reserved_ LPVOID reserved) noexcept
 {
     DWORD ReplaceFileInstance = ++g_FileIntceptInstance;
+    redirection_change_scope changes(replacedFileName);
+    changes.add(replacementFileName);
+    changes.add(backupFileName);
     auto guard = g_reentrancyGuard.enter();
     try
     {
@@ -42,9 +45,12 @@ BOOL __stdcall ReplaceFileFixup(
             //       effectively require that we re-write ReplaceFile, which we opt not to do right now. Also note that
             //       this implies that we have the same file deletion limitation that we have for DeleteFile, etc.
             path_redirect_info  priTarget = ShouldRedirectV2(replacedFileName, redirect_flags::check_file_presence | redirect_flags::copy_on_read | redirect_flags::ok_if_parent_in_pkg, ReplaceFileInstance);
+            changes.add(priTarget.redirect_path.c_str());
             //////path_redirect_info  priSource = ShouldRedirectV2(replacementFileName, redirect_flags::ensure_directory_structure, ReplaceFileInstance);
             path_redirect_info  priSource = ShouldRedirectV2(replacementFileName, redirect_flags::check_file_presence | redirect_flags::copy_on_read | redirect_flags::ensure_directory_structure | redirect_flags::ok_if_parent_in_pkg, ReplaceFileInstance);
+            changes.add(priSource.redirect_path.c_str());
             path_redirect_info  priBackup = ShouldRedirectV2(backupFileName, redirect_flags::ensure_directory_structure | redirect_flags::ok_if_parent_in_pkg, ReplaceFileInstance);
+            changes.add(priBackup.redirect_path.c_str());
 #if MOREDEBUG
             if (priTarget.should_redirect)
                 LogString(ReplaceFileInstance, L"ReplaceFileFixup RedirTarget ", priTarget.redirect_path.c_str());
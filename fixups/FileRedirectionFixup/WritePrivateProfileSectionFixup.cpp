@@ -14,6 +14,7 @@ BOOL __stdcall WritePrivateProfileSectionFixup(
     _In_opt_ const CharT* fileName) noexcept
 {
     DWORD WritePrivateProfileSectionInstance = ++g_FileIntceptInstance;
+    redirection_change_scope changes(fileName);
     auto guard = g_reentrancyGuard.enter();
     try
     {
@@ -26,6 +27,7 @@ BOOL __stdcall WritePrivateProfileSectionFixup(
                 if (!IsUnderUserAppDataLocalPackages(fileName))
                 {
                     path_redirect_info  pri = ShouldRedirectV2(fileName, redirect_flags::copy_on_read, WritePrivateProfileSectionInstance);
+                    changes.add(pri.redirect_path.c_str());
                     if (pri.should_redirect)
                     {
                         if constexpr (psf::is_ansi<CharT>)
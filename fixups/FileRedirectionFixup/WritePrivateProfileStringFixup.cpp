@@ -15,6 +15,7 @@ BOOL __stdcall WritePrivateProfileStringFixup(
     _In_opt_ const CharT* fileName) noexcept
 {
     DWORD WritePrivateProfileStringInstance = ++g_FileIntceptInstance;
+    redirection_change_scope changes(fileName);
     auto guard = g_reentrancyGuard.enter();
     try
     {
@@ -27,6 +28,7 @@ BOOL __stdcall WritePrivateProfileStringFixup(
                 if (!IsUnderUserAppDataLocalPackages(fileName))
                 {
                     path_redirect_info  pri = ShouldRedirectV2(fileName, redirect_flags::copy_on_read, WritePrivateProfileStringInstance);
+                    changes.add(pri.redirect_path.c_str());
                     if (pri.should_redirect)
                     {
                         if constexpr (psf::is_ansi<CharT>)
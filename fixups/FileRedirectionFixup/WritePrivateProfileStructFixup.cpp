@@ -16,6 +16,7 @@ BOOL __stdcall WritePrivateProfileStructFixup(
     _In_opt_ const CharT* fileName) noexcept
 {
     DWORD WritePrivateProfileStructInstance = ++g_FileIntceptInstance;
+    redirection_change_scope changes(fileName);
     auto guard = g_reentrancyGuard.enter();
     try
     {
@@ -28,6 +29,7 @@ BOOL __stdcall WritePrivateProfileStructFixup(
                 if (!IsUnderUserAppDataLocalPackages(fileName))
                 {
                     path_redirect_info  pri = ShouldRedirectV2(fileName, redirect_flags::copy_on_read, WritePrivateProfileStructInstance);
+                    changes.add(pri.redirect_path.c_str());
                     if (pri.should_redirect)
                     {
                         if constexpr (psf::is_ansi<CharT>)
@@ -8,12 +8,16 @@
 
 void InitializePaths();
 void InitializeConfiguration();
+void LogRedirectionDecisionCacheStatistics();
 
 extern "C" {
 
 int __stdcall PSFInitialize() noexcept try
 {
-    InitializeConfiguration();
+    {
+        psf::timeline_span span("FileRedirectionFixup configuration");
+        InitializeConfiguration();
+    }
 #if _DEBUG
     int count = psf::attach_count_all();
     Log(L"[0] FileRedirectionFixup attaches %d fixups.", count);
@@ -29,6 +33,7 @@ catch (...)
 
 int __stdcall PSFUninitialize() noexcept try
 {
+    LogRedirectionDecisionCacheStatistics();
     psf::detach_all();
     return ERROR_SUCCESS;
 }
@@ -52,6 +57,7 @@ BOOL __stdcall DllMain(HINSTANCE, DWORD reason, LPVOID) noexcept try
 #ifdef _DEBUG
         ::OutputDebugStringA("FileRedirectionFixup attached");
 #endif
+        psf::timeline_span span("FileRedirectionFixup paths");
         InitializePaths();
     }
 
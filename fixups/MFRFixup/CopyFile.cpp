@@ -19,11 +19,11 @@
 #include "DetermineCohorts.h"
 #include "DetermineIlvPaths.h"
 
-BOOL WRAPPER_WORKAROUND(std::wstring existingFileWs, std::wstring newFileWs, BOOL failIfExists, [[maybe_unused]] bool debug, bool moredebug, DWORD dllInstance)
+BOOL WRAPPER_WORKAROUND(psf::wzstring_view existingFileWs, psf::wzstring_view newFileWs, BOOL failIfExists, [[maybe_unused]] bool debug, bool moredebug, DWORD dllInstance)
 {
     BOOL retfinal = FALSE;
-    std::wstring LongExistingFileWs = MakeLongPath(existingFileWs);
-    std::wstring LongNewFileWs = MakeLongPath(newFileWs);
+    long_path LongExistingFileWs(existingFileWs);
+    long_path LongNewFileWs(newFileWs);
     if (moredebug)
     {
         LogString(dllInstance, L"CopyFileFixup: WrapperWorkaround: Actual From", LongExistingFileWs.c_str());
@@ -79,11 +79,11 @@ BOOL WRAPPER_WORKAROUND(std::wstring existingFileWs, std::wstring newFileWs, BOO
     return retfinal;
 }
 
-BOOL  WRAPPER_COPYFILE(std::wstring existingFileWs, std::wstring newFileWs, BOOL failIfExists, bool debug, bool moredebug, DWORD dllInstance)
+BOOL  WRAPPER_COPYFILE(psf::wzstring_view existingFileWs, psf::wzstring_view newFileWs, BOOL failIfExists, bool debug, bool moredebug, DWORD dllInstance)
 {
     BOOL retfinal;
-    std::wstring LongExistingFileWs = MakeLongPath(existingFileWs);
-    std::wstring LongNewFileWs = MakeLongPath(newFileWs);
+    long_path LongExistingFileWs(existingFileWs);
+    long_path LongNewFileWs(newFileWs);
 
     if (moredebug)
     {
@@ -106,7 +106,7 @@ BOOL  WRAPPER_COPYFILE(std::wstring existingFileWs, std::wstring newFileWs, BOOL
             if (initialError == ERROR_CANT_ACCESS_FILE)
             {
 #if TRIED_DIDNOT_HELP
-                retfinal = WRAPPER_WORKAROUND(LongExistingFileWs, LongNewFileWs, failIfExists, debug, moredebug, dllInstance);
+                retfinal = WRAPPER_WORKAROUND(LongExistingFileWs.c_str(), LongNewFileWs.c_str(), failIfExists, debug, moredebug, dllInstance);
 #endif
             }
         }
@@ -152,11 +152,11 @@ BOOL __stdcall CopyFileFixup(_In_ const CharT* existingFileName, _In_ const Char
 #endif
             std::wstring wExistingFileName = widen(existingFileName);
             std::wstring wNewFileName = widen(newFileName);
-            wExistingFileName = AdjustSlashes(wExistingFileName);
-            wNewFileName = AdjustSlashes(wNewFileName);
+            wExistingFileName = AdjustSlashes(std::move(wExistingFileName));
+            wNewFileName = AdjustSlashes(std::move(wNewFileName));
 
-            wExistingFileName = AdjustBadUNC(wExistingFileName, dllInstance, L"CopyFileFixup (existing)");
-            wNewFileName = AdjustBadUNC(wNewFileName, dllInstance, L"CopyFileFixup (new)");
+            wExistingFileName = AdjustBadUNC(std::move(wExistingFileName), dllInstance, L"CopyFileFixup (existing)");
+            wNewFileName = AdjustBadUNC(std::move(wNewFileName), dllInstance, L"CopyFileFixup (new)");
             
 
             // This get is inheirently a write operation in all cases.
@@ -173,7 +173,7 @@ BOOL __stdcall CopyFileFixup(_In_ const CharT* existingFileName, _In_ const Char
                 switch (cohortsNew.file_mfr.Request_MfrPathType)
                 {
                 case mfr::mfr_path_types::in_native_area:
-                    if (cohortsNew.map.Valid_mapping && !cohortsNew.map.IsAnExclusionToRedirect)
+                    if (cohortsNew.map->Valid_mapping && !cohortsNew.map->IsAnExclusionToRedirect)
                     {
                         newFileWsRedirected = cohortsNew.WsRedirected;
                         PreCreateFolders(newFileWsRedirected, dllInstance, L"CopyFileFixup");
@@ -184,7 +184,7 @@ BOOL __stdcall CopyFileFixup(_In_ const CharT* existingFileName, _In_ const Char
                     }
                     break;
                 case mfr::mfr_path_types::in_package_pvad_area:
-                    if (cohortsNew.map.Valid_mapping && !cohortsNew.map.IsAnExclusionToRedirect)
+                    if (cohortsNew.map->Valid_mapping && !cohortsNew.map->IsAnExclusionToRedirect)
                     {
                         newFileWsRedirected = cohortsNew.WsRedirected;
                         PreCreateFolders(newFileWsRedirected, dllInstance, L"CopyFileFixup");
@@ -195,7 +195,7 @@ BOOL __stdcall CopyFileFixup(_In_ const CharT* existingFileName, _In_ const Char
                     }
                     break;
                 case mfr::mfr_path_types::in_package_vfs_area:
-                    if (cohortsNew.map.Valid_mapping && !cohortsNew.map.IsAnExclusionToRedirect)
+                    if (cohortsNew.map->Valid_mapping && !cohortsNew.map->IsAnExclusionToRedirect)
                     {
                         newFileWsRedirected = cohortsNew.WsRedirected;
                         PreCreateFolders(newFileWsRedirected, dllInstance, L"CopyFileFixup");
@@ -206,7 +206,7 @@ BOOL __stdcall CopyFileFixup(_In_ const CharT* existingFileName, _In_ const Char
                     }
                     break;
                 case mfr::mfr_path_types::in_redirection_area_writablepackageroot:
-                    if (cohortsNew.map.Valid_mapping && !cohortsNew.map.IsAnExclusionToRedirect)
+                    if (cohortsNew.map->Valid_mapping && !cohortsNew.map->IsAnExclusionToRedirect)
                     {
                         newFileWsRedirected = cohortsNew.WsRedirected;
                         PreCreateFolders(newFileWsRedirected, dllInstance, L"CopyFileFixup");
@@ -244,11 +244,11 @@ BOOL __stdcall CopyFileFixup(_In_ const CharT* existingFileName, _In_ const Char
                 switch (cohortsExisting.file_mfr.Request_MfrPathType)
                 {
                 case mfr::mfr_path_types::in_native_area:
-                    if (cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local &&
-                        cohortsExisting.map.Valid_mapping)
+                    if (cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local &&
+                        cohortsExisting.map->Valid_mapping)
                     {
                         // try the request path, which must be the local redirected version by definition, and then a package equivalent, or make original call to fail.
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             PreCreateFolders(newFileWsRedirected.c_str(), dllInstance, L"CopyFileFixup");
                             retfinal = WRAPPER_COPYFILE(cohortsExisting.WsRedirected, newFileWsRedirected, failIfExists, debug, moredebug, dllInstance);
@@ -267,12 +267,12 @@ BOOL __stdcall CopyFileFixup(_In_ const CharT* existingFileName, _In_ const Char
                             return retfinal;
                         }
                     }
-                    else if ((cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
-                        cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs) &&
-                        cohortsExisting.map.Valid_mapping)
+                    else if ((cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
+                        cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs) &&
+                        cohortsExisting.map->Valid_mapping)
                     {
                         // try the redirected path, then package, then native, or let fail using original.
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             PreCreateFolders(newFileWsRedirected.c_str(), dllInstance, L"CopyFileFixup");
                             retfinal = WRAPPER_COPYFILE(cohortsExisting.WsRedirected, newFileWsRedirected, failIfExists, debug, moredebug, dllInstance);
@@ -300,10 +300,10 @@ BOOL __stdcall CopyFileFixup(_In_ const CharT* existingFileName, _In_ const Char
                     }
                     break;
                 case mfr::mfr_path_types::in_package_pvad_area:
-                    if (cohortsExisting.map.Valid_mapping)
+                    if (cohortsExisting.map->Valid_mapping)
                     {
                         //// try the redirected path, then package (COW), then don't need native.
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             PreCreateFolders(newFileWsRedirected.c_str(), dllInstance, L"CopyFileFixup");
                             retfinal = WRAPPER_COPYFILE(cohortsExisting.WsRedirected, newFileWsRedirected, failIfExists, debug, moredebug, dllInstance);
@@ -324,9 +324,9 @@ BOOL __stdcall CopyFileFixup(_In_ const CharT* existingFileName, _In_ const Char
                     }
                     break;
                 case mfr::mfr_path_types::in_package_vfs_area:
-                    if (cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local &&
-                        cohortsExisting.map.Valid_mapping &&
-                        !cohortsExisting.map.IsAnExclusionToRedirect)
+                    if (cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local &&
+                        cohortsExisting.map->Valid_mapping &&
+                        !cohortsExisting.map->IsAnExclusionToRedirect)
                     {
 #if MOREDEBUG
                         Log(L"[%d] CopyFileFixup: from VFS with prefer local redirection on source", dllInstance);
@@ -395,15 +395,15 @@ BOOL __stdcall CopyFileFixup(_In_ const CharT* existingFileName, _In_ const Char
                             }
                         }
                     }
-                    else if ((cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
-                        cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs) &&
-                        cohortsExisting.map.Valid_mapping)
+                    else if ((cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
+                        cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs) &&
+                        cohortsExisting.map->Valid_mapping)
                     {
 #if MOREDEBUG
                         Log(L"[%d] CopyFileFixup: from VFS with prefer traditional redirection on source", dllInstance);
 #endif
                         // try the redirection path, then the package (COW), then native (possibly COW)
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             PreCreateFolders(newFileWsRedirected.c_str(), dllInstance, L"CopyFileFixup");
                             retfinal = WRAPPER_COPYFILE(cohortsExisting.WsRedirected, newFileWsRedirected, failIfExists, debug, moredebug, dllInstance);
@@ -431,10 +431,10 @@ BOOL __stdcall CopyFileFixup(_In_ const CharT* existingFileName, _In_ const Char
                     }
                     break;
                 case mfr::mfr_path_types::in_redirection_area_writablepackageroot:
-                    if (cohortsExisting.map.Valid_mapping)
+                    if (cohortsExisting.map->Valid_mapping)
                     {
                         // try the redirected path, then package (COW), then possibly native (Possibly COW).
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             PreCreateFolders(newFileWsRedirected.c_str(), dllInstance, L"CopyFileFixup");
                             retfinal = WRAPPER_COPYFILE(cohortsExisting.WsRedirected, newFileWsRedirected, failIfExists, debug, moredebug, dllInstance);
@@ -22,8 +22,8 @@
 
 #define  WRAPPER_COPYFILE2(existingFileWs, newFileWs, extendedParameters, debug, moredebug) \
     { \
-        std::wstring LongExistingFileWs = MakeLongPath(existingFileWs); \
-        std::wstring LongNewFileWs = MakeLongPath(newFileWs); \
+        long_path LongExistingFileWs(existingFileWs); \
+        long_path LongNewFileWs(newFileWs); \
         retfinal = impl::CopyFile2(LongExistingFileWs.c_str(), LongNewFileWs.c_str(), extendedParameters); \
         if (moredebug) \
         { \
@@ -72,11 +72,11 @@ HRESULT __stdcall CopyFile2Fixup(
 #endif
             std::wstring wExistingFileName = widen(existingFileName);
             std::wstring wNewFileName = widen(newFileName);
-            wExistingFileName = AdjustSlashes(wExistingFileName);
-            wNewFileName = AdjustSlashes(wNewFileName);
+            wExistingFileName = AdjustSlashes(std::move(wExistingFileName));
+            wNewFileName = AdjustSlashes(std::move(wNewFileName));
 
-            wExistingFileName = AdjustBadUNC(wExistingFileName, dllInstance, L"CopyFile2Fixup (existing)");
-            wNewFileName = AdjustBadUNC(wNewFileName, dllInstance, L"CopyFile2Fixup (new)");
+            wExistingFileName = AdjustBadUNC(std::move(wExistingFileName), dllInstance, L"CopyFile2Fixup (existing)");
+            wNewFileName = AdjustBadUNC(std::move(wNewFileName), dllInstance, L"CopyFile2Fixup (new)");
 
 
 
@@ -96,7 +96,7 @@ HRESULT __stdcall CopyFile2Fixup(
                 switch (cohortsNew.file_mfr.Request_MfrPathType)
                 {
                 case mfr::mfr_path_types::in_native_area:
-                    if (cohortsNew.map.Valid_mapping && !cohortsNew.map.IsAnExclusionToRedirect)
+                    if (cohortsNew.map->Valid_mapping && !cohortsNew.map->IsAnExclusionToRedirect)
                     {
                         newFileWsRedirected = cohortsNew.WsRedirected;
                         // TODO: CopyFile precreates folders here, why not CopyFIle2? and other cases
@@ -108,7 +108,7 @@ HRESULT __stdcall CopyFile2Fixup(
                     }
                     break;
                 case mfr::mfr_path_types::in_package_pvad_area:
-                    if (cohortsNew.map.Valid_mapping && !cohortsNew.map.IsAnExclusionToRedirect)
+                    if (cohortsNew.map->Valid_mapping && !cohortsNew.map->IsAnExclusionToRedirect)
                     {
                         newFileWsRedirected = cohortsNew.WsRedirected;
                     }
@@ -118,7 +118,7 @@ HRESULT __stdcall CopyFile2Fixup(
                     }
                     break;
                 case mfr::mfr_path_types::in_package_vfs_area:
-                    if (cohortsNew.map.Valid_mapping && !cohortsNew.map.IsAnExclusionToRedirect)
+                    if (cohortsNew.map->Valid_mapping && !cohortsNew.map->IsAnExclusionToRedirect)
                     {
                         newFileWsRedirected = cohortsNew.WsRedirected;
                     }
@@ -128,7 +128,7 @@ HRESULT __stdcall CopyFile2Fixup(
                     }
                     break;
                 case mfr::mfr_path_types::in_redirection_area_writablepackageroot:
-                    if (cohortsNew.map.Valid_mapping && !cohortsNew.map.IsAnExclusionToRedirect)
+                    if (cohortsNew.map->Valid_mapping && !cohortsNew.map->IsAnExclusionToRedirect)
                     {
                         newFileWsRedirected = cohortsNew.WsRedirected;
                     }
@@ -159,11 +159,11 @@ HRESULT __stdcall CopyFile2Fixup(
                 switch (cohortsExisting.file_mfr.Request_MfrPathType)
                 {
                 case mfr::mfr_path_types::in_native_area:
-                    if (cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local &&
-                        cohortsExisting.map.Valid_mapping)
+                    if (cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local &&
+                        cohortsExisting.map->Valid_mapping)
                     {
                         // try the request path, which must be the local redirected version by definition, and then a package equivalent, or make original call to fail.
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             PreCreateFolders(newFileWsRedirected.c_str(), dllInstance, L"CopyFile2Fixup");
                             WRAPPER_COPYFILE2(cohortsExisting.WsRedirected, newFileWsRedirected, extendedParameters, debug, moredebug);
@@ -179,12 +179,12 @@ HRESULT __stdcall CopyFile2Fixup(
                             WRAPPER_COPYFILE2(cohortsExisting.WsRequested, newFileWsRedirected, extendedParameters, debug, moredebug);
                         }
                     }
-                    else if ((cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
-                        cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs) &&
-                        cohortsExisting.map.Valid_mapping)
+                    else if ((cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
+                        cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs) &&
+                        cohortsExisting.map->Valid_mapping)
                     {
                         // try the redirected path, then package, then native, or let fail using original.
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             PreCreateFolders(newFileWsRedirected.c_str(), dllInstance, L"CopyFile2Fixup");
                             WRAPPER_COPYFILE2(cohortsExisting.WsRedirected, newFileWsRedirected, extendedParameters, debug, moredebug);
@@ -208,10 +208,10 @@ HRESULT __stdcall CopyFile2Fixup(
                     }
                     break;
                 case mfr::mfr_path_types::in_package_pvad_area:
-                    if (cohortsExisting.map.Valid_mapping)
+                    if (cohortsExisting.map->Valid_mapping)
                     {
                         //// try the redirected path, then package (COW), then don't need native.
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             PreCreateFolders(newFileWsRedirected.c_str(), dllInstance, L"CopyFile2Fixup");
                             WRAPPER_COPYFILE2(cohortsExisting.WsRedirected, newFileWsRedirected, extendedParameters, debug, moredebug);
@@ -229,11 +229,11 @@ HRESULT __stdcall CopyFile2Fixup(
                     }
                     break;
                 case mfr::mfr_path_types::in_package_vfs_area:
-                    if (cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local &&
-                        cohortsExisting.map.Valid_mapping)
+                    if (cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local &&
+                        cohortsExisting.map->Valid_mapping)
                     {
                         // try the redirection path, then the package (COW).
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             PreCreateFolders(newFileWsRedirected.c_str(), dllInstance, L"CopyFile2Fixup");
                             WRAPPER_COPYFILE2(cohortsExisting.WsRedirected, newFileWsRedirected, extendedParameters, debug, moredebug);
@@ -249,12 +249,12 @@ HRESULT __stdcall CopyFile2Fixup(
                             WRAPPER_COPYFILE2(cohortsExisting.WsRequested, newFileWsRedirected, extendedParameters, debug, moredebug);
                         }
                     }
-                    else if ((cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
-                        cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs) &&
-                        cohortsExisting.map.Valid_mapping)
+                    else if ((cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
+                        cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs) &&
+                        cohortsExisting.map->Valid_mapping)
                     {
                         // try the redirection path, then the package (COW), then native (possibly COW)
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             PreCreateFolders(newFileWsRedirected.c_str(), dllInstance, L"CopyFile2Fixup");
                             WRAPPER_COPYFILE2(cohortsExisting.WsRedirected, newFileWsRedirected, extendedParameters, debug, moredebug);
@@ -278,10 +278,10 @@ HRESULT __stdcall CopyFile2Fixup(
                     }
                     break;
                 case mfr::mfr_path_types::in_redirection_area_writablepackageroot:
-                    if (cohortsExisting.map.Valid_mapping)
+                    if (cohortsExisting.map->Valid_mapping)
                     {
                         // try the redirected path, then package (COW), then possibly native (Possibly COW).
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             PreCreateFolders(newFileWsRedirected.c_str(), dllInstance, L"CopyFile2Fixup");
                             WRAPPER_COPYFILE2(cohortsExisting.WsRedirected, newFileWsRedirected, extendedParameters, debug, moredebug);
@@ -22,8 +22,8 @@
 
 #define  WRAPPER_COPYFILEEX(existingFileWs, newFileWs, dwCopyFlags, debug, moredebug) \
     { \
-        std::wstring LongExistingFileWs = MakeLongPath(existingFileWs); \
-        std::wstring LongNewFileWs = MakeLongPath(newFileWs); \
+        long_path LongExistingFileWs(existingFileWs); \
+        long_path LongNewFileWs(newFileWs); \
         retfinal = impl::CopyFileEx(LongExistingFileWs.c_str(), LongNewFileWs.c_str(), progressRoutine, data, cancel, dwCopyFlags); \
         if (moredebug) \
         { \
@@ -78,11 +78,11 @@ BOOL __stdcall CopyFileExFixup(
 #endif
             std::wstring wExistingFileName = widen(existingFileName);
             std::wstring wNewFileName = widen(newFileName);
-            wExistingFileName = AdjustSlashes(wExistingFileName);
-            wNewFileName = AdjustSlashes(wNewFileName);
+            wExistingFileName = AdjustSlashes(std::move(wExistingFileName));
+            wNewFileName = AdjustSlashes(std::move(wNewFileName));
 
-            wExistingFileName = AdjustBadUNC(wExistingFileName, dllInstance, L"CopyFileExFixup (existing)");
-            wNewFileName = AdjustBadUNC(wNewFileName, dllInstance, L"CopyFileExFixup (new)");
+            wExistingFileName = AdjustBadUNC(std::move(wExistingFileName), dllInstance, L"CopyFileExFixup (existing)");
+            wNewFileName = AdjustBadUNC(std::move(wNewFileName), dllInstance, L"CopyFileExFixup (new)");
 
 
 
@@ -101,7 +101,7 @@ BOOL __stdcall CopyFileExFixup(
                 switch (cohortsNew.file_mfr.Request_MfrPathType)
                 {
                 case mfr::mfr_path_types::in_native_area:
-                    if (cohortsNew.map.Valid_mapping && !cohortsNew.map.IsAnExclusionToRedirect)
+                    if (cohortsNew.map->Valid_mapping && !cohortsNew.map->IsAnExclusionToRedirect)
                     {
                         newFileWsRedirected = cohortsNew.WsRedirected;
                     }
@@ -111,7 +111,7 @@ BOOL __stdcall CopyFileExFixup(
                     }
                     break;
                 case mfr::mfr_path_types::in_package_pvad_area:
-                    if (cohortsNew.map.Valid_mapping && !cohortsNew.map.IsAnExclusionToRedirect)
+                    if (cohortsNew.map->Valid_mapping && !cohortsNew.map->IsAnExclusionToRedirect)
                     {
                         newFileWsRedirected = cohortsNew.WsRedirected;
                     }
@@ -121,7 +121,7 @@ BOOL __stdcall CopyFileExFixup(
                     }
                     break;
                 case mfr::mfr_path_types::in_package_vfs_area:
-                    if (cohortsNew.map.Valid_mapping && !cohortsNew.map.IsAnExclusionToRedirect)
+                    if (cohortsNew.map->Valid_mapping && !cohortsNew.map->IsAnExclusionToRedirect)
                     {
                         newFileWsRedirected = cohortsNew.WsRedirected;
                         // TODO: CopyFile precreates folders here, why not CopyFileEx? and other cases
@@ -133,7 +133,7 @@ BOOL __stdcall CopyFileExFixup(
                     }
                     break;
                 case mfr::mfr_path_types::in_redirection_area_writablepackageroot:
-                    if (cohortsNew.map.Valid_mapping && !cohortsNew.map.IsAnExclusionToRedirect)
+                    if (cohortsNew.map->Valid_mapping && !cohortsNew.map->IsAnExclusionToRedirect)
                     {
                         newFileWsRedirected = cohortsNew.WsRedirected;
                     }
@@ -163,11 +163,11 @@ BOOL __stdcall CopyFileExFixup(
                 switch (cohortsExisting.file_mfr.Request_MfrPathType)
                 {
                 case mfr::mfr_path_types::in_native_area:
-                    if (cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local &&
-                        cohortsExisting.map.Valid_mapping)
+                    if (cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local &&
+                        cohortsExisting.map->Valid_mapping)
                     {
                         // try the request path, which must be the local redirected version by definition, and then a package equivalent, or make original call to fail.
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             PreCreateFolders(newFileWsRedirected.c_str(), dllInstance, L"CopyFileExFixup");
                             WRAPPER_COPYFILEEX(cohortsExisting.WsRedirected, newFileWsRedirected, copyFlags, debug, moredebug);
@@ -184,12 +184,12 @@ BOOL __stdcall CopyFileExFixup(
                             WRAPPER_COPYFILEEX(cohortsExisting.WsRequested, newFileWsRedirected, copyFlags, debug, moredebug);
                         }
                     }
-                    else if ((cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
-                        cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs) &&
-                        cohortsExisting.map.Valid_mapping)
+                    else if ((cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
+                        cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs) &&
+                        cohortsExisting.map->Valid_mapping)
                     {
                         // try the redirected path, then package, then native, or let fail using original.
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             PreCreateFolders(newFileWsRedirected.c_str(), dllInstance, L"CopyFileExFixup");
                             WRAPPER_COPYFILEEX(cohortsExisting.WsRedirected, newFileWsRedirected, copyFlags, debug, moredebug);
@@ -213,10 +213,10 @@ BOOL __stdcall CopyFileExFixup(
                     }
                     break;
                 case mfr::mfr_path_types::in_package_pvad_area:
-                    if (cohortsExisting.map.Valid_mapping)
+                    if (cohortsExisting.map->Valid_mapping)
                     {
                         //// try the redirected path, then package (COW), then don't need native.
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             PreCreateFolders(newFileWsRedirected.c_str(), dllInstance, L"CopyFileExFixup");
                             WRAPPER_COPYFILEEX(cohortsExisting.WsRedirected, newFileWsRedirected, copyFlags, debug, moredebug);
@@ -234,11 +234,11 @@ BOOL __stdcall CopyFileExFixup(
                     }
                     break;
                 case mfr::mfr_path_types::in_package_vfs_area:
-                    if (cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local &&
-                        cohortsExisting.map.Valid_mapping)
+                    if (cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local &&
+                        cohortsExisting.map->Valid_mapping)
                     {
                         // try the redirection path, then the package (COW).
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             PreCreateFolders(newFileWsRedirected.c_str(), dllInstance, L"CopyFileExFixup");
                             WRAPPER_COPYFILEEX(cohortsExisting.WsRedirected, newFileWsRedirected, copyFlags, debug, moredebug);
@@ -254,12 +254,12 @@ BOOL __stdcall CopyFileExFixup(
                             WRAPPER_COPYFILEEX(cohortsExisting.WsRequested, newFileWsRedirected, copyFlags, debug, moredebug);
                         }
                     }
-                    else if ((cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
-                        cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs) &&
-                        cohortsExisting.map.Valid_mapping)
+                    else if ((cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
+                        cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs) &&
+                        cohortsExisting.map->Valid_mapping)
                     {
                         // try the redirection path, then the package (COW), then native (possibly COW)
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             PreCreateFolders(newFileWsRedirected.c_str(), dllInstance, L"CopyFileExFixup");
                             WRAPPER_COPYFILEEX(cohortsExisting.WsRedirected, newFileWsRedirected, copyFlags, debug, moredebug);
@@ -283,10 +283,10 @@ BOOL __stdcall CopyFileExFixup(
                     }
                     break;
                 case mfr::mfr_path_types::in_redirection_area_writablepackageroot:
-                    if (cohortsExisting.map.Valid_mapping)
+                    if (cohortsExisting.map->Valid_mapping)
                     {
                         // try the redirected path, then package (COW), then possibly native (Possibly COW).
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             PreCreateFolders(newFileWsRedirected.c_str(), dllInstance, L"CopyExFileFixup");
                             WRAPPER_COPYFILEEX(cohortsExisting.WsRedirected, newFileWsRedirected, copyFlags, debug, moredebug);
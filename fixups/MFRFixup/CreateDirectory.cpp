@@ -52,9 +52,9 @@
 //#define MOREDEBUG 1
 #endif
 
-BOOL  WRAPPER_CREATEDIRECTORY(std::wstring theDestinationDirectory, LPSECURITY_ATTRIBUTES securityAttributes, DWORD dllInstance, bool debug)
+BOOL  WRAPPER_CREATEDIRECTORY(psf::wzstring_view theDestinationDirectory, LPSECURITY_ATTRIBUTES securityAttributes, DWORD dllInstance, bool debug)
 {
-    std::wstring LongDestinationDirectory = MakeLongPath(theDestinationDirectory);
+    long_path LongDestinationDirectory(theDestinationDirectory);
     BOOL retfinal = impl::CreateDirectoryW(LongDestinationDirectory.c_str(), securityAttributes);
     if (debug)
     {
@@ -94,13 +94,13 @@ BOOL __stdcall CreateDirectoryFixup(_In_ const CharT* pathName, _In_opt_ LPSECUR
         {
             dllInstance = ++g_InterceptInstance;
             std::wstring wPathName = widen(pathName);
-            wPathName = AdjustSlashes(wPathName);
+            wPathName = AdjustSlashes(std::move(wPathName));
 
 #if _DEBUG
             LogString(dllInstance, L"CreateDirectoryFixup for path", pathName);
 #endif
             
-            wPathName = AdjustBadUNC(wPathName, dllInstance, L"CreateDirectoryFixup");
+            wPathName = AdjustBadUNC(std::move(wPathName), dllInstance, L"CreateDirectoryFixup");
             
 
             // This get is inheirently a write operation in all cases.
@@ -113,11 +113,11 @@ BOOL __stdcall CreateDirectoryFixup(_In_ const CharT* pathName, _In_opt_ LPSECUR
                 switch (cohorts.file_mfr.Request_MfrPathType)
                 {
                 case mfr::mfr_path_types::in_native_area:
-                    if (cohorts.map.Valid_mapping &&
-                        cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
+                    if (cohorts.map->Valid_mapping &&
+                        cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
                     {
                         // try the request path, which must be the local redirected version by definition, and then a package equivalent
-                        if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                        if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                         {
                             // Still do this to set attributes
                             retfinal = WRAPPER_CREATEDIRECTORY(cohorts.WsRedirected, securityAttributes, dllInstance, debug);
@@ -158,12 +158,12 @@ BOOL __stdcall CreateDirectoryFixup(_In_ const CharT* pathName, _In_opt_ LPSECUR
                             return WRAPPER_CREATEDIRECTORY(cohorts.WsRedirected, securityAttributes, dllInstance, debug);
                         }
                     }
-                    else if (cohorts.map.Valid_mapping &&
-                        (cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
-                            cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
+                    else if (cohorts.map->Valid_mapping &&
+                        (cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
+                            cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
                     {
                         // try the redirected path, then package (via COW), then native (possibly via COW).
-                        if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                        if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                         {
                             retfinal = WRAPPER_CREATEDIRECTORY(cohorts.WsRedirected, securityAttributes, dllInstance, debug);
 #if IMPROVE_RETURN_ACCURACY
@@ -222,10 +222,10 @@ BOOL __stdcall CreateDirectoryFixup(_In_ const CharT* pathName, _In_opt_ LPSECUR
                     }
                     break;
                 case mfr::mfr_path_types::in_package_pvad_area:
-                    if (cohorts.map.Valid_mapping)
+                    if (cohorts.map->Valid_mapping)
                     {
                         //// try the redirected path, then package (COW), then don't need native.
-                        if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                        if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                         {
                             PreCreateFolders(cohorts.WsRedirected.c_str(), dllInstance, L"CreateDirectoryFixup");
                             retfinal = WRAPPER_CREATEDIRECTORY(cohorts.WsRedirected, securityAttributes, dllInstance, debug);
@@ -268,11 +268,11 @@ BOOL __stdcall CreateDirectoryFixup(_In_ const CharT* pathName, _In_opt_ LPSECUR
                     }
                     break;
                 case mfr::mfr_path_types::in_package_vfs_area:
-                    if (cohorts.map.Valid_mapping &&
-                        cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
+                    if (cohorts.map->Valid_mapping &&
+                        cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
                     {
                         // try the redirection path, then the package (COW).
-                        if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                        if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                         {
                             PreCreateFolders(cohorts.WsRedirected.c_str(), dllInstance, L"CreateDirectoryFixup");
                             retfinal = WRAPPER_CREATEDIRECTORY(cohorts.WsRedirected, securityAttributes, dllInstance, debug);
@@ -311,12 +311,12 @@ BOOL __stdcall CreateDirectoryFixup(_In_ const CharT* pathName, _In_opt_ LPSECUR
                             return WRAPPER_CREATEDIRECTORY(cohorts.WsRedirected, securityAttributes, dllInstance, debug);
                         }
                     }
-                    else if (cohorts.map.Valid_mapping &&
-                        (cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
-                            cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
+                    else if (cohorts.map->Valid_mapping &&
+                        (cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
+                            cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
                     {
                         // try the redirection path, then the package (COW), then native (possibly COW)
-                        if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                        if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                         {
                             PreCreateFolders(cohorts.WsRedirected.c_str(), dllInstance, L"CreateDirectoryFixup");
                             retfinal = WRAPPER_CREATEDIRECTORY(cohorts.WsRedirected, securityAttributes, dllInstance, debug);
@@ -375,10 +375,10 @@ BOOL __stdcall CreateDirectoryFixup(_In_ const CharT* pathName, _In_opt_ LPSECUR
                     }
                     break;
                 case mfr::mfr_path_types::in_redirection_area_writablepackageroot:
-                    if (cohorts.map.Valid_mapping)
+                    if (cohorts.map->Valid_mapping)
                     {
                         // try the redirected path, then package (COW), then possibly native (Possibly COW).
-                        if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                        if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                         {
                             PreCreateFolders(cohorts.WsRedirected.c_str(), dllInstance, L"CreateDirectoryFixup");
                             retfinal = WRAPPER_CREATEDIRECTORY(cohorts.WsRedirected, securityAttributes, dllInstance, debug);
@@ -24,10 +24,10 @@
 #include "DetermineCohorts.h"
 #include "DetermineIlvPaths.h"
 
-BOOL WRAPPER_CREATEDIRECTORYEX(std::wstring theTemplateDirectory, std::wstring theDestinationDirectory, LPSECURITY_ATTRIBUTES securityAttributes, DWORD dllInstance, bool debug, bool moredebug)
+BOOL WRAPPER_CREATEDIRECTORYEX(psf::wzstring_view theTemplateDirectory, psf::wzstring_view theDestinationDirectory, LPSECURITY_ATTRIBUTES securityAttributes, DWORD dllInstance, bool debug, bool moredebug)
     { 
-        std::wstring LongTemplateDirectory = MakeLongPath(theTemplateDirectory);
-        std::wstring LongDestinationDirectory = MakeLongPath(theDestinationDirectory);
+        long_path LongTemplateDirectory(theTemplateDirectory);
+        long_path LongDestinationDirectory(theDestinationDirectory);
         BOOL retfinal = impl::CreateDirectoryExW(LongTemplateDirectory.c_str(), LongDestinationDirectory.c_str(), securityAttributes); 
         if (moredebug) 
         { 
@@ -78,11 +78,11 @@ BOOL __stdcall CreateDirectoryExFixup(
 #endif
             std::wstring WtemplateDirectory = widen(templateDirectory);
             std::wstring WnewDirectory = widen(newDirectory);
-            WtemplateDirectory = AdjustSlashes(WtemplateDirectory);
-            WnewDirectory = AdjustSlashes(WnewDirectory);
+            WtemplateDirectory = AdjustSlashes(std::move(WtemplateDirectory));
+            WnewDirectory = AdjustSlashes(std::move(WnewDirectory));
 
-            WtemplateDirectory = AdjustBadUNC(WtemplateDirectory, dllInstance, L"CreateDirectoryExFixup (template)");
-            WnewDirectory = AdjustBadUNC(WnewDirectory, dllInstance, L"CreateDirectoryExFixup (new)");
+            WtemplateDirectory = AdjustBadUNC(std::move(WtemplateDirectory), dllInstance, L"CreateDirectoryExFixup (template)");
+            WnewDirectory = AdjustBadUNC(std::move(WnewDirectory), dllInstance, L"CreateDirectoryExFixup (new)");
             
 
             // This get is inheirently a write operation in all cases.
@@ -99,7 +99,7 @@ BOOL __stdcall CreateDirectoryExFixup(
                 switch (cohortsNew.file_mfr.Request_MfrPathType)
                 {
                 case mfr::mfr_path_types::in_native_area:
-                    if (cohortsNew.map.Valid_mapping && !cohortsNew.map.IsAnExclusionToRedirect)
+                    if (cohortsNew.map->Valid_mapping && !cohortsNew.map->IsAnExclusionToRedirect)
                     {
                         newDirectoryWsRedirected = cohortsNew.WsRedirected;
                     }
@@ -109,7 +109,7 @@ BOOL __stdcall CreateDirectoryExFixup(
                     }
                     break;
                 case mfr::mfr_path_types::in_package_pvad_area:
-                    if (cohortsNew.map.Valid_mapping && !cohortsNew.map.IsAnExclusionToRedirect)
+                    if (cohortsNew.map->Valid_mapping && !cohortsNew.map->IsAnExclusionToRedirect)
                     {
                         newDirectoryWsRedirected = cohortsNew.WsRedirected;
                     }
@@ -119,7 +119,7 @@ BOOL __stdcall CreateDirectoryExFixup(
                     }
                     break;
                 case mfr::mfr_path_types::in_package_vfs_area:
-                    if (cohortsNew.map.Valid_mapping && !cohortsNew.map.IsAnExclusionToRedirect)
+                    if (cohortsNew.map->Valid_mapping && !cohortsNew.map->IsAnExclusionToRedirect)
                     {
                         newDirectoryWsRedirected = cohortsNew.WsRedirected;
                     }
@@ -129,7 +129,7 @@ BOOL __stdcall CreateDirectoryExFixup(
                     }
                     break;
                 case mfr::mfr_path_types::in_redirection_area_writablepackageroot:
-                    if (cohortsNew.map.Valid_mapping && !cohortsNew.map.IsAnExclusionToRedirect)
+                    if (cohortsNew.map->Valid_mapping && !cohortsNew.map->IsAnExclusionToRedirect)
                     {
                         newDirectoryWsRedirected = cohortsNew.WsRedirected;
                     }
@@ -160,11 +160,11 @@ BOOL __stdcall CreateDirectoryExFixup(
                 switch (cohortsTemplate.file_mfr.Request_MfrPathType)
                 {
                 case mfr::mfr_path_types::in_native_area:
-                    if (cohortsTemplate.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local &&
-                        cohortsTemplate.map.Valid_mapping)
+                    if (cohortsTemplate.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local &&
+                        cohortsTemplate.map->Valid_mapping)
                     {
                         // try the request path, which must be the local redirected version by definition, and then a package equivalent, or make original call to fail.
-                        if (!cohortsTemplate.map.IsAnExclusionToRedirect && PathExists(cohortsTemplate.WsRedirected.c_str()))
+                        if (!cohortsTemplate.map->IsAnExclusionToRedirect && PathExists(cohortsTemplate.WsRedirected.c_str()))
                         {
                             PreCreateFolders(newDirectoryWsRedirected.c_str(), dllInstance, L"CreateDirectoryExFixup");
                             retfinal = WRAPPER_CREATEDIRECTORYEX(cohortsTemplate.WsRedirected, newDirectoryWsRedirected, securityAttributes, dllInstance, debug, moredebug);
@@ -207,12 +207,12 @@ BOOL __stdcall CreateDirectoryExFixup(
                             return retfinal;
                         }
                     }
-                    else if ((cohortsTemplate.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
-                        cohortsTemplate.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs) &&
-                        cohortsTemplate.map.Valid_mapping)
+                    else if ((cohortsTemplate.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
+                        cohortsTemplate.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs) &&
+                        cohortsTemplate.map->Valid_mapping)
                     {
                         // try the redirected path, then package, then native, or let fail using original.
-                        if (!cohortsTemplate.map.IsAnExclusionToRedirect && PathExists(cohortsTemplate.WsRedirected.c_str()))
+                        if (!cohortsTemplate.map->IsAnExclusionToRedirect && PathExists(cohortsTemplate.WsRedirected.c_str()))
                         {
                             PreCreateFolders(newDirectoryWsRedirected.c_str(), dllInstance, L"CreateDirectoryExFixup");
                             retfinal = WRAPPER_CREATEDIRECTORYEX(cohortsTemplate.WsRedirected, newDirectoryWsRedirected, securityAttributes, dllInstance, debug, moredebug);
@@ -282,10 +282,10 @@ BOOL __stdcall CreateDirectoryExFixup(
                     }
                     break;
                 case mfr::mfr_path_types::in_package_pvad_area:
-                    if (cohortsTemplate.map.Valid_mapping)
+                    if (cohortsTemplate.map->Valid_mapping)
                     {
                         //// try the redirected path, then package (COW), then don't need native.
-                        if (!cohortsTemplate.map.IsAnExclusionToRedirect && PathExists(cohortsTemplate.WsRedirected.c_str()))
+                        if (!cohortsTemplate.map->IsAnExclusionToRedirect && PathExists(cohortsTemplate.WsRedirected.c_str()))
                         {
                             PreCreateFolders(newDirectoryWsRedirected.c_str(), dllInstance, L"CreateDirectoryExFixup");
                             retfinal = WRAPPER_CREATEDIRECTORYEX(cohortsTemplate.WsRedirected, newDirectoryWsRedirected, securityAttributes, dllInstance, debug, moredebug);
@@ -334,11 +334,11 @@ BOOL __stdcall CreateDirectoryExFixup(
                     }
                     break;
                 case mfr::mfr_path_types::in_package_vfs_area:
-                    if (cohortsTemplate.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local &&
-                        cohortsTemplate.map.Valid_mapping)
+                    if (cohortsTemplate.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local &&
+                        cohortsTemplate.map->Valid_mapping)
                     {
                         // try the redirection path, then the package (COW).
-                        if (!cohortsTemplate.map.IsAnExclusionToRedirect && PathExists(cohortsTemplate.WsRedirected.c_str()))
+                        if (!cohortsTemplate.map->IsAnExclusionToRedirect && PathExists(cohortsTemplate.WsRedirected.c_str()))
                         {
                             PreCreateFolders(newDirectoryWsRedirected.c_str(), dllInstance, L"CreateDirectoryExFixup");
                             retfinal = WRAPPER_CREATEDIRECTORYEX(cohortsTemplate.WsRedirected, newDirectoryWsRedirected, securityAttributes, dllInstance, debug, moredebug);
@@ -385,12 +385,12 @@ BOOL __stdcall CreateDirectoryExFixup(
                             return retfinal;
                         }
                     }
-                    else if ((cohortsTemplate.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
-                        cohortsTemplate.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs) &&
-                        cohortsTemplate.map.Valid_mapping)
+                    else if ((cohortsTemplate.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
+                        cohortsTemplate.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs) &&
+                        cohortsTemplate.map->Valid_mapping)
                     {
                         // try the redirection path, then the package (COW), then native (possibly COW)
-                        if (!cohortsTemplate.map.IsAnExclusionToRedirect && PathExists(cohortsTemplate.WsRedirected.c_str()))
+                        if (!cohortsTemplate.map->IsAnExclusionToRedirect && PathExists(cohortsTemplate.WsRedirected.c_str()))
                         {
                             PreCreateFolders(newDirectoryWsRedirected.c_str(), dllInstance, L"CreateDirectoryExFixup");
                             retfinal = WRAPPER_CREATEDIRECTORYEX(cohortsTemplate.WsRedirected, newDirectoryWsRedirected, securityAttributes, dllInstance, debug, moredebug);
@@ -460,10 +460,10 @@ BOOL __stdcall CreateDirectoryExFixup(
                     }
                     break;
                 case mfr::mfr_path_types::in_redirection_area_writablepackageroot:
-                    if (cohortsTemplate.map.Valid_mapping)
+                    if (cohortsTemplate.map->Valid_mapping)
                     {
                         // try the redirected path, then package (COW), then possibly native (Possibly COW).
-                        if (!cohortsTemplate.map.IsAnExclusionToRedirect && PathExists(cohortsTemplate.WsRedirected.c_str()))
+                        if (!cohortsTemplate.map->IsAnExclusionToRedirect && PathExists(cohortsTemplate.WsRedirected.c_str()))
                         {
                             PreCreateFolders(newDirectoryWsRedirected.c_str(), dllInstance, L"CreateDirectoryExFixup");
                             retfinal = WRAPPER_CREATEDIRECTORYEX(cohortsTemplate.WsRedirected, newDirectoryWsRedirected, securityAttributes, dllInstance, debug, moredebug);
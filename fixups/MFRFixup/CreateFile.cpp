@@ -22,7 +22,7 @@
 #include "Detect_Pipe.h"
 
 
-HANDLE  WRAPPER_CREATEFILE(std::wstring theDestinationFile,
+HANDLE  WRAPPER_CREATEFILE(psf::wzstring_view theDestinationFile,
     _In_ DWORD desiredAccess,
     _In_ DWORD shareMode,
     _In_opt_ LPSECURITY_ATTRIBUTES securityAttributes,
@@ -32,7 +32,7 @@ HANDLE  WRAPPER_CREATEFILE(std::wstring theDestinationFile,
     DWORD dllInstance, bool debug)
 {
     HANDLE retfinal;
-    std::wstring LongDestinationFile = MakeLongPath(theDestinationFile);
+    long_path LongDestinationFile(theDestinationFile);
 
     retfinal = impl::CreateFileW(LongDestinationFile.c_str(), desiredAccess, shareMode, securityAttributes, creationDisposition, flagsAndAttributes, templateFile);
 
@@ -61,14 +61,8 @@ HANDLE __stdcall CreateFileFixup(_In_ const CharT* pathName,
     _In_opt_ HANDLE templateFile) noexcept
 {
     DWORD dllInstance = g_InterceptInstance;
-    bool debug = false;
-#if _DEBUG
-    debug = true;
-#endif
-    bool moredebug = false;
-#if MOREDEBUG
-    moredebug = true;
-#endif
+    bool debug = PSF_LOG_ENABLED(psf::log_level::debug, g_logMfrFiles);
+    bool moredebug = PSF_LOG_ENABLED(psf::log_level::trace, g_logMfrFiles);
 
     auto guard = g_reentrancyGuard.enter();
     HANDLE retfinal;
@@ -79,8 +73,8 @@ HANDLE __stdcall CreateFileFixup(_In_ const CharT* pathName,
         {
             dllInstance = ++g_InterceptInstance;
             std::wstring wPathName = widen(pathName);
-            wPathName = AdjustSlashes(wPathName);
-            wPathName = AdjustLocalPipeName(wPathName);
+            wPathName = AdjustSlashes(std::move(wPathName));
+            wPathName = AdjustLocalPipeName(std::move(wPathName));
 
             if (wPathName._Starts_with(L"\\\\?\\UNC"))
             {
@@ -90,32 +84,31 @@ HANDLE __stdcall CreateFileFixup(_In_ const CharT* pathName,
 #endif
             }
 
-#if _DEBUG
-            if (wPathName._Starts_with(L"STORAGE#") ||
-                wPathName._Starts_with(L"\\\\?\\STORAGE#"))
+            if (debug)
             {
-                Log(L"[%d] CreateFileFixup Storage Namespace", dllInstance);
-            }
-            else if (wPathName.size() == 3)
-            {
-                if (wPathName.compare(L"C:\\") ||
-                    wPathName.compare(L"c:\\"))
+                if (wPathName._Starts_with(L"STORAGE#") ||
+                    wPathName._Starts_with(L"\\\\?\\STORAGE#"))
+                {
+                    Log(L"[%d] CreateFileFixup Storage Namespace", dllInstance);
+                }
+                else if (wPathName.size() == 3)
                 {
-                    Log(L"[%d] CreateFileFixup AppVPackageDrive", dllInstance);
+                    if (wPathName.compare(L"C:\\") ||
+                        wPathName.compare(L"c:\\"))
+                    {
+                        Log(L"[%d] CreateFileFixup AppVPackageDrive", dllInstance);
+                    }
                 }
+                LogString(dllInstance, L"CreateFileFixup for path", pathName);
             }
-            LogString(dllInstance, L"CreateFileFixup for path", pathName);
-#if MOREDEBUG
-            Log(L"[%d]        DesiredAccess %s", dllInstance, Log_DesiredAccess(desiredAccess).c_str());
-            Log(L"[%d]        ShareMode %s", dllInstance, Log_ShareMode(shareMode).c_str());
-            Log(L"[%d]        creationDisposition %s", dllInstance, Log_CreationDisposition(creationDisposition).c_str());
-            Log(L"[%d]        flagsAndAttributes %s", dllInstance,  Log_FlagsAndAttributes(flagsAndAttributes).c_str());
-#endif
-#endif
+            PSF_LOG_TRACE(g_logMfrFiles, L"[%d]        DesiredAccess %s", dllInstance, Log_DesiredAccess(desiredAccess).c_str());
+            PSF_LOG_TRACE(g_logMfrFiles, L"[%d]        ShareMode %s", dllInstance, Log_ShareMode(shareMode).c_str());
+            PSF_LOG_TRACE(g_logMfrFiles, L"[%d]        creationDisposition %s", dllInstance, Log_CreationDisposition(creationDisposition).c_str());
+            PSF_LOG_TRACE(g_logMfrFiles, L"[%d]        flagsAndAttributes %s", dllInstance, Log_FlagsAndAttributes(flagsAndAttributes).c_str());
             bool IsAWriteCase = IsCreateForChange(desiredAccess, creationDisposition, flagsAndAttributes);
             bool IsADirectoryCase = IsCreateForDirectory(desiredAccess, creationDisposition, flagsAndAttributes);
 
-            wPathName = AdjustBadUNC(wPathName, dllInstance, L"CreateFile");
+            wPathName = AdjustBadUNC(std::move(wPathName), dllInstance, L"CreateFile");
             
 
 #if NOTOBSOLETE
@@ -153,11 +146,11 @@ HANDLE __stdcall CreateFileFixup(_In_ const CharT* pathName,
                 case mfr::mfr_path_types::in_native_area:
                     if (!IsADirectoryCase)
                     {
-                        if (cohorts.map.Valid_mapping &&
-                            cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
+                        if (cohorts.map->Valid_mapping &&
+                            cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
                         {
                             // try the request path, which must be the local redirected version by definition, and then a package equivalent
-                            if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                            if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                             {
                                 retfinal = WRAPPER_CREATEFILE(cohorts.WsRedirected, desiredAccess, shareMode, securityAttributes, creationDisposition, flagsAndAttributes, templateFile, dllInstance, debug);
                                 return retfinal;
@@ -190,15 +183,15 @@ HANDLE __stdcall CreateFileFixup(_In_ const CharT* pathName,
                             retfinal = WRAPPER_CREATEFILE(cohorts.WsRedirected, desiredAccess, shareMode, securityAttributes, creationDisposition, flagsAndAttributes, templateFile, dllInstance, debug);
                             return retfinal;
                         }
-                        if (cohorts.map.Valid_mapping &&
-                            (cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
-                                cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
+                        if (cohorts.map->Valid_mapping &&
+                            (cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
+                                cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
                         {
 #if MOREDEBUG
                             Log(L"[%d] CreateFileFixup: traditional redirection mapping.", dllInstance);
 #endif
                             // try the redirected path, then package (via COW), then native (possibly via COW).
-                            if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                            if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                             {
 #if MOREDEBUG
                                 Log(L"[%d] CreateFileFixup: use redirected.", dllInstance);
@@ -269,8 +262,8 @@ HANDLE __stdcall CreateFileFixup(_In_ const CharT* pathName,
                     }
                     else
                     {
-                        if (cohorts.map.Valid_mapping &&
-                            cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
+                        if (cohorts.map->Valid_mapping &&
+                            cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
                         {
                             // try the request path, which must be the local redirected version by definition, and then a package equivalent
                             if (PathExists(cohorts.WsRedirected.c_str()))
@@ -278,7 +271,7 @@ HANDLE __stdcall CreateFileFixup(_In_ const CharT* pathName,
                                 retfinal = WRAPPER_CREATEFILE(cohorts.WsRedirected, desiredAccess, shareMode, securityAttributes, creationDisposition, flagsAndAttributes, templateFile, dllInstance, debug);
                                 return retfinal;
                             }
-                            if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsPackage.c_str()))
+                            if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsPackage.c_str()))
                             {
                                 if (IsAWriteCase)
                                 {
@@ -306,17 +299,17 @@ HANDLE __stdcall CreateFileFixup(_In_ const CharT* pathName,
                             retfinal = WRAPPER_CREATEFILE(cohorts.WsRedirected, desiredAccess, shareMode, securityAttributes, creationDisposition, flagsAndAttributes, templateFile, dllInstance, debug);
                             return retfinal;
                         }
-                        else if (cohorts.map.Valid_mapping &&
-                            (cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
-                                cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
+                        else if (cohorts.map->Valid_mapping &&
+                            (cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
+                                cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
                         {
                             // try the redirected path, then package (via COW), then native (possibly via COW).
-                            if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                            if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                             {
                                 retfinal = WRAPPER_CREATEFILE(cohorts.WsRedirected, desiredAccess, shareMode, securityAttributes, creationDisposition, flagsAndAttributes, templateFile, dllInstance, debug);
                                 return retfinal;
                             }
-                            if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsPackage.c_str()))
+                            if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsPackage.c_str()))
                             {
                                 if (IsAWriteCase)
                                 {
@@ -369,7 +362,7 @@ HANDLE __stdcall CreateFileFixup(_In_ const CharT* pathName,
                     }
                     break;
                 case mfr::mfr_path_types::in_package_pvad_area:
-                    if (cohorts.map.Valid_mapping)
+                    if (cohorts.map->Valid_mapping)
                     {
                         if (PathExists(cohorts.WsPackage.c_str()))
                         {
@@ -381,7 +374,7 @@ HANDLE __stdcall CreateFileFixup(_In_ const CharT* pathName,
                             else
                             {
                                 //// try the redirected path, then package (COW), then don't need native.
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     retfinal = WRAPPER_CREATEFILE(cohorts.WsRedirected, desiredAccess, shareMode, securityAttributes, creationDisposition, flagsAndAttributes, templateFile, dllInstance, debug);
                                     return retfinal;
@@ -424,7 +417,7 @@ HANDLE __stdcall CreateFileFixup(_In_ const CharT* pathName,
                             else
                             {
                                 //// try the redirected path, then package (COW), then don't need native.
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     retfinal = WRAPPER_CREATEFILE(cohorts.WsRedirected, desiredAccess, shareMode, securityAttributes, creationDisposition, flagsAndAttributes, templateFile, dllInstance, debug);
                                     return retfinal;
@@ -439,14 +432,14 @@ HANDLE __stdcall CreateFileFixup(_In_ const CharT* pathName,
                     }
                     break;
                 case mfr::mfr_path_types::in_package_vfs_area:
-                    if (cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local &&
-                        cohorts.map.Valid_mapping)
+                    if (cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local &&
+                        cohorts.map->Valid_mapping)
                     {
 #if EVENMOREDEBUG
                         Log(L"[%d] CreateFileFixup: Package VFS with local redirection case.", dllInstance);
 #endif
                         // try the redirection path, then the package (COW).
-                        if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                        if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                         {
                             retfinal = WRAPPER_CREATEFILE(cohorts.WsRedirected, desiredAccess, shareMode, securityAttributes, creationDisposition, flagsAndAttributes, templateFile, dllInstance, debug);
                             return retfinal;
@@ -478,9 +471,9 @@ HANDLE __stdcall CreateFileFixup(_In_ const CharT* pathName,
                         retfinal = WRAPPER_CREATEFILE(cohorts.WsRedirected, desiredAccess, shareMode, securityAttributes, creationDisposition, flagsAndAttributes, templateFile, dllInstance, debug);
                         return retfinal;
                     }
-                    else if (cohorts.map.Valid_mapping &&
-                        (cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
-                            cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
+                    else if (cohorts.map->Valid_mapping &&
+                        (cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
+                            cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
                     {
 #if EVENMOREDEBUG
                         Log(L"[%d] CreateFileFixup: Package VFS with traditional redirection case.", dllInstance);
@@ -511,7 +504,7 @@ HANDLE __stdcall CreateFileFixup(_In_ const CharT* pathName,
                                     Log(L"[%d] CreateFileFixup: NOT directory case.", dllInstance);
 #endif
                                     // try the redirection path, then the package (COW), then native (possibly COW)
-                                    if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                    if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                     {
 #if MOREDEBUG
                                         Log(L"[%d] CreateFileFixup: Read only Package VFS but exists in redir, ready to create in redirected area", dllInstance);
@@ -585,7 +578,7 @@ HANDLE __stdcall CreateFileFixup(_In_ const CharT* pathName,
                                             }
 #endif
                                             // Return the most appropriate error code
-                                            if (!cohorts.map.IsAnExclusionToRedirect && PathParentExists(cohorts.WsRedirected.c_str()) && !PathExists(cohorts.WsRedirected.c_str()))
+                                            if (!cohorts.map->IsAnExclusionToRedirect && PathParentExists(cohorts.WsRedirected.c_str()) && !PathExists(cohorts.WsRedirected.c_str()))
                                             {
 #if _DEBUG
                                                 Log(L"[%d] CreateFileFixup: Reset error to File not found.", dllInstance);
@@ -693,7 +686,7 @@ HANDLE __stdcall CreateFileFixup(_In_ const CharT* pathName,
                                         Log(L"[%d] CreateFileFixup: write case.", dllInstance);
 #endif
                                         // The file wasn't in the package, so precreate folders and let it rip!
-                                        PreCreateFolders(cohorts.WsRedirected, dllInstance, L"CreateFileFixup");
+                                        PreCreateFolders(cohorts.WsRedirected.c_str(), dllInstance, L"CreateFileFixup");
                                         retfinal = WRAPPER_CREATEFILE(cohorts.WsRedirected, desiredAccess, shareMode, securityAttributes, creationDisposition, flagsAndAttributes, templateFile, dllInstance, debug);
                                         return retfinal;
                                     }
@@ -743,10 +736,10 @@ HANDLE __stdcall CreateFileFixup(_In_ const CharT* pathName,
                     }
                     break;
                 case mfr::mfr_path_types::in_redirection_area_writablepackageroot:
-                    if (cohorts.map.Valid_mapping)
+                    if (cohorts.map->Valid_mapping)
                     {
                         // try the redirected path, then package (COW), then possibly native (Possibly COW).
-                        if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                        if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                         {
                             retfinal = WRAPPER_CREATEFILE(cohorts.WsRedirected, desiredAccess, shareMode, securityAttributes, creationDisposition, flagsAndAttributes, templateFile, dllInstance, debug);
                             return retfinal;
@@ -870,14 +863,23 @@ HANDLE __stdcall CreateFileFixup(_In_ const CharT* pathName,
 #endif
     if (pathName != nullptr)
     {
-        std::wstring LongDirectory = MakeLongPath(widen(pathName));
-        if (LongDirectory.length() != widen(pathName).length())
+        if constexpr (psf::is_ansi<CharT>)
         {
-            retfinal = impl::CreateFileW(LongDirectory.c_str(), desiredAccess, shareMode, securityAttributes, creationDisposition, flagsAndAttributes, templateFile);
+            std::wstring LongDirectory = MakeLongPath(widen(pathName));
+            if (LongDirectory.length() != widen(pathName).length())
+            {
+                retfinal = impl::CreateFileW(LongDirectory.c_str(), desiredAccess, shareMode, securityAttributes, creationDisposition, flagsAndAttributes, templateFile);
+            }
+            else
+            {
+                retfinal = impl::CreateFile(pathName, desiredAccess, shareMode, securityAttributes, creationDisposition, flagsAndAttributes, templateFile);
+            }
         }
         else
         {
-            retfinal = impl::CreateFile(pathName, desiredAccess, shareMode, securityAttributes, creationDisposition, flagsAndAttributes, templateFile);
+            // Only copies the path when it needs the prefix
+            long_path LongDirectory(pathName);
+            retfinal = impl::CreateFileW(LongDirectory.c_str(), desiredAccess, shareMode, securityAttributes, creationDisposition, flagsAndAttributes, templateFile);
         }
     }
     else
@@ -21,14 +21,14 @@
 #include "Detect_Pipe.h"
 
 
-HANDLE  WRAPPER_CREATEFILE2(std::wstring theDestinationFile,
+HANDLE  WRAPPER_CREATEFILE2(psf::wzstring_view theDestinationFile,
     _In_ DWORD desiredAccess,
     _In_ DWORD shareMode,
     _In_ DWORD creationDisposition,
     _In_opt_ LPCREATEFILE2_EXTENDED_PARAMETERS createExParams,
     DWORD dllInstance, bool debug)
 {
-    std::wstring LongDestinationFile = MakeLongPath(theDestinationFile);
+    long_path LongDestinationFile(theDestinationFile);
     HANDLE retfinal = impl::CreateFile2(LongDestinationFile.c_str(), desiredAccess, shareMode, creationDisposition, createExParams);
     if (debug)
     {
@@ -53,14 +53,8 @@ HANDLE __stdcall CreateFile2Fixup(
     _In_opt_ LPCREATEFILE2_EXTENDED_PARAMETERS createExParams) noexcept
 {
     DWORD dllInstance = g_InterceptInstance;
-    bool debug = false;
-#if _DEBUG
-    debug = true;
-#endif
-    bool moredebug = false;
-#if MOREDEBUG
-    moredebug = true;
-#endif
+    bool debug = PSF_LOG_ENABLED(psf::log_level::debug, g_logMfrFiles);
+    bool moredebug = PSF_LOG_ENABLED(psf::log_level::trace, g_logMfrFiles);
 
     auto guard = g_reentrancyGuard.enter();
     HANDLE retfinal;
@@ -72,25 +66,24 @@ HANDLE __stdcall CreateFile2Fixup(
         {
             dllInstance = ++g_InterceptInstance;
             std::wstring wPathName = fileName;
-            wPathName = AdjustSlashes(wPathName);
-            wPathName = AdjustLocalPipeName(wPathName);
+            wPathName = AdjustSlashes(std::move(wPathName));
+            wPathName = AdjustLocalPipeName(std::move(wPathName));
 
-#if _DEBUG
-            LogString(dllInstance, L"CreateFile2Fixup for ", fileName);
-#if MOREDEBUG
-            Log(L"[%d]        DesiredAccess %s", dllInstance, Log_DesiredAccess(desiredAccess).c_str());
-            Log(L"[%d]        ShareMode %s", dllInstance, Log_ShareMode(shareMode).c_str());
-            Log(L"[%d]        creationDisposition %s", dllInstance, Log_CreationDisposition(creationDisposition).c_str());
+            if (debug)
+            {
+                LogString(dllInstance, L"CreateFile2Fixup for ", fileName);
+            }
+            PSF_LOG_TRACE(g_logMfrFiles, L"[%d]        DesiredAccess %s", dllInstance, Log_DesiredAccess(desiredAccess).c_str());
+            PSF_LOG_TRACE(g_logMfrFiles, L"[%d]        ShareMode %s", dllInstance, Log_ShareMode(shareMode).c_str());
+            PSF_LOG_TRACE(g_logMfrFiles, L"[%d]        creationDisposition %s", dllInstance, Log_CreationDisposition(creationDisposition).c_str());
             if (createExParams)
             {
-                Log(L"[%d]        flags %s", dllInstance, Log_FlagsAndAttributes(createExParams->dwFileFlags).c_str());
-                Log(L"[%d]        Attributes %s", dllInstance, Log_FlagsAndAttributes(createExParams->dwFileAttributes).c_str());
+                PSF_LOG_TRACE(g_logMfrFiles, L"[%d]        flags %s", dllInstance, Log_FlagsAndAttributes(createExParams->dwFileFlags).c_str());
+                PSF_LOG_TRACE(g_logMfrFiles, L"[%d]        Attributes %s", dllInstance, Log_FlagsAndAttributes(createExParams->dwFileAttributes).c_str());
             }
-#endif
-#endif
 
 
-            wPathName = AdjustBadUNC(wPathName, dllInstance, L"CreateFile2Fixup");
+            wPathName = AdjustBadUNC(std::move(wPathName), dllInstance, L"CreateFile2Fixup");
             
 
             bool IsAWriteCase;
@@ -135,11 +128,11 @@ HANDLE __stdcall CreateFile2Fixup(
                 switch (cohorts.file_mfr.Request_MfrPathType)
                 {
                 case mfr::mfr_path_types::in_native_area:
-                    if (cohorts.map.Valid_mapping &&
-                        cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
+                    if (cohorts.map->Valid_mapping &&
+                        cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
                     {
                         // try the request path, which must be the local redirected version by definition, and then a package equivalent
-                        if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                        if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                         {
                             retfinal = WRAPPER_CREATEFILE2(cohorts.WsRedirected, desiredAccess, shareMode, creationDisposition, createExParams, dllInstance, debug);
                             return retfinal;
@@ -172,12 +165,12 @@ HANDLE __stdcall CreateFile2Fixup(
                         retfinal = WRAPPER_CREATEFILE2(cohorts.WsRedirected, desiredAccess, shareMode, creationDisposition, createExParams, dllInstance, debug);
                         return retfinal;
                     }
-                    else if (cohorts.map.Valid_mapping &&
-                        (cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
-                            cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
+                    else if (cohorts.map->Valid_mapping &&
+                        (cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
+                            cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
                     {
                         // try the redirected path, then package (via COW), then native (possibly via COW).
-                        if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                        if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                         {
                             retfinal = WRAPPER_CREATEFILE2(cohorts.WsRedirected, desiredAccess, shareMode, creationDisposition, createExParams, dllInstance, debug);
                             return retfinal;
@@ -235,7 +228,7 @@ HANDLE __stdcall CreateFile2Fixup(
                     }
                     break;
                 case mfr::mfr_path_types::in_package_pvad_area:
-                    if (cohorts.map.Valid_mapping)
+                    if (cohorts.map->Valid_mapping)
                     {
                         if (PathExists(cohorts.WsPackage.c_str()))
                         {
@@ -247,7 +240,7 @@ HANDLE __stdcall CreateFile2Fixup(
                             else
                             {
                                 //// try the redirected path, then package (COW), then don't need native.
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     retfinal = WRAPPER_CREATEFILE2(cohorts.WsRedirected, desiredAccess, shareMode, creationDisposition, createExParams, dllInstance, debug);
                                     return retfinal;
@@ -282,11 +275,11 @@ HANDLE __stdcall CreateFile2Fixup(
                     }
                     break;
                 case mfr::mfr_path_types::in_package_vfs_area:
-                    if (cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local &&
-                        cohorts.map.Valid_mapping)
+                    if (cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local &&
+                        cohorts.map->Valid_mapping)
                     {
                         // try the redirection path, then the package (COW).
-                        if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                        if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                         {
                             retfinal = WRAPPER_CREATEFILE2(cohorts.WsRedirected, desiredAccess, shareMode, creationDisposition, createExParams, dllInstance, debug);
                             return retfinal;
@@ -318,9 +311,9 @@ HANDLE __stdcall CreateFile2Fixup(
                         retfinal = WRAPPER_CREATEFILE2(cohorts.WsRedirected, desiredAccess, shareMode, creationDisposition, createExParams, dllInstance, debug);
                         return retfinal;
                     }
-                    else if (cohorts.map.Valid_mapping &&
-                        (cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
-                            cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
+                    else if (cohorts.map->Valid_mapping &&
+                        (cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
+                            cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
                     {
                         // try the redirection path, then the package (COW), then native (possibly COW)
                         if (PathExists(cohorts.WsPackage.c_str()))
@@ -332,7 +325,7 @@ HANDLE __stdcall CreateFile2Fixup(
                             }
                             else
                             {
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     retfinal = WRAPPER_CREATEFILE2(cohorts.WsRedirected, desiredAccess, shareMode, creationDisposition, createExParams, dllInstance, debug);
                                     return retfinal;
@@ -388,10 +381,10 @@ HANDLE __stdcall CreateFile2Fixup(
                     }
                     break;
                 case mfr::mfr_path_types::in_redirection_area_writablepackageroot:
-                    if (cohorts.map.Valid_mapping)
+                    if (cohorts.map->Valid_mapping)
                     {
                         // try the redirected path, then package (COW), then possibly native (Possibly COW).
-                        if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                        if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                         {
                             retfinal = WRAPPER_CREATEFILE2(cohorts.WsRedirected, desiredAccess, shareMode, creationDisposition, createExParams, dllInstance, debug);
                             return retfinal;
@@ -501,7 +494,7 @@ HANDLE __stdcall CreateFile2Fixup(
 #endif
     if (fileName != nullptr)
     {
-        std::wstring LongDirectory = MakeLongPath(fileName);
+        long_path LongDirectory(fileName);
         retfinal = impl::CreateFile2(LongDirectory.c_str(), desiredAccess, shareMode, creationDisposition, createExParams);
     }
     else
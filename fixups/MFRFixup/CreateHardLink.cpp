@@ -55,11 +55,11 @@ BOOL __stdcall CreateHardLinkFixup(
 #endif
             std::wstring wNewFileName = widen(fileName);
             std::wstring wExistingFileName = widen(existingFileName);
-            wNewFileName = AdjustSlashes(wNewFileName);
-            wExistingFileName = AdjustSlashes(wExistingFileName);
+            wNewFileName = AdjustSlashes(std::move(wNewFileName));
+            wExistingFileName = AdjustSlashes(std::move(wExistingFileName));
 
-            wExistingFileName = AdjustBadUNC(wExistingFileName, dllInstance, L"CreateHardLinkFixup (existing)");
-            wNewFileName = AdjustBadUNC(wNewFileName, dllInstance, L"CreateHardLinkFixup (new link)");
+            wExistingFileName = AdjustBadUNC(std::move(wExistingFileName), dllInstance, L"CreateHardLinkFixup (existing)");
+            wNewFileName = AdjustBadUNC(std::move(wNewFileName), dllInstance, L"CreateHardLinkFixup (new link)");
 
             Cohorts cohortsNew;
             DetermineCohorts(wNewFileName, &cohortsNew, moredebug, dllInstance, L"CreateHardLinkFixup");
@@ -68,7 +68,7 @@ BOOL __stdcall CreateHardLinkFixup(
             DetermineCohorts(wExistingFileName, &cohortsExisting, moredebug, dllInstance, L"CreateHardLinkFixup");
 
 
-            std::wstring UseExisting = cohortsExisting.WsRedirected;
+            std::wstring UseExisting(cohortsExisting.WsRedirected);
             // Make a copy of existing into redirection area (if needed) so that all changes happen there
             if (!PathExists(cohortsExisting.WsRedirected.c_str()))
             {
@@ -102,10 +102,10 @@ BOOL __stdcall CreateHardLinkFixup(
 
 
 
-            if (cohortsExisting.map.Valid_mapping && cohortsNew.map.Valid_mapping)
+            if (cohortsExisting.map->Valid_mapping && cohortsNew.map->Valid_mapping)
             {
                 std::wstring rldNewFileNameRedirected;
-                if (!cohortsNew.map.IsAnExclusionToRedirect)
+                if (!cohortsNew.map->IsAnExclusionToRedirect)
                 {
                     rldNewFileNameRedirected = MakeLongPath(cohortsNew.WsRedirected);
                 }
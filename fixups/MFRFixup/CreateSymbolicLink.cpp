@@ -67,11 +67,11 @@ BOOLEAN __stdcall CreateSymbolicLinkFixup(
 
             std::wstring wSymlinkFileName = widen(symlinkFileName);
             std::wstring wTargetFileName = widen(targetFileName);
-            wSymlinkFileName = AdjustSlashes(wSymlinkFileName);
-            wTargetFileName = AdjustSlashes(wTargetFileName);
+            wSymlinkFileName = AdjustSlashes(std::move(wSymlinkFileName));
+            wTargetFileName = AdjustSlashes(std::move(wTargetFileName));
 
-            wSymlinkFileName = AdjustBadUNC(wSymlinkFileName, dllInstance, L"CreateSymbolicLinkFixup (new link)");
-            wTargetFileName = AdjustBadUNC(wTargetFileName, dllInstance, L"CreateSymbolicLinkFixup (existing)");
+            wSymlinkFileName = AdjustBadUNC(std::move(wSymlinkFileName), dllInstance, L"CreateSymbolicLinkFixup (new link)");
+            wTargetFileName = AdjustBadUNC(std::move(wTargetFileName), dllInstance, L"CreateSymbolicLinkFixup (existing)");
 
             Cohorts cohortsSymlink;
             DetermineCohorts(wSymlinkFileName, &cohortsSymlink, moredebug, dllInstance, L"CreateSymbolicLinkFixup");
@@ -80,7 +80,7 @@ BOOLEAN __stdcall CreateSymbolicLinkFixup(
             DetermineCohorts(wTargetFileName, &cohortsTarget, moredebug, dllInstance, L"CreateSymbolicLinkFixup");
 
 
-            std::wstring UseTarget = cohortsTarget.WsRedirected;
+            std::wstring UseTarget(cohortsTarget.WsRedirected);
             // If file case, make a copy if needed so that all changes happen there
             if (flags == 0)
             {
@@ -121,10 +121,10 @@ BOOLEAN __stdcall CreateSymbolicLinkFixup(
             }
 
  
-            if (cohortsTarget.map.Valid_mapping && cohortsSymlink.map.Valid_mapping)
+            if (cohortsTarget.map->Valid_mapping && cohortsSymlink.map->Valid_mapping)
             {
                 std::wstring rldSymlinkFileNameRedirected;
-                if (!cohortsSymlink.map.IsAnExclusionToRedirect)
+                if (!cohortsSymlink.map->IsAnExclusionToRedirect)
                 {
                     rldSymlinkFileNameRedirected = MakeLongPath(cohortsSymlink.WsRedirected);
                 }
@@ -20,9 +20,9 @@
 #include "DetermineIlvPaths.h"
 
 
-BOOL  WRAPPER_DELETEFILE(std::wstring theDeletingFile, DWORD dllInstance, bool debug)
+BOOL  WRAPPER_DELETEFILE(psf::wzstring_view theDeletingFile, DWORD dllInstance, bool debug)
 {
-    std::wstring LongDeletingFile = MakeLongPath(theDeletingFile);
+    long_path LongDeletingFile(theDeletingFile);
     BOOL retfinal = impl::DeleteFileW(LongDeletingFile.c_str());
     if (debug)
     {
@@ -59,13 +59,13 @@ BOOL __stdcall DeleteFileFixup(_In_ const CharT* pathName) noexcept
         if (guard)
         {
             std::wstring wPathName = widen(pathName);
-            wPathName = AdjustSlashes(wPathName);
+            wPathName = AdjustSlashes(std::move(wPathName));
 
 #if _DEBUG
             LogString(dllInstance, L"DeleteFileFixup for pathName", wPathName.c_str());
 #endif
 
-            wPathName = AdjustBadUNC(wPathName, dllInstance, L"DeleteFileFixup");
+            wPathName = AdjustBadUNC(std::move(wPathName), dllInstance, L"DeleteFileFixup");
 
             Cohorts cohorts;
             DetermineCohorts(wPathName, &cohorts, moredebug, dllInstance, L"DeleteFileFixup");
@@ -78,11 +78,11 @@ BOOL __stdcall DeleteFileFixup(_In_ const CharT* pathName) noexcept
                 switch (cohorts.file_mfr.Request_MfrPathType)
                 {
                 case mfr::mfr_path_types::in_native_area:
-                    if (cohorts.map.Valid_mapping &&
-                        cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
+                    if (cohorts.map->Valid_mapping &&
+                        cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
                     {
                         // try the request path, which must be the local redirected version by definition, and then a package equivalent
-                        if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                        if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                         {
                             // Still do this to set attributes
                             retfinal = WRAPPER_DELETEFILE(cohorts.WsRedirected, dllInstance, debug);
@@ -118,12 +118,12 @@ BOOL __stdcall DeleteFileFixup(_In_ const CharT* pathName) noexcept
                             return retfinal;
                         }
                     }
-                    else if (cohorts.map.Valid_mapping &&
-                        (cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
-                            cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
+                    else if (cohorts.map->Valid_mapping &&
+                        (cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
+                            cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
                     {
                         // try the redirected path, then package (via COW), then native (possibly via COW).
-                        if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                        if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                         {
                             retfinal = WRAPPER_DELETEFILE(cohorts.WsRedirected, dllInstance, debug);
                             return retfinal;
@@ -151,10 +151,10 @@ BOOL __stdcall DeleteFileFixup(_In_ const CharT* pathName) noexcept
                     }
                     break;
                 case mfr::mfr_path_types::in_package_pvad_area:
-                    if (cohorts.map.Valid_mapping)
+                    if (cohorts.map->Valid_mapping)
                     {
                         //// try the redirected path, then package (COW), then don't need native.
-                        if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                        if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                         {
                             retfinal = WRAPPER_DELETEFILE(cohorts.WsRedirected, dllInstance, debug);
                             return retfinal;
@@ -181,11 +181,11 @@ BOOL __stdcall DeleteFileFixup(_In_ const CharT* pathName) noexcept
                     }
                     break;
                 case mfr::mfr_path_types::in_package_vfs_area:
-                    if (cohorts.map.Valid_mapping &&
-                        cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
+                    if (cohorts.map->Valid_mapping &&
+                        cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
                     {
                         // try the redirection path, then the package (COW).
-                        if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                        if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                         {
                             retfinal = WRAPPER_DELETEFILE(cohorts.WsRedirected, dllInstance, debug);
                             return retfinal;
@@ -210,12 +210,12 @@ BOOL __stdcall DeleteFileFixup(_In_ const CharT* pathName) noexcept
                             return retfinal;
                         }
                     }
-                    else if (cohorts.map.Valid_mapping &&
-                        (cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
-                            cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
+                    else if (cohorts.map->Valid_mapping &&
+                        (cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
+                            cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
                     {
                         // try the redirection path, then the package (COW), then native (possibly COW)
-                        if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                        if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                         {
                             retfinal = WRAPPER_DELETEFILE(cohorts.WsRedirected, dllInstance, debug);
                             return retfinal;
@@ -246,10 +246,10 @@ BOOL __stdcall DeleteFileFixup(_In_ const CharT* pathName) noexcept
                         }
                     }
                     break;
-                    if (cohorts.map.Valid_mapping)
+                    if (cohorts.map->Valid_mapping)
                     {
                         // try the redirected path, then package (COW), then possibly native (Possibly COW).
-                        if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                        if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                         {
                             retfinal = WRAPPER_DELETEFILE(cohorts.WsRedirected, dllInstance, debug);
                             return retfinal;
@@ -20,7 +20,7 @@
 // - Checks for form: \\.\pipe\<token>
 // - Will only allow local pipes
 // - Will not look for local pipes using localhost or 127.0.0.1
-bool detectPipe(std::wstring pipeName);
+bool detectPipe(const std::wstring& pipeName);
 bool detectPipe(std::string  pipeName);
 
 const static int PipePrefixLen = 9;
@@ -62,7 +62,7 @@ std::string AdjustLocalPipeName(std::string pipeName)
     return detectPipe(widen(pipeName));
 }
 
-bool detectPipe(std::wstring pipeName)
+bool detectPipe(const std::wstring& pipeName)
 {
     // Verify that the name can even fit
     if (pipeName.size() <= PipePrefixLen)
@@ -4,13 +4,50 @@
 //-------------------------------------------------------------------------------------------------------
 
 
+#include <algorithm>
+#include <cwctype>
+#include <windows.h>
 #include "DetermineCohorts.h"
 #include <psf_logging.h>
-#include "PathUtilities.h"
 
 
 using namespace std::literals;
 
+// At most two of the cohorts are derived from the request; the others are the request itself
+static constexpr std::size_t MaxDerivedPaths = 2;
+
+/// <summary>
+///   ReplacePathPart from PathUtilities, with the result stored alongside the request in file_mfr rather than in a
+///   string of its own.  inputPath is one of the paths already stored there.
+/// </summary>
+static psf::wzstring_view StoreReplacedPathPart(mfr::mfr_path& file_mfr, psf::wzstring_view inputPath, const std::filesystem::path& from, const std::filesystem::path& to)
+{
+    size_t removecount = from.native().length();
+    if (removecount >= inputPath.length())
+    {
+        return inputPath;
+    }
+
+    // Sized first, so that the part of the input that is kept can be copied from where it is
+    auto& toText = to.native();
+    auto keepLength = inputPath.length() - removecount;
+    auto keepOffset = static_cast<size_t>(inputPath.data() - file_mfr.storage.c_str()) + removecount;
+    file_mfr.storage.reserve(file_mfr.storage.size() + 1 + toText.length() + keepLength);
+    auto offset = file_mfr.store({});
+    file_mfr.storage.append(toText.begin(), toText.end());
+    file_mfr.storage.append(std::wstring_view(file_mfr.storage.c_str() + keepOffset, keepLength));
+    return file_mfr.stored(offset, toText.length() + keepLength);
+}
+
+// comparei from PathUtilities, without copying either side
+static bool EqualsIgnoringCase(std::wstring_view lhs, std::wstring_view rhs)
+{
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](wchar_t a, wchar_t b)
+    {
+        return std::towlower(a) == std::towlower(b);
+    });
+}
+
 /// DetermineCohorts
 ///
 /// This function takes in a file path that was one of the inputs to an API call that we are intercepting,
@@ -22,11 +59,13 @@ using namespace std::literals;
 /// This information is returned in the cohorts structure, which has all three possible file paths, as well as mapping
 /// information that will be useful to the caller in deciding which paths to use and what to do with them.
 /// 
-void DetermineCohorts(std::wstring requestedPath, Cohorts *cohorts, bool UseMoreDebug, DWORD dllInstance, const wchar_t * FixupName)
+void DetermineCohorts(psf::wzstring_view requestedPath, Cohorts *cohorts, bool UseMoreDebug, DWORD dllInstance, const wchar_t * FixupName)
 {
 
-    cohorts->file_mfr = mfr::create_mfr_path(requestedPath);
-    cohorts->WsRequested = cohorts->file_mfr.Request_NormalizedPath.c_str();
+    // The request and every path derived from it share the storage of file_mfr, which create_mfr_path sizes for all of
+    // them so that the views stay put while the rest are added.
+    cohorts->file_mfr = mfr::create_mfr_path(requestedPath, MaxDerivedPaths);
+    cohorts->WsRequested = cohorts->file_mfr.Request_NormalizedPath;
     cohorts->UsingNative = true;
 
     switch (cohorts->file_mfr.Request_MfrPathType)
@@ -36,21 +75,21 @@ void DetermineCohorts(std::wstring requestedPath, Cohorts *cohorts, bool UseMore
         {
             Log(L"[%d] %s: DetermineCohorts: Request is in_native_area.", dllInstance, FixupName);
         }
-        cohorts->map = mfr::Find_LocalRedirMapping_FromNativePath_ForwardSearch(cohorts->file_mfr.Request_NormalizedPath.c_str());
-        if (cohorts->map.Valid_mapping)
+        cohorts->map = &mfr::Find_LocalRedirMapping_FromNativePath_ForwardSearch(cohorts->file_mfr.Request_NormalizedPath);
+        if (cohorts->map->Valid_mapping)
         {
             if (UseMoreDebug)
             {
-                Log(L"[%d] %s: DetermineCohorts: Mapping match against local  %s", dllInstance, FixupName, cohorts->map.VFSFolderName.c_str());
+                Log(L"[%d] %s: DetermineCohorts: Mapping match against local  %s", dllInstance, FixupName, cohorts->map->VFSFolderName.c_str());
             }
-            if (!cohorts->map.IsAnExclusionToRedirect)
+            if (!cohorts->map->IsAnExclusionToRedirect)
             {
                 if (UseMoreDebug)
                 {
-                    Log(L"[%d] %s: DetermineCohorts: Maps with known local redirection type %s", dllInstance, FixupName, RedirectFlagsName(cohorts->map.RedirectionFlags));
+                    Log(L"[%d] %s: DetermineCohorts: Maps with known local redirection type %s", dllInstance, FixupName, RedirectFlagsName(cohorts->map->RedirectionFlags));
                 }
                 cohorts->WsRedirected = cohorts->WsRequested;
-                cohorts->WsPackage = ReplacePathPart(cohorts->WsRequested.c_str(), cohorts->map.RedirectedPathBase, cohorts->map.PackagePathBase);
+                cohorts->WsPackage = StoreReplacedPathPart(cohorts->file_mfr, cohorts->WsRequested, cohorts->map->RedirectedPathBase, cohorts->map->PackagePathBase);
                 //cohorts->WsNative = cohorts->WsRequested;
                 cohorts->UsingNative = false;
                 break;
@@ -75,36 +114,36 @@ void DetermineCohorts(std::wstring requestedPath, Cohorts *cohorts, bool UseMore
             }
         }
 
-        cohorts->map = mfr::Find_TraditionalRedirMapping_FromNativePath_ForwardSearch(cohorts->file_mfr.Request_NormalizedPath.c_str());
-        if (cohorts->map.Valid_mapping)
+        cohorts->map = &mfr::Find_TraditionalRedirMapping_FromNativePath_ForwardSearch(cohorts->file_mfr.Request_NormalizedPath);
+        if (cohorts->map->Valid_mapping)
         {
             if (UseMoreDebug)
             {
-                Log(L"[%d] %s: DetermineCohorts: Mapping match against traditional  %s", dllInstance, FixupName, cohorts->map.VFSFolderName.c_str());
+                Log(L"[%d] %s: DetermineCohorts: Mapping match against traditional  %s", dllInstance, FixupName, cohorts->map->VFSFolderName.c_str());
             }
-            if (!cohorts->map.IsAnExclusionToRedirect)
+            if (!cohorts->map->IsAnExclusionToRedirect)
             {
                 if (UseMoreDebug)
                 {
-                    Log(L"[%d] %s: DetermineCohorts: Maps with known traditional redirection type %s", dllInstance, FixupName, RedirectFlagsName(cohorts->map.RedirectionFlags));
+                    Log(L"[%d] %s: DetermineCohorts: Maps with known traditional redirection type %s", dllInstance, FixupName, RedirectFlagsName(cohorts->map->RedirectionFlags));
                 }
                 // Exception processing
                 // We shouln't redirect to traditional area if the call was only to the WindowsApps folder.
                 // This can cause an issue in an app like R (language) that deals with Short Names and we can't force shortnames to be the same
                 // in the redirection area that they are natively. (Well, we could if MFR did everything but not with ILV in use as it creates these things behind our back.
-                if (comparei(cohorts->WsRequested, L"C:\\Program Files\\WindowsApps"))
+                if (EqualsIgnoringCase(cohorts->WsRequested, L"C:\\Program Files\\WindowsApps"))
                 {
 #if _DEBUG
                     Log(L"[%d] %s: DetermineCohorts: Windows Apps exclusion.", dllInstance, cohorts->WsRequested.c_str());
 #endif
-                    cohorts->WsPackage = cohorts->WsRequested; // ReplacePathPart(cohorts->WsRequested.c_str(), cohorts->map.NativePathBase, cohorts->map.PackagePathBase);
+                    cohorts->WsPackage = cohorts->WsRequested; // StoreReplacedPathPart(cohorts->file_mfr, cohorts->WsRequested, cohorts->map->NativePathBase, cohorts->map->PackagePathBase);
                     cohorts->WsRedirected = cohorts->WsPackage;
-                    cohorts->map.IsAnExclusionToRedirect = true;
+                    cohorts->map = &mfr::ExclusionMapping(*cohorts->map);
                 }
                 else
                 {
-                    cohorts->WsRedirected = ReplacePathPart(cohorts->WsRequested.c_str(), cohorts->map.NativePathBase, cohorts->map.RedirectedPathBase);
-                    cohorts->WsPackage = ReplacePathPart(cohorts->WsRequested.c_str(), cohorts->map.NativePathBase, cohorts->map.PackagePathBase);
+                    cohorts->WsRedirected = StoreReplacedPathPart(cohorts->file_mfr, cohorts->WsRequested, cohorts->map->NativePathBase, cohorts->map->RedirectedPathBase);
+                    cohorts->WsPackage = StoreReplacedPathPart(cohorts->file_mfr, cohorts->WsRequested, cohorts->map->NativePathBase, cohorts->map->PackagePathBase);
                 }
                 cohorts->WsNative = cohorts->WsRequested;
             }
@@ -133,20 +172,20 @@ void DetermineCohorts(std::wstring requestedPath, Cohorts *cohorts, bool UseMore
             Log(L"[%d] %s: DetermineCohorts: Request is in package_pvad_area.", dllInstance, FixupName);
         }
         cohorts->WsPackage = cohorts->WsRequested;
-        cohorts->map = mfr::Find_TraditionalRedirMapping_FromPackagePath_ForwardSearch(cohorts->file_mfr.Request_NormalizedPath.c_str());
-        if (cohorts->map.Valid_mapping)
+        cohorts->map = &mfr::Find_TraditionalRedirMapping_FromPackagePath_ForwardSearch(cohorts->file_mfr.Request_NormalizedPath);
+        if (cohorts->map->Valid_mapping)
         {
             if (UseMoreDebug)
             {
-                Log(L"[%d] %s: DetermineCohorts: Mapping match against traditional  %s", dllInstance, FixupName, cohorts->map.VFSFolderName.c_str());
+                Log(L"[%d] %s: DetermineCohorts: Mapping match against traditional  %s", dllInstance, FixupName, cohorts->map->VFSFolderName.c_str());
             }
-            if (!cohorts->map.IsAnExclusionToRedirect)
+            if (!cohorts->map->IsAnExclusionToRedirect)
             {
                 if (UseMoreDebug)
                 {
-                    Log(L"[%d] %s: DetermineCohorts: Maps with known traditional redirection type %s", dllInstance, FixupName, RedirectFlagsName(cohorts->map.RedirectionFlags));
+                    Log(L"[%d] %s: DetermineCohorts: Maps with known traditional redirection type %s", dllInstance, FixupName, RedirectFlagsName(cohorts->map->RedirectionFlags));
                 }
-                cohorts->WsRedirected = ReplacePathPart(cohorts->WsRequested.c_str(), cohorts->map.PackagePathBase, cohorts->map.RedirectedPathBase);
+                cohorts->WsRedirected = StoreReplacedPathPart(cohorts->file_mfr, cohorts->WsRequested, cohorts->map->PackagePathBase, cohorts->map->RedirectedPathBase);
                 cohorts->UsingNative = false;
             }
             else
@@ -172,22 +211,22 @@ void DetermineCohorts(std::wstring requestedPath, Cohorts *cohorts, bool UseMore
         {
             Log(L"[%d] %s: DetermineCohorts: Request is in_package_vfs_area.", dllInstance, FixupName);
         }
-        cohorts->map = mfr::Find_LocalRedirMapping_FromPackagePath_ForwardSearch(cohorts->file_mfr.Request_NormalizedPath.c_str());
-        if (cohorts->map.Valid_mapping)
+        cohorts->map = &mfr::Find_LocalRedirMapping_FromPackagePath_ForwardSearch(cohorts->file_mfr.Request_NormalizedPath);
+        if (cohorts->map->Valid_mapping)
         {
             if (UseMoreDebug)
             {
-                Log(L"[%d] %s: DetermineCohorts: Mapping match against local  %s", dllInstance, FixupName, cohorts->map.VFSFolderName.c_str());
+                Log(L"[%d] %s: DetermineCohorts: Mapping match against local  %s", dllInstance, FixupName, cohorts->map->VFSFolderName.c_str());
             }
-            if (!cohorts->map.IsAnExclusionToRedirect)
+            if (!cohorts->map->IsAnExclusionToRedirect)
             {
                 if (UseMoreDebug)
                 {
-                    Log(L"[%d] %s: DetermineCohorts: Maps with known local redirection type %s", dllInstance, FixupName, RedirectFlagsName(cohorts->map.RedirectionFlags));
+                    Log(L"[%d] %s: DetermineCohorts: Maps with known local redirection type %s", dllInstance, FixupName, RedirectFlagsName(cohorts->map->RedirectionFlags));
                 }
                 cohorts->WsPackage = cohorts->WsRequested;
-                cohorts->WsRedirected = ReplacePathPart(cohorts->WsRequested.c_str(), cohorts->map.PackagePathBase, cohorts->map.RedirectedPathBase);
-                //cohorts->WsNative = ReplacePathPart(cohorts->WsRequested.c_str(), cohorts->map.PackagePathBase, cohorts->map.NativePathBase);
+                cohorts->WsRedirected = StoreReplacedPathPart(cohorts->file_mfr, cohorts->WsRequested, cohorts->map->PackagePathBase, cohorts->map->RedirectedPathBase);
+                //cohorts->WsNative = StoreReplacedPathPart(cohorts->file_mfr, cohorts->WsRequested, cohorts->map->PackagePathBase, cohorts->map->NativePathBase);
                 cohorts->UsingNative = false;
                 break;
             }
@@ -211,22 +250,22 @@ void DetermineCohorts(std::wstring requestedPath, Cohorts *cohorts, bool UseMore
             }
         }
 
-        cohorts->map = mfr::Find_TraditionalRedirMapping_FromPackagePath_ForwardSearch(cohorts->file_mfr.Request_NormalizedPath.c_str());
-        if (cohorts->map.Valid_mapping)
+        cohorts->map = &mfr::Find_TraditionalRedirMapping_FromPackagePath_ForwardSearch(cohorts->file_mfr.Request_NormalizedPath);
+        if (cohorts->map->Valid_mapping)
         {
             if (UseMoreDebug)
             {
-                Log(L"[%d] %s: DetermineCohorts: Mapping match against traditional  %s", dllInstance, FixupName, cohorts->map.VFSFolderName.c_str());
+                Log(L"[%d] %s: DetermineCohorts: Mapping match against traditional  %s", dllInstance, FixupName, cohorts->map->VFSFolderName.c_str());
             }
-            if (!cohorts->map.IsAnExclusionToRedirect)
+            if (!cohorts->map->IsAnExclusionToRedirect)
             {
                 if (UseMoreDebug)
                 {
-                    Log(L"[%d] %s: DetermineCohorts: Maps with known traditional redirection type %s", dllInstance, FixupName, RedirectFlagsName(cohorts->map.RedirectionFlags));
+                    Log(L"[%d] %s: DetermineCohorts: Maps with known traditional redirection type %s", dllInstance, FixupName, RedirectFlagsName(cohorts->map->RedirectionFlags));
                 }
                 cohorts->WsPackage = cohorts->WsRequested;
-                cohorts->WsRedirected = ReplacePathPart(cohorts->WsRequested.c_str(), cohorts->map.PackagePathBase, cohorts->map.RedirectedPathBase);
-                cohorts->WsNative = ReplacePathPart(cohorts->WsRequested.c_str(), cohorts->map.PackagePathBase, cohorts->map.NativePathBase);
+                cohorts->WsRedirected = StoreReplacedPathPart(cohorts->file_mfr, cohorts->WsRequested, cohorts->map->PackagePathBase, cohorts->map->RedirectedPathBase);
+                cohorts->WsNative = StoreReplacedPathPart(cohorts->file_mfr, cohorts->WsRequested, cohorts->map->PackagePathBase, cohorts->map->NativePathBase);
             }
             else
             {
@@ -252,24 +291,24 @@ void DetermineCohorts(std::wstring requestedPath, Cohorts *cohorts, bool UseMore
         {
             Log(L"[%d] %s: DetermineCohorts: Request is in_redirection_area_writablepackageroot.", dllInstance, FixupName);
         }
-        cohorts->map = mfr::Find_TraditionalRedirMapping_FromRedirectedPath_ForwardSearch(cohorts->file_mfr.Request_NormalizedPath.c_str());
-        if (cohorts->map.Valid_mapping)
+        cohorts->map = &mfr::Find_TraditionalRedirMapping_FromRedirectedPath_ForwardSearch(cohorts->file_mfr.Request_NormalizedPath);
+        if (cohorts->map->Valid_mapping)
         {
             if (UseMoreDebug)
             {
-                Log(L"[%d] %s: DetermineCohorts: Mapping match against traditional  %s", dllInstance, FixupName, cohorts->map.VFSFolderName.c_str());
+                Log(L"[%d] %s: DetermineCohorts: Mapping match against traditional  %s", dllInstance, FixupName, cohorts->map->VFSFolderName.c_str());
             }
-            if (!cohorts->map.IsAnExclusionToRedirect)
+            if (!cohorts->map->IsAnExclusionToRedirect)
             {
                 if (UseMoreDebug)
                 {
-                    Log(L"[%d] %s: DetermineCohorts: Maps with known traditional redirection type %s", dllInstance, FixupName, RedirectFlagsName(cohorts->map.RedirectionFlags));
+                    Log(L"[%d] %s: DetermineCohorts: Maps with known traditional redirection type %s", dllInstance, FixupName, RedirectFlagsName(cohorts->map->RedirectionFlags));
                 }
                 cohorts->WsRedirected = cohorts->WsRequested;
-                cohorts->WsPackage = ReplacePathPart(cohorts->WsRequested.c_str(), cohorts->map.RedirectedPathBase, cohorts->map.PackagePathBase);
+                cohorts->WsPackage = StoreReplacedPathPart(cohorts->file_mfr, cohorts->WsRequested, cohorts->map->RedirectedPathBase, cohorts->map->PackagePathBase);
                 if (cohorts->WsPackage.find(L"\\VFS\\") != std::wstring::npos)
                 {
-                    cohorts->WsNative = ReplacePathPart(cohorts->WsRequested.c_str(), cohorts->map.RedirectedPathBase, cohorts->map.NativePathBase);
+                    cohorts->WsNative = StoreReplacedPathPart(cohorts->file_mfr, cohorts->WsRequested, cohorts->map->RedirectedPathBase, cohorts->map->NativePathBase);
                 }
                 else
                 {
@@ -320,7 +359,7 @@ void DetermineCohorts(std::wstring requestedPath, Cohorts *cohorts, bool UseMore
 
     if (UseMoreDebug)
     {
-        if (cohorts->map.Valid_mapping)
+        if (cohorts->map->Valid_mapping)
         {
             Log(L"[%d] %s: DetermineCohorts:   Cohort->WsRedirected %s", dllInstance, FixupName, cohorts->WsRedirected.c_str());
             Log(L"[%d] %s: DetermineCohorts:   Cohort->WsPackage    %s", dllInstance, FixupName, cohorts->WsPackage.c_str());
@@ -328,7 +367,7 @@ void DetermineCohorts(std::wstring requestedPath, Cohorts *cohorts, bool UseMore
         }
         else
         {
-            Log(L"[%d] %s: DetermineCohorts:   Cohort->map.Valid_Mapping %d", dllInstance, FixupName, cohorts->map.Valid_mapping);
+            Log(L"[%d] %s: DetermineCohorts:   Cohort->map.Valid_Mapping %d", dllInstance, FixupName, cohorts->map->Valid_mapping);
         }
     }
 
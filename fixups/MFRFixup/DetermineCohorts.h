@@ -5,21 +5,29 @@
 //-------------------------------------------------------------------------------------------------------
 
 #include <filesystem>
+#include <string_view>
 #include <dos_paths.h>
 #include "ManagedFileMappings.h"
 #include "ManagedPathTypes.h"
 
+// Cohorts are filled in on every intercepted call, so they refer to the matching entry of the mapping list rather than
+// holding a copy of it, and are passed around by reference.  The paths are null terminated views into the storage of
+// file_mfr, which holds all of them for the call.
 struct Cohorts
 {
-    std::wstring WsRequested;
+    Cohorts() = default;
+    Cohorts(const Cohorts&) = delete;
+    Cohorts& operator=(const Cohorts&) = delete;
+
+    psf::wzstring_view WsRequested;
 
     mfr::mfr_path file_mfr;
-    mfr::mfr_folder_mapping map;
+    const mfr::mfr_folder_mapping* map = &mfr::InvalidMapping();
 
-    std::wstring WsRedirected;
-    std::wstring WsPackage;
-    std::wstring WsNative;
+    psf::wzstring_view WsRedirected;
+    psf::wzstring_view WsPackage;
+    psf::wzstring_view WsNative;
     bool UsingNative = true;
 };
 
-extern void DetermineCohorts(std::wstring requestedPath, Cohorts *cohorts, bool UseMoreDebug, DWORD dllInstance, const wchar_t* FixupName);
\ No newline at end of file
+extern void DetermineCohorts(psf::wzstring_view requestedPath, Cohorts *cohorts, bool UseMoreDebug, DWORD dllInstance, const wchar_t* FixupName);
\ No newline at end of file
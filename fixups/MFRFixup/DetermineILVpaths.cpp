@@ -20,7 +20,7 @@
 extern void CheckFileForIlvAnomoly(DWORD, std::wstring);
 #endif
 
-std::wstring DetermineIlvPathForReadOperations(Cohorts cohorts, [[maybe_unused]] DWORD dllInstance, [[maybe_unused]] bool moredebug)
+std::wstring DetermineIlvPathForReadOperations(const Cohorts& cohorts, [[maybe_unused]] DWORD dllInstance, [[maybe_unused]] bool moredebug)
 {
     // Given the cohorts information for a file path, determine the correct path to use when attempting what would be a read operation under ILV.
     // - For anything with a valid mapping for traditional redirection, this means we want the package path.
@@ -32,11 +32,11 @@ std::wstring DetermineIlvPathForReadOperations(Cohorts cohorts, [[maybe_unused]]
 
     std::wstring UseFile;
     DWORD oldErr = GetLastError();
-    DWORD RequestedAttributes = impl::GetFileAttributes(MakeLongPath(cohorts.WsRequested).c_str());
+    DWORD RequestedAttributes = impl::GetFileAttributes(long_path(cohorts.WsRequested).c_str());
     [[maybe_unused]] DWORD RequestedError = GetLastError();
-    DWORD PackageAttributes = impl::GetFileAttributes(MakeLongPath(cohorts.WsPackage).c_str());
+    DWORD PackageAttributes = impl::GetFileAttributes(long_path(cohorts.WsPackage).c_str());
     [[maybe_unused]] DWORD PackageError = GetLastError();
-    DWORD RedirectedAttributes = impl::GetFileAttributes(MakeLongPath(cohorts.WsRedirected).c_str());
+    DWORD RedirectedAttributes = impl::GetFileAttributes(long_path(cohorts.WsRedirected).c_str());
     [[maybe_unused]] DWORD RedirectedError = GetLastError();
     bool RedirectoinDeletionMarker = false;
     if (RedirectedAttributes != INVALID_FILE_ATTRIBUTES &&
@@ -70,8 +70,8 @@ std::wstring DetermineIlvPathForReadOperations(Cohorts cohorts, [[maybe_unused]]
     switch (cohorts.file_mfr.Request_MfrPathType)
     {
     case mfr::mfr_path_types::in_native_area: 
-        if (cohorts.map.Valid_mapping && !cohorts.map.IsAnExclusionToRedirect &&
-            cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
+        if (cohorts.map->Valid_mapping && !cohorts.map->IsAnExclusionToRedirect &&
+            cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
         {
             // for REQUESTED, PACKAGE, REDIRECTED
             //K1 True, True, True    : means it might or mightnot be native, but we have a redirected copy and it was not deleted:                            USE=Package
@@ -140,9 +140,9 @@ std::wstring DetermineIlvPathForReadOperations(Cohorts cohorts, [[maybe_unused]]
             }
             break;
         }
-        else if (cohorts.map.Valid_mapping && !cohorts.map.IsAnExclusionToRedirect &&
-            (cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
-                cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
+        else if (cohorts.map->Valid_mapping && !cohorts.map->IsAnExclusionToRedirect &&
+            (cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
+                cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
         {
             // for REQUESTED, PACKAGE, REDIRECTED
             //K1 True, True, True    : means it might or mightnot be native, but we have a redirected copy and it was not deleted:                            USE=Package
@@ -220,8 +220,8 @@ std::wstring DetermineIlvPathForReadOperations(Cohorts cohorts, [[maybe_unused]]
         UseFile = cohorts.WsRequested;
         break;
     case mfr::mfr_path_types::in_package_vfs_area:
-        if (cohorts.map.Valid_mapping && !cohorts.map.IsAnExclusionToRedirect &&
-            cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
+        if (cohorts.map->Valid_mapping && !cohorts.map->IsAnExclusionToRedirect &&
+            cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
         {
             if (cohorts.UsingNative && PathExists(cohorts.WsNative.c_str()))
             {
@@ -238,9 +238,9 @@ std::wstring DetermineIlvPathForReadOperations(Cohorts cohorts, [[maybe_unused]]
                 break;
             }
         }
-        else if (cohorts.map.Valid_mapping && !cohorts.map.IsAnExclusionToRedirect &&
-            (cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
-                cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
+        else if (cohorts.map->Valid_mapping && !cohorts.map->IsAnExclusionToRedirect &&
+            (cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
+                cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
         {
             UseFile = cohorts.WsPackage;
             break;
@@ -251,7 +251,7 @@ std::wstring DetermineIlvPathForReadOperations(Cohorts cohorts, [[maybe_unused]]
         }
         break;
     case mfr::mfr_path_types::in_redirection_area_writablepackageroot:
-        if (cohorts.map.Valid_mapping && !cohorts.map.IsAnExclusionToRedirect)
+        if (cohorts.map->Valid_mapping && !cohorts.map->IsAnExclusionToRedirect)
         {
             UseFile = cohorts.WsPackage;
         }
@@ -279,7 +279,7 @@ std::wstring DetermineIlvPathForReadOperations(Cohorts cohorts, [[maybe_unused]]
 }  // DetermineIlvPathForReadOperations()
 
 
-std::wstring DetermineIlvPathForWriteOperations(Cohorts cohorts, [[maybe_unused]] DWORD dllInstance, [[maybe_unused]] bool moredebug)
+std::wstring DetermineIlvPathForWriteOperations(const Cohorts& cohorts, [[maybe_unused]] DWORD dllInstance, [[maybe_unused]] bool moredebug)
 {
     // Given the cohorts information for a file path, determine the correct path to use when attempting what would be a write/create operation under ILV.
     // - For anything with a valid mapping for traditional redirection, this means we want the package path.
@@ -290,15 +290,15 @@ std::wstring DetermineIlvPathForWriteOperations(Cohorts cohorts, [[maybe_unused]
     switch (cohorts.file_mfr.Request_MfrPathType)
     {
     case mfr::mfr_path_types::in_native_area:
-        if (cohorts.map.Valid_mapping && !cohorts.map.IsAnExclusionToRedirect &&
-            cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
+        if (cohorts.map->Valid_mapping && !cohorts.map->IsAnExclusionToRedirect &&
+            cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
         {
             UseFile = cohorts.WsRequested;
             break;
         }
-        else if (cohorts.map.Valid_mapping && !cohorts.map.IsAnExclusionToRedirect &&
-            (cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
-                cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
+        else if (cohorts.map->Valid_mapping && !cohorts.map->IsAnExclusionToRedirect &&
+            (cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
+                cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
         {
             UseFile = cohorts.WsPackage;
             break;
@@ -312,8 +312,8 @@ std::wstring DetermineIlvPathForWriteOperations(Cohorts cohorts, [[maybe_unused]
         UseFile = cohorts.WsRequested;
         break;
     case mfr::mfr_path_types::in_package_vfs_area:
-        if (cohorts.map.Valid_mapping && !cohorts.map.IsAnExclusionToRedirect &&
-            cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
+        if (cohorts.map->Valid_mapping && !cohorts.map->IsAnExclusionToRedirect &&
+            cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
         {
             if (cohorts.UsingNative)
             {
@@ -326,9 +326,9 @@ std::wstring DetermineIlvPathForWriteOperations(Cohorts cohorts, [[maybe_unused]
                 break;
             }
         }
-        else if (cohorts.map.Valid_mapping && !cohorts.map.IsAnExclusionToRedirect &&
-            (cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
-                cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
+        else if (cohorts.map->Valid_mapping && !cohorts.map->IsAnExclusionToRedirect &&
+            (cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
+                cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
         {
             UseFile = cohorts.WsPackage;
             break;
@@ -339,7 +339,7 @@ std::wstring DetermineIlvPathForWriteOperations(Cohorts cohorts, [[maybe_unused]
         }
         break;
     case mfr::mfr_path_types::in_redirection_area_writablepackageroot:
-        if (cohorts.map.Valid_mapping && !cohorts.map.IsAnExclusionToRedirect)
+        if (cohorts.map->Valid_mapping && !cohorts.map->IsAnExclusionToRedirect)
         {
             UseFile = cohorts.WsPackage;
         }
@@ -366,7 +366,7 @@ std::wstring DetermineIlvPathForWriteOperations(Cohorts cohorts, [[maybe_unused]
     return UseFile;
 } // DetermineIlvPathForWriteOperations()
 
-bool IsThisALocalPathNow(std::wstring path)
+bool IsThisALocalPathNow(psf::wzstring_view path)
 {
     mfr::mfr_path mfr = mfr::create_mfr_path(path);
     if (mfr.Request_MfrPathType == mfr::mfr_path_types::in_native_area)
@@ -375,7 +375,7 @@ bool IsThisALocalPathNow(std::wstring path)
     }
     return false;
 } // IsThisLocalPathNow
-bool IsThisAPackagePathNow(std::wstring path)
+bool IsThisAPackagePathNow(psf::wzstring_view path)
 {
     mfr::mfr_path mfr = mfr::create_mfr_path(path);
     if (mfr.Request_MfrPathType == mfr::mfr_path_types::in_package_pvad_area ||
@@ -386,20 +386,20 @@ bool IsThisAPackagePathNow(std::wstring path)
     return false;
 } // IsThisLocalPathNow
 
-std::wstring SelectLocalOrPackageForRead(std::wstring localPath, std::wstring packagePath)
+std::wstring SelectLocalOrPackageForRead(psf::wzstring_view localPath, psf::wzstring_view packagePath)
 {
     if (IsThisALocalPathNow(localPath))
     {
         // In a redirect to local scenario, we are responsible for determing if source is local or in package
         if (!PathExists(localPath.c_str()) && PathExists(packagePath.c_str()))
         {
-            return packagePath;
+            return std::wstring(packagePath);
         }
     }
-    return localPath;
+    return std::wstring(localPath);
 }  // SelectLocalOrPackageForRead()
 
-void PreCreateLocalFoldersIfNeededForWrite(std::wstring localPath, std::wstring packagePath, DWORD dllInstance,  bool debug, std::wstring debugString)
+void PreCreateLocalFoldersIfNeededForWrite(psf::wzstring_view localPath, psf::wzstring_view packagePath, DWORD dllInstance,  bool debug, std::wstring debugString)
 {
     if (IsThisALocalPathNow(localPath))
     {
@@ -415,14 +415,14 @@ void PreCreateLocalFoldersIfNeededForWrite(std::wstring localPath, std::wstring
                 {
                     Log(L"[%d] %s: Pre-create local parent path to match the package first %s", dllInstance, debugString.c_str(), packagePathAsPath.parent_path().c_str());
                 }
-                PreCreateFolders(localPath, dllInstance, debugString.c_str());
+                PreCreateFolders(std::wstring(localPath), dllInstance, debugString.c_str());
 
             }
         }
     }
 } // PreCreateLocalFoldersIfNeededForWrite() // PreCreateLocalFoldersIfNeededForWrite()
 
-void PreCreatePackageFoldersIfIlvNeededForWrite(std::wstring filePath, DWORD dllInstance, bool debug, std::wstring debugString)
+void PreCreatePackageFoldersIfIlvNeededForWrite(psf::wzstring_view filePath, DWORD dllInstance, bool debug, std::wstring debugString)
 {
     if (IsThisAPackagePathNow(filePath))
     {
@@ -436,13 +436,13 @@ void PreCreatePackageFoldersIfIlvNeededForWrite(std::wstring filePath, DWORD dll
                 {
                     Log(L"[%d] %s: Pre-create package parent path to match the package first %s", dllInstance, debugString.c_str(), packagePathAsPath.parent_path().c_str());
                 }
-                PreCreateFolders(filePath, dllInstance, debugString.c_str());
+                PreCreateFolders(std::wstring(filePath), dllInstance, debugString.c_str());
             }
         }
     }
 } // PreCreatePackageFoldersIfIlvNeededForWrite()
 
-void CowLocalFoldersIfNeededForWrite(std::wstring localPath, std::wstring packagePath, DWORD dllInstance, [[maybe_unused]] bool debug, std::wstring debugString)
+void CowLocalFoldersIfNeededForWrite(psf::wzstring_view localPath, psf::wzstring_view packagePath, DWORD dllInstance, [[maybe_unused]] bool debug, std::wstring debugString)
 {
     if (IsThisALocalPathNow(localPath))
     {
@@ -454,7 +454,7 @@ void CowLocalFoldersIfNeededForWrite(std::wstring localPath, std::wstring packag
     }
 } // CowLocalFoldersIfNeededForWrite()
 
-bool IsThisUnsupportedForInterceptsNow(std::wstring path)
+bool IsThisUnsupportedForInterceptsNow(psf::wzstring_view path)
 {
     mfr::mfr_path mfr = mfr::create_mfr_path(path);
     switch (mfr.Request_MfrPathType)
@@ -10,19 +10,19 @@
 #include "ManagedPathTypes.h"
 #include "DetermineCohorts.h"
 
-extern std::wstring DetermineIlvPathForReadOperations(Cohorts cohorts, [[maybe_unused]] DWORD dllInstance, [[maybe_unused]] bool moredebug);
+extern std::wstring DetermineIlvPathForReadOperations(const Cohorts& cohorts, [[maybe_unused]] DWORD dllInstance, [[maybe_unused]] bool moredebug);
 
-extern std::wstring DetermineIlvPathForWriteOperations(Cohorts cohorts, [[maybe_unused]] DWORD dllInstance, [[maybe_unused]] bool moredebug);
+extern std::wstring DetermineIlvPathForWriteOperations(const Cohorts& cohorts, [[maybe_unused]] DWORD dllInstance, [[maybe_unused]] bool moredebug);
 
-extern bool IsThisALocalPathNow(std::wstring path);
-extern bool IsThisAPackagePathNow(std::wstring path);
+extern bool IsThisALocalPathNow(psf::wzstring_view path);
+extern bool IsThisAPackagePathNow(psf::wzstring_view path);
 
-extern std::wstring SelectLocalOrPackageForRead(std::wstring localPath, std::wstring packagePath);
+extern std::wstring SelectLocalOrPackageForRead(psf::wzstring_view localPath, psf::wzstring_view packagePath);
 
-extern void PreCreateLocalFoldersIfNeededForWrite(std::wstring localPath, std::wstring packagePath, DWORD dllInstance,  bool debug,  std::wstring debugString );
+extern void PreCreateLocalFoldersIfNeededForWrite(psf::wzstring_view localPath, psf::wzstring_view packagePath, DWORD dllInstance,  bool debug,  std::wstring debugString );
 
-extern void PreCreatePackageFoldersIfIlvNeededForWrite(std::wstring localPath, DWORD dllInstance, bool debug, std::wstring debugString);
+extern void PreCreatePackageFoldersIfIlvNeededForWrite(psf::wzstring_view localPath, DWORD dllInstance, bool debug, std::wstring debugString);
 
-extern void CowLocalFoldersIfNeededForWrite(std::wstring localPath, std::wstring packagePath, DWORD dllInstance, bool debug, std::wstring debugString);
+extern void CowLocalFoldersIfNeededForWrite(psf::wzstring_view localPath, psf::wzstring_view packagePath, DWORD dllInstance, bool debug, std::wstring debugString);
 
-extern bool IsThisUnsupportedForInterceptsNow(std::wstring path);
\ No newline at end of file
+extern bool IsThisUnsupportedForInterceptsNow(psf::wzstring_view path);
\ No newline at end of file
@@ -0,0 +1,265 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) TMurgent Technologies, LLP. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+
+// Reads one layer of a merged find in batches. The folder is opened and the pattern handed to the file system the same
+// way that FindFirstFileEx does it, so the file system (not us) decides which long and short names match.
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+#include <dos_paths.h>
+#include "FunctionImplementations.h"
+#include "FunctionImplementations_ntdll.h"
+#include "DirectoryBatchSource.h"
+
+extern "C" NTSYSAPI BOOLEAN NTAPI RtlDosPathNameToNtPathName_U(PCWSTR DosFileName, PUNICODE_STRING NtFileName, PWSTR* FilePart, PVOID RelativeName);
+
+namespace
+{
+    constexpr auto FileIdBothDirectoryInformationClass = static_cast<FILE_INFORMATION_CLASS>(37);
+    constexpr NTSTATUS StatusObjectTypeMismatch = static_cast<NTSTATUS>(0xC0000024L);
+    constexpr NTSTATUS StatusObjectNameNotFound = static_cast<NTSTATUS>(0xC0000034L);
+
+    // Holds a few hundred typical entries. FindFirstFileEx reads 64K at a time with FIND_FIRST_EX_LARGE_FETCH, but we
+    // may keep a buffer per layer for as long as the app keeps the find handle open.
+    constexpr ULONG BatchBufferSize = 32 * 1024;
+
+    // The translation that FindFirstFile applies to "?", "*." and ".*" so that the file system matches names the DOS way
+    void TranslateDosWildcards(std::wstring& pattern)
+    {
+        for (size_t i = 0; i < pattern.length(); ++i)
+        {
+            auto next = (i + 1 < pattern.length()) ? pattern[i + 1] : L'\0';
+            switch (pattern[i])
+            {
+            case L'?':
+                pattern[i] = L'>';  // DOS_QM
+                break;
+            case L'*':
+                if (next == L'.')
+                {
+                    pattern[i] = L'<';  // DOS_STAR
+                }
+                break;
+            case L'.':
+                if ((next == L'?') || (next == L'*'))
+                {
+                    pattern[i] = L'"';  // DOS_DOT
+                }
+                break;
+            }
+        }
+    }
+}
+
+directory_batch_source::directory_batch_source(directory_batch_source&& other) noexcept :
+    m_directory(std::exchange(other.m_directory, nullptr)),
+    m_buffer(std::move(other.m_buffer)),
+    m_pending(std::exchange(other.m_pending, false)),
+    m_error(other.m_error)
+{
+}
+
+directory_batch_source& directory_batch_source::operator=(directory_batch_source&& other) noexcept
+{
+    if (this != &other)
+    {
+        close();
+        m_directory = std::exchange(other.m_directory, nullptr);
+        m_buffer = std::move(other.m_buffer);
+        m_pending = std::exchange(other.m_pending, false);
+        m_error = other.m_error;
+    }
+    return *this;
+}
+
+directory_batch_source::~directory_batch_source()
+{
+    close();
+}
+
+void directory_batch_source::close() noexcept
+{
+    if (m_directory)
+    {
+        ::NtClose(m_directory);
+        m_directory = nullptr;
+    }
+    m_pending = false;
+}
+
+bool directory_batch_source::supports(const std::wstring& findPattern)
+{
+    switch (psf::path_type(findPattern.c_str()))
+    {
+    case psf::dos_path_type::drive_absolute:
+    case psf::dos_path_type::unc_absolute:
+    case psf::dos_path_type::root_local_device:
+        break;
+    default:
+        return false;
+    }
+
+    auto split = findPattern.find_last_of(L'\\');
+    if ((split == std::wstring::npos) || (split + 1 == findPattern.length()))
+    {
+        return false;
+    }
+
+    std::wstring_view fileName(findPattern.c_str() + split + 1, findPattern.length() - split - 1);
+    if ((fileName.back() == L'.') || (fileName.back() == L' '))
+    {
+        return false;
+    }
+    return fileName.find_first_of(L"<>\":/") == std::wstring_view::npos;
+}
+
+DWORD directory_batch_source::open(const std::wstring& findPattern)
+{
+    close();
+
+    UNICODE_STRING ntPath{};
+    if (!RtlDosPathNameToNtPathName_U(findPattern.c_str(), &ntPath, nullptr, nullptr))
+    {
+        return ERROR_PATH_NOT_FOUND;
+    }
+
+    std::wstring_view path(ntPath.Buffer, ntPath.Length / sizeof(wchar_t));
+    auto split = path.find_last_of(L'\\');
+    std::wstring pattern(path.substr(split + 1));
+    TranslateDosWildcards(pattern);
+
+    // Keep the separator of a drive root ("\??\C:\")
+    auto directoryLength = ((split > 0) && (path[split - 1] == L':')) ? split + 1 : split;
+    UNICODE_STRING directory;
+    directory.Buffer = ntPath.Buffer;
+    directory.Length = static_cast<USHORT>(directoryLength * sizeof(wchar_t));
+    directory.MaximumLength = directory.Length;
+
+    OBJECT_ATTRIBUTES attributes;
+    InitializeObjectAttributes(&attributes, &directory, OBJ_CASE_INSENSITIVE, nullptr, nullptr);
+    IO_STATUS_BLOCK ioStatus{};
+    HANDLE handle = nullptr;
+    auto status = ::NtOpenFile(&handle, FILE_LIST_DIRECTORY | SYNCHRONIZE, &attributes, &ioStatus,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        FILE_DIRECTORY_FILE | FILE_SYNCHRONOUS_IO_NONALERT | FILE_OPEN_FOR_BACKUP_INTENT);
+    ::RtlFreeUnicodeString(&ntPath);
+    if (!NT_SUCCESS(status))
+    {
+        // As FindFirstFile reports it, the folder part of the request is a path
+        if ((status == StatusObjectNameNotFound) || (status == StatusObjectTypeMismatch))
+        {
+            return ERROR_PATH_NOT_FOUND;
+        }
+        return ::RtlNtStatusToDosError(status);
+    }
+    m_directory = handle;
+
+    auto error = query(&pattern);
+    if (error != ERROR_SUCCESS)
+    {
+        close();
+        return (error == ERROR_NO_MORE_FILES) ? ERROR_FILE_NOT_FOUND : error;
+    }
+    m_pending = true;
+    return ERROR_SUCCESS;
+}
+
+DWORD directory_batch_source::query(const std::wstring* pattern)
+{
+    if (!m_buffer)
+    {
+        m_buffer = std::make_unique<std::byte[]>(BatchBufferSize);
+    }
+
+    UNICODE_STRING fileName{};
+    if (pattern)
+    {
+        fileName.Buffer = const_cast<PWSTR>(pattern->c_str());
+        fileName.Length = static_cast<USHORT>(pattern->length() * sizeof(wchar_t));
+        fileName.MaximumLength = fileName.Length;
+    }
+
+    // The trampoline, so that our own ZwQueryDirectoryFile intercept does not see this
+    IO_STATUS_BLOCK ioStatus{};
+    auto status = ntdllimpl::ZwQueryDirectoryFileImpl(m_directory, nullptr, nullptr, nullptr, &ioStatus,
+        m_buffer.get(), BatchBufferSize, FileIdBothDirectoryInformationClass, FALSE,
+        pattern ? &fileName : nullptr, pattern ? TRUE : FALSE);
+    if (!NT_SUCCESS(status))
+    {
+        return ::RtlNtStatusToDosError(status);
+    }
+    return ERROR_SUCCESS;
+}
+
+psf::directory_batch_result directory_batch_source::read_batch(std::vector<entry_type>& batch)
+{
+    if (!m_directory)
+    {
+        return psf::directory_batch_result::end;
+    }
+
+    if (!m_pending)
+    {
+        auto error = query(nullptr);
+        if (error == ERROR_NO_MORE_FILES)
+        {
+            close();
+            m_buffer.reset();
+            return psf::directory_batch_result::end;
+        }
+        else if (error != ERROR_SUCCESS)
+        {
+            m_error = error;
+            return psf::directory_batch_result::failed;
+        }
+    }
+    m_pending = false;
+
+    auto position = m_buffer.get();
+    while (true)
+    {
+        auto info = reinterpret_cast<const FILE_ID_BOTH_DIR_INFO*>(position);
+        batch.push_back(entry_type{ info });
+        if (info->NextEntryOffset == 0)
+        {
+            break;
+        }
+        position += info->NextEntryOffset;
+    }
+    return psf::directory_batch_result::entries;
+}
+
+void directory_batch_source::to_find_data(const entry_type& entry, bool basicInfo, WIN32_FIND_DATAW& findData) noexcept
+{
+    auto info = entry.info;
+    findData.dwFileAttributes = info->FileAttributes;
+    findData.ftCreationTime.dwLowDateTime = info->CreationTime.LowPart;
+    findData.ftCreationTime.dwHighDateTime = static_cast<DWORD>(info->CreationTime.HighPart);
+    findData.ftLastAccessTime.dwLowDateTime = info->LastAccessTime.LowPart;
+    findData.ftLastAccessTime.dwHighDateTime = static_cast<DWORD>(info->LastAccessTime.HighPart);
+    findData.ftLastWriteTime.dwLowDateTime = info->LastWriteTime.LowPart;
+    findData.ftLastWriteTime.dwHighDateTime = static_cast<DWORD>(info->LastWriteTime.HighPart);
+    findData.nFileSizeHigh = static_cast<DWORD>(info->EndOfFile.HighPart);
+    findData.nFileSizeLow = info->EndOfFile.LowPart;
+
+    // For reparse points the file system returns the reparse tag in place of the EA size, and FindFirstFile passes it on
+    findData.dwReserved0 = (info->FileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) ? info->EaSize : 0;
+    findData.dwReserved1 = 0;
+
+    auto name = entry.name();
+    auto nameLength = (std::min)(name.length(), std::size(findData.cFileName) - 1);
+    std::copy_n(name.data(), nameLength, findData.cFileName);
+    findData.cFileName[nameLength] = L'\0';
+
+    size_t shortNameLength = 0;
+    if (!basicInfo)
+    {
+        shortNameLength = (std::min)(static_cast<size_t>(info->ShortNameLength) / sizeof(wchar_t), std::size(findData.cAlternateFileName) - 1);
+        std::copy_n(info->ShortName, shortNameLength, findData.cAlternateFileName);
+    }
+    findData.cAlternateFileName[shortNameLength] = L'\0';
+}
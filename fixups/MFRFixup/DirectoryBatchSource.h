@@ -0,0 +1,69 @@
+#pragma once
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) TMurgent Technologies, LLP. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+
+// One layer of a merged FindFirstFile/FindNextFile enumeration, read with NtQueryDirectoryFile into a buffer of
+// FILE_ID_BOTH_DIR_INFO entries so that a whole batch of names is fetched (and merged) per call instead of one name
+// per FindNextFile call.  See merged_directory_enumeration.h for how the layers are combined.
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <windows.h>
+#include <merged_directory_enumeration.h>
+
+
+class directory_batch_source
+{
+public:
+
+    struct entry_type
+    {
+        const FILE_ID_BOTH_DIR_INFO* info;
+
+        std::wstring_view name() const noexcept
+        {
+            return std::wstring_view(info->FileName, info->FileNameLength / sizeof(wchar_t));
+        }
+    };
+
+    directory_batch_source() = default;
+    directory_batch_source(directory_batch_source&& other) noexcept;
+    directory_batch_source& operator=(directory_batch_source&& other) noexcept;
+    ~directory_batch_source();
+
+    // Whether the FindFirstFile pattern can be listed here; anything else (relative paths, stream or DOS wildcard
+    // syntax, trailing dots or spaces) is left to FindFirstFile itself.
+    static bool supports(const std::wstring& findPattern);
+
+    // Opens the folder and reads the first batch. Returns ERROR_SUCCESS when at least one entry matched, otherwise the
+    // error that FindFirstFile would report for the pattern.
+    DWORD open(const std::wstring& findPattern);
+
+    psf::directory_batch_result read_batch(std::vector<entry_type>& batch);
+
+    // The error behind the last failed read
+    DWORD last_error() const noexcept
+    {
+        return m_error;
+    }
+
+    // Fills in the data that FindFirstFile/FindNextFile return; the short name is left empty for FindExInfoBasic.
+    static void to_find_data(const entry_type& entry, bool basicInfo, WIN32_FIND_DATAW& findData) noexcept;
+
+private:
+
+    void close() noexcept;
+    DWORD query(const std::wstring* pattern);
+
+    HANDLE m_directory = nullptr;
+    std::unique_ptr<std::byte[]> m_buffer;
+
+    // Set while the batch read by open() has not been handed out yet
+    bool m_pending = false;
+    DWORD m_error = ERROR_SUCCESS;
+};
@@ -8,6 +8,9 @@
 #include <filesystem>
 #include <dos_paths.h>
 #include "fancy_handle.h"
+#include <file_name_set.h>
+#include <user_locale_fold.h>
+#include "DirectoryBatchSource.h"
 
 
 struct find_deleter
@@ -39,6 +42,8 @@ enum FindDataResult
     Result_Native = 2
 };
 
+using merged_find = psf::merged_directory_enumeration<directory_batch_source, psf::user_locale_fold>;
+
 struct FindData3
 {
     // Redirected path directory so that we can avoid returning duplicate filenames. This value will be empty if the
@@ -48,7 +53,7 @@ struct FindData3
     //std::wstring wsNative_path;
     //std::wstring wsPackage_path;
     //std::wstring wsRedirected_path;
-    std::list<std::wstring> wsAlready_returned_list = {};
+    psf::file_name_set<psf::user_locale_fold> wsAlready_returned_list;
 
     // There are three different locations where we might find things, stored in the find_handles array and used in the following order:
     //    The first (optional) value is the find handle for the "redirected path" (typically to the user's profile). Set when original is a package path.
@@ -64,5 +69,10 @@ struct FindData3
     // We need to hold on to the results of FindFirstFile for find_handles[0/1/2/3/4] 
     WIN32_FIND_DATAW cached_data;
 
+    // Used instead of find_handles when the layers are read in batches (see StartMergedFind); the merge then does its
+    // own tracking of the names already returned.
+    std::unique_ptr<merged_find> merged;
+    bool merged_basic_info = false;
+
     DWORD RememberedInstance = 0;
 };
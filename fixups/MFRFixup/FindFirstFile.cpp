@@ -76,7 +76,7 @@ HANDLE __stdcall FindFirstFileFixup(_In_ const CharT* fileName, _Out_ win32_find
         LogString(dllInstance, L"FindFirstFileFixup: for fileName", fileName);
 #endif
        
-        wfileName = AdjustBadUNC(wfileName, dllInstance, L"FindFirstFileFixup");
+        wfileName = AdjustBadUNC(std::move(wfileName), dllInstance, L"FindFirstFileFixup");
 
         // Determine possible paths involved
         Cohorts cohorts; 
@@ -104,6 +104,37 @@ HANDLE __stdcall FindFirstFileFixup(_In_ const CharT* fileName, _Out_ win32_find
         WIN32_FIND_DATAW* findData = psf::is_ansi<CharT> ? &result->cached_data : wideData;
         DWORD initialFindError = ERROR_PATH_NOT_FOUND;
 
+        // Read the layers in batches when we can, otherwise fall back to a find handle per layer
+        if (StartMergedFind(*result, cohorts, false, initialFindError, dllInstance))
+        {
+            if (initialFindError != ERROR_SUCCESS)
+            {
+#if _DEBUG
+                Log(L"[%d] FindFirstFileFixup returns 0x%x", dllInstance, initialFindError);
+#endif
+                ::SetLastError(initialFindError);
+                return INVALID_HANDLE_VALUE;
+            }
+
+            if constexpr (psf::is_ansi<CharT>)
+            {
+                if (copy_find_data(result->cached_data, *ansiData))
+                {
+                    // NOTE: Last error set by caller
+                    return INVALID_HANDLE_VALUE;
+                }
+            }
+            else
+            {
+                copy_find_data(result->cached_data, *wideData);
+            }
+#if _DEBUG
+            Log(L"[%d] FindFirstFileFixup returns %ls", dllInstance, result->cached_data.cFileName);
+#endif
+            ::SetLastError(ERROR_SUCCESS);
+            return reinterpret_cast<HANDLE>(result.release());
+        }
+
         // First find the redirected area results
         std::wstring rldUseFile = MakeLongPath(cohorts.WsRedirected);
         result->find_handles[Result_Redirected].reset(impl::FindFirstFile(rldUseFile.c_str(), findData));
@@ -288,7 +319,7 @@ HANDLE __stdcall FindFirstFileFixup(_In_ const CharT* fileName, _Out_ win32_find
                 Log(L"[%d] FindFirstFileFixup returns %ls", dllInstance, result->cached_data.cFileName);
             }
 #endif
-            result->wsAlready_returned_list.push_back(result->cached_data.cFileName);
+            result->wsAlready_returned_list.insert(result->cached_data.cFileName);
             ::SetLastError(ERROR_SUCCESS);
 
         }
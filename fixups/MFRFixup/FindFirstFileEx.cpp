@@ -77,7 +77,7 @@ HANDLE __stdcall FindFirstFileExFixup(_In_ const CharT* fileName,
     if (guard)
     {
         std::wstring wfileName = widen(fileName);
-        wfileName = AdjustSlashes(wfileName);
+        wfileName = AdjustSlashes(std::move(wfileName));
 
         auto result = std::make_unique<FindData3>();
         result->RememberedInstance = dllInstance;
@@ -127,7 +127,7 @@ HANDLE __stdcall FindFirstFileExFixup(_In_ const CharT* fileName,
             break;
         }
 #endif
-        wfileName = AdjustBadUNC(wfileName, dllInstance, L"FindFirstFileExFixup");
+        wfileName = AdjustBadUNC(std::move(wfileName), dllInstance, L"FindFirstFileExFixup");
 
         // Determine possible paths involved
         Cohorts cohorts;
@@ -153,6 +153,40 @@ HANDLE __stdcall FindFirstFileExFixup(_In_ const CharT* fileName,
         WIN32_FIND_DATAW* findData = psf::is_ansi<CharT> ? &result->cached_data : wideData;
         DWORD initialFindError = ERROR_PATH_NOT_FOUND;
 
+        // Read the layers in batches when we can, otherwise fall back to a find handle per layer
+        if (((infoLevelId == FindExInfoStandard) || (infoLevelId == FindExInfoBasic)) &&
+            ((searchOp == FindExSearchNameMatch) || (searchOp == FindExSearchLimitToDirectories)) &&
+            ((additionalFlags & ~FIND_FIRST_EX_LARGE_FETCH) == 0) &&
+            StartMergedFind(*result, cohorts, infoLevelId == FindExInfoBasic, initialFindError, dllInstance))
+        {
+            if (initialFindError != ERROR_SUCCESS)
+            {
+#if _DEBUG
+                Log(L"[%d] FindFirstFileExFixup returns 0x%x", dllInstance, initialFindError);
+#endif
+                ::SetLastError(initialFindError);
+                return INVALID_HANDLE_VALUE;
+            }
+
+            if constexpr (psf::is_ansi<CharT>)
+            {
+                if (copy_find_data(result->cached_data, *ansiData))
+                {
+                    // NOTE: Last error set by caller
+                    return INVALID_HANDLE_VALUE;
+                }
+            }
+            else
+            {
+                copy_find_data(result->cached_data, *wideData);
+            }
+#if _DEBUG
+            Log(L"[%d] FindFirstFileExFixup returns %ls", dllInstance, result->cached_data.cFileName);
+#endif
+            ::SetLastError(ERROR_SUCCESS);
+            return reinterpret_cast<HANDLE>(result.release());
+        }
+
         // First find the redirected area results
         std::wstring rldUseFile = MakeLongPath(cohorts.WsRedirected);
         result->find_handles[Result_Redirected].reset(impl::FindFirstFileEx(rldUseFile.c_str(), infoLevelId, findData, searchOp, searchFilter, additionalFlags));
@@ -309,7 +343,7 @@ HANDLE __stdcall FindFirstFileExFixup(_In_ const CharT* fileName,
 #if _DEBUG
             Log(L"[%d] FindFirstFileExFixup returns %ls", dllInstance, result->cached_data.cFileName);
 #endif
-            result->wsAlready_returned_list.push_back(result->cached_data.cFileName);
+            result->wsAlready_returned_list.insert(result->cached_data.cFileName);
             ::SetLastError(ERROR_SUCCESS);
 
         }
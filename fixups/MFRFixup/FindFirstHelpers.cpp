@@ -74,3 +74,74 @@ DWORD copy_find_data(const WIN32_FIND_DATAA& from, WIN32_FIND_DATAW& to) noexcep
 
     return ERROR_SUCCESS;
 }
+
+bool StartMergedFind(FindData3& data, const Cohorts& cohorts, bool basicInfo, DWORD& error, [[maybe_unused]] DWORD dllInstance)
+{
+    // Same order (and so the same priority) as the find_handles
+    std::wstring paths[3];
+    paths[Result_Redirected] = MakeLongPath(cohorts.WsRedirected);
+    paths[Result_Package] = MakeLongPath(cohorts.WsPackage);
+    int layerCount = 2;
+    if (cohorts.UsingNative)
+    {
+        paths[Result_Native] = MakeLongPath(cohorts.WsNative);
+        layerCount = 3;
+    }
+    for (int layer = 0; layer < layerCount; ++layer)
+    {
+        if (!directory_batch_source::supports(paths[layer]))
+        {
+            return false;
+        }
+    }
+
+    auto merged = std::make_unique<merged_find>();
+    for (int layer = 0; layer < layerCount; ++layer)
+    {
+        directory_batch_source source;
+        auto layerError = source.open(paths[layer]);
+        // Some applications really care about the failure reason. Try and make this the best that we can, preferring
+        // something like "file not found" over "path does not exist"
+        if (layer == Result_Redirected)
+        {
+            error = layerError;
+        }
+        else if (layerError == ERROR_SUCCESS)
+        {
+            error = ERROR_SUCCESS;
+        }
+        else if ((error != ERROR_SUCCESS) && (layerError == ERROR_FILE_NOT_FOUND))
+        {
+            error = ERROR_FILE_NOT_FOUND;
+        }
+
+        if (layerError == ERROR_SUCCESS)
+        {
+#if _DEBUG
+            Log(L"[%d] StartMergedFind[%d]: had results.", dllInstance, layer);
+#endif
+            merged->add_layer(std::move(source));
+        }
+        else
+        {
+#if _DEBUG
+            Log(L"[%d] StartMergedFind[%d]: no results 0x%x.", dllInstance, layer, layerError);
+#endif
+        }
+    }
+    if (error != ERROR_SUCCESS)
+    {
+        return true;
+    }
+
+    auto first = merged->next();
+    if (!first)
+    {
+        error = merged->failed() ? merged->layer(merged->current_layer()).last_error() : ERROR_FILE_NOT_FOUND;
+        return true;
+    }
+    directory_batch_source::to_find_data(*first, basicInfo, data.cached_data);
+    data.merged = std::move(merged);
+    data.merged_basic_info = basicInfo;
+    return true;
+}
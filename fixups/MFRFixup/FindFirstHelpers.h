@@ -15,6 +15,7 @@
 #include <psf_logging.h>
 #include <memory>
 #include "FindData3.h"
+#include "DetermineCohorts.h"
 
 
 
@@ -27,3 +28,8 @@ using win32_find_data_t = std::conditional_t<psf::is_ansi<CharT>, WIN32_FIND_DAT
 extern DWORD copy_find_data(const WIN32_FIND_DATAW& from, WIN32_FIND_DATAA& to) noexcept;
 extern DWORD copy_find_data(const WIN32_FIND_DATAW& from, WIN32_FIND_DATAW& to) noexcept;
 extern DWORD copy_find_data(const WIN32_FIND_DATAA& from, WIN32_FIND_DATAW& to) noexcept;
+
+// Lists the layers of a find request with batched directory reads (see DirectoryBatchSource.h). Returns false, leaving
+// data alone, when a layer needs to be listed by FindFirstFile itself. Otherwise error is set either to ERROR_SUCCESS,
+// with the first entry in data.cached_data, or to the error that the request should fail with.
+extern bool StartMergedFind(FindData3& data, const Cohorts& cohorts, bool basicInfo, DWORD& error, DWORD dllInstance);
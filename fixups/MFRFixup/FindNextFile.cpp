@@ -19,9 +19,7 @@
 #include <psf_logging.h>
 #include <memory>
 #include "FindData3.h"
-
-template <typename CharT>
-using win32_find_data_t = std::conditional_t<psf::is_ansi<CharT>, WIN32_FIND_DATAA, WIN32_FIND_DATAW>;
+#include "FindFirstHelpers.h"
 
 
 template <typename CharT>
@@ -58,7 +56,40 @@ BOOL __stdcall FindNextFileFixup(_In_ HANDLE findFile, _Out_ win32_find_data_t<C
 #endif
 #endif
 
-        auto wasFileAlreadyProvided = [&](std::wstring findrequest, auto filename)
+        if (data->merged)
+        {
+            if (auto entry = data->merged->next())
+            {
+                if constexpr (psf::is_ansi<CharT>)
+                {
+                    WIN32_FIND_DATAW wideData;
+                    directory_batch_source::to_find_data(*entry, data->merged_basic_info, wideData);
+                    if (copy_find_data(wideData, *findFileData))
+                    {
+                        // NOTE: Last error set by caller
+                        return FALSE;
+                    }
+                }
+                else
+                {
+                    directory_batch_source::to_find_data(*entry, data->merged_basic_info, *findFileData);
+                }
+#if _DEBUG
+                Log(L"[%d][%d] FindNextFileFixup (batched) returns TRUE with ERROR_SUCCESS and file %ls", data->RememberedInstance, dllInstance, widen(findFileData->cFileName).c_str());
+#endif
+                ::SetLastError(ERROR_SUCCESS);
+                return TRUE;
+            }
+
+            auto error = data->merged->failed() ? data->merged->layer(data->merged->current_layer()).last_error() : ERROR_NO_MORE_FILES;
+#if _DEBUG
+            Log(L"[%d][%d] FindNextFileFixup (batched) returns FALSE 0x%x", data->RememberedInstance, dllInstance, error);
+#endif
+            ::SetLastError(error);
+            return FALSE;
+        }
+
+        auto wasFileAlreadyProvided = [&](auto filename)
         {
 #if _DEBUG
             LogString(data->RememberedInstance, dllInstance, L"\tFindNextFileFixup wasFileAlreadyProvided versus ", filename);
@@ -85,24 +116,13 @@ BOOL __stdcall FindNextFileFixup(_In_ HANDLE findFile, _Out_ win32_find_data_t<C
                 wFilename = filename;
             }
 
-            // always return false on directories as these are always considered merged.
-            std::filesystem::path fullpath = findrequest.c_str();
-            fullpath = fullpath.parent_path() / wFilename.c_str();
-
-            _locale_t locale = _wcreate_locale(LC_ALL, L"");
-            for (std::wstring check : data->wsAlready_returned_list)
+            if (data->wsAlready_returned_list.contains(wFilename))
             {
-                //            if (check.compare(wFilename.c_str()) == 0)
-                if (_wcsicmp_l(check.c_str(), wFilename.c_str(), locale) == 0)
-                {
 #if MOREDEBUG
-                    Log(L"[%d][%d]\tFindNextFileFixup A wasFileAlreadyProvided returns true %ls", data->RememberedInstance, dllInstance, wFilename.c_str());
+                Log(L"[%d][%d]\tFindNextFileFixup A wasFileAlreadyProvided returns true %ls", data->RememberedInstance, dllInstance, wFilename.c_str());
 #endif
-                    _free_locale(locale);
-                    return true;
-                }
+                return true;
             }
-            _free_locale(locale);
 
 #if MOREDEBUG
             Log(L"[%d][%d]\tFindNextFileFixup wasFileAlreadyProvided returns false", data->RememberedInstance, dllInstance);
@@ -116,12 +136,12 @@ BOOL __stdcall FindNextFileFixup(_In_ HANDLE findFile, _Out_ win32_find_data_t<C
             if (impl::FindNextFile(data->find_handles[Result_Redirected].get(), findFileData))
             {
                 // Skip the file if the name was previously used, unless it is a directory
-                if (!wasFileAlreadyProvided(data->requested_path, findFileData->cFileName))
+                if (!wasFileAlreadyProvided(findFileData->cFileName))
                 {
 #if _DEBUG
                     Log(L"[%d][%d] FindNextFileFixup[%d] returns TRUE with ERROR_SUCCESS and file %ls", data->RememberedInstance, dllInstance, Result_Redirected, widen(findFileData->cFileName).c_str());
 #endif
-                    data->wsAlready_returned_list.push_back(widen(findFileData->cFileName));
+                    data->wsAlready_returned_list.insert(widen(findFileData->cFileName));
                     ::SetLastError(ERROR_SUCCESS);
                     return TRUE;
                 }
@@ -156,12 +176,12 @@ BOOL __stdcall FindNextFileFixup(_In_ HANDLE findFile, _Out_ win32_find_data_t<C
             if (impl::FindNextFile(data->find_handles[Result_Package].get(), findFileData))
             {
                 // Skip the file if the name was previously used, unless it is a directory
-                if (!wasFileAlreadyProvided(data->requested_path, findFileData->cFileName))
+                if (!wasFileAlreadyProvided(findFileData->cFileName))
                 {
 #if _DEBUG
                     Log(L"[%d][%d] FindNextFileFixup[%d] returns TRUE with ERROR_SUCCESS and file %ls", data->RememberedInstance, dllInstance, Result_Package, widen(findFileData->cFileName).c_str());
 #endif
-                    data->wsAlready_returned_list.push_back(widen(findFileData->cFileName));
+                    data->wsAlready_returned_list.insert(widen(findFileData->cFileName));
                     ::SetLastError(ERROR_SUCCESS);
                     return TRUE;
                 }
@@ -196,12 +216,12 @@ BOOL __stdcall FindNextFileFixup(_In_ HANDLE findFile, _Out_ win32_find_data_t<C
             if (impl::FindNextFile(data->find_handles[Result_Native].get(), findFileData))
             {
                 // Skip the file if the name was previously used, unless it is a directory
-                if (!wasFileAlreadyProvided(data->requested_path, findFileData->cFileName))
+                if (!wasFileAlreadyProvided(findFileData->cFileName))
                 {
 #if _DEBUG
                     Log(L"[%d][%d] FindNextFileFixup[%d] returns TRUE with ERROR_SUCCESS and file %ls", data->RememberedInstance, dllInstance, Result_Native, widen(findFileData->cFileName).c_str());
 #endif
-                    data->wsAlready_returned_list.push_back(widen(findFileData->cFileName));
+                    data->wsAlready_returned_list.insert(widen(findFileData->cFileName));
                     ::SetLastError(ERROR_SUCCESS);
                     return TRUE;
                 }
@@ -26,7 +26,7 @@
 
 #define WRAPPER_GETFILEATTRIBUTES(theDestinationFilename, debug, moredebug, wsWhich) \
     { \
-        std::wstring LongDestinationFilename = MakeLongPath(theDestinationFilename); \
+        long_path LongDestinationFilename(theDestinationFilename); \
         retfinal = impl::GetFileAttributesW(LongDestinationFilename.c_str()); \
         DWORD error = GetLastError(); \
         if (retfinal != INVALID_FILE_ATTRIBUTES) \
@@ -72,7 +72,7 @@ DWORD __stdcall GetFileAttributesFixup(_In_ const CharT* fileName) noexcept
         {
             dllInstance = ++g_InterceptInstance;
             std::wstring wfileName = widen(fileName);
-            wfileName = AdjustSlashes(wfileName);
+            wfileName = AdjustSlashes(std::move(wfileName));
 
 
             if constexpr (psf::is_ansi<CharT>)
@@ -88,7 +88,7 @@ DWORD __stdcall GetFileAttributesFixup(_In_ const CharT* fileName) noexcept
 #endif
             }
 
-            wfileName = AdjustBadUNC(wfileName, dllInstance, L"GetFileAttributesFixup");
+            wfileName = AdjustBadUNC(std::move(wfileName), dllInstance, L"GetFileAttributesFixup");
             
 
 #if DEBUGPATHTESTING
@@ -110,12 +110,12 @@ DWORD __stdcall GetFileAttributesFixup(_In_ const CharT* fileName) noexcept
                 switch (cohorts.file_mfr.Request_MfrPathType)
                 {
                 case mfr::mfr_path_types::in_native_area:
-                    if (cohorts.map.Valid_mapping)
+                    if (cohorts.map->Valid_mapping)
                     {
-                        switch (cohorts.map.RedirectionFlags)
+                        switch (cohorts.map->RedirectionFlags)
                         {
                         case mfr::mfr_redirect_flags::prefer_redirection_local:
-                            if (!cohorts.map.IsAnExclusionToRedirect)
+                            if (!cohorts.map->IsAnExclusionToRedirect)
                             {
                                 // try the request path, which must be the local redirected version by definition, and then a package equivalent = 
                                     WRAPPER_GETFILEATTRIBUTES(cohorts.WsRedirected, debug, moreDebug, L"WsRedirected");  // returns if successful.                                
@@ -142,7 +142,7 @@ DWORD __stdcall GetFileAttributesFixup(_In_ const CharT* fileName) noexcept
                             return retfinal;
                         case mfr::mfr_redirect_flags::prefer_redirection_containerized:
                         case mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs:
-                            if (!cohorts.map.IsAnExclusionToRedirect)
+                            if (!cohorts.map->IsAnExclusionToRedirect)
                             {
                                 // try the redirected path, then package, then native.
                                 WRAPPER_GETFILEATTRIBUTES(cohorts.WsRedirected, debug, moreDebug, L"WsRedirected");   // returns if successful.
@@ -175,9 +175,9 @@ DWORD __stdcall GetFileAttributesFixup(_In_ const CharT* fileName) noexcept
                     break;
                 case mfr::mfr_path_types::in_package_pvad_area:
                     /// NOTE: Ilv does not allow accessing PVAD files in the package.  PERIOD!!!  So this call will always fail.
-                    if (cohorts.map.Valid_mapping)
+                    if (cohorts.map->Valid_mapping)
                     {
-                        if (!cohorts.map.IsAnExclusionToRedirect)
+                        if (!cohorts.map->IsAnExclusionToRedirect)
                         {
                             Log(L"[%d] GetFileAttributes try redirected... ", dllInstance);
                             //// try the redirected path, then package, then don't need native.
@@ -203,12 +203,12 @@ DWORD __stdcall GetFileAttributesFixup(_In_ const CharT* fileName) noexcept
                     }
                     break;
                 case mfr::mfr_path_types::in_package_vfs_area:
-                    if (cohorts.map.Valid_mapping)
+                    if (cohorts.map->Valid_mapping)
                     {
-                        switch (cohorts.map.RedirectionFlags)
+                        switch (cohorts.map->RedirectionFlags)
                         {
                         case mfr::mfr_redirect_flags::prefer_redirection_local:
-                            if (!cohorts.map.IsAnExclusionToRedirect)
+                            if (!cohorts.map->IsAnExclusionToRedirect)
                             {
                                 WRAPPER_GETFILEATTRIBUTES(cohorts.WsRedirected, debug, moreDebug, L"WsRedirected");   // returns if successful.                              
                             }
@@ -230,7 +230,7 @@ DWORD __stdcall GetFileAttributesFixup(_In_ const CharT* fileName) noexcept
                             return retfinal;
                         case mfr::mfr_redirect_flags::prefer_redirection_containerized:
                         case mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs:
-                            if (!cohorts.map.IsAnExclusionToRedirect)
+                            if (!cohorts.map->IsAnExclusionToRedirect)
                             {
                                 // try the redirected path, then package, then native.
                                 WRAPPER_GETFILEATTRIBUTES(cohorts.WsRedirected, debug, moreDebug, L"WsRedirected");  // returns if successful.
@@ -262,16 +262,16 @@ DWORD __stdcall GetFileAttributesFixup(_In_ const CharT* fileName) noexcept
                     }
                     break;
                 case mfr::mfr_path_types::in_redirection_area_writablepackageroot:
-                    if (cohorts.map.Valid_mapping)
+                    if (cohorts.map->Valid_mapping)
                     {
-                        switch (cohorts.map.RedirectionFlags)
+                        switch (cohorts.map->RedirectionFlags)
                         {
                         case mfr::mfr_redirect_flags::prefer_redirection_local:
                             // not possible
                             break;
                         case mfr::mfr_redirect_flags::prefer_redirection_containerized:
                         case mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs:
-                            if (!cohorts.map.IsAnExclusionToRedirect)
+                            if (!cohorts.map->IsAnExclusionToRedirect)
                             {
                                 // try the redirected path, then package, then native if relevant.
                                 WRAPPER_GETFILEATTRIBUTES(cohorts.WsRedirected, debug, moreDebug, L"WsRedirected");  // returns if successful.
@@ -346,8 +346,17 @@ DWORD __stdcall GetFileAttributesFixup(_In_ const CharT* fileName) noexcept
 #endif
     if (fileName != nullptr)
     {
-        std::wstring LongFileName = MakeLongPath(widen(fileName));
-        retfinal = impl::GetFileAttributes(LongFileName.c_str());
+        if constexpr (psf::is_ansi<CharT>)
+        {
+            std::wstring LongFileName = MakeLongPath(widen(fileName));
+            retfinal = impl::GetFileAttributes(LongFileName.c_str());
+        }
+        else
+        {
+            // Only copies the path when it needs the prefix
+            long_path LongFileName(fileName);
+            retfinal = impl::GetFileAttributes(LongFileName.c_str());
+        }
     }
     else
     {
@@ -45,7 +45,7 @@ void LogAttributesEx(DWORD dllInstance, LPVOID fileInformation)
 
 #define WRAPPER_GETFILEATTRIBUTESEX(theDestinationFilename, debug, moredebug, wsWhich) \
     { \
-        std::wstring LongDestinationFilename = MakeLongPath(theDestinationFilename); \
+        long_path LongDestinationFilename(theDestinationFilename); \
         retfinal = impl::GetFileAttributesEx(LongDestinationFilename.c_str(), infoLevelId, fileInformation); \
         DWORD error = GetLastError(); \
         if (retfinal != 0) \
@@ -96,12 +96,12 @@ BOOL __stdcall GetFileAttributesExFixup(
         {
             dllInstance = ++g_InterceptInstance;
             std::wstring wfileName = widen(fileName);
-            wfileName = AdjustSlashes(wfileName);
+            wfileName = AdjustSlashes(std::move(wfileName));
             
 #if _DEBUG
             Log(L"[%d] GetFileAttributesExFixup level 0x%x for fileName '%s' ", dllInstance, infoLevelId, wfileName.c_str());
 #endif
-            wfileName = AdjustBadUNC(wfileName, dllInstance, L"GetFileAttributesExFixup");
+            wfileName = AdjustBadUNC(std::move(wfileName), dllInstance, L"GetFileAttributesExFixup");
             
 
             Cohorts cohorts;
@@ -114,12 +114,12 @@ BOOL __stdcall GetFileAttributesExFixup(
                 switch (cohorts.file_mfr.Request_MfrPathType)
                 {
                 case mfr::mfr_path_types::in_native_area:
-                    if (cohorts.map.Valid_mapping)
+                    if (cohorts.map->Valid_mapping)
                     {
-                        switch (cohorts.map.RedirectionFlags)
+                        switch (cohorts.map->RedirectionFlags)
                         {
                         case mfr::mfr_redirect_flags::prefer_redirection_local:
-                            if (!cohorts.map.IsAnExclusionToRedirect)
+                            if (!cohorts.map->IsAnExclusionToRedirect)
                             {
                                 // try the request path, which must be the local redirected version by definition, and then a package equivalent  
                                 WRAPPER_GETFILEATTRIBUTESEX(cohorts.WsRedirected, debug, moreDebug, L"WsRedirected");   // returns if successful.
@@ -147,7 +147,7 @@ BOOL __stdcall GetFileAttributesExFixup(
                             return retfinal;
                         case mfr::mfr_redirect_flags::prefer_redirection_containerized:
                         case mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs:
-                            if (!cohorts.map.IsAnExclusionToRedirect)
+                            if (!cohorts.map->IsAnExclusionToRedirect)
                             {
                                 // try the redirected path, then package, then native.
                                 WRAPPER_GETFILEATTRIBUTESEX(cohorts.WsRedirected, debug, moreDebug, L"WsRedirected");   // returns if successful.
@@ -180,9 +180,9 @@ BOOL __stdcall GetFileAttributesExFixup(
                     break;
                 case mfr::mfr_path_types::in_package_pvad_area:
                     /// NOTE: Ilv does not allow accessing PVAD files in the package.  PERIOD!!!  So this call will always fail.
-                    if (cohorts.map.Valid_mapping)
+                    if (cohorts.map->Valid_mapping)
                     {
-                        if (!cohorts.map.IsAnExclusionToRedirect)
+                        if (!cohorts.map->IsAnExclusionToRedirect)
                         {
                             //// try the redirected path, then package, then don't need native.
                             WRAPPER_GETFILEATTRIBUTESEX(cohorts.WsRedirected, debug, moreDebug, L"WsRedirected");   // returns if successful.
@@ -208,12 +208,12 @@ BOOL __stdcall GetFileAttributesExFixup(
                     }
                     break;
                 case mfr::mfr_path_types::in_package_vfs_area:
-                    if (cohorts.map.Valid_mapping)
+                    if (cohorts.map->Valid_mapping)
                     {
-                        switch (cohorts.map.RedirectionFlags)
+                        switch (cohorts.map->RedirectionFlags)
                         {
                         case mfr::mfr_redirect_flags::prefer_redirection_local:
-                            if (!cohorts.map.IsAnExclusionToRedirect)
+                            if (!cohorts.map->IsAnExclusionToRedirect)
                             {
                                 // try the request path, which must be the local redirected version by definition, and then a package equivalent.
                                 WRAPPER_GETFILEATTRIBUTESEX(cohorts.WsRedirected, debug, moreDebug, L"WsRedirected");   // returns if successful.
@@ -236,7 +236,7 @@ BOOL __stdcall GetFileAttributesExFixup(
                             return retfinal;
                         case mfr::mfr_redirect_flags::prefer_redirection_containerized:
                         case mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs:
-                            if (!cohorts.map.IsAnExclusionToRedirect)
+                            if (!cohorts.map->IsAnExclusionToRedirect)
                             {
                                 // try the redirected path, then package, then native.
                                 WRAPPER_GETFILEATTRIBUTESEX(cohorts.WsRedirected, debug, moreDebug, L"WsRedirected");  // returns if successful.
@@ -268,9 +268,9 @@ BOOL __stdcall GetFileAttributesExFixup(
                     }
                     break;
                 case mfr::mfr_path_types::in_redirection_area_writablepackageroot:
-                    if (cohorts.map.Valid_mapping)
+                    if (cohorts.map->Valid_mapping)
                     {
-                        if (!cohorts.map.IsAnExclusionToRedirect)
+                        if (!cohorts.map->IsAnExclusionToRedirect)
                         {
                             // try the redirected path, then package, then native if relevant.
                             WRAPPER_GETFILEATTRIBUTESEX(cohorts.WsRedirected, debug, moreDebug, L"WsRedirected");  // returns if successful.
@@ -338,11 +338,23 @@ BOOL __stdcall GetFileAttributesExFixup(
     SetLastError(0);
     if (fileName != nullptr)
     {
-        std::wstring LongFileName = MakeLongPath(widen(fileName));
+        if constexpr (psf::is_ansi<CharT>)
+        {
+            std::wstring LongFileName = MakeLongPath(widen(fileName));
+#if MOREDEBUG
+            Log(L"[%d] GetFileAttributesEx: unfixed versus %s", dllInstance, LongFileName.c_str());
+#endif
+            retfinal = impl::GetFileAttributesEx(LongFileName.c_str(), infoLevelId, fileInformation);
+        }
+        else
+        {
+            // Only copies the path when it needs the prefix
+            long_path LongFileName(fileName);
 #if MOREDEBUG
-        Log(L"[%d] GetFileAttributesEx: unfixed versus %s", dllInstance, LongFileName.c_str());
+            Log(L"[%d] GetFileAttributesEx: unfixed versus %s", dllInstance, LongFileName.c_str());
 #endif
-        retfinal = impl::GetFileAttributesEx(LongFileName.c_str(), infoLevelId, fileInformation);
+            retfinal = impl::GetFileAttributesEx(LongFileName.c_str(), infoLevelId, fileInformation);
+        }
     }
     else
     {
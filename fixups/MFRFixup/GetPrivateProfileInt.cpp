@@ -24,7 +24,7 @@
 
 #define WRAPPER_GETPRIVATEPROFILEINT(theDestinationFilename, debug) \
     { \
-        std::wstring LongDestinationFilename = MakeLongPath(theDestinationFilename); \
+        long_path LongDestinationFilename(theDestinationFilename); \
         retfinal = impl::GetPrivateProfileIntW(widen_argument(sectionName).c_str(), widen_argument(key).c_str(), nDefault, LongDestinationFilename.c_str()); \
         if (debug) \
         { \
@@ -101,8 +101,8 @@ UINT __stdcall GetPrivateProfileIntFixup(
                 // This get is inheirently a read-only operation in all cases.
                 // We prefer to use the redirecton case, if present.
                 std::wstring wfileName = widen(fileName);
-                wfileName = AdjustSlashes(wfileName);
-                wfileName = AdjustBadUNC(wfileName, dllInstance, L"GetPrivateProfileIntFixup");
+                wfileName = AdjustSlashes(std::move(wfileName));
+                wfileName = AdjustBadUNC(std::move(wfileName), dllInstance, L"GetPrivateProfileIntFixup");
 
                 Cohorts cohorts;
                 DetermineCohorts(wfileName, &cohorts, moredebug, dllInstance, L"GetPrivateProfileIntFixup");
@@ -112,13 +112,13 @@ UINT __stdcall GetPrivateProfileIntFixup(
                     switch (cohorts.file_mfr.Request_MfrPathType)
                     {
                     case mfr::mfr_path_types::in_native_area:
-                        if (cohorts.map.Valid_mapping)
+                        if (cohorts.map->Valid_mapping)
                         {
-                            switch (cohorts.map.RedirectionFlags)
+                            switch (cohorts.map->RedirectionFlags)
                             {
                             case mfr::mfr_redirect_flags::prefer_redirection_local:
                                 // try the request path, which must be the local redirected version by definition, and then a package equivalent, then default 
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_GETPRIVATEPROFILEINT(cohorts.WsRedirected, debug);  // Returns always
                                 }
@@ -134,7 +134,7 @@ UINT __stdcall GetPrivateProfileIntFixup(
                                 break;
                             case mfr::mfr_redirect_flags::prefer_redirection_containerized:
                             case mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs:
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_GETPRIVATEPROFILEINT(cohorts.WsRedirected, debug);
                                 }
@@ -162,9 +162,9 @@ UINT __stdcall GetPrivateProfileIntFixup(
                         }
                         break;
                     case mfr::mfr_path_types::in_package_pvad_area:
-                        if (cohorts.map.Valid_mapping)
+                        if (cohorts.map->Valid_mapping)
                         {
-                            switch (cohorts.map.RedirectionFlags)
+                            switch (cohorts.map->RedirectionFlags)
                             {
                             case mfr::mfr_redirect_flags::prefer_redirection_local:
                                 // not possible, fall through
@@ -172,7 +172,7 @@ UINT __stdcall GetPrivateProfileIntFixup(
                             case mfr::mfr_redirect_flags::prefer_redirection_containerized:
                             case mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs:
                                 //// try the redirected path, then package, then don't need native, so default
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_GETPRIVATEPROFILEINT(cohorts.WsRedirected, debug);
                                 }
@@ -194,13 +194,13 @@ UINT __stdcall GetPrivateProfileIntFixup(
                         }
                         break;
                     case mfr::mfr_path_types::in_package_vfs_area:
-                        if (cohorts.map.Valid_mapping)
+                        if (cohorts.map->Valid_mapping)
                         {
-                            switch (cohorts.map.RedirectionFlags)
+                            switch (cohorts.map->RedirectionFlags)
                             {
                             case mfr::mfr_redirect_flags::prefer_redirection_local:
                                 // try the redirected path, then package path, then default.
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_GETPRIVATEPROFILEINT(cohorts.WsRedirected, debug);
                                 }
@@ -217,7 +217,7 @@ UINT __stdcall GetPrivateProfileIntFixup(
                             case mfr::mfr_redirect_flags::prefer_redirection_containerized:
                             case mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs:
                                 // try the redirected path, then package, then native, then default
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_GETPRIVATEPROFILEINT(cohorts.WsRedirected, debug);
                                 }
@@ -245,9 +245,9 @@ UINT __stdcall GetPrivateProfileIntFixup(
                         }
                         break;
                     case mfr::mfr_path_types::in_redirection_area_writablepackageroot:
-                        if (cohorts.map.Valid_mapping)
+                        if (cohorts.map->Valid_mapping)
                         {
-                            switch (cohorts.map.RedirectionFlags)
+                            switch (cohorts.map->RedirectionFlags)
                             {
                             case mfr::mfr_redirect_flags::prefer_redirection_local:
                                 // not possible
@@ -255,7 +255,7 @@ UINT __stdcall GetPrivateProfileIntFixup(
                             case mfr::mfr_redirect_flags::prefer_redirection_containerized:
                             case mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs:
                                 // try the redirected path, then package, then possibly native, then default.
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_GETPRIVATEPROFILEINT(cohorts.WsRedirected, debug);
                                 }
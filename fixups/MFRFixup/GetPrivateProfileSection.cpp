@@ -25,7 +25,7 @@
 
 #define WRAPPER_GETPRIVATEPROFILESECTION(theDestinationFilename, debug, moredebug) \
     { \
-        std::wstring LongDestinationFilename = MakeLongPath(theDestinationFilename); \
+        long_path LongDestinationFilename(theDestinationFilename); \
         if constexpr (psf::is_ansi<CharT>) \
         { \
             auto wideString = std::make_unique<wchar_t[]>(stringLength); \
@@ -89,8 +89,8 @@ DWORD __stdcall GetPrivateProfileSectionFixup(
                 // This get is inheirently a read-only operation in all cases.
                 // We prefer to use the redirecton case, if present.
                 std::wstring wfileName = widen(fileName);
-                wfileName = AdjustSlashes(wfileName);
-                wfileName = AdjustBadUNC(wfileName, dllInstance, L"GetPrivateProfileSectioniFixup");
+                wfileName = AdjustSlashes(std::move(wfileName));
+                wfileName = AdjustBadUNC(std::move(wfileName), dllInstance, L"GetPrivateProfileSectioniFixup");
 
                 Cohorts cohorts;
                 DetermineCohorts(wfileName, &cohorts, moredebug, dllInstance, L"GetPrivateProfileSectionFixup");
@@ -100,13 +100,13 @@ DWORD __stdcall GetPrivateProfileSectionFixup(
                     switch (cohorts.file_mfr.Request_MfrPathType)
                     {
                     case mfr::mfr_path_types::in_native_area:
-                        if (cohorts.map.Valid_mapping)
+                        if (cohorts.map->Valid_mapping)
                         {
-                            switch (cohorts.map.RedirectionFlags)
+                            switch (cohorts.map->RedirectionFlags)
                             {
                             case mfr::mfr_redirect_flags::prefer_redirection_local:
                                 // try the request path (which must be the local redirected version by definition), and then a package equivalent, then return 0 characters as the fail.
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_GETPRIVATEPROFILESECTION(cohorts.WsRedirected, debug, moredebug);
                                 }
@@ -123,7 +123,7 @@ DWORD __stdcall GetPrivateProfileSectionFixup(
                             case mfr::mfr_redirect_flags::prefer_redirection_containerized:
                             case mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs:
                                 // try the redirected path, then package, then native,  then return 0 characters as the fail.
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_GETPRIVATEPROFILESECTION(cohorts.WsRedirected, debug, moredebug);
                                 }
@@ -151,9 +151,9 @@ DWORD __stdcall GetPrivateProfileSectionFixup(
                         }
                         break;
                     case mfr::mfr_path_types::in_package_pvad_area:
-                        if (cohorts.map.Valid_mapping)
+                        if (cohorts.map->Valid_mapping)
                         {
-                            switch (cohorts.map.RedirectionFlags)
+                            switch (cohorts.map->RedirectionFlags)
                             {
                             case mfr::mfr_redirect_flags::prefer_redirection_local:
                                 // not possible, fall through
@@ -161,7 +161,7 @@ DWORD __stdcall GetPrivateProfileSectionFixup(
                             case mfr::mfr_redirect_flags::prefer_redirection_containerized:
                             case mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs:
                                 //// try the redirected path, then package, then don't need native and return 0 characters as the fail.
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_GETPRIVATEPROFILESECTION(cohorts.WsRedirected, debug, moredebug);
                                 }
@@ -184,13 +184,13 @@ DWORD __stdcall GetPrivateProfileSectionFixup(
                         }
                         break;
                     case mfr::mfr_path_types::in_package_vfs_area:
-                        if (cohorts.map.Valid_mapping)
+                        if (cohorts.map->Valid_mapping)
                         {
-                            switch (cohorts.map.RedirectionFlags)
+                            switch (cohorts.map->RedirectionFlags)
                             {
                             case mfr::mfr_redirect_flags::prefer_redirection_local:
                                 // try the redirected path, then package path, then return 0 characters as the fail.
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_GETPRIVATEPROFILESECTION(cohorts.WsRedirected, debug, moredebug);
                                 }
@@ -208,7 +208,7 @@ DWORD __stdcall GetPrivateProfileSectionFixup(
                             case mfr::mfr_redirect_flags::prefer_redirection_containerized:
                             case mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs:
                                 // try the redirected path, then package, then native, then return 0 characters as the fail.
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_GETPRIVATEPROFILESECTION(cohorts.WsRedirected, debug, moredebug);
                                 }
@@ -236,9 +236,9 @@ DWORD __stdcall GetPrivateProfileSectionFixup(
                         }
                         break;
                     case mfr::mfr_path_types::in_redirection_area_writablepackageroot:
-                        if (cohorts.map.Valid_mapping)
+                        if (cohorts.map->Valid_mapping)
                         {
-                            switch (cohorts.map.RedirectionFlags)
+                            switch (cohorts.map->RedirectionFlags)
                             {
                             case mfr::mfr_redirect_flags::prefer_redirection_local:
                                 // not possible
@@ -246,7 +246,7 @@ DWORD __stdcall GetPrivateProfileSectionFixup(
                             case mfr::mfr_redirect_flags::prefer_redirection_containerized:
                             case mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs:
                                 // try the redirected path, then package, then possibly native, then return 0 characters as the fail.
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_GETPRIVATEPROFILESECTION(cohorts.WsRedirected, debug, moredebug);
                                 }
@@ -25,7 +25,7 @@
 
 #define WRAPPER_GETPRIVATEPROFILESECTIONNAME(theDestinationFilename, debug) \
     { \
-        std::wstring LongDestinationFilename = MakeLongPath(theDestinationFilename); \
+        long_path LongDestinationFilename(theDestinationFilename); \
         if constexpr (psf::is_ansi<CharT>) \
         { \
             auto wideString = std::make_unique<wchar_t[]>(stringLength); \
@@ -80,8 +80,8 @@ DWORD __stdcall GetPrivateProfileSectionNamesFixup(
                 // This get is inheirently a read-only operation in all cases.
                 // We prefer to use the redirecton case, if present.
                 std::wstring wfileName = widen(fileName);
-                wfileName = AdjustSlashes(wfileName);
-                wfileName = AdjustBadUNC(wfileName, dllInstance, L"GetPrivateProfileNamesFixup");
+                wfileName = AdjustSlashes(std::move(wfileName));
+                wfileName = AdjustBadUNC(std::move(wfileName), dllInstance, L"GetPrivateProfileNamesFixup");
 
                 Cohorts cohorts;
                 DetermineCohorts(wfileName, &cohorts, moredebug, dllInstance, L"GetPrivateProfileNamesFixup");
@@ -91,13 +91,13 @@ DWORD __stdcall GetPrivateProfileSectionNamesFixup(
                     switch (cohorts.file_mfr.Request_MfrPathType)
                     {
                     case mfr::mfr_path_types::in_native_area:
-                        if (cohorts.map.Valid_mapping)
+                        if (cohorts.map->Valid_mapping)
                         {
-                            switch (cohorts.map.RedirectionFlags)
+                            switch (cohorts.map->RedirectionFlags)
                             {
                             case mfr::mfr_redirect_flags::prefer_redirection_local:
                                 // try the request path, which must be the local redirected version by definition, and then a package equivalent, then default 
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_GETPRIVATEPROFILESECTIONNAME(cohorts.WsRedirected, debug);
                                 }
@@ -114,7 +114,7 @@ DWORD __stdcall GetPrivateProfileSectionNamesFixup(
                             case mfr::mfr_redirect_flags::prefer_redirection_containerized:
                             case mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs:
                                 // try the redirected path, then package, then native, then default
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_GETPRIVATEPROFILESECTIONNAME(cohorts.WsRedirected, debug);
                                 }
@@ -141,9 +141,9 @@ DWORD __stdcall GetPrivateProfileSectionNamesFixup(
                         }
                         break;
                     case mfr::mfr_path_types::in_package_pvad_area:
-                        if (cohorts.map.Valid_mapping)
+                        if (cohorts.map->Valid_mapping)
                         {
-                            switch (cohorts.map.RedirectionFlags)
+                            switch (cohorts.map->RedirectionFlags)
                             {
                             case mfr::mfr_redirect_flags::prefer_redirection_local:
                                 // not possible, fall through
@@ -151,7 +151,7 @@ DWORD __stdcall GetPrivateProfileSectionNamesFixup(
                             case mfr::mfr_redirect_flags::prefer_redirection_containerized:
                             case mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs:
                                 //// try the redirected path, then package, then don't need native, so default
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_GETPRIVATEPROFILESECTIONNAME(cohorts.WsRedirected, debug);
                                 }
@@ -174,13 +174,13 @@ DWORD __stdcall GetPrivateProfileSectionNamesFixup(
                         }
                         break;
                     case mfr::mfr_path_types::in_package_vfs_area:
-                        if (cohorts.map.Valid_mapping)
+                        if (cohorts.map->Valid_mapping)
                         {
-                            switch (cohorts.map.RedirectionFlags)
+                            switch (cohorts.map->RedirectionFlags)
                             {
                             case mfr::mfr_redirect_flags::prefer_redirection_local:
                                 // try the redirected path, then package path, then default.
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_GETPRIVATEPROFILESECTIONNAME(cohorts.WsRedirected, debug);
                                 }
@@ -197,7 +197,7 @@ DWORD __stdcall GetPrivateProfileSectionNamesFixup(
                             case mfr::mfr_redirect_flags::prefer_redirection_containerized:
                             case mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs:
                                 // try the redirected path, then package, then native, then default
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_GETPRIVATEPROFILESECTIONNAME(cohorts.WsRedirected, debug);
                                 }
@@ -225,9 +225,9 @@ DWORD __stdcall GetPrivateProfileSectionNamesFixup(
                         }
                         break;
                     case mfr::mfr_path_types::in_redirection_area_writablepackageroot:
-                        if (cohorts.map.Valid_mapping)
+                        if (cohorts.map->Valid_mapping)
                         {
-                            switch (cohorts.map.RedirectionFlags)
+                            switch (cohorts.map->RedirectionFlags)
                             {
                             case mfr::mfr_redirect_flags::prefer_redirection_local:
                                 // not possible
@@ -235,7 +235,7 @@ DWORD __stdcall GetPrivateProfileSectionNamesFixup(
                             case mfr::mfr_redirect_flags::prefer_redirection_containerized:
                             case mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs:
                                 // try the redirected path, then package, then possibly native, then default.
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_GETPRIVATEPROFILESECTIONNAME(cohorts.WsRedirected, debug);
                                 }
@@ -24,7 +24,7 @@
 
 #define WRAPPER_GETPRIVATEPROFILESTRING(theDestinationFilename, debug) \
     { \
-        std::wstring LongDestinationFilename = MakeLongPath(theDestinationFilename); \
+        long_path LongDestinationFilename(theDestinationFilename); \
         if constexpr (psf::is_ansi<CharT>) \
         { \
             retfinal = impl::GetPrivateProfileString(appName, keyName, defaultString, string, stringLength, narrow(LongDestinationFilename.c_str()).c_str()); \
@@ -131,8 +131,8 @@ DWORD __stdcall GetPrivateProfileStringFixup(
                 // This get is inheirently a read-only operation in all cases.
                 // We prefer to use the redirecton case, if present.
                 std::wstring wfileName = widen(fileName);
-                wfileName = AdjustSlashes(wfileName);
-                wfileName = AdjustBadUNC(wfileName, dllInstance, L"GetPrivateProfileStringFixup");
+                wfileName = AdjustSlashes(std::move(wfileName));
+                wfileName = AdjustBadUNC(std::move(wfileName), dllInstance, L"GetPrivateProfileStringFixup");
 
                 Cohorts cohorts;
                 DetermineCohorts(wfileName, &cohorts, moredebug, dllInstance, L"GetPrivateProfileStringFixup");
@@ -142,13 +142,13 @@ DWORD __stdcall GetPrivateProfileStringFixup(
                     switch (cohorts.file_mfr.Request_MfrPathType)
                     {
                     case mfr::mfr_path_types::in_native_area:
-                        if (cohorts.map.Valid_mapping)
+                        if (cohorts.map->Valid_mapping)
                         {
-                            switch (cohorts.map.RedirectionFlags)
+                            switch (cohorts.map->RedirectionFlags)
                             {
                             case mfr::mfr_redirect_flags::prefer_redirection_local:
                                 // try the request path, which must be the local redirected version by definition, and then a package equivalent, then default 
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_GETPRIVATEPROFILESTRING(cohorts.WsRedirected, debug);
                                 }
@@ -165,7 +165,7 @@ DWORD __stdcall GetPrivateProfileStringFixup(
                             case mfr::mfr_redirect_flags::prefer_redirection_containerized:
                             case mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs:
                                 // try the redirected path, then package, then native, then default
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_GETPRIVATEPROFILESTRING(cohorts.WsRedirected, debug);
                                 }
@@ -193,9 +193,9 @@ DWORD __stdcall GetPrivateProfileStringFixup(
                         }
                         break;
                     case mfr::mfr_path_types::in_package_pvad_area:
-                        if (cohorts.map.Valid_mapping)
+                        if (cohorts.map->Valid_mapping)
                         {
-                            switch (cohorts.map.RedirectionFlags)
+                            switch (cohorts.map->RedirectionFlags)
                             {
                             case mfr::mfr_redirect_flags::prefer_redirection_local:
                                 // not possible, fall through
@@ -203,7 +203,7 @@ DWORD __stdcall GetPrivateProfileStringFixup(
                             case mfr::mfr_redirect_flags::prefer_redirection_containerized:
                             case mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs:
                                 //// try the redirected path, then package, then don't need native, so default
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_GETPRIVATEPROFILESTRING(cohorts.WsRedirected, debug);
                                 }
@@ -226,13 +226,13 @@ DWORD __stdcall GetPrivateProfileStringFixup(
                         }
                         break;
                     case mfr::mfr_path_types::in_package_vfs_area:
-                        if (cohorts.map.Valid_mapping)
+                        if (cohorts.map->Valid_mapping)
                         {
-                            switch (cohorts.map.RedirectionFlags)
+                            switch (cohorts.map->RedirectionFlags)
                             {
                             case mfr::mfr_redirect_flags::prefer_redirection_local:
                                 // try the redirected path, then package path, then default.
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_GETPRIVATEPROFILESTRING(cohorts.WsRedirected, debug);
                                 }
@@ -249,7 +249,7 @@ DWORD __stdcall GetPrivateProfileStringFixup(
                             case mfr::mfr_redirect_flags::prefer_redirection_containerized:
                             case mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs:
                                 // try the redirected path, then package, then native, then default
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_GETPRIVATEPROFILESTRING(cohorts.WsRedirected, debug);
                                 }
@@ -277,9 +277,9 @@ DWORD __stdcall GetPrivateProfileStringFixup(
                         }
                         break;
                     case mfr::mfr_path_types::in_redirection_area_writablepackageroot:
-                        if (cohorts.map.Valid_mapping)
+                        if (cohorts.map->Valid_mapping)
                         {
-                            switch (cohorts.map.RedirectionFlags)
+                            switch (cohorts.map->RedirectionFlags)
                             {
                             case mfr::mfr_redirect_flags::prefer_redirection_local:
                                 // not possible
@@ -287,7 +287,7 @@ DWORD __stdcall GetPrivateProfileStringFixup(
                             case mfr::mfr_redirect_flags::prefer_redirection_containerized:
                             case mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs:
                                 // try the redirected path, then package, then possibly native, then default.
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_GETPRIVATEPROFILESTRING(cohorts.WsRedirected, debug);
                                 }
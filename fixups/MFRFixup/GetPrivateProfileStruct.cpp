@@ -24,7 +24,7 @@
 
 #define WRAPPER_GETPRIVATEPROFILESTRUCT(theDestinationFilename, debug) \
     { \
-        std::wstring LongDestinationFilename = MakeLongPath(theDestinationFilename); \
+        long_path LongDestinationFilename(theDestinationFilename); \
         if constexpr (psf::is_ansi<CharT>) \
         { \
             retfinal = impl::GetPrivateProfileStructW(widen_argument(sectionName).c_str(), widen_argument(key).c_str(), structArea, uSizeStruct, LongDestinationFilename.c_str()); \
@@ -75,8 +75,8 @@ BOOL __stdcall GetPrivateProfileStructFixup(
                 // This get is inheirently a read-only operation in all cases.
                 // We prefer to use the redirecton case, if present.
                 std::wstring wfileName = widen(fileName);
-                wfileName = AdjustSlashes(wfileName);
-                wfileName = AdjustBadUNC(wfileName, dllInstance, L"GetPrivateProfileStructFixup");
+                wfileName = AdjustSlashes(std::move(wfileName));
+                wfileName = AdjustBadUNC(std::move(wfileName), dllInstance, L"GetPrivateProfileStructFixup");
 
                 Cohorts cohorts;
                 DetermineCohorts(wfileName, &cohorts, moredebug, dllInstance, L"GetPrivateProfileStructFixup");
@@ -86,13 +86,13 @@ BOOL __stdcall GetPrivateProfileStructFixup(
                     switch (cohorts.file_mfr.Request_MfrPathType)
                     {
                     case mfr::mfr_path_types::in_native_area:
-                        if (cohorts.map.Valid_mapping)
+                        if (cohorts.map->Valid_mapping)
                         {
-                            switch (cohorts.map.RedirectionFlags)
+                            switch (cohorts.map->RedirectionFlags)
                             {
                             case mfr::mfr_redirect_flags::prefer_redirection_local:
                                 // try the request path, which must be the local redirected version by definition, and then a package equivalent, then default 
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_GETPRIVATEPROFILESTRUCT(cohorts.WsRedirected, debug);
                                 }
@@ -109,7 +109,7 @@ BOOL __stdcall GetPrivateProfileStructFixup(
                             case mfr::mfr_redirect_flags::prefer_redirection_containerized:
                             case mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs:
                                 // try the redirected path, then package, then native, then default
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_GETPRIVATEPROFILESTRUCT(cohorts.WsRedirected, debug);
                                 }
@@ -137,9 +137,9 @@ BOOL __stdcall GetPrivateProfileStructFixup(
                         }
                         break;
                     case mfr::mfr_path_types::in_package_pvad_area:
-                        if (cohorts.map.Valid_mapping)
+                        if (cohorts.map->Valid_mapping)
                         {
-                            switch (cohorts.map.RedirectionFlags)
+                            switch (cohorts.map->RedirectionFlags)
                             {
                             case mfr::mfr_redirect_flags::prefer_redirection_local:
                                 // not possible, fall through
@@ -147,7 +147,7 @@ BOOL __stdcall GetPrivateProfileStructFixup(
                             case mfr::mfr_redirect_flags::prefer_redirection_containerized:
                             case mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs:
                                 //// try the redirected path, then package, then don't need native, so default
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_GETPRIVATEPROFILESTRUCT(cohorts.WsRedirected, debug);
                                 }
@@ -170,13 +170,13 @@ BOOL __stdcall GetPrivateProfileStructFixup(
                         }
                         break;
                     case mfr::mfr_path_types::in_package_vfs_area:
-                        if (cohorts.map.Valid_mapping)
+                        if (cohorts.map->Valid_mapping)
                         {
-                            switch (cohorts.map.RedirectionFlags)
+                            switch (cohorts.map->RedirectionFlags)
                             {
                             case mfr::mfr_redirect_flags::prefer_redirection_local:
                                 // try the redirected path, then package path,  then default.
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_GETPRIVATEPROFILESTRUCT(cohorts.WsRedirected, debug);
                                 }
@@ -193,7 +193,7 @@ BOOL __stdcall GetPrivateProfileStructFixup(
                             case mfr::mfr_redirect_flags::prefer_redirection_containerized:
                             case mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs:
                                 // try the redirected path, then package, then native, then default
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_GETPRIVATEPROFILESTRUCT(cohorts.WsRedirected, debug);
                                 }
@@ -221,9 +221,9 @@ BOOL __stdcall GetPrivateProfileStructFixup(
                         }
                         break;
                     case mfr::mfr_path_types::in_redirection_area_writablepackageroot:
-                        if (cohorts.map.Valid_mapping)
+                        if (cohorts.map->Valid_mapping)
                         {
-                            switch (cohorts.map.RedirectionFlags)
+                            switch (cohorts.map->RedirectionFlags)
                             {
                             case mfr::mfr_redirect_flags::prefer_redirection_local:
                                 // not possible
@@ -231,7 +231,7 @@ BOOL __stdcall GetPrivateProfileStructFixup(
                             case mfr::mfr_redirect_flags::prefer_redirection_containerized:
                             case mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs:
                                 // try the redirected path, then package, then possibly native, then default.
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_GETPRIVATEPROFILESTRUCT(cohorts.WsRedirected, debug);
                                 }
@@ -35,6 +35,8 @@ mfr::mfr_configuration MFRConfiguration;
 
 void InitializeConfiguration()
 {
+    SetLogLevels(::PSFQueryCurrentDllLogLevel());
+
     TraceLoggingRegister(g_Log_ETW_ComponentProvider);
     std::wstringstream traceDataStream;
 
@@ -258,6 +260,10 @@ void InitializeConfiguration()
         Log(L"============== Dump ====================");
 #endif
 
+        // The overrides above replace mappings in the list, so the indexes (and the exclusion copies kept with them)
+        // are rebuilt to match
+        mfr::BuildMappingIndexes();
+
         TraceLoggingWrite(
             g_Log_ETW_ComponentProvider,
             "MFRFixupConfigdata",
@@ -68,8 +68,8 @@ BOOL __stdcall Kb_MoveFileExWFixup(
             std::wstring wNewFileName = AdjustSlashes(newFileName);
             std::wstring wExistingFileName = AdjustSlashes(existingFileName);
 
-            wExistingFileName = AdjustBadUNC(wExistingFileName, dllInstance, L"Kb_MoveFileExWFixup (existing)");
-            wNewFileName = AdjustBadUNC(wNewFileName, dllInstance, L"Kb_MoveFileExWFixup (new)");
+            wExistingFileName = AdjustBadUNC(std::move(wExistingFileName), dllInstance, L"Kb_MoveFileExWFixup (existing)");
+            wNewFileName = AdjustBadUNC(std::move(wNewFileName), dllInstance, L"Kb_MoveFileExWFixup (new)");
 
 
             Cohorts cohortsNew;
@@ -79,19 +79,19 @@ BOOL __stdcall Kb_MoveFileExWFixup(
             DetermineCohorts(wExistingFileName, &cohortsExisting, moredebug, dllInstance, L"Kb_MoveFileExWFixup (existingFileName)");
 
             // Determine if path of existing file and if in package.
-            std::wstring UseExistingFile = cohortsExisting.WsRequested;
+            std::wstring UseExistingFile(cohortsExisting.WsRequested);
             bool         ExistingFileIsPackagePath = false;
-            std::wstring UseNewFile = cohortsNew.WsRequested;
+            std::wstring UseNewFile(cohortsNew.WsRequested);
 
             if (!MFRConfiguration.Ilv_Aware)
             {
                 switch (cohortsExisting.file_mfr.Request_MfrPathType)
                 {
                 case mfr::mfr_path_types::in_native_area:
-                    if (cohortsExisting.map.Valid_mapping &&
-                        cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
+                    if (cohortsExisting.map->Valid_mapping &&
+                        cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
                     {
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             UseExistingFile = cohortsExisting.WsRedirected;
                         }
@@ -106,11 +106,11 @@ BOOL __stdcall Kb_MoveFileExWFixup(
                         }
                         break;
                     }
-                    else if (cohortsExisting.map.Valid_mapping &&
-                        (cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
-                            cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
+                    else if (cohortsExisting.map->Valid_mapping &&
+                        (cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
+                            cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
                     {
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             UseExistingFile = cohortsExisting.WsRedirected;
                         }
@@ -127,9 +127,9 @@ BOOL __stdcall Kb_MoveFileExWFixup(
                     }
                     break;
                 case mfr::mfr_path_types::in_package_pvad_area:
-                    if (cohortsExisting.map.Valid_mapping)
+                    if (cohortsExisting.map->Valid_mapping)
                     {
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             UseExistingFile = cohortsExisting.WsRedirected;
                         }
@@ -142,10 +142,10 @@ BOOL __stdcall Kb_MoveFileExWFixup(
                     }
                     break;
                 case mfr::mfr_path_types::in_package_vfs_area:
-                    if (cohortsExisting.map.Valid_mapping &&
-                        cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
+                    if (cohortsExisting.map->Valid_mapping &&
+                        cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
                     {
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             UseExistingFile = cohortsExisting.WsRedirected;
                         }
@@ -156,11 +156,11 @@ BOOL __stdcall Kb_MoveFileExWFixup(
                         }
                         break;
                     }
-                    else if (cohortsExisting.map.Valid_mapping &&
-                        (cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
-                            cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
+                    else if (cohortsExisting.map->Valid_mapping &&
+                        (cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
+                            cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
                     {
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             UseExistingFile = cohortsExisting.WsRedirected;
                         }
@@ -183,9 +183,9 @@ BOOL __stdcall Kb_MoveFileExWFixup(
                     }
                     break;
                 case mfr::mfr_path_types::in_redirection_area_writablepackageroot:
-                    if (cohortsExisting.map.Valid_mapping)
+                    if (cohortsExisting.map->Valid_mapping)
                     {
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             UseExistingFile = cohortsExisting.WsRedirected;
                         }
@@ -225,44 +225,44 @@ BOOL __stdcall Kb_MoveFileExWFixup(
                 switch (cohortsNew.file_mfr.Request_MfrPathType)
                 {
                 case mfr::mfr_path_types::in_native_area:
-                    if (cohortsNew.map.Valid_mapping && !cohortsNew.map.IsAnExclusionToRedirect &&
-                        cohortsNew.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
+                    if (cohortsNew.map->Valid_mapping && !cohortsNew.map->IsAnExclusionToRedirect &&
+                        cohortsNew.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
                     {
                         UseNewFile = cohortsNew.WsRequested;
                         break;
                     }
-                    else if (cohortsNew.map.Valid_mapping && !cohortsNew.map.IsAnExclusionToRedirect &&
-                        (cohortsNew.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
-                            cohortsNew.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
+                    else if (cohortsNew.map->Valid_mapping && !cohortsNew.map->IsAnExclusionToRedirect &&
+                        (cohortsNew.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
+                            cohortsNew.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
                     {
                         UseNewFile = cohortsNew.WsRedirected;
                         break;
                     }
                     break;
                 case mfr::mfr_path_types::in_package_pvad_area:
-                    if (cohortsNew.map.Valid_mapping && !cohortsNew.map.IsAnExclusionToRedirect)
+                    if (cohortsNew.map->Valid_mapping && !cohortsNew.map->IsAnExclusionToRedirect)
                     {
                         UseNewFile = cohortsNew.WsRedirected;
                         break;
                     }
                     break;
                 case mfr::mfr_path_types::in_package_vfs_area:
-                    if (cohortsNew.map.Valid_mapping && !cohortsNew.map.IsAnExclusionToRedirect &&
-                        cohortsNew.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
+                    if (cohortsNew.map->Valid_mapping && !cohortsNew.map->IsAnExclusionToRedirect &&
+                        cohortsNew.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
                     {
                         UseNewFile = cohortsNew.WsRequested;
                         break;
                     }
-                    else if (cohortsNew.map.Valid_mapping && !cohortsNew.map.IsAnExclusionToRedirect &&
-                        (cohortsNew.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
-                            cohortsNew.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
+                    else if (cohortsNew.map->Valid_mapping && !cohortsNew.map->IsAnExclusionToRedirect &&
+                        (cohortsNew.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
+                            cohortsNew.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
                     {
                         UseNewFile = cohortsNew.WsRedirected;
                         break;
                     }
                     break;
                 case mfr::mfr_path_types::in_redirection_area_writablepackageroot:
-                    if (cohortsNew.map.Valid_mapping)
+                    if (cohortsNew.map->Valid_mapping)
                     {
                         UseNewFile = cohortsNew.WsRequested;
                         break;
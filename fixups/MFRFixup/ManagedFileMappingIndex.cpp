@@ -0,0 +1,183 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) TMurgent Technologies, LLP. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+//
+// The folder mapping list and the lookups into it that every intercepted file call makes.  The list itself is filled
+// in by Initialize_MFR_Mappings (ManagedFileMappings.cpp) and adjusted by the configuration.
+
+#include <algorithm>
+#include <windows.h>
+#include "ManagedPathTypes.h"
+#include "ManagedFileMappings.h"
+#include <path_prefix_trie.h>
+
+namespace mfr
+{
+
+    std::vector<mfr_folder_mapping> g_MfrFolderMappings;
+
+    // Indexes into g_MfrFolderMappings by each of the three base paths. The bases never change once
+    // Initialize_MFR_Mappings is done (configuration only changes the flags), so these are built once and then
+    // only read; the flags are checked at lookup time.
+    static psf::path_prefix_trie<size_t> g_MfrNativePathIndex;
+    static psf::path_prefix_trie<size_t> g_MfrPackagePathIndex;
+    static psf::path_prefix_trie<size_t> g_MfrRedirectedPathIndex;
+
+    // The result of Find_TraditionalRedirMapping_FromPackagePath_ForwardSearch for package files outside of the VFS
+    static mfr_folder_mapping g_MfrPackageRootMapping;
+
+    // A copy of each entry of g_MfrFolderMappings marked as an exclusion, for ExclusionMapping
+    static std::vector<mfr_folder_mapping> g_MfrExclusionMappings;
+
+    std::size_t g_MfrLongestBasePathLength = 0;
+
+    static void AddToMappingIndex(psf::path_prefix_trie<size_t>& index, const std::filesystem::path& basePath, size_t mapIndex)
+    {
+        g_MfrLongestBasePathLength = std::max(g_MfrLongestBasePathLength, basePath.native().length());
+
+        // Only done once, so the copy (rather than a view of native()) does not matter
+        std::wstring base = basePath.wstring();
+        while (!base.empty() && psf::is_path_separator(base.back()))
+        {
+            base.pop_back();
+        }
+        if (!base.empty())
+        {
+            index.insert(base, mapIndex);
+        }
+    }
+
+    void BuildMappingIndexes()
+    {
+        g_MfrNativePathIndex = {};
+        g_MfrPackagePathIndex = {};
+        g_MfrRedirectedPathIndex = {};
+        g_MfrLongestBasePathLength = 0;
+        g_MfrExclusionMappings.clear();
+        for (size_t mapIndex = 0; mapIndex < g_MfrFolderMappings.size(); ++mapIndex)
+        {
+            auto& map = g_MfrFolderMappings[mapIndex];
+            AddToMappingIndex(g_MfrNativePathIndex, map.NativePathBase, mapIndex);
+            AddToMappingIndex(g_MfrPackagePathIndex, map.PackagePathBase, mapIndex);
+            AddToMappingIndex(g_MfrRedirectedPathIndex, map.RedirectedPathBase, mapIndex);
+            g_MfrExclusionMappings.push_back(map);
+            g_MfrExclusionMappings.back().IsAnExclusionToRedirect = true;
+        }
+
+        g_MfrPackageRootMapping.Valid_mapping = true;
+        g_MfrPackageRootMapping.IsAnExclusionToRedirect = false;
+        g_MfrPackageRootMapping.DoesRuntimeMapNativeToVFS = false;
+        g_MfrPackageRootMapping.NativePathBase = FID_RootDrive;
+        g_MfrPackageRootMapping.PackagePathBase = g_packageRootPath;
+        g_MfrPackageRootMapping.RedirectedPathBase = g_writablePackageRootPath;
+        g_MfrPackageRootMapping.RedirectionFlags = mfr_redirect_flags::prefer_redirection_containerized;
+        for (auto base : { &FID_RootDrive, &g_packageRootPath, &g_writablePackageRootPath })
+        {
+            g_MfrLongestBasePathLength = std::max(g_MfrLongestBasePathLength, base->native().length());
+        }
+    }
+
+    const mfr_folder_mapping& InvalidMapping()
+    {
+        static const mfr_folder_mapping none = MakeInvalidMapping();
+        return none;
+    }
+
+    const mfr_folder_mapping& ExclusionMapping(const mfr_folder_mapping& map)
+    {
+        std::less<const mfr_folder_mapping*> lt;
+        if (!lt(&map, g_MfrFolderMappings.data()) && lt(&map, g_MfrFolderMappings.data() + g_MfrExclusionMappings.size()))
+        {
+            return g_MfrExclusionMappings[&map - g_MfrFolderMappings.data()];
+        }
+        return map;
+    }
+
+    // The list is ordered with more specific paths first and used to be searched front to back, so of all of the
+    // mappings whose base is a prefix of the path, the one that comes first in the list (and is accepted) wins.
+    template <typename Accept>
+    static const mfr_folder_mapping& FindMapping(const psf::path_prefix_trie<size_t>& index, std::wstring_view WsPath, Accept&& accept)
+    {
+        size_t found = g_MfrFolderMappings.size();
+        index.for_each_prefix(WsPath, [&](const std::vector<size_t>& mapIndexes, size_t)
+        {
+            for (auto mapIndex : mapIndexes)
+            {
+                if ((mapIndex < found) && accept(g_MfrFolderMappings[mapIndex]))
+                {
+                    found = mapIndex;
+                    break;
+                }
+            }
+            return true;
+        });
+        return (found < g_MfrFolderMappings.size()) ? g_MfrFolderMappings[found] : InvalidMapping();
+    }
+
+    static bool IsLocalMapping(const mfr_folder_mapping& map)
+    {
+        // 4.2.0.0: Restoring the check against local explicitly.  Not sure why it was changed.
+        return map.RedirectionFlags != mfr_redirect_flags::disabled &&
+            //map.RedirectionFlags != mfr_redirect_flags::prefer_redirection_none
+            map.RedirectionFlags == mfr_redirect_flags::prefer_redirection_local;
+    }
+
+    static bool IsTraditionalMapping(const mfr_folder_mapping& map)
+    {
+        return map.RedirectionFlags != mfr_redirect_flags::disabled &&
+            map.RedirectionFlags != mfr_redirect_flags::prefer_redirection_local;
+    }
+
+
+    mfr_folder_mapping  MakeInvalidMapping()
+    {
+        mfr_folder_mapping none;
+        none.Valid_mapping = false;
+        return none;
+    }
+
+    const mfr_folder_mapping& Find_LocalRedirMapping_FromNativePath_ForwardSearch(std::wstring_view WsPath)
+    {
+        return FindMapping(g_MfrNativePathIndex, WsPath, IsLocalMapping);
+    }  // Find_LocalRedirMapping_FromNativePath_ForwardSearch() 
+
+
+    const mfr_folder_mapping& Find_LocalRedirMapping_FromPackagePath_ForwardSearch(std::wstring_view WsPath)
+    {
+        // if not found, this might be PVAD, but PVADs don't map
+        return FindMapping(g_MfrPackagePathIndex, WsPath, IsLocalMapping);
+    } // Find_LocalRedirMapping_FromPackagePath_ForwardSearch() 
+
+
+    const mfr_folder_mapping& Find_TraditionalRedirMapping_FromNativePath_ForwardSearch(std::wstring_view WsPath)
+    {
+        return FindMapping(g_MfrNativePathIndex, WsPath, IsTraditionalMapping);
+    }  // Find_TraditionalRedirMapping_FromNativePath_ForwardSearch() 
+
+    const mfr_folder_mapping& Find_TraditionalRedirMapping_FromPackagePath_ForwardSearch(std::wstring_view WsPath)
+    {
+        auto& map = FindMapping(g_MfrPackagePathIndex, WsPath, IsTraditionalMapping);
+        if (map.Valid_mapping)
+        {
+            return map;
+        }
+
+        // if still here, this might be PVAD
+        if (path_starts_with(WsPath, g_packageVfsRootPath))
+        {
+            // Left unmapped. TODO why didn't the original work???
+        }
+        else if (path_starts_with(WsPath, g_packageRootPath))
+        {
+            return g_MfrPackageRootMapping;
+        }
+        return InvalidMapping();
+    } // Find_TraditionalRedirMapping_FromPackagePath_ForwardSearch() 
+
+
+    const mfr_folder_mapping& Find_TraditionalRedirMapping_FromRedirectedPath_ForwardSearch(std::wstring_view WsPath)
+    {
+        return FindMapping(g_MfrRedirectedPathIndex, WsPath, IsTraditionalMapping);
+    }  // Find_TraditionalRedirMapping_FromRedirectedPath_ForwardSearch()
+}
@@ -16,10 +16,6 @@
 namespace mfr
 {
 
-    std::vector<mfr_folder_mapping> g_MfrFolderMappings;
-
-    
-
     void Initialize_MFR_Mappings()
     {
         // This creates an ordered list of folders such that more specific paths are listed prior to less specific.
@@ -421,78 +417,13 @@ namespace mfr
                                                                 false,
                                                                 g_writablePackageRootPath,
                                                                 mfr::mfr_redirect_flags::prefer_redirection_containerized});
+
+        BuildMappingIndexes();
 #if MOREDEBUG
         Log(L" MFR_Mappings initialized.");
 #endif
     } // Initialize_MFR_Mappings()
 
-    mfr_folder_mapping  MakeInvalidMapping()
-    {
-        mfr_folder_mapping none;
-        none.Valid_mapping = false;
-        return none;
-    }
-
-    mfr_folder_mapping  Find_LocalRedirMapping_FromNativePath_ForwardSearch(std::wstring WsPath)
-    {
-        for (mfr_folder_mapping map : g_MfrFolderMappings)
-        {
-            // 4.2.0.0: Restoring the check against local explicitly.  Not sure why it was changed.
-            if (map.RedirectionFlags != mfr_redirect_flags::disabled &&
-                //map.RedirectionFlags != mfr_redirect_flags::prefer_redirection_none
-                map.RedirectionFlags == mfr_redirect_flags::prefer_redirection_local
-               )
-            {
-                if (path_isSubsetOf_String(map.NativePathBase, WsPath.c_str()))
-                {
-                    return map;
-                }
-            }
-        }
-        return MakeInvalidMapping();
-    }  // Find_LocalRedirMapping_FromNativePath_ForwardSearch() 
-
-
-    mfr_folder_mapping  Find_LocalRedirMapping_FromPackagePath_ForwardSearch(std::wstring WsPath)
-    {
-        mfr::mfr_folder_mapping packagemap;
-        //{ true, FID_ProgramFilesX64, L"ProgramFilesX64", L"ProgramFilesX64", g_packageVfsRootPath / L"ProgramFilesX64"sv, true, g_writablePackageRootPath / L"VFS\\ProgramFilesX64"sv, mfr::mfr_redirect_flags::prefer_redirection_containerized });
-
-        for (mfr_folder_mapping map : g_MfrFolderMappings)
-        {
-            // 4.2.0.0: Restoring the check against local explicitly.  Not sure why it was changed.
-            if (map.RedirectionFlags != mfr_redirect_flags::disabled &&
-                //map.RedirectionFlags != mfr_redirect_flags::prefer_redirection_none
-                map.RedirectionFlags == mfr_redirect_flags::prefer_redirection_local
-                )
-            {
-                if (path_isSubsetOf_String(map.PackagePathBase, WsPath.c_str()))
-                {
-                    return map;
-                }
-            }
-        }
-        // if still here, this might be PVAD, but PVADs don't map
-        return MakeInvalidMapping();
-    } // Find_LocalRedirMapping_FromPackagePath_ForwardSearch() 
-
-
-    mfr_folder_mapping  Find_TraditionalRedirMapping_FromNativePath_ForwardSearch(std::wstring WsPath)
-    {
-        for (mfr_folder_mapping map : g_MfrFolderMappings)
-        {
-            if (map.RedirectionFlags != mfr_redirect_flags::disabled &&
-                map.RedirectionFlags != mfr_redirect_flags::prefer_redirection_local)
-            {
-                if (path_isSubsetOf_String(map.NativePathBase, WsPath.c_str()))
-                {
-                    return map;
-                }
-            }
-        }
-        return MakeInvalidMapping();
-    }  // Find_TraditionalRedirMapping_FromNativePath_ForwardSearch() 
-
 #if DEAD2ME
     mfr_folder_mapping  Find_TraditionalRedirMapping_FromRedirPath_BackwardSearch(std::wstring WsPath)
     {
@@ -541,62 +472,5 @@ namespace mfr
 
 
 
-    mfr_folder_mapping Find_TraditionalRedirMapping_FromPackagePath_ForwardSearch(std::wstring WsPath)
-    {
-        mfr::mfr_folder_mapping packagemap;
-        //{ true, FID_ProgramFilesX64, L"ProgramFilesX64", L"ProgramFilesX64", g_packageVfsRootPath / L"ProgramFilesX64"sv, true, g_writablePackageRootPath / L"VFS\\ProgramFilesX64"sv, mfr::mfr_redirect_flags::prefer_redirection_containerized });
-
-        for (mfr_folder_mapping map : g_MfrFolderMappings)
-        {
-            if (map.RedirectionFlags != mfr_redirect_flags::disabled &&
-                map.RedirectionFlags != mfr_redirect_flags::prefer_redirection_local)
-            {
-                if (path_isSubsetOf_String(map.PackagePathBase, WsPath.c_str()))
-                {
-                    return map;
-                }
-            }
-        }
-        // if still here, this might be PVAD
-        if (path_isSubsetOf_String(g_packageVfsRootPath,WsPath.c_str()))
-        {
-            packagemap.Valid_mapping = true;
-            packagemap.DoesRuntimeMapNativeToVFS = false;
-            //packagemap.FolderId = L"";
-            packagemap.NativePathBase = FID_RootDrive;
-            packagemap.PackagePathBase = L"";
-            // TODO why didn't the original work???
-        }
-        else if (path_isSubsetOf_String(g_packageRootPath, WsPath.c_str()))
-        {
-            packagemap.Valid_mapping = true;
-            packagemap.DoesRuntimeMapNativeToVFS = false;
-            //packagemap.FolderId = L"";
-            packagemap.NativePathBase = FID_RootDrive;
-            packagemap.PackagePathBase = g_packageRootPath;
-            //packagemap.VFSFolderName = "";
-            packagemap.RedirectedPathBase = g_writablePackageRootPath;
-            packagemap.RedirectionFlags = mfr_redirect_flags::prefer_redirection_containerized;
-            return packagemap;
-        }
-        return MakeInvalidMapping();
-    } // Find_TraditionalRedirMapping_FromPackagePath_ForwardSearch() 
-
-
-    mfr_folder_mapping  Find_TraditionalRedirMapping_FromRedirectedPath_ForwardSearch(std::wstring WsPath)
-    {
-        for (mfr_folder_mapping map : g_MfrFolderMappings)
-        {
-            if (map.RedirectionFlags != mfr_redirect_flags::disabled &&
-                map.RedirectionFlags != mfr_redirect_flags::prefer_redirection_local)
-            {
-                if (path_isSubsetOf_String(map.RedirectedPathBase, WsPath.c_str()))
-                {
-                    return map;
-                }
-            }
-        }
-        return MakeInvalidMapping();
-    }  // Find_TraditionalRedirMapping_FromRedirectedPath_ForwardSearch()
 
 }
\ No newline at end of file
@@ -5,6 +5,9 @@
 //-------------------------------------------------------------------------------------------------------
 
 #include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
 #include <dos_paths.h>
 
 
@@ -64,13 +67,30 @@ namespace mfr
 
     extern void Initialize_MFR_Mappings();
 
+    // Indexes g_MfrFolderMappings by base path for the lookups below; Initialize_MFR_Mappings calls this once the list
+    // is complete.
+    extern void BuildMappingIndexes();
+
+    // The length of the longest base path in g_MfrFolderMappings, which bounds how much longer swapping one base of a
+    // path for another can make it.
+    extern std::size_t g_MfrLongestBasePathLength;
+
     extern mfr_folder_mapping  MakeInvalidMapping();
-    extern mfr_folder_mapping  Find_LocalRedirMapping_FromNativePath_ForwardSearch(std::wstring WsPath);
-    extern mfr_folder_mapping  Find_LocalRedirMapping_FromPackagePath_ForwardSearch(std::wstring WsPath);
+    // A shared invalid mapping, for references that must always point at some mapping
+    extern const mfr_folder_mapping& InvalidMapping();
+
+    // The same as map, an entry of g_MfrFolderMappings, but marked as an exclusion to redirect; for the request that
+    // matches a mapping but must not be redirected.  Kept with the indexes, so the result stays valid.
+    extern const mfr_folder_mapping& ExclusionMapping(const mfr_folder_mapping& map);
+
+    // These return the first mapping in g_MfrFolderMappings whose base path (of the given kind) is a parent of, or the
+    // same as, WsPath; or an invalid mapping if there is none.  The results refer to the mapping list, so stay valid.
+    extern const mfr_folder_mapping& Find_LocalRedirMapping_FromNativePath_ForwardSearch(std::wstring_view WsPath);
+    extern const mfr_folder_mapping& Find_LocalRedirMapping_FromPackagePath_ForwardSearch(std::wstring_view WsPath);
 
-    extern mfr_folder_mapping  Find_TraditionalRedirMapping_FromNativePath_ForwardSearch(std::wstring WsPath);
-    extern mfr_folder_mapping  Find_TraditionalRedirMapping_FromPackagePath_ForwardSearch(std::wstring WsPath);
-    extern mfr_folder_mapping  Find_TraditionalRedirMapping_FromRedirectedPath_ForwardSearch(std::wstring WsPath);
+    extern const mfr_folder_mapping& Find_TraditionalRedirMapping_FromNativePath_ForwardSearch(std::wstring_view WsPath);
+    extern const mfr_folder_mapping& Find_TraditionalRedirMapping_FromPackagePath_ForwardSearch(std::wstring_view WsPath);
+    extern const mfr_folder_mapping& Find_TraditionalRedirMapping_FromRedirectedPath_ForwardSearch(std::wstring_view WsPath);
 
 #if DEAD2ME
     extern mfr_folder_mapping  Find_TraditionalRedirMapping_FromRedirPath_BackwardSearch(std::wstring WsPath);
@@ -3,9 +3,9 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 //-------------------------------------------------------------------------------------------------------
 
+#include <windows.h>
 #include "ManagedPathTypes.h"
-#include "FID.h"
-#include "PathUtilities.h"
+#include "ManagedFileMappings.h"
 #include <psf_logging.h>
 
 namespace mfr
@@ -45,46 +45,46 @@ namespace mfr
     } // MfrPathTypeName()
 #endif
 
-    mfr_path_types Get_ManagedPathTypeForDriveAbsolute(std::filesystem::path path)
+    mfr_path_types Get_ManagedPathTypeForDriveAbsolute(std::wstring_view path)
     {
-        if (pathString_isSubsetOf_Path(g_writablePackageRootPath.generic_wstring().c_str(), path))
+        if (path_starts_with(path, g_writablePackageRootPath))
         {
             return mfr_path_types::in_redirection_area_writablepackageroot;
         }
-        if (pathString_isSubsetOf_Path(g_short_writablePackageRootPath.generic_wstring().c_str(), path))
+        if (path_starts_with(path, g_short_writablePackageRootPath))
         {
             return mfr_path_types::in_redirection_area_writablepackageroot;
         }
 
-        if (pathString_isSubsetOf_Path(g_redirectRootPath.generic_wstring().c_str(), path))
+        if (path_starts_with(path, g_redirectRootPath))
         {
             return mfr_path_types::in_redirection_area_other;
         }
-        if (pathString_isSubsetOf_Path(g_short_redirectRootPath.generic_wstring().c_str(), path))
+        if (path_starts_with(path, g_short_redirectRootPath))
         {
             return mfr_path_types::in_redirection_area_other;
         }
 
-        if (pathString_isSubsetOf_Path(g_packageVfsRootPath.generic_wstring().c_str(), path))
+        if (path_starts_with(path, g_packageVfsRootPath))
         {
             return mfr_path_types::in_package_vfs_area;
         }
-        if (pathString_isSubsetOf_Path(g_short_packageVfsRootPath.generic_wstring().c_str(), path))
+        if (path_starts_with(path, g_short_packageVfsRootPath))
         {
             return mfr_path_types::in_package_vfs_area;
         }
 
-        if (pathString_isSubsetOf_Path(g_packageRootPath.generic_wstring().c_str(), path))
+        if (path_starts_with(path, g_packageRootPath))
         {
             return mfr_path_types::in_package_pvad_area;
         }
-        if (pathString_isSubsetOf_Path(g_short_packageRootPath.generic_wstring().c_str(), path))
+        if (path_starts_with(path, g_short_packageRootPath))
         {
             return mfr_path_types::in_package_pvad_area;
         }
 
         //Log(L"FID_RootDrive  %s", FID_RootDrive.generic_wstring().c_str());
-        if (!pathString_isSubsetOf_Path(FID_RootDrive.generic_wstring().c_str(), path))
+        if (!path_starts_with(path, FID_RootDrive))
         {
             return mfr_path_types::in_other_drive_area;
         }
@@ -92,68 +92,146 @@ namespace mfr
     } // Get_ManagedPathTypeForDriveAbsolute()
 
 
+/// <summary>
+///     Simplifies c:\foo\fie\foe\..\..\fum to c:\foo\fum, in place, and returns the new length.
+///     A "\..\" with no folder to drop after the first three characters (as in C:\Windows\..\..\something) drops
+///     everything before it instead, so that this can not loop forever.
+/// </summary>
+    static std::size_t PurgeDotDotFolders(wchar_t* path, std::size_t length)
+    {
+        constexpr std::wstring_view slashDots = L"\\..\\";
+        size_t SlashDotsStartAt = std::wstring_view(path, length).find(slashDots);
+        while (SlashDotsStartAt != std::wstring_view::npos)
+        {
+            // Keep everything before the backslash that starts the folder, and everything from the final backslash on
+            size_t replaceStartsAt = 0;
+            for (size_t at = (SlashDotsStartAt > 0) ? SlashDotsStartAt - 1 : 0; at > 2; --at)
+            {
+                if (path[at] == L'\\')
+                {
+                    replaceStartsAt = at;
+                    break;
+                }
+            }
+            auto resumeAt = SlashDotsStartAt + 3;
+            std::copy(path + resumeAt, path + length, path + replaceStartsAt);
+            length -= resumeAt - replaceStartsAt;
+            SlashDotsStartAt = std::wstring_view(path, length).find(slashDots);  // look for another
+        }
+        return length;
+    }
+
+
 /// <summary>
 ///     Given an input path, determine the mfr_path
+///     Paths relative to the working directory are made drive absolute in the same way as with
+///     std::filesystem::current_path(), and folder\..\ is simplified away, all within the storage of the result.
 /// 
-    mfr_path create_mfr_path(std::filesystem::path inputPath)
+    mfr_path create_mfr_path(psf::wzstring_view inputPath, std::size_t derivedPaths)
     {
         mfr_path outputPath;
-        outputPath.Request_OriginalPath = inputPath;
         outputPath.Request_DosPathType = psf::path_type(inputPath.c_str());
-        std::wstring wInputPath = inputPath.c_str();
+
+        // The normalized path is made from these three parts
+        std::wstring_view normalPrefix;
+        std::wstring_view normalSeparator;
+        std::wstring_view normalPath = inputPath;
+
+        wchar_t currentDirectoryBuffer[MAX_PATH];
+        std::wstring currentDirectoryFallback;
+        auto currentDirectory = [&]() -> std::wstring_view
+        {
+            auto length = ::GetCurrentDirectoryW(MAX_PATH, currentDirectoryBuffer);
+            if ((length > 0) && (length < MAX_PATH))
+            {
+                return std::wstring_view(currentDirectoryBuffer, length);
+            }
+            currentDirectoryFallback = std::filesystem::current_path().wstring();
+            return currentDirectoryFallback;
+        };
+
+        bool normalize = true;
         switch (outputPath.Request_DosPathType)
         {
         case psf::dos_path_type::drive_absolute:
-            outputPath.Request_NormalizedPath = drive_absolute_to_normal(inputPath);
-            outputPath.Request_MfrPathType = mfr::Get_ManagedPathTypeForDriveAbsolute(outputPath.Request_NormalizedPath);
             break;
         case psf::dos_path_type::drive_relative:   // E.g. "C:path\to\file"  or shell::{...}
-
-            outputPath.Request_NormalizedPath = drive_relative_to_normal(inputPath);
-            outputPath.Request_MfrPathType = mfr::Get_ManagedPathTypeForDriveAbsolute(outputPath.Request_NormalizedPath);
+            normalPrefix = currentDirectory();
+            normalSeparator = L"\\";
+            normalPath = inputPath.substr(2);
             break;
         case psf::dos_path_type::local_device:   // E.g. "\\.\named_pipe"
-            outputPath.Request_NormalizedPath = inputPath;
             outputPath.Request_MfrPathType = mfr::mfr_path_types::unsupported_for_intercepts;
+            normalize = false;
             break;
         case psf::dos_path_type::relative:  // E.g. like  "path\to\file"  
-            outputPath.Request_NormalizedPath = cwd_relative_to_normal(inputPath);
-            outputPath.Request_MfrPathType = mfr::Get_ManagedPathTypeForDriveAbsolute(outputPath.Request_NormalizedPath);
+            normalPrefix = currentDirectory();
+            normalSeparator = L"\\";
             break;
         case psf::dos_path_type::rooted: // E.g. "\path\to\file"
-            outputPath.Request_NormalizedPath = rooted_relative_to_normal(inputPath);
-            outputPath.Request_MfrPathType = mfr::Get_ManagedPathTypeForDriveAbsolute(outputPath.Request_NormalizedPath);
+            normalPrefix = currentDirectory();
+            if ((normalPrefix.length() >= 2) && (normalPrefix[1] == L':'))
+            {
+                normalPrefix = normalPrefix.substr(0, 2);
+            }
+            else
+            {
+                currentDirectoryFallback = std::filesystem::path(std::wstring(normalPrefix)).root_name().wstring();
+                normalPrefix = currentDirectoryFallback;
+            }
             break;
         case psf::dos_path_type::storage_namespace: // E.g. "\\?\STORAGE#Volume..."
-            outputPath.Request_NormalizedPath = inputPath;
             outputPath.Request_MfrPathType = mfr::mfr_path_types::unsupported_for_intercepts;
+            normalize = false;
             break;
         case psf::dos_path_type::root_local_device: // E.g. "\\?\C:\path\to\file"
-            outputPath.Request_NormalizedPath = root_local_relative_to_normal(inputPath);
-            outputPath.Request_MfrPathType = mfr::Get_ManagedPathTypeForDriveAbsolute(outputPath.Request_NormalizedPath);
+            normalPath = inputPath.substr(4);
             break;
         case psf::dos_path_type::unc_absolute:   // E.g. "\\servername\share\path\to\file"
-            outputPath.Request_NormalizedPath = inputPath;
             outputPath.Request_MfrPathType = mfr::mfr_path_types::is_UNC_path;
+            normalize = false;
             break;
         case psf::dos_path_type::protocol:      // e.g: "ftp:\\..."
-            outputPath.Request_NormalizedPath = inputPath;
             outputPath.Request_MfrPathType = mfr::mfr_path_types::is_Protocol;
+            normalize = false;
             break;
         case psf::dos_path_type::shell:
-            outputPath.Request_NormalizedPath = inputPath;
             outputPath.Request_MfrPathType = mfr::mfr_path_types::is_Shell;
+            normalize = false;
             break;
         case psf::dos_path_type::DosSpecial:
-            outputPath.Request_NormalizedPath = inputPath;
             outputPath.Request_MfrPathType = mfr::mfr_path_types::is_DosSpecial;
+            normalize = false;
             break;
         case psf::dos_path_type::unknown:
         default:
-            outputPath.Request_NormalizedPath = inputPath;
             outputPath.Request_MfrPathType = mfr::mfr_path_types::unsupported_for_intercepts;
+            normalize = false;
             break;
         }
+
+        // Typical paths, and what is derived from them, fit inline.  Anything longer is sized for all of it up front, so
+        // that it is a single allocation and the views stored below never have to move.
+        auto normalLength = normalPrefix.length() + normalSeparator.length() + normalPath.length();
+        auto needed = (inputPath.length() + 1) + (normalize ? normalLength + 1 : 0) +
+            derivedPaths * (normalLength + g_MfrLongestBasePathLength + 1);
+        outputPath.storage.reserve(needed);
+
+        outputPath.Request_OriginalPath = outputPath.stored(outputPath.store(inputPath), inputPath.length());
+        if (normalize)
+        {
+            auto offset = outputPath.store(normalPrefix);
+            outputPath.storage.append(normalSeparator);
+            outputPath.storage.append(normalPath);
+            normalLength = PurgeDotDotFolders(outputPath.storage.data() + offset, normalLength);
+            outputPath.storage.truncate(offset + normalLength);
+            outputPath.Request_NormalizedPath = outputPath.stored(offset, normalLength);
+            outputPath.Request_MfrPathType = mfr::Get_ManagedPathTypeForDriveAbsolute(outputPath.Request_NormalizedPath);
+        }
+        else
+        {
+            outputPath.Request_NormalizedPath = outputPath.Request_OriginalPath;
+        }
         return outputPath;
     } // create_mfr_path()
 
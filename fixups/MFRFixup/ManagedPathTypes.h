@@ -4,8 +4,26 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 //-------------------------------------------------------------------------------------------------------
 
+#include <algorithm>
 #include <filesystem>
+#include <functional>
+#include <string_view>
 #include <dos_paths.h>
+#include <inline_wstring.h>
+
+extern std::filesystem::path g_packageRootPath;
+extern std::filesystem::path g_packageVfsRootPath;
+extern std::filesystem::path g_redirectRootPath;
+extern std::filesystem::path g_writablePackageRootPath;
+extern std::filesystem::path g_finalPackageRootPath;
+
+extern std::filesystem::path g_short_packageRootPath;
+extern std::filesystem::path g_short_packageVfsRootPath;
+extern std::filesystem::path g_short_redirectRootPath;
+extern std::filesystem::path g_short_writablePackageRootPath;
+extern std::filesystem::path g_short_finalPackageRootPath;
+
+extern std::filesystem::path FID_RootDrive;
 
 namespace mfr
 {
@@ -61,12 +79,108 @@ namespace mfr
         }
     }
 
+    // Whether path starts with the text of base, compared case insensitively and with either kind of separator.  There
+    // is no check for a component boundary, so C:\Foo is a subset of C:\Foobar as well as of C:\Foo\bar.
+    inline bool path_starts_with(std::wstring_view path, const std::filesystem::path& base)
+    {
+        auto& text = base.native();
+        return (text.length() <= path.length()) && std::equal(text.begin(), text.end(), path.begin(), psf::path_compare{});
+    }
+
     typedef struct mfr_path
     {
-        std::filesystem::path Request_OriginalPath;
-        std::filesystem::path Request_NormalizedPath;
+        // Null terminated views into storage (the same text is shared when the views are equal).
+        psf::wzstring_view    Request_OriginalPath;
+        psf::wzstring_view    Request_NormalizedPath;
         psf::dos_path_type    Request_DosPathType = psf::dos_path_type::unknown;
         mfr_path_types        Request_MfrPathType = mfr_path_types::unknown;
+
+        // Null terminated segments that the views above, and the paths that DetermineCohorts works out from them, point
+        // into.  Typical paths and their cohorts fit inline, so an intercepted call needs no heap for them; pass mfr_path
+        // by reference all the same, as it is not small.
+        static constexpr std::size_t InlineCapacity = 4 * MAX_PATH;
+        psf::inline_wstring<InlineCapacity> storage;
+
+        mfr_path() = default;
+
+        mfr_path(const mfr_path& other) :
+            Request_DosPathType(other.Request_DosPathType),
+            Request_MfrPathType(other.Request_MfrPathType),
+            storage(other.storage)
+        {
+            rebase_views(other, other.storage.c_str(), other.storage.size());
+        }
+
+        mfr_path(mfr_path&& other) noexcept :
+            Request_DosPathType(other.Request_DosPathType),
+            Request_MfrPathType(other.Request_MfrPathType),
+            storage(std::move(other.storage))
+        {
+            // When the storage was on the heap it has simply changed owner
+            auto oldBase = storage.is_inline() ? other.storage.c_str() : storage.c_str();
+            rebase_views(other, oldBase, storage.size());
+        }
+
+        mfr_path& operator=(const mfr_path& other)
+        {
+            if (this != &other)
+            {
+                Request_DosPathType = other.Request_DosPathType;
+                Request_MfrPathType = other.Request_MfrPathType;
+                storage = other.storage;
+                rebase_views(other, other.storage.c_str(), other.storage.size());
+            }
+            return *this;
+        }
+
+        mfr_path& operator=(mfr_path&& other) noexcept
+        {
+            if (this != &other)
+            {
+                auto oldBase = other.storage.c_str();
+                auto oldSize = other.storage.size();
+                Request_DosPathType = other.Request_DosPathType;
+                Request_MfrPathType = other.Request_MfrPathType;
+                storage = std::move(other.storage);
+                rebase_views(other, oldBase, oldSize);
+            }
+            return *this;
+        }
+
+        // Appends text to storage as a new null terminated segment and returns its offset.
+        std::size_t store(std::wstring_view text)
+        {
+            if (!storage.empty())
+            {
+                storage.push_back(L'\0');
+            }
+            auto offset = storage.size();
+            storage.append(text);
+            return offset;
+        }
+
+        // A view of length characters at offset in storage; storage[offset + length] must be a null terminator.
+        psf::wzstring_view stored(std::size_t offset, std::size_t length) const noexcept
+        {
+            return psf::wzstring_view(storage.c_str() + offset, length);
+        }
+
+    private:
+
+        void rebase_views(const mfr_path& other, const wchar_t* oldBase, std::size_t oldSize) noexcept
+        {
+            auto rebase = [&](psf::wzstring_view view)
+            {
+                std::less_equal<const wchar_t*> le;
+                if (le(oldBase, view.data()) && le(view.data(), oldBase + oldSize))
+                {
+                    return stored(view.data() - oldBase, view.length());
+                }
+                return view;
+            };
+            Request_OriginalPath = rebase(other.Request_OriginalPath);
+            Request_NormalizedPath = rebase(other.Request_NormalizedPath);
+        }
     } mfr_path;
 
 
@@ -75,9 +189,11 @@ namespace mfr
 #endif
 
 
-    extern mfr_path_types Get_ManagedPathTypeForDriveAbsolute(std::filesystem::path path);
+    extern mfr_path_types Get_ManagedPathTypeForDriveAbsolute(std::wstring_view path);
 
-    extern mfr_path create_mfr_path(std::filesystem::path inputPath);
+    // derivedPaths is how many paths the caller will go on to store, each the normalized path with one mapping base
+    // swapped for another, so that a long path only has to go to the heap once.
+    extern mfr_path create_mfr_path(psf::wzstring_view inputPath, std::size_t derivedPaths = 0);
 
 
 }
\ No newline at end of file
@@ -49,11 +49,11 @@ BOOL __stdcall MoveFileFixup(_In_ const CharT* existingFileName, _In_ const Char
 
             std::wstring wNewFileName = widen(newFileName);
             std::wstring wExistingFileName = widen(existingFileName);
-            wNewFileName = AdjustSlashes(wNewFileName);
-            wExistingFileName = AdjustSlashes(wExistingFileName);
+            wNewFileName = AdjustSlashes(std::move(wNewFileName));
+            wExistingFileName = AdjustSlashes(std::move(wExistingFileName));
 
-            wExistingFileName = AdjustBadUNC(wExistingFileName, dllInstance, L"MoveFileFixup (existing)");
-            wNewFileName = AdjustBadUNC(wNewFileName, dllInstance, L"MoveFileFixup (new)");
+            wExistingFileName = AdjustBadUNC(std::move(wExistingFileName), dllInstance, L"MoveFileFixup (existing)");
+            wNewFileName = AdjustBadUNC(std::move(wNewFileName), dllInstance, L"MoveFileFixup (new)");
 
             Cohorts cohortsExisting;
             DetermineCohorts(wExistingFileName, &cohortsExisting, moredebug, dllInstance, L"MoveFileFixup (existingFile)");
@@ -61,9 +61,9 @@ BOOL __stdcall MoveFileFixup(_In_ const CharT* existingFileName, _In_ const Char
             Cohorts cohortsNew;
             DetermineCohorts(wNewFileName, &cohortsNew, moredebug, dllInstance, L"MoveFileFixup (newFile)");
 
-            std::wstring UseExistingFile = cohortsExisting.WsRequested;
+            std::wstring UseExistingFile(cohortsExisting.WsRequested);
             bool         ExistingFileIsPackagePath = false;
-            std::wstring UseNewFile = cohortsNew.WsRequested;
+            std::wstring UseNewFile(cohortsNew.WsRequested);
 
             if (!MFRConfiguration.Ilv_Aware)
             {
@@ -71,10 +71,10 @@ BOOL __stdcall MoveFileFixup(_In_ const CharT* existingFileName, _In_ const Char
                 switch (cohortsExisting.file_mfr.Request_MfrPathType)
                 {
                 case mfr::mfr_path_types::in_native_area:
-                    if (cohortsExisting.map.Valid_mapping &&
-                        cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
+                    if (cohortsExisting.map->Valid_mapping &&
+                        cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
                     {
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             UseExistingFile = cohortsExisting.WsRedirected;
                         }
@@ -85,11 +85,11 @@ BOOL __stdcall MoveFileFixup(_In_ const CharT* existingFileName, _In_ const Char
                         }
                         break;
                     }
-                    else if (cohortsExisting.map.Valid_mapping &&
-                        (cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
-                            cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
+                    else if (cohortsExisting.map->Valid_mapping &&
+                        (cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
+                            cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
                     {
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             UseExistingFile = cohortsExisting.WsRedirected;
                         }
@@ -106,9 +106,9 @@ BOOL __stdcall MoveFileFixup(_In_ const CharT* existingFileName, _In_ const Char
                     }
                     break;
                 case mfr::mfr_path_types::in_package_pvad_area:
-                    if (cohortsExisting.map.Valid_mapping)
+                    if (cohortsExisting.map->Valid_mapping)
                     {
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             UseExistingFile = cohortsExisting.WsRedirected;
                         }
@@ -121,10 +121,10 @@ BOOL __stdcall MoveFileFixup(_In_ const CharT* existingFileName, _In_ const Char
                     }
                     break;
                 case mfr::mfr_path_types::in_package_vfs_area:
-                    if (cohortsExisting.map.Valid_mapping &&
-                        cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
+                    if (cohortsExisting.map->Valid_mapping &&
+                        cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
                     {
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             UseExistingFile = cohortsExisting.WsRedirected;
                         }
@@ -135,11 +135,11 @@ BOOL __stdcall MoveFileFixup(_In_ const CharT* existingFileName, _In_ const Char
                         }
                         break;
                     }
-                    else if (cohortsExisting.map.Valid_mapping &&
-                        (cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
-                            cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
+                    else if (cohortsExisting.map->Valid_mapping &&
+                        (cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
+                            cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
                     {
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             UseExistingFile = cohortsExisting.WsRedirected;
                         }
@@ -162,9 +162,9 @@ BOOL __stdcall MoveFileFixup(_In_ const CharT* existingFileName, _In_ const Char
                     }
                     break;
                 case mfr::mfr_path_types::in_redirection_area_writablepackageroot:
-                    if (cohortsExisting.map.Valid_mapping)
+                    if (cohortsExisting.map->Valid_mapping)
                     {
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             UseExistingFile = cohortsExisting.WsRedirected;
                         }
@@ -204,15 +204,15 @@ BOOL __stdcall MoveFileFixup(_In_ const CharT* existingFileName, _In_ const Char
                 switch (cohortsNew.file_mfr.Request_MfrPathType)
                 {
                 case mfr::mfr_path_types::in_native_area:
-                    if (cohortsNew.map.Valid_mapping && !cohortsNew.map.IsAnExclusionToRedirect &&
-                        cohortsNew.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
+                    if (cohortsNew.map->Valid_mapping && !cohortsNew.map->IsAnExclusionToRedirect &&
+                        cohortsNew.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
                     {
                         UseNewFile = cohortsNew.WsRequested;
                         break;
                     }
-                    else if (cohortsNew.map.Valid_mapping && !cohortsNew.map.IsAnExclusionToRedirect &&
-                        (cohortsNew.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
-                            cohortsNew.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
+                    else if (cohortsNew.map->Valid_mapping && !cohortsNew.map->IsAnExclusionToRedirect &&
+                        (cohortsNew.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
+                            cohortsNew.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
                     {
                         UseNewFile = cohortsNew.WsRedirected;
                         break;
@@ -223,29 +223,29 @@ BOOL __stdcall MoveFileFixup(_In_ const CharT* existingFileName, _In_ const Char
                     }
                     break;
                 case mfr::mfr_path_types::in_package_pvad_area:
-                    if (cohortsNew.map.Valid_mapping && !cohortsNew.map.IsAnExclusionToRedirect)
+                    if (cohortsNew.map->Valid_mapping && !cohortsNew.map->IsAnExclusionToRedirect)
                     {
                         UseNewFile = cohortsNew.WsRedirected;
                         break;
                     }
                     break;
                 case mfr::mfr_path_types::in_package_vfs_area:
-                    if (cohortsNew.map.Valid_mapping && !cohortsNew.map.IsAnExclusionToRedirect &&
-                        cohortsNew.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
+                    if (cohortsNew.map->Valid_mapping && !cohortsNew.map->IsAnExclusionToRedirect &&
+                        cohortsNew.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
                     {
                         UseNewFile = cohortsNew.WsRequested;
                         break;
                     }
-                    else if (cohortsNew.map.Valid_mapping && !cohortsNew.map.IsAnExclusionToRedirect &&
-                        (cohortsNew.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
-                            cohortsNew.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
+                    else if (cohortsNew.map->Valid_mapping && !cohortsNew.map->IsAnExclusionToRedirect &&
+                        (cohortsNew.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
+                            cohortsNew.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
                     {
                         UseNewFile = cohortsNew.WsRedirected;
                         break;
                     }
                     break;
                 case mfr::mfr_path_types::in_redirection_area_writablepackageroot:
-                    if (cohortsNew.map.Valid_mapping && !cohortsNew.map.IsAnExclusionToRedirect)
+                    if (cohortsNew.map->Valid_mapping && !cohortsNew.map->IsAnExclusionToRedirect)
                     {
                         UseNewFile = cohortsNew.WsRequested;
                         break;
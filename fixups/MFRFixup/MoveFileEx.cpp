@@ -59,11 +59,11 @@ BOOL __stdcall MoveFileExFixup(
 
             std::wstring wNewFileName = widen(newFileName);
             std::wstring wExistingFileName = widen(existingFileName);
-            wNewFileName = AdjustSlashes(wNewFileName);
-            wExistingFileName = AdjustSlashes(wExistingFileName);
+            wNewFileName = AdjustSlashes(std::move(wNewFileName));
+            wExistingFileName = AdjustSlashes(std::move(wExistingFileName));
 
-            wExistingFileName = AdjustBadUNC(wExistingFileName, dllInstance, L"MoveFileExFixup (existing)");
-            wNewFileName = AdjustBadUNC(wNewFileName, dllInstance, L"MoveFileExFixup (new)");
+            wExistingFileName = AdjustBadUNC(std::move(wExistingFileName), dllInstance, L"MoveFileExFixup (existing)");
+            wNewFileName = AdjustBadUNC(std::move(wNewFileName), dllInstance, L"MoveFileExFixup (new)");
 
 
             Cohorts cohortsExisting;
@@ -74,19 +74,19 @@ BOOL __stdcall MoveFileExFixup(
 
 
             // Determine if path of existing file and if in package.
-            std::wstring UseExistingFile = cohortsExisting.WsRequested;
+            std::wstring UseExistingFile(cohortsExisting.WsRequested);
             bool         ExistingFileIsPackagePath = false;
-            std::wstring UseNewFile = cohortsNew.WsRequested;
+            std::wstring UseNewFile(cohortsNew.WsRequested);
 
             if (!MFRConfiguration.Ilv_Aware)
             {
                 switch (cohortsExisting.file_mfr.Request_MfrPathType)
                 {
                 case mfr::mfr_path_types::in_native_area:
-                    if (cohortsExisting.map.Valid_mapping &&
-                        cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
+                    if (cohortsExisting.map->Valid_mapping &&
+                        cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
                     {
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             UseExistingFile = cohortsExisting.WsRedirected;
                         }
@@ -101,11 +101,11 @@ BOOL __stdcall MoveFileExFixup(
                         }
                         break;
                     }
-                    else if (cohortsExisting.map.Valid_mapping &&
-                        (cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
-                            cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
+                    else if (cohortsExisting.map->Valid_mapping &&
+                        (cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
+                            cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
                     {
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             UseExistingFile = cohortsExisting.WsRedirected;
                         }
@@ -122,9 +122,9 @@ BOOL __stdcall MoveFileExFixup(
                     }
                     break;
                 case mfr::mfr_path_types::in_package_pvad_area:
-                    if (cohortsExisting.map.Valid_mapping)
+                    if (cohortsExisting.map->Valid_mapping)
                     {
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             UseExistingFile = cohortsExisting.WsRedirected;
                         }
@@ -137,10 +137,10 @@ BOOL __stdcall MoveFileExFixup(
                     }
                     break;
                 case mfr::mfr_path_types::in_package_vfs_area:
-                    if (cohortsExisting.map.Valid_mapping &&
-                        cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
+                    if (cohortsExisting.map->Valid_mapping &&
+                        cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
                     {
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             UseExistingFile = cohortsExisting.WsRedirected;
                         }
@@ -151,11 +151,11 @@ BOOL __stdcall MoveFileExFixup(
                         }
                         break;
                     }
-                    else if (cohortsExisting.map.Valid_mapping &&
-                        (cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
-                            cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
+                    else if (cohortsExisting.map->Valid_mapping &&
+                        (cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
+                            cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
                     {
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             UseExistingFile = cohortsExisting.WsRedirected;
                         }
@@ -178,9 +178,9 @@ BOOL __stdcall MoveFileExFixup(
                     }
                     break;
                 case mfr::mfr_path_types::in_redirection_area_writablepackageroot:
-                    if (cohortsExisting.map.Valid_mapping)
+                    if (cohortsExisting.map->Valid_mapping)
                     {
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             UseExistingFile = cohortsExisting.WsRedirected;
                         }
@@ -220,44 +220,44 @@ BOOL __stdcall MoveFileExFixup(
                 switch (cohortsNew.file_mfr.Request_MfrPathType)
                 {
                 case mfr::mfr_path_types::in_native_area:
-                    if (cohortsNew.map.Valid_mapping && !cohortsNew.map.IsAnExclusionToRedirect &&
-                        cohortsNew.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
+                    if (cohortsNew.map->Valid_mapping && !cohortsNew.map->IsAnExclusionToRedirect &&
+                        cohortsNew.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
                     {
                         UseNewFile = cohortsNew.WsRequested;
                         break;
                     }
-                    else if (cohortsNew.map.Valid_mapping && !cohortsNew.map.IsAnExclusionToRedirect &&
-                        (cohortsNew.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
-                            cohortsNew.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
+                    else if (cohortsNew.map->Valid_mapping && !cohortsNew.map->IsAnExclusionToRedirect &&
+                        (cohortsNew.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
+                            cohortsNew.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
                     {
                         UseNewFile = cohortsNew.WsRedirected;
                         break;
                     }
                     break;
                 case mfr::mfr_path_types::in_package_pvad_area:
-                    if (cohortsNew.map.Valid_mapping && !cohortsNew.map.IsAnExclusionToRedirect)
+                    if (cohortsNew.map->Valid_mapping && !cohortsNew.map->IsAnExclusionToRedirect)
                     {
                         UseNewFile = cohortsNew.WsRedirected;
                         break;
                     }
                     break;
                 case mfr::mfr_path_types::in_package_vfs_area:
-                    if (cohortsNew.map.Valid_mapping && !cohortsNew.map.IsAnExclusionToRedirect &&
-                        cohortsNew.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
+                    if (cohortsNew.map->Valid_mapping && !cohortsNew.map->IsAnExclusionToRedirect &&
+                        cohortsNew.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
                     {
                         UseNewFile = cohortsNew.WsRequested;
                         break;
                     }
-                    else if (cohortsNew.map.Valid_mapping && !cohortsNew.map.IsAnExclusionToRedirect &&
-                        (cohortsNew.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
-                            cohortsNew.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
+                    else if (cohortsNew.map->Valid_mapping && !cohortsNew.map->IsAnExclusionToRedirect &&
+                        (cohortsNew.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
+                            cohortsNew.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
                     {
                         UseNewFile = cohortsNew.WsRedirected;
                         break;
                     }
                     break;
                 case mfr::mfr_path_types::in_redirection_area_writablepackageroot:
-                    if (cohortsNew.map.Valid_mapping)
+                    if (cohortsNew.map->Valid_mapping)
                     {
                         UseNewFile = cohortsNew.WsRequested;
                         break;
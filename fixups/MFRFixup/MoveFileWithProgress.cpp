@@ -60,8 +60,8 @@ BOOL __stdcall MoveFileWithProgressFixup(
 
             std::wstring wNewFileName = widen(newFileName);
             std::wstring wExistingFileName = widen(existingFileName);
-            wNewFileName = AdjustSlashes(wNewFileName);
-            wExistingFileName = AdjustSlashes(wExistingFileName);
+            wNewFileName = AdjustSlashes(std::move(wNewFileName));
+            wExistingFileName = AdjustSlashes(std::move(wExistingFileName));
 
             if (wExistingFileName._Starts_with(L"\\\\?\\UNC"))
             {
@@ -86,19 +86,19 @@ BOOL __stdcall MoveFileWithProgressFixup(
             DetermineCohorts(wExistingFileName, &cohortsExisting, moredebug, dllInstance, L"MoveFileWithProgressFixup (existingFile)");
 
             // Determine if path of existing file and if in package.
-            std::wstring UseExistingFile = cohortsExisting.WsRequested;
+            std::wstring UseExistingFile(cohortsExisting.WsRequested);
             bool         ExistingFileIsPackagePath = false;
-            std::wstring UseNewFile = cohortsNew.WsRequested;
+            std::wstring UseNewFile(cohortsNew.WsRequested);
 
             if (!MFRConfiguration.Ilv_Aware)
             {
                 switch (cohortsExisting.file_mfr.Request_MfrPathType)
                 {
                 case mfr::mfr_path_types::in_native_area:
-                    if (cohortsExisting.map.Valid_mapping &&
-                        cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
+                    if (cohortsExisting.map->Valid_mapping &&
+                        cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
                     {
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             UseExistingFile = cohortsExisting.WsRedirected;
                         }
@@ -113,11 +113,11 @@ BOOL __stdcall MoveFileWithProgressFixup(
                         }
                         break;
                     }
-                    else if (cohortsExisting.map.Valid_mapping &&
-                        (cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
-                            cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
+                    else if (cohortsExisting.map->Valid_mapping &&
+                        (cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
+                            cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
                     {
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             UseExistingFile = cohortsExisting.WsRedirected;
                         }
@@ -134,9 +134,9 @@ BOOL __stdcall MoveFileWithProgressFixup(
                     }
                     break;
                 case mfr::mfr_path_types::in_package_pvad_area:
-                    if (cohortsExisting.map.Valid_mapping)
+                    if (cohortsExisting.map->Valid_mapping)
                     {
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             UseExistingFile = cohortsExisting.WsRedirected;
                         }
@@ -149,10 +149,10 @@ BOOL __stdcall MoveFileWithProgressFixup(
                     }
                     break;
                 case mfr::mfr_path_types::in_package_vfs_area:
-                    if (cohortsExisting.map.Valid_mapping &&
-                        cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
+                    if (cohortsExisting.map->Valid_mapping &&
+                        cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
                     {
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             UseExistingFile = cohortsExisting.WsRedirected;
                         }
@@ -163,11 +163,11 @@ BOOL __stdcall MoveFileWithProgressFixup(
                         }
                         break;
                     }
-                    else if (cohortsExisting.map.Valid_mapping &&
-                        (cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
-                            cohortsExisting.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
+                    else if (cohortsExisting.map->Valid_mapping &&
+                        (cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
+                            cohortsExisting.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
                     {
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             UseExistingFile = cohortsExisting.WsRedirected;
                         }
@@ -190,9 +190,9 @@ BOOL __stdcall MoveFileWithProgressFixup(
                     }
                     break;
                 case mfr::mfr_path_types::in_redirection_area_writablepackageroot:
-                    if (cohortsExisting.map.Valid_mapping)
+                    if (cohortsExisting.map->Valid_mapping)
                     {
-                        if (!cohortsExisting.map.IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
+                        if (!cohortsExisting.map->IsAnExclusionToRedirect && PathExists(cohortsExisting.WsRedirected.c_str()))
                         {
                             UseExistingFile = cohortsExisting.WsRedirected;
                         }
@@ -232,44 +232,44 @@ BOOL __stdcall MoveFileWithProgressFixup(
                 switch (cohortsNew.file_mfr.Request_MfrPathType)
                 {
                 case mfr::mfr_path_types::in_native_area:
-                    if (cohortsNew.map.Valid_mapping && !cohortsNew.map.IsAnExclusionToRedirect &&
-                        cohortsNew.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
+                    if (cohortsNew.map->Valid_mapping && !cohortsNew.map->IsAnExclusionToRedirect &&
+                        cohortsNew.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
                     {
                         UseNewFile = cohortsNew.WsRequested;
                         break;
                     }
-                    else if (cohortsNew.map.Valid_mapping && !cohortsNew.map.IsAnExclusionToRedirect &&
-                        (cohortsNew.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
-                            cohortsNew.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
+                    else if (cohortsNew.map->Valid_mapping && !cohortsNew.map->IsAnExclusionToRedirect &&
+                        (cohortsNew.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
+                            cohortsNew.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
                     {
                         UseNewFile = cohortsNew.WsRedirected;
                         break;
                     }
                     break;
                 case mfr::mfr_path_types::in_package_pvad_area:
-                    if (cohortsNew.map.Valid_mapping && !cohortsNew.map.IsAnExclusionToRedirect)
+                    if (cohortsNew.map->Valid_mapping && !cohortsNew.map->IsAnExclusionToRedirect)
                     {
                         UseNewFile = cohortsNew.WsRedirected;
                         break;
                     }
                     break;
                 case mfr::mfr_path_types::in_package_vfs_area:
-                    if (cohortsNew.map.Valid_mapping && !cohortsNew.map.IsAnExclusionToRedirect &&
-                        cohortsNew.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
+                    if (cohortsNew.map->Valid_mapping && !cohortsNew.map->IsAnExclusionToRedirect &&
+                        cohortsNew.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
                     {
                         UseNewFile = cohortsNew.WsRequested;
                         break;
                     }
-                    else if (cohortsNew.map.Valid_mapping && !cohortsNew.map.IsAnExclusionToRedirect &&
-                        (cohortsNew.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
-                            cohortsNew.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
+                    else if (cohortsNew.map->Valid_mapping && !cohortsNew.map->IsAnExclusionToRedirect &&
+                        (cohortsNew.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
+                            cohortsNew.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
                     {
                         UseNewFile = cohortsNew.WsRedirected;
                         break;
                     }
                     break;
                 case mfr::mfr_path_types::in_redirection_area_writablepackageroot:
-                    if (cohortsNew.map.Valid_mapping && !cohortsNew.map.IsAnExclusionToRedirect)
+                    if (cohortsNew.map->Valid_mapping && !cohortsNew.map->IsAnExclusionToRedirect)
                     {
                         UseNewFile = cohortsNew.WsRequested;
                         break;
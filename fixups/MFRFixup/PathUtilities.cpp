@@ -31,21 +31,6 @@ bool path_isSubsetOf_String( std::filesystem::path& basePath, const char* pathst
 }
 
 
-/// <summary>
-/// Utility functions to determine if a given file (w)string is relative to a path, as in the string starts the same.
-/// Comparison is perfomed case insensitive.
-/// </summary>
-bool pathString_isSubsetOf_Path(const wchar_t* pathstring, std::filesystem::path& Path)
-{
-    std::filesystem::path wpathpart = pathstring;
-    return std::equal(wpathpart.native().begin(), wpathpart.native().end(), Path.generic_wstring().c_str(), psf::path_compare{});
-}
-bool pathString_isSubsetOf_Path(const char* pathstring, std::filesystem::path& Path)
-{    
-    std::filesystem::path wpathpart = widen(pathstring);
-    return std::equal(wpathpart.native().begin(), wpathpart.native().end(), Path.generic_wstring().c_str(), psf::path_compare{});
-}
-
 /// <summary>
 ///   Given a Wstring representing a file path, replace the folder portion from one to another.
 ///   There is no check to see if the input string contains the from portion, it is assumed to be correct (even if not case sensitive).
@@ -54,133 +39,27 @@ bool pathString_isSubsetOf_Path(const char* pathstring, std::filesystem::path& P
 /// <param name="from">The path "C:\WINDOWS"</param>
 /// <param name="to">The path "C:\Program Files\WindowsApps\pkgname\VFS\Windows"</param>
 /// <returns>A wstring like "C:\Program Files\WindowsApps\pkgname\VFS\Windows\foo.txt"</returns>
-std::wstring ReplacePathPart(std::wstring inputWstring, std::filesystem::path from, std::filesystem::path to)
+std::wstring ReplacePathPart(std::wstring_view inputWstring, const std::filesystem::path& from, const std::filesystem::path& to)
 {
-    std::wstring outputWstring = to.c_str();
-    size_t removecount = wcslen(from.c_str());
-    if (removecount < wcslen(inputWstring.c_str()))
+    size_t removecount = from.native().length();
+    if (removecount < inputWstring.length())
     {
+        // Sized up front so that building the result is the only allocation
+        std::wstring outputWstring;
+        outputWstring.reserve(to.native().length() + inputWstring.length() - removecount);
+        outputWstring.append(to.native());
         outputWstring.append(inputWstring.substr(removecount));
         return outputWstring;
     }
-    return inputWstring;
+    return std::wstring(inputWstring);
 } // ReplacePathPart
 
-/// <summary>
-/// Given a wstring representing a file path, look for  folder\sub\..\something and remove any .. level and prior folder to simplify the path
-/// </summary>
-/// <param name="inputWs"></param>
-/// <returns></returns>
-std::wstring PurgeDotDotFolders(std::wstring inputWs)
-{
-    std::wstring outputWs = inputWs;
-    size_t SlashDotsStartAt = outputWs.find(L"\\..\\");
-    while (SlashDotsStartAt != std::wstring::npos)
-    {
-        size_t replaceStartsAt = SlashDotsStartAt -1; // before slash
-        while (replaceStartsAt > 0)   
-        {
-            if (replaceStartsAt > 2)
-            {
-                if (outputWs.at(replaceStartsAt) == L'\\')
-                {
-                    std::wstring temp = outputWs.substr(0, replaceStartsAt);
-                    temp.append(outputWs.substr(SlashDotsStartAt + 3));
-                    outputWs = temp;
-                    replaceStartsAt = 0;  // terminate this while
-                    SlashDotsStartAt = outputWs.find(L"\\..\\");  // look for another
-                }
-                else
-                {
-                    replaceStartsAt--;
-                }
-            }
-            else
-            {
-                // have seen path C:\Windows\..\..\something so we must not loop forever.
-                outputWs = outputWs.substr(SlashDotsStartAt + 3);
-                replaceStartsAt = 0;  // terminate this while
-                SlashDotsStartAt = outputWs.find(L"\\..\\");  // look for another
-            }
-        }
-    }
-    return outputWs;
-}
-
-/// <summary>
-///     Utility to convert a drive relative path (c:foo\fie) to drive normal (c:\{cwd}\foo\fie)
-///     Also simplifies c:\foo\fie\foe\..\..\fum to c:\foo\fum
-/// </summary>
-std::filesystem::path drive_relative_to_normal(std::filesystem::path nativeRelativePath)
-{
-    std::wstring resultWstr = std::filesystem::current_path().c_str();
-    resultWstr.append(L"\\");
-    resultWstr.append(nativeRelativePath.c_str() + 2);
-    resultWstr = PurgeDotDotFolders(resultWstr);
-    std::filesystem::path resultPath = resultWstr;
-    return resultPath;
-}
-
-/// <summary>
-///     Utility to convert a rooted relative path (\foo\fie) to drive normal (c:\foo\fie)
-/// </summary>
-std::filesystem::path rooted_relative_to_normal(std::filesystem::path nativeRelativePath)
-{
-    std::wstring resultWstr = std::filesystem::current_path().root_name().c_str();
-    resultWstr.append(nativeRelativePath.c_str());// .generic_wstring().data());
-    resultWstr = PurgeDotDotFolders(resultWstr);
-    std::filesystem::path resultPath = resultWstr;
-    return resultPath;
-}
-
-
-/// <summary>
-///     Utility to convert a cwd relative path (foo\fie) to drive normal (c:\cwd\foo\fie)
-/// </summary>
-std::filesystem::path cwd_relative_to_normal(std::filesystem::path nativeRelativePath)
-{
-    std::wstring resultWstr = std::filesystem::current_path().c_str();
-    resultWstr.append(L"\\");
-    resultWstr.append(nativeRelativePath.c_str());// .generic_wstring().data());
-    resultWstr = PurgeDotDotFolders(resultWstr);
-    std::filesystem::path resultPath = resultWstr;
-    return resultPath;
-}
-
-
-
-/// <summary>
-///     "\\?\C:\path\to\file normalized to C:\path\to\file 
-///     Utility to convert a root local  path (foo\fie) to drive normal (c:\cwd\foo\fie)
-/// </summary>
-std::filesystem::path root_local_relative_to_normal(std::filesystem::path nativeRelativePath)
-{
-    //std::filesystem::path resultPath = "";
-    //resultPath.append(nativeRelativePath.c_str() + 4);// .generic_wstring().data() + 4);
-    std::wstring resultWstr = (nativeRelativePath.c_str() + 4);
-    resultWstr = PurgeDotDotFolders(resultWstr);
-    std::filesystem::path resultPath = resultWstr;
-    return resultPath;
-}
-
-
-/// <summary>
-///     Simplifies c:\foo\fie\foe\..\..\fum to c:\foo\fum
-/// </summary>
-std::filesystem::path drive_absolute_to_normal(std::filesystem::path nativeRelativeAbsolutePath)
-{
-    std::wstring resultWstr = nativeRelativeAbsolutePath.c_str();
-    resultWstr = PurgeDotDotFolders(resultWstr);
-    std::filesystem::path resultPath = resultWstr;
-    return resultPath;
-}
-
 ///
 /// Adjust a file path for common non-standard requests that might or might not work as is,
 /// but give our code fits.  Alter the path to look normal.
 std::wstring AdjustSlashes(std::wstring path)
 {
-    std::wstring wPathName = path;
+    std::wstring& wPathName = path;
     
     // Part 1:  Spin any backwards slashes around.
     std::replace(wPathName.begin(), wPathName.end(), L'/', L'\\');
@@ -214,16 +93,16 @@ std::wstring AdjustSlashes(std::wstring path)
 /// the ILV will cause the app to think it is working with a unc path that is in the form of \\?\UNC\server\share\file.  
 /// This is not a valid UNC path and when the app uses it in subsequent calls, this call will fail.
 /// So if this shows up in a subsequent call, we need to adjust it to \\server\share\file.
-std::wstring AdjustBadUNC(std::wstring path, [[maybe_unused]] DWORD dllInstance, [[maybe_unused]] std::wstring CallerName)
+std::wstring AdjustBadUNC(std::wstring path, [[maybe_unused]] DWORD dllInstance, [[maybe_unused]] const wchar_t* CallerName)
 {
-    std::wstring wPathName = path;
+    std::wstring& wPathName = path;
     if (!wPathName.empty())
     {
         if (wPathName._Starts_with(L"\\\\?\\UNC"))
         {
-            wPathName = L"\\" + wPathName.substr(7);
+            wPathName.replace(0, 7, L"\\");
 #if _DEBUG
-            Log(L"[%d] %s adjustment to existingFileName", dllInstance, CallerName.c_str(), wPathName.c_str());
+            Log(L"[%d] %s adjustment to existingFileName", dllInstance, CallerName, wPathName.c_str());
 #endif
         }
     }
@@ -235,7 +114,7 @@ std::wstring AdjustBadUNC(std::wstring path, [[maybe_unused]] DWORD dllInstance,
 /// </summary>
 /// <param name="path"></param>
 /// <returns></retrns>
-std::wstring MakeLongPath(std::wstring path)
+bool NeedsLongPathPrefix(std::wstring_view path)
 {
     // Only add to full paths on a drive letter
     if (path.length() > 0)
@@ -243,18 +122,27 @@ std::wstring MakeLongPath(std::wstring path)
         // Only add if getting near the limit
         if (path.length() > 230)
         {
-            psf::dos_path_type dosType = psf::path_type(path.c_str());
-            if (dosType == psf::dos_path_type::drive_absolute)
+            // Checked the way psf::path_type does, which would need the path null terminated
+            if (std::iswalpha(path[0]) && (path[1] == L':') && psf::is_path_separator(path[2]))
             {
                 if (path.length() > 3)   // Don't extend C:\ as it messes up FindFirstFile(Ex)
                 {
-                    std::wstring outPath = L"\\\\?\\";
-                    return outPath.append(path);
+                    return true;
                 }
             }
         }
     }
-    return path;
+    return false;
+}
+
+std::wstring MakeLongPath(psf::wzstring_view path)
+{
+    if (NeedsLongPathPrefix(path))
+    {
+        std::wstring outPath = L"\\\\?\\";
+        return outPath.append(path);
+    }
+    return std::wstring(path);
 }
 
 /// <summary>
@@ -384,7 +272,7 @@ void PreCreateFolders(std::wstring filepath, [[maybe_unused]] DWORD dllInstance,
     }
 } // PreCreateFolders()
 
-BOOL Cow(std::wstring from, std::wstring to, [[maybe_unused]] int dllInstance, [[maybe_unused]] std::wstring DebugString)
+BOOL Cow(psf::wzstring_view from, psf::wzstring_view to, [[maybe_unused]] int dllInstance, [[maybe_unused]] std::wstring DebugString)
 {
     switch (MFRConfiguration.COW)
     {
@@ -405,7 +293,7 @@ BOOL Cow(std::wstring from, std::wstring to, [[maybe_unused]] int dllInstance, [
         }
         if (from.length() > 4)
         {
-            std::wstring ext = from.substr(from.length() - 4);
+            auto ext = from.substr(from.length() - 4);
             if (std::equal(ext.begin(), ext.end(), L".exe", psf::path_compare{}))
                 return false;
             if (std::equal(ext.begin(), ext.end(), L".dll", psf::path_compare{}))
@@ -420,7 +308,7 @@ BOOL Cow(std::wstring from, std::wstring to, [[maybe_unused]] int dllInstance, [
         break;
     }
     // We may need to pre-create mising directories for the destination in the redirection area
-    PreCreateFolders(to, dllInstance, DebugString.append(L" via Cow"));
+    PreCreateFolders(std::wstring(to), dllInstance, DebugString.append(L" via Cow"));
 
     std::wstring RdlTo = MakeLongPath(to);
     std::wstring RdlFrom = MakeLongPath(from);
@@ -5,53 +5,67 @@
 //-------------------------------------------------------------------------------------------------------
 
 #include <filesystem>
+#include <string_view>
 #include <dos_paths.h>
 #include <utilities.h>
+#include <psf_logging.h>
 #include "win32_error.h"
 #include "ManagedPathTypes.h"
 #include "ManagedFileMappings.h"
 #include "MfrConfiguration.h"
 
 
-extern std::filesystem::path g_packageRootPath;
-extern std::filesystem::path g_packageVfsRootPath;
-extern std::filesystem::path g_redirectRootPath;
-extern std::filesystem::path g_writablePackageRootPath;
-extern std::filesystem::path g_finalPackageRootPath;
-
-extern std::filesystem::path g_short_packageRootPath;
-extern std::filesystem::path g_short_packageVfsRootPath;
-extern std::filesystem::path g_short_redirectRootPath;
-extern std::filesystem::path g_short_writablePackageRootPath;
-extern std::filesystem::path g_short_finalPackageRootPath;
-
 extern bool path_isSubsetOf_String(std::filesystem::path& basePath, const wchar_t* pathstring);
 extern bool path_isSubsetOf_String(std::filesystem::path& basePath, const char* pathstring);
 
-extern bool pathString_isSubsetOf_Path(const wchar_t* pathstring, std::filesystem::path& basePath);
-extern bool pathString_isSubsetOf_Path(const char* pathstring, std::filesystem::path& basePath);
+extern std::wstring ReplacePathPart(std::wstring_view inputWstring, const std::filesystem::path& from, const std::filesystem::path& to);
 
-extern std::wstring ReplacePathPart(std::wstring inputWstring, std::filesystem::path from, std::filesystem::path to);
+// These take the path by value and hand it back adjusted, so pass it with std::move to save copying it.
+extern std::wstring AdjustSlashes(std::wstring path);
+extern std::wstring AdjustBadUNC(std::wstring path, DWORD dllInstance, const wchar_t* CallerName);
 
-extern std::filesystem::path cwd_relative_to_normal(std::filesystem::path nativeRelativePath); 
-extern std::filesystem::path drive_relative_to_normal(std::filesystem::path nativeRelativePath);
-extern std::filesystem::path rooted_relative_to_normal(std::filesystem::path nativeRelativePath);
-extern std::filesystem::path root_local_relative_to_normal(std::filesystem::path nativeRelativePath);
+extern bool NeedsLongPathPrefix(std::wstring_view path);
+extern std::wstring MakeLongPath(psf::wzstring_view path);
+extern std::wstring MakeNotLongPath(std::wstring path);
 
-extern std::filesystem::path drive_absolute_to_normal(std::filesystem::path nativeAbsolutePath);
+// MakeLongPath for a path that is only needed as a const wchar_t* for the duration of a call.  Paths that are not
+// getting near MAX_PATH are used as they are; the rest are prefixed in a buffer that fits them without the heap.
+class long_path
+{
+public:
+    explicit long_path(psf::wzstring_view path)
+    {
+        if (NeedsLongPathPrefix(path))
+        {
+            m_storage.append(L"\\\\?\\");
+            m_storage.append(path);
+            m_path = psf::wzstring_view(m_storage.c_str(), m_storage.size());
+        }
+        else
+        {
+            m_path = path;
+        }
+    }
 
-extern std::wstring AdjustSlashes(std::wstring path);
-extern std::wstring AdjustBadUNC(std::wstring path, DWORD dllInstance, std::wstring CallerName);
+    long_path(const long_path&) = delete;
+    long_path& operator=(const long_path&) = delete;
 
-extern std::wstring MakeLongPath(std::wstring path);
-extern std::wstring MakeNotLongPath(std::wstring path);
+    const wchar_t* c_str() const noexcept
+    {
+        return m_path.c_str();
+    }
+
+private:
+    psf::wzstring_view m_path;
+    psf::inline_wstring<2 * MAX_PATH> m_storage;
+};
 
 extern bool PathExists(const wchar_t* path);
 extern bool PathParentExists(const wchar_t* path);
 
 extern void PreCreateFolders(std::wstring filepath, DWORD dllInstance, std::wstring DebugMessage);
 
-extern BOOL Cow(std::wstring from, std::wstring to, int dllInstance, std::wstring DebugString);
+extern BOOL Cow(psf::wzstring_view from, psf::wzstring_view to, int dllInstance, std::wstring DebugString);
 
 extern std::filesystem::path ConvertPathToShortPath(std::filesystem::path inputPath);
 
@@ -59,6 +73,9 @@ extern bool IsCreateForChange(DWORD desiredAccess, DWORD creationDisposition, DW
 extern bool IsSpecialCaseforChange(std::wstring filepath);
 extern bool IsCreateForDirectory(DWORD desiredAccess, DWORD creationDisposition, DWORD flagsAndAttributes);
 
+// The file operations that MFRFixup intercepts
+inline psf::log_category g_logMfrFiles{ "files" };
+
 extern std::wstring Log_DesiredAccess(DWORD desiredAccess);
 extern std::wstring Log_ShareMode(DWORD shareMode);
 extern std::wstring Log_CreationDisposition(DWORD creationDisposition);
@@ -26,9 +26,9 @@
 #include "DetermineCohorts.h"
 #include "DetermineIlvPaths.h"
 
-BOOL  WRAPPER_REMOVEDIRECTORY(std::wstring theRemovingDirectory,  DWORD dllInstance, bool debug)
+BOOL  WRAPPER_REMOVEDIRECTORY(psf::wzstring_view theRemovingDirectory,  DWORD dllInstance, bool debug)
 {
-    std::wstring LongRemovingDirectory = MakeLongPath(theRemovingDirectory);
+    long_path LongRemovingDirectory(theRemovingDirectory);
     BOOL retfinal = impl::RemoveDirectoryW(LongRemovingDirectory.c_str());
     if (debug)
     {
@@ -65,12 +65,12 @@ BOOL __stdcall RemoveDirectoryFixup(_In_ const CharT* pathName) noexcept
         if (guard)
         {
             std::wstring wPathName = widen(pathName);
-            wPathName = AdjustSlashes(wPathName);
+            wPathName = AdjustSlashes(std::move(wPathName));
 #if _DEBUG
             LogString(dllInstance, L"RemoveDirectoryFixup for pathName", wPathName.c_str());
 #endif
 
-            wPathName = AdjustBadUNC(wPathName, dllInstance, L"RemoveDirectoryFixup");
+            wPathName = AdjustBadUNC(std::move(wPathName), dllInstance, L"RemoveDirectoryFixup");
 
             Cohorts cohorts;
             DetermineCohorts(wPathName, &cohorts, moredebug, dllInstance, L"RemoveDirectoryFixup");
@@ -83,11 +83,11 @@ BOOL __stdcall RemoveDirectoryFixup(_In_ const CharT* pathName) noexcept
                 switch (cohorts.file_mfr.Request_MfrPathType)
                 {
                 case mfr::mfr_path_types::in_native_area:
-                    if (cohorts.map.Valid_mapping &&
-                        cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
+                    if (cohorts.map->Valid_mapping &&
+                        cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
                     {
                         // try the request path, which must be the local redirected version by definition, and then a package equivalent
-                        if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                        if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                         {
                             // Still do this to set attributes
                             retfinal = WRAPPER_REMOVEDIRECTORY(cohorts.WsRedirected, dllInstance, debug);
@@ -123,12 +123,12 @@ BOOL __stdcall RemoveDirectoryFixup(_In_ const CharT* pathName) noexcept
                             return retfinal;
                         }
                     }
-                    else if (cohorts.map.Valid_mapping &&
-                        (cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
-                            cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
+                    else if (cohorts.map->Valid_mapping &&
+                        (cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
+                            cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
                     {
                         // try the redirected path, then package (via COW), then native (possibly via COW).
-                        if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                        if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                         {
                             retfinal = WRAPPER_REMOVEDIRECTORY(cohorts.WsRedirected, dllInstance, debug);
                             return retfinal;
@@ -156,10 +156,10 @@ BOOL __stdcall RemoveDirectoryFixup(_In_ const CharT* pathName) noexcept
                     }
                     break;
                 case mfr::mfr_path_types::in_package_pvad_area:
-                    if (cohorts.map.Valid_mapping)
+                    if (cohorts.map->Valid_mapping)
                     {
                         //// try the redirected path, then package (COW), then don't need native.
-                        if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                        if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                         {
                             retfinal = WRAPPER_REMOVEDIRECTORY(cohorts.WsRedirected, dllInstance, debug);
                             return retfinal;
@@ -186,11 +186,11 @@ BOOL __stdcall RemoveDirectoryFixup(_In_ const CharT* pathName) noexcept
                     }
                     break;
                 case mfr::mfr_path_types::in_package_vfs_area:
-                    if (cohorts.map.Valid_mapping &&
-                        cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
+                    if (cohorts.map->Valid_mapping &&
+                        cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
                     {
                         // try the redirection path, then the package (COW).
-                        if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                        if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                         {
                             retfinal = WRAPPER_REMOVEDIRECTORY(cohorts.WsRedirected, dllInstance, debug);
                             return retfinal;
@@ -215,12 +215,12 @@ BOOL __stdcall RemoveDirectoryFixup(_In_ const CharT* pathName) noexcept
                             return retfinal;
                         }
                     }
-                    else if (cohorts.map.Valid_mapping &&
-                        (cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
-                            cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
+                    else if (cohorts.map->Valid_mapping &&
+                        (cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_containerized ||
+                            cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs))
                     {
                         // try the redirection path, then the package (COW), then native (possibly COW)
-                        if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                        if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                         {
                             retfinal = WRAPPER_REMOVEDIRECTORY(cohorts.WsRedirected, dllInstance, debug);
                             return retfinal;
@@ -252,10 +252,10 @@ BOOL __stdcall RemoveDirectoryFixup(_In_ const CharT* pathName) noexcept
                     }
                     break;
                 case mfr::mfr_path_types::in_redirection_area_writablepackageroot:
-                    if (cohorts.map.Valid_mapping)
+                    if (cohorts.map->Valid_mapping)
                     {
                         // try the redirected path, then package (COW), then possibly native (Possibly COW).
-                        if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                        if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                         {
                             retfinal = WRAPPER_REMOVEDIRECTORY(cohorts.WsRedirected, dllInstance, debug);
                             return retfinal;
@@ -26,13 +26,13 @@
 #include "DetermineIlvPaths.h"
 
 
-std::wstring DetermineNonIlvPathForReplaced(Cohorts cohortsReplaced, [[maybe_unused]] DWORD dllInstance, [[maybe_unused]] bool moredebug)
+std::wstring DetermineNonIlvPathForReplaced(const Cohorts& cohortsReplaced, [[maybe_unused]] DWORD dllInstance, [[maybe_unused]] bool moredebug)
 {
-    std::wstring UseReplacedFile = cohortsReplaced.WsRequested;
+    std::wstring UseReplacedFile(cohortsReplaced.WsRequested);
     switch (cohortsReplaced.file_mfr.Request_MfrPathType)
     {
     case mfr::mfr_path_types::in_native_area:
-        if (cohortsReplaced.map.Valid_mapping)
+        if (cohortsReplaced.map->Valid_mapping)
         {
             UseReplacedFile = cohortsReplaced.WsRedirected;
         }
@@ -42,7 +42,7 @@ std::wstring DetermineNonIlvPathForReplaced(Cohorts cohortsReplaced, [[maybe_unu
         }
         break;
     case mfr::mfr_path_types::in_package_pvad_area:
-        if (cohortsReplaced.map.Valid_mapping)
+        if (cohortsReplaced.map->Valid_mapping)
         {
             UseReplacedFile = cohortsReplaced.WsRedirected;
         }
@@ -52,7 +52,7 @@ std::wstring DetermineNonIlvPathForReplaced(Cohorts cohortsReplaced, [[maybe_unu
         }
         break;
     case mfr::mfr_path_types::in_package_vfs_area:
-        if (cohortsReplaced.map.Valid_mapping)
+        if (cohortsReplaced.map->Valid_mapping)
         {
             UseReplacedFile = cohortsReplaced.WsRedirected;
         }
@@ -62,7 +62,7 @@ std::wstring DetermineNonIlvPathForReplaced(Cohorts cohortsReplaced, [[maybe_unu
         }
         break;
     case mfr::mfr_path_types::in_redirection_area_writablepackageroot:
-        if (cohortsReplaced.map.Valid_mapping)
+        if (cohortsReplaced.map->Valid_mapping)
         {
             UseReplacedFile = cohortsReplaced.WsRequested;
         }
@@ -88,18 +88,18 @@ std::wstring DetermineNonIlvPathForReplaced(Cohorts cohortsReplaced, [[maybe_unu
     return UseReplacedFile;
 }
 
-std::wstring DetermineNonIlvPathForReplacement(Cohorts cohortsReplacement, [[maybe_unused]] DWORD dllInstance, [[maybe_unused]] bool moredebug)
+std::wstring DetermineNonIlvPathForReplacement(const Cohorts& cohortsReplacement, [[maybe_unused]] DWORD dllInstance, [[maybe_unused]] bool moredebug)
 {
-    std::wstring UseReplacementFile = cohortsReplacement.WsRequested;
+    std::wstring UseReplacementFile(cohortsReplacement.WsRequested);
     switch (cohortsReplacement.file_mfr.Request_MfrPathType)
     {
     case mfr::mfr_path_types::in_native_area:
-        if (cohortsReplacement.map.Valid_mapping)
+        if (cohortsReplacement.map->Valid_mapping)
         {
-            switch (cohortsReplacement.map.RedirectionFlags)
+            switch (cohortsReplacement.map->RedirectionFlags)
             {
             case mfr::mfr_redirect_flags::prefer_redirection_local:
-                if (!cohortsReplacement.map.IsAnExclusionToRedirect && PathExists(cohortsReplacement.WsNative.c_str()))
+                if (!cohortsReplacement.map->IsAnExclusionToRedirect && PathExists(cohortsReplacement.WsNative.c_str()))
                 {
                     UseReplacementFile = cohortsReplacement.WsNative;
                 }
@@ -114,7 +114,7 @@ std::wstring DetermineNonIlvPathForReplacement(Cohorts cohortsReplacement, [[may
                 break;
             case mfr::mfr_redirect_flags::prefer_redirection_containerized:
             case mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs:
-                if (!cohortsReplacement.map.IsAnExclusionToRedirect && PathExists(cohortsReplacement.WsRedirected.c_str()))
+                if (!cohortsReplacement.map->IsAnExclusionToRedirect && PathExists(cohortsReplacement.WsRedirected.c_str()))
                 {
                     UseReplacementFile = cohortsReplacement.WsRedirected;
                 }
@@ -145,16 +145,16 @@ std::wstring DetermineNonIlvPathForReplacement(Cohorts cohortsReplacement, [[may
         }
         break;
     case mfr::mfr_path_types::in_package_pvad_area:
-        if (cohortsReplacement.map.Valid_mapping)
+        if (cohortsReplacement.map->Valid_mapping)
         {
-            switch (cohortsReplacement.map.RedirectionFlags)
+            switch (cohortsReplacement.map->RedirectionFlags)
             {
             case mfr::mfr_redirect_flags::prefer_redirection_local:
                 // not possible, fall through
                 break;
             case mfr::mfr_redirect_flags::prefer_redirection_containerized:
             case mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs:
-                if (!cohortsReplacement.map.IsAnExclusionToRedirect && PathExists(cohortsReplacement.WsRedirected.c_str()))
+                if (!cohortsReplacement.map->IsAnExclusionToRedirect && PathExists(cohortsReplacement.WsRedirected.c_str()))
                 {
                     UseReplacementFile = cohortsReplacement.WsRedirected;
                 }
@@ -176,12 +176,12 @@ std::wstring DetermineNonIlvPathForReplacement(Cohorts cohortsReplacement, [[may
         }
         break;
     case mfr::mfr_path_types::in_package_vfs_area:
-        if (cohortsReplacement.map.Valid_mapping)
+        if (cohortsReplacement.map->Valid_mapping)
         {
-            switch (cohortsReplacement.map.RedirectionFlags)
+            switch (cohortsReplacement.map->RedirectionFlags)
             {
             case mfr::mfr_redirect_flags::prefer_redirection_local:
-                if (!cohortsReplacement.map.IsAnExclusionToRedirect && PathExists(cohortsReplacement.WsRedirected.c_str()))
+                if (!cohortsReplacement.map->IsAnExclusionToRedirect && PathExists(cohortsReplacement.WsRedirected.c_str()))
                 {
                     UseReplacementFile = cohortsReplacement.WsRedirected;
                 }
@@ -196,7 +196,7 @@ std::wstring DetermineNonIlvPathForReplacement(Cohorts cohortsReplacement, [[may
                 break;
             case mfr::mfr_redirect_flags::prefer_redirection_containerized:
             case mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs:
-                if (!cohortsReplacement.map.IsAnExclusionToRedirect && PathExists(cohortsReplacement.WsRedirected.c_str()))
+                if (!cohortsReplacement.map->IsAnExclusionToRedirect && PathExists(cohortsReplacement.WsRedirected.c_str()))
                 {
                     UseReplacementFile = cohortsReplacement.WsRedirected;
                 }
@@ -227,16 +227,16 @@ std::wstring DetermineNonIlvPathForReplacement(Cohorts cohortsReplacement, [[may
         }
         break;
     case mfr::mfr_path_types::in_redirection_area_writablepackageroot:
-        if (cohortsReplacement.map.Valid_mapping)
+        if (cohortsReplacement.map->Valid_mapping)
         {
-            switch (cohortsReplacement.map.RedirectionFlags)
+            switch (cohortsReplacement.map->RedirectionFlags)
             {
             case mfr::mfr_redirect_flags::prefer_redirection_local:
                 // not possible
                 break;
             case mfr::mfr_redirect_flags::prefer_redirection_containerized:
             case mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs:
-                if (!cohortsReplacement.map.IsAnExclusionToRedirect && PathExists(cohortsReplacement.WsRedirected.c_str()))
+                if (!cohortsReplacement.map->IsAnExclusionToRedirect && PathExists(cohortsReplacement.WsRedirected.c_str()))
                 {
                     UseReplacementFile = cohortsReplacement.WsRedirected;
                 }
@@ -284,22 +284,22 @@ std::wstring DetermineNonIlvPathForReplacement(Cohorts cohortsReplacement, [[may
     return UseReplacementFile;
 }
 
-std::wstring DetermineNonIlvPathForBackup(Cohorts cohortsBackup, [[maybe_unused]] DWORD dllInstance, [[maybe_unused]] bool moredebug)
+std::wstring DetermineNonIlvPathForBackup(const Cohorts& cohortsBackup, [[maybe_unused]] DWORD dllInstance, [[maybe_unused]] bool moredebug)
 {
-    std::wstring UseBackupFile = cohortsBackup.WsRequested;
+    std::wstring UseBackupFile(cohortsBackup.WsRequested);
     switch (cohortsBackup.file_mfr.Request_MfrPathType)
     {
     case mfr::mfr_path_types::in_native_area:
-        if (cohortsBackup.map.Valid_mapping)
+        if (cohortsBackup.map->Valid_mapping)
         {
-            switch (cohortsBackup.map.RedirectionFlags)
+            switch (cohortsBackup.map->RedirectionFlags)
             {
             case mfr::mfr_redirect_flags::prefer_redirection_local:
                 UseBackupFile = cohortsBackup.WsRequested;
                 break;
             case mfr::mfr_redirect_flags::prefer_redirection_containerized:
             case mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs:
-                if (!cohortsBackup.map.IsAnExclusionToRedirect)
+                if (!cohortsBackup.map->IsAnExclusionToRedirect)
                 {
                     UseBackupFile = cohortsBackup.WsRedirected;
                 }
@@ -317,7 +317,7 @@ std::wstring DetermineNonIlvPathForBackup(Cohorts cohortsBackup, [[maybe_unused]
         }
         break;
     case mfr::mfr_path_types::in_package_pvad_area:
-        if (cohortsBackup.map.Valid_mapping && !cohortsBackup.map.IsAnExclusionToRedirect)
+        if (cohortsBackup.map->Valid_mapping && !cohortsBackup.map->IsAnExclusionToRedirect)
         {
             UseBackupFile = cohortsBackup.WsRedirected;
             break;
@@ -328,19 +328,19 @@ std::wstring DetermineNonIlvPathForBackup(Cohorts cohortsBackup, [[maybe_unused]
         }
         break;
     case mfr::mfr_path_types::in_package_vfs_area:
-        if (cohortsBackup.map.Valid_mapping)
+        if (cohortsBackup.map->Valid_mapping)
         {
-            switch (cohortsBackup.map.RedirectionFlags)
+            switch (cohortsBackup.map->RedirectionFlags)
             {
             case mfr::mfr_redirect_flags::prefer_redirection_local:
-                if (!cohortsBackup.map.IsAnExclusionToRedirect)
+                if (!cohortsBackup.map->IsAnExclusionToRedirect)
                 {
                     UseBackupFile = cohortsBackup.WsRequested;
                 }
                 break;
             case mfr::mfr_redirect_flags::prefer_redirection_containerized:
             case mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs:
-                if (!cohortsBackup.map.IsAnExclusionToRedirect)
+                if (!cohortsBackup.map->IsAnExclusionToRedirect)
                 {
                     UseBackupFile = cohortsBackup.WsRedirected;
                 }
@@ -358,7 +358,7 @@ std::wstring DetermineNonIlvPathForBackup(Cohorts cohortsBackup, [[maybe_unused]
         }
         break;
     case mfr::mfr_path_types::in_redirection_area_writablepackageroot:
-        if (cohortsBackup.map.Valid_mapping && !cohortsBackup.map.IsAnExclusionToRedirect)
+        if (cohortsBackup.map->Valid_mapping && !cohortsBackup.map->IsAnExclusionToRedirect)
         {
             UseBackupFile = cohortsBackup.WsRedirected;
             break;
@@ -440,11 +440,11 @@ BOOL __stdcall ReplaceFileFixup(
 #endif
             std::wstring wReplacedFileName = widen(replacedFileName);
             std::wstring wReplacementFileName = widen(replacementFileName);
-            wReplacedFileName = AdjustSlashes(wReplacedFileName);
-            wReplacementFileName = AdjustSlashes(wReplacementFileName);
+            wReplacedFileName = AdjustSlashes(std::move(wReplacedFileName));
+            wReplacementFileName = AdjustSlashes(std::move(wReplacementFileName));
 
-            wReplacedFileName = AdjustBadUNC(wReplacedFileName, dllInstance, L"ReplaceFileFixup (replaced)");
-            wReplacementFileName = AdjustBadUNC(wReplacementFileName, dllInstance, L"ReplaceFileFixup (replacement)");
+            wReplacedFileName = AdjustBadUNC(std::move(wReplacedFileName), dllInstance, L"ReplaceFileFixup (replaced)");
+            wReplacementFileName = AdjustBadUNC(std::move(wReplacementFileName), dllInstance, L"ReplaceFileFixup (replacement)");
 
             Cohorts cohortsReplaced;
             DetermineCohorts(wReplacedFileName, &cohortsReplaced, moredebug, dllInstance, L"ReplaceFileFixup (replacedFile)");
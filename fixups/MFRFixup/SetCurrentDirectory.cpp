@@ -26,9 +26,9 @@
 // exists inside the package.  
 
 
-BOOL  WRAPPER_SETCURRENTDIRECTORY(std::wstring thePath, DWORD dllInstance, bool debug)
+BOOL  WRAPPER_SETCURRENTDIRECTORY(psf::wzstring_view thePath, DWORD dllInstance, bool debug)
 {
-    std::wstring LongThePath = MakeLongPath(thePath);
+    long_path LongThePath(thePath);
     BOOL retfinal = impl::SetCurrentDirectoryW(LongThePath.c_str());
     if (debug)
     {
@@ -65,7 +65,7 @@ BOOL __stdcall SetCurrentDirectoryFixup(_In_ const CharT* pathName) noexcept
         if (guard)
         {
             std::wstring wPathName = widen(pathName);
-            wPathName = AdjustSlashes(wPathName);
+            wPathName = AdjustSlashes(std::move(wPathName));
 
 
 #if _DEBUG
@@ -79,8 +79,8 @@ BOOL __stdcall SetCurrentDirectoryFixup(_In_ const CharT* pathName) noexcept
                 switch (cohorts.file_mfr.Request_MfrPathType)
                 {
                 case mfr::mfr_path_types::in_native_area:
-                    if (cohorts.map.Valid_mapping &&
-                        cohorts.map.RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
+                    if (cohorts.map->Valid_mapping &&
+                        cohorts.map->RedirectionFlags == mfr::mfr_redirect_flags::prefer_redirection_local)
                     {
                         // treat as is; don't redirect
                     }
@@ -26,9 +26,9 @@
 
 
 
-BOOL WRAPPER_SETFILEATTRIBUTES(std::wstring theDestinationFilename, DWORD fileAttributes, DWORD dllInstance, bool debug)
+BOOL WRAPPER_SETFILEATTRIBUTES(psf::wzstring_view theDestinationFilename, DWORD fileAttributes, DWORD dllInstance, bool debug)
     { 
-        std::wstring LongDestinationFilename = MakeLongPath(theDestinationFilename); 
+        long_path LongDestinationFilename(theDestinationFilename); 
         bool retfinal = impl::SetFileAttributesW(LongDestinationFilename.c_str(),fileAttributes); 
         if (debug) 
         { 
@@ -66,13 +66,13 @@ BOOL __stdcall SetFileAttributesFixup(_In_ const CharT* fileName, _In_ DWORD fil
         {
             dllInstance = ++g_InterceptInstance;
             std::wstring wfileName = widen(fileName);
-            wfileName = AdjustSlashes(wfileName);
+            wfileName = AdjustSlashes(std::move(wfileName));
 
 #if _DEBUG
             LogString(dllInstance, L"SetFileAttributesFixup for fileName", wfileName.c_str());
 #endif
 
-            wfileName = AdjustBadUNC(wfileName, dllInstance, L"SetFileAttributesFixup");
+            wfileName = AdjustBadUNC(std::move(wfileName), dllInstance, L"SetFileAttributesFixup");
             
 
             // This get is inheirently a write operation in all cases.
@@ -85,15 +85,15 @@ BOOL __stdcall SetFileAttributesFixup(_In_ const CharT* fileName, _In_ DWORD fil
                 switch (cohorts.file_mfr.Request_MfrPathType)
                 {
                 case mfr::mfr_path_types::in_native_area:
-                    if (cohorts.map.Valid_mapping)
+                    if (cohorts.map->Valid_mapping)
                     {
-                        switch (cohorts.map.RedirectionFlags)
+                        switch (cohorts.map->RedirectionFlags)
                         {
                         case mfr::mfr_redirect_flags::prefer_redirection_local:
                             if (!MFRConfiguration.Ilv_Aware)
                             {
                                 // try the request path, which must be the local redirected version by definition, and then a package equivalent using COW
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     retfinal = WRAPPER_SETFILEATTRIBUTES(cohorts.WsRedirected, fileAttributes, dllInstance, debug);
                                     return retfinal;
@@ -130,7 +130,7 @@ BOOL __stdcall SetFileAttributesFixup(_In_ const CharT* fileName, _In_ DWORD fil
 #if MOREDEBUG
                                 Log(L"[%d] SetFileAttributesFixup: Native Local with ILV", dllInstance);
 #endif
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsPackage.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsPackage.c_str()))
                                 {
                                     retfinal = WRAPPER_SETFILEATTRIBUTES(cohorts.WsRequested, fileAttributes, dllInstance, debug);
                                     if (!retfinal && GetLastError() == ERROR_CANT_ACCESS_FILE)
@@ -171,7 +171,7 @@ BOOL __stdcall SetFileAttributesFixup(_In_ const CharT* fileName, _In_ DWORD fil
                             if (!MFRConfiguration.Ilv_Aware)
                             {
                                 // try the redirected path, then package (via COW), then native (possibly via COW).
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     retfinal = WRAPPER_SETFILEATTRIBUTES(cohorts.WsRedirected, fileAttributes, dllInstance, debug);
                                     return retfinal;
@@ -194,7 +194,7 @@ BOOL __stdcall SetFileAttributesFixup(_In_ const CharT* fileName, _In_ DWORD fil
                                     // TODO: This might not be the best way to decide is COW is appropriate.  
                                     //       Possibly we should always do it, or possibly only if the equivalent VFS folder exists in the package.
                                     //       Setting attributes on an external file subject to traditional redirection seems an unlikely scenario that we need COW, but it might make an old app work.
-                                    if (cohorts.map.DoesRuntimeMapNativeToVFS)
+                                    if (cohorts.map->DoesRuntimeMapNativeToVFS)
                                     {
                                         if (Cow(cohorts.WsNative, cohorts.WsRedirected, dllInstance, L"SetFileAttributes"))
                                         {
@@ -227,7 +227,7 @@ BOOL __stdcall SetFileAttributesFixup(_In_ const CharT* fileName, _In_ DWORD fil
                                 Log(L"[%d] SetFileAttributeFixups: Native Traditional with ILV", dllInstance);
 #endif
                                 // WIth IlvAware, we can't set the attribute and get this specific error if the file is in the package.
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     retfinal = WRAPPER_SETFILEATTRIBUTES(cohorts.WsRedirected, fileAttributes, dllInstance, debug);
                                 }
@@ -259,9 +259,9 @@ BOOL __stdcall SetFileAttributesFixup(_In_ const CharT* fileName, _In_ DWORD fil
                     }
                     break;
                 case mfr::mfr_path_types::in_package_pvad_area:
-                    if (cohorts.map.Valid_mapping)
+                    if (cohorts.map->Valid_mapping)
                     {
-                        switch (cohorts.map.RedirectionFlags)
+                        switch (cohorts.map->RedirectionFlags)
                         {
                         case mfr::mfr_redirect_flags::prefer_redirection_local:
                             // not possible, fall through
@@ -271,7 +271,7 @@ BOOL __stdcall SetFileAttributesFixup(_In_ const CharT* fileName, _In_ DWORD fil
                             if (!MFRConfiguration.Ilv_Aware)
                             {
                                 //// try the redirected path, then package (COW), then don't need native.
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     retfinal = WRAPPER_SETFILEATTRIBUTES(cohorts.WsRedirected, fileAttributes, dllInstance, debug);
                                     return retfinal;
@@ -327,14 +327,14 @@ BOOL __stdcall SetFileAttributesFixup(_In_ const CharT* fileName, _In_ DWORD fil
                     }
                     break;
                 case mfr::mfr_path_types::in_package_vfs_area:
-                    if (cohorts.map.Valid_mapping)
+                    if (cohorts.map->Valid_mapping)
                     {
-                        switch (cohorts.map.RedirectionFlags)
+                        switch (cohorts.map->RedirectionFlags)
                         {
                         case mfr::mfr_redirect_flags::prefer_redirection_local:
                             if (!MFRConfiguration.Ilv_Aware)
                             {
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     retfinal = WRAPPER_SETFILEATTRIBUTES(cohorts.WsRedirected, fileAttributes, dllInstance, debug);
                                     return retfinal;
@@ -406,7 +406,7 @@ BOOL __stdcall SetFileAttributesFixup(_In_ const CharT* fileName, _In_ DWORD fil
                             if (!MFRConfiguration.Ilv_Aware)
                             {
                                 // try the redirection path, then the package (COW), then native (possibly COW)
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     retfinal = WRAPPER_SETFILEATTRIBUTES(cohorts.WsRedirected, fileAttributes, dllInstance, debug);
                                     return retfinal;
@@ -429,7 +429,7 @@ BOOL __stdcall SetFileAttributesFixup(_In_ const CharT* fileName, _In_ DWORD fil
                                     // TODO: This might not be the best way to decide is COW is appropriate.  
                                     //       Possibly we should always do it, or possibly only if the equivalent VFS folder exists in the package.
                                     //       Setting attributes on an external file subject to traditional redirection seems an unlikely scenario that we need COW, but it might make an old app work.
-                                    if (cohorts.map.DoesRuntimeMapNativeToVFS)
+                                    if (cohorts.map->DoesRuntimeMapNativeToVFS)
                                     {
                                         if (Cow(cohorts.WsNative, cohorts.WsRedirected, dllInstance, L"SetFileAttributes"))
                                         {
@@ -488,12 +488,12 @@ BOOL __stdcall SetFileAttributesFixup(_In_ const CharT* fileName, _In_ DWORD fil
                     }
                     break;
                 case mfr::mfr_path_types::in_redirection_area_writablepackageroot:
-                    if (cohorts.map.Valid_mapping)
+                    if (cohorts.map->Valid_mapping)
                     {
                         if (!MFRConfiguration.Ilv_Aware)
                         {
                             // try the redirected path, then package (COW), then possibly native (Possibly COW).
-                            if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                            if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                             {
                                 retfinal = WRAPPER_SETFILEATTRIBUTES(cohorts.WsRedirected, fileAttributes, dllInstance, debug);
                                 return retfinal;
@@ -518,7 +518,7 @@ BOOL __stdcall SetFileAttributesFixup(_In_ const CharT* fileName, _In_ DWORD fil
                                     // TODO: This might not be the best way to decide is COW is appropriate.  
                                     //       Possibly we should always do it, or possibly only if the equivalent VFS folder exists in the package.
                                     //       Setting attributes on an external file subject to traditional redirection seems an unlikely scenario that we need COW, but it might make an old app work.
-                                    if (cohorts.map.DoesRuntimeMapNativeToVFS)
+                                    if (cohorts.map->DoesRuntimeMapNativeToVFS)
                                     {
                                         if (Cow(cohorts.WsNative, cohorts.WsRedirected, dllInstance, L"SetFileAttributes"))
                                         {
@@ -24,7 +24,7 @@
 
 #define WRAPPER_WRITEPRIVATEPROFILESECTION(theDestinationFilename, debug ) \
     { \
-        std::wstring LongDestinationFilename = MakeLongPath(theDestinationFilename); \
+        long_path LongDestinationFilename(theDestinationFilename); \
         if constexpr (psf::is_ansi<CharT>) \
         { \
             retfinal = impl::WritePrivateProfileSectionW(widen_argument(appName).c_str(), widen_argument(string).c_str(), LongDestinationFilename.c_str()); \
@@ -71,8 +71,8 @@ BOOL __stdcall WritePrivateProfileSectionFixup(
                 // This get is inheirently a write operation in all cases.
                 // We prefer to use the redirecton case, if present.
                 std::wstring wfileName = widen(fileName);
-                wfileName = AdjustSlashes(wfileName);
-                wfileName = AdjustBadUNC(wfileName, dllInstance, L"WritePrivateProfileSectionFixup");
+                wfileName = AdjustSlashes(std::move(wfileName));
+                wfileName = AdjustBadUNC(std::move(wfileName), dllInstance, L"WritePrivateProfileSectionFixup");
 
                 Cohorts cohorts;
                 DetermineCohorts(wfileName, &cohorts, moredebug, dllInstance, L"WritePrivateProfileSectionFixup");
@@ -82,13 +82,13 @@ BOOL __stdcall WritePrivateProfileSectionFixup(
                     switch (cohorts.file_mfr.Request_MfrPathType)
                     {
                     case mfr::mfr_path_types::in_native_area:
-                        if (cohorts.map.Valid_mapping)
+                        if (cohorts.map->Valid_mapping)
                         {
-                            switch (cohorts.map.RedirectionFlags)
+                            switch (cohorts.map->RedirectionFlags)
                             {
                             case mfr::mfr_redirect_flags::prefer_redirection_local:
                                 // try the request path (which must be the local redirected version by definition), and then a package equivalent with COW if needed.
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     // no special acction, just write to redirected area
                                     WRAPPER_WRITEPRIVATEPROFILESECTION(cohorts.WsRedirected, debug);
@@ -114,7 +114,7 @@ BOOL __stdcall WritePrivateProfileSectionFixup(
                             case mfr::mfr_redirect_flags::prefer_redirection_containerized:
                             case mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs:
                                 // try the redirected path, then package (COW), then native (possibly via COW).
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_WRITEPRIVATEPROFILESECTION(cohorts.WsRedirected, debug);
                                 }
@@ -135,7 +135,7 @@ BOOL __stdcall WritePrivateProfileSectionFixup(
                                     // TODO: This might not be the best way to decide is COW is appropriate.  
                                     //       Possibly we should always do it, or possibly only if the equivalent VFS folder exists in the package.
                                     //       Setting attributes on an external file subject to traditional redirection seems an unlikely scenario that we need COW, but it might make an old app work.
-                                    if (cohorts.map.DoesRuntimeMapNativeToVFS)
+                                    if (cohorts.map->DoesRuntimeMapNativeToVFS)
                                     {
                                         if (Cow(cohorts.WsNative, cohorts.WsRedirected, dllInstance, L"WritePrivateProfileSectionFixup"))
                                         {
@@ -167,9 +167,9 @@ BOOL __stdcall WritePrivateProfileSectionFixup(
                         }
                         break;
                     case mfr::mfr_path_types::in_package_pvad_area:
-                        if (cohorts.map.Valid_mapping)
+                        if (cohorts.map->Valid_mapping)
                         {
-                            switch (cohorts.map.RedirectionFlags)
+                            switch (cohorts.map->RedirectionFlags)
                             {
                             case mfr::mfr_redirect_flags::prefer_redirection_local:
                                 // not possible, fall through
@@ -177,7 +177,7 @@ BOOL __stdcall WritePrivateProfileSectionFixup(
                             case mfr::mfr_redirect_flags::prefer_redirection_containerized:
                             case mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs:
                                 //// try the redirected path, then package with COW, then don't need native and create in redirected.
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_WRITEPRIVATEPROFILESECTION(cohorts.WsRedirected, debug);
                                 }
@@ -220,13 +220,13 @@ BOOL __stdcall WritePrivateProfileSectionFixup(
                         }
                         break;
                     case mfr::mfr_path_types::in_package_vfs_area:
-                        if (cohorts.map.Valid_mapping)
+                        if (cohorts.map->Valid_mapping)
                         {
-                            switch (cohorts.map.RedirectionFlags)
+                            switch (cohorts.map->RedirectionFlags)
                             {
                             case mfr::mfr_redirect_flags::prefer_redirection_local:
                                 // try the redirected path, then package path (COW), then create redirected
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_WRITEPRIVATEPROFILESECTION(cohorts.WsRedirected, debug);
                                 }
@@ -251,7 +251,7 @@ BOOL __stdcall WritePrivateProfileSectionFixup(
                             case mfr::mfr_redirect_flags::prefer_redirection_containerized:
                             case mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs:
                                 // try the redirected path, then package (COW), then native (COW), then just create new in redirected.
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_WRITEPRIVATEPROFILESECTION(cohorts.WsRedirected, debug);
                                 }
@@ -294,9 +294,9 @@ BOOL __stdcall WritePrivateProfileSectionFixup(
                         }
                         break;
                     case mfr::mfr_path_types::in_redirection_area_writablepackageroot:
-                        if (cohorts.map.Valid_mapping)
+                        if (cohorts.map->Valid_mapping)
                         {
-                            switch (cohorts.map.RedirectionFlags)
+                            switch (cohorts.map->RedirectionFlags)
                             {
                             case mfr::mfr_redirect_flags::prefer_redirection_local:
                                 // not possible
@@ -304,7 +304,7 @@ BOOL __stdcall WritePrivateProfileSectionFixup(
                             case mfr::mfr_redirect_flags::prefer_redirection_containerized:
                             case mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs:
                                 // try the redirected path, then package (COW), then possibly native (COW), then create new in redirected.
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_WRITEPRIVATEPROFILESECTION(cohorts.WsRedirected, debug);
                                 }
@@ -24,7 +24,7 @@
 
 #define WRAPPER_WRITEPRIVATEPROFILESTRUCT(theDestinationFilename, debug) \
     { \
-        std::wstring LongDestinationFilename = MakeLongPath(theDestinationFilename); \
+        long_path LongDestinationFilename(theDestinationFilename); \
         if constexpr (psf::is_ansi<CharT>) \
         { \
             retfinal = impl::WritePrivateProfileStructW(widen_argument(appName).c_str(), widen_argument(keyName).c_str(), structData, uSizeStruct, LongDestinationFilename.c_str()); \
@@ -73,8 +73,8 @@ BOOL __stdcall WritePrivateProfileStructFixup(
                 // This get is inheirently a read-only operation in all cases.
 // We prefer to use the redirecton case, if present.
                 std::wstring wfileName = widen(fileName);
-                wfileName = AdjustSlashes(wfileName);
-                wfileName = AdjustBadUNC(wfileName, dllInstance, L"WritePrivateProfileStructFixup");
+                wfileName = AdjustSlashes(std::move(wfileName));
+                wfileName = AdjustBadUNC(std::move(wfileName), dllInstance, L"WritePrivateProfileStructFixup");
 
                 Cohorts cohorts;
                 DetermineCohorts(wfileName, &cohorts, moredebug, dllInstance, L"WritePrivateProfileStructFixup");
@@ -84,13 +84,13 @@ BOOL __stdcall WritePrivateProfileStructFixup(
                     switch (cohorts.file_mfr.Request_MfrPathType)
                     {
                     case mfr::mfr_path_types::in_native_area:
-                        if (cohorts.map.Valid_mapping)
+                        if (cohorts.map->Valid_mapping)
                         {
-                            switch (cohorts.map.RedirectionFlags)
+                            switch (cohorts.map->RedirectionFlags)
                             {
                             case mfr::mfr_redirect_flags::prefer_redirection_local:
                                 // try the request path (which must be the local redirected version by definition), and then a package equivalent with COW if needed.
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     // no special acction, just write to redirected area
                                     WRAPPER_WRITEPRIVATEPROFILESTRUCT(cohorts.WsRedirected, debug);
@@ -116,7 +116,7 @@ BOOL __stdcall WritePrivateProfileStructFixup(
                             case mfr::mfr_redirect_flags::prefer_redirection_containerized:
                             case mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs:
                                 // try the redirected path, then package (COW), then native (possibly via COW).
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_WRITEPRIVATEPROFILESTRUCT(cohorts.WsRedirected, debug);
                                 }
@@ -137,7 +137,7 @@ BOOL __stdcall WritePrivateProfileStructFixup(
                                     // TODO: This might not be the best way to decide is COW is appropriate.  
                                     //       Possibly we should always do it, or possibly only if the equivalent VFS folder exists in the package.
                                     //       Setting attributes on an external file subject to traditional redirection seems an unlikely scenario that we need COW, but it might make an old app work.
-                                    if (cohorts.map.DoesRuntimeMapNativeToVFS)
+                                    if (cohorts.map->DoesRuntimeMapNativeToVFS)
                                     {
                                         if (Cow(cohorts.WsNative, cohorts.WsRedirected, dllInstance, L"WritePrivateProfileStructFixup"))
                                         {
@@ -169,9 +169,9 @@ BOOL __stdcall WritePrivateProfileStructFixup(
                         }
                         break;
                     case mfr::mfr_path_types::in_package_pvad_area:
-                        if (cohorts.map.Valid_mapping)
+                        if (cohorts.map->Valid_mapping)
                         {
-                            switch (cohorts.map.RedirectionFlags)
+                            switch (cohorts.map->RedirectionFlags)
                             {
                             case mfr::mfr_redirect_flags::prefer_redirection_local:
                                 // not possible, fall through
@@ -179,7 +179,7 @@ BOOL __stdcall WritePrivateProfileStructFixup(
                             case mfr::mfr_redirect_flags::prefer_redirection_containerized:
                             case mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs:
                                 //// try the redirected path, then package with COW, then don't need native and create in redirected.
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_WRITEPRIVATEPROFILESTRUCT(cohorts.WsRedirected, debug);
                                 }
@@ -222,13 +222,13 @@ BOOL __stdcall WritePrivateProfileStructFixup(
                         }
                         break;
                     case mfr::mfr_path_types::in_package_vfs_area:
-                        if (cohorts.map.Valid_mapping)
+                        if (cohorts.map->Valid_mapping)
                         {
-                            switch (cohorts.map.RedirectionFlags)
+                            switch (cohorts.map->RedirectionFlags)
                             {
                             case mfr::mfr_redirect_flags::prefer_redirection_local:
                                 // try the redirected path, then package path (COW), then create redirected
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_WRITEPRIVATEPROFILESTRUCT(cohorts.WsRedirected, debug);
                                 }
@@ -253,7 +253,7 @@ BOOL __stdcall WritePrivateProfileStructFixup(
                             case mfr::mfr_redirect_flags::prefer_redirection_containerized:
                             case mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs:
                                 // try the redirected path, then package (COW), then native (COW), then just create new in redirected.
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_WRITEPRIVATEPROFILESTRUCT(cohorts.WsRedirected, debug);
                                 }
@@ -296,9 +296,9 @@ BOOL __stdcall WritePrivateProfileStructFixup(
                         }
                         break;
                     case mfr::mfr_path_types::in_redirection_area_writablepackageroot:
-                        if (cohorts.map.Valid_mapping)
+                        if (cohorts.map->Valid_mapping)
                         {
-                            switch (cohorts.map.RedirectionFlags)
+                            switch (cohorts.map->RedirectionFlags)
                             {
                             case mfr::mfr_redirect_flags::prefer_redirection_local:
                                 // not possible
@@ -306,7 +306,7 @@ BOOL __stdcall WritePrivateProfileStructFixup(
                             case mfr::mfr_redirect_flags::prefer_redirection_containerized:
                             case mfr::mfr_redirect_flags::prefer_redirection_if_package_vfs:
                                 // try the redirected path, then package (COW), then possibly native (COW), then create new in redirected.
-                                if (!cohorts.map.IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
+                                if (!cohorts.map->IsAnExclusionToRedirect && PathExists(cohorts.WsRedirected.c_str()))
                                 {
                                     WRAPPER_WRITEPRIVATEPROFILESTRUCT(cohorts.WsRedirected, debug);
                                 }
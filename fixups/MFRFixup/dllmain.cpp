@@ -199,9 +199,12 @@ extern "C" {
         switch (ul_reason_for_call)
         {
         case DLL_PROCESS_ATTACH:
+        {
+            psf::timeline_span span("MFRFixup attach");
             InitializeMFRFixup();
             InitializeConfiguration();
             break;
+        }
         case DLL_THREAD_ATTACH:
         case DLL_THREAD_DETACH:
         case DLL_PROCESS_DETACH:
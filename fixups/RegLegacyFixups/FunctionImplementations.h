@@ -335,6 +335,9 @@ namespace winternl
         _Out_opt_ PVOID lpData,
         _In_opt_ _Out_opt_ LPDWORD lpcbData);
 
+    LSTATUS __stdcall RegCloseKey(
+        _In_ HKEY key);
+
 #endif
 
 }
@@ -428,6 +431,13 @@ namespace impl
 
     inline auto KernelBaseRegQueryValueExA = KERNELBASEINTERNL_FUNCTION(winternl::RegQueryValueExA);
     inline auto KernelBaseRegQueryValueExW = KERNELBASEINTERNL_FUNCTION(winternl::RegQueryValueExW);
+
+    inline auto KernelBaseRegCloseKey = KERNELBASEINTERNL_FUNCTION(winternl::RegCloseKey);
+#else
+    inline auto RegEnumKeyExA = &::RegEnumKeyExA;
+    inline auto RegEnumKeyExW = &::RegEnumKeyExW;
+
+    inline auto RegCloseKey = &::RegCloseKey;
 #endif
 
 }
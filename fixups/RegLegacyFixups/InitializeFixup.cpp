@@ -20,6 +20,7 @@ using namespace std::literals;
 
 #include "FunctionImplementations.h"
 #include "Reg_Remediation_spec.h"
+#include "RegRemediation.h"
 
 
 std::vector<Reg_Remediation_Spec>  g_regRemediationSpecs;
@@ -37,6 +38,8 @@ void InitializeFixups()
 
 void InitializeConfiguration()
 {
+    SetLogLevels(::PSFQueryCurrentDllLogLevel());
+
 #if _DEBUG
     Log(L"RegLegacyFixups Start InitializeConfiguration()\n");
 #endif
@@ -118,7 +121,7 @@ void InitializeConfiguration()
 #if _DEBUG
                                     Log(L"RegLegacyFixups:      Pattern: %Ls\n", patternString.data());
 #endif
-                                    recordItem.modifyKeyAccess.patterns.push_back(patternString.data());
+                                    recordItem.modifyKeyAccess.patterns.push_back(CompileRegPattern(patternString));
 
                                 }
                             }
@@ -204,7 +207,7 @@ void InitializeConfiguration()
 #if _DEBUG
                                     Log(L"RegLegacyFixups:      Pattern: %Ls\n", patternString.data());
 #endif
-                                    recordItem.fakeDeleteKey.patterns.push_back(patternString.data());
+                                    recordItem.fakeDeleteKey.patterns.push_back(CompileRegPattern(patternString));
                                 }
                             }
                             catch (...)
@@ -260,9 +263,9 @@ void InitializeConfiguration()
 
                             try
                             {
-                                recordItem.deletionMarker.key = regItemObject.try_get("key")->as_string().wstring();
+                                recordItem.deletionMarker.key = CompileRegPattern(regItemObject.try_get("key")->as_string().wstring());
 #if _DEBUG
-                                Log(L"RegLegacyFixups:      Key: %Ls\n", recordItem.deletionMarker.key.data());
+                                Log(L"RegLegacyFixups:      Key: %Ls\n", recordItem.deletionMarker.key.text.c_str());
 #endif
                             }
                             catch (...)
@@ -278,7 +281,7 @@ void InitializeConfiguration()
 #if _DEBUG
                                     Log(L"RegLegacyFixups:      Pattern: %Ls\n", patternString.data());
 #endif
-                                    recordItem.deletionMarker.patterns.push_back(patternString.data());
+                                    recordItem.deletionMarker.patterns.push_back(CompileRegPattern(recordItem.deletionMarker.key.text + L".*" + std::wstring(patternString)));
                                 }  
                             }
                             catch (...)
@@ -340,6 +343,7 @@ void InitializeConfiguration()
             Log(L"RegLegacyFixups: Fixup not found in json config.\n");
 #endif
         }
+        PrepareRegRemediation();
 #if _DEBUG
         Log(L"RegLegacyFixups End InitializeConfiguration()\n");
 #endif
@@ -0,0 +1,230 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) Tim Mangan. All rights reserved
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+
+#include <psf_framework.h>
+#include <psf_logging.h>
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "FunctionImplementations.h"
+#include "Framework.h"
+#include "Reg_Remediation_Spec.h"
+#include "RegRemediation.h"
+#include "KeyEnumeration.h"
+
+
+namespace
+{
+    struct enumeration_index
+    {
+        std::vector<DWORD> visible;     // The real index of each item the app may see, in enumeration order
+        DWORD next = 0;                 // The first real index not checked yet
+        bool complete = false;
+    };
+
+    struct key_enumeration
+    {
+        std::mutex mutex;
+        std::string keyPath;
+        LONGLONG lastWriteTime = 0;
+        ULONG subKeyCount = 0;
+        ULONG valueCount = 0;
+        enumeration_index subKeys;
+        enumeration_index values;
+    };
+
+    std::mutex g_enumerationsMutex;
+    std::unordered_map<HKEY, std::shared_ptr<key_enumeration>> g_enumerations;
+
+    // Adding or removing a subkey or value changes the last write time of the key, as well as the count
+    bool QueryKeyStamp(HKEY key, LONGLONG& lastWriteTime, ULONG& subKeyCount, ULONG& valueCount)
+    {
+        winternl::KEY_CACHED_INFORMATION info;
+        ULONG size = 0;
+        if (!NT_SUCCESS(impl::NtQueryKey(key, winternl::KeyCachedInformation, &info, sizeof(info), &size)))
+        {
+            return false;
+        }
+        lastWriteTime = info.LastWriteTime.QuadPart;
+        subKeyCount = info.SubKeys;
+        valueCount = info.Values;
+        return true;
+    }
+
+    LSTATUS EnumSubKey(HKEY key, DWORD index, wchar_t* name, DWORD* nameLength)
+    {
+#ifdef INTERCEPT_KERNELBASE
+        return impl::KernelBaseRegEnumKeyExW(key, index, name, nameLength, nullptr, nullptr, nullptr, nullptr);
+#else
+        return impl::RegEnumKeyExW(key, index, name, nameLength, nullptr, nullptr, nullptr, nullptr);
+#endif
+    }
+
+    LSTATUS EnumValue(HKEY key, DWORD index, wchar_t* name, DWORD* nameLength)
+    {
+#ifdef INTERCEPT_KERNELBASE
+        return impl::KernelBaseRegEnumValueW(key, index, name, nameLength, nullptr, nullptr, nullptr, nullptr);
+#else
+        // RegEnumValue is not intercepted in this build
+        return ::RegEnumValueW(key, index, name, nameLength, nullptr, nullptr, nullptr, nullptr);
+#endif
+    }
+
+    // Returns the state for the key, started over if the key is not the one it was built for or has changed since
+    std::shared_ptr<key_enumeration> AcquireKeyEnumeration(HKEY key, const std::string& keyPath, std::unique_lock<std::mutex>& lock, [[maybe_unused]] DWORD RegLocalInstance)
+    {
+        LONGLONG lastWriteTime;
+        ULONG subKeyCount;
+        ULONG valueCount;
+        if (!QueryKeyStamp(key, lastWriteTime, subKeyCount, valueCount))
+        {
+            return nullptr;
+        }
+
+        std::shared_ptr<key_enumeration> state;
+        {
+            std::lock_guard mapLock(g_enumerationsMutex);
+            auto& entry = g_enumerations[key];
+            if (!entry)
+            {
+                entry = std::make_shared<key_enumeration>();
+            }
+            state = entry;
+        }
+
+        lock = std::unique_lock(state->mutex);
+        if ((state->keyPath != keyPath) || (state->lastWriteTime != lastWriteTime) ||
+            (state->subKeyCount != subKeyCount) || (state->valueCount != valueCount))
+        {
+#if _DEBUG
+            if (!state->keyPath.empty())
+            {
+                Log(L"[%d] Key changed, enumeration index started over", RegLocalInstance);
+            }
+#endif
+            state->keyPath = keyPath;
+            state->lastWriteTime = lastWriteTime;
+            state->subKeyCount = subKeyCount;
+            state->valueCount = valueCount;
+            state->subKeys = enumeration_index{};
+            state->values = enumeration_index{};
+        }
+        return state;
+    }
+
+    // Checks items until the one the app asked for is known, or there are no more
+    template <typename EnumFunc, typename HiddenFunc>
+    LSTATUS MapIndex(enumeration_index& items, DWORD index, DWORD& realIndex, DWORD maxNameLength, EnumFunc&& enumItem, HiddenFunc&& isHidden)
+    {
+        if ((index >= items.visible.size()) && !items.complete)
+        {
+            std::wstring name(maxNameLength + 1, L'\0');
+            while ((index >= items.visible.size()) && !items.complete)
+            {
+                DWORD nameLength = static_cast<DWORD>(name.size());
+                auto result = enumItem(items.next, name.data(), &nameLength);
+                if (result == ERROR_NO_MORE_ITEMS)
+                {
+                    items.complete = true;
+                    break;
+                }
+                else if (result != ERROR_SUCCESS)
+                {
+                    return result;
+                }
+
+                if (!isHidden(narrow(std::wstring_view(name.data(), nameLength))))
+                {
+                    items.visible.push_back(items.next);
+                }
+                ++items.next;
+            }
+        }
+
+        if (index < items.visible.size())
+        {
+            realIndex = items.visible[index];
+            return ERROR_SUCCESS;
+        }
+        return ERROR_NO_MORE_ITEMS;
+    }
+}
+
+LSTATUS MapSubKeyIndex(HKEY key, const std::string& keyPath, DWORD index, DWORD& realIndex, DWORD RegLocalInstance)
+{
+    if (!HasSubKeyRemediation())
+    {
+        realIndex = index;
+        return ERROR_SUCCESS;
+    }
+
+    // The state is declared first so that the lock on its mutex is released before ForgetKeyEnumeration, called from
+    // RegCloseKey on another thread, can have dropped the last reference to it
+    std::shared_ptr<key_enumeration> state;
+    std::unique_lock<std::mutex> lock;
+    state = AcquireKeyEnumeration(key, keyPath, lock, RegLocalInstance);
+    if (!state)
+    {
+        return ERROR_NOT_SUPPORTED;
+    }
+
+    // Key names are limited to 255 characters
+    return MapIndex(state->subKeys, index, realIndex, 255,
+        [&](DWORD at, wchar_t* buffer, DWORD* length) { return EnumSubKey(key, at, buffer, length); },
+        [&](const std::string& subKey)
+        {
+            bool hidden = (RegFixupDeletionMarker(keyPath, subKey, RegLocalInstance) != ERROR_SUCCESS) ||
+                IsBlockedJavaKey(keyPath + "\\" + subKey);
+#if _DEBUG
+            if (hidden)
+            {
+                Log("[%d] RegEnumKeyEx:  hiding subkey %s", RegLocalInstance, subKey.c_str());
+            }
+#endif
+            return hidden;
+        });
+}
+
+LSTATUS MapValueIndex(HKEY key, const std::string& keyPath, DWORD index, DWORD& realIndex, DWORD RegLocalInstance)
+{
+    if (!HasDeletionMarker())
+    {
+        realIndex = index;
+        return ERROR_SUCCESS;
+    }
+
+    // As in MapSubKeyIndex, the state has to outlive the lock
+    std::shared_ptr<key_enumeration> state;
+    std::unique_lock<std::mutex> lock;
+    state = AcquireKeyEnumeration(key, keyPath, lock, RegLocalInstance);
+    if (!state)
+    {
+        return ERROR_NOT_SUPPORTED;
+    }
+
+    // Value names are limited to 16383 characters
+    return MapIndex(state->values, index, realIndex, 16383,
+        [&](DWORD at, wchar_t* buffer, DWORD* length) { return EnumValue(key, at, buffer, length); },
+        [&](const std::string& value)
+        {
+            bool hidden = RegFixupDeletionMarker(keyPath, value, RegLocalInstance) != ERROR_SUCCESS;
+#if _DEBUG
+            if (hidden)
+            {
+                Log("[%d] RegEnumValue:  hiding value %s", RegLocalInstance, value.c_str());
+            }
+#endif
+            return hidden;
+        });
+}
+
+void ForgetKeyEnumeration(HKEY key)
+{
+    std::lock_guard lock(g_enumerationsMutex);
+    g_enumerations.erase(key);
+}
@@ -0,0 +1,24 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) Tim Mangan. All rights reserved
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+
+// Lets RegEnumKeyEx and RegEnumValue hide the subkeys and values that a DeletionMarker (or, for subkeys, a JavaBlocker)
+// applies to without disturbing the indexes that the app enumerates with. For each key handle we remember, in order,
+// the real index of every subkey and value the app may see, so a later call maps the app's index straight onto the real
+// one instead of re-reading and re-checking the items before it. The lists are only filled in as far as the app has
+// asked, are started over if the key changes, and are dropped when the handle is closed.
+
+#pragma once
+
+#include <string>
+#include <windows.h>
+
+// Return ERROR_SUCCESS with the real index of the subkey or value that the app asked for, or ERROR_NO_MORE_ITEMS if the
+// app has seen them all. Any other result means the key could not be indexed, and the caller has to check the items
+// itself.
+LSTATUS MapSubKeyIndex(HKEY key, const std::string& keyPath, DWORD index, DWORD& realIndex, DWORD RegLocalInstance);
+LSTATUS MapValueIndex(HKEY key, const std::string& keyPath, DWORD index, DWORD& realIndex, DWORD RegLocalInstance);
+
+// Called before a key handle is closed
+void ForgetKeyEnumeration(HKEY key);
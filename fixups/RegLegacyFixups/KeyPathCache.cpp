@@ -0,0 +1,115 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) Tim Mangan. All rights reserved
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+
+#include <psf_framework.h>
+#include <psf_logging.h>
+
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+#include "KeyPathCache.h"
+
+
+namespace
+{
+    struct key_path_entry
+    {
+        std::uint64_t generation;
+        bool known;
+        std::string path;
+    };
+
+    // Registry calls come from many threads at once, so the handles are spread over several independently locked maps;
+    // lookups, which are by far the most common operation, only take a shared lock.
+    constexpr std::size_t ShardCount = 16;
+
+    struct key_path_shard
+    {
+        std::shared_mutex mutex;
+        std::unordered_map<HKEY, key_path_entry> entries;
+    };
+
+    key_path_shard g_keyPathShards[ShardCount];
+    std::atomic<std::uint64_t> g_keyPathGeneration{ 0 };
+
+    // Logged at unload in every build; relaxed, since the counts are not ordered with anything else
+    std::atomic<std::uint64_t> g_keyPathHits{ 0 };
+    std::atomic<std::uint64_t> g_keyPathMisses{ 0 };
+    std::atomic<std::uint64_t> g_keyPathUntracked{ 0 };
+
+    key_path_shard& ShardFor(HKEY key) noexcept
+    {
+        // Handle values are multiples of 4
+        return g_keyPathShards[(reinterpret_cast<std::uintptr_t>(key) >> 2) % ShardCount];
+    }
+}
+
+void TrackKeyPath(HKEY key)
+{
+    if (key == nullptr)
+    {
+        return;
+    }
+    auto& shard = ShardFor(key);
+    std::unique_lock lock(shard.mutex);
+    shard.entries[key] = key_path_entry{ ++g_keyPathGeneration, false, std::string() };
+}
+
+void ForgetKeyPath(HKEY key)
+{
+    auto& shard = ShardFor(key);
+    std::unique_lock lock(shard.mutex);
+    shard.entries.erase(key);
+}
+
+bool LookupKeyPath(HKEY key, std::string& path, std::uint64_t& generation)
+{
+    generation = 0;
+    auto& shard = ShardFor(key);
+    std::shared_lock lock(shard.mutex);
+    auto entry = shard.entries.find(key);
+    if (entry == shard.entries.end())
+    {
+        g_keyPathUntracked.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (!entry->second.known)
+    {
+        g_keyPathMisses.fetch_add(1, std::memory_order_relaxed);
+        generation = entry->second.generation;
+        return false;
+    }
+    g_keyPathHits.fetch_add(1, std::memory_order_relaxed);
+    path = entry->second.path;
+    return true;
+}
+
+void StoreKeyPath(HKEY key, std::uint64_t generation, const std::string& path)
+{
+    if (generation == 0)
+    {
+        return;
+    }
+    auto& shard = ShardFor(key);
+    std::unique_lock lock(shard.mutex);
+    auto entry = shard.entries.find(key);
+    if ((entry != shard.entries.end()) && (entry->second.generation == generation))
+    {
+        entry->second.path = path;
+        entry->second.known = true;
+    }
+}
+
+void LogKeyPathCacheStats()
+{
+    auto hits = g_keyPathHits.load(std::memory_order_relaxed);
+    auto misses = g_keyPathMisses.load(std::memory_order_relaxed);
+    auto untracked = g_keyPathUntracked.load(std::memory_order_relaxed);
+    auto total = hits + misses + untracked;
+    Log(L"RegLegacyFixups: key path cache %llu hits, %llu misses, %llu untracked handles (%.1f%% hit ratio)\n",
+        hits, misses, untracked, (total > 0) ? (100.0 * static_cast<double>(hits) / static_cast<double>(total)) : 0.0);
+}
@@ -0,0 +1,33 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) Tim Mangan. All rights reserved
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+
+// Remembers the path that InterpretKeyPath works out for a registry key handle, so that the intercepts do not have to
+// ask the kernel for the name of the key on every call made with it.
+//
+// Only handles returned by our RegOpenKey*/RegCreateKey* fixups are cached, and the RegCloseKey fixup drops them before
+// the handle is closed. Every tracked handle carries a generation, so a path that was looked up for a handle that has
+// since been closed (and whose value may have been handed out again) is never stored against the new key.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <windows.h>
+
+// Called with each key handle that a fixup returns to the app
+void TrackKeyPath(HKEY key);
+
+// Called before a key handle is closed
+void ForgetKeyPath(HKEY key);
+
+// Returns true with the cached path. Otherwise generation is set for a later StoreKeyPath call, or to 0 if the handle is
+// not one that may be cached.
+bool LookupKeyPath(HKEY key, std::string& path, std::uint64_t& generation);
+
+// Caches the path of a tracked handle, unless it was closed (or re-tracked) since the LookupKeyPath call
+void StoreKeyPath(HKEY key, std::uint64_t generation, const std::string& path);
+
+// Logs how many lookups were answered from the cache, missed, or were made with a handle that is not tracked
+void LogKeyPathCacheStats();
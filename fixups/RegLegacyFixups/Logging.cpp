@@ -13,6 +13,7 @@
 ///#include "Reg_Remediation_Spec.h"
 
 #include "Logging.h"
+#include "KeyPathCache.h"
 
 
 static trace_level configured_trace_level(function_type)
@@ -260,25 +261,50 @@ void LogKeyPath(HKEY key, const wchar_t* msg )
 }
 
 
+// Asks the kernel for the name of the key. Most names fit in the buffer on the stack, so this is usually a single call
+// with no allocation; a longer name is read again into a buffer of the size that was reported.
+static NTSTATUS QueryKeyName(HKEY key, const char* msg, std::string& name, bool& retried)
+{
+    constexpr ULONG StackBufferSize = 512;
+    alignas(winternl::KEY_NAME_INFORMATION) std::uint8_t stackBuffer[StackBufferSize + 2];
+    std::unique_ptr<std::uint8_t[]> heapBuffer;
+    auto buffer = stackBuffer;
+
+    ULONG size = 0;
+    retried = false;
+    auto status = impl::NtQueryKey(key, winternl::KeyNameInformation, buffer, StackBufferSize, &size);
+    if ((status == STATUS_BUFFER_TOO_SMALL) || (status == STATUS_BUFFER_OVERFLOW))
+    {
+        retried = true;
+        heapBuffer = std::make_unique<std::uint8_t[]>(size + 2);
+        buffer = heapBuffer.get();
+        status = impl::NtQueryKey(key, winternl::KeyNameInformation, buffer, size, &size);
+    }
+    if (NT_SUCCESS(status))
+    {
+        buffer[size] = 0x0;
+        buffer[size + 1] = 0x0;  // Add string termination character
+        auto info = reinterpret_cast<winternl::PKEY_NAME_INFORMATION>(buffer);
+        name = InterpretCountedString(msg, info->Name, info->NameLength / 2);
+    }
+    return status;
+}
+
 std::string InterpretKeyPath(HKEY key, const char* msg)
 {
     std::string sret = "";
-    ULONG size;
     try
     {
-        auto status = impl::NtQueryKey(key, winternl::KeyNameInformation, nullptr, 0, &size);
-        if ((status == STATUS_BUFFER_TOO_SMALL) || (status == STATUS_BUFFER_OVERFLOW))
+        bool retried;
+        auto status = QueryKeyName(key, msg, sret, retried);
+        if (NT_SUCCESS(status))
         {
-            auto buffer = std::make_unique<std::uint8_t[]>(size + 2);
-            if (NT_SUCCESS(impl::NtQueryKey(key, winternl::KeyNameInformation, buffer.get(), size, &size)))
-            {
-                buffer[size] = 0x0;
-                buffer[size + 1] = 0x0;  // Add string termination character
-                auto info = reinterpret_cast<winternl::PKEY_NAME_INFORMATION>(buffer.get());
-                sret = InterpretCountedString(msg, info->Name, info->NameLength / 2);
-            }
-            else
-                sret = "InterpretKeyPath failure2a";
+            return sret;
+        }
+
+        if (retried)
+        {
+            sret = "InterpretKeyPath failure2a";
         }
         else if (status == STATUS_INVALID_HANDLE)
         {
@@ -301,35 +327,38 @@ std::string InterpretKeyPath(HKEY key, const char* msg)
 
 std::string InterpretKeyPath(HKEY key)
 {
+    // The predefined keys are not kernel handles, so there is nothing to ask the kernel about
+    if (key == HKEY_LOCAL_MACHINE)
+        return InterpretStringA("HKEY_LOCAL_MACHINE");
+    else if (key == HKEY_CURRENT_USER)
+        return InterpretStringA("HKEY_CURRENT_USER");
+    else if (key == HKEY_CLASSES_ROOT)
+        return InterpretStringA("HKEY_CLASSES_ROOT");
+
     std::string sret = "";
-    ULONG size;
+    std::uint64_t generation = 0;
+    bool found = false;
     try
     {
-        auto status = impl::NtQueryKey(key, winternl::KeyNameInformation, nullptr, 0, &size);
-        if ((status == STATUS_BUFFER_TOO_SMALL) || (status == STATUS_BUFFER_OVERFLOW))
+        if (LookupKeyPath(key, sret, generation))
         {
-            auto buffer = std::make_unique<std::uint8_t[]>(size + 2);
-            if (NT_SUCCESS(impl::NtQueryKey(key, winternl::KeyNameInformation, buffer.get(), size, &size)))
-            {
-                buffer[size] = 0x0;
-                buffer[size + 1] = 0x0;  // Add string termination character
-                auto info = reinterpret_cast<winternl::PKEY_NAME_INFORMATION>(buffer.get());
-                sret = InterpretCountedString("", info->Name, info->NameLength / 2);
-            }
-            else
-                sret = "InterpretKeyPath failure2b";
+            return sret;
+        }
+
+        bool retried;
+        auto status = QueryKeyName(key, "", sret, retried);
+        if (NT_SUCCESS(status))
+        {
+            found = true;
+        }
+        else if (retried)
+        {
+            sret = "InterpretKeyPath failure2b";
         }
         else if (status == STATUS_INVALID_HANDLE)
         {
-            if (key == HKEY_LOCAL_MACHINE)
-                sret = InterpretStringA("HKEY_LOCAL_MACHINE");
-            else if (key == HKEY_CURRENT_USER)
-                sret = InterpretStringA("HKEY_CURRENT_USER");
-            else if (key == HKEY_CLASSES_ROOT)
-                sret = InterpretStringA("HKEY_CLASSES_ROOT");
 #if _DEBUG
-            else
-                Log(L"InterpretKeyPath failure2c.");
+            Log(L"InterpretKeyPath failure2c.");
 #endif
         }
         else
@@ -349,6 +378,16 @@ std::string InterpretKeyPath(HKEY key)
         sret = "HKEY_LOCAL_MACHINE" + sret.substr(10);
     }
 
+    if (found)
+    {
+        try
+        {
+            StoreKeyPath(key, generation, sret);
+        }
+        catch (...)
+        {
+        }
+    }
     return sret;
 }
 
@@ -91,6 +91,9 @@ struct result_configuration
 
 extern DWORD g_RegIntceptInstance;
 
+// The registry calls that RegLegacyFixups intercepts
+inline psf::log_category g_logRegistry{ "registry" };
+
 std::wstring InterpretStringW(const char* value);
 std::wstring InterpretStringW(const wchar_t* value);
 
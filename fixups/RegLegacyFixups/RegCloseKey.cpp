@@ -0,0 +1,37 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) Tim Mangan. All rights reserved
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+
+// RegCloseKey is only intercepted so that what is cached for the key (see KeyPathCache.h and KeyEnumeration.h) is
+// dropped before the handle value can be reused for another key.
+
+#include <psf_framework.h>
+#include <psf_logging.h>
+
+#include "FunctionImplementations.h"
+#include "KeyEnumeration.h"
+#include "KeyPathCache.h"
+
+
+#ifdef INTERCEPT_KERNELBASE
+
+LSTATUS __stdcall RegCloseKeyFixup(_In_ HKEY key)
+{
+    ForgetKeyPath(key);
+    ForgetKeyEnumeration(key);
+    return impl::KernelBaseRegCloseKey(key);
+}
+DECLARE_FIXUP(impl::KernelBaseRegCloseKey, RegCloseKeyFixup);
+
+#else
+
+LSTATUS __stdcall RegCloseKeyFixup(_In_ HKEY key)
+{
+    ForgetKeyPath(key);
+    ForgetKeyEnumeration(key);
+    return impl::RegCloseKey(key);
+}
+DECLARE_FIXUP(impl::RegCloseKey, RegCloseKeyFixup);
+
+#endif
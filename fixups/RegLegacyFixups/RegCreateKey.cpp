@@ -15,6 +15,7 @@
 #include "Logging.h"
 #include <regex>
 #include "RegRemediation.h"
+#include "KeyPathCache.h"
 
 
 
@@ -229,6 +230,10 @@ LSTATUS __stdcall RegCreateKeyFixup(
 
     }
 
+    if (result == ERROR_SUCCESS)
+    {
+        TrackKeyPath(*resultKey);
+    }
     return result;
 }
 DECLARE_STRING_FIXUP(RegCreateKeyImpl, RegCreateKeyFixup);
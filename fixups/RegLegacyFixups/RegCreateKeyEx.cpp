@@ -15,6 +15,7 @@
 #include "Logging.h"
 #include <regex>
 #include "RegRemediation.h"
+#include "KeyPathCache.h"
 
 
 #ifdef INTERCEPT_KERNELBASE
@@ -266,6 +267,10 @@ LSTATUS __stdcall RegCreateKeyExGeneric(
 
     }
 
+    if (result == ERROR_SUCCESS)
+    {
+        TrackKeyPath(*resultKey);
+    }
     return result;
 }
 
@@ -537,6 +542,10 @@ LSTATUS __stdcall RegCreateKeyExFixup(
 
     }
 
+    if (result == ERROR_SUCCESS)
+    {
+        TrackKeyPath(*resultKey);
+    }
     return result;
 }
 DECLARE_STRING_FIXUP(RegCreateKeyExImpl, RegCreateKeyExFixup);
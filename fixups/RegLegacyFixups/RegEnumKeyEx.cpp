@@ -14,6 +14,7 @@
 #include "Logging.h"
 #include <regex>
 #include "RegRemediation.h"
+#include "KeyEnumeration.h"
 
 #ifdef INTERCEPT_KERNELBASE
 LSTATUS __stdcall RegEnumKeyExAFixup(
@@ -39,6 +40,20 @@ LSTATUS __stdcall RegEnumKeyExAFixup(
 
     bool stillWorking = true;
     DWORD onIndex = dwIndex;
+    switch (MapSubKeyIndex(key, keyonlypath, dwIndex, onIndex, RegLocalInstance))
+    {
+    case ERROR_SUCCESS:
+        result = impl::KernelBaseRegEnumKeyExA(key, onIndex, lpName, lpcchName, lpReserved, lpClass, lpcchClass, lpftLastWriteTime);
+        stillWorking = false;
+        break;
+    case ERROR_NO_MORE_ITEMS:
+        result = ERROR_NO_MORE_ITEMS;
+        stillWorking = false;
+        break;
+    default:
+        // The key could not be indexed, so check the subkeys one at a time
+        break;
+    }
     while (stillWorking)
     {
         result = impl::KernelBaseRegEnumKeyExA(key, onIndex, lpName, lpcchName, lpReserved, lpClass, lpcchClass, lpftLastWriteTime);
@@ -46,6 +61,10 @@ LSTATUS __stdcall RegEnumKeyExAFixup(
         {
             std::string sskey = narrow(lpName);
             result = RegFixupDeletionMarker(keyonlypath, sskey, RegLocalInstance);
+            if ((result == ERROR_SUCCESS) && IsBlockedJavaKey(keyonlypath + "\\" + sskey))
+            {
+                result = ERROR_PATH_NOT_FOUND;
+            }
             if (result == ERROR_SUCCESS)
             {
 #if MOREDEBUG
@@ -55,9 +74,9 @@ LSTATUS __stdcall RegEnumKeyExAFixup(
             }
             else
             {
-                // We have a deletion marker on this particular item, so we need to skip it.
-                // When we return this value, a subsequent call by the app might ask for this new index, but we can probably assume it's OK to return it twice
-                // because we do not have a way to remember this, like done in FindFirstFile.
+                // We have a deletion marker or java blocker on this particular item, so we need to skip it.
+                // Only reached when the key could not be indexed (see KeyEnumeration.h), in which case a subsequent call
+                // by the app might ask for this new index, but we can probably assume it's OK to return it twice.
 #if _DEBUG
                 Log(L"[%d] RegEnumKeyEx:  DeletionMarker Blocking lpName=%S, try again.", RegLocalInstance, lpName);
 #endif                
@@ -128,6 +147,20 @@ LSTATUS __stdcall RegEnumKeyExWFixup(
 
     bool stillWorking = true;
     DWORD onIndex = dwIndex;
+    switch (MapSubKeyIndex(key, keyonlypath, dwIndex, onIndex, RegLocalInstance))
+    {
+    case ERROR_SUCCESS:
+        result = impl::KernelBaseRegEnumKeyExW(key, onIndex, lpName, lpcchName, lpReserved, lpClass, lpcchClass, lpftLastWriteTime);
+        stillWorking = false;
+        break;
+    case ERROR_NO_MORE_ITEMS:
+        result = ERROR_NO_MORE_ITEMS;
+        stillWorking = false;
+        break;
+    default:
+        // The key could not be indexed, so check the subkeys one at a time
+        break;
+    }
     while (stillWorking)
     {
         result = impl::KernelBaseRegEnumKeyExW(key, onIndex, lpName, lpcchName, lpReserved, lpClass, lpcchClass, lpftLastWriteTime);
@@ -135,6 +168,10 @@ LSTATUS __stdcall RegEnumKeyExWFixup(
         {
             std::string sskey = narrow(lpName);
             result = RegFixupDeletionMarker(keyonlypath, sskey, RegLocalInstance);
+            if ((result == ERROR_SUCCESS) && IsBlockedJavaKey(keyonlypath + "\\" + sskey))
+            {
+                result = ERROR_PATH_NOT_FOUND;
+            }
             if (result == ERROR_SUCCESS)
             {
 #if MOREDEBUG
@@ -144,9 +181,9 @@ LSTATUS __stdcall RegEnumKeyExWFixup(
             }
             else
             {
-                // We have a deletion marker on this particular item, so we need to skip it.
-                // When we return this value, a subsequent call by the app might ask for this new index, but we can probably assume it's OK to return it twice
-                // because we do not have a way to remember this, like done in FindFirstFile.
+                // We have a deletion marker or java blocker on this particular item, so we need to skip it.
+                // Only reached when the key could not be indexed (see KeyEnumeration.h), in which case a subsequent call
+                // by the app might ask for this new index, but we can probably assume it's OK to return it twice.
 #if _DEBUG
                 Log(L"[%d] RegEnumKeyEx:  DeletionMarker Blocking lpName=%S, try again.", RegLocalInstance, lpName);
 #endif                
@@ -196,12 +233,6 @@ DECLARE_FIXUP(impl::KernelBaseRegEnumKeyExW, RegEnumKeyExWFixup);
 
 
 #else
-namespace impl
-{
-    inline auto RegEnumKeyExA = &::RegEnumKeyExA;
-    inline auto RegEnumKeyExW = &::RegEnumKeyExW;
-}
-
 //auto RegEnumKeyExImpl = psf::detoured_string_function(&::RegEnumKeyExA, &::RegEnumKeyExW);
 //template <typename CharT>
 LSTATUS __stdcall RegEnumKeyExAFixup(
@@ -227,13 +258,31 @@ LSTATUS __stdcall RegEnumKeyExAFixup(
 
     bool stillWorking = true;
     DWORD onIndex = dwIndex;
-    while(stillWorking)
+    switch (MapSubKeyIndex(key, keyonlypath, dwIndex, onIndex, RegLocalInstance))
+    {
+    case ERROR_SUCCESS:
+        result = impl::RegEnumKeyExA(key, onIndex, lpName, lpcchName, lpReserved, lpClass, lpcchClass, lpftLastWriteTime);
+        stillWorking = false;
+        break;
+    case ERROR_NO_MORE_ITEMS:
+        result = ERROR_NO_MORE_ITEMS;
+        stillWorking = false;
+        break;
+    default:
+        // The key could not be indexed, so check the subkeys one at a time
+        break;
+    }
+    while (stillWorking)
     {
         result = impl::RegEnumKeyExA(key, onIndex, lpName, lpcchName, lpReserved, lpClass, lpcchClass, lpftLastWriteTime);
         if (result == ERROR_SUCCESS)
         {
             std::string sskey = narrow(lpName);
             result = RegFixupDeletionMarker(keyonlypath, sskey, RegLocalInstance);
+            if ((result == ERROR_SUCCESS) && IsBlockedJavaKey(keyonlypath + "\\" + sskey))
+            {
+                result = ERROR_PATH_NOT_FOUND;
+            }
             if (result == ERROR_SUCCESS)
             {
 #if MOREDEBUG
@@ -243,9 +292,9 @@ LSTATUS __stdcall RegEnumKeyExAFixup(
             }
             else
             {
-                // We have a deletion marker on this particular item, so we need to skip it.
-                // When we return this value, a subsequent call by the app might ask for this new index, but we can probably assume it's OK to return it twice
-                // because we do not have a way to remember this, like done in FindFirstFile.
+                // We have a deletion marker or java blocker on this particular item, so we need to skip it.
+                // Only reached when the key could not be indexed (see KeyEnumeration.h), in which case a subsequent call
+                // by the app might ask for this new index, but we can probably assume it's OK to return it twice.
 #if _DEBUG
                 Log(L"[%d] RegEnumKeyEx:  DeletionMarker Blocking lpName=%S, try again.", RegLocalInstance, lpName);
 #endif                
@@ -316,6 +365,20 @@ LSTATUS __stdcall RegEnumKeyExWFixup(
 
     bool stillWorking = true;
     DWORD onIndex = dwIndex;
+    switch (MapSubKeyIndex(key, keyonlypath, dwIndex, onIndex, RegLocalInstance))
+    {
+    case ERROR_SUCCESS:
+        result = impl::RegEnumKeyExW(key, onIndex, lpName, lpcchName, lpReserved, lpClass, lpcchClass, lpftLastWriteTime);
+        stillWorking = false;
+        break;
+    case ERROR_NO_MORE_ITEMS:
+        result = ERROR_NO_MORE_ITEMS;
+        stillWorking = false;
+        break;
+    default:
+        // The key could not be indexed, so check the subkeys one at a time
+        break;
+    }
     while (stillWorking)
     {
         result = impl::RegEnumKeyExW(key, onIndex, lpName, lpcchName, lpReserved, lpClass, lpcchClass, lpftLastWriteTime);
@@ -323,6 +386,10 @@ LSTATUS __stdcall RegEnumKeyExWFixup(
         {
             std::string sskey = narrow(lpName);
             result = RegFixupDeletionMarker(keyonlypath, sskey, RegLocalInstance);
+            if ((result == ERROR_SUCCESS) && IsBlockedJavaKey(keyonlypath + "\\" + sskey))
+            {
+                result = ERROR_PATH_NOT_FOUND;
+            }
             if (result == ERROR_SUCCESS)
             {
 #if MOREDEBUG
@@ -332,9 +399,9 @@ LSTATUS __stdcall RegEnumKeyExWFixup(
             }
             else
             {
-                // We have a deletion marker on this particular item, so we need to skip it.
-                // When we return this value, a subsequent call by the app might ask for this new index, but we can probably assume it's OK to return it twice
-                // because we do not have a way to remember this, like done in FindFirstFile.
+                // We have a deletion marker or java blocker on this particular item, so we need to skip it.
+                // Only reached when the key could not be indexed (see KeyEnumeration.h), in which case a subsequent call
+                // by the app might ask for this new index, but we can probably assume it's OK to return it twice.
 #if _DEBUG
                 Log(L"[%d] RegEnumKeyEx:  DeletionMarker Blocking lpName=%S, try again.", RegLocalInstance, lpName);
 #endif                
@@ -14,6 +14,7 @@
 #include "Logging.h"
 #include <regex>
 #include "RegRemediation.h"
+#include "KeyEnumeration.h"
 
 #ifdef INTERCEPT_KERNELBASE
 LSTATUS __stdcall RegEnumValueAFixup(
@@ -39,6 +40,20 @@ LSTATUS __stdcall RegEnumValueAFixup(
 
     bool stillWorking = true;
     DWORD onIndex = dwIndex;
+    switch (MapValueIndex(key, keyonlypath, dwIndex, onIndex, RegLocalInstance))
+    {
+    case ERROR_SUCCESS:
+        result = impl::KernelBaseRegEnumValueA(key, onIndex, lpName, lpcchName, lpReserved, lpType, lpData, lpcbData);
+        stillWorking = false;
+        break;
+    case ERROR_NO_MORE_ITEMS:
+        result = ERROR_NO_MORE_ITEMS;
+        stillWorking = false;
+        break;
+    default:
+        // The key could not be indexed, so check the values one at a time
+        break;
+    }
     while (stillWorking)
     {
         result = impl::KernelBaseRegEnumValueA(key, onIndex, lpName, lpcchName, lpReserved, lpType, lpData, lpcbData);
@@ -56,8 +71,8 @@ LSTATUS __stdcall RegEnumValueAFixup(
             else
             {
                 // We have a deletion marker on this particular item, so we need to skip it.
-                // When we return this value, a subsequent call by the app might ask for this new index, but we can probably assume it's OK to return it twice
-                // because we do not have a way to remember this, like done in FindFirstFile.
+                // Only reached when the key could not be indexed (see KeyEnumeration.h), in which case a subsequent call
+                // by the app might ask for this new index, but we can probably assume it's OK to return it twice.
 #if _DEBUG
                 Log(L"[%d] RegEnumValue:  DeletionMarker Blocking lpName=%S, try again.", RegLocalInstance, lpName);
 #endif                
@@ -128,6 +143,20 @@ LSTATUS __stdcall RegEnumValueWFixup(
 
     bool stillWorking = true;
     DWORD onIndex = dwIndex;
+    switch (MapValueIndex(key, keyonlypath, dwIndex, onIndex, RegLocalInstance))
+    {
+    case ERROR_SUCCESS:
+        result = impl::KernelBaseRegEnumValueW(key, onIndex, lpName, lpcchName, lpReserved, lpType, lpData, lpcbData);
+        stillWorking = false;
+        break;
+    case ERROR_NO_MORE_ITEMS:
+        result = ERROR_NO_MORE_ITEMS;
+        stillWorking = false;
+        break;
+    default:
+        // The key could not be indexed, so check the values one at a time
+        break;
+    }
     while (stillWorking)
     {
         result = impl::KernelBaseRegEnumValueW(key, onIndex, lpName, lpcchName, lpReserved, lpType, lpData, lpcbData);
@@ -145,8 +174,8 @@ LSTATUS __stdcall RegEnumValueWFixup(
             else
             {
                 // We have a deletion marker on this particular item, so we need to skip it.
-                // When we return this value, a subsequent call by the app might ask for this new index, but we can probably assume it's OK to return it twice
-                // because we do not have a way to remember this, like done in FindFirstFile.
+                // Only reached when the key could not be indexed (see KeyEnumeration.h), in which case a subsequent call
+                // by the app might ask for this new index, but we can probably assume it's OK to return it twice.
 #if _DEBUG
                 Log(L"[%d] RegEnumValue:  DeletionMarker Blocking lpName=%S, try again.", RegLocalInstance, lpName);
 #endif                
@@ -58,9 +58,7 @@ LSTATUS __stdcall RegGetValueAFixup(
         }
         else
         {
-            // We have a deletion marker on this particular item, so we need to skip it.
-            // When we return this value, a subsequent call by the app might ask for this new index, but we can probably assume it's OK to return it twice
-            // because we do not have a way to remember this, like done in FindFirstFile.
+            // We have a deletion marker on this particular item, so we need to hide it.
 #if _DEBUG
             Log(L"[%d] RegGetValue:  DeletionMarker Blocking this call.", RegLocalInstance);
 #endif                
@@ -119,9 +117,7 @@ LSTATUS __stdcall RegGetValueWFixup(
         }
         else
         {
-            // We have a deletion marker on this particular item, so we need to skip it.
-            // When we return this value, a subsequent call by the app might ask for this new index, but we can probably assume it's OK to return it twice
-            // because we do not have a way to remember this, like done in FindFirstFile.
+            // We have a deletion marker on this particular item, so we need to hide it.
 #if _DEBUG
             Log(L"[%d] RegGetValue:  DeletionMarker Blocking this call.", RegLocalInstance);
 #endif
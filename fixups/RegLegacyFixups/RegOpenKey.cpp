@@ -14,6 +14,7 @@
 #include "Logging.h"
 #include <regex>
 #include "RegRemediation.h"
+#include "KeyPathCache.h"
 
 auto RegOpenKeyImpl = psf::detoured_string_function(&::RegOpenKeyA, &::RegOpenKeyW);
 template <typename CharT>
@@ -154,6 +155,10 @@ LSTATUS __stdcall RegOpenKeyFixup(
     }
 #endif
 #endif
+    if (result == ERROR_SUCCESS)
+    {
+        TrackKeyPath(*resultKey);
+    }
     return result;
 }
 DECLARE_STRING_FIXUP(RegOpenKeyImpl, RegOpenKeyFixup);
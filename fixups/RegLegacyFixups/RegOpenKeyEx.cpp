@@ -3,8 +3,6 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 //-------------------------------------------------------------------------------------------------------
 
-//#define MOREDEBUG 1
-
 #include <psf_framework.h>
 #include <psf_logging.h>
 
@@ -14,6 +12,7 @@
 #include "Logging.h"
 #include <regex>
 #include "RegRemediation.h"
+#include "KeyPathCache.h"
 
 
 
@@ -31,12 +30,10 @@ LSTATUS __stdcall RegOpenKeyExAFixup(
     bool isBlocked = false;
 
 
-#if _DEBUG
     if (subKey != NULL)
-        Log(L"[%d] RegOpenKeyExA(KernelBase): key=0x%x subKey=%S", RegLocalInstance, (ULONG)(ULONG_PTR)key, subKey);
+        PSF_LOG_DEBUG(g_logRegistry, L"[%d] RegOpenKeyExA(KernelBase): key=0x%x subKey=%S", RegLocalInstance, (ULONG)(ULONG_PTR)key, subKey);
     else
-        Log(L"[%d] RegOpenKeyExA(KernelBase): key=0x%x subKey=NULL", RegLocalInstance, (ULONG)(ULONG_PTR)key);
-#endif
+        PSF_LOG_DEBUG(g_logRegistry, L"[%d] RegOpenKeyExA(KernelBase): key=0x%x subKey=NULL", RegLocalInstance, (ULONG)(ULONG_PTR)key);
 
     std::string keyonlypath = InterpretKeyPath(key);
     std::string keypath;
@@ -45,7 +42,8 @@ LSTATUS __stdcall RegOpenKeyExAFixup(
     else
         keypath = keyonlypath;
 
-    REGSAM samModified = RegFixupSam(keypath, samDesired, RegLocalInstance);
+    auto remediation = EvaluateRegRemediation(keypath, samDesired, Reg_Remediation_Check_ModifyKeyAccess | Reg_Remediation_Check_JavaBlocker, RegLocalInstance);
+    REGSAM samModified = remediation.samModified;
 
     bool hasRedirection = false;
 
@@ -61,19 +59,15 @@ LSTATUS __stdcall RegOpenKeyExAFixup(
         {
 
 
-#if MOREDEBUG
-            Log(L"[%d] RegOpenKeyExA:  JavaBlocker checking path=%S", RegLocalInstance, keypath.c_str());
-#endif
+            PSF_LOG_TRACE(g_logRegistry, L"[%d] RegOpenKeyExA:  JavaBlocker checking path=%S", RegLocalInstance, keypath.c_str());
 
-            if (!RegFixupJavaBlocker(keypath, RegLocalInstance))
+            if (!remediation.javaBlocked)
             {
                 result = impl::KernelBaseRegOpenKeyExA(key, subKey, options, samModified, resultKey);
             }
             else
             {
-#if _DEBUG
-                Log(L"[%d] RegOpenKeyExA:  JavaBlocker Blocking path=%S", RegLocalInstance, keypath.c_str());
-#endif
+                PSF_LOG_DEBUG(g_logRegistry, L"[%d] RegOpenKeyExA:  JavaBlocker Blocking path=%S", RegLocalInstance, keypath.c_str());
                 result = ERROR_PATH_NOT_FOUND;
                 resultKey = NULL;
                 isBlocked = true;
@@ -89,20 +83,16 @@ LSTATUS __stdcall RegOpenKeyExAFixup(
 
 
 
-#ifdef _DEBUG
     if (result != ERROR_SUCCESS)
     {
-        Log("[%d] RegOpenKeyExA result=%d", RegLocalInstance, result);
+        PSF_LOG_DEBUG(g_logRegistry, "[%d] RegOpenKeyExA result=%d", RegLocalInstance, result);
     }
     else
     {
-        Log("[%d] RegOpenKeyExA result=SUCCESS key=0x%x", RegLocalInstance, *resultKey);
+        PSF_LOG_DEBUG(g_logRegistry, "[%d] RegOpenKeyExA result=SUCCESS key=0x%x", RegLocalInstance, *resultKey);
     }
-#endif
 
-#ifdef _DEBUG
-#ifdef MOREDEBUG
-    if (true) //result == ERROR_ACCESS_DENIED)
+    if (PSF_LOG_ENABLED(psf::log_level::trace, g_logRegistry))
     {
         auto functionResult = from_win32(result);
         if (auto lock = acquire_output_lock(function_type::registry, functionResult))
@@ -134,8 +124,10 @@ LSTATUS __stdcall RegOpenKeyExAFixup(
             }
         }
     }
-#endif
-#endif
+    if (result == ERROR_SUCCESS)
+    {
+        TrackKeyPath(*resultKey);
+    }
     return result;
 }
 DECLARE_FIXUP(impl::KernelBaseRegOpenKeyExA, RegOpenKeyExAFixup);
@@ -153,12 +145,10 @@ LSTATUS __stdcall RegOpenKeyExWFixup(
     bool isBlocked = false;
 
 
-#if _DEBUG
     if (subKey != NULL)
-        Log(L"[%d] RegOpenKeyExW(KernelBase): key=0x%x subKey=%ls", RegLocalInstance, (ULONG)(ULONG_PTR)key, subKey);
+        PSF_LOG_DEBUG(g_logRegistry, L"[%d] RegOpenKeyExW(KernelBase): key=0x%x subKey=%ls", RegLocalInstance, (ULONG)(ULONG_PTR)key, subKey);
     else
-        Log(L"[%d] RegOpenKeyExW(KernelBase): key=0x%x subKey=NULL", RegLocalInstance, (ULONG)(ULONG_PTR)key);
-#endif
+        PSF_LOG_DEBUG(g_logRegistry, L"[%d] RegOpenKeyExW(KernelBase): key=0x%x subKey=NULL", RegLocalInstance, (ULONG)(ULONG_PTR)key);
 
     std::string keyonlypath = InterpretKeyPath(key);
     std::string keypath;
@@ -166,7 +156,8 @@ LSTATUS __stdcall RegOpenKeyExWFixup(
         keypath = keyonlypath + "\\" + InterpretStringA(subKey);
     else
         keypath = keyonlypath;
-    REGSAM samModified = RegFixupSam(keypath, samDesired, RegLocalInstance);
+    auto remediation = EvaluateRegRemediation(keypath, samDesired, Reg_Remediation_Check_ModifyKeyAccess | Reg_Remediation_Check_JavaBlocker, RegLocalInstance);
+    REGSAM samModified = remediation.samModified;
 
     bool hasRedirection = false;
 
@@ -182,19 +173,15 @@ LSTATUS __stdcall RegOpenKeyExWFixup(
         {
 
 
-#if MOREDEBUG
-            Log(L"[%d] RegOpenKeyExA:  JavaBlocker checking path=%S", RegLocalInstance, keypath.c_str());
-#endif
+            PSF_LOG_TRACE(g_logRegistry, L"[%d] RegOpenKeyExA:  JavaBlocker checking path=%S", RegLocalInstance, keypath.c_str());
 
-            if (!RegFixupJavaBlocker(keypath, RegLocalInstance))
+            if (!remediation.javaBlocked)
             {
                 result = impl::KernelBaseRegOpenKeyExW(key, subKey, options, samModified, resultKey);
             }
             else
             {
-#if _DEBUG
-                Log(L"[%d] RegOpenKeyExW:  JavaBlocker Blocking path=%S", RegLocalInstance, keypath.c_str());
-#endif
+                PSF_LOG_DEBUG(g_logRegistry, L"[%d] RegOpenKeyExW:  JavaBlocker Blocking path=%S", RegLocalInstance, keypath.c_str());
                 result = ERROR_PATH_NOT_FOUND;
                 resultKey = NULL;
                 isBlocked = true;
@@ -210,20 +197,16 @@ LSTATUS __stdcall RegOpenKeyExWFixup(
 
 
 
-#ifdef _DEBUG
     if (result != ERROR_SUCCESS)
     {
-        Log("[%d] RegOpenKeyExW result=%d", RegLocalInstance, result);
+        PSF_LOG_DEBUG(g_logRegistry, "[%d] RegOpenKeyExW result=%d", RegLocalInstance, result);
     }
     else
     {
-        Log("[%d] RegOpenKeyExW result=SUCCESS key=0x%x", RegLocalInstance, *resultKey);
+        PSF_LOG_DEBUG(g_logRegistry, "[%d] RegOpenKeyExW result=SUCCESS key=0x%x", RegLocalInstance, *resultKey);
     }
-#endif
 
-#ifdef _DEBUG
-#ifdef MOREDEBUG
-    if (true) //result == ERROR_ACCESS_DENIED)
+    if (PSF_LOG_ENABLED(psf::log_level::trace, g_logRegistry))
     {
         auto functionResult = from_win32(result);
         if (auto lock = acquire_output_lock(function_type::registry, functionResult))
@@ -255,8 +238,10 @@ LSTATUS __stdcall RegOpenKeyExWFixup(
             }
         }
     }
-#endif
-#endif
+    if (result == ERROR_SUCCESS)
+    {
+        TrackKeyPath(*resultKey);
+    }
     return result;
 }
 DECLARE_FIXUP(impl::KernelBaseRegOpenKeyExW, RegOpenKeyExWFixup);
@@ -279,20 +264,20 @@ LSTATUS __stdcall RegOpenKeyExFixup(
     bool isBlocked = false;
     
 
-#if _DEBUG
     if constexpr (psf::is_ansi<CharT>)
     {
-        Log(L"[%d] RegOpenKeyEx:  key=0x%x subkey=%S", RegLocalInstance, (ULONG)(ULONG_PTR)key, subKey);
+        PSF_LOG_DEBUG(g_logRegistry, L"[%d] RegOpenKeyEx:  key=0x%x subkey=%S", RegLocalInstance, (ULONG)(ULONG_PTR)key, subKey);
     }
     else
     {
-        Log(L"[%d] RegOpenKeyEx: key=0x%x subKey=%ls", RegLocalInstance, (ULONG)(ULONG_PTR)key, subKey);
+        PSF_LOG_DEBUG(g_logRegistry, L"[%d] RegOpenKeyEx: key=0x%x subKey=%ls", RegLocalInstance, (ULONG)(ULONG_PTR)key, subKey);
     }
-#endif
 
     std::string keyonlypath = InterpretKeyPath(key);
     std::string keypath = keyonlypath + "\\" + InterpretStringA(subKey);
-    REGSAM samModified = RegFixupSam(keypath, samDesired, RegLocalInstance);
+    // One pass over the rules for both the access to ask for and whether the key is hidden by the Java blocker
+    auto remediation = EvaluateRegRemediation(keypath, samDesired, Reg_Remediation_Check_ModifyKeyAccess | Reg_Remediation_Check_JavaBlocker, RegLocalInstance);
+    REGSAM samModified = remediation.samModified;
 
     bool hasRedirection = false;
 #if TRYHKLM2HKCU
@@ -324,9 +309,10 @@ LSTATUS __stdcall RegOpenKeyExFixup(
                 result = RegOpenKeyExImpl(altkey, subKey, options, samModified, resultKey);
                 RegCloseKey(altkey);
                 hasRedirection = true;
-#ifdef _DEBUG
-                LogString(RegLocalInstance, L"\tRegOpenKeyEx Redirecting to HKCU", subKey);
-#endif
+                if (PSF_LOG_ENABLED(psf::log_level::debug, g_logRegistry))
+                {
+                    LogString(RegLocalInstance, L"\tRegOpenKeyEx Redirecting to HKCU", subKey);
+                }
             }
         }
     }
@@ -340,19 +326,15 @@ LSTATUS __stdcall RegOpenKeyExFixup(
         {
             
 
-#if MOREDEBUG
-            Log(L"[%d] RegOpenKeyEx:  JavaBlocker checking path=%S", RegLocalInstance, keypath.c_str());
-#endif
+            PSF_LOG_TRACE(g_logRegistry, L"[%d] RegOpenKeyEx:  JavaBlocker checking path=%S", RegLocalInstance, keypath.c_str());
 
-            if (!RegFixupJavaBlocker(keypath, RegLocalInstance))
+            if (!remediation.javaBlocked)
             {
                 result = RegOpenKeyExImpl(key, subKey, options, samModified, resultKey);
             }
             else
             {
-#if _DEBUG
-                Log(L"[%d] RegOpenKeyEx:  JavaBlocker Blocking path=%S", RegLocalInstance, keypath.c_str());
-#endif
+                PSF_LOG_DEBUG(g_logRegistry, L"[%d] RegOpenKeyEx:  JavaBlocker Blocking path=%S", RegLocalInstance, keypath.c_str());
                 result = ERROR_PATH_NOT_FOUND;
                 resultKey = NULL;
                 isBlocked = true;
@@ -368,20 +350,16 @@ LSTATUS __stdcall RegOpenKeyExFixup(
 
 
 
-#ifdef _DEBUG
     if (result != ERROR_SUCCESS)
     {
-        Log("[%d] RegOpenKeyEx result=%d", RegLocalInstance, result);
+        PSF_LOG_DEBUG(g_logRegistry, "[%d] RegOpenKeyEx result=%d", RegLocalInstance, result);
     }
     else
     {
-        Log("[%d] RegOpenKeyEx result=SUCCESS key=0x%x", RegLocalInstance,*resultKey);
+        PSF_LOG_DEBUG(g_logRegistry, "[%d] RegOpenKeyEx result=SUCCESS key=0x%x", RegLocalInstance,*resultKey);
     }
-#endif
 
-#ifdef _DEBUG
-#ifdef MOREDEBUG
-    if (true) //result == ERROR_ACCESS_DENIED)
+    if (PSF_LOG_ENABLED(psf::log_level::trace, g_logRegistry))
     {
         auto functionResult = from_win32(result);
         if (auto lock = acquire_output_lock(function_type::registry, functionResult))
@@ -410,8 +388,10 @@ LSTATUS __stdcall RegOpenKeyExFixup(
             }
         }
     }
-#endif
-#endif
+    if (result == ERROR_SUCCESS)
+    {
+        TrackKeyPath(*resultKey);
+    }
     return result;
 }
 DECLARE_STRING_FIXUP(RegOpenKeyExImpl, RegOpenKeyExFixup);
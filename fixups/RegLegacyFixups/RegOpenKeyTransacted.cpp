@@ -13,6 +13,7 @@
 #include "Logging.h"
 #include <regex>
 #include "RegRemediation.h"
+#include "KeyPathCache.h"
 
 
 auto RegOpenKeyTransactedImpl = psf::detoured_string_function(&::RegOpenKeyTransactedA, &::RegOpenKeyTransactedW);
@@ -92,6 +93,10 @@ LSTATUS __stdcall RegOpenKeyTransactedFixup(
         }
     }
 #endif
+    if (result == ERROR_SUCCESS)
+    {
+        TrackKeyPath(*resultKey);
+    }
     return result;
 }
 DECLARE_STRING_FIXUP(RegOpenKeyTransactedImpl, RegOpenKeyTransactedFixup);
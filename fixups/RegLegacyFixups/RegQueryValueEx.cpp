@@ -52,9 +52,7 @@ LSTATUS __stdcall RegQueryValueExAFixup(
             }
             else
             {
-                // We have a deletion marker on this particular item, so we need to skip it.
-                // When we return this value, a subsequent call by the app might ask for this new index, but we can probably assume it's OK to return it twice
-                // because we do not have a way to remember this, like done in FindFirstFile.
+                // We have a deletion marker on this particular item, so we need to hide it.
 #if _DEBUG
                 Log(L"[%d] RegQueryValueEx:  DeletionMarker Blocking this call.", RegLocalInstance);
 #endif                
@@ -111,9 +109,7 @@ LSTATUS __stdcall RegQueryValueExWFixup(
             }
             else
             {
-                // We have a deletion marker on this particular item, so we need to skip it.
-                // When we return this value, a subsequent call by the app might ask for this new index, but we can probably assume it's OK to return it twice
-                // because we do not have a way to remember this, like done in FindFirstFile.
+                // We have a deletion marker on this particular item, so we need to hide it.
 #if _DEBUG
                 Log(L"[%d] RegQueryValueEx:  DeletionMarker Blocking this call.", RegLocalInstance);
 #endif                
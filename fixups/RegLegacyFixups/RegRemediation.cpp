@@ -12,10 +12,108 @@
 #include "Framework.h"
 #include "Reg_Remediation_Spec.h"
 #include "Logging.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <mutex>
+#include <optional>
 #include <regex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <registry_key_path.h>
 #include "RegRemediation.h"
 
 
+/// <summary>
+///     Compiles a configured key or value pattern. The remediation rules used to build a std::wregex from every pattern
+///     on every registry call; they are compiled here, once, while the configuration is read.
+/// </summary>
+Reg_Pattern CompileRegPattern(std::wstring_view pattern)
+{
+    Reg_Pattern compiled;
+    compiled.text = pattern;
+    compiled.stats = std::make_shared<Reg_Pattern_Stats>();
+    try
+    {
+        compiled.regex.assign(pattern, true);
+        compiled.valid = true;
+    }
+    catch (...)
+    {
+        Log(L"Bad Regex pattern ignored in RegLegacyFixups: %Ls\n", compiled.text.c_str());
+    }
+    return compiled;
+}
+
+bool RegPatternMatch(const Reg_Pattern& pattern, std::wstring_view input)
+{
+    if (!pattern.valid)
+    {
+        return false;
+    }
+    LARGE_INTEGER start;
+    LARGE_INTEGER finish;
+    ::QueryPerformanceCounter(&start);
+    bool matched = pattern.regex.match(input);
+    ::QueryPerformanceCounter(&finish);
+    pattern.stats->evaluations.fetch_add(1, std::memory_order_relaxed);
+    pattern.stats->ticks.fetch_add(static_cast<std::uint64_t>(finish.QuadPart - start.QuadPart), std::memory_order_relaxed);
+    if (matched)
+    {
+        pattern.stats->matches.fetch_add(1, std::memory_order_relaxed);
+    }
+    return matched;
+}
+
+static void LogRegPatternStats(const wchar_t* rule, const Reg_Pattern& pattern, double ticksPerMicrosecond)
+{
+    auto evaluations = pattern.stats->evaluations.load(std::memory_order_relaxed);
+    if (evaluations > 0)
+    {
+        Log(L"RegLegacyFixups: %Ls pattern %Ls: %llu matches of %llu checks, %.1f us total\n", rule, pattern.text.c_str(),
+            pattern.stats->matches.load(std::memory_order_relaxed), evaluations,
+            static_cast<double>(pattern.stats->ticks.load(std::memory_order_relaxed)) / ticksPerMicrosecond);
+    }
+}
+
+void LogRegPatternStats()
+{
+    LARGE_INTEGER frequency;
+    ::QueryPerformanceFrequency(&frequency);
+    double ticksPerMicrosecond = static_cast<double>(frequency.QuadPart) / 1000000.0;
+    for (auto& spec : g_regRemediationSpecs)
+    {
+        for (auto& specitem : spec.remediationRecords)
+        {
+            switch (specitem.remeditaionType)
+            {
+            case Reg_Remediation_Type_ModifyKeyAccess:
+                for (auto& pattern : specitem.modifyKeyAccess.patterns)
+                {
+                    LogRegPatternStats(L"ModifyKeyAccess", pattern, ticksPerMicrosecond);
+                }
+                break;
+            case Reg_Remediation_Type_FakeDelete:
+                for (auto& pattern : specitem.fakeDeleteKey.patterns)
+                {
+                    LogRegPatternStats(L"FakeDelete", pattern, ticksPerMicrosecond);
+                }
+                break;
+            case Reg_Remediation_Type_DeletionMarker:
+                LogRegPatternStats(L"DeletionMarker", specitem.deletionMarker.key, ticksPerMicrosecond);
+                for (auto& pattern : specitem.deletionMarker.patterns)
+                {
+                    LogRegPatternStats(L"DeletionMarker", pattern, ticksPerMicrosecond);
+                }
+                break;
+            default:
+                break;
+            }
+        }
+    }
+}
+
+
 /// <summary>
 ///     ReplaceAppRegistrySyntax takes a string representing a registry path and returns a replacement string in "normal" style if it were in App hive style.
 /// </summary>
@@ -68,693 +166,462 @@ std::string ReplaceAppRegistrySyntax(std::string regPath)
     return returnPath;
 }
 
-REGSAM RegFixupSam(std::string keypath, REGSAM samDesired, DWORD RegLocalInstance)
+namespace
 {
+    bool IsInHive(Modify_Key_Hive_Types ruleHive, psf::registry_hive hive)
+    {
+        switch (ruleHive)
+        {
+        case Modify_Key_Hive_Type_HKCU:
+            return hive == psf::registry_hive::current_user;
+        case Modify_Key_Hive_Type_HKLM:
+            return hive == psf::registry_hive::local_machine;
+        default:
+            return false;
+        }
+    }
 
-    REGSAM samModified = samDesired;
-    std::string keystring;
-    std::string altkeystring;
-
+    bool AnyPatternMatches(const std::vector<Reg_Pattern>& patterns, std::wstring_view relativeKey, [[maybe_unused]] DWORD RegLocalInstance)
+    {
+        for (auto& pattern : patterns)
+        {
+            try
+            {
+                if (RegPatternMatch(pattern, relativeKey))
+                {
+                    return true;
+                }
+            }
+            catch (...)
+            {
+                Log(L"[%d] Bad Regex pattern ignored in RegLegacyFixups.\n", RegLocalInstance);
+            }
+        }
+        return false;
+    }
 
-#ifdef _DEBUG
-    Log("[%d] RegFixupSam: path=%s\n", RegLocalInstance, keypath.c_str());
-#endif
-    for (auto& spec : g_regRemediationSpecs)
+    // Applies the access rule of a ModifyKeyAccess record whose pattern matched. Returns false if the requested access
+    // is one the rule leaves alone, in which case the remaining records still get their chance.
+    bool ApplyModifyKeyAccess(Modify_Key_Access_Types access, REGSAM samDesired, REGSAM& samModified, [[maybe_unused]] DWORD RegLocalInstance)
     {
+        constexpr REGSAM fullAccessOnly = DELETE | WRITE_DAC | WRITE_OWNER | KEY_CREATE_LINK;
+        constexpr REGSAM writeAccess = KEY_SET_VALUE | KEY_CREATE_SUB_KEY | KEY_WRITE;
 
-        for (auto& specitem : spec.remediationRecords)
+        bool wantsFull = ((samDesired & KEY_ALL_ACCESS) == KEY_ALL_ACCESS) || ((samDesired & fullAccessOnly) != 0);
+        bool wantsWrite = ((samDesired & (KEY_SET_VALUE | KEY_CREATE_SUB_KEY)) != 0) || ((samDesired & fullAccessOnly) != 0);
+        switch (access)
         {
-            switch (specitem.remeditaionType)
+        case Modify_Key_Access_Type_Full2RW:
+            if (wantsFull)
             {
-            case Reg_Remediation_Type_ModifyKeyAccess:
-#ifdef MOREDEBUG
-                Log(L"[%d]   RegFixupSam: rule is Check ModifyKeyAccess...\n", RegLocalInstance);
-#endif
-                switch (specitem.modifyKeyAccess.hive)
-                {
-                case Modify_Key_Hive_Type_HKCU:
-                    keystring = "HKEY_CURRENT_USER\\";
-                    altkeystring = "=\\REGISTRY\\USER\\";
-                    if (keypath._Starts_with(keystring) ||
-                        keypath._Starts_with(altkeystring))
-                    {
-#ifdef MOREDEBUG
-                        //Log(L"[%d]   RegFixupSam: is HKCU key\n", RegLocalInstance);
-#endif
-                        for (auto& pattern : specitem.modifyKeyAccess.patterns)
-                        {
-                            size_t OffsetHkcu = keystring.size();
-                            if (keypath._Starts_with(altkeystring))
-                            {
-                                // Must remove both the pattern and the S-1-5-...\ that follows.
-                                OffsetHkcu = keypath.find_first_of('\\', altkeystring.size()) + 1;
-                            }
-#ifdef MOREDEBUG
-                            std::wstring wcheck = widen(keypath.substr(OffsetHkcu));
-                            Log(L"[%d]   RegFixupSam: Check %s\n", RegLocalInstance, wcheck.c_str());
-                            Log(L"[%d]   RegFixupSam: using %s\n", RegLocalInstance, pattern.c_str());
-#endif
-                            try
-                            {
-                                if (std::regex_match(widen(keypath.substr(OffsetHkcu)), std::wregex(pattern, std::regex_constants::icase)))
-                                {
-#ifdef MOREDEBUG
-                                    Log(L"[%d]   RegFixupSam: is HKCU pattern match on type=0x%x.\n", RegLocalInstance, specitem.modifyKeyAccess.access);
-#endif
-                                    switch (specitem.modifyKeyAccess.access)
-                                    {
-                                    case Modify_Key_Access_Type_Full2RW:
-                                        //(samDesired & (DELETE | WRITE_DAC | WRITE_OWNER | KEY_CREATE_LINK)) != 0)
-                                        if ((samDesired & (KEY_ALL_ACCESS)) == (KEY_ALL_ACCESS) ||
-                                            // (samDesired & (DELETE | WRITE_DAC | WRITE_OWNER | KEY_CREATE_LINK | KEY_CREATE_SUB_KEY)) != 0)
-                                            (samDesired & (DELETE | WRITE_DAC | WRITE_OWNER | KEY_CREATE_LINK)) != 0)
-                                            {
-                                            //samModified = samDesired & ~(DELETE | WRITE_DAC | WRITE_OWNER | KEY_CREATE_LINK);
-                                            // samModified = samDesired & ~(DELETE | WRITE_DAC | WRITE_OWNER | KEY_CREATE_LINK | KEY_CREATE_SUB_KEY);
-                                            samModified = samDesired & ~(DELETE | WRITE_DAC | WRITE_OWNER | KEY_CREATE_LINK);
-#ifdef _DEBUG
-                                            Log(L"[%d]   RegFixupSam: Full2RW\n", RegLocalInstance);
-#endif
-                                            return samModified;
-                                        }
-                                        break;
-                                    case Modify_Key_Access_Type_Full2MaxAllowed:
-                                        //(samDesired & (DELETE | WRITE_DAC | WRITE_OWNER | KEY_CREATE_LINK)) != 0)
-                                        if ((samDesired & (KEY_ALL_ACCESS)) == (KEY_ALL_ACCESS) ||
-                                            // (samDesired & (DELETE | WRITE_DAC | WRITE_OWNER | KEY_CREATE_LINK | KEY_CREATE_SUB_KEY)) != 0)
-                                            (samDesired & (DELETE | WRITE_DAC | WRITE_OWNER | KEY_CREATE_LINK)) != 0)
-                                        {
-                                            // MAXIMUM_ALLOWED turns out to not have the maximum permissions allowed for
-                                            // running in the container, for example to create a subkey.  So We'll try this.
-                                            // samModified = KEY_READ | KEY_WRITE;
-                                            samModified = MAXIMUM_ALLOWED;
-#ifdef _DEBUG
-                                            Log(L"[%d]   RegFixupSam: Full2MaxAllowed\n", RegLocalInstance);
-#endif                                    
-                                            return samModified;
-                                        }
-                                        break;
-                                    case Modify_Key_Access_Type_Full2R:
-                                        if ((samDesired & (KEY_ALL_ACCESS)) == (KEY_ALL_ACCESS) ||
-                                            (samDesired & (DELETE | WRITE_DAC | WRITE_OWNER | KEY_CREATE_LINK)) != 0 ||
-                                            (samDesired & (KEY_SET_VALUE | KEY_CREATE_SUB_KEY | KEY_WRITE)) != 0)
-                                        {
-                                            samModified = samDesired & ~(DELETE | WRITE_DAC | WRITE_OWNER | KEY_CREATE_LINK | KEY_SET_VALUE | KEY_CREATE_SUB_KEY | KEY_WRITE);
-#ifdef _DEBUG
-                                            Log(L"[%d]   RegFixupSam: Full2R\n", RegLocalInstance);
-#endif
-                                            return samModified;
-                                        }
-                                        break;
-                                    case Modify_Key_Access_Type_RW2R:
-                                        if ((samDesired & (KEY_SET_VALUE | KEY_CREATE_SUB_KEY)) != 0 ||
-                                            (samDesired & (DELETE | WRITE_DAC | WRITE_OWNER | KEY_CREATE_LINK)) != 0)
-                                        {
-                                            samModified = samDesired & ~(DELETE | WRITE_DAC | WRITE_OWNER | KEY_CREATE_LINK | KEY_SET_VALUE | KEY_CREATE_SUB_KEY | KEY_WRITE);
+                samModified = samDesired & ~fullAccessOnly;
 #ifdef _DEBUG
-                                            Log(L"[%d]   RegFixupSam: RW2R\n", RegLocalInstance);
+                Log(L"[%d]   RegFixupSam: Full2RW\n", RegLocalInstance);
 #endif
-                                            return samModified;
-                                        }
-                                        break;
-                                    case Modify_Key_Access_Type_RW2MaxAllowed:
-                                        //(samDesired & (DELETE | WRITE_DAC | WRITE_OWNER | KEY_CREATE_LINK)) != 0)
-                                        if ((samDesired & (KEY_SET_VALUE | KEY_CREATE_SUB_KEY)) != 0 ||
-                                            // (samDesired & (DELETE | WRITE_DAC | WRITE_OWNER | KEY_CREATE_LINK | KEY_CREATE_SUB_KEY)) != 0)
-                                            (samDesired & (DELETE | WRITE_DAC | WRITE_OWNER | KEY_CREATE_LINK)) != 0)
-                                        {
-                                            // MAXIMUM_ALLOWED turns out to not have the maximum permissions allowed for
-                                            // running in the container, for example to create a subkey.  So We'll try this.
-                                            // samModified = KEY_READ | KEY_WRITE;
-                                            samModified = MAXIMUM_ALLOWED;
-#ifdef _DEBUG
-                                            Log(L"[%d]   RegFixupSam: RW2MaxAllowed\n", RegLocalInstance);
-#endif                                    
-                                            return samModified;
-                                        }
-                                        break;
-                                    default:
-#ifdef _DEBUG
-                                        Log(L"[%d]   RegFixupSam: Unknown rule ignored.\n", RegLocalInstance);
-#endif 
-                                        break;
-                                    }
-                                }
-                            }
-                            catch (...)
-                            {
-                                Log(L"[%d] Bad Regex pattern ignored in RegLegacyFixups.\n", RegLocalInstance);
-                            }
-                        }
-                    }
-                    else
-                    {
+                return true;
+            }
+            break;
+        case Modify_Key_Access_Type_Full2MaxAllowed:
+            if (wantsFull)
+            {
+                // MAXIMUM_ALLOWED turns out to not have the maximum permissions allowed for
+                // running in the container, for example to create a subkey.  So We'll try this.
+                // samModified = KEY_READ | KEY_WRITE;
+                samModified = MAXIMUM_ALLOWED;
 #ifdef _DEBUG
-                        //Log(L"[%d]   RegFixupSam: is not HKCU key?\n", RegLocalInstance);
+                Log(L"[%d]   RegFixupSam: Full2MaxAllowed\n", RegLocalInstance);
 #endif
-                    }
-                    break;
-                case Modify_Key_Hive_Type_HKLM:
-                    keystring = "HKEY_LOCAL_MACHINE\\";
-                    altkeystring = "=\\REGISTRY\\MACHINE\\";
-                    if (keypath._Starts_with(keystring) ||
-                        keypath._Starts_with(altkeystring))
-                    {
-                        size_t OffsetHklm = keystring.size();
-                        if (keypath._Starts_with(altkeystring))
-                        {
-                            // Must remove both the pattern and the S-1-5-...\ that follows.
-                            OffsetHklm = keypath.find_first_of('\\', altkeystring.size()) + 1;
-                        }
+                return true;
+            }
+            break;
+        case Modify_Key_Access_Type_Full2R:
+            if (wantsFull || ((samDesired & writeAccess) != 0))
+            {
+                samModified = samDesired & ~(fullAccessOnly | writeAccess);
 #ifdef _DEBUG
-                        //Log(L"[%d]   RegFixupSam:  is HKLM key\n", RegLocalInstance);
+                Log(L"[%d]   RegFixupSam: Full2R\n", RegLocalInstance);
 #endif
-                        for (auto& pattern : specitem.modifyKeyAccess.patterns)
-                        {
-                            try
-                            {
-                                if (std::regex_match(widen(keypath.substr(OffsetHklm)), std::wregex(pattern, std::regex_constants::icase)))
-                                {
+                return true;
+            }
+            break;
+        case Modify_Key_Access_Type_RW2R:
+            if (wantsWrite)
+            {
+                samModified = samDesired & ~(fullAccessOnly | writeAccess);
 #ifdef _DEBUG
-                                    Log(L"[%d]   RegFixupSam: is HKLM pattern match on type=0x%x.\n", RegLocalInstance, specitem.modifyKeyAccess.access);
+                Log(L"[%d]   RegFixupSam: RW2R\n", RegLocalInstance);
 #endif
-                                    switch (specitem.modifyKeyAccess.access)
-                                    {
-                                    case Modify_Key_Access_Type_Full2RW:
-                                        //(samDesired & (DELETE | WRITE_DAC | WRITE_OWNER | KEY_CREATE_LINK)) != 0)
-                                        if ((samDesired & (KEY_ALL_ACCESS)) == (KEY_ALL_ACCESS) ||
-                                            // (samDesired & (DELETE | WRITE_DAC | WRITE_OWNER | KEY_CREATE_LINK | KEY_CREATE_SUB_KEY)) != 0)
-                                            (samDesired & (DELETE | WRITE_DAC | WRITE_OWNER | KEY_CREATE_LINK)) != 0)
-                                        {
-                                            //samModified = samDesired & ~(DELETE | WRITE_DAC | WRITE_OWNER | KEY_CREATE_LINK );
-                                            // samModified = samDesired & ~(DELETE | WRITE_DAC | WRITE_OWNER | KEY_CREATE_LINK | KEY_CREATE_SUB_KEY);
-                                            samModified = samDesired & ~(DELETE | WRITE_DAC | WRITE_OWNER | KEY_CREATE_LINK);
+                return true;
+            }
+            break;
+        case Modify_Key_Access_Type_RW2MaxAllowed:
+            if (wantsWrite)
+            {
+                samModified = MAXIMUM_ALLOWED;
 #ifdef _DEBUG
-                                            Log(L"[%d]   RegFixupSam: Full2RW\n", RegLocalInstance);
+                Log(L"[%d]   RegFixupSam: RW2MaxAllowed\n", RegLocalInstance);
 #endif
-                                            return samModified;
-                                        }
-                                        break;
-                                    case Modify_Key_Access_Type_Full2R:
-                                        if ((samDesired & (KEY_ALL_ACCESS)) == (KEY_ALL_ACCESS) ||
-                                            (samDesired & (DELETE | WRITE_DAC | WRITE_OWNER | KEY_CREATE_LINK)) != 0 ||
-                                            (samDesired & (KEY_SET_VALUE | KEY_CREATE_SUB_KEY | KEY_WRITE)) != 0)
-                                        {
-                                            samModified = samDesired & ~(DELETE | WRITE_DAC | WRITE_OWNER | KEY_CREATE_LINK | KEY_SET_VALUE | KEY_CREATE_SUB_KEY | KEY_WRITE);
+                return true;
+            }
+            break;
+        default:
 #ifdef _DEBUG
-                                            Log(L"[%d]   RegFixupSam: Full2R\n", RegLocalInstance);
+            Log(L"[%d]   RegFixupSam: Unknown rule ignored.\n", RegLocalInstance);
 #endif
-                                            return samModified;
-                                        }
-                                        break;
-                                    case Modify_Key_Access_Type_Full2MaxAllowed:
-                                        //(samDesired & (DELETE | WRITE_DAC | WRITE_OWNER | KEY_CREATE_LINK)) != 0)
-                                        if ((samDesired & (KEY_ALL_ACCESS)) == (KEY_ALL_ACCESS) ||
-                                            // (samDesired & (DELETE | WRITE_DAC | WRITE_OWNER | KEY_CREATE_LINK | KEY_CREATE_SUB_KEY)) != 0)
-                                            (samDesired & (DELETE | WRITE_DAC | WRITE_OWNER | KEY_CREATE_LINK)) != 0)
-                                        {
-                                            samModified = MAXIMUM_ALLOWED;
-#ifdef _DEBUG
-                                            Log(L"[%d]   RegFixupSam: Full2MaxAllowed\n", RegLocalInstance);
-#endif                                    
-                                            return samModified;
-                                        }
-                                        break;
-                                    case Modify_Key_Access_Type_RW2R:
-                                        //(samDesired & (DELETE | WRITE_DAC | WRITE_OWNER | KEY_CREATE_LINK)) != 0)
-                                        if ((samDesired & (KEY_SET_VALUE | KEY_CREATE_SUB_KEY)) != 0 ||
-                                            (samDesired & (DELETE | WRITE_DAC | WRITE_OWNER | KEY_CREATE_LINK | KEY_CREATE_SUB_KEY)) != 0)
-                                        {
-                                            samModified = samDesired & ~(DELETE | WRITE_DAC | WRITE_OWNER | KEY_CREATE_LINK | KEY_SET_VALUE | KEY_CREATE_SUB_KEY | KEY_WRITE);
-#ifdef _DEBUG
-                                            Log(L"[%d]   RegFixupSam: RW2R\n", RegLocalInstance);
+            break;
+        }
+        return false;
+    }
+
+    // Applies a DeletionMarker record to the part of "key\\value" below its hive (see classify_registry_marker_path).
+    // Returns ERROR_FILE_NOT_FOUND if the key pattern matches and the record names no values (or no value was asked
+    // about), ERROR_PATH_NOT_FOUND if a value pattern matches too, and ERROR_SUCCESS otherwise. The value patterns of
+    // an HKCU record are matched against the whole remainder, and those of an HKLM record against the value alone, as
+    // they always have been.
+    LSTATUS DeletionMarkerStatus(const Deletion_Marker& marker, std::wstring_view remainder, std::wstring_view wValue, [[maybe_unused]] DWORD RegLocalInstance)
+    {
+#ifdef MOREDEBUG
+        Log(L"[%d] RegFixupDeletionMarker: remainder=%Ls regex=%Ls\n", RegLocalInstance, std::wstring(remainder).c_str(), marker.key.text.c_str());
 #endif
-                                            return samModified;
-                                        }
-                                        break;
-                                    case Modify_Key_Access_Type_RW2MaxAllowed:
-                                        //(samDesired & (DELETE | WRITE_DAC | WRITE_OWNER | KEY_CREATE_LINK)) != 0)
-                                        if ((samDesired & (KEY_SET_VALUE | KEY_CREATE_SUB_KEY)) != 0 ||
-                                            // (samDesired & (DELETE | WRITE_DAC | WRITE_OWNER | KEY_CREATE_LINK | KEY_CREATE_SUB_KEY)) != 0)
-                                            (samDesired & (DELETE | WRITE_DAC | WRITE_OWNER | KEY_CREATE_LINK)) != 0)
-                                        {
-                                            samModified = MAXIMUM_ALLOWED;
-#ifdef _DEBUG
-                                            Log(L"[%d]   RegFixupSam: RW2MaxAllowed\n", RegLocalInstance);
-#endif                                    
-                                            return samModified;
-                                        }
-                                        break;
-                                    default:
-#ifdef _DEBUG
-                                        Log(L"[%d]   RegFixupSam: Unknown rule ignored.\n", RegLocalInstance);
-#endif   
-                                        break;
-                                    }
-                                }
-                            }
-                            catch (...)
-                            {
-                                Log(L"[%d] Bad Regex pattern ignored in RegLegacyFixups.\n", RegLocalInstance);
-                            }
-                        }
-                    }
-                    else
-                    {
+        if (!RegPatternMatch(marker.key, remainder))
+        {
+            return ERROR_SUCCESS;
+        }
+        if (marker.patterns.empty() || wValue.empty())
+        {
+            // treat an empty values list as a match on any value
 #ifdef _DEBUG
-                        //Log(L"[%d]   RegFixupSam: is not HKLM key?\n", RegLocalInstance);
+            Log("[%d] RegFixupDeletionMarker: no pattern or no value return = ERROR_FILE_NOT_FOUND", RegLocalInstance);
 #endif
-                    }
-                    break;
-                case Modify_Key_Hive_Type_Unknown:
+            return ERROR_FILE_NOT_FOUND;
+        }
+        auto valueInput = (marker.hive == Modify_Key_Hive_Type_HKCU) ? remainder : wValue;
+        for (auto& pattern : marker.patterns)
+        {
+            if (RegPatternMatch(pattern, valueInput))
+            {
 #ifdef _DEBUG
-                    Log(L"[%d]   RegFixupSam: is UNKNOWN type key?\n", RegLocalInstance);
+                Log("[%d] RegFixupDeletionMarker: pattern match return = ERROR_PATH_NOT_FOUND", RegLocalInstance);
 #endif
-                    break;
-                default:
-#ifdef _DEBUG
-                    Log(L"[%d]   RegFixupSam: is OTHER type key?\n", RegLocalInstance);
-#endif                    
-                    break;
-                }
-                break;
-            default:
-                // other rule type
-                break;
+                return ERROR_PATH_NOT_FOUND;
+            }
+        }
+        return ERROR_SUCCESS;
+    }
+
+    // Each JavaBlocker record hides the Java versions newer than the one it names, so between them they hide every
+    // version newer than the oldest one named. Set by PrepareRegRemediation.
+    std::optional<Java_Blocker> g_javaBlocker;
+    bool g_hasDeletionMarker = false;
+
+    // The decision for each Java CLSID seen, by the part of it that holds the version
+    std::shared_mutex g_javaKeyMutex;
+    std::unordered_map<std::string, bool> g_javaKeyBlocked;
+
+    bool IsNewerJavaVersion(const Java_Blocker& version, const Java_Blocker& than)
+    {
+        if (version.majorVersion != than.majorVersion)
+        {
+            return version.majorVersion > than.majorVersion;
+        }
+        if (version.minorVersion != than.minorVersion)
+        {
+            return version.minorVersion > than.minorVersion;
+        }
+        return version.updateVersion > than.updateVersion;
+    }
+
+    bool StartsWithUpper(std::string_view str, std::string_view upperPrefix)
+    {
+        return (str.size() >= upperPrefix.size()) &&
+            std::equal(upperPrefix.begin(), upperPrefix.end(), str.begin(),
+                [](char prefixChar, char ch) { return prefixChar == static_cast<char>(std::toupper(static_cast<unsigned char>(ch))); });
+    }
+
+    // Java registers each of its versions as a CLSID, e.g. {CAFEEFAC-0018-0000-0131-ABCDEFFEDCBA} for 1.8.0_131.
+    // Returns the part of such a key path that holds the version, or an empty view for any other key.
+    std::string_view JavaClsidVersion(std::string_view keyPath)
+    {
+        static constexpr std::string_view javaClsidRoots[] =
+        {
+            "HKEY_CURRENT_USER\\SOFTWARE\\CLASSES\\CLSID\\{CAFEEFAC-",
+            "=\\REGISTRY\\USER\\SOFTWARE\\CLASSES\\CLSID\\{CAFEEFAC-",
+            "HKEY_LOCAL_MACHINE\\SOFTWARE\\CLASSES\\CLSID\\{CAFEEFAC-",
+            "=\\REGISTRY\\MACHINE\\SOFTWARE\\CLASSES\\CLSID\\{CAFEEFAC-",
+            "HKEY_LOCAL_MACHINE\\SOFTWARE\\WOW6432NODE\\CLASSES\\CLSID\\{CAFEEFAC-",
+            "=\\REGISTRY\\MACHINE\\SOFTWARE\\WOW6432NODE\\CLASSES\\CLSID\\{CAFEEFAC-"
+        };
+
+        for (auto& root : javaClsidRoots)
+        {
+            if (StartsWithUpper(keyPath, root))
+            {
+                auto version = keyPath.substr(root.size(), 15);
+                return (version.substr(0, 2) == "00") ? version : std::string_view();
             }
         }
+        return std::string_view();
+    }
+
+    bool IsBlockedJavaVersion(std::string_view version)
+    {
+        if (version.size() < 12)
+        {
+            //update version FFF marker doesn't convert, but we want to block it anyway.
+            return true;
+        }
+        Java_Blocker registered;
+        registered.majorVersion = std::atoi(std::string(version.substr(2, 1)).c_str());
+        registered.minorVersion = std::atoi(std::string(version.substr(3, 1)).c_str());
+        registered.updateVersion = std::atoi(std::string(version.substr(12, 3)).c_str());
+        return IsNewerJavaVersion(registered, *g_javaBlocker);
     }
-    return samModified;
 }
 
-#if TRYHKLM2HKCU
-bool HasHKLM2HKCUSpecified()
+/// <summary>
+///     Folds the configured rules into the forms that the intercepts use; called once the configuration has been read.
+/// </summary>
+void PrepareRegRemediation()
 {
     for (auto& spec : g_regRemediationSpecs)
     {
         for (auto& specitem : spec.remediationRecords)
         {
-            if (specitem.remeditaionType == Reg_Remdiaton_Type_HKLM_to_HKCU)
+            if (specitem.remeditaionType == Reg_Remediation_Type_JavaBlocker)
             {
-                return true;
+                if (!g_javaBlocker || IsNewerJavaVersion(*g_javaBlocker, specitem.javaBlocker))
+                {
+                    g_javaBlocker = specitem.javaBlocker;
+                }
+            }
+            else if (specitem.remeditaionType == Reg_Remediation_Type_DeletionMarker)
+            {
+                g_hasDeletionMarker = true;
             }
         }
     }
-    return false;
-} // HasHKLM2HKCUSpecified()
+#if _DEBUG
+    if (g_javaBlocker)
+    {
+        Log(L"RegLegacyFixups: JavaBlocker allows up to %d.%dU%d\n", g_javaBlocker->majorVersion, g_javaBlocker->minorVersion, g_javaBlocker->updateVersion);
+    }
+#endif
+}
 
-std::string HKLM2HKCU_Replacement(std::string path)
+bool HasSubKeyRemediation()
 {
-    std::string rPath = "REDIRECTED";
-    return rPath + "\\" + path;
+    return g_hasDeletionMarker || g_javaBlocker.has_value();
 }
-#endif
 
+bool HasDeletionMarker()
+{
+    return g_hasDeletionMarker;
+}
 
-// helper for registry deleting
-bool RegFixupFakeDelete(std::string keypath, [[maybe_unused]] DWORD RegLocalInstance)
+/// <summary>
+///     Returns true if the JavaBlocker hides the key, which it does for the CLSIDs that register a Java version newer
+///     than the configured one (and for any of them too short to hold a version). Each CLSID is parsed only once.
+/// </summary>
+bool IsBlockedJavaKey(const std::string& keyPath)
 {
-#ifdef _DEBUG
-    Log("[%d] RegFixupFakeDelete: path=%s\n", RegLocalInstance, keypath.c_str());
-#endif
-    std::string keystring;
-    std::string altkeystring;
-    for (auto& spec : g_regRemediationSpecs)
+    if (!g_javaBlocker)
+    {
+        return false;
+    }
+    auto version = JavaClsidVersion(keyPath);
+    if (version.empty())
     {
+        return false;
+    }
 
-        for (auto& specitem : spec.remediationRecords)
+    std::string versionKey(version);
+    {
+        std::shared_lock lock(g_javaKeyMutex);
+        if (auto known = g_javaKeyBlocked.find(versionKey); known != g_javaKeyBlocked.end())
         {
-#ifdef MOREDEBUG
-            Log(L"[%d] RegFixupFakeDelete: specitem.type=%d\n", RegLocalInstance, specitem.remeditaionType);
-#endif      
-            if (specitem.remeditaionType == Reg_Remediation_Type_FakeDelete)
-            {
-#ifdef MOREDEBUG
-                Log(L"[%d] RegFixupFakeDelete: specitem.type=%d\n", RegLocalInstance, specitem.remeditaionType);
-#endif 
-                switch (specitem.fakeDeleteKey.hive)
-                {
-                case Modify_Key_Hive_Type_HKCU:
-                    keystring = "HKEY_CURRENT_USER\\";
-                    altkeystring = "=\\REGISTRY\\USER\\";
-                    if (keypath._Starts_with(keystring) ||
-                        keypath._Starts_with(altkeystring))
-                    {
-                        size_t OffsetHkcu = keystring.size();
-                        if (keypath._Starts_with(altkeystring))
-                        {
-                            // Must remove both the pattern and the S-1-5-...\ that follows.
-                            OffsetHkcu = keypath.find_first_of('\\', altkeystring.size()) + 1;
-                        }
-                        for (auto& pattern : specitem.fakeDeleteKey.patterns)
-                        {
-                            try
-                            {
-                                if (std::regex_match(widen(keypath.substr(OffsetHkcu)), std::wregex(pattern, std::regex_constants::icase)))
-                                {
-#ifdef _DEBUG
-                                    Log(L"[%d] RegFixupFakeDelete: match hkcu\n", RegLocalInstance);
-#endif                            
-                                    return true;
-                                }
-                            }
-                            catch (...)
-                            {
-#ifdef _DEBUG
-                                Log(L"[%d] Bad Regex pattern ignored in RegLegacyFixups.\n", RegLocalInstance);
-#endif
-                            }
-                        }
-                    }
-                    break;
-                case Modify_Key_Hive_Type_HKLM:
-                    keystring = "HKEY_LOCAL_MACHINE\\";
-                    altkeystring = "=\\REGISTRY\\MACHINE\\";
-                    if (keypath._Starts_with(keystring) ||
-                        keypath._Starts_with(altkeystring))
-                    {
-                        size_t OffsetHklm = keystring.size();
-                        if (keypath._Starts_with(altkeystring))
-                        {
-                            // Must remove both the pattern and the S-1-5-...\ that follows.
-                            OffsetHklm = keypath.find_first_of('\\', altkeystring.size()) + 1;
-                        }
-                        for (auto& pattern : specitem.fakeDeleteKey.patterns)
-                        {
-                            try
-                            {
-                                if (std::regex_match(widen(keypath.substr(OffsetHklm)), std::wregex(pattern, std::regex_constants::icase)))
-                                {
-#ifdef _DEBUG
-                                    Log(L"[%d] RegFixupFakeDelete: match HKLM\n", RegLocalInstance);
-#endif                            
-                                    return true;
-                                }
-                            }
-                            catch (...)
-                            {
+            return known->second;
+        }
+    }
+    bool blocked = IsBlockedJavaVersion(version);
+    std::unique_lock lock(g_javaKeyMutex);
+    g_javaKeyBlocked.emplace(std::move(versionKey), blocked);
+    return blocked;
+}
+
+/// <summary>
+///     Works out, in a single pass over the configured rules, which of the key based remediations apply to a key path.
+///     The path is classified (hive, and the part below it) once, rather than once per rule; only the remediations
+///     asked for in checks are looked for, and the walk stops as soon as all of them have been decided. value is only
+///     used by the DeletionMarker check, which looks at "keypath\\value".
+/// </summary>
+Reg_Remediation_Result EvaluateRegRemediation(const std::string& keypath, REGSAM samDesired, unsigned checks, [[maybe_unused]] DWORD RegLocalInstance, std::string_view value)
+{
+    Reg_Remediation_Result result;
+    result.samModified = samDesired;
+
 #ifdef _DEBUG
-                                Log(L"[%d] Bad Regex pattern ignored in RegLegacyFixups.\n", RegLocalInstance);
+    Log("[%d] EvaluateRegRemediation: path=%s\n", RegLocalInstance, keypath.c_str());
 #endif
-                            }
+    auto classified = psf::classify_registry_path(std::string_view(keypath));
+    std::wstring wRelativeKey;
+    if (classified.hive == psf::registry_hive::unknown)
+    {
+        // No ModifyKeyAccess or FakeDelete rule can apply outside of HKCU and HKLM
+        checks &= ~(Reg_Remediation_Check_ModifyKeyAccess | Reg_Remediation_Check_FakeDelete);
+    }
+    else if (checks & (Reg_Remediation_Check_ModifyKeyAccess | Reg_Remediation_Check_FakeDelete))
+    {
+        wRelativeKey = widen(classified.remainder);
+    }
 
-                        }
-                    }
-                    break;
-                }
-            }
+    std::wstring wKeyPathValue;
+    std::wstring_view wValue;
+    psf::classified_registry_path<wchar_t> markerClassified;
+    if ((checks & Reg_Remediation_Check_DeletionMarker) && !g_hasDeletionMarker)
+    {
+        checks &= ~Reg_Remediation_Check_DeletionMarker;
+    }
+    if (checks & Reg_Remediation_Check_DeletionMarker)
+    {
+        wKeyPathValue = widen(keypath);
+        auto valueOffset = wKeyPathValue.length() + 2;
+        wKeyPathValue.append(L"\\\\").append(widen(value));
+        wValue = std::wstring_view(wKeyPathValue).substr(valueOffset);
+        markerClassified = psf::classify_registry_marker_path(std::wstring_view(wKeyPathValue));
+        if (markerClassified.hive == psf::registry_hive::unknown)
+        {
+            checks &= ~Reg_Remediation_Check_DeletionMarker;
         }
     }
-    return false;
-}
 
-
-// helper for registry deletion marker
-// returs ERROR_SUCCESS if the path is not subject to a deletion marker
-//        otherwise appropriate error code for the match, either Path or File (aka full string).
-LSTATUS RegFixupDeletionMarker(std::string keyPath, std::string Value, [[maybe_unused]] DWORD RegLocalInstance)
-{
-    try
+    if (checks & Reg_Remediation_Check_JavaBlocker)
     {
+        try
+        {
+            result.javaBlocked = IsBlockedJavaKey(keypath);
+        }
+        catch (...)
+        {
+            Log(L"[%d] RegFixupJavaBlocker: exception caught\n", RegLocalInstance);
+        }
 #ifdef MOREDEBUG
-        Log("[%d] RegFixupDeletionMarker: keypath=%s value=%s\n", RegLocalInstance, keyPath.c_str(), Value.c_str());
+        Log(L"[%d] RegFixupJavaBlocker: blocked=%d\n", RegLocalInstance, result.javaBlocked);
 #endif
-        std::wstring wKeyPath = widen(keyPath);
-        std::wstring wValue = widen(Value);
-        std::wstring wKeyPathValue = wKeyPath + L"\\\\" + wValue;
-        std::wstring wRemainingKeyPathValue;
-        std::wstring wKeyString;
-        std::wstring wAltKeyString;
-        for (auto& spec : g_regRemediationSpecs)
+        checks &= ~Reg_Remediation_Check_JavaBlocker;
+    }
+
+    for (auto& spec : g_regRemediationSpecs)
+    {
+        for (auto& specitem : spec.remediationRecords)
         {
+            if (checks == 0)
+            {
+                return result;
+            }
 
-            for (auto& specitem : spec.remediationRecords)
+            switch (specitem.remeditaionType)
             {
-                if (specitem.remeditaionType == Reg_Remediation_Type_DeletionMarker)
+            case Reg_Remediation_Type_ModifyKeyAccess:
+                if ((checks & Reg_Remediation_Check_ModifyKeyAccess) &&
+                    IsInHive(specitem.modifyKeyAccess.hive, classified.hive) &&
+                    AnyPatternMatches(specitem.modifyKeyAccess.patterns, wRelativeKey, RegLocalInstance) &&
+                    ApplyModifyKeyAccess(specitem.modifyKeyAccess.access, samDesired, result.samModified, RegLocalInstance))
+                {
+                    checks &= ~Reg_Remediation_Check_ModifyKeyAccess;
+                }
+                break;
+            case Reg_Remediation_Type_FakeDelete:
+                if ((checks & Reg_Remediation_Check_FakeDelete) &&
+                    IsInHive(specitem.fakeDeleteKey.hive, classified.hive) &&
+                    AnyPatternMatches(specitem.fakeDeleteKey.patterns, wRelativeKey, RegLocalInstance))
                 {
-#ifdef MOREDEBUG
-                    Log(L"[%d] RegFixupDeletionMarker: specitem.type=%d\n", RegLocalInstance, specitem.remeditaionType);
-#endif 
-                    //TODO:  Test this
-                    switch (specitem.deletionMarker.hive)
-                    {
-                    case Modify_Key_Hive_Type_HKCU:
-#ifdef MOREDEBUG
-                        Log(L"[%d] RegFixupDeletionMarker: checking hive HKCU\n", RegLocalInstance);
-#endif 
-                        wKeyString = L"HKEY_CURRENT_USER";
-                        wAltKeyString = L"=\\REGISTRY\\USER";
-                        if (wKeyPathValue._Starts_with(wKeyString) ||
-                            wKeyPathValue._Starts_with(wAltKeyString))
-                        {
-#ifdef MOREDEBUG
-                            Log(L"[%d] RegFixupDeletionMarker: request is in hive\n", RegLocalInstance);
-#endif                        
-                            size_t OffsetHkcu = wKeyString.size() + 2;  // skip next '\' 
-                            if (wKeyPathValue._Starts_with(wAltKeyString))
-                            {
-                                // Must remove both the pattern and the S-1-5-...\ that follows.
-                                OffsetHkcu = wKeyPathValue.find_first_of(L'\\', wAltKeyString.size()) + 2;
-                            }
-                            if (OffsetHkcu < wKeyPathValue.size())
-                            {
-                                wRemainingKeyPathValue = wKeyPathValue.substr(OffsetHkcu);
-                            }
-                            else
-                            {
-                                wRemainingKeyPathValue = L"";
-                            }
-                            
-#ifdef MOREDEBUG
-                            Log(L"[%d] RegFixupDeletionMarker: wRemainingKeyPathValue=%Ls\n", RegLocalInstance, wRemainingKeyPathValue.c_str());
-                            Log(L"[%d] RegFixupDeletionMarker: regex=%Ls\n", RegLocalInstance, specitem.deletionMarker.key.c_str());
-#endif
-                            if (std::regex_match(wRemainingKeyPathValue, std::wregex(specitem.deletionMarker.key, std::regex_constants::icase)))
-                            {
-#ifdef MOREDEBUG
-                                Log(L"[%d] RegFixupDeletionMarker: regex match on key\n", RegLocalInstance);
-#endif                            
-                                if (specitem.deletionMarker.patterns.empty())
-                                {
-                                    // treat an empty values list as a match on any value
-#ifdef _DEBUG
-                                    Log("[%d] RegFixupDeletionMarker: no pattern specified return = ERROR_FILE_NOT_FOUND", RegLocalInstance);
-#endif
-                                    return ERROR_FILE_NOT_FOUND;
-                                }
-                                else if (wValue.size() == 0)
-                                {
-#ifdef _DEBUG
-                                    Log("[%d] RegFixupDeletionMarker: no value specified return = ERROR_FILE_NOT_FOUND", RegLocalInstance);
-#endif
-                                    return ERROR_FILE_NOT_FOUND;
-                                }
-                                else
-                                {
-                                    for (auto& pattern : specitem.deletionMarker.patterns)
-                                    {
-                                        std::wstring fullpattern = specitem.deletionMarker.key + L".*" + pattern;
-#ifdef MOREDEBUG
-                                        Log(L"[%d] RegFixupDeletionMarker: wRemainingKeyPathValue vs regex=%Ls\n", RegLocalInstance, fullpattern.c_str());
-#endif
-                                        if (std::regex_match(wRemainingKeyPathValue, std::wregex(fullpattern, std::regex_constants::icase)))
-                                        {
-#ifdef _DEBUG
-                                            Log("[%d] RegFixupDeletionMarker: pattern match return = ERROR_PATH_NOT_FOUND", RegLocalInstance);
-#endif
-                                            return ERROR_PATH_NOT_FOUND;
-                                        }
-                                    }
-                                }
-                            }
-#ifdef MOREDEBUG
-                            Log(L"[%d] RegFixupDeletionMarker: no match found.\n", RegLocalInstance);
-#endif 
-                        }
-                        break;
-                    case Modify_Key_Hive_Type_HKLM:
-                        wKeyString = L"HKEY_LOCAL_MACHINE";
-                        wAltKeyString = L"=\\REGISTRY\\MACHINE";
-                        if (wKeyPathValue._Starts_with(wKeyString) ||
-                            wKeyPathValue._Starts_with(wAltKeyString))
-                        {
-                            size_t OffsetHkcu = wKeyString.size() + 2;  // skip next '\' 
-                            if (wKeyPathValue._Starts_with(wAltKeyString))
-                            {
-                                // Must remove both the pattern and the S-1-5-...\ that follows.
-                                OffsetHkcu = wKeyPathValue.find_first_of(L'\\', wAltKeyString.size()) + 2;
-                            }
-                            if (OffsetHkcu < wKeyPathValue.size())
-                            {
-                                wRemainingKeyPathValue = wKeyPathValue.substr(OffsetHkcu);
-                            }
-                            else
-                            {
-                                wRemainingKeyPathValue = L"";
-                            }
-                            if (std::regex_match(wRemainingKeyPathValue, std::wregex(specitem.deletionMarker.key, std::regex_constants::icase)))
-                            {
-                                if (specitem.deletionMarker.patterns.empty())
-                                {
-                                    // treat an empty values list as a match on any value
-#ifdef _DEBUG
-                                    Log("[%d] RegFixupDeletionMarker: return = ERROR_FILE_NOT_FOUND", RegLocalInstance);
-#endif
-                                    return ERROR_FILE_NOT_FOUND;
-                                }
-                                else if (wValue.size() == 0)
-                                {
-                                    return ERROR_FILE_NOT_FOUND;
-                                }
-                                else
-                                {
-                                    for (auto& pattern : specitem.deletionMarker.patterns)
-                                    {
-                                        std::wstring fullpattern = specitem.deletionMarker.key + L".*" + pattern;
-                                        if (std::regex_match(wValue, std::wregex(fullpattern, std::regex_constants::icase)))
-                                        {
 #ifdef _DEBUG
-                                            Log("[%d] RegFixupDeletionMarker: return = ERROR_PATH_NOT_FOUND", RegLocalInstance);
+                    Log(L"[%d] RegFixupFakeDelete: match\n", RegLocalInstance);
 #endif
-                                            return ERROR_PATH_NOT_FOUND;
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                        break;
-                    default:
-                        break;
+                    result.fakeDelete = true;
+                    checks &= ~Reg_Remediation_Check_FakeDelete;
+                }
+                break;
+            case Reg_Remediation_Type_DeletionMarker:
+                if ((checks & Reg_Remediation_Check_DeletionMarker) &&
+                    IsInHive(specitem.deletionMarker.hive, markerClassified.hive))
+                {
+                    result.deletionMarker = DeletionMarkerStatus(specitem.deletionMarker, markerClassified.remainder, wValue, RegLocalInstance);
+                    if (result.deletionMarker != ERROR_SUCCESS)
+                    {
+                        checks &= ~Reg_Remediation_Check_DeletionMarker;
                     }
                 }
+                break;
+            default:
+                // other rule type
+                break;
             }
         }
     }
-    catch (...)
-    {
-        Log(L"[%d] RegFixupDeletionMarker: exception caught\n", RegLocalInstance);
-    }
-    return ERROR_SUCCESS;
+    return result;
 }
 
+REGSAM RegFixupSam(std::string keypath, REGSAM samDesired, DWORD RegLocalInstance)
+{
+    return EvaluateRegRemediation(keypath, samDesired, Reg_Remediation_Check_ModifyKeyAccess, RegLocalInstance).samModified;
+}
 
+// helper for registry deleting
+bool RegFixupFakeDelete(std::string keypath, [[maybe_unused]] DWORD RegLocalInstance)
+{
+    return EvaluateRegRemediation(keypath, 0, Reg_Remediation_Check_FakeDelete, RegLocalInstance).fakeDelete;
+}
 
 // helper for registry java blocker marker
 // true = blocked
 bool RegFixupJavaBlocker(std::string keyPath, [[maybe_unused]] DWORD RegLocalInstance)
 {
-    try
+    return EvaluateRegRemediation(keyPath, 0, Reg_Remediation_Check_JavaBlocker, RegLocalInstance).javaBlocked;
+}
+
+
+#if TRYHKLM2HKCU
+bool HasHKLM2HKCUSpecified()
+{
+    for (auto& spec : g_regRemediationSpecs)
     {
-#ifdef MOREDEBUG
-        Log(L"[%d] RegFixupJavaBlocker: keypath=%S\n", RegLocalInstance, keyPath.c_str());
-#endif
-        std::wstring wKeyPath = widen(keyPath);
-        std::wstring wRemainingKeyPath;
-        std::wstring check_strings[6] = { L"HKEY_CURRENT_USER\\SOFTWARE\\CLASSES\\CLSID\\{CAFEEFAC-",
-                                         L"=\\REGISTRY\\USER\\SOFTWARE\\CLASSES\\CLSID\\{CAFEEFAC-",
-                                         L"HKEY_LOCAL_MACHINE\\SOFTWARE\\CLASSES\\CLSID\\{CAFEEFAC-",
-                                         L"=\\REGISTRY\\MACHINE\\SOFTWARE\\CLASSES\\CLSID\\{CAFEEFAC-",
-                                         L"HKEY_LOCAL_MACHINE\\SOFTWARE\\WOW6432NODE\\CLASSES\\CLSID\\{CAFEEFAC-",
-                                         L"=\\REGISTRY\\MACHINE\\SOFTWARE\\WOW6432NODE\\CLASSES\\CLSID\\{CAFEEFAC-"
-        };
-        //std::wstring wKeyStringU;
-        //std::wstring wAltKeyStringU;
-        //std::wstring wKeyStringM;
-        //std::wstring wAltKeyStringM;
-        //std::wstring wKeyStringMw;
-        //std::wstring wAltKeyStringMw;
-        //std::wstring wMaxAllowedString;
-        for (auto& spec : g_regRemediationSpecs)
+        for (auto& specitem : spec.remediationRecords)
         {
-            for (auto& specitem : spec.remediationRecords)
+            if (specitem.remeditaionType == Reg_Remdiaton_Type_HKLM_to_HKCU)
             {
-                if (specitem.remeditaionType == Reg_Remediation_Type_JavaBlocker)
-                {
-                    std::wstring wKeyPathUpper = L"";
-                    for (size_t i = 0; i < wKeyPath.size(); i++)
-                    {
-                        wKeyPathUpper += towupper(wKeyPath[i]);
-                    }
+                return true;
+            }
+        }
+    }
+    return false;
+} // HasHKLM2HKCUSpecified()
 
-                    bool isInRange = false;
-                    size_t OffsetHkcu = 0;
-                    for (size_t index = 0; index < 6; index++)
-                    {
-                        if (wKeyPathUpper._Starts_with(check_strings[index]))
-                        {
-                            isInRange = true;
-                            OffsetHkcu = check_strings[index].size();
-                            break;
-                        }
-                    }
+std::string HKLM2HKCU_Replacement(std::string path)
+{
+    std::string rPath = "REDIRECTED";
+    return rPath + "\\" + path;
+}
+#endif
 
-                    if (isInRange)
-                    {
-                        if (wKeyPath.size() > OffsetHkcu)
-                        {
-                            wRemainingKeyPath = wKeyPathUpper.substr(OffsetHkcu);
-
-                            // {CAFEEFAC-0018-0000-0131-ABCDEFFEDCBA}
-                            // {CAFEEFAC-0018-0000-0131-ABCDEFFEDCBB}
-                            if (wRemainingKeyPath._Starts_with(L"00"))
-                            {
-                                try
-                                {
-                                    INT32 majorVersion = _wtoi(wRemainingKeyPath.substr(2, 1).c_str());
-                                    INT32 minorVersion = _wtoi(wRemainingKeyPath.substr(3, 1).c_str());
-                                    INT32 buildVersion = _wtoi(wRemainingKeyPath.substr(12, 3).c_str());
-                                    if (specitem.javaBlocker.majorVersion < majorVersion)
-                                    {
-#ifdef MOREDEBUG
-                                        Log(L"[%d] RegFixupJavaBlocker:  matched\n", RegLocalInstance);
-#endif 
-                                        return true;
-                                    }
-                                    if (specitem.javaBlocker.majorVersion == majorVersion)
-                                    {
-                                        if (specitem.javaBlocker.minorVersion < minorVersion)
-                                        {
-#ifdef MOREDEBUG
-                                            Log(L"[%d] RegFixupJavaBlocker:  matched\n", RegLocalInstance);
-#endif 
-                                            return true;
-                                        }
-                                        if (specitem.javaBlocker.minorVersion == minorVersion)
-                                        {
-                                            if (specitem.javaBlocker.updateVersion < buildVersion)
-                                            {
-#ifdef MOREDEBUG
-                                                Log(L"[%d] RegFixupJavaBlocker:  matched\n", RegLocalInstance);
-#endif 
-                                                return true;
-                                            }
-                                        }
-                                    }
-#ifdef MOREDEBUG
-                                    Log(L"[%d] RegFixupJavaBlocker:  allowed\n", RegLocalInstance);
-#endif                                return false;
-                                }
-                                catch (...)
-                                {
-                                    //update version FFF marker doesn't convert, but we want to block it anyway.
+
+
+
+// helper for registry deletion marker
+// returs ERROR_SUCCESS if the path is not subject to a deletion marker
+//        otherwise appropriate error code for the match, either Path or File (aka full string).
+LSTATUS RegFixupDeletionMarker(std::string keyPath, std::string Value, [[maybe_unused]] DWORD RegLocalInstance)
+{
+    try
+    {
 #ifdef MOREDEBUG
-                                    Log(L"[%d] RegFixupJavaBlocker:  exception matched\n", RegLocalInstance);
-#endif 
-                                    return true;
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-        }
+        Log("[%d] RegFixupDeletionMarker: keypath=%s value=%s\n", RegLocalInstance, keyPath.c_str(), Value.c_str());
+#endif
+        return EvaluateRegRemediation(keyPath, 0, Reg_Remediation_Check_DeletionMarker, RegLocalInstance, Value).deletionMarker;
     }
     catch (...)
     {
-        Log(L"[%d] RegFixupJavaBlocker: exception caught\n", RegLocalInstance);
+        Log(L"[%d] RegFixupDeletionMarker: exception caught\n", RegLocalInstance);
     }
-#ifdef MOREDEBUG
-    Log(L"[%d] RegFixupJavaBlocker: no match\n", RegLocalInstance);
-#endif 
-    return false;
+    return ERROR_SUCCESS;
 }
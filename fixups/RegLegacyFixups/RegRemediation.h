@@ -10,6 +10,35 @@
 
 std::string ReplaceAppRegistrySyntax(std::string regPath);
 
+// The key based remediations that EvaluateRegRemediation can look for
+enum Reg_Remediation_Checks : unsigned
+{
+    Reg_Remediation_Check_ModifyKeyAccess = 0x1,
+    Reg_Remediation_Check_FakeDelete = 0x2,
+    Reg_Remediation_Check_JavaBlocker = 0x4,
+    Reg_Remediation_Check_DeletionMarker = 0x8,
+};
+
+struct Reg_Remediation_Result
+{
+    REGSAM samModified;         // samDesired, unless a ModifyKeyAccess rule changes it
+    bool fakeDelete = false;
+    bool javaBlocked = false;
+    LSTATUS deletionMarker = ERROR_SUCCESS;     // as RegFixupDeletionMarker returns it
+};
+
+void PrepareRegRemediation();
+
+// True if any rule can hide a subkey from enumeration (a DeletionMarker or JavaBlocker)
+bool HasSubKeyRemediation();
+
+// True if any DeletionMarker is configured, the only rule that can hide a value
+bool HasDeletionMarker();
+
+bool IsBlockedJavaKey(const std::string& keyPath);
+
+Reg_Remediation_Result EvaluateRegRemediation(const std::string& keypath, REGSAM samDesired, unsigned checks, DWORD RegLocalInstance, std::string_view value = {});
+
 REGSAM RegFixupSam(std::string keypath, REGSAM samDesired, DWORD RegLocalInstance);
 
 bool RegFixupFakeDelete(std::string keypath, [[maybe_unused]] DWORD RegLocalInstance);
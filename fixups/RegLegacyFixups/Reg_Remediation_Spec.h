@@ -4,8 +4,13 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 //-------------------------------------------------------------------------------------------------------
 #pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
 #include <string_view>
 #include <vector>
+#include <dfa_regex.h>
 
 
 using namespace std::literals;
@@ -39,25 +44,45 @@ enum Modify_Key_Hive_Types
     Modify_Key_Hive_Type_HKLM = 2
 };
 
+// Per pattern counters, shared by all copies of the pattern and logged when the fixup unloads. Kept with
+// relaxed atomics in every build, as a count only needs to be atomic, not ordered with anything else.
+struct Reg_Pattern_Stats
+{
+    std::atomic<std::uint64_t> evaluations{ 0 };
+    std::atomic<std::uint64_t> matches{ 0 };
+    std::atomic<std::uint64_t> ticks{ 0 };
+};
+
+// A key or value pattern from the config, compiled (case insensitive) once by InitializeConfiguration so that the
+// intercepts only have to run the match.
+struct Reg_Pattern
+{
+    std::wstring text;
+    psf::dfa_regex regex;
+    bool valid = false;     // A pattern that did not compile is ignored, it never matches
+    std::shared_ptr<Reg_Pattern_Stats> stats;
+};
+
 struct Modify_Key_Access
 {
     Modify_Key_Hive_Types hive;
-    std::vector<std::wstring> patterns;
+    std::vector<Reg_Pattern> patterns;
     Modify_Key_Access_Types access;
 };
 
 struct Fake_Delete_Key
 {
     Modify_Key_Hive_Types hive;
-    std::vector<std::wstring> patterns;
+    std::vector<Reg_Pattern> patterns;
 };
 
 struct Deletion_Marker
 {
     // NOTE: Both key and values are regex patterns; values are optional
+    // Each value pattern is compiled as key + ".*" + pattern, which is how it is matched.
     Modify_Key_Hive_Types hive;
-    std::wstring key;
-    std::vector<std::wstring> patterns;
+    Reg_Pattern key;
+    std::vector<Reg_Pattern> patterns;
 };
 
 struct Java_Blocker
@@ -81,4 +106,8 @@ struct Reg_Remediation_Spec
     std::vector<Reg_Remediation_Record> remediationRecords;
 };
 
-extern std::vector<Reg_Remediation_Spec>  g_regRemediationSpecs;
\ No newline at end of file
+extern std::vector<Reg_Remediation_Spec>  g_regRemediationSpecs;
+
+extern Reg_Pattern CompileRegPattern(std::wstring_view pattern);
+extern bool RegPatternMatch(const Reg_Pattern& pattern, std::wstring_view input);
+extern void LogRegPatternStats();
\ No newline at end of file
@@ -21,6 +21,8 @@ bool m_shouldLog = true;
 
 void InitializeFixups();
 void InitializeConfiguration();
+void LogRegPatternStats();
+void LogKeyPathCacheStats();
 
 extern "C" {
 
@@ -78,6 +80,8 @@ extern "C" {
 
     int __stdcall PSFUninitialize() noexcept try
     {
+        LogRegPatternStats();
+        LogKeyPathCacheStats();
         psf::detach_all();
         return ERROR_SUCCESS;
     }
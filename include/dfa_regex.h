@@ -0,0 +1,728 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) TMurgent Technologies, LLP. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+//
+// A small regular expression engine for the patterns found in fixup configuration (file name and registry key
+// patterns). The pattern is compiled into a DFA once, at configuration time, so that matching is a single table driven
+// pass over the input that never backtracks and never allocates.
+//
+// The supported subset of the ECMAScript syntax used by std::wregex is:
+//      literals, '.', bracket expressions with ranges and negation ("[tTiI]", "[^\\]"), grouping ("(...)" and
+//      "(?:...)"), alternation, the '*', '+' and '?' quantifiers (a trailing lazy '?' is accepted, it makes no
+//      difference to whether a match exists), escaped punctuation ("\.", "\\"), and '^' / '$' at the very start/end
+//      of the pattern.
+// Anything else (back references, "\d" and friends, counted repetition, assertions, ...) causes the pattern to be
+// handed to std::wregex instead, so callers always get std::wregex semantics. Invalid patterns throw
+// std::regex_error, exactly as std::wregex would.
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cwchar>
+#include <cwctype>
+#include <map>
+#include <memory>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace psf
+{
+    namespace details
+    {
+        // Inclusive character ranges; kept sorted and non-overlapping by normalize_ranges
+        using char_ranges = std::vector<std::pair<std::uint32_t, std::uint32_t>>;
+
+        constexpr std::uint32_t max_regex_char = static_cast<std::uint32_t>(WCHAR_MAX);
+
+        // Limits on the compiled automaton; patterns that would exceed them go to std::wregex instead
+        constexpr std::size_t max_dfa_states = 1024;
+        constexpr std::size_t max_dfa_table = 1 << 18;
+
+        // Raised while compiling when a construct is outside of the supported subset
+        struct unsupported_pattern {};
+
+        inline wchar_t fold_regex_char(wchar_t ch) noexcept
+        {
+            return static_cast<wchar_t>(std::towlower(ch));
+        }
+
+        inline void normalize_ranges(char_ranges& ranges)
+        {
+            std::sort(ranges.begin(), ranges.end());
+            char_ranges merged;
+            for (auto& range : ranges)
+            {
+                if (!merged.empty() && (range.first <= merged.back().second + 1))
+                {
+                    merged.back().second = std::max(merged.back().second, range.second);
+                }
+                else
+                {
+                    merged.push_back(range);
+                }
+            }
+            ranges = std::move(merged);
+        }
+
+        inline char_ranges negate_ranges(const char_ranges& ranges)
+        {
+            char_ranges result;
+            std::uint32_t next = 0;
+            for (auto& range : ranges)
+            {
+                if (range.first > next)
+                {
+                    result.emplace_back(next, range.first - 1);
+                }
+                next = range.second + 1;
+            }
+            if (next <= max_regex_char && (ranges.empty() || ranges.back().second < max_regex_char))
+            {
+                result.emplace_back(next, max_regex_char);
+            }
+            return result;
+        }
+
+        inline bool ranges_contain(const char_ranges& ranges, std::uint32_t ch) noexcept
+        {
+            auto itr = std::upper_bound(ranges.begin(), ranges.end(), ch, [](std::uint32_t value, auto& range)
+            {
+                return value < range.first;
+            });
+            return (itr != ranges.begin()) && (ch <= std::prev(itr)->second);
+        }
+
+        // Thompson construction of an NFA from the pattern. Every fragment has a single start state and a single
+        // (epsilon) end state whose out edge is patched when the fragment is joined to the next one.
+        class regex_nfa
+        {
+        public:
+
+            struct state
+            {
+                int set = -1;   // Index into sets of the characters consumed by this state, or -1 for an epsilon state
+                int out1 = -1;
+                int out2 = -1;
+            };
+
+            std::vector<state> states;
+            std::vector<char_ranges> sets;
+            int match_start = -1;
+            int search_start = -1;
+            int accept = -1;
+            bool anchored_start = false;
+            bool anchored_end = false;
+
+            regex_nfa(std::wstring_view pattern, bool icase) :
+                m_icase(icase)
+            {
+                if (!pattern.empty() && pattern.front() == L'^')
+                {
+                    anchored_start = true;
+                    pattern.remove_prefix(1);
+                }
+                if (!pattern.empty() && pattern.back() == L'$')
+                {
+                    std::size_t escapes = 0;
+                    for (auto i = pattern.length() - 1; (i > 0) && (pattern[i - 1] == L'\\'); --i)
+                    {
+                        ++escapes;
+                    }
+                    if ((escapes % 2) == 0)
+                    {
+                        anchored_end = true;
+                        pattern.remove_suffix(1);
+                    }
+                }
+
+                m_pattern = pattern;
+                auto body = parse_alternation();
+                if (m_pos != m_pattern.length())
+                {
+                    throw unsupported_pattern{};
+                }
+                if ((anchored_start || anchored_end) && m_topLevelAlternation)
+                {
+                    // "^a|b" anchors only the first alternative
+                    throw unsupported_pattern{};
+                }
+
+                accept = body.end;
+                match_start = body.start;
+
+                // The search automaton is the pattern preceded by any number of arbitrary characters
+                auto anyChar = single(char_ranges{ { 0, max_regex_char } });
+                auto prefix = star(anyChar);
+                states[prefix.end].out1 = body.start;
+                search_start = prefix.start;
+            }
+
+        private:
+
+            struct fragment
+            {
+                int start;
+                int end;
+            };
+
+            int new_state(int set = -1)
+            {
+                states.push_back(state{ set, -1, -1 });
+                return static_cast<int>(states.size() - 1);
+            }
+
+            fragment empty()
+            {
+                auto s = new_state();
+                return fragment{ s, s };
+            }
+
+            fragment single(char_ranges ranges)
+            {
+                normalize_ranges(ranges);
+                sets.push_back(std::move(ranges));
+                auto s = new_state(static_cast<int>(sets.size() - 1));
+                auto e = new_state();
+                states[s].out1 = e;
+                return fragment{ s, e };
+            }
+
+            fragment concat(fragment lhs, fragment rhs)
+            {
+                states[lhs.end].out1 = rhs.start;
+                return fragment{ lhs.start, rhs.end };
+            }
+
+            fragment alternate(fragment lhs, fragment rhs)
+            {
+                auto s = new_state();
+                auto e = new_state();
+                states[s].out1 = lhs.start;
+                states[s].out2 = rhs.start;
+                states[lhs.end].out1 = e;
+                states[rhs.end].out1 = e;
+                return fragment{ s, e };
+            }
+
+            fragment star(fragment inner)
+            {
+                auto s = new_state();
+                auto e = new_state();
+                states[s].out1 = inner.start;
+                states[s].out2 = e;
+                states[inner.end].out1 = inner.start;
+                states[inner.end].out2 = e;
+                return fragment{ s, e };
+            }
+
+            fragment plus(fragment inner)
+            {
+                auto e = new_state();
+                states[inner.end].out1 = inner.start;
+                states[inner.end].out2 = e;
+                return fragment{ inner.start, e };
+            }
+
+            fragment optional(fragment inner)
+            {
+                auto s = new_state();
+                auto e = new_state();
+                states[s].out1 = inner.start;
+                states[s].out2 = e;
+                states[inner.end].out1 = e;
+                return fragment{ s, e };
+            }
+
+            bool at_end() const noexcept
+            {
+                return m_pos >= m_pattern.length();
+            }
+
+            wchar_t peek() const noexcept
+            {
+                return m_pattern[m_pos];
+            }
+
+            static bool is_identity_escape(wchar_t ch) noexcept
+            {
+                // Only ASCII punctuation may be escaped to mean itself
+                return (ch < 0x80) && !std::iswalnum(ch) && (ch != L'_');
+            }
+
+            fragment parse_alternation()
+            {
+                auto result = parse_concatenation();
+                while (!at_end() && (peek() == L'|'))
+                {
+                    if (m_depth == 0)
+                    {
+                        m_topLevelAlternation = true;
+                    }
+                    ++m_pos;
+                    result = alternate(result, parse_concatenation());
+                }
+                return result;
+            }
+
+            fragment parse_concatenation()
+            {
+                auto result = empty();
+                while (!at_end() && (peek() != L'|') && (peek() != L')'))
+                {
+                    result = concat(result, parse_repetition());
+                }
+                return result;
+            }
+
+            fragment parse_repetition()
+            {
+                auto result = parse_atom();
+                if (!at_end())
+                {
+                    switch (peek())
+                    {
+                    case L'*':
+                        ++m_pos;
+                        result = star(result);
+                        break;
+                    case L'+':
+                        ++m_pos;
+                        result = plus(result);
+                        break;
+                    case L'?':
+                        ++m_pos;
+                        result = optional(result);
+                        break;
+                    case L'{':
+                        throw unsupported_pattern{};
+                    default:
+                        return result;
+                    }
+
+                    // Lazy quantifiers match the same set of strings
+                    if (!at_end() && (peek() == L'?'))
+                    {
+                        ++m_pos;
+                    }
+                    if (!at_end() && ((peek() == L'*') || (peek() == L'+') || (peek() == L'?') || (peek() == L'{')))
+                    {
+                        throw unsupported_pattern{};
+                    }
+                }
+                return result;
+            }
+
+            fragment parse_atom()
+            {
+                auto ch = peek();
+                switch (ch)
+                {
+                case L'(':
+                {
+                    ++m_pos;
+                    if (!at_end() && (peek() == L'?'))
+                    {
+                        if ((m_pos + 1 < m_pattern.length()) && (m_pattern[m_pos + 1] == L':'))
+                        {
+                            m_pos += 2;
+                        }
+                        else
+                        {
+                            throw unsupported_pattern{};
+                        }
+                    }
+                    ++m_depth;
+                    auto result = parse_alternation();
+                    --m_depth;
+                    if (at_end() || (peek() != L')'))
+                    {
+                        throw unsupported_pattern{};
+                    }
+                    ++m_pos;
+                    return result;
+                }
+
+                case L'[':
+                    ++m_pos;
+                    return parse_bracket();
+
+                case L'.':
+                    ++m_pos;
+                    // ECMAScript '.' matches anything but a line terminator
+                    return single(negate_ranges(char_ranges{ { L'\n', L'\n' }, { L'\r', L'\r' }, { 0x2028, 0x2029 } }));
+
+                case L'\\':
+                {
+                    ++m_pos;
+                    if (at_end() || !is_identity_escape(peek()))
+                    {
+                        throw unsupported_pattern{};
+                    }
+                    return literal(m_pattern[m_pos++]);
+                }
+
+                case L'^':
+                case L'$':
+                case L'*':
+                case L'+':
+                case L'?':
+                case L'{':
+                case L'}':
+                case L']':
+                    throw unsupported_pattern{};
+
+                default:
+                    ++m_pos;
+                    return literal(ch);
+                }
+            }
+
+            fragment literal(wchar_t ch)
+            {
+                std::uint32_t value = static_cast<std::uint32_t>(m_icase ? fold_regex_char(ch) : ch);
+                return single(char_ranges{ { value, value } });
+            }
+
+            wchar_t parse_bracket_char()
+            {
+                if (at_end())
+                {
+                    throw unsupported_pattern{};
+                }
+
+                auto ch = m_pattern[m_pos++];
+                if (ch == L'\\')
+                {
+                    if (at_end() || !is_identity_escape(peek()))
+                    {
+                        throw unsupported_pattern{};
+                    }
+                    return m_pattern[m_pos++];
+                }
+                if ((ch == L'[') && !at_end() && ((peek() == L':') || (peek() == L'.') || (peek() == L'=')))
+                {
+                    // Character class names, collating symbols and equivalence classes
+                    throw unsupported_pattern{};
+                }
+                return ch;
+            }
+
+            fragment parse_bracket()
+            {
+                bool negate = false;
+                if (!at_end() && (peek() == L'^'))
+                {
+                    negate = true;
+                    ++m_pos;
+                }
+                if (at_end() || (peek() == L']'))
+                {
+                    throw unsupported_pattern{};
+                }
+
+                char_ranges ranges;
+                while (!at_end() && (peek() != L']'))
+                {
+                    std::uint32_t low = static_cast<std::uint32_t>(parse_bracket_char());
+                    std::uint32_t high = low;
+                    if ((m_pos + 1 < m_pattern.length()) && (peek() == L'-') && (m_pattern[m_pos + 1] != L']'))
+                    {
+                        ++m_pos;
+                        high = static_cast<std::uint32_t>(parse_bracket_char());
+                        if (high < low)
+                        {
+                            throw unsupported_pattern{};
+                        }
+                    }
+                    ranges.emplace_back(low, high);
+                }
+                if (at_end())
+                {
+                    throw unsupported_pattern{};
+                }
+                ++m_pos;
+
+                if (m_icase)
+                {
+                    // Input characters are folded before they are matched, so add the folded form of every member
+                    char_ranges folded;
+                    for (auto& range : ranges)
+                    {
+                        for (auto value = range.first; value <= range.second; ++value)
+                        {
+                            auto lower = static_cast<std::uint32_t>(fold_regex_char(static_cast<wchar_t>(value)));
+                            if (lower != value)
+                            {
+                                folded.emplace_back(lower, lower);
+                            }
+                        }
+                    }
+                    ranges.insert(ranges.end(), folded.begin(), folded.end());
+                }
+
+                normalize_ranges(ranges);
+                return single(negate ? negate_ranges(ranges) : std::move(ranges));
+            }
+
+            std::wstring_view m_pattern;
+            std::size_t m_pos = 0;
+            int m_depth = 0;
+            bool m_topLevelAlternation = false;
+            bool m_icase;
+        };
+
+        // Subset construction of a DFA from the NFA, over the equivalence classes of characters that the pattern
+        // can tell apart.
+        class regex_dfa
+        {
+        public:
+
+            regex_dfa(const regex_nfa& nfa, int start)
+            {
+                // Equivalence classes: every range boundary used by the pattern starts a new class
+                m_boundaries.push_back(0);
+                for (auto& set : nfa.sets)
+                {
+                    for (auto& range : set)
+                    {
+                        m_boundaries.push_back(range.first);
+                        if (range.second < max_regex_char)
+                        {
+                            m_boundaries.push_back(range.second + 1);
+                        }
+                    }
+                }
+                std::sort(m_boundaries.begin(), m_boundaries.end());
+                m_boundaries.erase(std::unique(m_boundaries.begin(), m_boundaries.end()), m_boundaries.end());
+                m_classes = m_boundaries.size();
+                for (std::uint32_t ch = 0; ch < m_ascii.size(); ++ch)
+                {
+                    m_ascii[ch] = class_search(ch);
+                }
+
+                // Which sets each class belongs to
+                std::vector<std::vector<bool>> setHasClass(nfa.sets.size(), std::vector<bool>(m_classes));
+                for (std::size_t set = 0; set < nfa.sets.size(); ++set)
+                {
+                    for (std::size_t cls = 0; cls < m_classes; ++cls)
+                    {
+                        setHasClass[set][cls] = ranges_contain(nfa.sets[set], m_boundaries[cls]);
+                    }
+                }
+
+                std::map<std::vector<int>, std::int32_t> known;
+                std::vector<std::vector<int>> pending;
+                auto intern = [&](std::vector<int> subset) -> std::int32_t
+                {
+                    if (subset.empty())
+                    {
+                        return -1;
+                    }
+                    auto itr = known.find(subset);
+                    if (itr != known.end())
+                    {
+                        return itr->second;
+                    }
+                    if ((known.size() >= max_dfa_states) || ((known.size() + 1) * m_classes > max_dfa_table))
+                    {
+                        throw unsupported_pattern{};
+                    }
+                    auto id = static_cast<std::int32_t>(known.size());
+                    m_accepting.push_back(std::binary_search(subset.begin(), subset.end(), nfa.accept));
+                    known.emplace(subset, id);
+                    pending.push_back(std::move(subset));
+                    return id;
+                };
+
+                intern(closure(nfa, { start }));
+                for (std::size_t id = 0; id < pending.size(); ++id)
+                {
+                    m_transitions.resize((id + 1) * m_classes, -1);
+                    for (std::size_t cls = 0; cls < m_classes; ++cls)
+                    {
+                        std::vector<int> next;
+                        for (auto s : pending[id])
+                        {
+                            auto& state = nfa.states[s];
+                            if ((state.set >= 0) && setHasClass[state.set][cls])
+                            {
+                                next.push_back(state.out1);
+                            }
+                        }
+                        // NOTE: intern may grow pending, so don't hold references into it across this call
+                        auto target = intern(closure(nfa, std::move(next)));
+                        m_transitions[id * m_classes + cls] = target;
+                    }
+                }
+            }
+
+            // Returns true if the whole input is accepted. With stopOnAccept, returns as soon as any prefix is.
+            bool run(std::wstring_view input, bool icase, bool stopOnAccept) const noexcept
+            {
+                std::int32_t state = 0;
+                if (stopOnAccept && m_accepting[state])
+                {
+                    return true;
+                }
+                for (auto ch : input)
+                {
+                    if (icase)
+                    {
+                        ch = fold_regex_char(ch);
+                    }
+                    auto value = static_cast<std::uint32_t>(ch);
+                    auto cls = (value < m_ascii.size()) ? m_ascii[value] : class_search(value);
+                    state = m_transitions[static_cast<std::size_t>(state) * m_classes + cls];
+                    if (state < 0)
+                    {
+                        return false;
+                    }
+                    if (stopOnAccept && m_accepting[state])
+                    {
+                        return true;
+                    }
+                }
+                return m_accepting[state];
+            }
+
+        private:
+
+            static std::vector<int> closure(const regex_nfa& nfa, std::vector<int> states)
+            {
+                std::vector<bool> seen(nfa.states.size());
+                std::vector<int> work = std::move(states);
+                std::vector<int> result;
+                while (!work.empty())
+                {
+                    auto s = work.back();
+                    work.pop_back();
+                    if ((s < 0) || seen[s])
+                    {
+                        continue;
+                    }
+                    seen[s] = true;
+
+                    auto& state = nfa.states[s];
+                    if (state.set >= 0 || s == nfa.accept)
+                    {
+                        result.push_back(s);
+                    }
+                    if (state.set < 0)
+                    {
+                        work.push_back(state.out1);
+                        work.push_back(state.out2);
+                    }
+                }
+                std::sort(result.begin(), result.end());
+                return result;
+            }
+
+            std::uint32_t class_search(std::uint32_t value) const noexcept
+            {
+                auto itr = std::upper_bound(m_boundaries.begin(), m_boundaries.end(), value);
+                return static_cast<std::uint32_t>(std::distance(m_boundaries.begin(), itr) - 1);
+            }
+
+            std::vector<std::uint32_t> m_boundaries;
+            std::size_t m_classes = 0;
+            std::array<std::uint32_t, 128> m_ascii = {};
+            std::vector<std::int32_t> m_transitions;
+            std::vector<bool> m_accepting;
+        };
+    }
+
+    class dfa_regex
+    {
+    public:
+
+        dfa_regex() = default;
+
+        explicit dfa_regex(std::wstring_view pattern, bool icase = false)
+        {
+            assign(pattern, icase);
+        }
+
+        // Compiles the pattern. Throws std::regex_error if the pattern is not valid ECMAScript syntax.
+        void assign(std::wstring_view pattern, bool icase = false)
+        {
+            auto compiled = std::make_shared<compiled_pattern>();
+            compiled->icase = icase;
+            try
+            {
+                details::regex_nfa nfa(pattern, icase);
+                compiled->anchored_end = nfa.anchored_end;
+                compiled->full = std::make_unique<details::regex_dfa>(nfa, nfa.match_start);
+                if (!nfa.anchored_start)
+                {
+                    compiled->search = std::make_unique<details::regex_dfa>(nfa, nfa.search_start);
+                }
+            }
+            catch (details::unsupported_pattern&)
+            {
+                compiled->full.reset();
+                compiled->search.reset();
+                auto flags = std::regex_constants::ECMAScript;
+                if (icase)
+                {
+                    flags |= std::regex_constants::icase;
+                }
+                compiled->fallback = std::make_unique<std::wregex>(pattern.data(), pattern.length(), flags);
+            }
+            m_compiled = std::move(compiled);
+        }
+
+        // Equivalent to std::regex_match: the pattern must match the entire input.
+        bool match(std::wstring_view input) const
+        {
+            if (!m_compiled)
+            {
+                return false;
+            }
+            if (m_compiled->full)
+            {
+                return m_compiled->full->run(input, m_compiled->icase, false);
+            }
+            return std::regex_match(input.begin(), input.end(), *m_compiled->fallback);
+        }
+
+        // Equivalent to std::regex_search: the pattern must match some part of the input.
+        bool search(std::wstring_view input) const
+        {
+            if (!m_compiled)
+            {
+                return false;
+            }
+            if (m_compiled->full)
+            {
+                auto& dfa = m_compiled->search ? *m_compiled->search : *m_compiled->full;
+                return dfa.run(input, m_compiled->icase, !m_compiled->anchored_end);
+            }
+            return std::regex_search(input.begin(), input.end(), *m_compiled->fallback);
+        }
+
+        // True if the pattern was compiled to a DFA, false if it is being handled by std::wregex
+        bool is_dfa() const noexcept
+        {
+            return m_compiled && m_compiled->full;
+        }
+
+    private:
+
+        // Shared so that copies of a compiled pattern are cheap; it is never modified after compilation
+        struct compiled_pattern
+        {
+            bool icase = false;
+            bool anchored_end = false;
+            std::unique_ptr<details::regex_dfa> full;
+            std::unique_ptr<details::regex_dfa> search;
+            std::unique_ptr<std::wregex> fallback;
+        };
+
+        std::shared_ptr<const compiled_pattern> m_compiled;
+    };
+}
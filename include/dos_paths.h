@@ -7,6 +7,7 @@
 #include <cassert>
 #include <cwctype>
 #include <string>
+#include <string_view>
 
 #include <windows.h>
 
@@ -131,19 +132,10 @@ namespace psf
             return is_path_separator(path[2]) ? dos_path_type::drive_absolute : dos_path_type::drive_relative;
         }
 
-        if constexpr (std::is_same_v<CharT, char>)
+        // Looked for through a view, so that classifying a path does not copy it
+        if (std::basic_string_view<CharT>(path).find(static_cast<CharT>(':')) != std::basic_string_view<CharT>::npos)
         {
-            if (std::string(path).find(":") != std::string::npos)
-            {
-                return dos_path_type::protocol;
-            }
-        }
-        else
-        {
-            if (std::wstring(path).find(L":") != std::wstring::npos)
-            {
-                return dos_path_type::protocol;
-            }
+            return dos_path_type::protocol;
         }
 
         // Otherwise assume that it's a relative path
@@ -0,0 +1,170 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) TMurgent Technologies, LLP. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+//
+// A case-insensitive set of file names, used to remember which names a merged directory enumeration has already
+// returned. It is an open addressing hash table of offsets into a single string that holds all of the names, so adding
+// a name costs no allocation of its own and lookups do not copy anything.
+//
+// Fold maps a character to the form used for comparison (e.g. lower case); two names are equal when they have the same
+// length and fold to the same characters.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cwctype>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace psf
+{
+    struct towlower_fold
+    {
+        wchar_t operator()(wchar_t ch) const noexcept
+        {
+            return static_cast<wchar_t>(std::towlower(ch));
+        }
+    };
+
+    template <typename Fold = towlower_fold>
+    class file_name_set
+    {
+    public:
+
+        explicit file_name_set(Fold fold = Fold{}) :
+            m_fold(fold)
+        {
+        }
+
+        bool empty() const noexcept
+        {
+            return m_count == 0;
+        }
+
+        std::size_t size() const noexcept
+        {
+            return m_count;
+        }
+
+        void clear() noexcept
+        {
+            m_slots.clear();
+            m_names.clear();
+            m_count = 0;
+        }
+
+        bool contains(std::wstring_view name) const
+        {
+            if (m_count == 0)
+            {
+                return false;
+            }
+            return m_slots[find_slot(name, hash(name))].length != empty_slot;
+        }
+
+        // Returns false if the name was already present
+        bool insert(std::wstring_view name)
+        {
+            if ((m_count + 1) * 2 > m_slots.size())
+            {
+                grow();
+            }
+
+            auto nameHash = hash(name);
+            auto& slot = m_slots[find_slot(name, nameHash)];
+            if (slot.length != empty_slot)
+            {
+                return false;
+            }
+
+            slot.offset = m_names.size();
+            slot.length = name.length();
+            slot.hash = nameHash;
+            m_names.append(name);
+            ++m_count;
+            return true;
+        }
+
+    private:
+
+        static constexpr std::size_t empty_slot = static_cast<std::size_t>(-1);
+
+        struct slot
+        {
+            std::size_t offset = 0;
+            std::size_t length = empty_slot;
+            std::size_t hash = 0;
+        };
+
+        // FNV-1a over the folded characters
+        std::size_t hash(std::wstring_view name) const noexcept
+        {
+            std::uint64_t result = 14695981039346656037ull;
+            for (auto ch : name)
+            {
+                result ^= static_cast<std::uint64_t>(m_fold(ch));
+                result *= 1099511628211ull;
+            }
+            return static_cast<std::size_t>(result);
+        }
+
+        bool equal(const slot& s, std::wstring_view name) const noexcept
+        {
+            if (s.length != name.length())
+            {
+                return false;
+            }
+            auto stored = m_names.data() + s.offset;
+            for (std::size_t i = 0; i < name.length(); ++i)
+            {
+                if (m_fold(stored[i]) != m_fold(name[i]))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // The slot holding name, or the empty slot where it would go. There is always at least one empty slot.
+        std::size_t find_slot(std::wstring_view name, std::size_t nameHash) const noexcept
+        {
+            auto mask = m_slots.size() - 1;
+            for (auto index = nameHash & mask; ; index = (index + 1) & mask)
+            {
+                auto& s = m_slots[index];
+                if ((s.length == empty_slot) || ((s.hash == nameHash) && equal(s, name)))
+                {
+                    return index;
+                }
+            }
+        }
+
+        void grow()
+        {
+            std::vector<slot> old;
+            old.swap(m_slots);
+            m_slots.resize(old.empty() ? 16 : old.size() * 2);
+
+            auto mask = m_slots.size() - 1;
+            for (auto& s : old)
+            {
+                if (s.length != empty_slot)
+                {
+                    auto index = s.hash & mask;
+                    while (m_slots[index].length != empty_slot)
+                    {
+                        index = (index + 1) & mask;
+                    }
+                    m_slots[index] = s;
+                }
+            }
+        }
+
+        Fold m_fold;
+        std::vector<slot> m_slots;
+        std::wstring m_names;
+        std::size_t m_count = 0;
+    };
+}
@@ -0,0 +1,62 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) TMurgent Technologies, LLP. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+//
+// The folders still to be listed by a tree scan that runs on several threads. Each thread pops a folder, lists it, and
+// hands back the sub-folders it found. A thread that runs out of folders waits until another one queues more, or until
+// no thread is listing a folder any more and so the scan is done. Listing a folder costs far more than taking the lock.
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace psf
+{
+    class folder_queue
+    {
+    public:
+        // The scan starts from 'root', usually the empty path relative to the folder being scanned
+        explicit folder_queue(std::wstring root = std::wstring()) : m_folders{ std::move(root) }
+        {
+        }
+
+        bool pop(std::wstring& folder)
+        {
+            std::unique_lock lock(m_mutex);
+            m_changed.wait(lock, [&] { return !m_folders.empty() || (m_busy == 0); });
+            if (m_folders.empty())
+            {
+                return false;
+            }
+            folder = std::move(m_folders.front());
+            m_folders.pop_front();
+            ++m_busy;
+            return true;
+        }
+
+        // Called once for every folder handed out by pop, with the sub-folders found in it
+        void finish(std::vector<std::wstring>& subFolders)
+        {
+            {
+                std::lock_guard lock(m_mutex);
+                std::move(subFolders.begin(), subFolders.end(), std::back_inserter(m_folders));
+                --m_busy;
+            }
+            subFolders.clear();
+            m_changed.notify_all();
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_changed;
+        std::deque<std::wstring> m_folders;
+        std::size_t m_busy = 0;
+    };
+}
@@ -0,0 +1,224 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) TMurgent Technologies, LLP. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+//
+// Small-buffer string storage for code that runs on every intercepted call. psf::inline_wstring keeps up to
+// InlineCapacity characters inside the object itself and only goes to the heap for longer strings, so that typical
+// paths (which fit in MAX_PATH) never allocate. psf::wzstring_view is a std::wstring_view that is known to be null
+// terminated, so that it can be handed to APIs that want a const wchar_t*.
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace psf
+{
+    class wzstring_view : public std::wstring_view
+    {
+    public:
+
+        constexpr wzstring_view() noexcept :
+            std::wstring_view(L"", 0)
+        {
+        }
+
+        // str[length] must be a null terminator
+        constexpr wzstring_view(const wchar_t* str, std::size_t length) noexcept :
+            std::wstring_view(str, length)
+        {
+        }
+
+        // Strings and string literals are null terminated already
+        wzstring_view(const std::wstring& str) noexcept :
+            std::wstring_view(str)
+        {
+        }
+
+        constexpr wzstring_view(const wchar_t* str) noexcept :
+            std::wstring_view(str)
+        {
+        }
+
+        constexpr const wchar_t* c_str() const noexcept
+        {
+            return data();
+        }
+    };
+
+    // A null terminated, growable wide character buffer; the storage moves to the heap only once the contents no
+    // longer fit into InlineCapacity characters (not counting the terminator).
+    template <std::size_t InlineCapacity>
+    class inline_wstring
+    {
+    public:
+
+        inline_wstring() noexcept
+        {
+            m_inline[0] = L'\0';
+        }
+
+        inline_wstring(const inline_wstring& other)
+        {
+            m_inline[0] = L'\0';
+            append(other.view());
+        }
+
+        // Heap storage is taken over; inline contents are copied
+        inline_wstring(inline_wstring&& other) noexcept
+        {
+            m_inline[0] = L'\0';
+            take(other);
+        }
+
+        inline_wstring& operator=(const inline_wstring& other)
+        {
+            if (this != &other)
+            {
+                clear();
+                append(other.view());
+            }
+            return *this;
+        }
+
+        inline_wstring& operator=(inline_wstring&& other) noexcept
+        {
+            if (this != &other)
+            {
+                m_heap.reset();
+                m_data = m_inline;
+                m_capacity = InlineCapacity;
+                take(other);
+            }
+            return *this;
+        }
+
+        const wchar_t* data() const noexcept
+        {
+            return m_data;
+        }
+
+        wchar_t* data() noexcept
+        {
+            return m_data;
+        }
+
+        const wchar_t* c_str() const noexcept
+        {
+            return m_data;
+        }
+
+        std::size_t size() const noexcept
+        {
+            return m_size;
+        }
+
+        std::size_t length() const noexcept
+        {
+            return m_size;
+        }
+
+        bool empty() const noexcept
+        {
+            return m_size == 0;
+        }
+
+        bool is_inline() const noexcept
+        {
+            return m_data == m_inline;
+        }
+
+        std::wstring_view view() const noexcept
+        {
+            return std::wstring_view(m_data, m_size);
+        }
+
+        // Keeps any heap storage for reuse
+        void clear() noexcept
+        {
+            m_size = 0;
+            m_data[0] = L'\0';
+        }
+
+        void reserve(std::size_t capacity)
+        {
+            if (capacity <= m_capacity)
+            {
+                return;
+            }
+
+            auto newCapacity = std::max(capacity, m_capacity * 2);
+            auto newStorage = std::make_unique<wchar_t[]>(newCapacity + 1);
+            std::copy(m_data, m_data + m_size + 1, newStorage.get());
+            m_heap = std::move(newStorage);
+            m_data = m_heap.get();
+            m_capacity = newCapacity;
+        }
+
+        void append(std::wstring_view str)
+        {
+            reserve(m_size + str.length());
+            std::copy(str.begin(), str.end(), m_data + m_size);
+            m_size += str.length();
+            m_data[m_size] = L'\0';
+        }
+
+        // Appends a range of characters, such as the native() text of a std::filesystem::path
+        template <typename InputIt>
+        void append(InputIt first, InputIt last)
+        {
+            reserve(m_size + static_cast<std::size_t>(std::distance(first, last)));
+            auto end = std::copy(first, last, m_data + m_size);
+            m_size = static_cast<std::size_t>(end - m_data);
+            m_data[m_size] = L'\0';
+        }
+
+        void push_back(wchar_t ch)
+        {
+            reserve(m_size + 1);
+            m_data[m_size++] = ch;
+            m_data[m_size] = L'\0';
+        }
+
+        // Shortens the contents to length characters
+        void truncate(std::size_t length) noexcept
+        {
+            if (length < m_size)
+            {
+                m_size = length;
+                m_data[m_size] = L'\0';
+            }
+        }
+
+    private:
+
+        void take(inline_wstring& other) noexcept
+        {
+            if (other.is_inline())
+            {
+                std::copy(other.m_data, other.m_data + other.m_size + 1, m_inline);
+            }
+            else
+            {
+                m_heap = std::move(other.m_heap);
+                m_data = m_heap.get();
+                m_capacity = other.m_capacity;
+                other.m_data = other.m_inline;
+                other.m_capacity = InlineCapacity;
+            }
+            m_size = other.m_size;
+            other.m_size = 0;
+            other.m_data[0] = L'\0';
+        }
+
+        wchar_t m_inline[InlineCapacity + 1];
+        std::unique_ptr<wchar_t[]> m_heap;
+        wchar_t* m_data = m_inline;
+        std::size_t m_size = 0;
+        std::size_t m_capacity = InlineCapacity;
+    };
+}
@@ -0,0 +1,133 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) TMurgent Technologies, LLP. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+//
+// Merges the listings of several directories ("layers") into one enumeration, the way the file fixups present a
+// redirected, a package and a native folder as a single folder. Layers are read in the order they were added, a whole
+// batch of entries at a time, and a name is only returned from the first layer that has it.
+//
+// A Source lists one layer. It provides an entry_type with a std::wstring_view name() member, and
+//      directory_batch_result read_batch(std::vector<entry_type>& batch)
+// which appends the next batch of entries to batch and returns entries, or returns end (appending nothing) once the
+// layer is exhausted or failed if it could not be read. Entries only need to stay valid until the next call to
+// read_batch on the same source, so a source may reuse one buffer for every batch.
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "file_name_set.h"
+
+namespace psf
+{
+    enum class directory_batch_result
+    {
+        entries,
+        end,
+        failed,
+    };
+
+    template <typename Source, typename Fold = towlower_fold>
+    class merged_directory_enumeration
+    {
+    public:
+
+        using entry_type = typename Source::entry_type;
+
+        explicit merged_directory_enumeration(Fold fold = Fold{}) :
+            m_returned(fold)
+        {
+        }
+
+        // Layers added first take priority over layers added later
+        void add_layer(Source source)
+        {
+            m_layers.push_back(std::move(source));
+        }
+
+        std::size_t layer_count() const noexcept
+        {
+            return m_layers.size();
+        }
+
+        Source& layer(std::size_t index) noexcept
+        {
+            return m_layers[index];
+        }
+
+        // The next entry, which stays valid until the following call, or nullptr once every layer is exhausted or when
+        // the current layer failed to read (see failed()). A failed read is retried by the next call.
+        const entry_type* next()
+        {
+            m_failed = false;
+            while (m_position == m_merged.size())
+            {
+                if (!merge_next_batch())
+                {
+                    return nullptr;
+                }
+            }
+            return &m_merged[m_position++];
+        }
+
+        bool failed() const noexcept
+        {
+            return m_failed;
+        }
+
+        // The layer that the last entry (or failure) came from
+        std::size_t current_layer() const noexcept
+        {
+            return m_current;
+        }
+
+    private:
+
+        bool merge_next_batch()
+        {
+            m_merged.clear();
+            m_position = 0;
+            while (m_current < m_layers.size())
+            {
+                m_batch.clear();
+                auto result = m_layers[m_current].read_batch(m_batch);
+                if (result == directory_batch_result::failed)
+                {
+                    m_failed = true;
+                    return false;
+                }
+                if (result == directory_batch_result::end)
+                {
+                    ++m_current;
+                    continue;
+                }
+
+                for (auto& entry : m_batch)
+                {
+                    if (m_returned.insert(entry.name()))
+                    {
+                        m_merged.push_back(entry);
+                    }
+                }
+                if (!m_merged.empty())
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        std::vector<Source> m_layers;
+        std::size_t m_current = 0;
+
+        // Entries of the current batch that were not hidden by an earlier layer, and the next one to return
+        std::vector<entry_type> m_batch;
+        std::vector<entry_type> m_merged;
+        std::size_t m_position = 0;
+        bool m_failed = false;
+
+        file_name_set<Fold> m_returned;
+    };
+}
@@ -0,0 +1,220 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) TMurgent Technologies, LLP. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+//
+// An in-memory listing of the files and folders of a directory tree that does not change while the process runs,
+// such as the package root. It answers "does this relative path exist, and is it a folder" without going to disk.
+//
+// The tree is stored as one entry per file or folder, in breadth first order, so the children of every folder are
+// contiguous and sorted by case-insensitive name; names live in a single string. Lookups walk the path one component
+// at a time with a binary search per folder.
+//
+// Lookups return entry_type::unknown for anything that the file system might resolve differently from a plain walk of
+// the names (".", "..", short 8.3 names, trailing dots or spaces, stream or wildcard syntax); callers should then ask
+// the file system.
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cwctype>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace psf
+{
+    class package_file_index
+    {
+    public:
+
+        enum class entry_type
+        {
+            unknown,
+            missing,
+            file,
+            directory,
+        };
+
+        // Builds the index. enumerate(std::wstring_view relativeFolder, auto&& add) must call
+        // add(std::wstring_view name, bool isDirectory) for every entry of the folder (other than "." and "..") and
+        // return true, or return false if the folder could not be listed. relativeFolder is empty for the root and
+        // uses '\' separators. Returns false, leaving the index empty, if a folder could not be listed or the tree has
+        // more than maxEntries entries.
+        template <typename Enumerate>
+        bool build(Enumerate&& enumerate, std::size_t maxEntries)
+        {
+            clear();
+            m_entries.push_back(entry{ 0, 0, true, 0, 0 });
+
+            // Only needed to rebuild the folder paths while building
+            std::vector<std::uint32_t> parents{ 0 };
+
+            std::vector<std::pair<std::wstring, bool>> children;
+            std::wstring folder;
+            for (std::size_t current = 0; current < m_entries.size(); ++current)
+            {
+                if (!m_entries[current].is_directory)
+                {
+                    continue;
+                }
+
+                children.clear();
+                relative_path_of(current, parents, folder);
+                bool listed = enumerate(std::wstring_view(folder), [&](std::wstring_view name, bool isDirectory)
+                {
+                    children.emplace_back(std::wstring(name), isDirectory);
+                });
+                if (!listed || (m_entries.size() + children.size() > maxEntries))
+                {
+                    clear();
+                    return false;
+                }
+
+                std::sort(children.begin(), children.end(), [](auto& lhs, auto& rhs)
+                {
+                    return compare_folded(lhs.first, rhs.first) < 0;
+                });
+                m_entries[current].first_child = static_cast<std::uint32_t>(m_entries.size());
+                for (auto& [name, isDirectory] : children)
+                {
+                    m_entries.push_back(entry{ static_cast<std::uint32_t>(m_names.size()), static_cast<std::uint32_t>(name.length()), isDirectory, 0, 0 });
+                    parents.push_back(static_cast<std::uint32_t>(current));
+                    m_names.append(name);
+                }
+                m_entries[current].child_count = static_cast<std::uint32_t>(children.size());
+            }
+
+            m_built = true;
+            return true;
+        }
+
+        bool built() const noexcept
+        {
+            return m_built;
+        }
+
+        std::size_t size() const noexcept
+        {
+            return m_built ? m_entries.size() - 1 : 0;
+        }
+
+        void clear()
+        {
+            m_entries.clear();
+            m_names.clear();
+            m_built = false;
+        }
+
+        // relativePath may use either separator; an empty path is the root folder.
+        entry_type find(std::wstring_view relativePath) const
+        {
+            if (!m_built)
+            {
+                return entry_type::unknown;
+            }
+
+            std::size_t current = 0;
+            while (!relativePath.empty())
+            {
+                auto end = relativePath.find_first_of(L"\\/");
+                auto component = relativePath.substr(0, end);
+                relativePath = (end == std::wstring_view::npos) ? std::wstring_view{} : relativePath.substr(end + 1);
+                if (!is_plain_component(component) || ((end != std::wstring_view::npos) && relativePath.empty()))
+                {
+                    return entry_type::unknown;
+                }
+
+                auto& folder = m_entries[current];
+                if (!folder.is_directory)
+                {
+                    return entry_type::missing;
+                }
+
+                auto first = m_entries.begin() + folder.first_child;
+                auto last = first + folder.child_count;
+                auto itr = std::lower_bound(first, last, component, [&](const entry& e, std::wstring_view value)
+                {
+                    return compare_folded(name_of(e), value) < 0;
+                });
+                if ((itr == last) || (compare_folded(name_of(*itr), component) != 0))
+                {
+                    return entry_type::missing;
+                }
+                current = static_cast<std::size_t>(itr - m_entries.begin());
+            }
+
+            return m_entries[current].is_directory ? entry_type::directory : entry_type::file;
+        }
+
+    private:
+
+        struct entry
+        {
+            std::uint32_t name_offset;
+            std::uint32_t name_length;
+            bool is_directory;
+            std::uint32_t first_child;
+            std::uint32_t child_count;
+        };
+
+        static wchar_t fold(wchar_t ch) noexcept
+        {
+            return static_cast<wchar_t>(std::towlower(ch));
+        }
+
+        std::wstring_view name_of(const entry& e) const noexcept
+        {
+            return std::wstring_view(m_names.data() + e.name_offset, e.name_length);
+        }
+
+        // Case-insensitive three way compare
+        static int compare_folded(std::wstring_view lhs, std::wstring_view rhs) noexcept
+        {
+            auto count = std::min(lhs.length(), rhs.length());
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                auto l = fold(lhs[i]);
+                auto r = fold(rhs[i]);
+                if (l != r)
+                {
+                    return (l < r) ? -1 : 1;
+                }
+            }
+            return (lhs.length() == rhs.length()) ? 0 : (lhs.length() < rhs.length()) ? -1 : 1;
+        }
+
+        static bool is_plain_component(std::wstring_view component) noexcept
+        {
+            if (component.empty() || (component.back() == L'.') || (component.back() == L' '))
+            {
+                return false;
+            }
+            return component.find_first_of(L"~:*?\"<>|") == std::wstring_view::npos;
+        }
+
+        void relative_path_of(std::size_t index, const std::vector<std::uint32_t>& parents, std::wstring& path) const
+        {
+            path.clear();
+            std::vector<std::size_t> chain;
+            for (auto i = index; i != 0; i = parents[i])
+            {
+                chain.push_back(i);
+            }
+            for (auto itr = chain.rbegin(); itr != chain.rend(); ++itr)
+            {
+                if (!path.empty())
+                {
+                    path.push_back(L'\\');
+                }
+                path.append(name_of(m_entries[*itr]));
+            }
+        }
+
+        std::vector<entry> m_entries;
+        std::wstring m_names;
+        bool m_built = false;
+    };
+}
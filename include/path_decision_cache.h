@@ -0,0 +1,370 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) TMurgent Technologies, LLP. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+//
+// A bounded LRU cache of decisions made about file paths (e.g. "should this path be redirected, and where to"),
+// meant to be used as a thread_local so that lookups never take a lock. Every entry remembers the paths that its
+// decision depends upon. When a fixup changes the file system it records the changed path in a process wide
+// path_invalidation_log; each cache replays the log on its next use and drops the entries that depend on something
+// beneath the parent folder of a changed path, or on one of its ancestors (which might have just been created).
+//
+// The cache never touches the file system itself.
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cwctype>
+#include <initializer_list>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace psf
+{
+    namespace details
+    {
+        inline std::wstring_view strip_device_prefix(std::wstring_view path) noexcept
+        {
+            if ((path.length() >= 4) && (path[0] == L'\\') && (path[1] == L'\\') &&
+                ((path[2] == L'?') || (path[2] == L'.')) && (path[3] == L'\\'))
+            {
+                path.remove_prefix(4);
+            }
+            return path;
+        }
+
+        inline bool is_cache_path_separator(wchar_t ch) noexcept
+        {
+            return (ch == L'\\') || (ch == L'/');
+        }
+
+        inline std::wstring_view trim_trailing_separators(std::wstring_view path) noexcept
+        {
+            while (!path.empty() && is_cache_path_separator(path.back()))
+            {
+                path.remove_suffix(1);
+            }
+            return path;
+        }
+
+        // True if path is folder, or is beneath it. Case insensitive, either separator.
+        inline bool path_is_under(std::wstring_view path, std::wstring_view folder) noexcept
+        {
+            path = trim_trailing_separators(strip_device_prefix(path));
+            folder = trim_trailing_separators(strip_device_prefix(folder));
+            if (folder.empty() || (path.length() < folder.length()))
+            {
+                return false;
+            }
+            for (std::size_t i = 0; i < folder.length(); ++i)
+            {
+                if ((std::towlower(path[i]) != std::towlower(folder[i])) &&
+                    !(is_cache_path_separator(path[i]) && is_cache_path_separator(folder[i])))
+                {
+                    return false;
+                }
+            }
+            return (path.length() == folder.length()) || is_cache_path_separator(path[folder.length()]);
+        }
+
+        inline std::wstring_view parent_path_of(std::wstring_view path) noexcept
+        {
+            path = trim_trailing_separators(strip_device_prefix(path));
+            auto pos = path.find_last_of(L"\\/");
+            return (pos == std::wstring_view::npos) ? std::wstring_view{} : path.substr(0, pos);
+        }
+
+        // Would a decision that depends on dependentPath be affected by a change to changedPath?
+        inline bool path_change_affects(std::wstring_view changedPath, std::wstring_view dependentPath) noexcept
+        {
+            if (dependentPath.empty())
+            {
+                return false;
+            }
+            auto parent = parent_path_of(changedPath);
+            return (parent.empty() ? path_is_under(dependentPath, changedPath) : path_is_under(dependentPath, parent)) ||
+                path_is_under(changedPath, dependentPath);
+        }
+    }
+
+    // Process wide record of file system changes made by the fixups. Writers take a lock; readers only take it when
+    // the sequence number shows that there is something new to replay.
+    class path_invalidation_log
+    {
+    public:
+
+        static constexpr std::size_t capacity = 1024;
+        static constexpr std::size_t max_tracked_subtrees = 256;
+
+        // Records that path has been created, deleted, or otherwise changed.
+        void invalidate(std::wstring_view path)
+        {
+            if (path.empty())
+            {
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_changes[m_next % capacity].assign(details::strip_device_prefix(path));
+
+            std::wstring subtree(details::parent_path_of(path));
+            std::transform(subtree.begin(), subtree.end(), subtree.begin(), [](wchar_t ch) { return static_cast<wchar_t>(std::towlower(ch)); });
+            auto itr = m_subtreeCounts.find(subtree);
+            if (itr != m_subtreeCounts.end())
+            {
+                ++itr->second;
+            }
+            else if (m_subtreeCounts.size() < max_tracked_subtrees)
+            {
+                m_subtreeCounts.emplace(std::move(subtree), 1);
+            }
+            else
+            {
+                ++m_untrackedSubtreeCount;
+            }
+
+            ++m_next;
+            m_sequence.store(m_next, std::memory_order_release);
+        }
+
+        std::uint64_t sequence() const noexcept
+        {
+            return m_sequence.load(std::memory_order_acquire);
+        }
+
+        // Calls fn(std::wstring_view changedPath) for the changes numbered [from, to). Returns false if some of them
+        // have already been overwritten, in which case the caller has to assume that anything may have changed.
+        template <typename Fn>
+        bool replay(std::uint64_t from, std::uint64_t to, Fn&& fn) const
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            if (m_next - from > capacity)
+            {
+                return false;
+            }
+            for (auto i = from; i < to; ++i)
+            {
+                fn(std::wstring_view(m_changes[i % capacity]));
+            }
+            return true;
+        }
+
+        // Calls fn(std::wstring_view subtree, std::size_t count) for each folder that has seen changes, plus one call
+        // with an empty subtree for changes that were not tracked individually.
+        template <typename Fn>
+        void for_each_subtree_count(Fn&& fn) const
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            for (auto& [subtree, count] : m_subtreeCounts)
+            {
+                fn(std::wstring_view(subtree), count);
+            }
+            if (m_untrackedSubtreeCount > 0)
+            {
+                fn(std::wstring_view{}, m_untrackedSubtreeCount);
+            }
+        }
+
+        // Counters shared by every cache that uses this log
+        std::atomic<std::uint64_t> hits{ 0 };
+        std::atomic<std::uint64_t> misses{ 0 };
+        std::atomic<std::uint64_t> invalidated_entries{ 0 };
+        std::atomic<std::uint64_t> flushes{ 0 };
+
+    private:
+
+        mutable std::mutex m_lock;
+        std::wstring m_changes[capacity];
+        std::uint64_t m_next = 0;
+        std::atomic<std::uint64_t> m_sequence{ 0 };
+        std::map<std::wstring, std::size_t> m_subtreeCounts;
+        std::size_t m_untrackedSubtreeCount = 0;
+    };
+
+    template <typename Value>
+    class path_decision_cache
+    {
+    public:
+
+        path_decision_cache(path_invalidation_log& log, std::size_t capacity) :
+            m_log(log),
+            m_capacity(capacity),
+            m_seen(log.sequence())
+        {
+        }
+
+        path_decision_cache(const path_decision_cache&) = delete;
+        path_decision_cache& operator=(const path_decision_cache&) = delete;
+
+        std::size_t capacity() const noexcept
+        {
+            return m_capacity;
+        }
+
+        std::size_t size() const noexcept
+        {
+            return m_entries.size();
+        }
+
+        // The sequence number to pass to insert; read it before starting to compute the decision.
+        std::uint64_t sequence() const noexcept
+        {
+            return m_log.sequence();
+        }
+
+        // Returns the cached decision, or nullptr. The pointer is only valid until the next call on this cache.
+        const Value* find(std::wstring_view path, std::uint32_t flags)
+        {
+            synchronize();
+            make_key(path, flags);
+            auto itr = m_index.find(m_key);
+            if (itr == m_index.end())
+            {
+                m_log.misses.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+
+            m_log.hits.fetch_add(1, std::memory_order_relaxed);
+            m_entries.splice(m_entries.begin(), m_entries, itr->second);
+            return &itr->second->value;
+        }
+
+        // Adds a decision that was computed after sequence() returned observedSequence. dependentPaths lists every
+        // path whose existence was used to reach the decision; the decision is not cached if one of them changed
+        // while it was being computed.
+        void insert(std::wstring_view path, std::uint32_t flags, Value value, std::initializer_list<std::wstring_view> dependentPaths, std::uint64_t observedSequence)
+        {
+            if (m_capacity == 0)
+            {
+                return;
+            }
+
+            synchronize();
+
+            entry newEntry{ std::wstring{}, std::move(value), {} };
+            newEntry.dependent_paths.emplace_back(details::strip_device_prefix(path));
+            for (auto& dependentPath : dependentPaths)
+            {
+                if (!dependentPath.empty())
+                {
+                    newEntry.dependent_paths.emplace_back(details::strip_device_prefix(dependentPath));
+                }
+            }
+
+            if (observedSequence != m_seen)
+            {
+                bool affected = false;
+                bool complete = m_log.replay(observedSequence, m_seen, [&](std::wstring_view changedPath)
+                {
+                    affected = affected || depends_on(newEntry, changedPath);
+                });
+                if (affected || !complete)
+                {
+                    return;
+                }
+            }
+
+            make_key(path, flags);
+            auto itr = m_index.find(m_key);
+            if (itr != m_index.end())
+            {
+                m_entries.erase(itr->second);
+                m_index.erase(itr);
+            }
+
+            newEntry.key = m_key;
+            m_entries.push_front(std::move(newEntry));
+            m_index.emplace(m_entries.front().key, m_entries.begin());
+
+            while (m_entries.size() > m_capacity)
+            {
+                m_index.erase(m_entries.back().key);
+                m_entries.pop_back();
+            }
+        }
+
+        void clear()
+        {
+            m_index.clear();
+            m_entries.clear();
+        }
+
+    private:
+
+        struct entry
+        {
+            std::wstring key;
+            Value value;
+            std::vector<std::wstring> dependent_paths;
+        };
+
+        static bool depends_on(const entry& e, std::wstring_view changedPath) noexcept
+        {
+            return std::any_of(e.dependent_paths.begin(), e.dependent_paths.end(), [&](const std::wstring& dependentPath)
+            {
+                return details::path_change_affects(changedPath, dependentPath);
+            });
+        }
+
+        // Applies any changes logged since this cache last looked
+        void synchronize()
+        {
+            auto current = m_log.sequence();
+            if (current == m_seen)
+            {
+                return;
+            }
+
+            bool complete = m_log.replay(m_seen, current, [&](std::wstring_view changedPath)
+            {
+                for (auto itr = m_entries.begin(); itr != m_entries.end(); )
+                {
+                    if (depends_on(*itr, changedPath))
+                    {
+                        m_index.erase(itr->key);
+                        itr = m_entries.erase(itr);
+                        m_log.invalidated_entries.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    else
+                    {
+                        ++itr;
+                    }
+                }
+            });
+            if (!complete)
+            {
+                clear();
+                m_log.flushes.fetch_add(1, std::memory_order_relaxed);
+            }
+            m_seen = current;
+        }
+
+        // The key is the flags followed by the case-folded path; m_key is reused to avoid allocating on lookups
+        void make_key(std::wstring_view path, std::uint32_t flags)
+        {
+            path = details::strip_device_prefix(path);
+            m_key.clear();
+            m_key.push_back(static_cast<wchar_t>(flags & 0xFFFF));
+            m_key.push_back(static_cast<wchar_t>(flags >> 16));
+            for (auto ch : path)
+            {
+                m_key.push_back(details::is_cache_path_separator(ch) ? L'\\' : static_cast<wchar_t>(std::towlower(ch)));
+            }
+        }
+
+        path_invalidation_log& m_log;
+        std::size_t m_capacity;
+        std::uint64_t m_seen;
+        std::list<entry> m_entries;
+        std::unordered_map<std::wstring, typename std::list<entry>::iterator> m_index;
+        std::wstring m_key;
+    };
+}
@@ -0,0 +1,213 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) TMurgent Technologies, LLP. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+//
+// A component trie over case-folded path prefixes. Each node represents one path component (the text between two
+// separators) and can carry any number of values. Building the trie is done once, at configuration time; lookups
+// then walk the requested path one component at a time, so their cost is proportional to the depth of the path and
+// not to the number of prefixes that were inserted.
+//
+// Matching is equivalent to the "starts with, case insensitive, followed by a separator or the end of the string"
+// test used throughout the fixups (see path_relative_to), treating '\' and '/' as the same character. A prefix such
+// as "C:\foo" therefore matches "c:/FOO" and "C:\foo\bar" but not "C:\foobar".
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cwctype>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace psf
+{
+    template <typename T>
+    class path_prefix_trie
+    {
+    public:
+
+        // Adds a value under the given prefix. Values under the same prefix are kept in insertion order.
+        void insert(std::wstring_view prefix, T value)
+        {
+            if (m_nodes.empty())
+            {
+                m_nodes.emplace_back();
+            }
+
+            std::size_t nodeIndex = 0;
+            for_each_component(prefix, [&](std::wstring_view component, std::size_t)
+            {
+                nodeIndex = child_for_insert(nodeIndex, component);
+                return true;
+            });
+            m_nodes[nodeIndex].values.push_back(std::move(value));
+            ++m_size;
+        }
+
+        bool empty() const noexcept
+        {
+            return m_size == 0;
+        }
+
+        std::size_t size() const noexcept
+        {
+            return m_size;
+        }
+
+        void clear() noexcept
+        {
+            m_nodes.clear();
+            m_size = 0;
+        }
+
+        // Invokes fn(const std::vector<T>& values, std::size_t relativeOffset) for every inserted prefix of path, from
+        // the shortest to the longest. relativeOffset is the index in path just past the prefix and any single
+        // separator that follows it. If fn returns false, the walk stops.
+        template <typename Fn>
+        void for_each_prefix(std::wstring_view path, Fn&& fn) const
+        {
+            if (m_nodes.empty())
+            {
+                return;
+            }
+
+            std::size_t nodeIndex = 0;
+            for_each_component(path, [&](std::wstring_view component, std::size_t nextOffset)
+            {
+                nodeIndex = find_child(nodeIndex, component);
+                if (nodeIndex == npos)
+                {
+                    return false;
+                }
+
+                auto& node = m_nodes[nodeIndex];
+                if (!node.values.empty())
+                {
+                    return fn(node.values, nextOffset);
+                }
+                return true;
+            });
+        }
+
+        // Returns the values stored on the longest inserted prefix of path, or nullptr if no prefix matches.
+        const std::vector<T>* longest_prefix(std::wstring_view path, std::size_t* relativeOffset = nullptr) const
+        {
+            const std::vector<T>* result = nullptr;
+            for_each_prefix(path, [&](const std::vector<T>& values, std::size_t offset)
+            {
+                result = &values;
+                if (relativeOffset)
+                {
+                    *relativeOffset = offset;
+                }
+                return true;
+            });
+            return result;
+        }
+
+    private:
+
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+        struct node
+        {
+            // Case-folded component text and child node index, sorted by the component text
+            std::vector<std::pair<std::wstring, std::size_t>> children;
+            std::vector<T> values;
+        };
+
+        static bool is_separator(wchar_t ch) noexcept
+        {
+            return (ch == L'\\') || (ch == L'/');
+        }
+
+        static wchar_t fold(wchar_t ch) noexcept
+        {
+            return static_cast<wchar_t>(std::towlower(ch));
+        }
+
+        // Case-insensitive three way compare of a stored (already folded) component against a path component
+        static int compare_folded(const std::wstring& stored, std::wstring_view component) noexcept
+        {
+            auto count = std::min(stored.length(), component.length());
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                auto rhs = fold(component[i]);
+                if (stored[i] != rhs)
+                {
+                    return (stored[i] < rhs) ? -1 : 1;
+                }
+            }
+            return (stored.length() == component.length()) ? 0 : (stored.length() < component.length()) ? -1 : 1;
+        }
+
+        // Splits on every single separator (so "a\\b" has an empty middle component, exactly like a character by
+        // character comparison would see it). A trailing separator yields a final empty component.
+        template <typename Fn>
+        static void for_each_component(std::wstring_view path, Fn&& fn)
+        {
+            std::size_t start = 0;
+            while (start <= path.length())
+            {
+                auto end = start;
+                while ((end < path.length()) && !is_separator(path[end]))
+                {
+                    ++end;
+                }
+
+                auto nextOffset = (end < path.length()) ? end + 1 : end;
+                if (!fn(path.substr(start, end - start), nextOffset))
+                {
+                    return;
+                }
+
+                if (end >= path.length())
+                {
+                    return;
+                }
+                start = end + 1;
+            }
+        }
+
+        std::size_t find_child(std::size_t nodeIndex, std::wstring_view component) const
+        {
+            auto& children = m_nodes[nodeIndex].children;
+            auto itr = std::lower_bound(children.begin(), children.end(), component, [](auto& child, std::wstring_view value)
+            {
+                return compare_folded(child.first, value) < 0;
+            });
+            if ((itr != children.end()) && (compare_folded(itr->first, component) == 0))
+            {
+                return itr->second;
+            }
+            return npos;
+        }
+
+        std::size_t child_for_insert(std::size_t nodeIndex, std::wstring_view component)
+        {
+            auto existing = find_child(nodeIndex, component);
+            if (existing != npos)
+            {
+                return existing;
+            }
+
+            std::wstring folded(component);
+            std::transform(folded.begin(), folded.end(), folded.begin(), fold);
+
+            auto newIndex = m_nodes.size();
+            m_nodes.emplace_back();
+
+            auto& children = m_nodes[nodeIndex].children;
+            auto itr = std::lower_bound(children.begin(), children.end(), folded, [](auto& child, const std::wstring& value)
+            {
+                return child.first < value;
+            });
+            children.emplace(itr, std::move(folded), newIndex);
+            return newIndex;
+        }
+
+        std::vector<node> m_nodes;
+        std::size_t m_size = 0;
+    };
+}
@@ -0,0 +1,231 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) TMurgent Technologies, LLP. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+//
+// Works out which architecture a PE image (exe or dll) was built for by reading parts of the file, so that callers
+// need not map the image to find out. For native images only the DOS header and the file header are looked at; a read
+// of the first page of the file is enough.
+//
+// Managed images are marked as x86 in the file header even when they load into a process of either bitness. For those
+// the CLR header is found through the data directories and the section table, and its flags decide: an image that
+// only contains IL and does not require a 32-bit process (or merely prefers one) is reported as any_cpu, while a mixed
+// mode image, or one marked 32BITREQUIRED, is reported as x86.
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace psf
+{
+    enum class pe_architecture
+    {
+        unknown,
+        x86,
+        x64,
+        arm64,
+        any_cpu,
+    };
+
+    namespace details
+    {
+        inline std::uint32_t read_pe_value(const std::uint8_t* data, std::size_t size) noexcept
+        {
+            std::uint32_t result = 0;
+            for (std::size_t i = size; i > 0; --i)
+            {
+                result = (result << 8) | data[i - 1];
+            }
+            return result;
+        }
+
+        // Reads from the first page of the file when it can, and from the file itself otherwise
+        template <typename ReadAt>
+        class pe_file_reader
+        {
+        public:
+            pe_file_reader(ReadAt& readAt) : m_readAt(readAt)
+            {
+                m_size = m_readAt(0, m_page, sizeof(m_page));
+            }
+
+            const std::uint8_t* page() const noexcept
+            {
+                return m_page;
+            }
+
+            std::size_t page_size() const noexcept
+            {
+                return m_size;
+            }
+
+            bool read(std::uint64_t offset, void* buffer, std::size_t count)
+            {
+                if ((offset <= m_size) && (m_size - offset >= count))
+                {
+                    std::memcpy(buffer, m_page + offset, count);
+                    return true;
+                }
+                return m_readAt(offset, buffer, count) == count;
+            }
+
+            bool read_value(std::uint64_t offset, std::size_t size, std::uint32_t& value)
+            {
+                std::uint8_t bytes[4];
+                if (!read(offset, bytes, size))
+                {
+                    return false;
+                }
+                value = read_pe_value(bytes, size);
+                return true;
+            }
+
+        private:
+            ReadAt& m_readAt;
+            std::uint8_t m_page[4096];
+            std::size_t m_size;
+        };
+    }
+
+    // readAt(std::uint64_t offset, void* buffer, std::size_t count) reads from the file, returning the number of bytes
+    // read. Anything that is not a well formed PE image comes back as unknown.
+    template <typename ReadAt>
+    inline pe_architecture read_pe_architecture(ReadAt&& readAt)
+    {
+        constexpr std::size_t dosHeaderSize = 0x40;
+        constexpr std::size_t fileHeaderSize = 20;
+        constexpr std::size_t sectionHeaderSize = 40;
+        constexpr std::uint32_t comDescriptorDirectory = 14;
+        constexpr std::uint32_t comImageFlagsIlOnly = 0x1;
+        constexpr std::uint32_t comImageFlags32BitRequired = 0x2;
+        constexpr std::uint32_t comImageFlags32BitPreferred = 0x20000;
+
+        details::pe_file_reader<std::remove_reference_t<ReadAt>> file(readAt);
+        auto data = file.page();
+        auto size = file.page_size();
+        if ((size < dosHeaderSize) || (data[0] != 'M') || (data[1] != 'Z'))
+        {
+            return pe_architecture::unknown;
+        }
+
+        std::size_t ntHeaders = details::read_pe_value(data + 0x3C, 4);
+        if ((ntHeaders > size) || (size - ntHeaders < 4 + fileHeaderSize) ||
+            (data[ntHeaders] != 'P') || (data[ntHeaders + 1] != 'E') || (data[ntHeaders + 2] != 0) || (data[ntHeaders + 3] != 0))
+        {
+            return pe_architecture::unknown;
+        }
+
+        auto fileHeader = data + ntHeaders + 4;
+        auto machine = details::read_pe_value(fileHeader, 2);
+        switch (machine)
+        {
+        case 0x8664:    // IMAGE_FILE_MACHINE_AMD64
+            return pe_architecture::x64;
+        case 0xAA64:    // IMAGE_FILE_MACHINE_ARM64
+            return pe_architecture::arm64;
+        case 0x014C:    // IMAGE_FILE_MACHINE_I386
+            break;
+        default:
+            return pe_architecture::unknown;
+        }
+
+        // An x86 image with a CLR header is a managed image
+        std::size_t sectionCount = details::read_pe_value(fileHeader + 2, 2);
+        std::size_t optionalHeader = ntHeaders + 4 + fileHeaderSize;
+        std::size_t optionalHeaderSize = details::read_pe_value(fileHeader + 16, 2);
+        if ((optionalHeaderSize < 2) || (size - optionalHeader < optionalHeaderSize))
+        {
+            return pe_architecture::x86;
+        }
+
+        std::size_t rvaCountOffset;
+        switch (details::read_pe_value(data + optionalHeader, 2))
+        {
+        case 0x10B:     // IMAGE_NT_OPTIONAL_HDR32_MAGIC
+            rvaCountOffset = 92;
+            break;
+        case 0x20B:     // IMAGE_NT_OPTIONAL_HDR64_MAGIC
+            rvaCountOffset = 108;
+            break;
+        default:
+            return pe_architecture::x86;
+        }
+
+        auto directoryOffset = rvaCountOffset + 4 + comDescriptorDirectory * 8;
+        if ((optionalHeaderSize < directoryOffset + 8) ||
+            (details::read_pe_value(data + optionalHeader + rvaCountOffset, 4) <= comDescriptorDirectory))
+        {
+            return pe_architecture::x86;
+        }
+        auto corHeaderRva = details::read_pe_value(data + optionalHeader + directoryOffset, 4);
+        if (corHeaderRva == 0)
+        {
+            return pe_architecture::x86;
+        }
+
+        // Find the section that holds the CLR header, to turn its address in memory into an offset in the file
+        std::uint64_t corHeaderOffset = 0;
+        bool mapped = false;
+        auto sectionTable = static_cast<std::uint64_t>(optionalHeader) + optionalHeaderSize;
+        for (std::size_t i = 0; i < sectionCount; ++i)
+        {
+            std::uint8_t section[sectionHeaderSize];
+            if (!file.read(sectionTable + i * sectionHeaderSize, section, sizeof(section)))
+            {
+                return pe_architecture::unknown;
+            }
+            auto virtualSize = details::read_pe_value(section + 8, 4);
+            auto virtualAddress = details::read_pe_value(section + 12, 4);
+            auto rawSize = details::read_pe_value(section + 16, 4);
+            auto rawOffset = details::read_pe_value(section + 20, 4);
+            auto extent = std::max(virtualSize, rawSize);
+            if ((corHeaderRva >= virtualAddress) && (corHeaderRva - virtualAddress < extent))
+            {
+                if (corHeaderRva - virtualAddress >= rawSize)
+                {
+                    // In the part of the section that is only zero filled in memory
+                    return pe_architecture::unknown;
+                }
+                corHeaderOffset = static_cast<std::uint64_t>(rawOffset) + (corHeaderRva - virtualAddress);
+                mapped = true;
+                break;
+            }
+        }
+
+        // IMAGE_COR20_HEADER::Flags
+        std::uint32_t flags;
+        if (!mapped || !file.read_value(corHeaderOffset + 16, 4, flags))
+        {
+            return pe_architecture::unknown;
+        }
+        if ((flags & comImageFlagsIlOnly) == 0)
+        {
+            // Mixed mode: holds x86 code
+            return pe_architecture::x86;
+        }
+        if ((flags & comImageFlags32BitRequired) && !(flags & comImageFlags32BitPreferred))
+        {
+            return pe_architecture::x86;
+        }
+        return pe_architecture::any_cpu;
+    }
+
+    // data/size is the start of the file, or all of it; a managed image whose CLR header is not within it comes back
+    // as unknown
+    inline pe_architecture read_pe_architecture(const std::uint8_t* data, std::size_t size) noexcept
+    {
+        return read_pe_architecture([data, size](std::uint64_t offset, void* buffer, std::size_t count) -> std::size_t
+        {
+            if (offset >= size)
+            {
+                return 0;
+            }
+            auto available = std::min<std::uint64_t>(count, size - offset);
+            std::memcpy(buffer, data + offset, static_cast<std::size_t>(available));
+            return static_cast<std::size_t>(available);
+        });
+    }
+}
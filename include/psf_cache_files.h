@@ -0,0 +1,214 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) TMurgent Technologies, LLP. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+//
+// The files that PSF keeps in the package's LocalCache so that one process of the package can share its work with the
+// others: the compiled config, the package file index and the dll index, along with logs and timelines. Cache files are
+// replaced whole, never updated in place, so a process that maps one always sees a complete file.
+//
+// A cache file is only as trustworthy as the folder it lives in, which the package itself can write to. What is read
+// back from one is checked before it is used, and anything found by walking the package is only shared this way for
+// packages whose files cannot change under it.
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <windows.h>
+#include <appmodel.h>
+
+#include "known_folders.h"
+
+namespace psf
+{
+    // <LocalAppData>\Packages\<packageFamilyName>\LocalCache\Local\Microsoft\PSF\<relativePath>
+    inline std::filesystem::path local_cache_path(std::wstring_view packageFamilyName, const std::filesystem::path& relativePath)
+    {
+        return known_folder(FOLDERID_LocalAppData) / std::filesystem::path(L"Packages") / packageFamilyName /
+            LR"(LocalCache\Local\Microsoft\PSF)" / relativePath;
+    }
+
+    // Packages installed from the store or an msix are staged read-only; a package registered from a development folder
+    // is not, and its files can change between (or during) runs. An unknown origin counts as a development folder.
+    inline bool is_development_package(const wchar_t* packageFullName) noexcept
+    {
+        PackageOrigin origin;
+        if (::GetStagedPackageOrigin(packageFullName, &origin) != ERROR_SUCCESS)
+        {
+            return true;
+        }
+        return (origin == PackageOrigin_Unknown) || (origin == PackageOrigin_DeveloperUnsigned) || (origin == PackageOrigin_DeveloperSigned);
+    }
+
+    // Changes whenever a file or folder directly in the folder is added, removed or renamed; 0 if it cannot be read
+    inline std::uint64_t folder_write_time(const std::filesystem::path& path) noexcept
+    {
+        WIN32_FILE_ATTRIBUTE_DATA data;
+        if (!::GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &data))
+        {
+            return 0;
+        }
+        return (static_cast<std::uint64_t>(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+    }
+
+    // What a walk of the package records for a file: one or more names separated by '\', with no root, drive, stream, or
+    // empty, "." or ".." component, so that joined to the package root it names something below it
+    inline bool is_package_relative_path(std::wstring_view path) noexcept
+    {
+        if (path.empty() || (path.find_first_of(L":/") != std::wstring_view::npos))
+        {
+            return false;
+        }
+
+        for (std::size_t start = 0; start <= path.length();)
+        {
+            auto end = std::min(path.find(L'\\', start), path.length());
+            auto component = path.substr(start, end - start);
+            if (component.empty() || (component == L".") || (component == L".."))
+            {
+                return false;
+            }
+            start = end + 1;
+        }
+        return true;
+    }
+
+    struct file_chunk
+    {
+        const void* data;
+        std::size_t size;
+    };
+
+    // Writes the chunks, in order, to a new file next to 'path' and then moves it over 'path', creating the folder if
+    // needed. Returns false, leaving any existing file alone, if any step fails.
+    inline bool write_file_atomically(const std::filesystem::path& path, std::initializer_list<file_chunk> chunks) noexcept try
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(path.parent_path(), ec);
+        auto tempPath = path;
+        tempPath += L"." + std::to_wstring(::GetCurrentProcessId());
+
+        HANDLE file = ::CreateFileW(tempPath.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+
+        bool writeOk = true;
+        for (auto& chunk : chunks)
+        {
+            DWORD written;
+            if ((chunk.size > MAXDWORD) ||
+                !::WriteFile(file, chunk.data, static_cast<DWORD>(chunk.size), &written, nullptr) || (written != chunk.size))
+            {
+                writeOk = false;
+                break;
+            }
+        }
+        ::CloseHandle(file);
+
+        if (!writeOk || !::MoveFileExW(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING))
+        {
+            ::DeleteFileW(tempPath.c_str());
+            return false;
+        }
+        return true;
+    }
+    catch (...)
+    {
+        return false;
+    }
+
+    // A read-only view of a whole file, unmapped when destroyed
+    class mapped_file
+    {
+    public:
+        mapped_file() noexcept = default;
+
+        // Takes ownership of a view returned by MapViewOfFile
+        mapped_file(const void* view, std::size_t size) noexcept :
+            m_view(static_cast<const std::uint8_t*>(view)),
+            m_size(size)
+        {
+        }
+
+        mapped_file(mapped_file&& other) noexcept :
+            m_view(std::exchange(other.m_view, nullptr)),
+            m_size(std::exchange(other.m_size, 0))
+        {
+        }
+
+        mapped_file& operator=(mapped_file&& other) noexcept
+        {
+            std::swap(m_view, other.m_view);
+            std::swap(m_size, other.m_size);
+            return *this;
+        }
+
+        ~mapped_file()
+        {
+            if (m_view)
+            {
+                ::UnmapViewOfFile(m_view);
+            }
+        }
+
+        explicit operator bool() const noexcept
+        {
+            return m_view != nullptr;
+        }
+
+        const std::uint8_t* data() const noexcept
+        {
+            return m_view;
+        }
+
+        std::size_t size() const noexcept
+        {
+            return m_size;
+        }
+
+    private:
+        const std::uint8_t* m_view = nullptr;
+        std::size_t m_size = 0;
+    };
+
+    // Maps the file at 'path' if it exists and its size is within the given bounds; otherwise returns an empty
+    // mapped_file. The pages are shared with every other process that maps the same file.
+    inline mapped_file map_cache_file(const std::filesystem::path& path, std::uint64_t minSize, std::uint64_t maxSize) noexcept
+    {
+        HANDLE file = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return {};
+        }
+
+        LARGE_INTEGER size;
+        HANDLE mapping = nullptr;
+        if (::GetFileSizeEx(file, &size) && (static_cast<std::uint64_t>(size.QuadPart) >= minSize) &&
+            (static_cast<std::uint64_t>(size.QuadPart) <= maxSize) && (size.QuadPart > 0))
+        {
+            mapping = ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        }
+        ::CloseHandle(file);
+        if (!mapping)
+        {
+            return {};
+        }
+
+        // The view stays valid after the mapping handle is closed
+        auto view = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        ::CloseHandle(mapping);
+        if (!view)
+        {
+            return {};
+        }
+        return mapped_file(view, static_cast<std::size_t>(size.QuadPart));
+    }
+}
@@ -0,0 +1,201 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) TMurgent Technologies, LLP. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+//
+// The queue between the threads that log and the thread that writes the log out. It is a bounded ring of preformatted
+// records that any number of threads can push to without taking a lock: a push claims a slot with a compare-exchange
+// of the tail and copies the message into it. A single consumer drains the records in the order that their slots were
+// claimed. When the ring is full, the record is dropped and counted instead of waiting for the consumer, so that
+// logging never blocks the thread being logged.
+//
+// Messages of up to log_record::inline_length characters are copied into the slot itself. Longer ones are copied to
+// the heap instead, and freed once drained, so that no message is ever cut short.
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+
+namespace psf
+{
+    struct log_record
+    {
+        static constexpr std::size_t inline_length = 1023;
+
+        bool is_wide;
+        std::uint32_t length;
+        void* heap;     // holds the message when it is longer than inline_length
+        union
+        {
+            char inline_narrow[inline_length + 1];
+            wchar_t inline_wide[inline_length + 1];
+        };
+
+        // Null terminated
+        const char* narrow() const noexcept
+        {
+            return heap ? static_cast<const char*>(heap) : inline_narrow;
+        }
+
+        const wchar_t* wide() const noexcept
+        {
+            return heap ? static_cast<const wchar_t*>(heap) : inline_wide;
+        }
+    };
+
+    class log_queue
+    {
+    public:
+
+        static constexpr std::size_t capacity = 512;
+        static_assert((capacity & (capacity - 1)) == 0, "capacity must be a power of two");
+
+        log_queue() : m_cells(std::make_unique<cell[]>(capacity))
+        {
+            for (std::size_t i = 0; i < capacity; ++i)
+            {
+                m_cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        // Frees what was never drained
+        ~log_queue()
+        {
+            drain([](const log_record&) {});
+        }
+
+        log_queue(const log_queue&) = delete;
+        log_queue& operator=(const log_queue&) = delete;
+
+        bool push(const char* message, std::size_t length) noexcept
+        {
+            return push_impl(message, length);
+        }
+
+        bool push(const wchar_t* message, std::size_t length) noexcept
+        {
+            return push_impl(message, length);
+        }
+
+        // Only one thread at a time may drain. Calls sink(const log_record&) for each record that is ready, oldest
+        // first, and returns how many there were.
+        template <typename Sink>
+        std::size_t drain(Sink&& sink)
+        {
+            std::size_t count = 0;
+            auto position = m_head.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                auto& current = m_cells[position & (capacity - 1)];
+                if (current.sequence.load(std::memory_order_acquire) != position + 1)
+                {
+                    break;
+                }
+
+                sink(static_cast<const log_record&>(current.record));
+                std::free(current.record.heap);
+                current.record.heap = nullptr;
+
+                // The slot is free again for the push that wraps around to it
+                current.sequence.store(position + capacity, std::memory_order_release);
+                m_head.store(++position, std::memory_order_relaxed);
+                ++count;
+            }
+            return count;
+        }
+
+        // Whether the next record is not ready yet; only meaningful to the thread that drains
+        bool empty() const noexcept
+        {
+            auto position = m_head.load(std::memory_order_relaxed);
+            return m_cells[position & (capacity - 1)].sequence.load(std::memory_order_acquire) != position + 1;
+        }
+
+        // The number of records dropped so far because the queue was full (or, rarely, a long message could not be
+        // copied)
+        std::uint64_t dropped() const noexcept
+        {
+            return m_dropped.load(std::memory_order_relaxed);
+        }
+
+    private:
+
+        struct cell
+        {
+            std::atomic<std::uint64_t> sequence{ 0 };
+            log_record record{};
+        };
+
+        template <typename CharT>
+        bool push_impl(const CharT* message, std::size_t length) noexcept
+        {
+            // Copied before a slot is claimed, so that a slot is never held up by an allocation
+            CharT* heap = nullptr;
+            if (length > log_record::inline_length)
+            {
+                if (length >= std::numeric_limits<std::uint32_t>::max())
+                {
+                    length = std::numeric_limits<std::uint32_t>::max() - 1;
+                }
+                heap = static_cast<CharT*>(std::malloc((length + 1) * sizeof(CharT)));
+                if (!heap)
+                {
+                    m_dropped.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                std::memcpy(heap, message, length * sizeof(CharT));
+                heap[length] = CharT();
+            }
+
+            auto position = m_tail.load(std::memory_order_relaxed);
+            cell* target;
+            for (;;)
+            {
+                target = &m_cells[position & (capacity - 1)];
+                auto sequence = target->sequence.load(std::memory_order_acquire);
+                auto difference = static_cast<std::int64_t>(sequence - position);
+                if (difference == 0)
+                {
+                    if (m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    {
+                        break;
+                    }
+                }
+                else if (difference < 0)
+                {
+                    // The consumer has not freed this slot from the last time around
+                    std::free(heap);
+                    m_dropped.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                else
+                {
+                    position = m_tail.load(std::memory_order_relaxed);
+                }
+            }
+
+            auto& record = target->record;
+            record.length = static_cast<std::uint32_t>(length);
+            record.is_wide = (sizeof(CharT) != sizeof(char));
+            record.heap = heap;
+            if (!heap)
+            {
+                auto text = reinterpret_cast<CharT*>(record.is_wide ? static_cast<void*>(record.inline_wide) : static_cast<void*>(record.inline_narrow));
+                std::memcpy(text, message, length * sizeof(CharT));
+                text[length] = CharT();
+            }
+
+            target->sequence.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        std::unique_ptr<cell[]> m_cells;
+        alignas(64) std::atomic<std::uint64_t> m_tail{ 0 };
+        alignas(64) std::atomic<std::uint64_t> m_head{ 0 };
+        alignas(64) std::atomic<std::uint64_t> m_dropped{ 0 };
+    };
+}
@@ -7,10 +7,19 @@
 
 // Must add psf_logging.cpp from the CommonSrc folder into the project.
 
+#include <atomic>
+
 #include <windows.h>
 
 extern bool g_psf_NoLogging;
 
+// Log formats the message, however long, and hands it to the log writer that PsfRuntime hosts for the whole process
+// (PSFWriteLog): by default it goes straight to the debugger, and when the config names a "logSink" it is queued and
+// written out by PsfRuntime's background thread. In a process without PsfRuntime, messages go to the debugger.
+
+// Writes out what has been queued so far
+void FlushLog() noexcept;
+
 
 void Log(const char* fmt, ...);
 
@@ -47,4 +56,123 @@ void LogCountedStringW(const char* name, const wchar_t* value, size_t length);
 
 void Loghexdump(void* pAddressIn, long  lSize, DWORD instance = 0);
 
+// Leveled logging. Messages belong to a category, and are only formatted (and their arguments only evaluated) when the
+// category's level, which is set at runtime, includes them. Levels above PSF_LOG_MAX_LEVEL are compiled out entirely.
+// For example:
+//      inline psf::log_category g_logRegistry{ "registry" };
+//      PSF_LOG_DEBUG(g_logRegistry, L"[%d] key path=%S", instance, InterpretKeyPath(key).c_str());
+//      if (PSF_LOG_ENABLED(psf::log_level::trace, g_logRegistry)) { LogKeyPath(key); }
+#define PSF_LOG_LEVEL_OFF       0
+#define PSF_LOG_LEVEL_ERROR     1
+#define PSF_LOG_LEVEL_WARNING   2
+#define PSF_LOG_LEVEL_INFO      3
+#define PSF_LOG_LEVEL_DEBUG     4
+#define PSF_LOG_LEVEL_TRACE     5
+
+#ifndef PSF_LOG_MAX_LEVEL
+#if _DEBUG
+#define PSF_LOG_MAX_LEVEL PSF_LOG_LEVEL_TRACE
+#else
+#define PSF_LOG_MAX_LEVEL PSF_LOG_LEVEL_DEBUG
+#endif
+#endif
+
+// The level of every category until the config says otherwise
+#ifndef PSF_LOG_DEFAULT_LEVEL
+#if _DEBUG
+#define PSF_LOG_DEFAULT_LEVEL PSF_LOG_LEVEL_DEBUG
+#else
+#define PSF_LOG_DEFAULT_LEVEL PSF_LOG_LEVEL_INFO
+#endif
+#endif
+
+namespace psf
+{
+    struct json_value;
+
+    enum class log_level
+    {
+        off = PSF_LOG_LEVEL_OFF,
+        error = PSF_LOG_LEVEL_ERROR,
+        warning = PSF_LOG_LEVEL_WARNING,
+        info = PSF_LOG_LEVEL_INFO,
+        debug = PSF_LOG_LEVEL_DEBUG,
+        trace = PSF_LOG_LEVEL_TRACE,
+    };
+
+    // A named group of messages with its own level. Categories must be defined at namespace scope (they link themselves
+    // into a list of the module's categories as they are constructed), and their names must be string literals.
+    class log_category
+    {
+    public:
+        explicit log_category(const char* name) noexcept :
+            m_name(name),
+            m_next(s_first)
+        {
+            s_first = this;
+        }
+
+        log_category(const log_category&) = delete;
+        log_category& operator=(const log_category&) = delete;
+
+        bool enabled(log_level level) const noexcept
+        {
+            return static_cast<int>(level) <= m_level.load(std::memory_order_relaxed);
+        }
+
+        void set_level(log_level level) noexcept
+        {
+            m_level.store(static_cast<int>(level), std::memory_order_relaxed);
+        }
+
+        const char* name() const noexcept
+        {
+            return m_name;
+        }
+
+        static log_category* first() noexcept
+        {
+            return s_first;
+        }
+
+        log_category* next() const noexcept
+        {
+            return m_next;
+        }
+
+    private:
+        inline static log_category* s_first = nullptr;
+
+        const char* m_name;
+        log_category* m_next;
+        std::atomic<int> m_level{ PSF_LOG_DEFAULT_LEVEL };
+    };
+}
+
+// Sets the levels of this module's categories from a fixup's "logLevel" setting, which is either a level name ("off",
+// "error", "warning", "info", "debug" or "trace") for all of them, or an object of category names to level names, where
+// "default" applies to the categories that are not named. Does nothing if levels is null.
+void SetLogLevels(const psf::json_value* levels);
+
+#define PSF_LOG_ENABLED(level, category) \
+    ((static_cast<int>(level) <= PSF_LOG_MAX_LEVEL) && !g_psf_NoLogging && (category).enabled(level))
+
+#define PSF_LOG(level, category, ...) \
+    do \
+    { \
+        if constexpr (static_cast<int>(level) <= PSF_LOG_MAX_LEVEL) \
+        { \
+            if (!g_psf_NoLogging && (category).enabled(level)) \
+            { \
+                Log(__VA_ARGS__); \
+            } \
+        } \
+    } while (0)
+
+#define PSF_LOG_ERROR(category, ...)    PSF_LOG(psf::log_level::error, category, __VA_ARGS__)
+#define PSF_LOG_WARNING(category, ...)  PSF_LOG(psf::log_level::warning, category, __VA_ARGS__)
+#define PSF_LOG_INFO(category, ...)     PSF_LOG(psf::log_level::info, category, __VA_ARGS__)
+#define PSF_LOG_DEBUG(category, ...)    PSF_LOG(psf::log_level::debug, category, __VA_ARGS__)
+#define PSF_LOG_TRACE(category, ...)    PSF_LOG(psf::log_level::trace, category, __VA_ARGS__)
+
 #include <CatchHandler.h>
\ No newline at end of file
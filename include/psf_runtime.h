@@ -4,6 +4,8 @@
 //-------------------------------------------------------------------------------------------------------
 #pragma once
 
+#include <cstdint>
+
 #include <windows.h>
 
 #include "psf_config.h"
@@ -58,6 +60,63 @@ inline const psf::json_value* PSFQueryCurrentDllConfig()
     return PSFQueryDllConfig(psf::current_module_path().filename().c_str());
 }
 
+// The "logLevel" of the dll's entry in the fixups array (see SetLogLevels in psf_logging.h), or null if there is none
+PSFAPI const psf::json_value* __stdcall PSFQueryDllLogLevel(const wchar_t* dll) noexcept;
+
+inline const psf::json_value* PSFQueryCurrentDllLogLevel()
+{
+    return PSFQueryDllLogLevel(psf::current_module_path().filename().c_str());
+}
+
+// Returns the full path of the index'th file (counting from zero) named fileName anywhere under the package root, in
+// the order a recursive walk of the package root would find them, or null if there is no such file. Names are matched
+// ignoring case. The index behind this is built once per package and shared by all of its processes.
+PSFAPI const wchar_t* __stdcall PSFFindPackageFile(_In_ const wchar_t* fileName, unsigned index) noexcept;
+
 PSFAPI void __stdcall PSFReportError(const wchar_t* error) noexcept;
 
+// The log writer that every module of the process shares; Log in psf_logging.cpp calls these, and they are rarely
+// called directly. The message must be null terminated at message[length]. Until the config names a "logSink" (or
+// PSF_LOG_SINK does), messages go straight to the debugger; after that they are queued, in full however long they are,
+// and written out by one background thread. PSFFlushLog writes out what has been queued so far.
+PSFAPI void __stdcall PSFWriteLog(_In_reads_(length) const char* message, std::size_t length) noexcept;
+PSFAPI void __stdcall PSFWriteLogW(_In_reads_(length) const wchar_t* message, std::size_t length) noexcept;
+PSFAPI void __stdcall PSFFlushLog() noexcept;
+
+// The process timeline (see psf_timeline.h). Times are in nanoseconds from PSFTimelineNow, and the name is copied.
+// PSFWriteTimeline writes the timeline in the Chrome trace event format to the given path, or when null to
+// LocalCache\Local\Microsoft\PSF\Timeline in the package's local app data folder. The timeline is also written there
+// when the process exits (from ExitProcess, or when the application's entry point returns) if the config sets
+// "timeline": true. It is not written from DllMain, so a process that ends with TerminateProcess leaves none; call
+// PSFWriteTimeline yourself to capture one.
+PSFAPI std::uint64_t __stdcall PSFTimelineNow() noexcept;
+PSFAPI void __stdcall PSFRecordSpan(_In_ const char* name, std::uint64_t start, std::uint64_t end) noexcept;
+PSFAPI BOOL __stdcall PSFWriteTimeline(_In_opt_ const wchar_t* path) noexcept;
+
+}
+
+namespace psf
+{
+    // Records the time from construction to destruction as a span of the process timeline. The name must outlive it.
+    class timeline_span
+    {
+    public:
+        explicit timeline_span(const char* name) noexcept :
+            m_name(name),
+            m_start(::PSFTimelineNow())
+        {
+        }
+
+        timeline_span(const timeline_span&) = delete;
+        timeline_span& operator=(const timeline_span&) = delete;
+
+        ~timeline_span()
+        {
+            ::PSFRecordSpan(m_name, m_start, ::PSFTimelineNow());
+        }
+
+    private:
+        const char* m_name;
+        std::uint64_t m_start;
+    };
 }
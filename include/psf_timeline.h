@@ -0,0 +1,189 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) TMurgent Technologies, LLP. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+//
+// Records how long the steps of starting a process take (loading the config, loading each fixup, ...), so that the
+// overhead of the PSF on process launch can be broken down, and writes them out in the Chrome trace event format that
+// chrome://tracing and Perfetto load.
+//
+// Spans go into a fixed size ring buffer: recording one is a single atomic increment to claim a slot, then plain
+// stores, so any thread can record without taking a lock or allocating. When more spans are recorded than the buffer
+// holds, the oldest are overwritten. Every field of a slot is an atomic word, so a dump that runs while spans are being
+// recorded is safe; it skips slots that are in the middle of being written.
+//
+// Timestamps are nanoseconds of std::chrono::steady_clock, which is monotonic. Names longer than max_name_length are
+// truncated; they are copied, so they need not outlive the call.
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+namespace psf
+{
+    class span_recorder
+    {
+    public:
+
+        static constexpr std::size_t capacity = 1024;
+        static constexpr std::size_t max_name_length = 47;
+
+        struct span
+        {
+            char name[max_name_length + 1];
+            std::uint64_t start;
+            std::uint64_t end;
+            std::uint32_t thread;
+        };
+
+        static std::uint64_t now() noexcept
+        {
+            return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+        void record(std::string_view name, std::uint64_t start, std::uint64_t end, std::uint32_t thread) noexcept
+        {
+            auto sequence = m_next.fetch_add(1, std::memory_order_relaxed);
+            auto& current = m_slots[sequence % capacity];
+
+            // Zero marks the slot as being written
+            current.sequence.store(0, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            std::array<std::uint64_t, name_words> words = {};
+            std::memcpy(words.data(), name.data(), std::min(name.length(), max_name_length));
+            for (std::size_t i = 0; i < name_words; ++i)
+            {
+                current.name[i].store(words[i], std::memory_order_relaxed);
+            }
+            current.start.store(start, std::memory_order_relaxed);
+            current.end.store(end, std::memory_order_relaxed);
+            current.thread.store(thread, std::memory_order_relaxed);
+
+            current.sequence.store(sequence + 1, std::memory_order_release);
+        }
+
+        // The spans in the buffer, oldest first
+        std::vector<span> snapshot() const
+        {
+            auto next = m_next.load(std::memory_order_acquire);
+            auto first = (next > capacity) ? (next - capacity) : 0;
+
+            std::vector<span> result;
+            result.reserve(static_cast<std::size_t>(next - first));
+            for (auto sequence = first; sequence < next; ++sequence)
+            {
+                auto& current = m_slots[sequence % capacity];
+                if (current.sequence.load(std::memory_order_acquire) != sequence + 1)
+                {
+                    continue;
+                }
+
+                std::array<std::uint64_t, name_words> words;
+                for (std::size_t i = 0; i < name_words; ++i)
+                {
+                    words[i] = current.name[i].load(std::memory_order_relaxed);
+                }
+
+                span value;
+                std::memcpy(value.name, words.data(), sizeof(value.name));
+                value.name[max_name_length] = '\0';
+                value.start = current.start.load(std::memory_order_relaxed);
+                value.end = current.end.load(std::memory_order_relaxed);
+                value.thread = current.thread.load(std::memory_order_relaxed);
+
+                // Overwritten while it was being read
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (current.sequence.load(std::memory_order_relaxed) == sequence + 1)
+                {
+                    result.push_back(value);
+                }
+            }
+            return result;
+        }
+
+        // Complete ("X") events, in microseconds since the earliest span; processName, if given, labels the process
+        void write_chrome_trace(std::ostream& stream, std::uint32_t processId, std::string_view processName = {}) const
+        {
+            auto spans = snapshot();
+            std::uint64_t origin = spans.empty() ? 0 : spans.front().start;
+            for (auto& value : spans)
+            {
+                origin = std::min(origin, value.start);
+            }
+
+            stream << "{\"traceEvents\":[";
+            bool first = true;
+            if (!processName.empty())
+            {
+                stream << "\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << processId << ",\"args\":{\"name\":";
+                write_json_string(stream, processName);
+                stream << "}}";
+                first = false;
+            }
+
+            for (auto& value : spans)
+            {
+                char times[64];
+                std::snprintf(times, sizeof(times), "\"ts\":%.3f,\"dur\":%.3f",
+                    static_cast<double>(value.start - origin) / 1000.0,
+                    static_cast<double>((value.end > value.start) ? (value.end - value.start) : 0) / 1000.0);
+
+                stream << (first ? "\n" : ",\n") << "{\"name\":";
+                write_json_string(stream, value.name);
+                stream << ",\"ph\":\"X\"," << times << ",\"pid\":" << processId << ",\"tid\":" << value.thread << "}";
+                first = false;
+            }
+            stream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+        }
+
+    private:
+
+        static constexpr std::size_t name_words = (max_name_length + 1) / sizeof(std::uint64_t);
+        static_assert((max_name_length + 1) % sizeof(std::uint64_t) == 0);
+
+        struct slot
+        {
+            std::atomic<std::uint64_t> sequence{ 0 };
+            std::atomic<std::uint64_t> name[name_words] = {};
+            std::atomic<std::uint64_t> start{ 0 };
+            std::atomic<std::uint64_t> end{ 0 };
+            std::atomic<std::uint32_t> thread{ 0 };
+        };
+
+        static void write_json_string(std::ostream& stream, std::string_view value)
+        {
+            stream << '"';
+            for (auto ch : value)
+            {
+                if ((ch == '"') || (ch == '\\'))
+                {
+                    stream << '\\' << ch;
+                }
+                else if (static_cast<unsigned char>(ch) < 0x20)
+                {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(ch));
+                    stream << escaped;
+                }
+                else
+                {
+                    stream << ch;
+                }
+            }
+            stream << '"';
+        }
+
+        std::atomic<std::uint64_t> m_next{ 0 };
+        std::array<slot, capacity> m_slots;
+    };
+}
@@ -0,0 +1,142 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) TMurgent Technologies, LLP. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+//
+// Works out which hive a registry key path is in, and the part of the path below the hive, so that registry fixups can
+// classify a key once and then evaluate all of their rules against the result.
+//
+// Key paths reach the fixups either in the familiar "HKEY_CURRENT_USER\Software\..." form or in the kernel's form,
+// "=\REGISTRY\USER\S-1-5-...\Software\..." (see InterpretKeyPath in RegLegacyFixups). In the kernel form the component
+// right after the root is skipped as well; for the user hive that is the SID. If there is no such component the whole
+// path is used, which is what the fixups have always done.
+#pragma once
+
+#include <string_view>
+
+namespace psf
+{
+    enum class registry_hive
+    {
+        unknown,
+        current_user,
+        local_machine,
+    };
+
+    template <typename CharT>
+    struct classified_registry_path
+    {
+        registry_hive hive = registry_hive::unknown;
+
+        // The path below the hive, e.g. "Software\Vendor" (empty for an unknown hive)
+        std::basic_string_view<CharT> remainder;
+    };
+
+    namespace details
+    {
+        template <typename CharT>
+        constexpr bool starts_with(std::basic_string_view<CharT> str, const char* prefix) noexcept
+        {
+            std::size_t i = 0;
+            for (; prefix[i]; ++i)
+            {
+                if ((i >= str.length()) || (str[i] != static_cast<CharT>(prefix[i])))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        template <typename CharT>
+        constexpr std::size_t literal_length(const char* literal) noexcept
+        {
+            std::size_t length = 0;
+            while (literal[length])
+            {
+                ++length;
+            }
+            return length;
+        }
+    }
+
+    template <typename CharT>
+    classified_registry_path<CharT> classify_registry_path(std::basic_string_view<CharT> path) noexcept
+    {
+        struct hive_root
+        {
+            const char* name;
+            bool kernelForm;
+            registry_hive hive;
+        };
+        static constexpr hive_root roots[] =
+        {
+            { "HKEY_CURRENT_USER\\", false, registry_hive::current_user },
+            { "=\\REGISTRY\\USER\\", true, registry_hive::current_user },
+            { "HKEY_LOCAL_MACHINE\\", false, registry_hive::local_machine },
+            { "=\\REGISTRY\\MACHINE\\", true, registry_hive::local_machine },
+        };
+
+        classified_registry_path<CharT> result;
+        for (auto& root : roots)
+        {
+            if (!details::starts_with(path, root.name))
+            {
+                continue;
+            }
+
+            auto offset = details::literal_length<CharT>(root.name);
+            if (root.kernelForm)
+            {
+                auto separator = path.find(static_cast<CharT>('\\'), offset);
+                offset = (separator == std::basic_string_view<CharT>::npos) ? 0 : separator + 1;
+            }
+            result.hive = root.hive;
+            result.remainder = path.substr(offset);
+            break;
+        }
+        return result;
+    }
+
+    // The DeletionMarker rules of RegLegacyFixups match a "key\\value" string, and have always cut it up differently:
+    // the hive is recognized by its root without the trailing separator, and the remainder starts two characters past
+    // the root (familiar form) or past the separator that follows it (kernel form). That leaves out the first character
+    // below the root, or of the SID. Existing configurations are written against those offsets, so they are kept.
+    template <typename CharT>
+    classified_registry_path<CharT> classify_registry_marker_path(std::basic_string_view<CharT> keyAndValue) noexcept
+    {
+        struct hive_root
+        {
+            const char* name;
+            bool kernelForm;
+            registry_hive hive;
+        };
+        static constexpr hive_root roots[] =
+        {
+            { "HKEY_CURRENT_USER", false, registry_hive::current_user },
+            { "=\\REGISTRY\\USER", true, registry_hive::current_user },
+            { "HKEY_LOCAL_MACHINE", false, registry_hive::local_machine },
+            { "=\\REGISTRY\\MACHINE", true, registry_hive::local_machine },
+        };
+
+        classified_registry_path<CharT> result;
+        for (auto& root : roots)
+        {
+            if (!details::starts_with(keyAndValue, root.name))
+            {
+                continue;
+            }
+
+            // As before, a kernel form without a separator after the root starts at 1 (npos + 2)
+            auto offset = details::literal_length<CharT>(root.name) + 2;
+            if (root.kernelForm)
+            {
+                offset = keyAndValue.find(static_cast<CharT>('\\'), offset - 2) + 2;
+            }
+            result.hive = root.hive;
+            result.remainder = (offset < keyAndValue.length()) ? keyAndValue.substr(offset) : std::basic_string_view<CharT>();
+            break;
+        }
+        return result;
+    }
+}
@@ -0,0 +1,22 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) TMurgent Technologies, LLP. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+#pragma once
+
+#include <cwctype>
+#include <locale.h>
+
+namespace psf
+{
+    // Folds characters the way _wcsicmp_l does for the user's locale, which is how the fixups have always compared the
+    // names returned by a merged FindFirstFile/FindNextFile enumeration. Used as the Fold of a file_name_set.
+    struct user_locale_fold
+    {
+        wchar_t operator()(wchar_t ch) const noexcept
+        {
+            static _locale_t locale = _wcreate_locale(LC_ALL, L"");
+            return _towlower_l(ch, locale);
+        }
+    };
+}
@@ -0,0 +1,211 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) TMurgent Technologies, LLP. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+//
+// Builds PsfRuntime's config parser and compiled config image (against the stand-ins in win32/) and checks that an
+// image gives the same tree as parsing config.json, that it is refused once config.json changes (including a change
+// that keeps the file's size and time stamp) or once the image itself is damaged, and reports the cost of parsing
+// against that of opening the image.
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../../PsfRuntime/ConfigImage.h"
+#include "../../PsfRuntime/JsonConfig.h"
+
+#include "portable_test.h"
+
+namespace
+{
+    // A config about the size of our larger packages: many processes, each with a few fixups and their rules
+    std::string make_config(std::size_t processCount)
+    {
+        std::ostringstream json;
+        json << "{\n  \"applications\": [ { \"id\": \"App\", \"executable\": \"App\\\\App.exe\", \"workingDirectory\": \"App\" } ],\n";
+        json << "  \"compiledConfig\": true,\n  \"processes\": [\n";
+        for (std::size_t i = 0; i < processCount; ++i)
+        {
+            json << "    { \"executable\": \"^Tool" << i << "$\", \"fixups\": [\n";
+            json << "      { \"dll\": \"FileRedirectionFixup.dll\", \"config\": { \"redirectedPaths\": { \"packageRelative\": [\n";
+            for (int rule = 0; rule < 6; ++rule)
+            {
+                json << "        { \"base\": \"Tool" << i << "\\\\Data" << rule << "\", \"patterns\": [ \".*\\\\.log\", \".*\\\\.ini\", \"Settings\\\\\\\\.*\" ] }"
+                     << ((rule < 5) ? ",\n" : "\n");
+            }
+            json << "      ] }, \"decisionCacheSize\": " << (256 + i) << ", \"ratio\": 0." << i << " } },\n";
+            json << "      { \"dll\": \"RegLegacyFixups.dll\", \"config\": [ { \"type\": \"ModifyKeyAccess\", \"remediation\": [\n";
+            json << "        { \"hive\": \"HKCU\", \"patterns\": [ \"^Software\\\\\\\\Vendor" << i << ".*\" ], \"access\": \"Full2RW\", \"enabled\": "
+                 << ((i % 2) ? "true" : "false") << ", \"note\": null, \"unicode\": \"caf\\u00e9 \\u65e5\\u672c\" }\n";
+            json << "      ] } ] }\n    ] }" << ((i + 1 < processCount) ? ",\n" : "\n");
+        }
+        json << "  ]\n}\n";
+        return json.str();
+    }
+
+    bool same_tree(const psf::json_value& lhs, const psf::json_value& rhs)
+    {
+        if (lhs.type() != rhs.type())
+        {
+            return false;
+        }
+        switch (lhs.type())
+        {
+        case psf::json_type::null:
+            return true;
+        case psf::json_type::string:
+            return (lhs.as_string().string() == rhs.as_string().string()) && (lhs.as_string().wstring() == rhs.as_string().wstring());
+        case psf::json_type::number:
+            return (lhs.as_number().get_signed() == rhs.as_number().get_signed()) &&
+                (lhs.as_number().get_unsigned() == rhs.as_number().get_unsigned()) &&
+                (lhs.as_number().get_float() == rhs.as_number().get_float());
+        case psf::json_type::boolean:
+            return lhs.as_boolean().get() == rhs.as_boolean().get();
+        case psf::json_type::object:
+        {
+            std::vector<std::pair<std::string, const psf::json_value*>> lhsMembers;
+            std::vector<std::pair<std::string, const psf::json_value*>> rhsMembers;
+            for (auto& member : lhs.as_object())
+            {
+                lhsMembers.emplace_back(std::string(member.first), &member.second);
+            }
+            for (auto& member : rhs.as_object())
+            {
+                rhsMembers.emplace_back(std::string(member.first), &member.second);
+            }
+            if (lhsMembers.size() != rhsMembers.size())
+            {
+                return false;
+            }
+            for (std::size_t i = 0; i < lhsMembers.size(); ++i)
+            {
+                auto found = rhs.as_object().try_get(lhsMembers[i].first.c_str());
+                if ((lhsMembers[i].first != rhsMembers[i].first) || (found != rhsMembers[i].second) ||
+                    !same_tree(*lhsMembers[i].second, *rhsMembers[i].second))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+        case psf::json_type::array:
+        {
+            auto& lhsArray = lhs.as_array();
+            auto& rhsArray = rhs.as_array();
+            if (lhsArray.size() != rhsArray.size())
+            {
+                return false;
+            }
+            for (unsigned i = 0; i < lhsArray.size(); ++i)
+            {
+                if (!same_tree(*lhsArray.try_get_at(i), *rhsArray.try_get_at(i)))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+        }
+        return false;
+    }
+
+    std::vector<char> read_file(const std::filesystem::path& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+}
+
+int main()
+{
+    const std::wstring packageFullName = L"Contoso.App_1.0.0.0_x64__8wekyb3d8bbwe";
+    auto folder = std::filesystem::temp_directory_path() / ("psf_config_image_" + std::to_string(::getpid()));
+    std::filesystem::create_directories(folder);
+    auto configPath = folder / "config.json";
+    auto imagePath = folder / "config.psfc";
+
+    auto json = make_config(200);
+    std::ofstream(configPath, std::ios::binary) << json;
+    auto contents = read_file(configPath);
+    auto hash = config_image::content_hash(contents.data(), contents.size());
+
+    json_dom_builder parsed;
+    CHECK(!parse_json_contents(contents.data(), contents.size(), parsed).IsError());
+    CHECK(parsed.root != nullptr);
+    CHECK(write_config_image(*parsed.root, configPath, hash, packageFullName, imagePath));
+
+    auto image = config_image_file::open(imagePath, packageFullName);
+    CHECK(image != nullptr);
+    if (image)
+    {
+        CHECK(same_tree(*parsed.root, *image->root()));
+        CHECK(image->source_path() == configPath);
+    }
+    CHECK(config_image_file::open(imagePath, L"Other.App_1.0.0.0_x64__8wekyb3d8bbwe") == nullptr);
+
+    // What each process pays: reading and parsing config.json, or mapping, checking and hashing against the image
+    std::size_t sink = 0;
+    auto parseTime = time_per_call(50, [&](std::size_t)
+    {
+        auto bytes = read_file(configPath);
+        auto builder = std::make_unique<json_dom_builder>();
+        parse_json_contents(bytes.data(), bytes.size(), *builder);
+        sink += builder->root ? 1 : 0;
+    });
+    auto imageTime = time_per_call(50, [&](std::size_t)
+    {
+        auto opened = config_image_file::open(imagePath, packageFullName);
+        sink += opened ? 1 : 0;
+    });
+    std::printf("%zu byte config.json: parse %.0f us, open compiled image %.0f us (%.1fx) [%zu]\n",
+        contents.size(), parseTime / 1000, imageTime / 1000, parseTime / imageTime, sink);
+
+    // A change that keeps the size and the time stamp must still be noticed
+    auto writeTime = std::filesystem::last_write_time(configPath);
+    auto changed = json;
+    changed[changed.find("Full2RW")] = 'X';
+    std::ofstream(configPath, std::ios::binary | std::ios::trunc) << changed;
+    std::filesystem::last_write_time(configPath, writeTime);
+    CHECK(std::filesystem::file_size(configPath) == contents.size());
+    CHECK(config_image_file::open(imagePath, packageFullName) == nullptr);
+
+    // As must an ordinary edit
+    std::ofstream(configPath, std::ios::binary | std::ios::trunc) << json << "\n";
+    CHECK(config_image_file::open(imagePath, packageFullName) == nullptr);
+
+    // And an image that has been damaged
+    std::ofstream(configPath, std::ios::binary | std::ios::trunc) << json;
+    std::filesystem::last_write_time(configPath, writeTime);
+    CHECK(config_image_file::open(imagePath, packageFullName) != nullptr);
+    {
+        std::fstream damage(imagePath, std::ios::binary | std::ios::in | std::ios::out);
+        damage.seekp(sizeof(config_image::image_header) + 4);
+        damage.put('\x7f');
+    }
+    CHECK(config_image_file::open(imagePath, packageFullName) == nullptr);
+
+    // Including where the structure still holds up: a character of a string value
+    CHECK(write_config_image(*parsed.root, configPath, hash, packageFullName, imagePath));
+    CHECK(config_image_file::open(imagePath, packageFullName) != nullptr);
+    {
+        auto bytes = read_file(imagePath);
+        auto offset = std::string_view(bytes.data(), bytes.size()).find("Full2RW");
+        CHECK(offset != std::string_view::npos);
+        std::fstream damage(imagePath, std::ios::binary | std::ios::in | std::ios::out);
+        damage.seekp(static_cast<std::streamoff>(offset));
+        damage.put('X');
+    }
+    CHECK(config_image_file::open(imagePath, packageFullName) == nullptr);
+
+    image.reset();
+    std::filesystem::remove_all(folder);
+    return test_result("config_image");
+}
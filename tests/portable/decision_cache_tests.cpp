@@ -0,0 +1,206 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) TMurgent Technologies, LLP. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+//
+// Drives a path_decision_cache the way ShouldRedirectV2 does, against a stand-in file system: the redirection decision
+// only reads the file system and is cached whatever the request's flags, and a copy-on-read request then copies the
+// package file to the redirected path itself, logging an invalidation only when it actually made the copy. Every
+// answer, cached or not, must match a decision made afresh, and copy-on-read requests must be served from the cache.
+
+#include <algorithm>
+#include <cwctype>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <path_decision_cache.h>
+
+#include "portable_test.h"
+
+namespace
+{
+    constexpr std::uint32_t check_presence = 0x0004;
+    constexpr std::uint32_t copy_on_read = 0x0003;
+
+    struct stand_in_file_system
+    {
+        std::set<std::wstring> files;
+        std::size_t probes = 0;
+
+        static std::wstring key(std::wstring_view path)
+        {
+            std::wstring result(path);
+            std::transform(result.begin(), result.end(), result.begin(), [](wchar_t ch) { return static_cast<wchar_t>(std::towlower(ch)); });
+            return result;
+        }
+
+        bool exists(std::wstring_view path)
+        {
+            ++probes;
+            return files.count(key(path)) != 0;
+        }
+
+        void create(std::wstring_view path)
+        {
+            files.insert(key(path));
+        }
+
+        void remove(std::wstring_view path)
+        {
+            files.erase(key(path));
+        }
+    };
+
+    struct decision
+    {
+        bool should_redirect = false;
+        bool package_exists = false;
+        bool redirected_exists = false;
+        std::wstring package_path;
+        std::wstring redirect_path;
+
+        bool operator==(const decision& other) const
+        {
+            return (should_redirect == other.should_redirect) && (package_exists == other.package_exists) &&
+                (redirected_exists == other.redirected_exists) && (package_path == other.package_path) &&
+                (redirect_path == other.redirect_path);
+        }
+    };
+
+    const std::wstring native_root = LR"(C:\Users\user\AppData\Roaming\Contoso\)";
+    const std::wstring package_root = LR"(C:\Program Files\WindowsApps\Contoso\VFS\AppData\Contoso\)";
+    const std::wstring redirected_root = LR"(C:\Users\user\AppData\Local\Packages\Contoso\LocalCache\Roaming\Contoso\)";
+
+    // ShouldRedirectV2Impl in miniature: which paths exist decides where the request goes
+    decision decide(stand_in_file_system& fs, const std::wstring& path, std::uint32_t flags)
+    {
+        decision result;
+        auto relative = path.substr(native_root.length());
+        result.package_path = package_root + relative;
+        result.redirect_path = redirected_root + relative;
+        result.package_exists = fs.exists(result.package_path);
+        result.redirected_exists = fs.exists(result.redirect_path);
+        result.should_redirect = !(flags & check_presence) || result.package_exists || result.redirected_exists;
+        return result;
+    }
+
+    struct redirector
+    {
+        explicit redirector(stand_in_file_system& fileSystem) : fs(fileSystem)
+        {
+        }
+
+        stand_in_file_system& fs;
+        psf::path_invalidation_log log;
+        psf::path_decision_cache<decision> cache{ log, 64 };
+        std::size_t copies = 0;
+        std::size_t mismatches = 0;
+
+        // ShouldRedirectV2Cached in miniature
+        decision should_redirect(const std::wstring& path, std::uint32_t flags)
+        {
+            auto decisionFlags = flags & ~copy_on_read;
+            decision result;
+            if (auto cached = cache.find(path, decisionFlags))
+            {
+                result = *cached;
+            }
+            else
+            {
+                auto observedSequence = cache.sequence();
+                result = decide(fs, path, decisionFlags);
+                cache.insert(path, decisionFlags, result, { result.package_path, result.redirect_path }, observedSequence);
+            }
+
+            // The cached answer must be the one that the file system gives right now
+            auto probes = fs.probes;
+            mismatches += (result == decide(fs, path, decisionFlags)) ? 0 : 1;
+            fs.probes = probes;
+
+            if (((flags & copy_on_read) == copy_on_read) && result.should_redirect && !result.redirected_exists && result.package_exists)
+            {
+                fs.create(result.redirect_path);
+                result.redirected_exists = true;
+                ++copies;
+                log.invalidate(result.redirect_path);
+            }
+            return result;
+        }
+    };
+}
+
+int main()
+{
+    stand_in_file_system fs;
+    std::vector<std::wstring> paths;
+    for (int i = 0; i < 40; ++i)
+    {
+        auto relative = L"Profile" + std::to_wstring(i) + L"\\settings.ini";
+        paths.push_back(native_root + relative);
+        if (i % 2 == 0)
+        {
+            fs.create(package_root + relative);
+        }
+    }
+
+    redirector frf(fs);
+    std::mt19937 random(3);
+    std::size_t deletes = 0;
+    std::size_t copyOnReadCalls = 0;
+    std::uint64_t copyOnReadHits = 0;
+    for (int i = 0; i < 20000; ++i)
+    {
+        auto& path = paths[random() % paths.size()];
+        switch (random() % 50)
+        {
+        case 0:
+        {
+            // The app deletes its redirected copy, through a fixup that reports the change
+            auto redirected = redirected_root + path.substr(native_root.length());
+            if (fs.exists(redirected))
+            {
+                fs.remove(redirected);
+                frf.log.invalidate(redirected);
+                ++deletes;
+            }
+            break;
+        }
+        case 1: case 2: case 3: case 4: case 5: case 6: case 7: case 8: case 9: case 10:
+        {
+            auto hits = frf.log.hits.load();
+            frf.should_redirect(path, copy_on_read);
+            copyOnReadHits += frf.log.hits.load() - hits;
+            ++copyOnReadCalls;
+            break;
+        }
+        default:
+            frf.should_redirect(path, check_presence);
+            break;
+        }
+    }
+
+    CHECK(frf.mismatches == 0);
+    CHECK(frf.copies > 0);
+    CHECK(deletes > 0);
+
+    // Only actual changes were logged: each copy and each delete once, and nothing for copy-on-read requests that
+    // found the copy already made
+    CHECK(frf.log.sequence() == frf.copies + deletes);
+    CHECK(frf.copies < copyOnReadCalls / 2);
+    CHECK(copyOnReadHits > copyOnReadCalls / 2);
+
+    // A copy-on-read request and a plain read of the same path share the cached decision
+    frf.should_redirect(paths[1], 0);
+    auto hits = frf.log.hits.load();
+    frf.should_redirect(paths[1], copy_on_read);
+    frf.should_redirect(paths[1], 0);
+    CHECK(frf.log.hits.load() == hits + 2);
+
+    std::printf("%zu copy-on-read requests: %llu cache hits, %zu copies, %zu deletes, %llu entries invalidated\n",
+        copyOnReadCalls, static_cast<unsigned long long>(copyOnReadHits), frf.copies, deletes,
+        static_cast<unsigned long long>(frf.log.invalidated_entries.load()));
+
+    return test_result("path_decision_cache");
+}
@@ -0,0 +1,536 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) TMurgent Technologies, LLP. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+//
+// Runs MFRFixup's DetermineCohorts (built from its own source, with create_mfr_path and the mapping lookups) over a
+// corpus of the paths the intercepts see, and checks that it gives the same cohorts as the std::wstring version it
+// replaced: the old *_to_normal and PurgeDotDotFolders for the request, then ReplacePathPart for each of the others.
+// The corpus includes paths long enough that the storage for the request and its cohorts has to leave the inline
+// buffer. Then counts the heap allocations that each version makes per request, and times them.
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <windows.h>
+
+#include "DetermineCohorts.h"
+
+#include "portable_test.h"
+
+namespace
+{
+    std::size_t g_allocations = 0;
+}
+
+void* operator new(std::size_t size)
+{
+    ++g_allocations;
+    if (auto result = std::malloc(size ? size : 1))
+    {
+        return result;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+// Set up by the fixup from the package and its configuration; here the package is installed for a user named Tester
+std::filesystem::path g_packageRootPath = LR"(C:\Program Files\WindowsApps\Contoso.App_1.0.0.0_x64__8wekyb3d8bbwe)";
+std::filesystem::path g_packageVfsRootPath = LR"(C:\Program Files\WindowsApps\Contoso.App_1.0.0.0_x64__8wekyb3d8bbwe\VFS)";
+std::filesystem::path g_redirectRootPath = LR"(C:\Users\Tester\AppData\Local\Packages\Contoso.App_8wekyb3d8bbwe\LocalCache)";
+std::filesystem::path g_writablePackageRootPath = LR"(C:\Users\Tester\AppData\Local\Packages\Contoso.App_8wekyb3d8bbwe\LocalCache\Local\Microsoft\WritablePackageRoot)";
+std::filesystem::path g_short_packageRootPath = LR"(C:\PROGRA~1\WINDOW~1\CONTOS~1.0_X)";
+std::filesystem::path g_short_packageVfsRootPath = LR"(C:\PROGRA~1\WINDOW~1\CONTOS~1.0_X\VFS)";
+std::filesystem::path g_short_redirectRootPath = LR"(C:\Users\Tester\AppData\Local\Packages\CONTOS~1\LOCALC~1)";
+std::filesystem::path g_short_writablePackageRootPath = LR"(C:\Users\Tester\AppData\Local\Packages\CONTOS~1\LOCALC~1\Local\MICROS~1\WRITAB~1)";
+std::filesystem::path FID_RootDrive = LR"(C:\)";
+
+namespace
+{
+    const std::wstring currentDirectory = LR"(C:\Users\Tester\AppData\Roaming\Contoso\App)";
+
+    void add_mapping(const wchar_t* native, const wchar_t* vfsFolder, mfr::mfr_redirect_flags flags, bool exclusion = false)
+    {
+        mfr::mfr_folder_mapping map;
+        map.Valid_mapping = true;
+        map.IsAnExclusionToRedirect = exclusion;
+        map.NativePathBase = native;
+        map.FolderId = L"{" + std::to_wstring(mfr::g_MfrFolderMappings.size()) + L"}";
+        map.VFSFolderName = vfsFolder;
+        map.PackagePathBase = g_packageVfsRootPath.wstring() + L"\\" + vfsFolder;
+        map.DoesRuntimeMapNativeToVFS = false;
+        map.RedirectedPathBase = (flags == mfr::mfr_redirect_flags::prefer_redirection_local) ? std::filesystem::path(native) :
+            std::filesystem::path(g_writablePackageRootPath.wstring() + L"\\VFS\\" + vfsFolder);
+        map.RedirectionFlags = flags;
+        mfr::g_MfrFolderMappings.push_back(std::move(map));
+    }
+
+    // A few of the mappings that Initialize_MFR_Mappings creates, more specific paths first
+    void add_mappings()
+    {
+        using mfr::mfr_redirect_flags;
+        add_mapping(LR"(C:\Windows\Fonts)", L"Fonts", mfr_redirect_flags::prefer_redirection_containerized, true);
+        add_mapping(LR"(C:\Windows\System32\catroot)", L"SystemX64\\catroot", mfr_redirect_flags::prefer_redirection_containerized);
+        add_mapping(LR"(C:\Windows\System32)", L"SystemX64", mfr_redirect_flags::prefer_redirection_containerized);
+        add_mapping(LR"(C:\Windows\SysWOW64)", L"SystemX86", mfr_redirect_flags::prefer_redirection_containerized);
+        add_mapping(LR"(C:\Windows)", L"Windows", mfr_redirect_flags::prefer_redirection_containerized);
+        add_mapping(LR"(C:\Program Files\Common Files)", L"ProgramFilesCommonX64", mfr_redirect_flags::prefer_redirection_if_package_vfs);
+        add_mapping(LR"(C:\Program Files (x86))", L"ProgramFilesX86", mfr_redirect_flags::prefer_redirection_if_package_vfs);
+        add_mapping(LR"(C:\Program Files)", L"ProgramFilesX64", mfr_redirect_flags::prefer_redirection_if_package_vfs);
+        add_mapping(LR"(C:\ProgramData)", L"Common AppData", mfr_redirect_flags::prefer_redirection_containerized);
+        add_mapping(LR"(C:\Users\Tester\AppData\Local\Temp)", L"Local AppData\\Temp", mfr_redirect_flags::prefer_redirection_none);
+        add_mapping(LR"(C:\Users\Tester\AppData\Local)", L"Local AppData", mfr_redirect_flags::prefer_redirection_local);
+        add_mapping(LR"(C:\Users\Tester\AppData\Roaming)", L"AppData", mfr_redirect_flags::prefer_redirection_local);
+        add_mapping(LR"(C:\Users\Tester\Documents)", L"Personal", mfr_redirect_flags::prefer_redirection_local);
+        mfr::BuildMappingIndexes();
+    }
+
+    // What mfr_path and Cohorts held before: strings, built by the functions that PathUtilities had for them
+    struct string_cohorts
+    {
+        std::wstring Request_NormalizedPath;
+        psf::dos_path_type Request_DosPathType = psf::dos_path_type::unknown;
+        mfr::mfr_path_types Request_MfrPathType = mfr::mfr_path_types::unknown;
+        std::wstring WsRequested;
+        const mfr::mfr_folder_mapping* map = &mfr::InvalidMapping();
+        bool exclusion = false;
+        std::wstring WsRedirected;
+        std::wstring WsPackage;
+        std::wstring WsNative;
+        bool UsingNative = true;
+    };
+
+    std::wstring PurgeDotDotFolders(std::wstring inputWs)
+    {
+        std::wstring outputWs = inputWs;
+        size_t SlashDotsStartAt = outputWs.find(L"\\..\\");
+        while (SlashDotsStartAt != std::wstring::npos)
+        {
+            size_t replaceStartsAt = SlashDotsStartAt - 1; // before slash
+            while (replaceStartsAt > 0)
+            {
+                if (replaceStartsAt > 2)
+                {
+                    if (outputWs.at(replaceStartsAt) == L'\\')
+                    {
+                        std::wstring temp = outputWs.substr(0, replaceStartsAt);
+                        temp.append(outputWs.substr(SlashDotsStartAt + 3));
+                        outputWs = temp;
+                        replaceStartsAt = 0;  // terminate this while
+                        SlashDotsStartAt = outputWs.find(L"\\..\\");  // look for another
+                    }
+                    else
+                    {
+                        replaceStartsAt--;
+                    }
+                }
+                else
+                {
+                    outputWs = outputWs.substr(SlashDotsStartAt + 3);
+                    replaceStartsAt = 0;  // terminate this while
+                    SlashDotsStartAt = outputWs.find(L"\\..\\");  // look for another
+                }
+            }
+        }
+        return outputWs;
+    }
+
+    std::wstring ReplacePathPart(std::wstring_view inputWstring, const std::filesystem::path& from, const std::filesystem::path& to)
+    {
+        size_t removecount = from.native().length();
+        if (removecount < inputWstring.length())
+        {
+            std::wstring outputWstring;
+            outputWstring.reserve(to.native().length() + inputWstring.length() - removecount);
+            outputWstring.append(to.wstring());
+            outputWstring.append(inputWstring.substr(removecount));
+            return outputWstring;
+        }
+        return std::wstring(inputWstring);
+    }
+
+    bool comparei(const std::wstring wstrA, const std::wstring wstrB)
+    {
+        if (wstrA.length() != wstrB.length())
+            return false;
+
+        std::wstring lwstrA = wstrA;
+        std::wstring lwstrB = wstrB;
+        std::transform(lwstrA.begin(), lwstrA.end(), lwstrA.begin(), [](wchar_t wc) { return (wchar_t)std::tolower(wc); });
+        std::transform(lwstrB.begin(), lwstrB.end(), lwstrB.begin(), [](wchar_t wc) { return (wchar_t)std::tolower(wc); });
+        return (lwstrA == lwstrB);
+    }
+
+    // pathString_isSubsetOf_Path, which compared against generic_wstring() of each root
+    bool isSubsetOf(const std::filesystem::path& root, const std::wstring& path)
+    {
+        std::wstring rootText = root.generic_wstring();
+        return std::equal(rootText.begin(), rootText.end(), path.c_str(), psf::path_compare{});
+    }
+
+    mfr::mfr_path_types string_managed_path_type(const std::wstring& path)
+    {
+        using mfr::mfr_path_types;
+        if (isSubsetOf(g_writablePackageRootPath, path) || isSubsetOf(g_short_writablePackageRootPath, path))
+        {
+            return mfr_path_types::in_redirection_area_writablepackageroot;
+        }
+        if (isSubsetOf(g_redirectRootPath, path) || isSubsetOf(g_short_redirectRootPath, path))
+        {
+            return mfr_path_types::in_redirection_area_other;
+        }
+        if (isSubsetOf(g_packageVfsRootPath, path) || isSubsetOf(g_short_packageVfsRootPath, path))
+        {
+            return mfr_path_types::in_package_vfs_area;
+        }
+        if (isSubsetOf(g_packageRootPath, path) || isSubsetOf(g_short_packageRootPath, path))
+        {
+            return mfr_path_types::in_package_pvad_area;
+        }
+        return isSubsetOf(FID_RootDrive, path) ? mfr_path_types::in_native_area : mfr_path_types::in_other_drive_area;
+    }
+
+    // The old create_mfr_path; std::filesystem::current_path() gives the current directory on Windows
+    void string_create_mfr_path(const std::wstring& inputPath, string_cohorts& result)
+    {
+        using mfr::mfr_path_types;
+        result.Request_DosPathType = psf::path_type(inputPath.c_str());
+        result.Request_NormalizedPath = inputPath;
+        switch (result.Request_DosPathType)
+        {
+        case psf::dos_path_type::drive_absolute:
+            result.Request_NormalizedPath = PurgeDotDotFolders(inputPath);
+            break;
+        case psf::dos_path_type::drive_relative:
+            result.Request_NormalizedPath = PurgeDotDotFolders(currentDirectory + L"\\" + (inputPath.c_str() + 2));
+            break;
+        case psf::dos_path_type::relative:
+            result.Request_NormalizedPath = PurgeDotDotFolders(currentDirectory + L"\\" + inputPath);
+            break;
+        case psf::dos_path_type::rooted:
+            result.Request_NormalizedPath = PurgeDotDotFolders(currentDirectory.substr(0, 2) + inputPath);
+            break;
+        case psf::dos_path_type::root_local_device:
+            result.Request_NormalizedPath = PurgeDotDotFolders(inputPath.c_str() + 4);
+            break;
+        case psf::dos_path_type::unc_absolute:
+            result.Request_MfrPathType = mfr_path_types::is_UNC_path;
+            return;
+        case psf::dos_path_type::protocol:
+            result.Request_MfrPathType = mfr_path_types::is_Protocol;
+            return;
+        case psf::dos_path_type::shell:
+            result.Request_MfrPathType = mfr_path_types::is_Shell;
+            return;
+        case psf::dos_path_type::DosSpecial:
+            result.Request_MfrPathType = mfr_path_types::is_DosSpecial;
+            return;
+        default:
+            result.Request_MfrPathType = mfr_path_types::unsupported_for_intercepts;
+            return;
+        }
+        result.Request_MfrPathType = string_managed_path_type(result.Request_NormalizedPath);
+    }
+
+    // The old DetermineCohorts, without the logging
+    string_cohorts string_determine_cohorts(const std::wstring& requestedPath)
+    {
+        using mfr::mfr_path_types;
+        string_cohorts c;
+        string_create_mfr_path(requestedPath, c);
+        c.WsRequested = c.Request_NormalizedPath;
+        switch (c.Request_MfrPathType)
+        {
+        case mfr_path_types::in_native_area:
+            c.map = &mfr::Find_LocalRedirMapping_FromNativePath_ForwardSearch(c.Request_NormalizedPath);
+            if (c.map->Valid_mapping)
+            {
+                c.WsRedirected = c.WsRequested;
+                if (!c.map->IsAnExclusionToRedirect)
+                {
+                    c.WsPackage = ReplacePathPart(c.WsRequested, c.map->RedirectedPathBase, c.map->PackagePathBase);
+                    c.UsingNative = false;
+                }
+                else
+                {
+                    c.WsPackage = c.WsRequested;
+                }
+                break;
+            }
+            c.map = &mfr::Find_TraditionalRedirMapping_FromNativePath_ForwardSearch(c.Request_NormalizedPath);
+            if (c.map->Valid_mapping)
+            {
+                if (!c.map->IsAnExclusionToRedirect)
+                {
+                    if (comparei(c.WsRequested, L"C:\\Program Files\\WindowsApps"))
+                    {
+                        c.WsPackage = c.WsRequested;
+                        c.WsRedirected = c.WsPackage;
+                        c.exclusion = true;
+                    }
+                    else
+                    {
+                        c.WsRedirected = ReplacePathPart(c.WsRequested, c.map->NativePathBase, c.map->RedirectedPathBase);
+                        c.WsPackage = ReplacePathPart(c.WsRequested, c.map->NativePathBase, c.map->PackagePathBase);
+                    }
+                    c.WsNative = c.WsRequested;
+                }
+                else
+                {
+                    c.WsRedirected = c.WsRequested;
+                    c.WsPackage = c.WsRequested;
+                    c.WsNative = c.WsRequested;
+                }
+            }
+            break;
+        case mfr_path_types::in_package_pvad_area:
+            c.WsPackage = c.WsRequested;
+            c.map = &mfr::Find_TraditionalRedirMapping_FromPackagePath_ForwardSearch(c.Request_NormalizedPath);
+            if (c.map->Valid_mapping)
+            {
+                if (!c.map->IsAnExclusionToRedirect)
+                {
+                    c.WsRedirected = ReplacePathPart(c.WsRequested, c.map->PackagePathBase, c.map->RedirectedPathBase);
+                    c.UsingNative = false;
+                }
+                else
+                {
+                    c.WsRedirected = c.WsRequested;
+                    c.WsNative = c.WsRequested;
+                }
+            }
+            break;
+        case mfr_path_types::in_package_vfs_area:
+            c.map = &mfr::Find_LocalRedirMapping_FromPackagePath_ForwardSearch(c.Request_NormalizedPath);
+            if (c.map->Valid_mapping)
+            {
+                if (!c.map->IsAnExclusionToRedirect)
+                {
+                    c.WsPackage = c.WsRequested;
+                    c.WsRedirected = ReplacePathPart(c.WsRequested, c.map->PackagePathBase, c.map->RedirectedPathBase);
+                    c.UsingNative = false;
+                }
+                else
+                {
+                    c.WsRedirected = c.WsRequested;
+                    c.WsPackage = c.WsRequested;
+                    c.WsNative = c.WsRequested;
+                }
+                break;
+            }
+            c.map = &mfr::Find_TraditionalRedirMapping_FromPackagePath_ForwardSearch(c.Request_NormalizedPath);
+            if (c.map->Valid_mapping)
+            {
+                if (!c.map->IsAnExclusionToRedirect)
+                {
+                    c.WsPackage = c.WsRequested;
+                    c.WsRedirected = ReplacePathPart(c.WsRequested, c.map->PackagePathBase, c.map->RedirectedPathBase);
+                    c.WsNative = ReplacePathPart(c.WsRequested, c.map->PackagePathBase, c.map->NativePathBase);
+                }
+                else
+                {
+                    c.WsRedirected = c.WsRequested;
+                    c.WsPackage = c.WsRequested;
+                    c.WsNative = c.WsRequested;
+                }
+            }
+            break;
+        case mfr_path_types::in_redirection_area_writablepackageroot:
+            c.map = &mfr::Find_TraditionalRedirMapping_FromRedirectedPath_ForwardSearch(c.Request_NormalizedPath);
+            if (c.map->Valid_mapping)
+            {
+                if (!c.map->IsAnExclusionToRedirect)
+                {
+                    c.WsRedirected = c.WsRequested;
+                    c.WsPackage = ReplacePathPart(c.WsRequested, c.map->RedirectedPathBase, c.map->PackagePathBase);
+                    if (c.WsPackage.find(L"\\VFS\\") != std::wstring::npos)
+                    {
+                        c.WsNative = ReplacePathPart(c.WsRequested, c.map->RedirectedPathBase, c.map->NativePathBase);
+                    }
+                    else
+                    {
+                        c.UsingNative = false;
+                    }
+                }
+                else
+                {
+                    c.WsRedirected = c.WsRequested;
+                    c.WsPackage = c.WsRequested;
+                    c.WsNative = c.WsRequested;
+                }
+            }
+            break;
+        default:
+            c.UsingNative = false;
+            break;
+        }
+        return c;
+    }
+
+    std::vector<std::wstring> make_corpus()
+    {
+        const std::wstring package = g_packageRootPath.wstring();
+        const std::wstring writable = g_writablePackageRootPath.wstring();
+        std::vector<std::wstring> corpus = {
+            LR"(C:\Users\Tester\AppData\Roaming\Contoso\App\settings.ini)",
+            LR"(C:\Users\Tester\AppData\Local\Contoso\cache.db)",
+            LR"(C:\Users\Tester\AppData\Local\Temp\x.tmp)",
+            LR"(C:\Users\Tester\Documents\Report.docx)",
+            LR"(C:\Windows\System32\kernel32.dll)",
+            LR"(C:\Windows\System32\catroot\{F750E6C3}\x.cat)",
+            LR"(C:\Windows\Fonts\arial.ttf)",
+            LR"(c:\windows\SYSTEM32\Drivers\..\msvcp140.dll)",
+            LR"(C:/Windows/SysWOW64/msvcr100.dll)",
+            LR"(C:\Program Files\Contoso\App\app.exe)",
+            LR"(C:\Program Files (x86)\Contoso\App\..\..\Common Files\x.dll)",
+            LR"(C:\Program Files\WindowsApps)",
+            LR"(c:\program files\windowsapps)",
+            LR"(C:\ProgramData\Contoso\license.dat)",
+            LR"(C:\Windows\..\boot.ini)",
+            LR"(C:\Elsewhere\file.txt)",
+            LR"(D:\Data\file.txt)",
+            package + LR"(\App\app.exe)",
+            package + LR"(\App\..\Config\app.config)",
+            package + LR"(\VFS\SystemX64\msvcp140.dll)",
+            package + LR"(\VFS\Local AppData\Contoso\defaults.ini)",
+            package + LR"(\VFS\Fonts\contoso.ttf)",
+            package + LR"(\VFS\Unmapped\file.txt)",
+            LR"(C:\PROGRA~1\WINDOW~1\CONTOS~1.0_X\App\app.exe)",
+            writable + LR"(\VFS\SystemX64\msvcp140.dll)",
+            writable + LR"(\App\settings.json)",
+            LR"(C:\Users\Tester\AppData\Local\Packages\Contoso.App_8wekyb3d8bbwe\LocalCache\Roaming\x.ini)",
+            LR"(settings.ini)",
+            LR"(..\..\Local\Contoso\cache.db)",
+            LR"(C:Contoso\settings.ini)",
+            LR"(\Windows\System32\kernel32.dll)",
+            LR"(\\?\C:\Windows\System32\drivers\..\kernel32.dll)",
+            LR"(\\?\STORAGE#Volume#{1234})",
+            LR"(\\.\pipe\contoso)",
+            LR"(\\server\share\folder\file.txt)",
+            LR"(ftp://server/file.txt)",
+            LR"(::{20D04FE0-3AEA-1069-A2D8-08002B30309D}\x)",
+            LR"(CON4:)",
+        };
+
+        // Longer than the inline storage, which holds 1040 characters, and than twice that
+        std::wstring folders;
+        while (folders.length() < 2200)
+        {
+            folders += L"Folder" + std::to_wstring(folders.length()) + L"\\";
+        }
+        for (auto length : { 300, 600, 1100, 2200 })
+        {
+            auto some = folders.substr(0, length);
+            corpus.push_back(LR"(C:\Windows\System32\)" + some + L"file.dll");
+            corpus.push_back(LR"(C:\Users\Tester\AppData\Roaming\)" + some + L"file.ini");
+            corpus.push_back(package + LR"(\VFS\SystemX64\)" + some + L"file.dll");
+            corpus.push_back(writable + LR"(\VFS\SystemX64\)" + some + L"..\\file.dll");
+            corpus.push_back(some + L"file.txt");
+        }
+        return corpus;
+    }
+
+    // Whether view is one of the segments of the request's storage, or the empty default
+    bool in_storage(const Cohorts& cohorts, psf::wzstring_view view)
+    {
+        auto& storage = cohorts.file_mfr.storage;
+        return view.empty() || ((view.data() >= storage.c_str()) && (view.data() + view.length() <= storage.c_str() + storage.size()));
+    }
+}
+
+int main()
+{
+    win32_stand_in::current_directory = currentDirectory;
+    add_mappings();
+    auto corpus = make_corpus();
+
+    for (auto& path : corpus)
+    {
+        auto expected = string_determine_cohorts(path);
+        Cohorts cohorts;
+        DetermineCohorts(path, &cohorts, false, 0, L"DetermineCohortsTest");
+
+        CHECK(cohorts.file_mfr.Request_OriginalPath == path);
+        CHECK(cohorts.file_mfr.Request_DosPathType == expected.Request_DosPathType);
+        CHECK(cohorts.file_mfr.Request_MfrPathType == expected.Request_MfrPathType);
+        CHECK(cohorts.file_mfr.Request_NormalizedPath == expected.Request_NormalizedPath);
+        CHECK(cohorts.WsRequested == expected.WsRequested);
+        CHECK(cohorts.WsRedirected == expected.WsRedirected);
+        CHECK(cohorts.WsPackage == expected.WsPackage);
+        CHECK(cohorts.WsNative == expected.WsNative);
+        CHECK(cohorts.UsingNative == expected.UsingNative);
+        CHECK(cohorts.map->Valid_mapping == expected.map->Valid_mapping);
+        CHECK(cohorts.map->NativePathBase == expected.map->NativePathBase);
+        CHECK(cohorts.map->IsAnExclusionToRedirect == (expected.map->IsAnExclusionToRedirect || expected.exclusion));
+        CHECK((cohorts.map == expected.map) == !expected.exclusion);
+
+        for (auto view : { cohorts.WsRequested, cohorts.WsRedirected, cohorts.WsPackage, cohorts.WsNative })
+        {
+            CHECK(view.c_str()[view.length()] == L'\0');
+            CHECK(in_storage(cohorts, view));
+        }
+    }
+
+    // Heap allocations per request, for the paths that fit in MAX_PATH and for all of them; the new version must not
+    // allocate at all for the first, and at most once for any path
+    auto count_allocations = [&](auto&& determine, bool shortOnly, std::size_t& most)
+    {
+        std::size_t paths = 0;
+        std::size_t total = 0;
+        for (auto& path : corpus)
+        {
+            if (!shortOnly || (path.length() < MAX_PATH))
+            {
+                auto before = g_allocations;
+                determine(path);
+                most = std::max(most, g_allocations - before);
+                total += g_allocations - before;
+                ++paths;
+            }
+        }
+        return static_cast<double>(total) / static_cast<double>(paths);
+    };
+    auto viaStrings = [](const std::wstring& path)
+    {
+        return string_determine_cohorts(path).WsRedirected.length();
+    };
+    auto viaStorage = [](const std::wstring& path)
+    {
+        Cohorts cohorts;
+        DetermineCohorts(path, &cohorts, false, 0, L"DetermineCohortsTest");
+        return cohorts.WsRedirected.length();
+    };
+    std::size_t mostStrings = 0;
+    std::size_t mostShortStorage = 0;
+    std::size_t mostStorage = 0;
+    auto shortStrings = count_allocations(viaStrings, true, mostStrings);
+    auto shortStorage = count_allocations(viaStorage, true, mostShortStorage);
+    auto allStrings = count_allocations(viaStrings, false, mostStrings);
+    auto allStorage = count_allocations(viaStorage, false, mostStorage);
+    CHECK(mostShortStorage == 0);
+    CHECK(mostStorage <= 1);
+
+    constexpr std::size_t iterations = 200000;
+    std::size_t sink = 0;
+    auto stringsTime = time_per_call(iterations, [&](std::size_t i) { sink += viaStrings(corpus[i % corpus.size()]); });
+    auto storageTime = time_per_call(iterations, [&](std::size_t i) { sink += viaStorage(corpus[i % corpus.size()]); });
+    CHECK(sink > 0);
+
+    std::printf("%zu requests: allocations per request (under MAX_PATH / all, most): strings %.1f / %.1f, %zu; "
+        "inline storage %.1f / %.1f, %zu; %.0f ns vs %.0f ns per request (%.1fx)\n", corpus.size(), shortStrings, allStrings,
+        mostStrings, shortStorage, allStorage, mostStorage, stringsTime, storageTime, stringsTime / storageTime);
+
+    return test_result("determine_cohorts");
+}
@@ -0,0 +1,149 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) TMurgent Technologies, LLP. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+//
+// Differential test of psf::dfa_regex against std::wregex: every pattern in the corpus (patterns taken from real
+// FileRedirectionFixup, RegLegacyFixups and launcher configs, plus randomly generated ones in the supported subset)
+// must give the same regex_match and regex_search answer as std::wregex on every input. Also reports the cost of a
+// match with each engine.
+
+#include <random>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include <dfa_regex.h>
+
+#include "portable_test.h"
+
+namespace
+{
+    const std::vector<std::wstring> g_configPatterns = {
+        LR"(.*)", LR"(.*\.txt)", LR"(.*\.log)", LR"(.*\/log)", LR"(.*\.[cC][oO][mM]$)", LR"(.*\.[dD][lL][lL]$)",
+        LR"(.*\.[eE][xX][eE]$)", LR"(.*\.[fF][oO][nN]$)", LR"(.*\.[oO][cC][xX]$)", LR"(.*\.[tT][lL][bB]$)",
+        LR"(.*\.[tT][tT][cC]$)", LR"(.*\.[tT][tT][fF]$)", LR"(.*\.[tTiI][xXnN][tTiI]$)", LR"(.*\.[zZ][iI][pP].*)",
+        LR"(AutoUpdate\.ini$)", LR"(HideThis.*)", LR"(MyName.*)", LR"(OrThat.*)", LR"(PrimaryApp$)", LR"(PsfLauncher.*)",
+        LR"(Software\\Vendor_Deletion\\.*)", LR"(Software\\Vendor_Deletion\\SubKey\\.*)", LR"(SubKey.*)",
+        LR"(^PsfLauncher.*)", LR"(^SOFTWARE\\Vendor_Covered.*)", LR"(^SOFTWARE\\Wow3264Node\\Vendor_Covered.*)",
+        LR"(^SOftWARE\\Vendor\\.*)", LR"(^Software\\Vendor.*)", LR"(^[Cc][Mm][Dd].*)", LR"(^[Pp]ower[Ss]hell.*)",
+        LR"(^notme.exe$)", LR"(name\.exe)", LR"([^\\]*\.ini)", LR"((?:Logs|Temp)\\.*)", LR"(a+b?c*)", LR"(x|y|(zz)+)",
+        LR"(.*?\.dat)", LR"(^$)", LR"([a-f0-9]+\.tmp)",
+        // Outside of the DFA subset; these must still give std::wregex answers through the fallback
+        LR"(\d+\.log)", LR"((a)\1)", LR"(a{2,3})", LR"(\bword\b)",
+    };
+
+    const std::vector<std::wstring> g_inputs = {
+        L"", L"a", L"app.log", L"APP.LOG", L"dir/log", L"dir\\log", L"x.dll", L"x.DLL", L"x.dll.bak", L"font.ttf",
+        L"archive.zip", L"archive.ZIP.old", L"AutoUpdate.ini", L"noAutoUpdate.ini", L"HideThis", L"HideThisToo",
+        L"PrimaryApp", L"PrimaryApp2", L"PsfLauncher64.exe", L"Software\\Vendor_Deletion\\Key",
+        L"Software\\Vendor_Deletion\\SubKey\\Value", L"SOFTWARE\\Vendor_Covered\\x", L"Software\\Vendor\\x",
+        L"SOFTWARE\\Wow3264Node\\Vendor_Covered", L"cmd.exe", L"Cmd.exe", L"powershell.exe", L"PowerShell.exe",
+        L"notme.exe", L"notmeXexe", L"name.exe", L"xname.exe", L"settings.ini", L"sub\\settings.ini", L"Logs\\a",
+        L"Temp\\b", L"abc", L"ac", L"bbb", L"zzzz", L"x", L"y", L"records.dat", L"12.log", L"aa", L"aaa", L"a word here",
+        L"deadbeef.tmp", L"DEADBEEF.tmp",
+    };
+
+    std::wstring random_pattern(std::mt19937& random)
+    {
+        static const std::vector<std::wstring> atoms = {
+            L"a", L"b", L"A", L".", L"\\.", L"\\\\", L"[ab]", L"[^a]", L"[a-c]", L"(a|b)", L"(?:ab|c)", L"x",
+        };
+        static const std::vector<std::wstring> quantifiers = { L"", L"", L"*", L"+", L"?", L"*?" };
+
+        std::wstring pattern;
+        if (random() % 4 == 0)
+        {
+            pattern += L'^';
+        }
+        auto count = 1 + random() % 5;
+        for (unsigned i = 0; i < count; ++i)
+        {
+            pattern += atoms[random() % atoms.size()];
+            pattern += quantifiers[random() % quantifiers.size()];
+        }
+        if (random() % 4 == 0)
+        {
+            pattern += L'$';
+        }
+        return pattern;
+    }
+
+    std::wstring random_input(std::mt19937& random)
+    {
+        static const std::wstring alphabet = L"abcABx.\\";
+        std::wstring input;
+        auto length = random() % 8;
+        for (unsigned i = 0; i < length; ++i)
+        {
+            input += alphabet[random() % alphabet.size()];
+        }
+        return input;
+    }
+
+    void compare(const std::wstring& pattern, bool icase, const std::vector<std::wstring>& inputs)
+    {
+        auto flags = std::regex_constants::ECMAScript;
+        if (icase)
+        {
+            flags |= std::regex_constants::icase;
+        }
+        std::wregex expected(pattern, flags);
+        psf::dfa_regex actual(pattern, icase);
+        for (auto& input : inputs)
+        {
+            bool matchOk = actual.match(input) == std::regex_match(input, expected);
+            bool searchOk = actual.search(input) == std::regex_search(input, expected);
+            if (!matchOk || !searchOk)
+            {
+                std::printf("pattern '%ls' (icase %d) differs on '%ls'\n", pattern.c_str(), icase, input.c_str());
+            }
+            CHECK(matchOk);
+            CHECK(searchOk);
+        }
+    }
+}
+
+int main()
+{
+    std::size_t dfaCount = 0;
+    for (auto& pattern : g_configPatterns)
+    {
+        compare(pattern, false, g_inputs);
+        compare(pattern, true, g_inputs);
+        dfaCount += psf::dfa_regex(pattern).is_dfa() ? 1 : 0;
+    }
+    std::printf("%zu of %zu config patterns compile to a DFA\n", dfaCount, g_configPatterns.size());
+    CHECK(dfaCount == g_configPatterns.size() - 4);
+
+    std::mt19937 random(2);
+    std::vector<std::wstring> randomInputs;
+    for (int i = 0; i < 40; ++i)
+    {
+        randomInputs.push_back(random_input(random));
+    }
+    for (int i = 0; i < 1500; ++i)
+    {
+        compare(random_pattern(random), (i % 2) != 0, randomInputs);
+    }
+
+    // Invalid patterns throw exactly as std::wregex does
+    for (auto pattern : { L"(", L"[a", L"*a", L"a)" })
+    {
+        bool stdThrew = false;
+        bool dfaThrew = false;
+        try { std::wregex check(pattern); } catch (std::regex_error&) { stdThrew = true; }
+        try { psf::dfa_regex check(pattern); } catch (std::regex_error&) { dfaThrew = true; }
+        CHECK(stdThrew == dfaThrew);
+    }
+
+    std::wregex stdRegex(LR"(.*\.[tTiI][xXnN][tTiI]$)", std::regex_constants::ECMAScript | std::regex_constants::icase);
+    psf::dfa_regex dfaRegex(LR"(.*\.[tTiI][xXnN][tTiI]$)", true);
+    std::wstring path = L"Contoso\\Application Data\\Settings\\Profiles\\Default\\preferences.ini";
+    std::size_t sink = 0;
+    auto stdTime = time_per_call(20000, [&](std::size_t) { sink += std::regex_match(path, stdRegex) ? 1 : 0; });
+    auto dfaTime = time_per_call(20000, [&](std::size_t) { sink += dfaRegex.match(path) ? 1 : 0; });
+    std::printf("regex_match: std::wregex %.0f ns, dfa_regex %.0f ns (%.1fx) [%zu]\n", stdTime, dfaTime, stdTime / dfaTime, sink);
+
+    return test_result("dfa_regex");
+}
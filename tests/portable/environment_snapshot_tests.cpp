@@ -0,0 +1,130 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) TMurgent Technologies, LLP. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+//
+// Runs EnvVarFixup's environment_snapshot (built from its own source) over two stand-in keys whose changes the test
+// signals by hand, in place of RegNotifyChangeKeyValue. Checks that lookups are answered from the snapshot until a key
+// reports a change, that a key which cannot report changes is read on every lookup, and that writing a variable through
+// the snapshot (as SetEnvironmentVariable does for a `useregistry` variable) has both keys read again.
+
+#include <map>
+#include <optional>
+#include <string>
+
+#include <windows.h>
+
+#include "EnvironmentSnapshot.h"
+
+#include "portable_test.h"
+
+namespace
+{
+    struct fake_key
+    {
+        std::map<std::wstring, std::wstring> values;
+        bool reportsChanges = true;
+        bool changed = false;
+        bool writable = true;
+        std::size_t reads = 0;
+    };
+
+    class fake_source : public environment_source
+    {
+    public:
+        explicit fake_source(fake_key& key) :
+            m_key(key)
+        {
+        }
+
+        std::vector<std::pair<std::wstring, std::wstring>> read() override
+        {
+            ++m_key.reads;
+            m_key.changed = false;
+            return { m_key.values.begin(), m_key.values.end() };
+        }
+
+        bool unchanged() noexcept override
+        {
+            return m_key.reportsChanges && !m_key.changed;
+        }
+
+        std::optional<LSTATUS> write(const std::wstring& name, const std::wstring& value) override
+        {
+            if (!m_key.writable)
+            {
+                return std::nullopt;
+            }
+            // Setting a value changes the key without it being signalled yet, as RegSetValueEx does until the
+            // notification arrives
+            m_key.values[name] = value;
+            return ERROR_SUCCESS;
+        }
+
+    private:
+        fake_key& m_key;
+    };
+
+    std::optional<std::wstring> lookup(environment_snapshot& snapshot, const std::wstring& name)
+    {
+        std::wstring value;
+        if (snapshot.lookup(name, value))
+        {
+            return value;
+        }
+        return std::nullopt;
+    }
+}
+
+int main()
+{
+    fake_key user;
+    user.values = { { L"Path", L"C:\\Users\\Tester\\bin" }, { L"TEMP", L"C:\\Users\\Tester\\AppData\\Local\\Temp" } };
+    fake_key machine;
+    machine.values = { { L"PATH", L"C:\\Windows\\System32" }, { L"ComSpec", L"C:\\Windows\\System32\\cmd.exe" } };
+    environment_snapshot snapshot(std::make_unique<fake_source>(user), std::make_unique<fake_source>(machine));
+
+    // The user's key first, then the machine's, by name in any case; both are read once
+    CHECK(lookup(snapshot, L"PATH") == L"C:\\Users\\Tester\\bin");
+    CHECK(lookup(snapshot, L"comspec") == L"C:\\Windows\\System32\\cmd.exe");
+    CHECK(!lookup(snapshot, L"Missing"));
+    CHECK((user.reads == 1) && (machine.reads == 1));
+
+    // A change that has not been signalled is not seen; once it is, only that key is read again
+    machine.values[L"ComSpec"] = L"C:\\Tools\\cmd.exe";
+    CHECK(lookup(snapshot, L"ComSpec") == L"C:\\Windows\\System32\\cmd.exe");
+    machine.changed = true;
+    CHECK(lookup(snapshot, L"ComSpec") == L"C:\\Tools\\cmd.exe");
+    CHECK((user.reads == 1) && (machine.reads == 2));
+
+    // invalidate has both read again
+    snapshot.invalidate();
+    CHECK(lookup(snapshot, L"TEMP") == L"C:\\Users\\Tester\\AppData\\Local\\Temp");
+    CHECK((user.reads == 2) && (machine.reads == 3));
+
+    // SetEnvironmentVariable for a useregistry variable writes through the snapshot, which then reads both keys again
+    // even though the write has not been signalled
+    auto written = snapshot.set(L"AppHome", L"C:\\Apps\\Contoso");
+    CHECK(written && (*written == ERROR_SUCCESS));
+    CHECK(user.values[L"AppHome"] == L"C:\\Apps\\Contoso");
+    CHECK(lookup(snapshot, L"APPHOME") == L"C:\\Apps\\Contoso");
+    CHECK((user.reads == 3) && (machine.reads == 4));
+
+    // A key that cannot be opened for writing is left to the caller, and nothing is read again
+    user.writable = false;
+    CHECK(!snapshot.set(L"AppHome", L"C:\\Elsewhere"));
+    CHECK(lookup(snapshot, L"AppHome") == L"C:\\Apps\\Contoso");
+    CHECK((user.reads == 3) && (machine.reads == 4));
+
+    // Without change notification there is no telling, so the key is read on every lookup
+    machine.reportsChanges = false;
+    std::size_t lookups = 0;
+    for (; lookups < 10; ++lookups)
+    {
+        CHECK(lookup(snapshot, L"Path") == L"C:\\Users\\Tester\\bin");
+    }
+    CHECK((user.reads == 3) && (machine.reads == 4 + lookups));
+
+    std::printf("%zu reads of the user key and %zu of the machine key\n", user.reads, machine.reads);
+    return test_result("environment_snapshot");
+}
@@ -0,0 +1,241 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) TMurgent Technologies, LLP. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+//
+// Checks psf::log_queue (long messages kept whole, overflow counted, order kept per thread), then logs from several
+// threads to a file the two ways PSF can: each thread writing its own messages out as it makes them (as with
+// OutputDebugString), or pushing them to the queue for one writer thread that appends them to the file in batches (as
+// PsfRuntime's file sink does). So that both write every message, the benchmark retries a push that finds the queue
+// full, where PSF would drop the message. Reports the time to get all of the messages into the file each way.
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include <psf_log_queue.h>
+
+#include "portable_test.h"
+
+namespace
+{
+    constexpr int threadCount = 4;
+    constexpr int messagesPerThread = 20000;
+
+    std::string make_message(int thread, int index)
+    {
+        std::string message = "thread " + std::to_string(thread) + " message " + std::to_string(index) + " ";
+        // Every 100th message is longer than a queue slot, as a logged command line or environment block can be
+        message.append((index % 100 == 0) ? 3000 : 60, static_cast<char>('a' + index % 26));
+        return message;
+    }
+
+    // What PsfRuntime's writer does for the file sink: append the drained records, then write them with one call
+    class file_writer
+    {
+    public:
+        explicit file_writer(const std::string& path) : m_file(std::fopen(path.c_str(), "wb"))
+        {
+        }
+
+        ~file_writer()
+        {
+            std::fclose(m_file);
+        }
+
+        void write_pending(psf::log_queue& queue)
+        {
+            queue.drain([&](const psf::log_record& record)
+            {
+                m_buffer.append(record.narrow(), record.length);
+                m_buffer.append("\r\n");
+            });
+            if (!m_buffer.empty())
+            {
+                std::fwrite(m_buffer.data(), 1, m_buffer.size(), m_file);
+                std::fflush(m_file);
+                m_buffer.clear();
+            }
+        }
+
+    private:
+        std::FILE* m_file;
+        std::string m_buffer;
+    };
+
+    // Checks that each thread's messages are all there, whole and in order
+    std::size_t check_log(const std::string& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        std::vector<int> next(threadCount, 0);
+        std::size_t lines = 0;
+        std::size_t skipped = 0;
+        bool ok = true;
+        for (std::string line; std::getline(file, line); ++lines)
+        {
+            if (!line.empty() && (line.back() == '\r'))
+            {
+                line.pop_back();
+            }
+            int thread = -1;
+            int index = -1;
+            if ((std::sscanf(line.c_str(), "thread %d message %d ", &thread, &index) != 2) || (thread < 0) ||
+                (thread >= threadCount) || (index < next[thread]) || (line != make_message(thread, index)))
+            {
+                ok = false;
+                break;
+            }
+            skipped += index - next[thread];
+            next[thread] = index + 1;
+        }
+        for (auto count : next)
+        {
+            skipped += messagesPerThread - count;
+        }
+        CHECK(ok);
+        CHECK(skipped == 0);
+        return lines;
+    }
+}
+
+int main()
+{
+    // Long messages are not cut short, and are freed once drained
+    {
+        psf::log_queue queue;
+        std::string longMessage(5000, 'x');
+        std::wstring longWide(2000, L'y');
+        CHECK(queue.push("short", 5));
+        CHECK(queue.push(longMessage.c_str(), longMessage.length()));
+        CHECK(queue.push(longWide.c_str(), longWide.length()));
+        std::vector<std::string> narrow;
+        std::vector<std::wstring> wide;
+        queue.drain([&](const psf::log_record& record)
+        {
+            if (record.is_wide)
+            {
+                wide.emplace_back(record.wide(), record.length);
+                CHECK(record.wide()[record.length] == L'\0');
+            }
+            else
+            {
+                narrow.emplace_back(record.narrow(), record.length);
+                CHECK(record.narrow()[record.length] == '\0');
+            }
+        });
+        CHECK((narrow.size() == 2) && (narrow[0] == "short") && (narrow[1] == longMessage));
+        CHECK((wide.size() == 1) && (wide[0] == longWide));
+
+        // A full queue drops and counts, including long messages, and frees them
+        for (std::size_t i = 0; i < psf::log_queue::capacity; ++i)
+        {
+            CHECK(queue.push("x", 1));
+        }
+        CHECK(!queue.push("y", 1));
+        CHECK(!queue.push(longMessage.c_str(), longMessage.length()));
+        CHECK(queue.dropped() == 2);
+        CHECK(queue.drain([](const psf::log_record&) {}) == psf::log_queue::capacity);
+        CHECK(queue.empty());
+
+        // Undrained long messages are freed with the queue
+        CHECK(queue.push(longMessage.c_str(), longMessage.length()));
+    }
+
+    auto folder = "/tmp/psf_log_queue_" + std::to_string(::getpid());
+    auto syncPath = folder + "-sync.log";
+    auto asyncPath = folder + "-async.log";
+
+    std::vector<std::vector<std::string>> messages(threadCount);
+    for (int thread = 0; thread < threadCount; ++thread)
+    {
+        for (int index = 0; index < messagesPerThread; ++index)
+        {
+            messages[thread].push_back(make_message(thread, index));
+        }
+    }
+
+    // Each logging thread writes its own message out before it carries on
+    auto syncTime = time_once([&]
+    {
+        std::FILE* file = std::fopen(syncPath.c_str(), "wb");
+        std::mutex fileLock;
+        std::vector<std::thread> threads;
+        for (int thread = 0; thread < threadCount; ++thread)
+        {
+            threads.emplace_back([&, thread]
+            {
+                for (auto& message : messages[thread])
+                {
+                    std::lock_guard<std::mutex> lock(fileLock);
+                    std::fwrite(message.data(), 1, message.size(), file);
+                    std::fwrite("\r\n", 1, 2, file);
+                    std::fflush(file);
+                }
+            });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        std::fclose(file);
+    });
+    CHECK(check_log(syncPath) == threadCount * messagesPerThread);
+
+    // The logging threads only push; one writer thread drains the queue to the file
+    std::uint64_t fullCount = 0;
+    auto asyncTime = time_once([&]
+    {
+        psf::log_queue queue;
+        file_writer writer(asyncPath);
+        std::atomic<bool> done{ false };
+        std::thread writerThread([&]
+        {
+            while (!done.load())
+            {
+                writer.write_pending(queue);
+                if (queue.empty())
+                {
+                    std::this_thread::yield();
+                }
+            }
+            writer.write_pending(queue);
+        });
+
+        std::vector<std::thread> threads;
+        for (int thread = 0; thread < threadCount; ++thread)
+        {
+            threads.emplace_back([&, thread]
+            {
+                for (auto& message : messages[thread])
+                {
+                    while (!queue.push(message.c_str(), message.size()))
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        done = true;
+        writerThread.join();
+        fullCount = queue.dropped();
+    });
+    CHECK(check_log(asyncPath) == threadCount * messagesPerThread);
+
+    std::printf("%d threads x %d messages to a file: written by each logging thread %.1f ms, queued for one writer %.1f ms "
+        "(%.1fx); the queue was full %llu time(s)\n", threadCount, messagesPerThread, syncTime, asyncTime, syncTime / asyncTime,
+        static_cast<unsigned long long>(fullCount));
+
+    std::remove(syncPath.c_str());
+    std::remove(asyncPath.c_str());
+    return test_result("log_queue");
+}
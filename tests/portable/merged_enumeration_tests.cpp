@@ -0,0 +1,180 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) TMurgent Technologies, LLP. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+//
+// Enumerates synthetic layered directories (a redirected, a package and a native layer that overlap) through
+// merged_directory_enumeration and checks that it returns the same names, in the same order, as the list based
+// duplicate check that FindNextFile used before, and times them. The list based check is quadratic (about 11 seconds
+// for 10k entries), so it is only run on the 1k directory; the 10k and 100k directories are checked against a
+// std::unordered_set of lower-cased names instead.
+
+#include <algorithm>
+#include <cwctype>
+#include <list>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <file_name_set.h>
+#include <merged_directory_enumeration.h>
+
+#include "portable_test.h"
+
+namespace
+{
+    struct fake_entry
+    {
+        std::wstring file_name;
+
+        std::wstring_view name() const noexcept
+        {
+            return file_name;
+        }
+    };
+
+    // Hands out a layer's listing in batches, the way FindFirstFileEx with FIND_FIRST_EX_LARGE_FETCH would
+    struct fake_source
+    {
+        using entry_type = fake_entry;
+
+        const std::vector<std::wstring>* names;
+        std::size_t position = 0;
+
+        psf::directory_batch_result read_batch(std::vector<fake_entry>& batch)
+        {
+            if (position == names->size())
+            {
+                return psf::directory_batch_result::end;
+            }
+            auto end = std::min(position + 128, names->size());
+            for (; position < end; ++position)
+            {
+                batch.push_back(fake_entry{ (*names)[position] });
+            }
+            return psf::directory_batch_result::entries;
+        }
+    };
+
+    using layers = std::vector<std::vector<std::wstring>>;
+
+    layers make_layers(std::size_t count)
+    {
+        layers result(3);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            auto name = L"File" + std::to_wstring(i) + L".dat";
+            result[1].push_back(name);
+            if (i % 3 == 0)
+            {
+                // Redirected copies of package files, with the case changed as apps tend to do
+                std::wstring upper = name;
+                std::transform(upper.begin(), upper.end(), upper.begin(), [](wchar_t ch) { return static_cast<wchar_t>(std::towupper(ch)); });
+                result[0].push_back(upper);
+            }
+            if (i % 2 == 0)
+            {
+                result[2].push_back(name);
+                result[2].push_back(L"Native" + std::to_wstring(i) + L".dat");
+            }
+        }
+        return result;
+    }
+
+    // What FindNextFile did before: remember every name returned in a std::list, and scan it for each new name
+    std::vector<std::wstring> list_merge(const layers& input)
+    {
+        std::list<std::wstring> returned;
+        std::vector<std::wstring> result;
+        for (auto& layer : input)
+        {
+            for (auto& name : layer)
+            {
+                bool found = false;
+                for (auto item : returned)
+                {
+                    if ((item.length() == name.length()) && std::equal(item.begin(), item.end(), name.begin(),
+                        [](wchar_t lhs, wchar_t rhs) { return std::towlower(lhs) == std::towlower(rhs); }))
+                    {
+                        found = true;
+                        break;
+                    }
+                }
+                if (!found)
+                {
+                    returned.push_back(name);
+                    result.push_back(name);
+                }
+            }
+        }
+        return result;
+    }
+
+    std::vector<std::wstring> reference_merge(const layers& input)
+    {
+        std::unordered_set<std::wstring> returned;
+        std::vector<std::wstring> result;
+        for (auto& layer : input)
+        {
+            for (auto& name : layer)
+            {
+                std::wstring folded = name;
+                std::transform(folded.begin(), folded.end(), folded.begin(), [](wchar_t ch) { return static_cast<wchar_t>(std::towlower(ch)); });
+                if (returned.insert(std::move(folded)).second)
+                {
+                    result.push_back(name);
+                }
+            }
+        }
+        return result;
+    }
+
+    std::vector<std::wstring> set_merge(const layers& input)
+    {
+        psf::merged_directory_enumeration<fake_source> merged;
+        for (auto& layer : input)
+        {
+            merged.add_layer(fake_source{ &layer });
+        }
+
+        std::vector<std::wstring> result;
+        while (auto entry = merged.next())
+        {
+            result.emplace_back(entry->name());
+        }
+        CHECK(!merged.failed());
+        return result;
+    }
+}
+
+int main()
+{
+    psf::file_name_set<> names;
+    CHECK(names.insert(L"Readme.TXT"));
+    CHECK(!names.insert(L"readme.txt"));
+    CHECK(names.contains(L"README.txt"));
+    CHECK(!names.contains(L"readme.tx"));
+    CHECK(names.size() == 1);
+
+    for (std::size_t count : { 1000, 10000, 100000 })
+    {
+        auto input = make_layers(count);
+        std::vector<std::wstring> viaSet;
+        auto setTime = time_once([&] { viaSet = set_merge(input); });
+        CHECK(viaSet.size() == count + count / 2 + (count % 2));
+        CHECK(viaSet == reference_merge(input));
+        if (count <= 1000)
+        {
+            std::vector<std::wstring> viaList;
+            auto listTime = time_once([&] { viaList = list_merge(input); });
+            CHECK(viaSet == viaList);
+            std::printf("%zu entries: list %.1f ms, hashed set %.1f ms (%.0fx)\n", count, listTime, setTime, listTime / setTime);
+        }
+        else
+        {
+            std::printf("%zu entries: hashed set %.1f ms\n", count, setTime);
+        }
+    }
+
+    return test_result("merged_directory_enumeration");
+}
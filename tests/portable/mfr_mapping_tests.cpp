@@ -0,0 +1,305 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) TMurgent Technologies, LLP. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+//
+// Runs MFRFixup's folder mapping lookups (built from ManagedFileMappingIndex.cpp, over a g_MfrFolderMappings about the
+// size of the one Initialize_MFR_Mappings creates) and checks each of the Find_* functions against the front to back
+// scan of the list that it replaced: the first accepted mapping in list order whose base is a parent of the path. The
+// scan copies each mapping it looks at, as the old lookups did. Then times the lookups, and DetermineCohorts (built from
+// its own source) over requests for each kind of path, with and without the cost of the scan in place of the index.
+
+#include <algorithm>
+#include <cwctype>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <windows.h>
+
+#include "DetermineCohorts.h"
+
+#include "portable_test.h"
+
+// Set up by the fixup from the package and its configuration; here the package is installed for a user named Tester
+std::filesystem::path g_packageRootPath = LR"(C:\Program Files\WindowsApps\Contoso.App_1.0.0.0_x64__8wekyb3d8bbwe)";
+std::filesystem::path g_packageVfsRootPath = LR"(C:\Program Files\WindowsApps\Contoso.App_1.0.0.0_x64__8wekyb3d8bbwe\VFS)";
+std::filesystem::path g_redirectRootPath = LR"(C:\Users\Tester\AppData\Local\Packages\Contoso.App_8wekyb3d8bbwe\LocalCache)";
+std::filesystem::path g_writablePackageRootPath = LR"(C:\Users\Tester\AppData\Local\Packages\Contoso.App_8wekyb3d8bbwe\LocalCache\Local\Microsoft\WritablePackageRoot)";
+std::filesystem::path g_short_packageRootPath = LR"(C:\PROGRA~1\WINDOW~1\CONTOS~1.0_X)";
+std::filesystem::path g_short_packageVfsRootPath = LR"(C:\PROGRA~1\WINDOW~1\CONTOS~1.0_X\VFS)";
+std::filesystem::path g_short_redirectRootPath = LR"(C:\Users\Tester\AppData\Local\Packages\CONTOS~1\LOCALC~1)";
+std::filesystem::path g_short_writablePackageRootPath = LR"(C:\Users\Tester\AppData\Local\Packages\CONTOS~1\LOCALC~1\Local\MICROS~1\WRITAB~1)";
+std::filesystem::path FID_RootDrive = LR"(C:\)";
+
+namespace
+{
+    using mfr::mfr_folder_mapping;
+    using mfr::mfr_redirect_flags;
+
+    enum class lookup
+    {
+        local_from_native,
+        local_from_package,
+        traditional_from_native,
+        traditional_from_package,
+        traditional_from_redirected,
+    };
+
+    bool is_separator(wchar_t ch)
+    {
+        return (ch == L'\\') || (ch == L'/');
+    }
+
+    // base is the native() text of a std::filesystem::path, which is narrow on other platforms than Windows; the test
+    // paths are all ASCII
+    template <typename String>
+    bool path_relative_to(std::wstring_view path, const String& base)
+    {
+        if (path.length() < base.length())
+        {
+            return false;
+        }
+        for (std::size_t i = 0; i < base.length(); ++i)
+        {
+            bool separators = is_separator(path[i]) && is_separator(base[i]);
+            if (!separators && (std::towlower(path[i]) != std::towlower(static_cast<wchar_t>(base[i]))))
+            {
+                return false;
+            }
+        }
+        return (path.length() == base.length()) || is_separator(path[base.length()]);
+    }
+
+    bool is_local(const mfr_folder_mapping& map)
+    {
+        return map.RedirectionFlags == mfr_redirect_flags::prefer_redirection_local;
+    }
+
+    bool is_traditional(const mfr_folder_mapping& map)
+    {
+        return (map.RedirectionFlags != mfr_redirect_flags::disabled) && !is_local(map);
+    }
+
+    // The old lookups: a copy of every mapping looked at, and a copy of the path
+    mfr_folder_mapping scan_find(lookup which, std::wstring WsPath)
+    {
+        bool local = (which == lookup::local_from_native) || (which == lookup::local_from_package);
+        for (mfr_folder_mapping map : mfr::g_MfrFolderMappings)
+        {
+            const auto& base = ((which == lookup::local_from_native) || (which == lookup::traditional_from_native)) ? map.NativePathBase :
+                (which == lookup::traditional_from_redirected) ? map.RedirectedPathBase : map.PackagePathBase;
+            if ((local ? is_local(map) : is_traditional(map)) && path_relative_to(WsPath, base.native()))
+            {
+                return map;
+            }
+        }
+
+        // Package files outside of the VFS map to the writable package root
+        if ((which == lookup::traditional_from_package) && !path_relative_to(WsPath, g_packageVfsRootPath.native()) &&
+            path_relative_to(WsPath, g_packageRootPath.native()))
+        {
+            mfr_folder_mapping packagemap = mfr::MakeInvalidMapping();
+            packagemap.Valid_mapping = true;
+            packagemap.DoesRuntimeMapNativeToVFS = false;
+            packagemap.NativePathBase = FID_RootDrive;
+            packagemap.PackagePathBase = g_packageRootPath;
+            packagemap.RedirectedPathBase = g_writablePackageRootPath;
+            packagemap.RedirectionFlags = mfr_redirect_flags::prefer_redirection_containerized;
+            return packagemap;
+        }
+        return mfr::MakeInvalidMapping();
+    }
+
+    const mfr_folder_mapping& index_find(lookup which, std::wstring_view WsPath)
+    {
+        switch (which)
+        {
+        case lookup::local_from_native:
+            return mfr::Find_LocalRedirMapping_FromNativePath_ForwardSearch(WsPath);
+        case lookup::local_from_package:
+            return mfr::Find_LocalRedirMapping_FromPackagePath_ForwardSearch(WsPath);
+        case lookup::traditional_from_native:
+            return mfr::Find_TraditionalRedirMapping_FromNativePath_ForwardSearch(WsPath);
+        case lookup::traditional_from_package:
+            return mfr::Find_TraditionalRedirMapping_FromPackagePath_ForwardSearch(WsPath);
+        case lookup::traditional_from_redirected:
+        default:
+            return mfr::Find_TraditionalRedirMapping_FromRedirectedPath_ForwardSearch(WsPath);
+        }
+    }
+
+    // The lookups that DetermineCohorts makes for a request, given its normalized path; returns whether the last one
+    // found a mapping
+    template <typename Find>
+    bool cohort_lookups(mfr::mfr_path_types pathType, const std::wstring& normalizedPath, Find&& find)
+    {
+        switch (pathType)
+        {
+        case mfr::mfr_path_types::in_native_area:
+            return find(lookup::local_from_native, normalizedPath) || find(lookup::traditional_from_native, normalizedPath);
+        case mfr::mfr_path_types::in_package_pvad_area:
+            return find(lookup::traditional_from_package, normalizedPath);
+        case mfr::mfr_path_types::in_package_vfs_area:
+            return find(lookup::local_from_package, normalizedPath) || find(lookup::traditional_from_package, normalizedPath);
+        case mfr::mfr_path_types::in_redirection_area_writablepackageroot:
+            return find(lookup::traditional_from_redirected, normalizedPath);
+        default:
+            return false;
+        }
+    }
+
+    // About as many mappings as Initialize_MFR_Mappings creates, more specific paths first; the second copy of each
+    // folder stands in for the traditional mappings of the same folders
+    std::vector<std::wstring> add_mappings()
+    {
+        const std::vector<std::wstring> natives = {
+            LR"(C:\Windows\System32\catroot)", LR"(C:\Windows\System32\drivers\etc)", LR"(C:\Windows\System32\spool)",
+            LR"(C:\Windows\System32)", LR"(C:\Windows\SysWOW64)", LR"(C:\Windows\Fonts)", LR"(C:\Windows)",
+            LR"(C:\Program Files\Common Files)", LR"(C:\Program Files (x86)\Common Files)", LR"(C:\Program Files)",
+            LR"(C:\Program Files (x86))", LR"(C:\ProgramData)", LR"(C:\Users\Public\Documents)", LR"(C:\Users\Public)",
+            LR"(C:\Users\Tester\AppData\Local\Temp)", LR"(C:\Users\Tester\AppData\LocalLow)", LR"(C:\Users\Tester\AppData\Local)",
+            LR"(C:\Users\Tester\AppData\Roaming\Microsoft\Windows\Start Menu)", LR"(C:\Users\Tester\AppData\Roaming)",
+            LR"(C:\Users\Tester\Documents\My Music)", LR"(C:\Users\Tester\Documents)", LR"(C:\Users\Tester\Desktop)",
+            LR"(C:\Users\Tester\Downloads)", LR"(C:\Users\Tester\Pictures)", LR"(C:\Users\Tester\Videos)", LR"(C:\Users\Tester\Music)",
+        };
+
+        for (std::size_t copy = 0; copy < 2; ++copy)
+        {
+            for (auto& native : natives)
+            {
+                auto mapIndex = mfr::g_MfrFolderMappings.size();
+                auto flags = (copy == 1) ? ((mapIndex % 4 == 0) ? mfr_redirect_flags::prefer_redirection_if_package_vfs : mfr_redirect_flags::prefer_redirection_containerized) :
+                    (mapIndex % 7 == 5) ? mfr_redirect_flags::disabled :
+                    (mapIndex % 3 == 1) ? mfr_redirect_flags::prefer_redirection_containerized : mfr_redirect_flags::prefer_redirection_local;
+
+                mfr_folder_mapping map;
+                map.Valid_mapping = true;
+                map.IsAnExclusionToRedirect = (native == LR"(C:\Windows\Fonts)");
+                map.NativePathBase = native;
+                map.FolderId = L"{" + std::to_wstring(mapIndex) + L"}";
+                map.VFSFolderName = L"VFS" + std::to_wstring(mapIndex);
+                map.PackagePathBase = g_packageVfsRootPath.wstring() + L"\\" + map.VFSFolderName;
+                map.DoesRuntimeMapNativeToVFS = false;
+                map.RedirectedPathBase = (flags == mfr_redirect_flags::prefer_redirection_local) ? std::filesystem::path(native) :
+                    std::filesystem::path(g_writablePackageRootPath.wstring() + L"\\VFS\\" + map.VFSFolderName);
+                map.RedirectionFlags = flags;
+                mfr::g_MfrFolderMappings.push_back(std::move(map));
+            }
+        }
+        mfr::BuildMappingIndexes();
+        return natives;
+    }
+
+    bool same_mapping(const mfr_folder_mapping& actual, const mfr_folder_mapping& expected)
+    {
+        return (actual.Valid_mapping == expected.Valid_mapping) &&
+            (!expected.Valid_mapping ||
+                ((actual.FolderId == expected.FolderId) && (actual.NativePathBase == expected.NativePathBase) &&
+                (actual.PackagePathBase == expected.PackagePathBase) && (actual.RedirectedPathBase == expected.RedirectedPathBase) &&
+                (actual.RedirectionFlags == expected.RedirectionFlags)));
+    }
+}
+
+int main()
+{
+    win32_stand_in::current_directory = LR"(C:\Users\Tester\AppData\Roaming\Contoso\App)";
+    auto natives = add_mappings();
+
+    // Paths beneath each of the bases of each mapping, in mixed case, and beneath the package root
+    const std::vector<std::wstring> leaves = {
+        L"app.log", L"Contoso\\settings.ini", L"Contoso\\Data\\records.xml", L"x.tmp", L"deep\\er\\file.bin",
+    };
+    std::mt19937 random(8);
+    std::vector<std::wstring> paths;
+    for (std::size_t i = 0; i < 4000; ++i)
+    {
+        auto& map = mfr::g_MfrFolderMappings[random() % mfr::g_MfrFolderMappings.size()];
+        auto& base = (i % 3 == 0) ? map.NativePathBase : (i % 3 == 1) ? map.PackagePathBase : map.RedirectedPathBase;
+        auto path = base.wstring() + L"\\" + leaves[random() % leaves.size()];
+        if (random() % 3 == 0)
+        {
+            std::transform(path.begin(), path.end(), path.begin(), [](wchar_t ch) { return static_cast<wchar_t>(std::towupper(ch)); });
+        }
+        paths.push_back(std::move(path));
+    }
+    paths.push_back(g_packageRootPath.wstring() + LR"(\App\app.exe)");
+    paths.push_back(g_packageVfsRootPath.wstring() + LR"(\Unmapped\file.txt)");
+    paths.push_back(g_writablePackageRootPath.wstring() + LR"(\App\settings.json)");
+    paths.push_back(LR"(C:\Windows\System32\catroot.log)");     // a sibling of a base, not beneath it
+    paths.push_back(LR"(D:\Elsewhere\file.txt)");
+
+    const lookup lookups[] = { lookup::local_from_native, lookup::local_from_package, lookup::traditional_from_native,
+        lookup::traditional_from_package, lookup::traditional_from_redirected };
+    std::size_t matched = 0;
+    for (auto& path : paths)
+    {
+        for (auto which : lookups)
+        {
+            auto expected = scan_find(which, path);
+            auto& actual = index_find(which, path);
+            CHECK(same_mapping(actual, expected));
+            matched += expected.Valid_mapping ? 1 : 0;
+
+            // Mappings from the list are returned in place rather than copied
+            if (actual.Valid_mapping && !actual.FolderId.empty())
+            {
+                CHECK(&actual == &mfr::g_MfrFolderMappings[std::stoul(actual.FolderId.substr(1))]);
+            }
+        }
+    }
+    CHECK(matched > 0);
+    CHECK(mfr::Find_TraditionalRedirMapping_FromNativePath_ForwardSearch(LR"(C:\Windows\System32\catroot.log)").NativePathBase == natives[3]);
+    CHECK(mfr::Find_TraditionalRedirMapping_FromPackagePath_ForwardSearch(paths[4000]).PackagePathBase == g_packageRootPath);
+    CHECK(!mfr::Find_TraditionalRedirMapping_FromPackagePath_ForwardSearch(paths[4001]).Valid_mapping);
+
+    std::size_t sink = 0;
+    auto scanTime = time_per_call(paths.size(), [&](std::size_t i) { sink += scan_find(lookup::local_from_native, paths[i]).Valid_mapping ? 1 : 0; });
+    auto indexTime = time_per_call(paths.size(), [&](std::size_t i) { sink += index_find(lookup::local_from_native, paths[i]).Valid_mapping ? 1 : 0; });
+
+    // DetermineCohorts over requests for each kind of path. Both lookup versions cannot be linked into one program, so
+    // the time with the scan is the time with the index, less the lookups it made, plus the same lookups as scans.
+    struct request
+    {
+        std::wstring path;
+        mfr::mfr_path_types pathType;
+        std::wstring normalizedPath;
+    };
+    std::vector<request> requests;
+    for (std::size_t i = 0; i < paths.size(); i += 4)
+    {
+        Cohorts cohorts;
+        DetermineCohorts(paths[i], &cohorts, false, 0, L"MfrMappingTest");
+        requests.push_back({ paths[i], cohorts.file_mfr.Request_MfrPathType, std::wstring(cohorts.file_mfr.Request_NormalizedPath) });
+
+        auto scanned = cohort_lookups(requests.back().pathType, requests.back().normalizedPath,
+            [](lookup which, const std::wstring& path) { return scan_find(which, path).Valid_mapping; });
+        CHECK(cohorts.map->Valid_mapping == scanned);
+    }
+
+    constexpr std::size_t iterations = 100000;
+    auto cohortsTime = time_per_call(iterations, [&](std::size_t i)
+    {
+        Cohorts cohorts;
+        DetermineCohorts(requests[i % requests.size()].path, &cohorts, false, 0, L"MfrMappingTest");
+        sink += cohorts.WsRedirected.length();
+    });
+    auto indexLookupsTime = time_per_call(iterations, [&](std::size_t i)
+    {
+        auto& r = requests[i % requests.size()];
+        sink += cohort_lookups(r.pathType, r.normalizedPath, [](lookup which, const std::wstring& path) { return index_find(which, path).Valid_mapping; }) ? 1 : 0;
+    });
+    auto scanLookupsTime = time_per_call(iterations, [&](std::size_t i)
+    {
+        auto& r = requests[i % requests.size()];
+        sink += cohort_lookups(r.pathType, r.normalizedPath, [](lookup which, const std::wstring& path) { return scan_find(which, path).Valid_mapping; }) ? 1 : 0;
+    });
+    CHECK(sink > 0);
+    auto scanCohortsTime = cohortsTime - indexLookupsTime + scanLookupsTime;
+
+    std::printf("%zu mappings: copying scan %.0f ns/lookup, index %.0f ns/lookup (%.1fx); DetermineCohorts %.0f ns/request "
+        "with the scan, %.0f ns with the index (%.1fx)\n", mfr::g_MfrFolderMappings.size(), scanTime, indexTime,
+        scanTime / indexTime, scanCohortsTime, cohortsTime, scanCohortsTime / cohortsTime);
+
+    return test_result("mfr_folder_mapping_index");
+}
@@ -0,0 +1,274 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) TMurgent Technologies, LLP. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+//
+// Runs FileRedirectionFixup's NormalizePathV2 (built from its own source) over a corpus of the paths the intercepts
+// see, and checks that it gives the same results as the std::wstring version it replaced: StripFileColonSlash,
+// ReplaceSlashBackwardOnly and UrlDecode applied in turn, then the drive-absolute form worked out from the path type.
+// The corpus includes paths too long for the inline storage, relative ones among them, so that the storage has to move
+// while a path is being normalized. Then counts the heap allocations that each version makes per path, and times them.
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <windows.h>
+
+#include "../../fixups/FileRedirectionFixup/PathRedirection.h"
+
+#include "portable_test.h"
+
+namespace
+{
+    std::size_t g_allocations = 0;
+}
+
+void* operator new(std::size_t size)
+{
+    ++g_allocations;
+    if (auto result = std::malloc(size ? size : 1))
+    {
+        return result;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+// NormalizePathV2 passes these through untouched; they live with the other path tests in PathTests.cpp
+bool IsColonColonGuid(const char* path)
+{
+    return (path != nullptr) && (std::string_view(path).length() > 39) && (std::string_view(path).substr(0, 3) == "::{");
+}
+
+bool IsColonColonGuid(const wchar_t* path)
+{
+    return (path != nullptr) && (std::wstring_view(path).length() > 39) && (std::wstring_view(path).substr(0, 3) == L"::{");
+}
+
+bool IsBlobColon(std::string_view path)
+{
+    return path.substr(0, 5) == "blob:" || path.substr(0, 5) == "BLOB:";
+}
+
+bool IsBlobColon(std::wstring_view path)
+{
+    return path.substr(0, 5) == L"blob:" || path.substr(0, 5) == L"BLOB:";
+}
+
+namespace
+{
+    const std::wstring currentDirectory = L"C:\\Users\\Tester\\AppData\\Local\\Vendor\\App";
+
+    // What normalized_pathV2 held before: three strings, built by the string functions from PathTests.cpp
+    struct string_normalized_path
+    {
+        std::wstring original_path;
+        std::wstring full_path;
+        psf::dos_path_type path_type;
+        std::wstring drive_absolute_path;
+    };
+
+    std::wstring StripAtStartW(std::wstring old_string, const wchar_t* toStrip)
+    {
+        size_t found = old_string.find(toStrip, 0);
+        if (found == 0)
+        {
+            return old_string.substr(wcslen(toStrip));
+        }
+        return old_string;
+    }
+
+    std::wstring StripFileColonSlash(std::wstring old_string)
+    {
+        std::wstring sRet = old_string;
+        sRet = StripAtStartW(sRet, L"file:\\\\");
+        sRet = StripAtStartW(sRet, L"file://");
+        sRet = StripAtStartW(sRet, L"FILE:\\\\");
+        sRet = StripAtStartW(sRet, L"FILE://");
+        sRet = StripAtStartW(sRet, L"\\\\file\\");
+        sRet = StripAtStartW(sRet, L"\\\\FILE\\");
+        return sRet;
+    }
+
+    std::wstring ReplaceSlashBackwardOnly(std::wstring old_string)
+    {
+        std::wstring dap = old_string;
+        std::replace(dap.begin(), dap.end(), L'/', L'\\');
+        return dap;
+    }
+
+    std::wstring UrlDecode(std::wstring str)
+    {
+        std::wstring ret;
+        char ch;
+        size_t i, len = str.length();
+        unsigned int ii;
+
+        for (i = 0; i < len; i++)
+        {
+            if (str[i] != L'%')
+            {
+                ret += str[i];
+            }
+            else
+            {
+                if (swscanf_s(str.substr(i + 1, 4).c_str(), L"%x", &ii) == 1)
+                {
+                    ch = static_cast<char>(ii);
+                    ret += ch;
+                    i = (ii <= 255) ? i + 2 : i + 4;
+                }
+                else
+                {
+                    ret += str[i];
+                }
+            }
+        }
+        return ret;
+    }
+
+    // The old NormalizePathV2Impl, for the path types in the corpus. For a relative path it appended to
+    // std::filesystem::current_path(), which on Windows gives the same as the current directory, a separator, and the
+    // path.
+    string_normalized_path string_normalize(const wchar_t* path)
+    {
+        string_normalized_path result;
+        result.original_path = path;
+        result.path_type = psf::path_type(path);
+
+        std::wstring new_wstring = StripFileColonSlash(result.original_path.c_str());
+        new_wstring = ReplaceSlashBackwardOnly(new_wstring);
+        new_wstring = UrlDecode(new_wstring);
+        result.full_path = new_wstring;
+
+        switch (result.path_type)
+        {
+        case psf::dos_path_type::relative:
+            result.drive_absolute_path = currentDirectory + L"\\" +
+                (result.full_path.substr(0, 2) == L".\\" ? result.full_path.substr(2) : result.full_path);
+            break;
+        case psf::dos_path_type::local_device:
+        case psf::dos_path_type::root_local_device:
+            result.drive_absolute_path = result.full_path.substr(4);
+            break;
+        default:
+            result.drive_absolute_path = result.full_path.data();
+            break;
+        }
+        return result;
+    }
+
+    std::vector<std::wstring> make_corpus()
+    {
+        std::vector<std::wstring> corpus = {
+            L"C:\\Program Files\\WindowsApps\\Vendor.App_1.0.0.0_x64__abc\\VFS\\ProgramFilesX64\\App\\app.exe",
+            L"C:/Users/Tester/AppData/Roaming/Vendor/App/settings.ini",
+            L"C:\\Users\\Tester\\Documents\\Report%20Final%2Edocx",
+            L"C:\\Temp\\%zz%4",
+            L"file:///C:/Users/Tester/Desktop/readme.txt",
+            L"FILE:\\\\C:\\Data\\x.dat",
+            L"\\\\file\\C:\\Data\\x.dat",
+            L"\\\\server\\share\\folder\\file.txt",
+            L"\\\\?\\C:\\Windows\\System32\\kernel32.dll",
+            L"\\\\.\\C:\\Windows\\Fonts\\arial.ttf",
+            L"\\\\.\\pipe",
+            L"\\\\?\\STORAGE#Volume#{1234}",
+            L"data\\config.xml",
+            L".\\logs\\app.log",
+            L"plugins/Plugin%201/plugin.dll",
+            L"app.exe",
+        };
+
+        // Longer than the inline storage, which holds 520 characters, and than twice that
+        std::wstring folders;
+        while (folders.length() < 1100)
+        {
+            folders += L"Folder" + std::to_wstring(folders.length()) + L"\\";
+        }
+        corpus.push_back(L"C:\\Long\\" + folders + L"file.txt");
+        corpus.push_back(folders + L"file.txt");
+        corpus.push_back(L".\\" + folders + L"file.txt");
+        std::wstring encoded = folders;
+        for (std::size_t i = 0; i < encoded.length(); i += 40)
+        {
+            encoded.replace(i, 1, L"%41");
+        }
+        corpus.push_back(encoded + L"file%20name.txt");
+        corpus.push_back(L"Short\\" + folders.substr(0, 390) + L"file.txt");
+        corpus.push_back(L"Short\\" + encoded.substr(0, 260) + L"file.txt");
+        return corpus;
+    }
+}
+
+int main()
+{
+    win32_stand_in::current_directory = currentDirectory;
+    auto corpus = make_corpus();
+
+    for (auto& path : corpus)
+    {
+        auto expected = string_normalize(path.c_str());
+        auto normalized = NormalizePathV2(path.c_str(), 0);
+        CHECK(normalized.path_type == expected.path_type);
+        CHECK(normalized.original_path == expected.original_path);
+        CHECK(normalized.full_path == expected.full_path);
+        CHECK(normalized.drive_absolute_path == expected.drive_absolute_path);
+        CHECK(normalized.drive_absolute_path.c_str()[normalized.drive_absolute_path.length()] == L'\0');
+
+        // Copies and moves keep their views on their own storage
+        auto copy = normalized;
+        CHECK(copy.drive_absolute_path == expected.drive_absolute_path);
+        CHECK((copy.full_path.data() >= copy.storage.c_str()) && (copy.full_path.data() <= copy.storage.c_str() + copy.storage.size()));
+        auto moved = std::move(copy);
+        CHECK(moved.full_path == expected.full_path);
+        CHECK(moved.drive_absolute_path == expected.drive_absolute_path);
+    }
+
+    // Heap allocations per path, for the paths that fit in MAX_PATH and for all of them
+    auto count_allocations = [&](auto&& normalize, bool shortOnly)
+    {
+        std::size_t paths = 0;
+        auto before = g_allocations;
+        for (auto& path : corpus)
+        {
+            if (!shortOnly || (path.length() < MAX_PATH))
+            {
+                normalize(path.c_str());
+                ++paths;
+            }
+        }
+        return static_cast<double>(g_allocations - before) / static_cast<double>(paths);
+    };
+    auto viaStrings = [](const wchar_t* path) { return string_normalize(path).drive_absolute_path.length(); };
+    auto viaStorage = [](const wchar_t* path) { return NormalizePathV2(path, 0).drive_absolute_path.length(); };
+    auto shortStrings = count_allocations(viaStrings, true);
+    auto shortStorage = count_allocations(viaStorage, true);
+    auto allStrings = count_allocations(viaStrings, false);
+    auto allStorage = count_allocations(viaStorage, false);
+    CHECK(shortStorage == 0);
+    CHECK(allStorage < allStrings);
+
+    constexpr std::size_t iterations = 200000;
+    std::size_t sink = 0;
+    auto stringsTime = time_per_call(iterations, [&](std::size_t i) { sink += viaStrings(corpus[i % corpus.size()].c_str()); });
+    auto storageTime = time_per_call(iterations, [&](std::size_t i) { sink += viaStorage(corpus[i % corpus.size()].c_str()); });
+    CHECK(sink > 0);
+
+    std::printf("%zu paths: allocations per path (under MAX_PATH / all): strings %.1f / %.1f, inline storage %.1f / %.1f; "
+        "%.0f ns vs %.0f ns per path (%.1fx)\n", corpus.size(), shortStrings, allStrings, shortStorage, allStorage, stringsTime,
+        storageTime, stringsTime / storageTime);
+
+    return test_result("normalize_path");
+}
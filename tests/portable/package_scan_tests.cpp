@@ -0,0 +1,214 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) TMurgent Technologies, LLP. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+//
+// Checks read_pe_architecture against synthetic native and managed images (including a CLR header that lies beyond
+// the first page), then scans a synthetic package tree the way DynamicLibraryFixup's scanPackage does: folders shared
+// through psf::folder_queue, and the architecture of each dll read from the file. Compares one thread with several,
+// which must find the same dlls.
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include <folder_queue.h>
+#include <pe_image_architecture.h>
+
+#include "portable_test.h"
+
+namespace
+{
+    void put(std::vector<std::uint8_t>& image, std::size_t offset, std::uint32_t value, std::size_t size)
+    {
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            image[offset + i] = static_cast<std::uint8_t>(value >> (8 * i));
+        }
+    }
+
+    // A minimal image: the headers, one section, and (when managed) a CLR header at 'corOffset' within that section
+    std::vector<std::uint8_t> make_image(std::uint16_t machine, bool pe32Plus, bool managed, std::uint32_t corFlags,
+        std::size_t corOffset = 0x208)
+    {
+        constexpr std::size_t ntHeaders = 0x80;
+        constexpr std::size_t sectionRaw = 0x200;
+        constexpr std::uint32_t sectionRva = 0x2000;
+        std::size_t optionalHeaderSize = pe32Plus ? 240 : 224;
+        std::size_t rvaCountOffset = pe32Plus ? 108 : 92;
+
+        std::vector<std::uint8_t> image(std::max<std::size_t>(corOffset + 72, 0x400));
+        image[0] = 'M';
+        image[1] = 'Z';
+        put(image, 0x3C, ntHeaders, 4);
+        image[ntHeaders] = 'P';
+        image[ntHeaders + 1] = 'E';
+        auto fileHeader = ntHeaders + 4;
+        put(image, fileHeader, machine, 2);
+        put(image, fileHeader + 2, 1, 2);
+        put(image, fileHeader + 16, static_cast<std::uint32_t>(optionalHeaderSize), 2);
+        auto optionalHeader = fileHeader + 20;
+        put(image, optionalHeader, pe32Plus ? 0x20B : 0x10B, 2);
+        put(image, optionalHeader + rvaCountOffset, 16, 4);
+        if (managed)
+        {
+            put(image, optionalHeader + rvaCountOffset + 4 + 14 * 8, static_cast<std::uint32_t>(sectionRva + corOffset - sectionRaw), 4);
+            put(image, optionalHeader + rvaCountOffset + 4 + 14 * 8 + 4, 72, 4);
+            put(image, corOffset, 72, 4);
+            put(image, corOffset + 16, corFlags, 4);
+        }
+        auto section = optionalHeader + optionalHeaderSize;
+        put(image, section + 8, static_cast<std::uint32_t>(image.size() - sectionRaw), 4);
+        put(image, section + 12, sectionRva, 4);
+        put(image, section + 16, static_cast<std::uint32_t>(image.size() - sectionRaw), 4);
+        put(image, section + 20, sectionRaw, 4);
+        return image;
+    }
+
+    psf::pe_architecture read_whole(const std::vector<std::uint8_t>& image)
+    {
+        return psf::read_pe_architecture(image.data(), image.size());
+    }
+
+    psf::pe_architecture read_file_architecture(const std::filesystem::path& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        return psf::read_pe_architecture([&](std::uint64_t offset, void* buffer, std::size_t count) -> std::size_t
+        {
+            file.clear();
+            file.seekg(static_cast<std::streamoff>(offset));
+            file.read(static_cast<char*>(buffer), static_cast<std::streamsize>(count));
+            return static_cast<std::size_t>(file.gcount());
+        });
+    }
+
+    struct found_dll
+    {
+        std::wstring relative_path;
+        psf::pe_architecture architecture;
+
+        bool operator<(const found_dll& other) const
+        {
+            return relative_path < other.relative_path;
+        }
+
+        bool operator==(const found_dll& other) const
+        {
+            return (relative_path == other.relative_path) && (architecture == other.architecture);
+        }
+    };
+
+    void scan_folders(const std::filesystem::path& root, psf::folder_queue& queue, std::vector<found_dll>& found)
+    {
+        std::wstring folder;
+        std::vector<std::wstring> subFolders;
+        while (queue.pop(folder))
+        {
+            for (auto& entry : std::filesystem::directory_iterator(folder.empty() ? root : root / folder))
+            {
+                auto name = entry.path().filename().wstring();
+                auto relativePath = folder.empty() ? name : folder + L"/" + name;
+                if (entry.is_directory())
+                {
+                    subFolders.push_back(std::move(relativePath));
+                }
+                else if ((name.size() > 4) && (name.compare(name.size() - 4, 4, L".dll") == 0))
+                {
+                    found.push_back(found_dll{ relativePath, read_file_architecture(entry.path()) });
+                }
+            }
+            queue.finish(subFolders);
+        }
+    }
+
+    std::vector<found_dll> scan(const std::filesystem::path& root, unsigned threadCount)
+    {
+        psf::folder_queue queue;
+        std::vector<std::vector<found_dll>> found(threadCount);
+        std::vector<std::thread> threads;
+        for (unsigned i = 1; i < threadCount; ++i)
+        {
+            threads.emplace_back(scan_folders, std::cref(root), std::ref(queue), std::ref(found[i]));
+        }
+        scan_folders(root, queue, found[0]);
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        std::vector<found_dll> result;
+        for (auto& threadFound : found)
+        {
+            result.insert(result.end(), threadFound.begin(), threadFound.end());
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+}
+
+int main()
+{
+    using psf::pe_architecture;
+    CHECK(read_whole(make_image(0x8664, true, false, 0)) == pe_architecture::x64);
+    CHECK(read_whole(make_image(0xAA64, true, false, 0)) == pe_architecture::arm64);
+    CHECK(read_whole(make_image(0x014C, false, false, 0)) == pe_architecture::x86);
+    CHECK(read_whole(make_image(0x014C, false, true, 0x1)) == pe_architecture::any_cpu);             // ILONLY
+    CHECK(read_whole(make_image(0x014C, false, true, 0x1 | 0x2)) == pe_architecture::x86);           // ILONLY | 32BITREQUIRED
+    CHECK(read_whole(make_image(0x014C, false, true, 0x1 | 0x2 | 0x20000)) == pe_architecture::any_cpu);  // 32BITPREFERRED
+    CHECK(read_whole(make_image(0x014C, false, true, 0x10)) == pe_architecture::x86);                // mixed mode, not ILONLY
+    CHECK(read_whole(make_image(0x8664, true, true, 0x1)) == pe_architecture::x64);
+
+    // A CLR header beyond the first page needs a second read, which the first page alone can't give
+    auto farImage = make_image(0x014C, false, true, 0x1, 0x3000);
+    CHECK(read_whole(farImage) == pe_architecture::any_cpu);
+    CHECK(psf::read_pe_architecture(farImage.data(), 4096) == pe_architecture::unknown);
+
+    auto truncated = make_image(0x014C, false, true, 0x1);
+    truncated.resize(0x190);     // ends within the section table
+    CHECK(read_whole(truncated) == pe_architecture::unknown);
+    CHECK(read_whole(std::vector<std::uint8_t>(0x400, 0)) == pe_architecture::unknown);
+
+    // A package tree: 40 top level folders, each with nested folders of dlls and other files
+    auto root = std::filesystem::temp_directory_path() / ("psf_package_scan_" + std::to_string(::getpid()));
+    const std::vector<std::vector<std::uint8_t>> images = {
+        make_image(0x8664, true, false, 0), make_image(0x014C, false, false, 0), make_image(0x014C, false, true, 0x1),
+        make_image(0x014C, false, true, 0x3), make_image(0x014C, false, true, 0x1, 0x3000),
+    };
+    std::size_t dllCount = 0;
+    for (int top = 0; top < 40; ++top)
+    {
+        for (int sub = 0; sub < 5; ++sub)
+        {
+            auto folder = root / ("Folder" + std::to_string(top)) / ("Sub" + std::to_string(sub)) / "bin";
+            std::filesystem::create_directories(folder);
+            for (int file = 0; file < 12; ++file)
+            {
+                auto& image = images[(top + sub + file) % images.size()];
+                auto name = (file % 3 == 0) ? "data" + std::to_string(file) + ".txt" : "lib" + std::to_string(file) + ".dll";
+                std::ofstream(folder / name, std::ios::binary).write(reinterpret_cast<const char*>(image.data()), image.size());
+                dllCount += (file % 3 == 0) ? 0 : 1;
+            }
+        }
+    }
+
+    std::vector<found_dll> single;
+    auto singleTime = time_once([&] { single = scan(root, 1); });
+    auto threadCount = std::clamp(std::thread::hardware_concurrency(), 2u, 8u);
+    std::vector<found_dll> parallel;
+    auto parallelTime = time_once([&] { parallel = scan(root, threadCount); });
+    CHECK(single.size() == dllCount);
+    CHECK(single == parallel);
+    CHECK(std::none_of(single.begin(), single.end(), [](const found_dll& dll) { return dll.architecture == pe_architecture::unknown; }));
+    CHECK(std::count_if(single.begin(), single.end(), [](const found_dll& dll) { return dll.architecture == pe_architecture::any_cpu; }) > 0);
+    std::printf("%zu dlls in %d folders: 1 thread %.1f ms, %u threads %.1f ms (%.1fx)\n", dllCount, 1 + 40 + 40 * 5 * 2,
+        singleTime, threadCount, parallelTime, singleTime / parallelTime);
+
+    std::filesystem::remove_all(root);
+    return test_result("package_scan");
+}
@@ -0,0 +1,160 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) TMurgent Technologies, LLP. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+//
+// Checks that looking up FileRedirectionFixup specs through path_prefix_trie finds exactly the rules that the old
+// linear scan (a path_relative_to test and a regex match per rule) finds, and compares the cost of the two.
+
+#include <algorithm>
+#include <cwctype>
+#include <random>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include <path_prefix_trie.h>
+
+#include "portable_test.h"
+
+namespace
+{
+    struct rule
+    {
+        std::wstring base_path;
+        std::wregex pattern;
+    };
+
+    // The test FileRedirectionFixup has always used: base is a prefix of path, ignoring case, followed by a separator
+    // or the end of path
+    bool path_relative_to(std::wstring_view path, std::wstring_view base)
+    {
+        if (path.length() < base.length())
+        {
+            return false;
+        }
+        for (std::size_t i = 0; i < base.length(); ++i)
+        {
+            auto lhs = path[i];
+            auto rhs = base[i];
+            bool separators = ((lhs == L'\\') || (lhs == L'/')) && ((rhs == L'\\') || (rhs == L'/'));
+            if (!separators && (std::towlower(lhs) != std::towlower(rhs)))
+            {
+                return false;
+            }
+        }
+        return (path.length() == base.length()) || (path[base.length()] == L'\\') || (path[base.length()] == L'/');
+    }
+
+    std::vector<std::size_t> linear_scan(const std::vector<rule>& rules, const std::wstring& path)
+    {
+        std::vector<std::size_t> result;
+        for (std::size_t i = 0; i < rules.size(); ++i)
+        {
+            if (path_relative_to(path, rules[i].base_path))
+            {
+                auto offset = rules[i].base_path.length();
+                if ((offset < path.length()) && ((path[offset] == L'\\') || (path[offset] == L'/')))
+                {
+                    ++offset;
+                }
+                if (std::regex_match(path.begin() + offset, path.end(), rules[i].pattern))
+                {
+                    result.push_back(i);
+                }
+            }
+        }
+        return result;
+    }
+
+    std::vector<std::size_t> trie_lookup(const psf::path_prefix_trie<std::size_t>& trie, const std::vector<rule>& rules, const std::wstring& path)
+    {
+        std::vector<std::size_t> result;
+        trie.for_each_prefix(path, [&](const std::vector<std::size_t>& candidates, std::size_t offset)
+        {
+            for (auto i : candidates)
+            {
+                if (std::regex_match(path.begin() + offset, path.end(), rules[i].pattern))
+                {
+                    result.push_back(i);
+                }
+            }
+            return true;
+        });
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+}
+
+int main()
+{
+    const std::vector<std::wstring> folders = {
+        LR"(C:\Program Files\WindowsApps\Contoso.App_1.0.0.0_x64__8wekyb3d8bbwe)",
+        LR"(C:\Program Files\WindowsApps\Contoso.App_1.0.0.0_x64__8wekyb3d8bbwe\VFS\ProgramFilesX64\Contoso)",
+        LR"(C:\Program Files\WindowsApps\Contoso.App_1.0.0.0_x64__8wekyb3d8bbwe\VFS\Common AppData\Contoso)",
+        LR"(C:\Users\user\AppData\Roaming\Contoso)",
+        LR"(C:\Users\user\AppData\Local\Contoso)",
+        LR"(C:\Users\user\Documents)",
+        LR"(C:\ProgramData\Contoso)",
+        LR"(C:\Windows\System32)",
+    };
+    const std::vector<std::wstring> patterns = {
+        LR"(.*\.[lL][oO][gG])", LR"(.*\.[iI][nN][iI])", LR"(.*\.[tT][mM][pP])", LR"(Settings\\.*)", LR"(.*)",
+        LR"(.*\.[cC][fF][gG])", LR"(Data\\.*\.xml)", LR"(.*\.[dD][aA][tT])",
+    };
+
+    // 64 rules, about what our larger packages carry
+    std::mt19937 random(17);
+    std::vector<rule> rules;
+    psf::path_prefix_trie<std::size_t> trie;
+    for (std::size_t i = 0; i < 64; ++i)
+    {
+        auto base = folders[random() % folders.size()];
+        if (random() % 2)
+        {
+            base += L"\\Sub" + std::to_wstring(random() % 4);
+        }
+        auto& pattern = patterns[random() % patterns.size()];
+        rules.push_back(rule{ base, std::wregex(pattern, std::regex_constants::ECMAScript | std::regex_constants::icase) });
+        trie.insert(base, i);
+    }
+    CHECK(trie.size() == rules.size());
+
+    const std::vector<std::wstring> leaves = {
+        L"app.log", L"Settings\\user.ini", L"Data\\records.xml", L"cache.tmp", L"readme.txt", L"Sub1\\app.cfg",
+        L"Sub2\\Data\\a.xml", L"Sub3\\x.dat", L"Sub0\\Settings\\a", L"deep\\er\\still\\file.bin",
+    };
+    std::vector<std::wstring> paths;
+    for (std::size_t i = 0; i < 4000; ++i)
+    {
+        auto path = folders[random() % folders.size()] + L"\\" + leaves[random() % leaves.size()];
+        if (random() % 3 == 0)
+        {
+            std::transform(path.begin(), path.end(), path.begin(), [](wchar_t ch) { return static_cast<wchar_t>(std::towupper(ch)); });
+        }
+        if (random() % 5 == 0)
+        {
+            std::replace(path.begin(), path.end(), L'\\', L'/');
+        }
+        paths.push_back(std::move(path));
+    }
+    paths.push_back(LR"(C:\Users\user\AppData\Roaming\ContosoX\app.log)");     // not beneath "...\Contoso"
+    paths.push_back(LR"(C:\Users\user\AppData\Roaming\Contoso)");              // the base path itself
+
+    std::size_t matched = 0;
+    for (auto& path : paths)
+    {
+        auto expected = linear_scan(rules, path);
+        CHECK(trie_lookup(trie, rules, path) == expected);
+        matched += expected.empty() ? 0 : 1;
+    }
+    CHECK(matched > 0);
+
+    std::size_t sink = 0;
+    auto linearTime = time_per_call(paths.size(), [&](std::size_t i) { sink += linear_scan(rules, paths[i]).size(); });
+    auto trieTime = time_per_call(paths.size(), [&](std::size_t i) { sink += trie_lookup(trie, rules, paths[i]).size(); });
+    std::printf("%zu rules: linear scan %.0f ns/path, prefix trie %.0f ns/path (%.1fx) [%zu]\n",
+        rules.size(), linearTime, trieTime, linearTime / trieTime, sink);
+
+    return test_result("path_prefix_trie");
+}
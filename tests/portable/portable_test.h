@@ -0,0 +1,65 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) TMurgent Technologies, LLP. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+//
+// The little that the portable tests share: a CHECK that counts failures instead of stopping, and a timer for the
+// benchmarks. Each test is its own executable whose exit code is the number of failed checks.
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+inline int g_failures = 0;
+
+#define CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            std::printf("%s(%d): CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+            ++g_failures; \
+        } \
+    } while (0)
+
+// Runs fn(iteration) the given number of times and returns the average time of one call, in nanoseconds
+template <typename Fn>
+double time_per_call(std::size_t iterations, Fn&& fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < iterations; ++i)
+    {
+        fn(i);
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return elapsed / static_cast<double>(iterations ? iterations : 1);
+}
+
+// Runs fn() once and returns how long it took, in milliseconds
+template <typename Fn>
+double time_once(Fn&& fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+inline int test_result(const char* name)
+{
+    if (g_failures)
+    {
+        std::printf("%s: %d check(s) failed\n", name, g_failures);
+    }
+    else
+    {
+        std::printf("%s: passed\n", name);
+    }
+    return g_failures;
+}
+
+inline std::wstring to_wide(std::string_view str)
+{
+    return std::wstring(str.begin(), str.end());
+}
@@ -0,0 +1,305 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) TMurgent Technologies, LLP. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+//
+// Replays a trace of registry key paths through the RegLegacyFixups rule check in two ways: the way it used to be done
+// (for every rule, test the path against the hive's two spellings, cut off the hive, build a std::wregex from the
+// pattern and match), and the way it is done now (classify_registry_path once, then match patterns compiled into a
+// dfa_regex at configuration time). Both must pick the same rule for every path; the cost of each is reported.
+// The DeletionMarker rules, which cut the "key\\value" string at offsets of their own, are replayed the same way: as
+// RegFixupDeletionMarker did it, and through classify_registry_marker_path, with no change in what is hidden.
+
+#include <random>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <dfa_regex.h>
+#include <registry_key_path.h>
+
+#include "portable_test.h"
+
+namespace
+{
+    struct rule
+    {
+        psf::registry_hive hive;
+        std::vector<std::wstring> patterns;
+    };
+
+    struct compiled_rule
+    {
+        psf::registry_hive hive;
+        std::vector<psf::dfa_regex> patterns;
+    };
+
+    constexpr std::size_t no_match = static_cast<std::size_t>(-1);
+
+    std::size_t per_call_check(const std::vector<rule>& rules, const std::wstring& keyPath)
+    {
+        for (std::size_t i = 0; i < rules.size(); ++i)
+        {
+            std::wstring keystring;
+            std::wstring altkeystring;
+            if (rules[i].hive == psf::registry_hive::current_user)
+            {
+                keystring = L"HKEY_CURRENT_USER\\";
+                altkeystring = L"=\\REGISTRY\\USER\\";
+            }
+            else
+            {
+                keystring = L"HKEY_LOCAL_MACHINE\\";
+                altkeystring = L"=\\REGISTRY\\MACHINE\\";
+            }
+
+            bool isAlt = keyPath.compare(0, altkeystring.size(), altkeystring) == 0;
+            if ((keyPath.compare(0, keystring.size(), keystring) == 0) || isAlt)
+            {
+                for (auto& pattern : rules[i].patterns)
+                {
+                    // As before, a kernel path without a component after the SID is matched whole (npos + 1 == 0)
+                    auto offset = isAlt ? keyPath.find_first_of(L'\\', altkeystring.size()) + 1 : keystring.size();
+                    if (std::regex_match(keyPath.substr(offset), std::wregex(pattern, std::regex_constants::icase)))
+                    {
+                        return i;
+                    }
+                }
+            }
+        }
+        return no_match;
+    }
+
+    std::size_t compiled_check(const std::vector<compiled_rule>& rules, const std::wstring& keyPath)
+    {
+        auto classified = psf::classify_registry_path(std::wstring_view(keyPath));
+        if (classified.hive == psf::registry_hive::unknown)
+        {
+            return no_match;
+        }
+        for (std::size_t i = 0; i < rules.size(); ++i)
+        {
+            if (rules[i].hive != classified.hive)
+            {
+                continue;
+            }
+            for (auto& pattern : rules[i].patterns)
+            {
+                if (pattern.match(classified.remainder))
+                {
+                    return i;
+                }
+            }
+        }
+        return no_match;
+    }
+
+    // What RegFixupDeletionMarker returns
+    constexpr int marker_none = 0;
+    constexpr int marker_key = 2;       // ERROR_FILE_NOT_FOUND
+    constexpr int marker_value = 3;     // ERROR_PATH_NOT_FOUND
+
+    struct marker_rule
+    {
+        psf::registry_hive hive;
+        psf::dfa_regex key;
+        std::vector<psf::dfa_regex> patterns;
+    };
+
+    // RegFixupDeletionMarker as it was, with the patterns already compiled
+    int per_call_marker(const std::vector<marker_rule>& rules, const std::wstring& wKeyPath, const std::wstring& wValue)
+    {
+        std::wstring wKeyPathValue = wKeyPath + L"\\\\" + wValue;
+        for (auto& rule : rules)
+        {
+            std::wstring wKeyString = (rule.hive == psf::registry_hive::current_user) ? L"HKEY_CURRENT_USER" : L"HKEY_LOCAL_MACHINE";
+            std::wstring wAltKeyString = (rule.hive == psf::registry_hive::current_user) ? L"=\\REGISTRY\\USER" : L"=\\REGISTRY\\MACHINE";
+            bool isAlt = wKeyPathValue.compare(0, wAltKeyString.size(), wAltKeyString) == 0;
+            if ((wKeyPathValue.compare(0, wKeyString.size(), wKeyString) != 0) && !isAlt)
+            {
+                continue;
+            }
+            size_t OffsetHkcu = wKeyString.size() + 2;  // skip next '\'
+            if (isAlt)
+            {
+                OffsetHkcu = wKeyPathValue.find_first_of(L'\\', wAltKeyString.size()) + 2;
+            }
+            std::wstring wRemainingKeyPathValue = (OffsetHkcu < wKeyPathValue.size()) ? wKeyPathValue.substr(OffsetHkcu) : L"";
+            if (rule.key.match(wRemainingKeyPathValue))
+            {
+                if (rule.patterns.empty() || wValue.empty())
+                {
+                    return marker_key;
+                }
+                for (auto& pattern : rule.patterns)
+                {
+                    if (pattern.match((rule.hive == psf::registry_hive::current_user) ? wRemainingKeyPathValue : wValue))
+                    {
+                        return marker_value;
+                    }
+                }
+            }
+        }
+        return marker_none;
+    }
+
+    // The same through classify_registry_marker_path, the way EvaluateRegRemediation does it
+    int classified_marker(const std::vector<marker_rule>& rules, const std::wstring& wKeyPath, const std::wstring& wValue)
+    {
+        std::wstring wKeyPathValue = wKeyPath;
+        auto valueOffset = wKeyPathValue.length() + 2;
+        wKeyPathValue.append(L"\\\\").append(wValue);
+        auto value = std::wstring_view(wKeyPathValue).substr(valueOffset);
+        auto classified = psf::classify_registry_marker_path(std::wstring_view(wKeyPathValue));
+        if (classified.hive == psf::registry_hive::unknown)
+        {
+            return marker_none;
+        }
+        for (auto& rule : rules)
+        {
+            if ((rule.hive != classified.hive) || !rule.key.match(classified.remainder))
+            {
+                continue;
+            }
+            if (rule.patterns.empty() || value.empty())
+            {
+                return marker_key;
+            }
+            for (auto& pattern : rule.patterns)
+            {
+                if (pattern.match((rule.hive == psf::registry_hive::current_user) ? classified.remainder : value))
+                {
+                    return marker_value;
+                }
+            }
+        }
+        return marker_none;
+    }
+}
+
+int main()
+{
+    // The classification itself
+    auto user = psf::classify_registry_path(std::wstring_view(LR"(=\REGISTRY\USER\S-1-5-21-1\Software\Vendor)"));
+    CHECK(user.hive == psf::registry_hive::current_user);
+    CHECK(user.remainder == L"Software\\Vendor");
+    auto machine = psf::classify_registry_path(std::string_view(R"(HKEY_LOCAL_MACHINE\SOFTWARE\Vendor)"));
+    CHECK(machine.hive == psf::registry_hive::local_machine);
+    CHECK(machine.remainder == "SOFTWARE\\Vendor");
+    auto bare = psf::classify_registry_path(std::wstring_view(LR"(=\REGISTRY\USER\S-1-5-21-1)"));
+    CHECK(bare.hive == psf::registry_hive::current_user);
+    CHECK(bare.remainder == LR"(=\REGISTRY\USER\S-1-5-21-1)");
+    CHECK(psf::classify_registry_path(std::wstring_view(L"HKEY_CLASSES_ROOT\\x")).hive == psf::registry_hive::unknown);
+    auto marker = psf::classify_registry_marker_path(std::wstring_view(LR"(HKEY_CURRENT_USER\Software\Vendor\\Value)"));
+    CHECK(marker.hive == psf::registry_hive::current_user);
+    CHECK(marker.remainder == LR"(oftware\Vendor\\Value)");
+    auto userMarker = psf::classify_registry_marker_path(std::wstring_view(LR"(=\REGISTRY\USER\S-1-5-21-1\Software\\Value)"));
+    CHECK(userMarker.hive == psf::registry_hive::current_user);
+    CHECK(userMarker.remainder == LR"(-1-5-21-1\Software\\Value)");
+
+    // Rules like the ones in the RegLegacyFixups readme and our test configs
+    const std::vector<rule> rules = {
+        { psf::registry_hive::current_user, { LR"(Software\\Vendor_Covered.*)", LR"(Software\\Vendor\\App\\Settings.*)" } },
+        { psf::registry_hive::local_machine, { LR"(^SOFTWARE\\Vendor_Covered.*)", LR"(^SOFTWARE\\Wow3264Node\\Vendor_Covered.*)" } },
+        { psf::registry_hive::current_user, { LR"(Software\\Vendor_Deletion\\.*)", LR"(Software\\Vendor_Deletion\\SubKey\\.*)" } },
+        { psf::registry_hive::local_machine, { LR"(^SOftWARE\\Vendor\\.*)", LR"(Software\\Classes\\CLSID\\\{CAFEEFAC-.*)" } },
+        { psf::registry_hive::current_user, { LR"(Software\\Policies\\.*)", LR"(Software\\Microsoft\\Windows\\.*)" } },
+    };
+    std::vector<compiled_rule> compiledRules;
+    for (auto& source : rules)
+    {
+        compiled_rule compiled{ source.hive, {} };
+        for (auto& pattern : source.patterns)
+        {
+            compiled.patterns.emplace_back(pattern, true);
+        }
+        compiledRules.push_back(std::move(compiled));
+    }
+
+    const std::vector<std::wstring> roots = {
+        L"HKEY_CURRENT_USER\\", L"=\\REGISTRY\\USER\\S-1-5-21-3623811015-3361044348-30300820-1013\\",
+        L"HKEY_LOCAL_MACHINE\\", L"=\\REGISTRY\\MACHINE\\", L"HKEY_CLASSES_ROOT\\",
+    };
+    const std::vector<std::wstring> keys = {
+        L"Software\\Vendor_Covered\\Config", L"SOFTWARE\\VENDOR_COVERED", L"Software\\Vendor\\App\\Settings\\Window",
+        L"Software\\Vendor\\App\\Other", L"SOFTWARE\\Wow3264Node\\Vendor_Covered\\x", L"Software\\Vendor_Deletion\\Key",
+        L"Software\\Classes\\CLSID\\{CAFEEFAC-0018-0000-0000-ABCDEFFEDCBA}", L"Software\\Classes\\CLSID\\{00000000-0000}",
+        L"Software\\Policies\\Microsoft\\Windows", L"Software\\Microsoft\\Windows\\CurrentVersion\\Explorer",
+        L"System\\CurrentControlSet\\Control", L"",
+    };
+
+    // The trace: a mix of the hives and keys, the way an app at startup touches them
+    std::mt19937 random(10);
+    std::vector<std::wstring> trace;
+    for (std::size_t i = 0; i < 3000; ++i)
+    {
+        trace.push_back(roots[random() % roots.size()] + keys[random() % keys.size()]);
+    }
+    trace.push_back(L"=\\REGISTRY\\USER\\S-1-5-21-1");
+
+    std::size_t matched = 0;
+    for (auto& keyPath : trace)
+    {
+        auto expected = per_call_check(rules, keyPath);
+        CHECK(compiled_check(compiledRules, keyPath) == expected);
+        matched += (expected != no_match) ? 1 : 0;
+    }
+    CHECK(matched > 0);
+
+    std::size_t sink = 0;
+    auto perCallTime = time_per_call(trace.size(), [&](std::size_t i) { sink += (per_call_check(rules, trace[i]) != no_match) ? 1 : 0; });
+    auto compiledTime = time_per_call(trace.size(), [&](std::size_t i) { sink += (compiled_check(compiledRules, trace[i]) != no_match) ? 1 : 0; });
+    std::printf("%zu calls: std::wregex per call %.0f ns/call, compiled %.0f ns/call (%.1fx) [%zu]\n",
+        trace.size(), perCallTime, compiledTime, perCallTime / compiledTime, sink);
+
+    // DeletionMarker rules like those in the readme; each value pattern is compiled as key + ".*" + pattern
+    auto make_marker = [](psf::registry_hive hive, const std::wstring& key, const std::vector<std::wstring>& values)
+    {
+        marker_rule marker{ hive, psf::dfa_regex(key, true), {} };
+        for (auto& value : values)
+        {
+            marker.patterns.emplace_back(key + L".*" + value, true);
+        }
+        return marker;
+    };
+    std::vector<marker_rule> markers;
+    markers.push_back(make_marker(psf::registry_hive::current_user, LR"(.*Vendor_Deletion.*)", {}));
+    markers.push_back(make_marker(psf::registry_hive::current_user, LR"(.*oftware\\Vendor\\App.*)", { L"Hidden", LR"(Settings\\\\Secret)" }));
+    markers.push_back(make_marker(psf::registry_hive::local_machine, LR"(.*Vendor_Covered.*)", { L"Install.*" }));
+    markers.push_back(make_marker(psf::registry_hive::local_machine, LR"(OFTWARE\\Vendor.*)", {}));
+    markers.push_back(make_marker(psf::registry_hive::current_user, LR"(-1-5-21-3623811015.*Policies.*)", {}));
+    markers.push_back(make_marker(psf::registry_hive::current_user, LR"(\\.*)", {}));
+
+    const std::vector<std::wstring> markerRoots = {
+        L"HKEY_CURRENT_USER\\", L"HKEY_CURRENT_USER", L"=\\REGISTRY\\USER\\S-1-5-21-3623811015-3361044348-30300820-1013\\",
+        L"=\\REGISTRY\\USER", L"HKEY_LOCAL_MACHINE\\", L"=\\REGISTRY\\MACHINE\\", L"=\\REGISTRY\\MACHINE", L"HKEY_CLASSES_ROOT\\",
+    };
+    const std::vector<std::wstring> values = { L"", L"Hidden", L"Settings", L"Secret", L"InstallDir", L"Version" };
+    std::vector<std::pair<std::wstring, std::wstring>> markerTrace;
+    for (std::size_t i = 0; i < 3000; ++i)
+    {
+        markerTrace.emplace_back(markerRoots[random() % markerRoots.size()] + keys[random() % keys.size()], values[random() % values.size()]);
+    }
+    for (auto& root : markerRoots)
+    {
+        markerTrace.emplace_back(root, L"");
+        markerTrace.emplace_back(root, L"Hidden");
+    }
+
+    std::size_t hidden[4] = {};
+    for (auto& [keyPath, value] : markerTrace)
+    {
+        auto expected = per_call_marker(markers, keyPath, value);
+        CHECK(classified_marker(markers, keyPath, value) == expected);
+        ++hidden[expected];
+    }
+    CHECK((hidden[marker_key] > 0) && (hidden[marker_value] > 0));
+
+    auto perCallMarkerTime = time_per_call(markerTrace.size(), [&](std::size_t i) { sink += per_call_marker(markers, markerTrace[i].first, markerTrace[i].second); });
+    auto classifiedMarkerTime = time_per_call(markerTrace.size(), [&](std::size_t i) { sink += classified_marker(markers, markerTrace[i].first, markerTrace[i].second); });
+    std::printf("%zu deletion marker checks (%zu keys and %zu values hidden): as before %.0f ns/call, classified %.0f ns/call [%zu]\n",
+        markerTrace.size(), hidden[marker_key], hidden[marker_value], perCallMarkerTime, classifiedMarkerTime, sink);
+
+    return test_result("registry_remediation");
+}
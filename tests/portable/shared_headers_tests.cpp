@@ -0,0 +1,51 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) TMurgent Technologies, LLP. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+//
+// Builds every header in include/ that does not need windows.h, all in one translation unit and with the warnings
+// turned up, so that one of them picking up a Windows dependency (or a missing include) breaks this build instead of a
+// fixup's. Also checks the small types that no other test covers.
+
+#include <dfa_regex.h>
+#include <file_name_set.h>
+#include <inline_wstring.h>
+#include <merged_directory_enumeration.h>
+#include <package_file_index.h>
+#include <path_decision_cache.h>
+#include <path_prefix_trie.h>
+#include <pe_image_architecture.h>
+#include <psf_log_queue.h>
+#include <psf_timeline.h>
+#include <registry_key_path.h>
+#include <reentrancy_guard.h>
+
+#include "portable_test.h"
+
+int main()
+{
+    psf::inline_wstring<8> small;
+    small.append(L"C:\\a");
+    CHECK(small.is_inline());
+    CHECK(small.view() == L"C:\\a");
+    small.append(L"\\longer\\than\\eight");
+    CHECK(!small.is_inline());
+    CHECK(small.view() == L"C:\\a\\longer\\than\\eight");
+    CHECK(small.c_str()[small.length()] == L'\0');
+    small.truncate(4);
+    CHECK(small.view() == L"C:\\a");
+
+    psf::inline_wstring<8> moved(std::move(small));
+    CHECK(moved.view() == L"C:\\a");
+
+    psf::reentrancy_guard guard;
+    {
+        auto outer = guard.enter();
+        CHECK(outer);
+        auto inner = guard.enter();
+        CHECK(!inner);
+    }
+    CHECK(guard.enter());
+
+    return test_result("shared_headers");
+}
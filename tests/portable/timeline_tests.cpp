@@ -0,0 +1,94 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) TMurgent Technologies, LLP. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+//
+// Checks psf::span_recorder: spans recorded from several threads at once all come back whole, the ring keeps the
+// newest spans when it wraps, and the Chrome trace output is escaped. Also reports the cost of recording a span.
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <psf_timeline.h>
+
+#include "portable_test.h"
+
+int main()
+{
+    {
+        psf::span_recorder recorder;
+        recorder.record("PsfRuntime: load config", 100, 250, 1);
+        recorder.record("a name that is far longer than the forty seven characters that fit", 300, 200, 2);
+        auto spans = recorder.snapshot();
+        CHECK(spans.size() == 2);
+        CHECK(std::strcmp(spans[0].name, "PsfRuntime: load config") == 0);
+        CHECK(std::strlen(spans[1].name) == psf::span_recorder::max_name_length);
+        CHECK(spans[1].thread == 2);
+
+        std::ostringstream stream;
+        recorder.record("quote \" and \\ and \n", 400, 500, 3);
+        recorder.write_chrome_trace(stream, 42, "App.exe");
+        auto trace = stream.str();
+        CHECK(trace.find("\"process_name\"") != std::string::npos);
+        CHECK(trace.find(R"("quote \" and \\ and \u000a")") != std::string::npos);
+        CHECK(trace.find("\"ts\":0.000,\"dur\":0.150") != std::string::npos);
+        CHECK(trace.find("\"dur\":0.000") != std::string::npos);     // end before start is reported as empty
+    }
+
+    // Several threads recording at once, wrapping the ring many times over
+    {
+        static psf::span_recorder recorder;
+        constexpr std::uint32_t threadCount = 4;
+        constexpr std::uint64_t perThread = 20000;
+        std::vector<std::thread> threads;
+        for (std::uint32_t thread = 1; thread <= threadCount; ++thread)
+        {
+            threads.emplace_back([thread]
+            {
+                for (std::uint64_t i = 0; i < perThread; ++i)
+                {
+                    auto name = "thread " + std::to_string(thread) + " span " + std::to_string(i);
+                    recorder.record(name, i, i + thread, thread);
+                }
+            });
+        }
+
+        // A snapshot taken while the spans are being written must only return whole spans
+        std::size_t torn = 0;
+        for (int i = 0; i < 50; ++i)
+        {
+            for (auto& value : recorder.snapshot())
+            {
+                auto expected = "thread " + std::to_string(value.thread) + " span " + std::to_string(value.start);
+                torn += ((expected != value.name) || (value.end != value.start + value.thread)) ? 1 : 0;
+            }
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        CHECK(torn == 0);
+
+        auto spans = recorder.snapshot();
+        CHECK(spans.size() == psf::span_recorder::capacity);
+        auto newest = std::count_if(spans.begin(), spans.end(), [](auto& value) { return value.start >= perThread - psf::span_recorder::capacity; });
+        CHECK(static_cast<std::size_t>(newest) == spans.size());
+    }
+
+    psf::span_recorder recorder;
+    std::uint64_t sink = 0;
+    auto recordTime = time_per_call(1000000, [&](std::size_t i)
+    {
+        auto start = psf::span_recorder::now();
+        recorder.record("PsfRuntime: attach fixup", start, start + i, 7);
+    });
+    auto nowTime = time_per_call(1000000, [&](std::size_t) { sink += psf::span_recorder::now(); });
+    std::printf("record %.1f ns/span (including one now()), now() alone %.1f ns [%llu]\n",
+        recordTime, nowTime, static_cast<unsigned long long>(sink & 1));
+
+    return test_result("span_recorder");
+}
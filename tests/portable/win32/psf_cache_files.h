@@ -0,0 +1,130 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) TMurgent Technologies, LLP. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+//
+// Test-only stand-in for psf_cache_files.h with the same interface, built on POSIX: files are mapped with mmap and
+// replaced with rename.
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace psf
+{
+    struct file_chunk
+    {
+        const void* data;
+        std::size_t size;
+    };
+
+    inline bool write_file_atomically(const std::filesystem::path& path, std::initializer_list<file_chunk> chunks) noexcept try
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(path.parent_path(), ec);
+        auto tempPath = path;
+        tempPath += "." + std::to_string(::getpid());
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            for (auto& chunk : chunks)
+            {
+                file.write(static_cast<const char*>(chunk.data), static_cast<std::streamsize>(chunk.size));
+            }
+            if (!file)
+            {
+                std::filesystem::remove(tempPath, ec);
+                return false;
+            }
+        }
+        std::filesystem::rename(tempPath, path, ec);
+        return !ec;
+    }
+    catch (...)
+    {
+        return false;
+    }
+
+    class mapped_file
+    {
+    public:
+        mapped_file() noexcept = default;
+
+        mapped_file(const void* view, std::size_t size) noexcept :
+            m_view(static_cast<const std::uint8_t*>(view)),
+            m_size(size)
+        {
+        }
+
+        mapped_file(mapped_file&& other) noexcept :
+            m_view(std::exchange(other.m_view, nullptr)),
+            m_size(std::exchange(other.m_size, 0))
+        {
+        }
+
+        mapped_file& operator=(mapped_file&& other) noexcept
+        {
+            std::swap(m_view, other.m_view);
+            std::swap(m_size, other.m_size);
+            return *this;
+        }
+
+        ~mapped_file()
+        {
+            if (m_view)
+            {
+                ::munmap(const_cast<std::uint8_t*>(m_view), m_size);
+            }
+        }
+
+        explicit operator bool() const noexcept
+        {
+            return m_view != nullptr;
+        }
+
+        const std::uint8_t* data() const noexcept
+        {
+            return m_view;
+        }
+
+        std::size_t size() const noexcept
+        {
+            return m_size;
+        }
+
+    private:
+        const std::uint8_t* m_view = nullptr;
+        std::size_t m_size = 0;
+    };
+
+    inline mapped_file map_cache_file(const std::filesystem::path& path, std::uint64_t minSize, std::uint64_t maxSize) noexcept
+    {
+        int file = ::open(path.c_str(), O_RDONLY);
+        if (file < 0)
+        {
+            return {};
+        }
+
+        struct stat status;
+        void* view = MAP_FAILED;
+        if ((::fstat(file, &status) == 0) && (static_cast<std::uint64_t>(status.st_size) >= minSize) &&
+            (static_cast<std::uint64_t>(status.st_size) <= maxSize) && (status.st_size > 0))
+        {
+            view = ::mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_SHARED, file, 0);
+        }
+        ::close(file);
+        if (view == MAP_FAILED)
+        {
+            return {};
+        }
+        return mapped_file(view, static_cast<std::size_t>(status.st_size));
+    }
+}
@@ -0,0 +1,22 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) TMurgent Technologies, LLP. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+//
+// Test-only stand-in for psf_logging.h: the portable tests measure the code around the logging, not the logging, so
+// messages are dropped.
+#pragma once
+
+template <typename... Args>
+inline void Log(const wchar_t*, Args&&...)
+{
+}
+
+template <typename... Args>
+inline void Log(const char*, Args&&...)
+{
+}
+
+inline void LogString(const wchar_t*, const wchar_t*)
+{
+}
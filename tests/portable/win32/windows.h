@@ -0,0 +1,225 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) TMurgent Technologies, LLP. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+//
+// Test-only stand-in for the few parts of windows.h that the fixup and PsfRuntime sources built by the portable tests use
+// (PsfRuntime's config code, FileRedirectionFixup's NormalizePathV2, MFRFixup's DetermineCohorts and EnvVarFixup's
+// environment snapshot), so that they can be built and measured there. Only what those sources need is here: the SAL
+// annotations (as nothing), basic types, error codes, UTF-8 conversion, file attributes, and a current directory that
+// the test sets.
+#pragma once
+
+#include <cstdint>
+#include <cwchar>
+#include <filesystem>
+#include <string>
+#include <utility>
+
+#include <sys/stat.h>
+
+#define _In_
+#define _In_opt_
+#define _Out_
+#define _Out_opt_
+#define _Inout_
+#define _stdcall
+
+#define MAX_PATH 260
+
+// Only the operators that the stand-in's users combine flags with
+#define DEFINE_ENUM_FLAG_OPERATORS(type) \
+    inline constexpr type operator&(type lhs, type rhs) \
+    { \
+        return static_cast<type>(static_cast<int>(lhs) & static_cast<int>(rhs)); \
+    } \
+    inline constexpr type operator|(type lhs, type rhs) \
+    { \
+        return static_cast<type>(static_cast<int>(lhs) | static_cast<int>(rhs)); \
+    }
+
+using BOOL = int;
+using UINT = unsigned int;
+using DWORD = std::uint32_t;
+using LONG = std::int32_t;
+using LSTATUS = LONG;
+
+#define NO_ERROR 0
+#define ERROR_SUCCESS 0L
+#define ERROR_FILE_NOT_FOUND 2
+#define ERROR_OUTOFMEMORY 14
+#define ERROR_INVALID_PARAMETER 87
+#define ERROR_BUFFER_OVERFLOW 111
+#define ERROR_ARITHMETIC_OVERFLOW 534
+#define ERROR_UNHANDLED_EXCEPTION 574
+#define ERROR_NO_UNICODE_TRANSLATION 1113
+
+#define CP_ACP 0
+#define CP_UTF8 65001
+#define MB_ERR_INVALID_CHARS 0x08
+#define WC_ERR_INVALID_CHARS 0x80
+
+namespace win32_stand_in
+{
+    inline thread_local DWORD last_error = NO_ERROR;
+}
+
+inline DWORD GetLastError()
+{
+    return win32_stand_in::last_error;
+}
+
+inline void SetLastError(DWORD error)
+{
+    win32_stand_in::last_error = error;
+}
+
+// Declared for the inline wrappers in dos_paths.h; the tested code does not call them
+DWORD GetFullPathNameA(const char* path, DWORD length, char* buffer, char** filePart);
+DWORD GetFullPathNameW(const wchar_t* path, DWORD length, wchar_t* buffer, wchar_t** filePart);
+
+namespace win32_stand_in
+{
+    inline std::wstring current_directory = L"C:\\";
+}
+
+// Returns the length without the terminator, or the size of buffer needed when it is too small, as Windows does
+inline DWORD GetCurrentDirectoryW(DWORD length, wchar_t* buffer)
+{
+    auto& directory = win32_stand_in::current_directory;
+    if (directory.length() >= length)
+    {
+        return static_cast<DWORD>(directory.length() + 1);
+    }
+    std::wcscpy(buffer, directory.c_str());
+    return static_cast<DWORD>(directory.length());
+}
+
+// From the CRT rather than windows.h; only used with numeric conversions, which need no buffer sizes
+template <typename... Args>
+inline int swscanf_s(const wchar_t* buffer, const wchar_t* format, Args&&... args)
+{
+    return std::swscanf(buffer, format, std::forward<Args>(args)...);
+}
+
+// Both code pages are treated as UTF-8; wchar_t holds whole code points
+inline int MultiByteToWideChar(UINT, DWORD, const char* str, int length, wchar_t* result, int resultLength)
+{
+    int count = 0;
+    for (int i = 0; i < length; )
+    {
+        auto lead = static_cast<unsigned char>(str[i]);
+        int extra = (lead < 0x80) ? 0 : ((lead >> 5) == 0x6) ? 1 : ((lead >> 4) == 0xE) ? 2 : ((lead >> 3) == 0x1E) ? 3 : -1;
+        if (extra < 0)
+        {
+            SetLastError(ERROR_NO_UNICODE_TRANSLATION);
+            return 0;
+        }
+        std::uint32_t ch = extra ? (lead & (0x3F >> extra)) : lead;
+        for (int j = 1; j <= extra; ++j)
+        {
+            if ((i + j >= length) || ((static_cast<unsigned char>(str[i + j]) & 0xC0) != 0x80))
+            {
+                SetLastError(ERROR_NO_UNICODE_TRANSLATION);
+                return 0;
+            }
+            ch = (ch << 6) | (static_cast<unsigned char>(str[i + j]) & 0x3F);
+        }
+        if (resultLength)
+        {
+            if (count >= resultLength)
+            {
+                SetLastError(ERROR_BUFFER_OVERFLOW);
+                return 0;
+            }
+            result[count] = static_cast<wchar_t>(ch);
+        }
+        ++count;
+        i += extra + 1;
+    }
+    return count;
+}
+
+inline int WideCharToMultiByte(UINT, DWORD, const wchar_t* str, int length, char* result, int resultLength, const char*, BOOL*)
+{
+    std::string encoded;
+    for (int i = 0; i < length; ++i)
+    {
+        auto ch = static_cast<std::uint32_t>(str[i]);
+        if (ch < 0x80)
+        {
+            encoded += static_cast<char>(ch);
+        }
+        else if (ch < 0x800)
+        {
+            encoded += static_cast<char>(0xC0 | (ch >> 6));
+            encoded += static_cast<char>(0x80 | (ch & 0x3F));
+        }
+        else if (ch < 0x10000)
+        {
+            encoded += static_cast<char>(0xE0 | (ch >> 12));
+            encoded += static_cast<char>(0x80 | ((ch >> 6) & 0x3F));
+            encoded += static_cast<char>(0x80 | (ch & 0x3F));
+        }
+        else
+        {
+            encoded += static_cast<char>(0xF0 | (ch >> 18));
+            encoded += static_cast<char>(0x80 | ((ch >> 12) & 0x3F));
+            encoded += static_cast<char>(0x80 | ((ch >> 6) & 0x3F));
+            encoded += static_cast<char>(0x80 | (ch & 0x3F));
+        }
+    }
+    if (resultLength == 0)
+    {
+        return static_cast<int>(encoded.size());
+    }
+    if (static_cast<int>(encoded.size()) > resultLength)
+    {
+        SetLastError(ERROR_BUFFER_OVERFLOW);
+        return 0;
+    }
+    encoded.copy(result, encoded.size());
+    return static_cast<int>(encoded.size());
+}
+
+struct FILETIME
+{
+    DWORD dwLowDateTime;
+    DWORD dwHighDateTime;
+};
+
+struct WIN32_FILE_ATTRIBUTE_DATA
+{
+    DWORD dwFileAttributes;
+    FILETIME ftCreationTime;
+    FILETIME ftLastAccessTime;
+    FILETIME ftLastWriteTime;
+    DWORD nFileSizeHigh;
+    DWORD nFileSizeLow;
+};
+
+enum GET_FILEEX_INFO_LEVELS
+{
+    GetFileExInfoStandard,
+};
+
+inline BOOL GetFileAttributesExW(const wchar_t* path, GET_FILEEX_INFO_LEVELS, void* result)
+{
+    struct stat status;
+    if (::stat(std::filesystem::path(path).c_str(), &status) != 0)
+    {
+        SetLastError(ERROR_FILE_NOT_FOUND);
+        return 0;
+    }
+
+    // Nanoseconds stand in for the FILETIME's 100ns units; only equality matters to the callers
+    auto data = static_cast<WIN32_FILE_ATTRIBUTE_DATA*>(result);
+    *data = {};
+    auto size = static_cast<std::uint64_t>(status.st_size);
+    auto writeTime = static_cast<std::uint64_t>(status.st_mtim.tv_sec) * 1000000000 + static_cast<std::uint64_t>(status.st_mtim.tv_nsec);
+    data->nFileSizeHigh = static_cast<DWORD>(size >> 32);
+    data->nFileSizeLow = static_cast<DWORD>(size);
+    data->ftLastWriteTime.dwHighDateTime = static_cast<DWORD>(writeTime >> 32);
+    data->ftLastWriteTime.dwLowDateTime = static_cast<DWORD>(writeTime);
+    return 1;
+}